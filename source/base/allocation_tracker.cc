@@ -0,0 +1,336 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/allocation_tracker.h"
+
+#if defined(USE_ALLOCATION_TRACKING)
+
+#include "base/logging.h"
+#include "base/memory/aligned_memory.h"
+
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#if defined(OS_WIN)
+#include <intrin.h>
+#else
+#include <dlfcn.h>
+#endif
+
+namespace base {
+
+namespace {
+
+// Slot count of the call-site table. Power of two; a few thousand distinct allocation sites
+// cover the four binaries with room to spare.
+const size_t kTableSize = 8192;
+
+// Linear probing distance before a site is given up and lumped into the overflow bucket.
+const size_t kProbeLimit = 16;
+
+// Number of call sites included in a dump.
+const size_t kDumpTopCount = 64;
+
+struct Slot
+{
+    std::atomic<void*> site;
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> bytes;
+};
+
+Slot g_table[kTableSize];
+
+// Allocations whose site did not fit into the table within the probe limit.
+std::atomic<uint64_t> g_overflow_count;
+std::atomic<uint64_t> g_overflow_bytes;
+
+// Total number of frees. Compared with the allocation total this shows the overall churn.
+std::atomic<uint64_t> g_free_count;
+
+void dumpAtExit()
+{
+    AllocationTracker::dump();
+}
+
+#if !defined(OS_WIN)
+void dumpOnSignal(int /* signum */)
+{
+    // LOG is not async-signal-safe; acceptable for a diagnostics-only mode that is never
+    // compiled into release builds.
+    AllocationTracker::dump();
+}
+#endif // !defined(OS_WIN)
+
+// Registers the exit dump and the on-demand signal before main() runs.
+struct Registrar
+{
+    Registrar()
+    {
+        std::atexit(dumpAtExit);
+#if !defined(OS_WIN)
+        signal(SIGUSR1, dumpOnSignal);
+#endif
+    }
+};
+
+Registrar g_registrar;
+
+// Formats |site| for the log. Where the platform can resolve the address the module-relative
+// offset is logged (and the symbol name when exported), so the dump stays usable for PIE
+// binaries; addr2line on the module with the offset gives the source line.
+std::string formatSite(void* site)
+{
+    char buffer[512];
+
+#if !defined(OS_WIN)
+    Dl_info info;
+    if (dladdr(site, &info) != 0 && info.dli_fbase != nullptr)
+    {
+        const uintptr_t offset =
+            reinterpret_cast<uintptr_t>(site) - reinterpret_cast<uintptr_t>(info.dli_fbase);
+
+        snprintf(buffer, sizeof(buffer), "%s+0x%zx (%s)",
+                 (info.dli_fname != nullptr) ? info.dli_fname : "?",
+                 static_cast<size_t>(offset),
+                 (info.dli_sname != nullptr) ? info.dli_sname : "?");
+        return buffer;
+    }
+#endif // !defined(OS_WIN)
+
+    snprintf(buffer, sizeof(buffer), "%p", site);
+    return buffer;
+}
+
+void* allocate(size_t size, size_t alignment, void* site)
+{
+    void* ptr;
+
+    if (alignment != 0)
+        ptr = alignedAlloc(size, alignment);
+    else
+        ptr = std::malloc((size != 0) ? size : 1);
+
+    if (!ptr)
+        throw std::bad_alloc();
+
+    AllocationTracker::record(site, size);
+    return ptr;
+}
+
+} // namespace
+
+// static
+void AllocationTracker::record(void* site, size_t bytes)
+{
+    // Multiplicative hash of the call-site address; the low bits are dropped first because
+    // return addresses share them.
+    size_t index = (reinterpret_cast<uintptr_t>(site) >> 2) * uint64_t{ 0x9E3779B97F4A7C15 };
+
+    for (size_t i = 0; i < kProbeLimit; ++i)
+    {
+        Slot& slot = g_table[(index + i) & (kTableSize - 1)];
+
+        void* expected = slot.site.load(std::memory_order_relaxed);
+        if (expected == nullptr)
+        {
+            // Claim the empty slot. Losing the race to another site just moves the probe on.
+            if (!slot.site.compare_exchange_strong(
+                    expected, site, std::memory_order_relaxed) && expected != site)
+            {
+                continue;
+            }
+        }
+        else if (expected != site)
+        {
+            continue;
+        }
+
+        slot.count.fetch_add(1, std::memory_order_relaxed);
+        slot.bytes.fetch_add(bytes, std::memory_order_relaxed);
+        return;
+    }
+
+    g_overflow_count.fetch_add(1, std::memory_order_relaxed);
+    g_overflow_bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+// static
+void AllocationTracker::dump()
+{
+    struct Site
+    {
+        void* site;
+        uint64_t count;
+        uint64_t bytes;
+    };
+
+    std::vector<Site> sites;
+    sites.reserve(kTableSize);
+
+    uint64_t total_count = g_overflow_count.load(std::memory_order_relaxed);
+    uint64_t total_bytes = g_overflow_bytes.load(std::memory_order_relaxed);
+
+    for (Slot& slot : g_table)
+    {
+        void* site = slot.site.load(std::memory_order_relaxed);
+        if (!site)
+            continue;
+
+        Site entry;
+        entry.site = site;
+        entry.count = slot.count.load(std::memory_order_relaxed);
+        entry.bytes = slot.bytes.load(std::memory_order_relaxed);
+
+        total_count += entry.count;
+        total_bytes += entry.bytes;
+
+        sites.emplace_back(entry);
+    }
+
+    std::sort(sites.begin(), sites.end(), [](const Site& lhs, const Site& rhs)
+    {
+        return lhs.bytes > rhs.bytes;
+    });
+
+    if (sites.size() > kDumpTopCount)
+        sites.resize(kDumpTopCount);
+
+    LOG(LS_INFO) << "Allocation statistics: " << total_count << " allocations, "
+                 << total_bytes << " bytes, " << g_free_count.load(std::memory_order_relaxed)
+                 << " frees";
+
+    for (const Site& entry : sites)
+    {
+        LOG(LS_INFO) << "  " << entry.count << " allocations, " << entry.bytes << " bytes at "
+                     << formatSite(entry.site);
+    }
+
+    const uint64_t overflow_count = g_overflow_count.load(std::memory_order_relaxed);
+    if (overflow_count != 0)
+    {
+        LOG(LS_INFO) << "  " << overflow_count << " allocations, "
+                     << g_overflow_bytes.load(std::memory_order_relaxed)
+                     << " bytes from untracked sites (table full)";
+    }
+}
+
+} // namespace base
+
+#if defined(CC_MSVC)
+#define CALLER_ADDRESS() _ReturnAddress()
+#else
+#define CALLER_ADDRESS() __builtin_return_address(0)
+#endif
+
+void* operator new(std::size_t size)
+{
+    return base::allocate(size, 0, CALLER_ADDRESS());
+}
+
+void* operator new[](std::size_t size)
+{
+    return base::allocate(size, 0, CALLER_ADDRESS());
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    void* ptr = std::malloc((size != 0) ? size : 1);
+    if (ptr)
+        base::AllocationTracker::record(CALLER_ADDRESS(), size);
+    return ptr;
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    void* ptr = std::malloc((size != 0) ? size : 1);
+    if (ptr)
+        base::AllocationTracker::record(CALLER_ADDRESS(), size);
+    return ptr;
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    return base::allocate(size, static_cast<std::size_t>(alignment), CALLER_ADDRESS());
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return base::allocate(size, static_cast<std::size_t>(alignment), CALLER_ADDRESS());
+}
+
+void operator delete(void* ptr) noexcept
+{
+    base::g_free_count.fetch_add(1, std::memory_order_relaxed);
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    base::g_free_count.fetch_add(1, std::memory_order_relaxed);
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    operator delete(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    operator delete[](ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+    operator delete(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+    operator delete[](ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+    base::g_free_count.fetch_add(1, std::memory_order_relaxed);
+    base::alignedFree(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept
+{
+    base::g_free_count.fetch_add(1, std::memory_order_relaxed);
+    base::alignedFree(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t alignment) noexcept
+{
+    operator delete(ptr, alignment);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t alignment) noexcept
+{
+    operator delete[](ptr, alignment);
+}
+
+#endif // defined(USE_ALLOCATION_TRACKING)
@@ -0,0 +1,50 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__ALLOCATION_TRACKER_H
+#define BASE__ALLOCATION_TRACKER_H
+
+#include <cstddef>
+
+namespace base {
+
+// Opt-in allocation statistics for all binaries, enabled with the USE_ALLOCATION_TRACKING
+// compile option. When enabled, the global allocation operators are replaced with a shim that
+// counts allocations and bytes per call site (the return address of the caller), so pooling
+// and reuse work can be directed by real numbers instead of guesses.
+//
+// The accumulated statistics are written to the log when the process exits and, on POSIX, on
+// SIGUSR1. Call sites are logged as module-relative addresses (with the symbol name where the
+// platform can resolve it); addr2line turns them into source lines.
+//
+// The shim is a diagnostics tool: it is not compiled into release builds, and recording is
+// lock-free but deliberately approximate (call sites beyond the table capacity are lumped into
+// an overflow bucket).
+class AllocationTracker
+{
+public:
+    // Records one allocation of |bytes| from the call site |site|.
+    static void record(void* site, size_t bytes);
+
+    // Writes the accumulated per-call-site statistics to the log, sorted by total bytes.
+    static void dump();
+};
+
+} // namespace base
+
+#endif // BASE__ALLOCATION_TRACKER_H
@@ -21,11 +21,24 @@
 
 #include "base/base64.h"
 
+#include "base/cpuid_util.h"
 #include "base/logging.h"
 #include "third_party/modp_b64/modp_b64.h"
 
+#if defined(ARCH_CPU_X86_FAMILY)
+#include "base/base64_avx2.h"
+#endif
+
 namespace base {
 
+namespace {
+
+// Below this size the scalar implementation is just as fast and the AVX2 kernels cannot form a
+// single full block anyway.
+const size_t kMinSizeForSimd = 64;
+
+} // namespace
+
 // static
 void Base64::encode(std::string_view input, std::string* output)
 {
@@ -56,12 +69,44 @@ std::string Base64::decode(std::string_view input)
 // static
 size_t Base64::encodeImpl(char* dest, const char* str, size_t len)
 {
+#if defined(ARCH_CPU_X86_FAMILY)
+    static const bool has_avx2 = CpuidUtil::hasAvx2();
+
+    // The AVX2 kernel consumes whole 24-byte blocks; the remaining tail (including padding)
+    // goes through the scalar implementation below.
+    if (has_avx2 && len >= kMinSizeForSimd)
+    {
+        const size_t consumed = base64EncodeAvx2(dest, str, len);
+        const size_t produced = consumed / 3 * 4;
+
+        return produced + modp_b64_encode(dest + produced, str + consumed, len - consumed);
+    }
+#endif // defined(ARCH_CPU_X86_FAMILY)
+
     return modp_b64_encode(dest, str, len);
 }
 
 // static
 size_t Base64::decodeImpl(char* dest, const char* src, size_t len)
 {
+#if defined(ARCH_CPU_X86_FAMILY)
+    static const bool has_avx2 = CpuidUtil::hasAvx2();
+
+    // The AVX2 kernel consumes whole 32-character blocks and stops at the first invalid
+    // character; the scalar implementation decodes and validates the rest.
+    if (has_avx2 && len >= kMinSizeForSimd)
+    {
+        const size_t consumed = base64DecodeAvx2(dest, src, len);
+        const size_t produced = consumed / 4 * 3;
+        const size_t tail = modp_b64_decode(dest + produced, src + consumed, len - consumed);
+
+        if (tail == MODP_B64_ERROR)
+            return kErrorResult;
+
+        return produced + tail;
+    }
+#endif // defined(ARCH_CPU_X86_FAMILY)
+
     return modp_b64_decode(dest, src, len);
 }
 
@@ -0,0 +1,161 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Based on the vectorized base64 algorithms by Wojciech Mula and Daniel Lemire:
+// "Faster Base64 Encoding and Decoding Using AVX2 Instructions".
+//
+
+#include "base/base64_avx2.h"
+
+#include "build/build_config.h"
+
+#if defined(CC_MSVC)
+#include <intrin.h>
+#else
+#include <immintrin.h>
+#endif
+
+namespace base {
+
+size_t base64EncodeAvx2(char* dest, const char* src, size_t len)
+{
+    // Each iteration loads 32 bytes of input but consumes only the first 24, so the loop stops
+    // while a full load is still in bounds.
+    if (len < 32)
+        return 0;
+
+    // Duplicates every 3-byte group into a 4-byte slot: [b1 b0 b2 b1] in each 32-bit word.
+    // The duplicated bytes put all four 6-bit indices into extractable positions.
+    const __m256i shuffle = _mm256_set_epi8(
+        10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+        10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+
+    // Offsets from a 6-bit index to its base64 character, selected by index range:
+    // slot 13 covers 0..25 ('A'), slot 0 covers 26..51 ('a' - 26), slots 1..10 cover
+    // 52..61 ('0' - 52), slot 11 covers 62 ('+' - 62) and slot 12 covers 63 ('/' - 63).
+    const __m256i offsets = _mm256_setr_epi8(
+        71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 65, 0, 0,
+        71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 65, 0, 0);
+
+    size_t pos = 0;
+    size_t out = 0;
+
+    while (pos + 32 <= len)
+    {
+        // Move input bytes 12..23 into the high lane so that the in-lane byte shuffle can
+        // reach them.
+        __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + pos));
+        in = _mm256_permutevar8x32_epi32(in, _mm256_setr_epi32(0, 1, 2, 3, 3, 4, 5, 6));
+        in = _mm256_shuffle_epi8(in, shuffle);
+
+        // Split each 24-bit group into four 6-bit indices, one per output byte.
+        const __m256i t0 = _mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00));
+        const __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+        const __m256i t2 = _mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0));
+        const __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+        const __m256i indices = _mm256_or_si256(t1, t3);
+
+        // Reduce each index to an offset slot and add the selected offset to the index.
+        __m256i slots = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+        const __m256i less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+        slots = _mm256_or_si256(slots, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+
+        const __m256i result =
+            _mm256_add_epi8(indices, _mm256_shuffle_epi8(offsets, slots));
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + out), result);
+
+        pos += 24;
+        out += 32;
+    }
+
+    return pos;
+}
+
+size_t base64DecodeAvx2(char* dest, const char* src, size_t len)
+{
+    // Character classes by low nibble and by high nibble. A character is valid when the two
+    // classes do not intersect; '=' padding is deliberately left invalid so that the final
+    // padded block always falls through to the scalar implementation.
+    const __m256i lut_lo = _mm256_setr_epi8(
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m256i lut_hi = _mm256_setr_epi8(
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+
+    // Offsets from a base64 character to its 6-bit value, selected by high nibble with a
+    // correction for '/' (the only character sharing a high nibble with '+').
+    const __m256i lut_roll = _mm256_setr_epi8(
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+
+    size_t pos = 0;
+    size_t out = 0;
+
+    while (pos + 32 <= len)
+    {
+        const __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + pos));
+
+        const __m256i hi_nibbles =
+            _mm256_and_si256(_mm256_srli_epi32(in, 4), _mm256_set1_epi8(0x0f));
+        const __m256i lo_nibbles = _mm256_and_si256(in, _mm256_set1_epi8(0x0f));
+
+        const __m256i lo = _mm256_shuffle_epi8(lut_lo, lo_nibbles);
+        const __m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+
+        if (!_mm256_testz_si256(lo, hi))
+        {
+            // Invalid character or padding; the scalar implementation takes over from here.
+            break;
+        }
+
+        const __m256i eq_2f = _mm256_cmpeq_epi8(in, _mm256_set1_epi8(0x2f));
+        const __m256i roll =
+            _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(eq_2f, hi_nibbles));
+
+        // Translate characters to 6-bit values and pack four of them into each 24-bit group.
+        const __m256i values = _mm256_add_epi8(in, roll);
+        const __m256i merged =
+            _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+        __m256i packed = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+
+        // Gather the 12 useful bytes of each lane and compact them into the low 24 bytes.
+        packed = _mm256_shuffle_epi8(packed, _mm256_setr_epi8(
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+        packed = _mm256_permutevar8x32_epi32(
+            packed, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, -1, -1));
+
+        // Exactly 24 bytes are stored to stay inside the output buffer on the last block.
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + out),
+                         _mm256_castsi256_si128(packed));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dest + out + 16),
+                         _mm256_extracti128_si256(packed, 1));
+
+        pos += 32;
+        out += 24;
+    }
+
+    return pos;
+}
+
+} // namespace base
@@ -0,0 +1,41 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__BASE64_AVX2_H
+#define BASE__BASE64_AVX2_H
+
+#include <cstddef>
+
+namespace base {
+
+// Encodes the leading 24-byte blocks of |src| with AVX2 and returns the number of input bytes
+// consumed (a multiple of 24, possibly zero). Every consumed block produces 32 output
+// characters. Requires AVX2 support (CpuidUtil::hasAvx2()); the caller encodes the remaining
+// tail with the scalar implementation.
+size_t base64EncodeAvx2(char* dest, const char* src, size_t len);
+
+// Decodes the leading 32-character blocks of |src| with AVX2 and returns the number of input
+// characters consumed (a multiple of 32, possibly zero). Every consumed block produces
+// 24 output bytes. The kernel stops at the first block containing a character outside the
+// base64 alphabet (including '=' padding); the caller decodes and validates the remaining tail
+// with the scalar implementation.
+size_t base64DecodeAvx2(char* dest, const char* src, size_t len);
+
+} // namespace base
+
+#endif // BASE__BASE64_AVX2_H
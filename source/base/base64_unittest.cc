@@ -76,6 +76,43 @@ TEST(base64_test, empty)
     EXPECT_TRUE(decoded.empty());
 }
 
+TEST(base64_test, round_trip_lengths)
+{
+    // Covers the boundaries of the vectorized kernels (24-byte / 32-character blocks) as well
+    // as the scalar tail and padding.
+    std::string source;
+
+    for (size_t length = 1; length <= 200; ++length)
+    {
+        source.resize(length);
+
+        for (size_t i = 0; i < length; ++i)
+            source[i] = static_cast<char>(i * 7 + length);
+
+        std::string decoded;
+
+        bool ok = Base64::decode(Base64::encode(source), &decoded);
+        ASSERT_TRUE(ok);
+        EXPECT_EQ(source, decoded);
+    }
+}
+
+TEST(base64_test, invalid_character)
+{
+    // Long enough for the vectorized decoder; an invalid character must be rejected no matter
+    // which block it lands in.
+    const std::string encoded = Base64::encode(std::string(96, 'x'));
+
+    for (size_t pos : { size_t(0), size_t(31), size_t(32), size_t(63), encoded.size() - 1 })
+    {
+        std::string damaged = encoded;
+        damaged[pos] = '!';
+
+        std::string decoded;
+        EXPECT_FALSE(Base64::decode(damaged, &decoded));
+    }
+}
+
 TEST(base64_test, DISABLED_benchmark)
 {
     for (int i = 0; i < kIterationCount; ++i)
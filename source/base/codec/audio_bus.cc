@@ -20,9 +20,14 @@
 
 #include "base/logging.h"
 #include "base/codec/vector_math.h"
+#include "build/build_config.h"
 
 #include <cstring>
 
+#if defined(ARCH_CPU_X86_FAMILY)
+#include <emmintrin.h>
+#endif
+
 namespace base {
 
 static bool IsAligned(void* ptr)
@@ -62,6 +67,33 @@ static void ValidateConfig(int channels, int frames)
     CHECK_LE(channels, kMaxChannels);
 }
 
+#if defined(ARCH_CPU_X86_FAMILY)
+// Scales of FixedSampleTypeTraits<int16_t>: negative samples map to [-1, 0) by 1 / 32768 and
+// positive samples to (0, 1] by 1 / 32767, so the scale is chosen per lane by the sign.
+static __m128 Int32ToFloatSample(__m128i value)
+{
+    __m128 result = _mm_cvtepi32_ps(value);
+    __m128 negative = _mm_cmplt_ps(result, _mm_setzero_ps());
+    __m128 scale = _mm_or_ps(_mm_and_ps(negative, _mm_set1_ps(1.0f / 32768.0f)),
+                             _mm_andnot_ps(negative, _mm_set1_ps(1.0f / 32767.0f)));
+    return _mm_mul_ps(result, scale);
+}
+
+static __m128i FloatSampleToInt32(__m128 value)
+{
+    // Clamp first: the scaled value of an out of range sample could overflow the integer
+    // conversion, which saturates to the wrong end for positive input.
+    value = _mm_max_ps(_mm_min_ps(value, _mm_set1_ps(1.0f)), _mm_set1_ps(-1.0f));
+
+    __m128 negative = _mm_cmplt_ps(value, _mm_setzero_ps());
+    __m128 scale = _mm_or_ps(_mm_and_ps(negative, _mm_set1_ps(32768.0f)),
+                             _mm_andnot_ps(negative, _mm_set1_ps(32767.0f)));
+
+    // Truncation towards zero matches the scalar conversion.
+    return _mm_cvttps_epi32(_mm_mul_ps(value, scale));
+}
+#endif // defined(ARCH_CPU_X86_FAMILY)
+
 void AudioBus::CheckOverflow(int start_frame, int frames, int total_frames)
 {
     CHECK_GE(start_frame, 0);
@@ -272,6 +304,110 @@ void AudioBus::BuildChannelData(int channels, int aligned_frames, float* data)
         channel_data_.push_back(data + i * aligned_frames);
 }
 
+void AudioBus::FromInterleavedInt16(const int16_t* source_buffer, int num_frames_to_write)
+{
+    DCHECK(!is_bitstream_format_);
+    CheckOverflow(0, num_frames_to_write, frames_);
+
+    int frame = 0;
+
+#if defined(ARCH_CPU_X86_FAMILY)
+    if (channels() == 2)
+    {
+        float* left = channel_data_[0];
+        float* right = channel_data_[1];
+
+        for (; frame + 4 <= num_frames_to_write; frame += 4)
+        {
+            // Four stereo frames; every 32-bit lane holds the left sample in the low half and
+            // the right sample in the high half.
+            __m128i pairs = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(source_buffer + frame * 2));
+
+            __m128i left32 = _mm_srai_epi32(_mm_slli_epi32(pairs, 16), 16);
+            __m128i right32 = _mm_srai_epi32(pairs, 16);
+
+            _mm_store_ps(left + frame, Int32ToFloatSample(left32));
+            _mm_store_ps(right + frame, Int32ToFloatSample(right32));
+        }
+    }
+    else if (channels() == 1)
+    {
+        float* dest = channel_data_[0];
+
+        for (; frame + 8 <= num_frames_to_write; frame += 8)
+        {
+            __m128i samples = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(source_buffer + frame));
+
+            // Duplicating every 16-bit sample into a 32-bit lane and shifting back sign-extends
+            // it without SSE4.
+            __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16);
+            __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16);
+
+            _mm_store_ps(dest + frame, Int32ToFloatSample(lo));
+            _mm_store_ps(dest + frame + 4, Int32ToFloatSample(hi));
+        }
+    }
+#endif // defined(ARCH_CPU_X86_FAMILY)
+
+    if (frame < num_frames_to_write)
+    {
+        FromInterleavedPartial<SignedInt16SampleTypeTraits>(
+            source_buffer + frame * channels(), frame, num_frames_to_write - frame);
+    }
+
+    // Zero any remaining frames, like FromInterleaved() does.
+    ZeroFramesPartial(num_frames_to_write, frames_ - num_frames_to_write);
+}
+
+void AudioBus::ToInterleavedInt16(int num_frames_to_read, int16_t* dest_buffer) const
+{
+    DCHECK(!is_bitstream_format_);
+    CheckOverflow(0, num_frames_to_read, frames_);
+
+    int frame = 0;
+
+#if defined(ARCH_CPU_X86_FAMILY)
+    if (channels() == 2)
+    {
+        const float* left = channel_data_[0];
+        const float* right = channel_data_[1];
+
+        for (; frame + 4 <= num_frames_to_read; frame += 4)
+        {
+            __m128i left16 = FloatSampleToInt32(_mm_load_ps(left + frame));
+            __m128i right16 = FloatSampleToInt32(_mm_load_ps(right + frame));
+
+            left16 = _mm_packs_epi32(left16, left16);
+            right16 = _mm_packs_epi32(right16, right16);
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest_buffer + frame * 2),
+                             _mm_unpacklo_epi16(left16, right16));
+        }
+    }
+    else if (channels() == 1)
+    {
+        const float* source = channel_data_[0];
+
+        for (; frame + 8 <= num_frames_to_read; frame += 8)
+        {
+            __m128i lo = FloatSampleToInt32(_mm_load_ps(source + frame));
+            __m128i hi = FloatSampleToInt32(_mm_load_ps(source + frame + 4));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest_buffer + frame),
+                             _mm_packs_epi32(lo, hi));
+        }
+    }
+#endif // defined(ARCH_CPU_X86_FAMILY)
+
+    if (frame < num_frames_to_read)
+    {
+        ToInterleavedPartial<SignedInt16SampleTypeTraits>(
+            frame, num_frames_to_read - frame, dest_buffer + frame * channels());
+    }
+}
+
 void AudioBus::CopyTo(AudioBus* dest) const
 {
     dest->set_is_bitstream_format(is_bitstream_format());
@@ -130,6 +130,12 @@ public:
         int num_frames_to_read,
         typename TargetSampleTypeTraits::ValueType* dest_buffer) const;
 
+    // Specializations of FromInterleaved() / ToInterleaved() for signed 16-bit samples, the
+    // wire format of the audio pipeline. Mono and stereo data is converted with SSE2 on x86;
+    // other channel counts fall back to the generic implementation.
+    void FromInterleavedInt16(const int16_t* source_buffer, int num_frames_to_write);
+    void ToInterleavedInt16(int num_frames_to_read, int16_t* dest_buffer) const;
+
     // Helper method for copying channel data from one AudioBus to another.  Both
     // AudioBus object must have the same frames() and channels().
     void CopyTo(AudioBus* dest) const;
@@ -0,0 +1,121 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/codec/audio_bus.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+namespace base {
+
+namespace {
+
+std::vector<int16_t> makeRandomSamples(size_t count)
+{
+    std::mt19937 engine(42);
+    std::uniform_int_distribution<int32_t> distance(-32768, 32767);
+
+    std::vector<int16_t> samples(count);
+    for (size_t i = 0; i < count; ++i)
+        samples[i] = static_cast<int16_t>(distance(engine));
+
+    return samples;
+}
+
+} // namespace
+
+// The int16 specializations must produce exactly what the generic template conversion
+// produces, for every frame count around the vector width.
+TEST(audio_bus_test, from_interleaved_int16_matches_template)
+{
+    for (int channels = 1; channels <= 3; ++channels)
+    {
+        for (int frames : { 1, 3, 4, 5, 7, 8, 9, 17, 480 })
+        {
+            std::vector<int16_t> samples =
+                makeRandomSamples(static_cast<size_t>(channels) * frames);
+
+            std::unique_ptr<AudioBus> expected = AudioBus::Create(channels, frames);
+            std::unique_ptr<AudioBus> actual = AudioBus::Create(channels, frames);
+
+            expected->FromInterleaved<SignedInt16SampleTypeTraits>(samples.data(), frames);
+            actual->FromInterleavedInt16(samples.data(), frames);
+
+            for (int ch = 0; ch < channels; ++ch)
+            {
+                for (int i = 0; i < frames; ++i)
+                    ASSERT_EQ(expected->channel(ch)[i], actual->channel(ch)[i]);
+            }
+        }
+    }
+}
+
+TEST(audio_bus_test, to_interleaved_int16_matches_template)
+{
+    for (int channels = 1; channels <= 3; ++channels)
+    {
+        for (int frames : { 1, 3, 4, 5, 7, 8, 9, 17, 480 })
+        {
+            std::vector<int16_t> samples =
+                makeRandomSamples(static_cast<size_t>(channels) * frames);
+
+            std::unique_ptr<AudioBus> bus = AudioBus::Create(channels, frames);
+            bus->FromInterleaved<SignedInt16SampleTypeTraits>(samples.data(), frames);
+
+            // Values outside [-1, 1] must clamp the same way the scalar conversion does.
+            bus->channel(0)[0] = 1.5f;
+            bus->channel(0)[frames - 1] = -1.5f;
+
+            std::vector<int16_t> expected(samples.size());
+            std::vector<int16_t> actual(samples.size());
+
+            bus->ToInterleaved<SignedInt16SampleTypeTraits>(frames, expected.data());
+            bus->ToInterleavedInt16(frames, actual.data());
+
+            ASSERT_EQ(expected, actual);
+        }
+    }
+}
+
+// A full int16 round trip through the float bus. The truncating float-to-int conversion may
+// lose one least significant bit, exactly like the generic template does.
+TEST(audio_bus_test, int16_round_trip)
+{
+    const int kFrames = 480;
+    std::vector<int16_t> samples = makeRandomSamples(2 * kFrames);
+
+    // Include the extremes; these must survive exactly.
+    samples[0] = -32768;
+    samples[1] = 32767;
+
+    std::unique_ptr<AudioBus> bus = AudioBus::Create(2, kFrames);
+    bus->FromInterleavedInt16(samples.data(), kFrames);
+
+    std::vector<int16_t> output(samples.size());
+    bus->ToInterleavedInt16(kFrames, output.data());
+
+    EXPECT_EQ(samples[0], output[0]);
+    EXPECT_EQ(samples[1], output[1]);
+
+    for (size_t i = 0; i < samples.size(); ++i)
+        ASSERT_NEAR(samples[i], output[i], 1);
+}
+
+} // namespace base
@@ -24,6 +24,8 @@
 
 #include <opus.h>
 
+#include <cstdlib>
+
 namespace base {
 
 namespace {
@@ -31,6 +33,24 @@ namespace {
 // Output 64 kb/s bitrate.
 const int kOutputBitrateBps = 64 * 1024;
 
+// Bitrate used while the signal stays near silence. The capturer only drops buffers that are
+// fully silent for a long time (see AudioSilenceDetector), so most of an idle session is spent
+// encoding background noise; it does not deserve the full music bitrate.
+const int kIdleBitrateBps = 24 * 1024;
+
+// Maximum absolute sample value that is still considered near silence. Chosen well above the
+// capturer silence threshold so that faint background noise counts as idle too.
+const int kNearSilenceThreshold = 512;
+
+// Encoder complexity (0-10) for the active and idle modes. Lowering complexity while idle cuts
+// encode CPU; quality loss on near-silent input is inaudible.
+const int kActiveComplexity = 9;
+const int kIdleComplexity = 5;
+
+// Number of consecutive near-silent frames before the encoder switches to the idle mode. Short
+// pauses between sounds keep the full bitrate so the transition is not audible.
+const std::chrono::seconds kNearSilencePeriodBeforeIdle { 1 };
+
 // Opus doesn't support 44100 sampling rate so we always resample to 48kHz.
 const proto::AudioPacket::SamplingRate kOpusSamplingRate =
     proto::AudioPacket::SAMPLING_RATE_48000;
@@ -59,7 +79,9 @@ AudioEncoderOpus::AudioEncoderOpus()
       frame_size_(0),
       resampling_data_(nullptr),
       resampling_data_size_(0),
-      resampling_data_pos_(0)
+      resampling_data_pos_(0),
+      near_silence_frames_(0),
+      idle_mode_(false)
 {
     // Nothing
 }
@@ -82,6 +104,14 @@ void AudioEncoderOpus::initEncoder()
     }
 
     opus_encoder_ctl(encoder_, OPUS_SET_BITRATE(kOutputBitrateBps));
+    opus_encoder_ctl(encoder_, OPUS_SET_COMPLEXITY(kActiveComplexity));
+
+    // With DTX enabled Opus sends a few bytes per frame during silence instead of a full
+    // encoded frame.
+    opus_encoder_ctl(encoder_, OPUS_SET_DTX(1));
+
+    near_silence_frames_ = 0;
+    idle_mode_ = false;
 
     frame_size_ = sampling_rate_ * kFrameSizeMs / std::chrono::milliseconds(1000);
 
@@ -146,7 +176,7 @@ void AudioEncoderOpus::fetchBytesToResample(int resampler_frame_delay, AudioBus*
     int samples_left = (resampling_data_size_ - resampling_data_pos_) / kBytesPerSample / channels_;
     DCHECK_LE(audio_bus->frames(), samples_left);
 
-    audio_bus->FromInterleaved<SignedInt16SampleTypeTraits>(
+    audio_bus->FromInterleavedInt16(
         reinterpret_cast<const int16_t*>(resampling_data_ + resampling_data_pos_),
         audio_bus->frames());
 
@@ -156,7 +186,51 @@ void AudioEncoderOpus::fetchBytesToResample(int resampler_frame_delay, AudioBus*
 
 int AudioEncoderOpus::bitrate()
 {
-    return kOutputBitrateBps;
+    return idle_mode_ ? kIdleBitrateBps : kOutputBitrateBps;
+}
+
+bool AudioEncoderOpus::isNearSilence(const int16_t* samples) const
+{
+    const int samples_count = kFrameSamples * channels_;
+
+    for (int i = 0; i < samples_count; ++i)
+    {
+        if (abs(samples[i]) > kNearSilenceThreshold)
+            return false;
+    }
+
+    return true;
+}
+
+void AudioEncoderOpus::updateEncoderMode(bool near_silence)
+{
+    const int frames_before_idle =
+        static_cast<int>(kNearSilencePeriodBeforeIdle / kFrameSizeMs);
+
+    if (!near_silence)
+    {
+        near_silence_frames_ = 0;
+
+        // Restore the full bitrate immediately so the onset of a sound is not encoded at the
+        // idle quality.
+        if (idle_mode_)
+        {
+            idle_mode_ = false;
+            opus_encoder_ctl(encoder_, OPUS_SET_BITRATE(kOutputBitrateBps));
+            opus_encoder_ctl(encoder_, OPUS_SET_COMPLEXITY(kActiveComplexity));
+        }
+        return;
+    }
+
+    if (near_silence_frames_ < frames_before_idle)
+        ++near_silence_frames_;
+
+    if (near_silence_frames_ >= frames_before_idle && !idle_mode_)
+    {
+        idle_mode_ = true;
+        opus_encoder_ctl(encoder_, OPUS_SET_BITRATE(kIdleBitrateBps));
+        opus_encoder_ctl(encoder_, OPUS_SET_COMPLEXITY(kIdleComplexity));
+    }
 }
 
 bool AudioEncoderOpus::encode(
@@ -211,7 +285,7 @@ bool AudioEncoderOpus::encode(
             resampling_data_ = nullptr;
             samples_consumed = resampling_data_pos_ / channels_ / kBytesPerSample;
 
-            resampler_bus_->ToInterleaved<SignedInt16SampleTypeTraits>(
+            resampler_bus_->ToInterleavedInt16(
                 kFrameSamples, reinterpret_cast<int16_t*>(resample_buffer_.get()));
             pcm_buffer = reinterpret_cast<int16_t*>(resample_buffer_.get());
         }
@@ -220,6 +294,9 @@ bool AudioEncoderOpus::encode(
             samples_consumed = frame_size_;
         }
 
+        // Adapt the bitrate and complexity to the signal level before encoding the frame.
+        updateEncoderMode(isNearSilence(pcm_buffer));
+
         // Initialize output buffer.
         std::string* data = output_packet->add_data();
         data->resize(kFrameSamples * kBytesPerSample * channels_);
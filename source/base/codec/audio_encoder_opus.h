@@ -46,6 +46,12 @@ private:
     bool resetForPacket(const proto::AudioPacket& packet);
     void fetchBytesToResample(int resampler_frame_delay, AudioBus* audio_bus);
 
+    // Returns true if no sample of the frame exceeds the near-silence threshold.
+    bool isNearSilence(const int16_t* samples) const;
+
+    // Switches the encoder between the active and idle (near-silent input) modes.
+    void updateEncoderMode(bool near_silence);
+
     int sampling_rate_;
     proto::AudioPacket::Channels channels_;
     OpusEncoder* encoder_;
@@ -65,6 +71,10 @@ private:
     int leftover_buffer_size_;
     int leftover_samples_;
 
+    // Number of consecutive near-silent frames and the resulting encoder mode.
+    int near_silence_frames_;
+    bool idle_mode_;
+
     DISALLOW_COPY_AND_ASSIGN(AudioEncoderOpus);
 };
 
@@ -22,6 +22,8 @@
 #include "base/desktop/mouse_cursor.h"
 #include "proto/desktop.pb.h"
 
+#include <algorithm>
+
 namespace base {
 
 namespace {
@@ -29,6 +31,11 @@ namespace {
 constexpr size_t kMinCacheSize = 2;
 constexpr size_t kMaxCacheSize = 30;
 
+// Upper bound of the raw-content dictionary built from the cached cursor images. Must match
+// the constant in CursorEncoder; both sides build the dictionary from their caches with the
+// same rule.
+constexpr size_t kMaxDictionarySize = 512 * 1024;
+
 } // namespace
 
 CursorDecoder::CursorDecoder()
@@ -39,19 +46,37 @@ CursorDecoder::CursorDecoder()
 
 CursorDecoder::~CursorDecoder() = default;
 
-ByteArray CursorDecoder::decompressCursor(const proto::CursorShape& cursor_shape) const
+ByteArray CursorDecoder::decompressCursor(const proto::CursorShape& cursor_shape)
 {
     const std::string& data = cursor_shape.data();
 
     if (data.empty())
         return ByteArray();
 
-    ByteArray image;
+    // The spare buffer (if any) already has the capacity of a typical cursor.
+    ByteArray image = std::move(spare_buffer_);
     image.resize(cursor_shape.width() * cursor_shape.height() * sizeof(uint32_t));
 
-    size_t ret = ZSTD_initDStream(stream_.get());
+    size_t ret = ZSTD_DCtx_reset(stream_.get(), ZSTD_reset_session_and_parameters);
     DCHECK(!ZSTD_isError(ret)) << ZSTD_getErrorName(ret);
 
+    // The encoder compressed the cursor against a dictionary built from its cursor cache. The
+    // caches on both sides hold the same cursors in the same order, so the dictionary built
+    // here is byte-identical. The buffer has to stay alive until the decompression is done.
+    ByteArray dictionary;
+    if (cursor_shape.flags() & proto::CursorShape::DICT)
+    {
+        dictionary = buildDictionary();
+        if (dictionary.empty())
+        {
+            LOG(LS_ERROR) << "Dictionary-compressed cursor received with an empty cache";
+            return ByteArray();
+        }
+
+        ret = ZSTD_DCtx_refPrefix(stream_.get(), dictionary.data(), dictionary.size());
+        DCHECK(!ZSTD_isError(ret)) << ZSTD_getErrorName(ret);
+    }
+
     ZSTD_inBuffer input = { data.data(), data.size(), 0 };
     ZSTD_outBuffer output = { image.data(), image.size(), 0 };
 
@@ -68,9 +93,35 @@ ByteArray CursorDecoder::decompressCursor(const proto::CursorShape& cursor_shape
     return image;
 }
 
+ByteArray CursorDecoder::buildDictionary() const
+{
+    // Walk from the most recently used entry backwards, so the freshest cursors are the ones
+    // included when the size cap cuts the dictionary short. The rule mirrors the encoder.
+    size_t total_size = 0;
+    size_t first = cache_.size();
+
+    while (first > 0 && total_size + cache_[first - 1].second->constImage().size() <=
+                            kMaxDictionarySize)
+    {
+        total_size += cache_[first - 1].second->constImage().size();
+        --first;
+    }
+
+    ByteArray dictionary;
+    dictionary.reserve(total_size);
+
+    for (size_t i = first; i < cache_.size(); ++i)
+    {
+        const ByteArray& image = cache_[i].second->constImage();
+        dictionary.insert(dictionary.end(), image.begin(), image.end());
+    }
+
+    return dictionary;
+}
+
 std::shared_ptr<MouseCursor> CursorDecoder::decode(const proto::CursorShape& cursor_shape)
 {
-    size_t cache_index;
+    const uint32_t cache_id = cursor_shape.cache_id();
 
     if (cursor_shape.flags() & proto::CursorShape::CACHE)
     {
@@ -80,8 +131,27 @@ std::shared_ptr<MouseCursor> CursorDecoder::decode(const proto::CursorShape& cur
             return nullptr;
         }
 
-        // Bits 0-4 contain the cursor position in the cache.
-        cache_index = cursor_shape.flags() & 0x1F;
+        // Looking for the cursor with the specified content identifier.
+        auto it = std::find_if(cache_.begin(), cache_.end(),
+                               [cache_id](const auto& entry)
+        {
+            return entry.first == cache_id;
+        });
+
+        if (it == cache_.end())
+        {
+            LOG(LS_ERROR) << "Cursor with id " << cache_id << " not found in cache";
+            return nullptr;
+        }
+
+        // Move the cursor to the most recently used position; the encoder does the same on the
+        // cache hit, so both sides evict the same cursor later.
+        std::shared_ptr<MouseCursor> mouse_cursor = it->second;
+
+        cache_.erase(it);
+        cache_.emplace_back(cache_id, mouse_cursor);
+
+        return mouse_cursor;
     }
     else
     {
@@ -122,25 +192,22 @@ std::shared_ptr<MouseCursor> CursorDecoder::decode(const proto::CursorShape& cur
         }
 
         // Add the cursor to the end of the list.
-        cache_.emplace_back(std::move(mouse_cursor));
+        cache_.emplace_back(cache_id, std::shared_ptr<MouseCursor>(std::move(mouse_cursor)));
 
         // If the current cache size exceeds the maximum cache size.
         if (cache_.size() > cache_size_.value())
         {
-            // Delete the first element in the cache (the oldest one).
+            // Delete the first element in the cache (the least recently used one). Its bitmap
+            // is kept for the next decoded cursor unless someone else still uses it.
+            std::shared_ptr<MouseCursor>& evicted = cache_.front().second;
+            if (evicted.use_count() == 1)
+                spare_buffer_ = std::move(evicted->image());
+
             cache_.erase(cache_.begin());
         }
 
-        cache_index = cache_.size() - 1;
+        return cache_.back().second;
     }
-
-    if (cache_index >= cache_.size())
-    {
-        LOG(LS_ERROR) << "Invalid cache index: " << cache_index;
-        return nullptr;
-    }
-
-    return cache_.at(cache_index);
 }
 
 } // namespace base
@@ -24,6 +24,8 @@
 #include "base/memory/byte_array.h"
 
 #include <optional>
+#include <utility>
+#include <vector>
 
 namespace proto {
 class CursorShape;
@@ -42,12 +44,20 @@ public:
     std::shared_ptr<MouseCursor> decode(const proto::CursorShape& cursor_shape);
 
 private:
-    ByteArray decompressCursor(const proto::CursorShape& cursor_shape) const;
+    ByteArray decompressCursor(const proto::CursorShape& cursor_shape);
+    ByteArray buildDictionary() const;
 
-    std::vector<std::shared_ptr<MouseCursor>> cache_;
+    // Cached cursors keyed by the content-hash identifier from the host, ordered from the least
+    // to the most recently used. The encoder applies the same ordering rules, so both caches
+    // always hold the same set of cursors.
+    std::vector<std::pair<uint32_t, std::shared_ptr<MouseCursor>>> cache_;
     std::optional<size_t> cache_size_;
     ScopedZstdDStream stream_;
 
+    // Buffer reclaimed from the last evicted cursor; the next decoded shape reuses it instead
+    // of allocating a fresh one.
+    ByteArray spare_buffer_;
+
     DISALLOW_COPY_AND_ASSIGN(CursorDecoder);
 };
 
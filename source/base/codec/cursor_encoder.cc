@@ -19,10 +19,12 @@
 #include "base/codec/cursor_encoder.h"
 
 #include "base/logging.h"
+#include "base/crypto/generic_hash.h"
 #include "base/desktop/mouse_cursor.h"
 #include "proto/desktop.pb.h"
 
-#include <libyuv/compare.h>
+#include <algorithm>
+#include <cstring>
 
 namespace base {
 
@@ -34,8 +36,32 @@ constexpr size_t kCacheSize = 30;
 // The compression ratio can be in the range of 1 to 22.
 constexpr int kCompressionRatio = 8;
 
-// Recommended seed value for a hash.
-constexpr uint32_t kHashingSeed = 5381;
+// Upper bound of the raw-content dictionary built from the cached cursor images. Must match
+// the constant in CursorDecoder; both sides build the dictionary from their caches with the
+// same rule.
+constexpr size_t kMaxDictionarySize = 512 * 1024;
+
+// Identifier of the cursor in the cache. The first four bytes of a BLAKE2s hash of the cursor
+// content; with at most 30 cached cursors an accidental collision is not a practical concern.
+uint32_t cursorCacheId(const MouseCursor& mouse_cursor)
+{
+    GenericHash hash(GenericHash::BLAKE2s256);
+
+    hash.addData(mouse_cursor.constImage());
+
+    const Size& size = mouse_cursor.size();
+    const Point& hotspot = mouse_cursor.hotSpot();
+
+    int32_t params[] = { size.width(), size.height(), hotspot.x(), hotspot.y() };
+    hash.addData(params, sizeof(params));
+
+    ByteArray result = hash.result();
+    DCHECK_GE(result.size(), sizeof(uint32_t));
+
+    uint32_t cache_id;
+    memcpy(&cache_id, result.data(), sizeof(cache_id));
+    return cache_id;
+}
 
 uint8_t* outputBuffer(proto::CursorShape* cursor_shape, size_t size)
 {
@@ -45,8 +71,9 @@ uint8_t* outputBuffer(proto::CursorShape* cursor_shape, size_t size)
 
 } // namespace
 
-CursorEncoder::CursorEncoder()
-    : stream_(ZSTD_createCStream())
+CursorEncoder::CursorEncoder(bool dictionary_allowed)
+    : dictionary_allowed_(dictionary_allowed),
+      stream_(ZSTD_createCStream())
 {
     static_assert(kCacheSize >= 2 && kCacheSize <= 30);
     static_assert(kCompressionRatio >= 1 && kCompressionRatio <= 22);
@@ -60,9 +87,26 @@ CursorEncoder::~CursorEncoder() = default;
 bool CursorEncoder::compressCursor(
     const MouseCursor& mouse_cursor, proto::CursorShape* cursor_shape) const
 {
-    size_t ret = ZSTD_initCStream(stream_.get(), kCompressionRatio);
+    size_t ret = ZSTD_CCtx_reset(stream_.get(), ZSTD_reset_session_and_parameters);
     DCHECK(!ZSTD_isError(ret)) << ZSTD_getErrorName(ret);
 
+    ret = ZSTD_CCtx_setParameter(stream_.get(), ZSTD_c_compressionLevel, kCompressionRatio);
+    DCHECK(!ZSTD_isError(ret)) << ZSTD_getErrorName(ret);
+
+    // The cached cursors serve as the dictionary: the glyph and alpha patterns of the cursors
+    // of one session are strongly self-similar, so a new cursor mostly consists of matches
+    // into the previous ones. The buffer has to stay alive until the compression is done.
+    ByteArray dictionary;
+    if (dictionary_allowed_ && !cache_.empty())
+    {
+        dictionary = buildDictionary();
+
+        ret = ZSTD_CCtx_refPrefix(stream_.get(), dictionary.data(), dictionary.size());
+        DCHECK(!ZSTD_isError(ret)) << ZSTD_getErrorName(ret);
+
+        cursor_shape->set_flags(cursor_shape->flags() | proto::CursorShape::DICT);
+    }
+
     const size_t input_size = mouse_cursor.constImage().size();
     const uint8_t* input_data = mouse_cursor.constImage().data();
 
@@ -72,23 +116,49 @@ bool CursorEncoder::compressCursor(
     ZSTD_inBuffer input = { input_data, input_size, 0 };
     ZSTD_outBuffer output = { output_data, output_size, 0 };
 
-    while (input.pos < input.size)
+    size_t remaining;
+    do
     {
-        ret = ZSTD_compressStream(stream_.get(), &output, &input);
-        if (ZSTD_isError(ret))
+        remaining = ZSTD_compressStream2(stream_.get(), &output, &input, ZSTD_e_end);
+        if (ZSTD_isError(remaining))
         {
-            LOG(LS_ERROR) << "ZSTD_compressStream failed: " << ZSTD_getErrorName(ret);
+            LOG(LS_ERROR) << "ZSTD_compressStream2 failed: " << ZSTD_getErrorName(remaining);
             return false;
         }
     }
-
-    ret = ZSTD_endStream(stream_.get(), &output);
-    DCHECK(!ZSTD_isError(ret)) << ZSTD_getErrorName(ret);
+    while (remaining != 0);
 
     cursor_shape->mutable_data()->resize(output.pos);
     return true;
 }
 
+ByteArray CursorEncoder::buildDictionary() const
+{
+    // Walk from the most recently used entry backwards, so the freshest cursors are the ones
+    // included when the size cap cuts the dictionary short.
+    size_t total_size = 0;
+    size_t first = cache_.size();
+
+    while (first > 0 && total_size + cache_[first - 1].second.size() <= kMaxDictionarySize)
+    {
+        total_size += cache_[first - 1].second.size();
+        --first;
+    }
+
+    ByteArray dictionary;
+    dictionary.reserve(total_size);
+
+    // The included entries are concatenated in cache order, so the decoder builds a
+    // byte-identical buffer from its own cache.
+    for (size_t i = first; i < cache_.size(); ++i)
+    {
+        const ByteArray& image = cache_[i].second;
+        dictionary.insert(dictionary.end(), image.begin(), image.end());
+    }
+
+    return dictionary;
+}
+
 bool CursorEncoder::encode(const MouseCursor& mouse_cursor, proto::CursorShape* cursor_shape)
 {
     const Size& size = mouse_cursor.size();
@@ -102,20 +172,28 @@ bool CursorEncoder::encode(const MouseCursor& mouse_cursor, proto::CursorShape*
         return false;
     }
 
-    // Calculate the hash of the cursor to search in the cache.
-    uint32_t hash = libyuv::HashDjb2(mouse_cursor.constImage().data(),
-                                     mouse_cursor.constImage().size(),
-                                     kHashingSeed);
+    // Calculate the content hash of the cursor to search in the cache.
+    const uint32_t cache_id = cursorCacheId(mouse_cursor);
 
     // Trying to find cursor in cache.
-    for (size_t index = 0; index < cache_.size(); ++index)
+    auto it = std::find_if(cache_.begin(), cache_.end(),
+                           [cache_id](const auto& entry)
     {
-        if (cache_[index] == hash)
-        {
-            // Cursor found in cache.
-            cursor_shape->set_flags(proto::CursorShape::CACHE | (index & 0x1F));
-            return true;
-        }
+        return entry.first == cache_id;
+    });
+
+    if (it != cache_.end())
+    {
+        // Cursor found in cache. Move it to the most recently used position; the decoder does
+        // the same on the cache hit, so both sides evict the same cursor later.
+        std::pair<uint32_t, ByteArray> entry = std::move(*it);
+
+        cache_.erase(it);
+        cache_.emplace_back(std::move(entry));
+
+        cursor_shape->set_flags(proto::CursorShape::CACHE);
+        cursor_shape->set_cache_id(cache_id);
+        return true;
     }
 
     // Set cursor parameters.
@@ -135,8 +213,12 @@ bool CursorEncoder::encode(const MouseCursor& mouse_cursor, proto::CursorShape*
         cursor_shape->set_flags(proto::CursorShape::RESET_CACHE | (kCacheSize & 0x1F));
     }
 
-    // Add the cursor to the cache.
-    cache_.emplace_back(hash);
+    // The identifier the decoder will store the cursor under.
+    cursor_shape->set_cache_id(cache_id);
+
+    // Add the cursor to the cache. The image copy keeps the dictionary reproducible after the
+    // original cursor is gone.
+    cache_.emplace_back(cache_id, mouse_cursor.constImage());
 
     // If the current cache size exceeds the maximum cache size.
     if (cache_.size() > kCacheSize)
@@ -21,7 +21,9 @@
 
 #include "base/macros_magic.h"
 #include "base/codec/scoped_zstd_stream.h"
+#include "base/memory/byte_array.h"
 
+#include <utility>
 #include <vector>
 
 namespace proto {
@@ -35,16 +37,25 @@ class MouseCursor;
 class CursorEncoder
 {
 public:
-    CursorEncoder();
+    // |dictionary_allowed| enables compression with a dictionary built from the cached
+    // cursors; only clients that announce the CURSOR_DICT configuration flag can decode it.
+    explicit CursorEncoder(bool dictionary_allowed);
     ~CursorEncoder();
 
     bool encode(const MouseCursor& mouse_cursor, proto::CursorShape* cursor_shape);
 
 private:
     bool compressCursor(const MouseCursor& mouse_cursor, proto::CursorShape* cursor_shape) const;
+    ByteArray buildDictionary() const;
 
+    const bool dictionary_allowed_;
     ScopedZstdCStream stream_;
-    std::vector<uint32_t> cache_;
+
+    // Cached cursors with their content-hash identifiers, ordered from the least to the most
+    // recently used. The decoder applies the same ordering rules, so both caches always hold
+    // the same set of cursors; the stored images make the dictionary reproducible on the
+    // decoder side.
+    std::vector<std::pair<uint32_t, ByteArray>> cache_;
 
     DISALLOW_COPY_AND_ASSIGN(CursorEncoder);
 };
@@ -0,0 +1,130 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/codec/cursor_encoder.h"
+
+#include "base/codec/cursor_decoder.h"
+#include "base/desktop/mouse_cursor.h"
+#include "proto/desktop.pb.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+namespace {
+
+// Cursors of one session are strongly self-similar; the seed perturbs a few bytes of an
+// otherwise identical pattern.
+std::unique_ptr<MouseCursor> makeCursor(int seed)
+{
+    const int kWidth = 32;
+    const int kHeight = 32;
+
+    ByteArray image(kWidth * kHeight * sizeof(uint32_t));
+    for (size_t i = 0; i < image.size(); ++i)
+        image[i] = static_cast<uint8_t>((i * 7 + ((i % 96 == 0) ? seed : 0)) & 0xFF);
+
+    return std::make_unique<MouseCursor>(std::move(image), Size(kWidth, kHeight), Point(1, 1));
+}
+
+} // namespace
+
+TEST(CursorEncoderTest, RoundTripWithoutDictionary)
+{
+    CursorEncoder encoder(false);
+    CursorDecoder decoder;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        std::unique_ptr<MouseCursor> cursor = makeCursor(i);
+
+        proto::CursorShape shape;
+        ASSERT_TRUE(encoder.encode(*cursor, &shape));
+        EXPECT_FALSE(shape.flags() & proto::CursorShape::DICT);
+
+        std::shared_ptr<MouseCursor> decoded = decoder.decode(shape);
+        ASSERT_TRUE(decoded);
+        EXPECT_EQ(decoded->constImage(), cursor->constImage());
+    }
+}
+
+TEST(CursorEncoderTest, RoundTripWithDictionary)
+{
+    CursorEncoder encoder(true);
+    CursorDecoder decoder;
+
+    size_t first_size = 0;
+    size_t last_size = 0;
+
+    // More cursors than the cache holds, so evictions happen on both sides.
+    for (int i = 0; i < 40; ++i)
+    {
+        std::unique_ptr<MouseCursor> cursor = makeCursor(i);
+
+        proto::CursorShape shape;
+        ASSERT_TRUE(encoder.encode(*cursor, &shape));
+
+        // The first cursor has no cache to build a dictionary from.
+        EXPECT_EQ((shape.flags() & proto::CursorShape::DICT) != 0, i != 0);
+
+        std::shared_ptr<MouseCursor> decoded = decoder.decode(shape);
+        ASSERT_TRUE(decoded);
+        EXPECT_EQ(decoded->constImage(), cursor->constImage());
+
+        if (i == 0)
+            first_size = shape.data().size();
+        last_size = shape.data().size();
+    }
+
+    // A cursor compressed against the dictionary is smaller than the cold first one.
+    EXPECT_LT(last_size, first_size);
+}
+
+TEST(CursorEncoderTest, CacheHitKeepsDictionariesInSync)
+{
+    CursorEncoder encoder(true);
+    CursorDecoder decoder;
+
+    for (int i = 0; i < 5; ++i)
+    {
+        std::unique_ptr<MouseCursor> cursor = makeCursor(i);
+
+        proto::CursorShape shape;
+        ASSERT_TRUE(encoder.encode(*cursor, &shape));
+        ASSERT_TRUE(decoder.decode(shape));
+    }
+
+    // The repeated cursor comes from the cache and reorders it on both sides.
+    std::unique_ptr<MouseCursor> repeat = makeCursor(2);
+    proto::CursorShape cached_shape;
+    ASSERT_TRUE(encoder.encode(*repeat, &cached_shape));
+    EXPECT_TRUE(cached_shape.flags() & proto::CursorShape::CACHE);
+    ASSERT_TRUE(decoder.decode(cached_shape));
+
+    // The next new cursor compresses against the reordered cache.
+    std::unique_ptr<MouseCursor> fresh = makeCursor(1000);
+    proto::CursorShape shape;
+    ASSERT_TRUE(encoder.encode(*fresh, &shape));
+    EXPECT_TRUE(shape.flags() & proto::CursorShape::DICT);
+
+    std::shared_ptr<MouseCursor> decoded = decoder.decode(shape);
+    ASSERT_TRUE(decoded);
+    EXPECT_EQ(decoded->constImage(), fresh->constImage());
+}
+
+} // namespace base
@@ -0,0 +1,81 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/codec/delivery_rate_estimator.h"
+
+namespace base {
+
+namespace {
+
+// Sliding window over which the delivery rate is measured.
+constexpr std::chrono::seconds kWindowDuration{ 3 };
+
+// An arrival gap longer than this counts as idle time: the sender had nothing queued, so the
+// gap says nothing about the network. Video frames arrive tens of milliseconds apart even at
+// low frame rates, and closer together when the link is saturated and frames queue up.
+constexpr std::chrono::milliseconds kMaxBurstGap{ 250 };
+
+// Minimum active receiving time and delivered volume before an estimate is produced. Below
+// these the division is dominated by scheduling noise on the receiving thread.
+constexpr std::chrono::milliseconds kMinActiveTime{ 50 };
+constexpr size_t kMinActiveBytes = 16 * 1024;
+
+} // namespace
+
+DeliveryRateEstimator::DeliveryRateEstimator()
+{
+    // Nothing
+}
+
+DeliveryRateEstimator::~DeliveryRateEstimator() = default;
+
+void DeliveryRateEstimator::addMessage(size_t size, TimePoint time)
+{
+    messages_.push_back(Message{ time, size });
+
+    while (!messages_.empty() && messages_.front().time < time - kWindowDuration)
+        messages_.pop_front();
+}
+
+int DeliveryRateEstimator::bandwidthKbps() const
+{
+    std::chrono::microseconds active_time{ 0 };
+    int64_t active_bytes = 0;
+
+    // The first message of a burst has an unknown transfer time, so each message is accounted
+    // together with the gap that precedes it and bursts are measured from their second message.
+    for (size_t i = 1; i < messages_.size(); ++i)
+    {
+        const std::chrono::microseconds gap =
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                messages_[i].time - messages_[i - 1].time);
+        if (gap > kMaxBurstGap)
+            continue;
+
+        active_time += gap;
+        active_bytes += static_cast<int64_t>(messages_[i].size);
+    }
+
+    if (active_time < kMinActiveTime || active_bytes < static_cast<int64_t>(kMinActiveBytes))
+        return 0;
+
+    // Bytes per microsecond of active time, converted to kilobits per second.
+    return static_cast<int>(active_bytes * 8 * 1000 / active_time.count());
+}
+
+} // namespace base
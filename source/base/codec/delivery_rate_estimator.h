@@ -0,0 +1,66 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__CODEC__DELIVERY_RATE_ESTIMATOR_H
+#define BASE__CODEC__DELIVERY_RATE_ESTIMATOR_H
+
+#include "base/macros_magic.h"
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+
+namespace base {
+
+// Estimates the rate at which messages are delivered to the receiving side of a connection.
+// The receiver records the arrival time and size of every message; the estimate is the number
+// of bytes delivered per unit of active receiving time over a sliding window. Arrival gaps
+// longer than a burst threshold count as idle time (the sender had nothing queued) and are
+// excluded, so a static screen does not look like a slow network.
+class DeliveryRateEstimator
+{
+public:
+    DeliveryRateEstimator();
+    ~DeliveryRateEstimator();
+
+    using Clock = std::chrono::steady_clock;
+    using TimePoint = Clock::time_point;
+
+    // Records the arrival of a message of |size| bytes at time |time|.
+    void addMessage(size_t size, TimePoint time);
+
+    // Delivery rate over the sliding window in kilobits per second, or 0 if too little data
+    // was received to measure it.
+    int bandwidthKbps() const;
+
+private:
+    struct Message
+    {
+        TimePoint time;
+        size_t size = 0;
+    };
+
+    // Messages received within the sliding window, in arrival order.
+    std::deque<Message> messages_;
+
+    DISALLOW_COPY_AND_ASSIGN(DeliveryRateEstimator);
+};
+
+} // namespace base
+
+#endif // BASE__CODEC__DELIVERY_RATE_ESTIMATOR_H
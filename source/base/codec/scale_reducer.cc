@@ -23,6 +23,8 @@
 
 #include <libyuv/scale_argb.h>
 
+#include <cmath>
+
 namespace base {
 
 ScaleReducer::ScaleReducer() = default;
@@ -81,12 +83,22 @@ const Frame* ScaleReducer::scaleFrame(const Frame* source_frame, const Size& tar
         Region* updated_region = target_frame_->updatedRegion();
         updated_region->clear();
 
+        // Accumulate the scaled rectangles in the region first. Neighboring dirty rectangles
+        // overlap in the target after the filter tap expansion; the region coalesces them, so
+        // every target pixel is rescaled at most once.
         for (Region::Iterator it(source_frame->constUpdatedRegion());
              !it.isAtEnd(); it.advance())
         {
             Rect target_rect = scaledRect(it.rect());
             target_rect.intersectWith(target_frame_rect);
 
+            updated_region->addRect(target_rect);
+        }
+
+        for (Region::Iterator it(*updated_region); !it.isAtEnd(); it.advance())
+        {
+            const Rect& target_rect = it.rect();
+
             libyuv::ARGBScaleClip(source_frame->frameData(),
                                   source_frame->stride(),
                                   source_size.width(),
@@ -100,8 +112,6 @@ const Frame* ScaleReducer::scaleFrame(const Frame* source_frame, const Size& tar
                                   target_rect.width(),
                                   target_rect.height(),
                                   libyuv::kFilterBox);
-
-            updated_region->addRect(target_rect);
         }
     }
 
@@ -110,16 +120,15 @@ const Frame* ScaleReducer::scaleFrame(const Frame* source_frame, const Size& tar
 
 Rect ScaleReducer::scaledRect(const Rect& source_rect)
 {
-    int left = static_cast<int>(
-        static_cast<double>(source_rect.left() * scale_x_) / 100.0);
-    int top = static_cast<int>(
-        static_cast<double>(source_rect.top() * scale_y_) / 100.0);
-    int right = static_cast<int>(
-        static_cast<double>(source_rect.right() * scale_x_) / 100.0);
-    int bottom = static_cast<int>(
-        static_cast<double>(source_rect.bottom() * scale_y_) / 100.0);
-
-    return Rect::makeLTRB(left - 1, top - 1, right + 2, bottom + 2);
+    // Round the left/top edge down and the right/bottom edge up so the mapped rectangle always
+    // covers every target pixel that samples the source rectangle, then expand it by one pixel
+    // on each side for the taps of the box filter.
+    int left = static_cast<int>(std::floor(source_rect.left() * scale_x_ / 100.0));
+    int top = static_cast<int>(std::floor(source_rect.top() * scale_y_ / 100.0));
+    int right = static_cast<int>(std::ceil(source_rect.right() * scale_x_ / 100.0));
+    int bottom = static_cast<int>(std::ceil(source_rect.bottom() * scale_y_ / 100.0));
+
+    return Rect::makeLTRB(left - 1, top - 1, right + 1, bottom + 1);
 }
 
 } // namespace base
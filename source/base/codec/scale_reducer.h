@@ -28,6 +28,11 @@ namespace base {
 
 class Frame;
 
+// Scales captured frames down to the size requested by the client. The scaled frame is kept
+// across calls and only the updated region of the source frame is rescaled into it (expanded
+// for the filter taps), so the cost per frame is proportional to the damaged area rather than
+// to the screen size. A full rescale happens only on the first frame and when the source or
+// target size changes.
 class ScaleReducer
 {
 public:
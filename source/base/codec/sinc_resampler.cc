@@ -96,13 +96,10 @@
 #include <limits>
 
 #if defined(ARCH_CPU_X86_FAMILY)
+#include "base/cpuid_util.h"
 #include <xmmintrin.h>
-#define CONVOLVE_FUNC Convolve_SSE
 #elif defined(ARCH_CPU_ARM_FAMILY) && defined(USE_NEON)
 #include <arm_neon.h>
-#define CONVOLVE_FUNC Convolve_NEON
-#else
-#define CONVOLVE_FUNC Convolve_C
 #endif
 
 namespace base {
@@ -158,18 +155,34 @@ static int CalculateChunkSize(int block_size_, double io_ratio)
     return block_size_ / io_ratio;
 }
 
+// static
+SincResampler::ConvolveProc SincResampler::SelectConvolveProc()
+{
+#if defined(ARCH_CPU_X86_FAMILY)
+    // The AVX2 kernel uses FMA instructions; both must be present.
+    if (CpuidUtil::hasAvx2() && CpuidUtil::hasFma())
+        return Convolve_AVX2;
+    return Convolve_SSE;
+#elif defined(ARCH_CPU_ARM_FAMILY) && defined(USE_NEON)
+    return Convolve_NEON;
+#else
+    return Convolve_C;
+#endif
+}
+
 SincResampler::SincResampler(double io_sample_rate_ratio,
                              int request_frames,
                              const ReadCB& read_cb)
-    : io_sample_rate_ratio_(io_sample_rate_ratio),
+    : convolve_proc_(SelectConvolveProc()),
+      io_sample_rate_ratio_(io_sample_rate_ratio),
       read_cb_(read_cb),
       request_frames_(request_frames),
       input_buffer_size_(request_frames_ + kKernelSize),
-      // Create input buffers with a 16-byte alignment for SSE optimizations.
-      kernel_storage_(static_cast<float*>(alignedAlloc(sizeof(float) * kKernelStorageSize, 16))),
-      kernel_pre_sinc_storage_(static_cast<float*>(alignedAlloc(sizeof(float) * kKernelStorageSize, 16))),
-      kernel_window_storage_(static_cast<float*>(alignedAlloc(sizeof(float) * kKernelStorageSize, 16))),
-      input_buffer_(static_cast<float*>(alignedAlloc(sizeof(float) * input_buffer_size_, 16))),
+      // Create input buffers with a 32-byte alignment for SSE/AVX2 optimizations.
+      kernel_storage_(static_cast<float*>(alignedAlloc(sizeof(float) * kKernelStorageSize, 32))),
+      kernel_pre_sinc_storage_(static_cast<float*>(alignedAlloc(sizeof(float) * kKernelStorageSize, 32))),
+      kernel_window_storage_(static_cast<float*>(alignedAlloc(sizeof(float) * kKernelStorageSize, 32))),
+      input_buffer_(static_cast<float*>(alignedAlloc(sizeof(float) * input_buffer_size_, 32))),
       r1_(input_buffer_.get()),
       r2_(input_buffer_.get() + kKernelSize / 2)
 {
@@ -300,17 +313,17 @@ void SincResampler::Resample(int frames, float* destination)
                 const float* k1 = kernel_storage_.get() + offset_idx * kKernelSize;
                 const float* k2 = k1 + kKernelSize;
 
-                // Ensure |k1|, |k2| are 16-byte aligned for SIMD usage.  Should always
-                // be true so long as kKernelSize is a multiple of 16.
-                DCHECK_EQ(0u, reinterpret_cast<uintptr_t>(k1) & 0x0F);
-                DCHECK_EQ(0u, reinterpret_cast<uintptr_t>(k2) & 0x0F);
+                // Ensure |k1|, |k2| are 32-byte aligned for SIMD usage.  Should always
+                // be true so long as kKernelSize is a multiple of 32.
+                DCHECK_EQ(0u, reinterpret_cast<uintptr_t>(k1) & 0x1F);
+                DCHECK_EQ(0u, reinterpret_cast<uintptr_t>(k2) & 0x1F);
 
                 // Initialize input pointer based on quantized |virtual_source_idx_|.
                 const float* input_ptr = r1_ + source_idx;
 
                 // Figure out how much to weight each kernel's "convolution".
                 const double kernel_interpolation_factor = virtual_offset_idx - offset_idx;
-                *destination++ = CONVOLVE_FUNC(input_ptr, k1, k2, kernel_interpolation_factor);
+                *destination++ = convolve_proc_(input_ptr, k1, k2, kernel_interpolation_factor);
 
                 // Advance the virtual index.
                 virtual_source_idx_ += io_sample_rate_ratio_;
@@ -101,20 +101,33 @@ private:
 
     // Compute convolution of |k1| and |k2| over |input_ptr|, resultant sums are
     // linearly interpolated using |kernel_interpolation_factor|.  On x86, the
-    // underlying implementation is chosen at run time based on SSE support.  On
-    // ARM, NEON support is chosen at compile time based on compilation flags.
+    // underlying implementation is chosen at run time: AVX2+FMA when the CPU
+    // supports it, SSE otherwise.  On ARM, NEON support is chosen at compile
+    // time based on compilation flags.
+    using ConvolveProc = float (*)(const float* input_ptr, const float* k1,
+                                   const float* k2,
+                                   double kernel_interpolation_factor);
+    static ConvolveProc SelectConvolveProc();
+
     static float Convolve_C(const float* input_ptr, const float* k1,
                             const float* k2, double kernel_interpolation_factor);
 #if defined(ARCH_CPU_X86_FAMILY)
     static float Convolve_SSE(const float* input_ptr, const float* k1,
                               const float* k2,
                               double kernel_interpolation_factor);
+    // Defined in sinc_resampler_avx2.cc, which is compiled with AVX2/FMA enabled.
+    static float Convolve_AVX2(const float* input_ptr, const float* k1,
+                               const float* k2,
+                               double kernel_interpolation_factor);
 #elif defined(ARCH_CPU_ARM_FAMILY) && defined(USE_NEON)
     static float Convolve_NEON(const float* input_ptr, const float* k1,
                                const float* k2,
                                double kernel_interpolation_factor);
 #endif
 
+    // Convolution implementation selected at construction time.
+    const ConvolveProc convolve_proc_;
+
     // The ratio of input / output sample rates.
     double io_sample_rate_ratio_;
 
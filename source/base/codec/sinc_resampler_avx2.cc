@@ -0,0 +1,66 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/codec/sinc_resampler.h"
+
+#include "build/build_config.h"
+
+#if defined(ARCH_CPU_X86_FAMILY)
+
+#include <immintrin.h>
+
+namespace base {
+
+// This file is compiled with AVX2 and FMA enabled; the function must only be called after
+// CpuidUtil has confirmed that the CPU supports both (see SelectConvolveProc()).
+float SincResampler::Convolve_AVX2(const float* input_ptr, const float* k1,
+                                   const float* k2,
+                                   double kernel_interpolation_factor)
+{
+    __m256 m_sums1 = _mm256_setzero_ps();
+    __m256 m_sums2 = _mm256_setzero_ps();
+
+    // |input_ptr| has arbitrary offsets into the input buffer, so it is loaded unaligned.
+    // The kernels are 32-byte aligned by construction.
+    for (int i = 0; i < kKernelSize; i += 8)
+    {
+        const __m256 m_input = _mm256_loadu_ps(input_ptr + i);
+        m_sums1 = _mm256_fmadd_ps(m_input, _mm256_load_ps(k1 + i), m_sums1);
+        m_sums2 = _mm256_fmadd_ps(m_input, _mm256_load_ps(k2 + i), m_sums2);
+    }
+
+    // Linearly interpolate the two "convolutions".
+    m_sums1 = _mm256_mul_ps(
+        m_sums1, _mm256_set1_ps(static_cast<float>(1.0 - kernel_interpolation_factor)));
+    m_sums1 = _mm256_fmadd_ps(
+        m_sums2, _mm256_set1_ps(static_cast<float>(kernel_interpolation_factor)), m_sums1);
+
+    // Sum components together.
+    __m128 m_sum =
+        _mm_add_ps(_mm256_castps256_ps128(m_sums1), _mm256_extractf128_ps(m_sums1, 1));
+    m_sum = _mm_add_ps(m_sum, _mm_movehl_ps(m_sum, m_sum));
+
+    float result;
+    _mm_store_ss(&result, _mm_add_ss(m_sum, _mm_shuffle_ps(m_sum, m_sum, 1)));
+
+    return result;
+}
+
+} // namespace base
+
+#endif // defined(ARCH_CPU_X86_FAMILY)
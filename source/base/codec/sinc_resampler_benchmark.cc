@@ -0,0 +1,73 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/codec/sinc_resampler.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <vector>
+
+namespace base {
+
+namespace {
+
+// Resamples one second of a sine wave at the ratios the audio capturer actually hits: 44.1 kHz
+// and 96 kHz device rates converted to the 48 kHz transport rate.
+void runResample(benchmark::State& state, double io_sample_rate_ratio)
+{
+    const int kOutputFrames = 48000;
+
+    double phase = 0.0;
+    SincResampler resampler(io_sample_rate_ratio, SincResampler::kDefaultRequestSize,
+        [&phase](int frames, float* destination)
+        {
+            for (int i = 0; i < frames; ++i)
+            {
+                destination[i] = static_cast<float>(std::sin(phase));
+                phase += 0.01;
+            }
+        });
+
+    std::vector<float> output(kOutputFrames);
+
+    for (auto _ : state)
+    {
+        resampler.Resample(kOutputFrames, output.data());
+        benchmark::DoNotOptimize(output.data());
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * kOutputFrames);
+}
+
+void BM_SincResampler_44100To48000(benchmark::State& state)
+{
+    runResample(state, 44100.0 / 48000.0);
+}
+
+void BM_SincResampler_96000To48000(benchmark::State& state)
+{
+    runResample(state, 96000.0 / 48000.0);
+}
+
+BENCHMARK(BM_SincResampler_44100To48000);
+BENCHMARK(BM_SincResampler_96000To48000);
+
+} // namespace
+
+} // namespace base
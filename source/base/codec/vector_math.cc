@@ -25,6 +25,8 @@
 
 // NaCl does not allow intrinsics.
 #if defined(ARCH_CPU_X86_FAMILY)
+#include "base/cpuid_util.h"
+#include "base/codec/vector_math_avx2.h"
 #include <xmmintrin.h>
 // Don't use custom SSE versions where the auto-vectorized C version performs better, which is
 // anywhere clang is used.
@@ -286,11 +288,24 @@ std::pair<float, float> EWMAAndMaxPower_NEON(
 }
 #endif
 
+#if defined(ARCH_CPU_X86_FAMILY)
+// The AVX2 implementations use FMA instructions, so both features are required.
+static bool HasAvx2AndFma()
+{
+    static const bool has_avx2_and_fma = CpuidUtil::hasAvx2() && CpuidUtil::hasFma();
+    return has_avx2_and_fma;
+}
+#endif
+
 void FMAC(const float src[], float scale, int len, float dest[])
 {
     // Ensure |src| and |dest| are 16-byte aligned.
     DCHECK_EQ(0u, reinterpret_cast<uintptr_t>(src) & (kRequiredAlignment - 1));
     DCHECK_EQ(0u, reinterpret_cast<uintptr_t>(dest) & (kRequiredAlignment - 1));
+#if defined(ARCH_CPU_X86_FAMILY)
+    if (HasAvx2AndFma())
+        return FMAC_AVX2(src, scale, len, dest);
+#endif
     return FMAC_FUNC(src, scale, len, dest);
 }
 
@@ -299,6 +314,10 @@ void FMUL(const float src[], float scale, int len, float dest[])
     // Ensure |src| and |dest| are 16-byte aligned.
     DCHECK_EQ(0u, reinterpret_cast<uintptr_t>(src) & (kRequiredAlignment - 1));
     DCHECK_EQ(0u, reinterpret_cast<uintptr_t>(dest) & (kRequiredAlignment - 1));
+#if defined(ARCH_CPU_X86_FAMILY)
+    if (HasAvx2AndFma())
+        return FMUL_AVX2(src, scale, len, dest);
+#endif
     return FMUL_FUNC(src, scale, len, dest);
 }
 
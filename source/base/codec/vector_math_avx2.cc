@@ -0,0 +1,65 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/codec/vector_math_avx2.h"
+
+#if defined(ARCH_CPU_X86_FAMILY)
+
+#include <immintrin.h>
+
+namespace base {
+
+// Callers only guarantee 16-byte alignment (vector_math.h kRequiredAlignment), so the 256-bit
+// loads and stores are unaligned; on AVX2 hardware they are as fast as aligned ones when the
+// address happens to be aligned.
+
+void FMAC_AVX2(const float src[], float scale, int len, float dest[])
+{
+    const int rem = len % 8;
+    const int last_index = len - rem;
+    const __m256 m_scale = _mm256_set1_ps(scale);
+
+    for (int i = 0; i < last_index; i += 8)
+    {
+        _mm256_storeu_ps(dest + i,
+                         _mm256_fmadd_ps(_mm256_loadu_ps(src + i), m_scale,
+                                         _mm256_loadu_ps(dest + i)));
+    }
+
+    // Handle any remaining values that wouldn't fit in an AVX2 pass.
+    for (int i = last_index; i < len; ++i)
+        dest[i] += src[i] * scale;
+}
+
+void FMUL_AVX2(const float src[], float scale, int len, float dest[])
+{
+    const int rem = len % 8;
+    const int last_index = len - rem;
+    const __m256 m_scale = _mm256_set1_ps(scale);
+
+    for (int i = 0; i < last_index; i += 8)
+        _mm256_storeu_ps(dest + i, _mm256_mul_ps(_mm256_loadu_ps(src + i), m_scale));
+
+    // Handle any remaining values that wouldn't fit in an AVX2 pass.
+    for (int i = last_index; i < len; ++i)
+        dest[i] = src[i] * scale;
+}
+
+} // namespace base
+
+#endif // defined(ARCH_CPU_X86_FAMILY)
@@ -0,0 +1,37 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__CODEC__VECTOR_MATH_AVX2_H
+#define BASE__CODEC__VECTOR_MATH_AVX2_H
+
+#include "build/build_config.h"
+
+#if defined(ARCH_CPU_X86_FAMILY)
+
+namespace base {
+
+// AVX2+FMA implementations of the vector_math.h primitives. Compiled in a separate translation
+// unit with the corresponding instruction sets enabled; call only when CpuidUtil reports AVX2
+// and FMA support.
+void FMAC_AVX2(const float src[], float scale, int len, float dest[]);
+void FMUL_AVX2(const float src[], float scale, int len, float dest[]);
+
+} // namespace base
+
+#endif // defined(ARCH_CPU_X86_FAMILY)
+#endif // BASE__CODEC__VECTOR_MATH_AVX2_H
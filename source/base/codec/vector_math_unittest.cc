@@ -0,0 +1,109 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/codec/vector_math.h"
+
+#include "base/codec/vector_math_avx2.h"
+#include "base/cpuid_util.h"
+#include "base/memory/aligned_memory.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+namespace base {
+
+namespace {
+
+// Deliberately not a multiple of the widest SIMD pass so the scalar tail is exercised.
+const int kLength = 101;
+const float kScale = 0.75f;
+
+using FloatBuffer = std::unique_ptr<float[], AlignedFreeDeleter>;
+
+FloatBuffer makeBuffer()
+{
+    return FloatBuffer(static_cast<float*>(alignedAlloc(sizeof(float) * kLength, 32)));
+}
+
+void fillBuffers(float* src, float* dest)
+{
+    for (int i = 0; i < kLength; ++i)
+    {
+        src[i] = static_cast<float>(i) * 0.25f - 10.0f;
+        dest[i] = static_cast<float>(kLength - i);
+    }
+}
+
+} // namespace
+
+TEST(VectorMath, FMAC)
+{
+    FloatBuffer src = makeBuffer();
+    FloatBuffer dest = makeBuffer();
+    fillBuffers(src.get(), dest.get());
+
+    FMAC(src.get(), kScale, kLength, dest.get());
+
+    for (int i = 0; i < kLength; ++i)
+    {
+        const float expected = static_cast<float>(kLength - i) + src[i] * kScale;
+        EXPECT_FLOAT_EQ(expected, dest[i]) << "at index " << i;
+    }
+}
+
+TEST(VectorMath, FMUL)
+{
+    FloatBuffer src = makeBuffer();
+    FloatBuffer dest = makeBuffer();
+    fillBuffers(src.get(), dest.get());
+
+    FMUL(src.get(), kScale, kLength, dest.get());
+
+    for (int i = 0; i < kLength; ++i)
+        EXPECT_FLOAT_EQ(src[i] * kScale, dest[i]) << "at index " << i;
+}
+
+#if defined(ARCH_CPU_X86_FAMILY)
+TEST(VectorMath, Avx2MatchesScalar)
+{
+    if (!CpuidUtil::hasAvx2() || !CpuidUtil::hasFma())
+    {
+        GTEST_SKIP() << "CPU does not support AVX2/FMA";
+    }
+
+    FloatBuffer src = makeBuffer();
+    FloatBuffer dest = makeBuffer();
+    fillBuffers(src.get(), dest.get());
+
+    FMAC_AVX2(src.get(), kScale, kLength, dest.get());
+
+    for (int i = 0; i < kLength; ++i)
+    {
+        const float expected = static_cast<float>(kLength - i) + src[i] * kScale;
+        EXPECT_FLOAT_EQ(expected, dest[i]) << "at index " << i;
+    }
+
+    FMUL_AVX2(src.get(), kScale, kLength, dest.get());
+
+    for (int i = 0; i < kLength; ++i)
+        EXPECT_FLOAT_EQ(src[i] * kScale, dest[i]) << "at index " << i;
+}
+#endif // defined(ARCH_CPU_X86_FAMILY)
+
+} // namespace base
@@ -0,0 +1,103 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/codec/video_content_classifier.h"
+
+#include <algorithm>
+
+namespace base {
+
+namespace {
+
+// Smoothing factor of the moving average. At 30 frames per second the window covers roughly
+// half a second.
+const double kSmoothingFactor = 1.0 / 16.0;
+
+// Above this damaged fraction of the screen the content counts as motion video, below
+// |kStaticThreshold| as static UI. The gap between the two is the hysteresis band.
+const double kMotionThreshold = 0.35;
+const double kStaticThreshold = 0.08;
+
+// How many consecutive frames the motion level must stay beyond a threshold before the
+// classification changes. About one second at the usual capture rate.
+const int kDecisionFrames = 30;
+
+} // namespace
+
+VideoContentClassifier::ContentType VideoContentClassifier::classify(
+    const Region& updated_region, const Size& screen_size)
+{
+    const int64_t screen_area =
+        static_cast<int64_t>(screen_size.width()) * screen_size.height();
+    if (screen_area <= 0)
+        return content_type_;
+
+    int64_t damaged_area = 0;
+
+    for (Region::Iterator it(updated_region); !it.isAtEnd(); it.advance())
+    {
+        const Rect rect = it.rect();
+        damaged_area += static_cast<int64_t>(rect.width()) * rect.height();
+    }
+
+    const double damaged_fraction =
+        std::min(1.0, static_cast<double>(damaged_area) / static_cast<double>(screen_area));
+
+    motion_level_ += (damaged_fraction - motion_level_) * kSmoothingFactor;
+
+    if (motion_level_ >= kMotionThreshold)
+    {
+        if (content_type_ == ContentType::MOTION_VIDEO)
+        {
+            decision_frames_ = 0;
+        }
+        else if (++decision_frames_ >= kDecisionFrames)
+        {
+            content_type_ = ContentType::MOTION_VIDEO;
+            decision_frames_ = 0;
+        }
+    }
+    else if (motion_level_ <= kStaticThreshold)
+    {
+        if (content_type_ == ContentType::STATIC_UI)
+        {
+            decision_frames_ = 0;
+        }
+        else if (++decision_frames_ >= kDecisionFrames)
+        {
+            content_type_ = ContentType::STATIC_UI;
+            decision_frames_ = 0;
+        }
+    }
+    else
+    {
+        // Inside the hysteresis band; the current classification stands.
+        decision_frames_ = 0;
+    }
+
+    return content_type_;
+}
+
+void VideoContentClassifier::reset()
+{
+    motion_level_ = 0.0;
+    decision_frames_ = 0;
+    content_type_ = ContentType::UNDECIDED;
+}
+
+} // namespace base
@@ -0,0 +1,72 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__CODEC__VIDEO_CONTENT_CLASSIFIER_H
+#define BASE__CODEC__VIDEO_CONTENT_CLASSIFIER_H
+
+#include "base/macros_magic.h"
+#include "base/desktop/geometry.h"
+#include "base/desktop/region.h"
+
+namespace base {
+
+// Classifies the captured content by how much of the screen changes from frame to frame, so
+// that the host can pick the cheapest video encoding that still looks good. Text work and
+// ordinary UI damage small areas; video playback and games repaint most of the screen every
+// frame. The classification is smoothed and switched with hysteresis, so a single scroll or a
+// momentary pause does not flip the encoder back and forth.
+class VideoContentClassifier
+{
+public:
+    VideoContentClassifier() = default;
+
+    enum class ContentType
+    {
+        // Not enough evidence yet. The caller keeps whatever encoding is in use.
+        UNDECIDED,
+
+        // Small localized updates: typing, terminals, ordinary UI work.
+        STATIC_UI,
+
+        // Large areas change continuously: video playback, games, animations.
+        MOTION_VIDEO,
+    };
+
+    // Feeds the damage region of one captured frame and returns the current classification.
+    // Frames are only captured when something changed, so a fully static screen simply stops
+    // feeding the classifier - and stops the encoder as well.
+    ContentType classify(const Region& updated_region, const Size& screen_size);
+
+    // Forgets the accumulated history, e.g. after a screen change.
+    void reset();
+
+private:
+    // Exponential moving average of the damaged screen fraction.
+    double motion_level_ = 0.0;
+
+    // Number of consecutive frames the motion level stayed beyond a switch threshold.
+    int decision_frames_ = 0;
+
+    ContentType content_type_ = ContentType::UNDECIDED;
+
+    DISALLOW_COPY_AND_ASSIGN(VideoContentClassifier);
+};
+
+} // namespace base
+
+#endif // BASE__CODEC__VIDEO_CONTENT_CLASSIFIER_H
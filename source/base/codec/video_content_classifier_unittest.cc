@@ -0,0 +1,92 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/codec/video_content_classifier.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+namespace {
+
+const Size kScreenSize(1920, 1080);
+
+using ContentType = VideoContentClassifier::ContentType;
+
+ContentType feedFrames(VideoContentClassifier* classifier, const Rect& damage, int count)
+{
+    ContentType content_type = ContentType::UNDECIDED;
+
+    for (int i = 0; i < count; ++i)
+        content_type = classifier->classify(Region(damage), kScreenSize);
+
+    return content_type;
+}
+
+} // namespace
+
+TEST(VideoContentClassifierTest, FullScreenDamageIsMotionVideo)
+{
+    VideoContentClassifier classifier;
+
+    EXPECT_EQ(feedFrames(&classifier, Rect::makeWH(1920, 1080), 100),
+              ContentType::MOTION_VIDEO);
+}
+
+TEST(VideoContentClassifierTest, SmallDamageIsStaticUi)
+{
+    VideoContentClassifier classifier;
+
+    // Typing-sized damage.
+    EXPECT_EQ(feedFrames(&classifier, Rect::makeWH(200, 20), 100), ContentType::STATIC_UI);
+}
+
+TEST(VideoContentClassifierTest, MidLevelDamageStaysUndecided)
+{
+    VideoContentClassifier classifier;
+
+    // About 19% of the screen: inside the hysteresis band.
+    EXPECT_EQ(feedFrames(&classifier, Rect::makeWH(1920, 216), 200), ContentType::UNDECIDED);
+}
+
+TEST(VideoContentClassifierTest, SwitchesWithHysteresis)
+{
+    VideoContentClassifier classifier;
+
+    ASSERT_EQ(feedFrames(&classifier, Rect::makeWH(1920, 1080), 100),
+              ContentType::MOTION_VIDEO);
+
+    // A short pause in the playback must not flip the classification.
+    EXPECT_EQ(feedFrames(&classifier, Rect::makeWH(200, 20), 10), ContentType::MOTION_VIDEO);
+
+    // Sustained small damage must.
+    EXPECT_EQ(feedFrames(&classifier, Rect::makeWH(200, 20), 100), ContentType::STATIC_UI);
+}
+
+TEST(VideoContentClassifierTest, Reset)
+{
+    VideoContentClassifier classifier;
+
+    ASSERT_EQ(feedFrames(&classifier, Rect::makeWH(1920, 1080), 100),
+              ContentType::MOTION_VIDEO);
+
+    classifier.reset();
+    EXPECT_EQ(feedFrames(&classifier, Rect::makeWH(1920, 1080), 1), ContentType::UNDECIDED);
+}
+
+} // namespace base
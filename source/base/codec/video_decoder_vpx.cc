@@ -28,10 +28,28 @@
 #include <vpx/vpx_decoder.h>
 #include <vpx/vp8dx.h>
 
+#include <algorithm>
+#include <thread>
+
 namespace base {
 
 namespace {
 
+// Upper bound on decode threads. VP9 splits a frame into at most 4 tile columns at 4K, so
+// threads beyond that only help through row-based multi-threading; past 8 the synchronization
+// overhead eats the gain.
+const unsigned int kMaxDecodeThreads = 8;
+
+unsigned int decodeThreads()
+{
+    // hardware_concurrency() may return 0 when the number of cores cannot be determined.
+    unsigned int threads = std::thread::hardware_concurrency();
+    if (threads == 0)
+        threads = 2;
+
+    return std::min(threads, kMaxDecodeThreads);
+}
+
 bool convertImage(const proto::VideoPacket& packet, vpx_image_t* image, Frame* frame)
 {
     if (image->fmt != VPX_IMG_FMT_I420)
@@ -46,6 +64,11 @@ bool convertImage(const proto::VideoPacket& packet, vpx_image_t* image, Frame* f
     int y_stride = image->stride[0];
     int uv_stride = image->stride[1];
 
+    // The converted rectangles are recorded in the frame, so the UI can repaint only the part of
+    // the screen this packet actually changed.
+    Region* updated_region = frame->updatedRegion();
+    updated_region->clear();
+
     for (int i = 0; i < packet.dirty_rect_size(); ++i)
     {
         const proto::Rect& dirty_rect = packet.dirty_rect(i);
@@ -68,6 +91,8 @@ bool convertImage(const proto::VideoPacket& packet, vpx_image_t* image, Frame* f
                            frame->stride(),
                            rect.width(),
                            rect.height());
+
+        updated_region->addRect(rect);
     }
 
     return true;
@@ -95,7 +120,7 @@ VideoDecoderVPX::VideoDecoderVPX(proto::VideoEncoding encoding)
 
     config.w = 0;
     config.h = 0;
-    config.threads = 2;
+    config.threads = decodeThreads();
 
     vpx_codec_iface_t* algo;
 
@@ -116,6 +141,17 @@ VideoDecoderVPX::VideoDecoderVPX(proto::VideoEncoding encoding)
 
     int ret = vpx_codec_dec_init(codec_.get(), algo, &config, 0);
     CHECK_EQ(ret, VPX_CODEC_OK);
+
+#ifdef VPX_CTRL_VP9D_SET_ROW_MT
+    if (encoding == proto::VIDEO_ENCODING_VP9)
+    {
+        // The host encodes with few tile columns, so tile parallelism alone leaves most decode
+        // threads idle; row-based multi-threading keeps them busy within a tile.
+        ret = vpx_codec_control(codec_.get(), VP9D_SET_ROW_MT, 1);
+        if (ret != VPX_CODEC_OK)
+            LOG(LS_WARNING) << "Unable to enable row multi-threading: " << ret;
+    }
+#endif
 }
 
 bool VideoDecoderVPX::decode(const proto::VideoPacket& packet, Frame* frame)
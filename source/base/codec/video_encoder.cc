@@ -18,16 +18,60 @@
 
 #include "base/codec/video_encoder.h"
 
+#include "base/codec/video_encoder_vpx.h"
 #include "base/desktop/frame.h"
 
 namespace base {
 
+// static
+std::unique_ptr<VideoEncoder> VideoEncoder::create(proto::VideoEncoding encoding)
+{
+    // Hardware backends (NVENC/QuickSync) would be probed here before falling back to the
+    // software encoders; none are built into the tree yet.
+    switch (encoding)
+    {
+        case proto::VIDEO_ENCODING_VP8:
+            return VideoEncoderVPX::createVP8();
+
+        case proto::VIDEO_ENCODING_VP9:
+            return VideoEncoderVPX::createVP9();
+
+        default:
+            return nullptr;
+    }
+}
+
 VideoEncoder::VideoEncoder(proto::VideoEncoding encoding)
     : encoding_(encoding)
 {
     // Nothing
 }
 
+void VideoEncoder::requestKeyFrame()
+{
+    // Ignored by default.
+}
+
+void VideoEncoder::invalidateReferences()
+{
+    // Ignored by default.
+}
+
+void VideoEncoder::setBandwidthEstimateKbps(int /* bandwidth_kbps */)
+{
+    // Ignored by default.
+}
+
+void VideoEncoder::setMaxBitrateKbps(int /* max_bitrate_kbps */)
+{
+    // Ignored by default.
+}
+
+void VideoEncoder::setSpeed(int /* speed */)
+{
+    // Ignored by default.
+}
+
 void VideoEncoder::fillPacketInfo(const Frame* frame, proto::VideoPacket* packet)
 {
     packet->set_encoding(encoding_);
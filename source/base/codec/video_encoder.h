@@ -22,6 +22,8 @@
 #include "base/desktop/geometry.h"
 #include "proto/desktop.pb.h"
 
+#include <memory>
+
 namespace base {
 
 class Frame;
@@ -32,8 +34,38 @@ public:
     explicit VideoEncoder(proto::VideoEncoding encoding);
     virtual ~VideoEncoder() = default;
 
+    // Creates the best available encoder for |encoding|. This is the single place where
+    // alternative backends (e.g. hardware encoders) are selected; callers should not instantiate
+    // concrete encoders directly. Returns nullptr if the encoding is not supported.
+    static std::unique_ptr<VideoEncoder> create(proto::VideoEncoding encoding);
+
     virtual void encode(const Frame* frame, proto::VideoPacket* packet) = 0;
 
+    // Asks the encoder to emit a key frame on the next call to encode(). Used for stream
+    // recovery: a viewer joining mid-stream or a client that detected data loss gets a decodable
+    // frame without restarting the stream. Encoders that cannot comply ignore the request.
+    virtual void requestKeyFrame();
+
+    // Asks the encoder not to reference frames encoded before this call. Cheaper than a key
+    // frame on codecs with multiple reference buffers: the next frame is still predicted, just
+    // not from the frames the client may have lost. Encoders that cannot comply ignore the
+    // request.
+    virtual void invalidateReferences();
+
+    // Tells the encoder the bandwidth available for its output, as measured on the receiving
+    // side. Encoders with a bitrate controller adjust their target bitrate to it; encoders
+    // without one ignore the estimate.
+    virtual void setBandwidthEstimateKbps(int bandwidth_kbps);
+
+    // Caps the target bitrate regardless of the available bandwidth, in kilobits per second.
+    // 0 removes the cap. Encoders without a bitrate controller ignore the cap.
+    virtual void setMaxBitrateKbps(int max_bitrate_kbps);
+
+    // Sets the speed/quality trade-off of the encoder (the libvpx "cpu used" parameter). Higher
+    // values encode faster at lower quality; 0 restores the codec default. Applied to the live
+    // codec context, without restarting the stream. Encoders without such a knob ignore it.
+    virtual void setSpeed(int speed);
+
     proto::VideoEncoding encoding() const { return encoding_; }
 
 protected:
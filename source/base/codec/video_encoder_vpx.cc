@@ -62,6 +62,22 @@ const int kVp9AqModeCyclicRefresh = 3;
 
 const int kDefaultTargetBitrateKbps = 1000;
 
+// Default "cpu used" values; see cpuUsed(). For VP8 the value of 16 has the smallest CPU load
+// (it turns off subpixel motion search). For VP9 this is the lowest CPU usage the codec
+// supports for lossy encoding.
+const int kVp8DefaultCpuUsed = 16;
+const int kVp9DefaultCpuUsed = 6;
+
+// Fastest VP9 speed, used for frames with tiny damage. On such frames almost no macroblocks
+// are active, so the costlier mode decisions of the default speed cannot pay off; switching
+// them off removes most of the fixed per-frame overhead (a blinking cursor is the typical
+// case). VP8 is not switched: its default above is already the fastest setting.
+const int kVp9TinyFrameCpuUsed = 9;
+
+// A frame counts as "tiny" when its updated area does not exceed this number of pixels
+// (16 macroblocks of 16x16).
+const int64_t kTinyFrameThresholdPixels = 16 * 16 * 16;
+
 // Minimum target bitrate per megapixel. The value is chosen experimentally such that when screen
 // is not changing the codec converges to the target quantizer above in less than 10 frames.
 // This value is for VP8 only; reconsider the value for VP9.
@@ -102,54 +118,8 @@ void setCommonCodecParameters(vpx_codec_enc_cfg_t* config, const Size& size)
     config->rc_overshoot_pct = 15;
 }
 
-void createImage(const Size& size,
-                 std::unique_ptr<vpx_image_t>* out_image,
-                 ByteArray* out_image_buffer)
-{
-    std::unique_ptr<vpx_image_t> image = std::make_unique<vpx_image_t>();
-
-    memset(image.get(), 0, sizeof(vpx_image_t));
-
-    image->d_w = image->w = size.width();
-    image->d_h = image->h = size.height();
-
-    image->fmt = VPX_IMG_FMT_YV12;
-    image->x_chroma_shift = 1;
-    image->y_chroma_shift = 1;
-
-    // libyuv's fast-path requires 16-byte aligned pointers and strides, so pad the Y, U and V
-    // planes' strides to multiples of 16 bytes.
-    const int y_stride = ((image->w - 1) & ~15) + 16;
-    const int uv_unaligned_stride = y_stride >> image->x_chroma_shift;
-    const int uv_stride = ((uv_unaligned_stride - 1) & ~15) + 16;
-
-    // libvpx accesses the source image in macro blocks, and will over-read if the image is not
-    // padded out to the next macroblock: crbug.com/119633.
-    // Pad the Y, U and V planes' height out to compensate.
-    // Assuming macroblocks are 16x16, aligning the planes' strides above also macroblock aligned
-    // them.
-    const int y_rows = ((image->h - 1) & ~(kMacroBlockSize - 1)) + kMacroBlockSize;
-    const int uv_rows = y_rows >> image->y_chroma_shift;
-
-    ByteArray image_buffer;
-
-    // Allocate a YUV buffer large enough for the aligned data & padding.
-    image_buffer.resize(y_stride * y_rows + (2 * uv_stride) * uv_rows);
-
-    // Reset image value to 128 so we just need to fill in the y plane.
-    memset(image_buffer.data(), 128, image_buffer.size());
-
-    // Fill in the information.
-    image->planes[0] = image_buffer.data();
-    image->planes[1] = image->planes[0] + y_stride * y_rows;
-    image->planes[2] = image->planes[1] + uv_stride * uv_rows;
-
-    image->stride[0] = y_stride;
-    image->stride[1] = image->stride[2] = uv_stride;
-
-    *out_image = std::move(image);
-    *out_image_buffer = std::move(image_buffer);
-}
+// Alignment of the YUV planes. Covers the widest SIMD stores used by the conversion routines.
+const size_t kImageBufferAlignment = 32;
 
 int roundToTwosMultiple(int x)
 {
@@ -201,7 +171,7 @@ void VideoEncoderVPX::encode(const Frame* frame, proto::VideoPacket* packet)
 
         bitrate_filter_.setFrameSize(frame_size.width(), frame_size.height());
 
-        createImage(frame_size, &image_, &image_buffer_);
+        createImage(frame_size);
         createActiveMap(frame_size);
 
         if (encoding() == proto::VIDEO_ENCODING_VP8)
@@ -217,11 +187,34 @@ void VideoEncoderVPX::encode(const Frame* frame, proto::VideoPacket* packet)
         is_key_frame = true;
     }
 
+    vpx_enc_frame_flags_t frame_flags = 0;
+    bool refresh_full_frame = is_key_frame;
+
+    if (!is_key_frame && key_frame_requested_)
+    {
+        // A forced key frame refreshes the whole image, so the full frame must be converted and
+        // marked active, exactly as on a stream restart.
+        frame_flags |= VPX_EFLAG_FORCE_KF;
+        refresh_full_frame = true;
+    }
+    else if (!is_key_frame && invalidate_references_)
+    {
+        // The frame stays predicted, but must not reference anything the client may have lost.
+        // Unchanged blocks cannot be copied from the dropped references either, so the full
+        // frame is refreshed as well.
+        frame_flags |= VP8_EFLAG_NO_REF_LAST | VP8_EFLAG_NO_REF_GF | VP8_EFLAG_NO_REF_ARF;
+        refresh_full_frame = true;
+    }
+
+    key_frame_requested_ = false;
+    invalidate_references_ = false;
+
     // Convert the updated capture data ready for encode.
     // Update active map based on updated region.
-    int64_t updated_area = prepareImageAndActiveMap(is_key_frame, frame, packet);
+    int64_t updated_area = prepareImageAndActiveMap(refresh_full_frame, frame, packet);
 
     updateConfig(updated_area);
+    updateCpuUsed(updated_area);
 
     // Apply active map to the encoder.
     vpx_codec_err_t ret = vpx_codec_control(codec_.get(), VP8E_SET_ACTIVEMAP, &active_map_);
@@ -233,7 +226,7 @@ void VideoEncoderVPX::encode(const Frame* frame, proto::VideoPacket* packet)
                            0, // pts
                            static_cast<unsigned long>(
                                std::chrono::microseconds(kTargetFrameInterval).count()),
-                           0, // flags
+                           frame_flags,
                            VPX_DL_REALTIME);
     DCHECK_EQ(ret, VPX_CODEC_OK);
 
@@ -256,11 +249,116 @@ void VideoEncoderVPX::encode(const Frame* frame, proto::VideoPacket* packet)
     }
 }
 
+void VideoEncoderVPX::requestKeyFrame()
+{
+    key_frame_requested_ = true;
+}
+
+void VideoEncoderVPX::invalidateReferences()
+{
+    invalidate_references_ = true;
+}
+
 void VideoEncoderVPX::setBandwidthEstimateKbps(int bandwidth_kbps)
 {
     bitrate_filter_.setBandwidthEstimateKbps(bandwidth_kbps);
 }
 
+void VideoEncoderVPX::setMaxBitrateKbps(int max_bitrate_kbps)
+{
+    // Applied by updateConfig() on the next encoded frame.
+    max_bitrate_kbps_ = max_bitrate_kbps;
+}
+
+void VideoEncoderVPX::setSpeed(int speed)
+{
+    // Applied by updateCpuUsed() on the next encoded frame.
+    speed_ = speed;
+}
+
+void VideoEncoderVPX::updateCpuUsed(int64_t updated_area)
+{
+    int cpu_used = cpuUsed();
+
+    // Damage-driven speed selection. An explicit profile speed always wins; without one, a
+    // tiny-damage frame runs at the fastest speed and a regular frame at the default.
+    if (speed_ == 0 && encoding() == proto::VIDEO_ENCODING_VP9 &&
+        updated_area <= kTinyFrameThresholdPixels)
+    {
+        cpu_used = kVp9TinyFrameCpuUsed;
+    }
+
+    if (cpu_used == applied_cpu_used_)
+        return;
+
+    applied_cpu_used_ = cpu_used;
+
+    vpx_codec_err_t ret = vpx_codec_control(codec_.get(), VP8E_SET_CPUUSED, cpu_used);
+    DCHECK_EQ(VPX_CODEC_OK, ret);
+}
+
+int VideoEncoderVPX::cpuUsed() const
+{
+    if (speed_ != 0)
+        return speed_;
+
+    return encoding() == proto::VIDEO_ENCODING_VP8 ? kVp8DefaultCpuUsed : kVp9DefaultCpuUsed;
+}
+
+void VideoEncoderVPX::createImage(const Size& size)
+{
+    std::unique_ptr<vpx_image_t> image = std::make_unique<vpx_image_t>();
+
+    memset(image.get(), 0, sizeof(vpx_image_t));
+
+    image->d_w = image->w = size.width();
+    image->d_h = image->h = size.height();
+
+    image->fmt = VPX_IMG_FMT_YV12;
+    image->x_chroma_shift = 1;
+    image->y_chroma_shift = 1;
+
+    // libyuv's fast-path requires 16-byte aligned pointers and strides, so pad the Y, U and V
+    // planes' strides to multiples of 16 bytes.
+    const int y_stride = ((image->w - 1) & ~15) + 16;
+    const int uv_unaligned_stride = y_stride >> image->x_chroma_shift;
+    const int uv_stride = ((uv_unaligned_stride - 1) & ~15) + 16;
+
+    // libvpx accesses the source image in macro blocks, and will over-read if the image is not
+    // padded out to the next macroblock: crbug.com/119633.
+    // Pad the Y, U and V planes' height out to compensate.
+    // Assuming macroblocks are 16x16, aligning the planes' strides above also macroblock aligned
+    // them.
+    const int y_rows = ((image->h - 1) & ~(kMacroBlockSize - 1)) + kMacroBlockSize;
+    const int uv_rows = y_rows >> image->y_chroma_shift;
+
+    // YUV buffer large enough for the aligned data & padding. The RGB-to-I420 conversion writes
+    // into these planes and libvpx consumes them in place, so this is the only buffer on the
+    // encode path. It is kept across stream restarts and only reallocated when the frame grows.
+    const size_t buffer_size =
+        static_cast<size_t>(y_stride * y_rows + (2 * uv_stride) * uv_rows);
+
+    if (!image_buffer_ || image_buffer_size_ < buffer_size)
+    {
+        image_buffer_.reset(
+            reinterpret_cast<uint8_t*>(alignedAlloc(buffer_size, kImageBufferAlignment)));
+        image_buffer_size_ = buffer_size;
+    }
+
+    // Reset image value to 128 so we just need to fill in the y plane.
+    memset(image_buffer_.get(), 128, buffer_size);
+
+    // Fill in the information.
+    image->planes[0] = image_buffer_.get();
+    image->planes[1] = image->planes[0] + y_stride * y_rows;
+    image->planes[2] = image->planes[1] + uv_stride * uv_rows;
+
+    image->stride[0] = y_stride;
+    image->stride[1] = image->stride[2] = uv_stride;
+
+    image_ = std::move(image);
+}
+
 void VideoEncoderVPX::createActiveMap(const Size& size)
 {
     active_map_.cols = (size.width() + kMacroBlockSize - 1) / kMacroBlockSize;
@@ -270,6 +368,7 @@ void VideoEncoderVPX::createActiveMap(const Size& size)
     active_map_.active_map = active_map_buffer_.data();
 
     clearActiveMap();
+    active_map_region_.clear();
 }
 
 void VideoEncoderVPX::createVp8Codec(const Size& size)
@@ -300,9 +399,9 @@ void VideoEncoderVPX::createVp8Codec(const Size& size)
     ret = vpx_codec_enc_init(codec_.get(), algo, &config_, 0);
     DCHECK_EQ(VPX_CODEC_OK, ret);
 
-    // Value of 16 will have the smallest CPU load. This turns off subpixel motion search.
-    ret = vpx_codec_control(codec_.get(), VP8E_SET_CPUUSED, 16);
+    ret = vpx_codec_control(codec_.get(), VP8E_SET_CPUUSED, cpuUsed());
     DCHECK_EQ(VPX_CODEC_OK, ret);
+    applied_cpu_used_ = cpuUsed();
 
     ret = vpx_codec_control(codec_.get(), VP8E_SET_SCREEN_CONTENT_MODE, 1);
     DCHECK_EQ(VPX_CODEC_OK, ret);
@@ -338,14 +437,31 @@ void VideoEncoderVPX::createVp9Codec(const Size& size)
     ret = vpx_codec_enc_init(codec_.get(), algo, &config_, 0);
     DCHECK_EQ(VPX_CODEC_OK, ret);
 
-    // Request the lowest-CPU usage that VP9 supports, which depends on whether we are encoding
-    // lossy or lossless.
-    ret = vpx_codec_control(codec_.get(), VP8E_SET_CPUUSED, 6);
+    ret = vpx_codec_control(codec_.get(), VP8E_SET_CPUUSED, cpuUsed());
     DCHECK_EQ(VPX_CODEC_OK, ret);
+    applied_cpu_used_ = cpuUsed();
 
     ret = vpx_codec_control(codec_.get(), VP9E_SET_TUNE_CONTENT, VP9E_CONTENT_SCREEN);
     DCHECK_EQ(VPX_CODEC_OK, ret);
 
+    // Split the frame into tile columns so the encoder threads can work on them independently.
+    // Each tile column should cover at least 256 pixels to be worth a thread, and more columns
+    // than threads bring no gain. The control takes log2 of the column count.
+    int tile_columns = 0;
+    while ((1 << (tile_columns + 1)) <= static_cast<int>(config_.g_threads) &&
+           (size.width() >> (tile_columns + 1)) >= 256)
+    {
+        ++tile_columns;
+    }
+
+    ret = vpx_codec_control(codec_.get(), VP9E_SET_TILE_COLUMNS, tile_columns);
+    DCHECK_EQ(VPX_CODEC_OK, ret);
+
+    // Row-based multi-threading lets the threads cooperate inside a tile as well, which keeps
+    // them busy on frames too narrow for many tile columns.
+    ret = vpx_codec_control(codec_.get(), VP9E_SET_ROW_MT, 1);
+    DCHECK_EQ(VPX_CODEC_OK, ret);
+
     // Use the lowest level of noise sensitivity so as to spend less time on motion estimation and
     // inter-prediction mode.
     ret = vpx_codec_control(codec_.get(), VP9E_SET_NOISE_SENSITIVITY, 0);
@@ -393,7 +509,13 @@ int64_t VideoEncoderVPX::prepareImageAndActiveMap(
     }
 
     if (!top_off_is_active_)
-        clearActiveMap();
+    {
+        // Only the macroblocks marked for the previous frame can be set, so resetting them is
+        // enough; rewriting the whole map every frame would touch it all even when a few pixels
+        // changed.
+        for (Region::Iterator it(active_map_region_); !it.isAtEnd(); it.advance())
+            removeRectFromActiveMap(it.rect());
+    }
 
     const int y_stride = image_->stride[0];
     const int uv_stride = image_->stride[1];
@@ -412,6 +534,8 @@ int64_t VideoEncoderVPX::prepareImageAndActiveMap(
         const int width = rect.width();
         const int height = rect.height();
 
+        // libyuv picks the widest conversion kernel supported by the CPU (SSSE3/AVX2/NEON) at
+        // runtime, so this call is already vectorized; only the rect setup around it is scalar.
         libyuv::ARGBToI420(frame->frameDataAtPos(rect.topLeft()),
                            frame->stride(),
                            y_data + y_offset, y_stride,
@@ -427,6 +551,9 @@ int64_t VideoEncoderVPX::prepareImageAndActiveMap(
     if (top_off_is_active_)
         regionFromActiveMap(&updated_region);
 
+    // Remember which macroblocks are marked so the next frame can reset just them.
+    active_map_region_ = updated_region;
+
     for (Region::Iterator it(updated_region); !it.isAtEnd(); it.advance())
     {
         proto::Rect* dirty_rect = packet->add_dirty_rect();
@@ -489,6 +616,24 @@ void VideoEncoderVPX::addRectToActiveMap(const Rect& rect)
     }
 }
 
+void VideoEncoderVPX::removeRectFromActiveMap(const Rect& rect)
+{
+    int left = rect.left() / kMacroBlockSize;
+    int top = rect.top() / kMacroBlockSize;
+    int right = (rect.right() - 1) / kMacroBlockSize;
+    int bottom = (rect.bottom() - 1) / kMacroBlockSize;
+
+    uint8_t* map = active_map_.active_map + top * active_map_.cols;
+
+    for (int y = top; y <= bottom; ++y)
+    {
+        for (int x = left; x <= right; ++x)
+            map[x] = 0;
+
+        map += active_map_.cols;
+    }
+}
+
 void VideoEncoderVPX::clearActiveMap()
 {
     memset(active_map_buffer_.data(), 0, active_map_buffer_.size());
@@ -499,6 +644,9 @@ void VideoEncoderVPX::updateConfig(int64_t updated_area)
     bool changed = false;
 
     uint32_t target_bitrate = static_cast<uint32_t>(bitrate_filter_.targetBitrateKbps());
+    if (max_bitrate_kbps_ > 0 && target_bitrate > static_cast<uint32_t>(max_bitrate_kbps_))
+        target_bitrate = static_cast<uint32_t>(max_bitrate_kbps_);
+
     if (config_.rc_target_bitrate != target_bitrate)
     {
         config_.rc_target_bitrate = target_bitrate;
@@ -25,6 +25,7 @@
 #include "base/codec/scoped_vpx_codec.h"
 #include "base/codec/video_encoder.h"
 #include "base/desktop/region.h"
+#include "base/memory/aligned_memory.h"
 #include "base/memory/byte_array.h"
 
 #define VPX_CODEC_DISABLE_COMPAT 1
@@ -42,35 +43,64 @@ public:
     static std::unique_ptr<VideoEncoderVPX> createVP9();
 
     void encode(const Frame* frame, proto::VideoPacket* packet) override;
-    void setBandwidthEstimateKbps(int bandwidth_kbps);
+    void requestKeyFrame() override;
+    void invalidateReferences() override;
+    void setBandwidthEstimateKbps(int bandwidth_kbps) override;
+    void setMaxBitrateKbps(int max_bitrate_kbps) override;
+    void setSpeed(int speed) override;
 
 private:
     explicit VideoEncoderVPX(proto::VideoEncoding encoding);
 
+    void createImage(const Size& size);
     void createActiveMap(const Size& size);
     void createVp8Codec(const Size& size);
     void createVp9Codec(const Size& size);
+    int cpuUsed() const;
     int64_t prepareImageAndActiveMap(
         bool is_key_frame, const Frame* frame, proto::VideoPacket* packet);
     void regionFromActiveMap(Region* updated_region);
     void addRectToActiveMap(const Rect& rect);
+    void removeRectFromActiveMap(const Rect& rect);
     void clearActiveMap();
 
     void updateConfig(int64_t updated_area);
+    void updateCpuUsed(int64_t updated_area);
 
     vpx_codec_enc_cfg_t config_;
     ScopedVpxCodec codec_;
 
     bool top_off_is_active_ = false;
+
+    // Recovery requests pending for the next encoded frame. Set through requestKeyFrame() and
+    // invalidateReferences(), consumed by encode().
+    bool key_frame_requested_ = false;
+    bool invalidate_references_ = false;
+
     ByteArray active_map_buffer_;
     vpx_active_map_t active_map_;
 
-    // VPX image and buffer to hold the actual YUV planes.
+    // Region whose macroblocks are currently marked in |active_map_|. Keeping it around lets the
+    // next frame reset only those macroblocks instead of wiping the whole map.
+    Region active_map_region_;
+
+    // VPX image and buffer to hold the actual YUV planes. The buffer is aligned so that the
+    // RGB-to-I420 conversion writes with SIMD stores directly into the planes consumed by libvpx,
+    // and it is reused across stream restarts as long as the frame size does not change.
     std::unique_ptr<vpx_image_t> image_;
-    ByteArray image_buffer_;
+    std::unique_ptr<uint8_t, AlignedFreeDeleter> image_buffer_;
+    size_t image_buffer_size_ = 0;
 
     EncoderBitrateFilter bitrate_filter_;
 
+    // Live profile limits; see setMaxBitrateKbps() and setSpeed(). 0 means "no cap" and
+    // "codec default" respectively.
+    int max_bitrate_kbps_ = 0;
+    int speed_ = 0;
+
+    // "Cpu used" value currently applied to the codec; see updateCpuUsed().
+    int applied_cpu_used_ = 0;
+
     // Accumulator for updated region area in the previously encoded frames.
     RunningSamples updated_region_area_;
 
@@ -0,0 +1,110 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/codec/video_encoder_vpx.h"
+#include "base/desktop/frame_simple.h"
+
+#include <benchmark/benchmark.h>
+
+namespace base {
+
+namespace {
+
+const int kBytesPerPixel = 4;
+
+// Draws a gradient into |rect| with a per-iteration offset so every encoded frame differs from
+// the previous one inside the damaged area.
+void drawDamage(Frame* frame, const Rect& rect, int iteration)
+{
+    for (int y = rect.top(); y < rect.bottom(); ++y)
+    {
+        uint8_t* row = frame->frameDataAtPos(rect.left(), y);
+        for (int x = 0; x < rect.width() * kBytesPerPixel; ++x)
+            row[x] = static_cast<uint8_t>(x + y + iteration);
+    }
+}
+
+// Encodes a stream of frames with the given screen size and damaged rectangle size. The first
+// (key) frame is encoded outside the measured loop, so the numbers reflect the steady state.
+void runEncode(benchmark::State& state, std::unique_ptr<VideoEncoderVPX> encoder)
+{
+    const Size screen_size(static_cast<int32_t>(state.range(0)),
+                           static_cast<int32_t>(state.range(1)));
+    const Size damage_size(static_cast<int32_t>(state.range(2)),
+                           static_cast<int32_t>(state.range(3)));
+
+    std::unique_ptr<FrameSimple> frame = FrameSimple::create(screen_size);
+    if (!frame || !encoder)
+    {
+        state.SkipWithError("Unable to create frame or encoder");
+        return;
+    }
+
+    Rect damage_rect = Rect::makeXYWH((screen_size.width() - damage_size.width()) / 2,
+                                      (screen_size.height() - damage_size.height()) / 2,
+                                      damage_size.width(),
+                                      damage_size.height());
+    damage_rect.intersectWith(Rect::makeSize(screen_size));
+
+    drawDamage(frame.get(), Rect::makeSize(screen_size), 0);
+    frame->updatedRegion()->setRect(Rect::makeSize(screen_size));
+
+    proto::VideoPacket packet;
+    encoder->encode(frame.get(), &packet);
+
+    int iteration = 1;
+
+    for (auto _ : state)
+    {
+        drawDamage(frame.get(), damage_rect, iteration++);
+        frame->updatedRegion()->setRect(damage_rect);
+
+        packet.Clear();
+        encoder->encode(frame.get(), &packet);
+        benchmark::DoNotOptimize(packet);
+    }
+}
+
+void BM_VideoEncoderVP8_Encode(benchmark::State& state)
+{
+    runEncode(state, VideoEncoderVPX::createVP8());
+}
+
+void BM_VideoEncoderVP9_Encode(benchmark::State& state)
+{
+    runEncode(state, VideoEncoderVPX::createVP9());
+}
+
+#define ENCODER_ARGS(benchmark_name)                   \
+    BENCHMARK(benchmark_name)                          \
+        ->ArgNames({"width", "height", "damage_w", "damage_h"}) \
+        ->Args({1920, 1080, 32, 32})                   \
+        ->Args({1920, 1080, 960, 540})                 \
+        ->Args({1920, 1080, 1920, 1080})               \
+        ->Args({3840, 2160, 960, 540})                 \
+        ->Args({3840, 2160, 3840, 2160})               \
+        ->Unit(benchmark::kMillisecond)
+
+ENCODER_ARGS(BM_VideoEncoderVP8_Encode);
+ENCODER_ARGS(BM_VideoEncoderVP9_Encode);
+
+#undef ENCODER_ARGS
+
+} // namespace
+
+} // namespace base
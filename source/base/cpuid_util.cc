@@ -72,6 +72,33 @@ void CpuidUtil::get(int leaf, int subleaf)
 
 #endif // CC_MSVC
 
+namespace {
+
+uint64_t xcr0()
+{
+#if defined(CC_MSVC)
+    return _xgetbv(0);
+#else
+    uint32_t eax;
+    uint32_t edx;
+
+    asm volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif // CC_MSVC
+}
+
+// Checks that the OS saves and restores the extended registers on context switch (OSXSAVE bit and
+// XCR0 state components |xcr0_mask|).
+bool hasOsXsave(uint64_t xcr0_mask)
+{
+    if (!BitSet<uint32_t>(CpuidUtil(1).ecx()).test(27))
+        return false;
+
+    return (xcr0() & xcr0_mask) == xcr0_mask;
+}
+
+} // namespace
+
 // static
 bool CpuidUtil::hasAesNi()
 {
@@ -83,6 +110,76 @@ bool CpuidUtil::hasAesNi()
     return BitSet<uint32_t>(CpuidUtil(1).ecx()).test(25);
 }
 
+// static
+bool CpuidUtil::hasAvx2()
+{
+    // Check if function 7 is supported.
+    if (CpuidUtil(0).eax() < 7)
+        return false;
+
+    // XMM (bit 1) and YMM (bit 2) states must be enabled by the OS.
+    if (!hasOsXsave(0x6))
+        return false;
+
+    // Bit 5 of register EBX set to 1 indicates the support of AVX2 instructions.
+    return BitSet<uint32_t>(CpuidUtil(7, 0).ebx()).test(5);
+}
+
+// static
+bool CpuidUtil::hasAvx512()
+{
+    // Check if function 7 is supported.
+    if (CpuidUtil(0).eax() < 7)
+        return false;
+
+    // In addition to XMM/YMM, opmask (bit 5) and ZMM (bits 6-7) states must be enabled by the OS.
+    if (!hasOsXsave(0xE6))
+        return false;
+
+    BitSet<uint32_t> ebx(CpuidUtil(7, 0).ebx());
+
+    // Bit 16 indicates AVX-512 Foundation, bit 30 indicates AVX-512 Byte and Word instructions.
+    return ebx.test(16) && ebx.test(30);
+}
+
+// static
+bool CpuidUtil::hasSse42()
+{
+    // Check if function 1 is supported.
+    if (CpuidUtil(0).eax() < 1)
+        return false;
+
+    // Bit 20 of register ECX set to 1 indicates the support of SSE4.2 instructions.
+    return BitSet<uint32_t>(CpuidUtil(1).ecx()).test(20);
+}
+
+// static
+bool CpuidUtil::hasPclmul()
+{
+    // Check if function 1 is supported.
+    if (CpuidUtil(0).eax() < 1)
+        return false;
+
+    // Bit 1 of register ECX set to 1 indicates the support of the PCLMULQDQ instruction.
+    return BitSet<uint32_t>(CpuidUtil(1).ecx()).test(1);
+}
+
+// static
+bool CpuidUtil::hasFma()
+{
+    // Check if function 1 is supported.
+    if (CpuidUtil(0).eax() < 1)
+        return false;
+
+    // FMA operates on YMM registers, so XMM (bit 1) and YMM (bit 2) states must be enabled by
+    // the OS.
+    if (!hasOsXsave(0x6))
+        return false;
+
+    // Bit 12 of register ECX set to 1 indicates the support of FMA instructions.
+    return BitSet<uint32_t>(CpuidUtil(1).ecx()).test(12);
+}
+
 } // namespace base
 
 #endif // defined(ARCH_CPU_X86_FAMILY)
@@ -50,6 +50,11 @@ public:
     uint32_t edx() const { return static_cast<uint32_t>(cpu_info_[kEDX]); }
 
     static bool hasAesNi();
+    static bool hasAvx2();
+    static bool hasAvx512();
+    static bool hasFma();
+    static bool hasSse42();
+    static bool hasPclmul();
 
 private:
     static constexpr int kEAX = 0;
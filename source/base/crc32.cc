@@ -18,6 +18,12 @@
 
 #include "base/crc32.h"
 
+#include "base/cpuid_util.h"
+
+#if defined(ARCH_CPU_X86_FAMILY)
+#include "base/crc32_pclmul.h"
+#endif
+
 namespace base {
 
 // Static table of checksums for all possible 8 bit bytes.
@@ -77,6 +83,85 @@ const uint32_t kCrcTable[256] =
     0x2d02ef8dL,
 };
 
+namespace {
+
+// Extends kCrcTable for the slice-by-16 algorithm: table[j][b] is the contribution of byte |b|
+// processed |15 - j| positions before the end of a 16-byte group. table[15] equals kCrcTable.
+// The extra tables are derived from kCrcTable at first use instead of being hardcoded.
+struct SliceTables
+{
+    SliceTables()
+    {
+        for (int b = 0; b < 256; ++b)
+        {
+            uint32_t checksum = kCrcTable[b];
+
+            table[15][b] = checksum;
+            for (int j = 14; j >= 0; --j)
+            {
+                checksum = kCrcTable[checksum & 0x000000FF] ^ (checksum >> 8);
+                table[j][b] = checksum;
+            }
+        }
+    }
+
+    uint32_t table[16][256];
+};
+
+// Slice-by-16 variant of the byte-at-a-time loop: 16 input bytes are folded into the checksum
+// per iteration with independent table lookups, removing the per-byte dependency chain.
+uint32_t crc32Slice16(uint32_t sum, const uint8_t* bytes, size_t size)
+{
+    static const SliceTables tables;
+    const uint32_t (&t)[16][256] = tables.table;
+
+    while (size >= 16)
+    {
+        sum ^= static_cast<uint32_t>(bytes[0]) | (static_cast<uint32_t>(bytes[1]) << 8) |
+               (static_cast<uint32_t>(bytes[2]) << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+
+        sum = t[0][sum & 0xFF] ^ t[1][(sum >> 8) & 0xFF] ^
+              t[2][(sum >> 16) & 0xFF] ^ t[3][sum >> 24] ^
+              t[4][bytes[4]] ^ t[5][bytes[5]] ^ t[6][bytes[6]] ^ t[7][bytes[7]] ^
+              t[8][bytes[8]] ^ t[9][bytes[9]] ^ t[10][bytes[10]] ^ t[11][bytes[11]] ^
+              t[12][bytes[12]] ^ t[13][bytes[13]] ^ t[14][bytes[14]] ^ t[15][bytes[15]];
+
+        bytes += 16;
+        size -= 16;
+    }
+
+    for (size_t i = 0; i < size; ++i)
+        sum = kCrcTable[(sum & 0x000000FF) ^ bytes[i]] ^ (sum >> 8);
+
+    return sum;
+}
+
+// Multiplies the GF(2) 32x32 matrix |mat| by the vector |vec|.
+uint32_t gf2MatrixTimes(const uint32_t* mat, uint32_t vec)
+{
+    uint32_t sum = 0;
+
+    while (vec)
+    {
+        if (vec & 1)
+            sum ^= *mat;
+
+        vec >>= 1;
+        ++mat;
+    }
+
+    return sum;
+}
+
+// Squares the GF(2) 32x32 matrix |mat| into |square|.
+void gf2MatrixSquare(uint32_t* square, const uint32_t* mat)
+{
+    for (int n = 0; n < 32; ++n)
+        square[n] = gf2MatrixTimes(mat, mat[n]);
+}
+
+} // namespace
+
 // We generate the CRC-32 using the low order bits to select whether to XOR in the reversed
 // polynomial 0xEDB88320. This is nice and simple, and allows us to keep the quotient in a uint32_t.
 // Since we're not concerned about the nature of corruptions (i.e., we don't care about bit
@@ -88,10 +173,63 @@ uint32_t crc32(uint32_t sum, const void* data, size_t size)
 {
     const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
 
-    for (size_t i = 0; i < size; ++i)
-        sum = kCrcTable[(sum & 0x000000FF) ^ bytes[i]] ^ (sum >> 8);
+#if defined(ARCH_CPU_X86_FAMILY)
+    static const bool has_pclmul = CpuidUtil::hasSse42() && CpuidUtil::hasPclmul();
 
-    return sum;
+    // The PCLMULQDQ kernel needs at least 64 bytes and works in blocks of 16; the tail goes
+    // through the table implementation below.
+    if (has_pclmul && size >= 64)
+    {
+        const size_t simd_size = size & ~static_cast<size_t>(15);
+
+        sum = crc32Pclmul(sum, bytes, simd_size);
+
+        bytes += simd_size;
+        size -= simd_size;
+    }
+#endif // defined(ARCH_CPU_X86_FAMILY)
+
+    return crc32Slice16(sum, bytes, size);
+}
+
+// Uses the zlib matrix approach: the checksum is linear over GF(2), so appending |size2| bytes
+// maps |sum1| through the matrix x^(8 * size2) mod P, built here by repeated squaring.
+uint32_t crc32Combine(uint32_t sum1, uint32_t sum2, size_t size2)
+{
+    if (size2 == 0)
+        return sum1;
+
+    uint32_t even[32]; // Even-power-of-two zero operators.
+    uint32_t odd[32];  // Odd-power-of-two zero operators.
+
+    // Operator for one zero bit: the reversed polynomial 0xEDB88320 and the shifted identity.
+    odd[0] = 0xEDB88320;
+    for (int n = 1; n < 32; ++n)
+        odd[n] = 1U << (n - 1);
+
+    // Operators for two and four zero bits.
+    gf2MatrixSquare(even, odd);
+    gf2MatrixSquare(odd, even);
+
+    // Apply x^(8 * size2) to |sum1|, squaring as the length bits are consumed.
+    do
+    {
+        gf2MatrixSquare(even, odd);
+        if (size2 & 1)
+            sum1 = gf2MatrixTimes(even, sum1);
+        size2 >>= 1;
+
+        if (!size2)
+            break;
+
+        gf2MatrixSquare(odd, even);
+        if (size2 & 1)
+            sum1 = gf2MatrixTimes(odd, sum1);
+        size2 >>= 1;
+    }
+    while (size2);
+
+    return sum1 ^ sum2;
 }
 
 } // namespace base
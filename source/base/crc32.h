@@ -31,6 +31,11 @@ extern const uint32_t kCrcTable[256];
 // operation began with previous data.
 uint32_t crc32(uint32_t sum, const void* data, size_t size);
 
+// Combines two checksums computed over adjacent buffers: given |sum1| = crc32(seed, A, sizeA)
+// and |sum2| = crc32(0, B, |size2|), returns crc32(seed, AB, sizeA + |size2|). This allows large
+// buffers to be checksummed in parallel across threads and the per-part results merged.
+uint32_t crc32Combine(uint32_t sum1, uint32_t sum2, size_t size2);
+
 } // namespace base
 
 #endif // BASE__CRC32_H
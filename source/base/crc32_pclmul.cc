@@ -0,0 +1,134 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/crc32_pclmul.h"
+
+#include "base/logging.h"
+#include "build/build_config.h"
+
+#if defined(CC_MSVC)
+#include <intrin.h>
+#else
+#include <smmintrin.h>
+#include <wmmintrin.h>
+#endif
+
+namespace base {
+
+// Folding approach described in the Intel white paper "Fast CRC Computation for Generic
+// Polynomials Using PCLMULQDQ Instruction". The constants are bit-reflected values of
+// x^T mod P for the CRC-32 polynomial P = 0x104C11DB7:
+//
+//   k1 = x^(4*128+32) mod P, k2 = x^(4*128-32) mod P  - fold by 4 blocks of 16 bytes;
+//   k3 = x^(128+32)   mod P, k4 = x^(128-32)   mod P  - fold by 1 block of 16 bytes;
+//   k5 = x^64 mod P                                   - fold 96 bits to 64 bits;
+//   mu = x^64 / P, followed by P itself               - Barrett reduction to 32 bits.
+//
+// In a 16-byte block loaded from memory the first bytes carry the highest powers of x, so the
+// low qword of a register folds with the larger distance (the high qword of the constant pair).
+uint32_t crc32Pclmul(uint32_t sum, const void* data, size_t size)
+{
+    DCHECK(size >= 64 && (size % 16) == 0);
+
+    const __m128i k1k2 = _mm_set_epi64x(0x0154442bd4, 0x01c6e41596);
+    const __m128i k3k4 = _mm_set_epi64x(0x01751997d0, 0x00ccaa009e);
+    const __m128i k5k0 = _mm_set_epi64x(0x0163cd6124, 0x0000000000);
+    const __m128i poly = _mm_set_epi64x(0x01db710641, 0x01f7011641);
+
+    const __m128i* buffer = reinterpret_cast<const __m128i*>(data);
+
+    // The running checksum is carried in four 128-bit accumulators.
+    __m128i x1 = _mm_loadu_si128(buffer + 0);
+    __m128i x2 = _mm_loadu_si128(buffer + 1);
+    __m128i x3 = _mm_loadu_si128(buffer + 2);
+    __m128i x4 = _mm_loadu_si128(buffer + 3);
+
+    // The incoming checksum is linear, so it is simply XORed into the first four bytes.
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(sum)));
+
+    buffer += 4;
+    size -= 64;
+
+    // Fold blocks of 64 bytes into the accumulators.
+    while (size >= 64)
+    {
+        __m128i x5 = _mm_clmulepi64_si128(x1, k1k2, 0x10);
+        __m128i x6 = _mm_clmulepi64_si128(x2, k1k2, 0x10);
+        __m128i x7 = _mm_clmulepi64_si128(x3, k1k2, 0x10);
+        __m128i x8 = _mm_clmulepi64_si128(x4, k1k2, 0x10);
+
+        x1 = _mm_clmulepi64_si128(x1, k1k2, 0x01);
+        x2 = _mm_clmulepi64_si128(x2, k1k2, 0x01);
+        x3 = _mm_clmulepi64_si128(x3, k1k2, 0x01);
+        x4 = _mm_clmulepi64_si128(x4, k1k2, 0x01);
+
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128(buffer + 0));
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128(buffer + 1));
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128(buffer + 2));
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128(buffer + 3));
+
+        buffer += 4;
+        size -= 64;
+    }
+
+    // Fold the four accumulators into one.
+    __m128i x5 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+    x1 = _mm_clmulepi64_si128(x1, k3k4, 0x01);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), x2);
+
+    x5 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+    x1 = _mm_clmulepi64_si128(x1, k3k4, 0x01);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), x3);
+
+    x5 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+    x1 = _mm_clmulepi64_si128(x1, k3k4, 0x01);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), x4);
+
+    // Fold the remaining blocks of 16 bytes.
+    while (size >= 16)
+    {
+        x5 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+        x1 = _mm_clmulepi64_si128(x1, k3k4, 0x01);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128(buffer));
+
+        buffer += 1;
+        size -= 16;
+    }
+
+    const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+
+    // Fold 128 bits to 64 bits.
+    x2 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, mask32);
+    x1 = _mm_clmulepi64_si128(x1, k5k0, 0x10);
+    x1 = _mm_xor_si128(x1, x2);
+
+    // Barrett reduction from 64 bits to the final 32-bit checksum.
+    x2 = _mm_and_si128(x1, mask32);
+    x2 = _mm_clmulepi64_si128(x2, poly, 0x00);
+    x2 = _mm_and_si128(x2, mask32);
+    x2 = _mm_clmulepi64_si128(x2, poly, 0x10);
+    x1 = _mm_xor_si128(x1, x2);
+
+    return static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+}
+
+} // namespace base
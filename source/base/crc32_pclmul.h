@@ -0,0 +1,35 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__CRC32_PCLMUL_H
+#define BASE__CRC32_PCLMUL_H
+
+#include <cstdint>
+#include <cstddef>
+
+namespace base {
+
+// Computes the same checksum as crc32() using PCLMULQDQ carry-less multiplication. Requires
+// SSE4.2 and PCLMULQDQ support (CpuidUtil::hasSse42() and CpuidUtil::hasPclmul()). |size| must
+// be at least 64 bytes and a multiple of 16; the caller handles the remaining tail with the
+// table implementation.
+uint32_t crc32Pclmul(uint32_t sum, const void* data, size_t size);
+
+} // namespace base
+
+#endif // BASE__CRC32_PCLMUL_H
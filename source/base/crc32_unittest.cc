@@ -18,10 +18,53 @@
 
 #include "base/crc32.h"
 
+#include "base/cpuid_util.h"
+
+#if defined(ARCH_CPU_X86_FAMILY)
+#include "base/crc32_pclmul.h"
+#endif
+
 #include <gtest/gtest.h>
 
+#include <random>
+#include <vector>
+
 namespace base {
 
+namespace {
+
+// Bit-at-a-time reference implementation equivalent to the table lookup in crc32().
+uint32_t referenceCrc32(uint32_t sum, const uint8_t* bytes, size_t size)
+{
+    for (size_t i = 0; i < size; ++i)
+    {
+        sum ^= bytes[i];
+        for (int j = 0; j < 8; ++j)
+        {
+            const uint32_t kReversedPolynomial = 0xEDB88320L;
+            if (sum & 1)
+                sum = kReversedPolynomial ^ (sum >> 1);
+            else
+                sum >>= 1;
+        }
+    }
+
+    return sum;
+}
+
+std::vector<uint8_t> randomBuffer(size_t size)
+{
+    std::mt19937 engine(static_cast<uint32_t>(size) + 1);
+    std::vector<uint8_t> buffer(size);
+
+    for (size_t i = 0; i < size; ++i)
+        buffer[i] = static_cast<uint8_t>(engine());
+
+    return buffer;
+}
+
+} // namespace
+
 // Table was generated similarly to sample code for CRC-32 given on:
 // http://www.w3.org/TR/PNG/#D-CRCAppendix.
 TEST(Crc32Test, TableTest)
@@ -47,4 +90,84 @@ TEST(Crc32Test, ZeroTest)
     EXPECT_EQ(0U, crc32(0, nullptr, 0));
 }
 
+// crc32() selects between the sliced table implementation and the PCLMULQDQ kernel depending on
+// the buffer size and CPU features, so check a spread of sizes around the switch points against
+// the reference for several seeds.
+TEST(Crc32Test, ReferenceTest)
+{
+    const size_t kSizes[] = { 1, 3, 15, 16, 17, 63, 64, 65, 100, 255, 256, 1000, 4096, 65537 };
+    const uint32_t kSeeds[] = { 0, 1, 0xDEADBEEF, 0xFFFFFFFF };
+
+    for (size_t size : kSizes)
+    {
+        std::vector<uint8_t> buffer = randomBuffer(size);
+
+        for (uint32_t seed : kSeeds)
+        {
+            EXPECT_EQ(referenceCrc32(seed, buffer.data(), size),
+                      crc32(seed, buffer.data(), size))
+                << "size=" << size << " seed=" << seed;
+        }
+    }
+}
+
+// Splitting a buffer and continuing with the intermediate checksum as the seed must produce the
+// same result as a single pass.
+TEST(Crc32Test, IncrementalTest)
+{
+    std::vector<uint8_t> buffer = randomBuffer(1000);
+    const uint32_t whole = crc32(0, buffer.data(), buffer.size());
+
+    for (size_t split : { size_t(1), size_t(15), size_t(64), size_t(500), size_t(999) })
+    {
+        uint32_t sum = crc32(0, buffer.data(), split);
+        sum = crc32(sum, buffer.data() + split, buffer.size() - split);
+        EXPECT_EQ(whole, sum) << "split=" << split;
+    }
+}
+
+// Checksums of adjacent parts combined with crc32Combine() must match a single pass over the
+// whole buffer.
+TEST(Crc32Test, CombineTest)
+{
+    std::vector<uint8_t> buffer = randomBuffer(100000);
+
+    for (uint32_t seed : { 0U, 0xDEADBEEFU })
+    {
+        const uint32_t whole = crc32(seed, buffer.data(), buffer.size());
+
+        for (size_t split : { size_t(0), size_t(1), size_t(100), size_t(65536), buffer.size() })
+        {
+            const uint32_t sum1 = crc32(seed, buffer.data(), split);
+            const uint32_t sum2 = crc32(0, buffer.data() + split, buffer.size() - split);
+
+            EXPECT_EQ(whole, crc32Combine(sum1, sum2, buffer.size() - split))
+                << "split=" << split << " seed=" << seed;
+        }
+    }
+}
+
+#if defined(ARCH_CPU_X86_FAMILY)
+
+// Runs the PCLMULQDQ kernel directly on its supported sizes (at least 64 bytes, multiple of 16).
+TEST(Crc32Test, PclmulTest)
+{
+    if (!CpuidUtil::hasSse42() || !CpuidUtil::hasPclmul())
+        return;
+
+    for (size_t size : { size_t(64), size_t(80), size_t(4096), size_t(65536) })
+    {
+        std::vector<uint8_t> buffer = randomBuffer(size);
+
+        for (uint32_t seed : { 0U, 0xDEADBEEFU })
+        {
+            EXPECT_EQ(referenceCrc32(seed, buffer.data(), size),
+                      crc32Pclmul(seed, buffer.data(), size))
+                << "size=" << size << " seed=" << seed;
+        }
+    }
+}
+
+#endif // defined(ARCH_CPU_X86_FAMILY)
+
 } // namespace base
@@ -69,4 +69,28 @@ void largeNumberIncrement(ByteArray* buffer)
     largeNumberIncrement(buffer->data(), buffer->size());
 }
 
+void largeNumberAdd(uint8_t* buffer, size_t buffer_size, uint64_t value)
+{
+    DCHECK(buffer);
+    DCHECK(buffer_size);
+
+    uint32_t n = buffer_size;
+    uint64_t c = value;
+
+    do
+    {
+        --n;
+        c += buffer[n];
+        buffer[n] = static_cast<uint8_t>(c);
+        c >>= 8;
+    }
+    while (n && c);
+}
+
+void largeNumberAdd(ByteArray* buffer, uint64_t value)
+{
+    DCHECK(buffer);
+    largeNumberAdd(buffer->data(), buffer->size(), value);
+}
+
 } // namespace base
@@ -26,6 +26,11 @@ namespace base {
 void largeNumberIncrement(uint8_t* buffer, size_t buffer_size);
 void largeNumberIncrement(ByteArray* buffer);
 
+// Adds |value| to the big-endian number in |buffer|. Equivalent to calling largeNumberIncrement
+// |value| times.
+void largeNumberAdd(uint8_t* buffer, size_t buffer_size, uint64_t value);
+void largeNumberAdd(ByteArray* buffer, uint64_t value);
+
 } // namespace base
 
 #endif // BASE__CRYPTO__LARGE_NUMBER_INCREMENT_H
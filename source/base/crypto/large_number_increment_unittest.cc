@@ -45,4 +45,25 @@ TEST(LargeNumberIncrementTest, Test)
     EXPECT_EQ(number2, result2);
 }
 
+TEST(LargeNumberIncrementTest, Add)
+{
+    ByteArray number1 = fromHex("0000000000000000");
+    ByteArray result1 = fromHex("0000000000989680");
+
+    largeNumberAdd(&number1, 10000000);
+    EXPECT_EQ(number1, result1);
+
+    ByteArray number2 = fromHex("FFFFFFFFFFFFFFFA");
+    ByteArray result2 = fromHex("0000000000000004");
+
+    largeNumberAdd(&number2, 10);
+    EXPECT_EQ(number2, result2);
+
+    ByteArray number3 = fromHex("00000000000000FF");
+    ByteArray result3 = fromHex("00000000000000FF");
+
+    largeNumberAdd(&number3, 0);
+    EXPECT_EQ(number3, result3);
+}
+
 } // namespace base
@@ -20,6 +20,7 @@
 #define BASE__CRYPTO__MESSAGE_DECRYPTOR_H
 
 #include <cstddef>
+#include <cstdint>
 
 namespace base {
 
@@ -30,6 +31,9 @@ public:
 
     virtual size_t decryptedDataSize(size_t in_size) = 0;
     virtual bool decrypt(const void* in, size_t in_size, void* out) = 0;
+
+    // Positions the cipher at message |message_id|. See MessageEncryptor::setMessageId.
+    virtual void setMessageId(uint64_t message_id) = 0;
 };
 
 } // namespace base
@@ -37,4 +37,9 @@ bool MessageDecryptorFake::decrypt(const void* in, size_t in_size, void* out)
     return true;
 }
 
+void MessageDecryptorFake::setMessageId(uint64_t /* message_id */)
+{
+    // Nothing
+}
+
 } // namespace base
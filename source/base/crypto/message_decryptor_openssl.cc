@@ -35,7 +35,8 @@ const int kTagSize = 16; // 128 bits, 16 bytes.
 
 MessageDecryptorOpenssl::MessageDecryptorOpenssl(EVP_CIPHER_CTX_ptr ctx, const ByteArray& iv)
     : ctx_(std::move(ctx)),
-      iv_(iv)
+      iv_(iv),
+      base_iv_(iv)
 {
     DCHECK_EQ(EVP_CIPHER_CTX_key_length(ctx_.get()), kKeySize);
     DCHECK_EQ(EVP_CIPHER_CTX_iv_length(ctx_.get()), kIVSize);
@@ -119,4 +120,10 @@ bool MessageDecryptorOpenssl::decrypt(const void* in, size_t in_size, void* out)
     return true;
 }
 
+void MessageDecryptorOpenssl::setMessageId(uint64_t message_id)
+{
+    iv_ = base_iv_;
+    largeNumberAdd(&iv_, message_id);
+}
+
 } // namespace base
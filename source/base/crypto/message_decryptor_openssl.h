@@ -40,6 +40,7 @@ public:
     // MessageDecryptor implementation.
     size_t decryptedDataSize(size_t in_size) override;
     bool decrypt(const void* in, size_t in_size, void* out) override;
+    void setMessageId(uint64_t message_id) override;
 
 private:
     MessageDecryptorOpenssl(EVP_CIPHER_CTX_ptr ctx, const ByteArray& iv);
@@ -47,6 +48,9 @@ private:
     EVP_CIPHER_CTX_ptr ctx_;
     ByteArray iv_;
 
+    // IV the cipher was created with. setMessageId() derives the nonce for a message from it.
+    const ByteArray base_iv_;
+
     DISALLOW_COPY_AND_ASSIGN(MessageDecryptorOpenssl);
 };
 
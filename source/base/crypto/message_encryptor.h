@@ -20,6 +20,7 @@
 #define BASE__CRYPTO__MESSAGE_ENCRYPTOR_H
 
 #include <cstddef>
+#include <cstdint>
 
 namespace base {
 
@@ -30,6 +31,12 @@ public:
 
     virtual size_t encryptedDataSize(size_t in_size) = 0;
     virtual bool encrypt(const void* in, size_t in_size, void* out) = 0;
+
+    // Positions the cipher at message |message_id|. Each message id maps to a unique nonce, so
+    // a datagram transport, where messages can be lost or reordered, can make every message
+    // decryptable on its own by tagging it with the id. Stream transports number messages
+    // implicitly and never need to call this.
+    virtual void setMessageId(uint64_t message_id) = 0;
 };
 
 } // namespace base
@@ -0,0 +1,70 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/crypto/message_encryptor_openssl.h"
+#include "base/crypto/random.h"
+
+#include <benchmark/benchmark.h>
+
+namespace base {
+
+namespace {
+
+// Encrypts messages of the given size with a stream-session encryptor. The sizes roughly match
+// an input event, an average video packet and a key frame.
+void runEncrypt(benchmark::State& state, std::unique_ptr<MessageEncryptor> encryptor)
+{
+    if (!encryptor)
+    {
+        state.SkipWithError("Unable to create encryptor");
+        return;
+    }
+
+    const size_t message_size = static_cast<size_t>(state.range(0));
+
+    ByteArray message = Random::byteArray(message_size);
+    ByteArray output;
+    output.resize(encryptor->encryptedDataSize(message_size));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(
+            encryptor->encrypt(message.data(), message.size(), output.data()));
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * message_size);
+}
+
+void BM_MessageEncryptor_Aes256Gcm(benchmark::State& state)
+{
+    runEncrypt(state, MessageEncryptorOpenssl::createForAes256Gcm(
+        Random::byteArray(32), Random::byteArray(12)));
+}
+
+void BM_MessageEncryptor_ChaCha20Poly1305(benchmark::State& state)
+{
+    runEncrypt(state, MessageEncryptorOpenssl::createForChaCha20Poly1305(
+        Random::byteArray(32), Random::byteArray(12)));
+}
+
+BENCHMARK(BM_MessageEncryptor_Aes256Gcm)->Arg(64)->Arg(16384)->Arg(262144);
+BENCHMARK(BM_MessageEncryptor_ChaCha20Poly1305)->Arg(64)->Arg(16384)->Arg(262144);
+
+} // namespace
+
+} // namespace base
@@ -37,4 +37,9 @@ bool MessageEncryptorFake::encrypt(const void* in, size_t in_size, void* out)
     return true;
 }
 
+void MessageEncryptorFake::setMessageId(uint64_t /* message_id */)
+{
+    // Nothing
+}
+
 } // namespace base
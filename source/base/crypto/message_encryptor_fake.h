@@ -33,6 +33,7 @@ public:
     // MessageEncryptor implementation.
     size_t encryptedDataSize(size_t in_size) override;
     bool encrypt(const void* in, size_t in_size, void* out) override;
+    void setMessageId(uint64_t message_id) override;
 
 private:
     DISALLOW_COPY_AND_ASSIGN(MessageEncryptorFake);
@@ -20,6 +20,22 @@
 
 namespace base {
 
+namespace {
+
+// Upper bound for the stretched update interval (5 fps).
+const std::chrono::milliseconds kMaxUpdateInterval{ 200 };
+
+// Number of queued messages at which the network is considered congested.
+const size_t kPendingMessagesThreshold = 2;
+
+// Minimum spacing between an input-driven capture and the capture before it.
+const std::chrono::milliseconds kMinInputCaptureInterval{ 20 };
+
+// Update interval while idle (1 fps thumbnails).
+const std::chrono::milliseconds kIdleUpdateInterval{ 1000 };
+
+} // namespace
+
 CaptureScheduler::CaptureScheduler(const std::chrono::milliseconds& update_interval)
     : update_interval_(update_interval)
 {
@@ -57,4 +73,62 @@ std::chrono::milliseconds CaptureScheduler::nextCaptureDelay() const
     return update_interval_ - diff_time;
 }
 
+void CaptureScheduler::beginEncode()
+{
+    encode_begin_time_ = std::chrono::high_resolution_clock::now();
+}
+
+void CaptureScheduler::endEncode()
+{
+    std::chrono::milliseconds encode_time =
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::high_resolution_clock::now() - encode_begin_time_);
+
+    // Exponential moving average so a single slow frame does not cause a frame-rate drop.
+    avg_encode_time_ = (avg_encode_time_ * 3 + encode_time) / 4;
+}
+
+void CaptureScheduler::setPendingMessages(size_t pending_messages)
+{
+    pending_messages_ = pending_messages;
+}
+
+void CaptureScheduler::setIdle(bool idle)
+{
+    idle_ = idle;
+}
+
+std::chrono::milliseconds CaptureScheduler::recommendedUpdateInterval() const
+{
+    if (idle_)
+        return kIdleUpdateInterval;
+
+    std::chrono::milliseconds interval = update_interval_;
+
+    // Leave at least half of the frame interval for capture and differ work.
+    if (avg_encode_time_ * 2 > interval)
+        interval = avg_encode_time_ * 2;
+
+    // A growing send queue means the network cannot keep up; slow down proportionally to let
+    // it drain instead of queuing more frames.
+    if (pending_messages_ > kPendingMessagesThreshold)
+        interval *= static_cast<int>(pending_messages_ - kPendingMessagesThreshold + 1);
+
+    if (interval > kMaxUpdateInterval)
+        interval = kMaxUpdateInterval;
+
+    return interval;
+}
+
+bool CaptureScheduler::shouldCaptureAfterInput() const
+{
+    std::chrono::milliseconds since_capture =
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::high_resolution_clock::now() - begin_time_);
+
+    // An early capture is useful only when the regular schedule would make the user wait
+    // noticeably longer; while captures are frequent anyway there is nothing to win.
+    return since_capture >= kMinInputCaptureInterval;
+}
+
 } // namespace base
@@ -38,11 +38,35 @@ public:
     void endCapture();
     std::chrono::milliseconds nextCaptureDelay() const;
 
+    // Adaptive mode. The owner reports how long the downstream consumer (encoder plus network
+    // queue) spent on the last frame and how many messages are still queued for sending.
+    // recommendedUpdateInterval() stretches the update interval when the consumer cannot keep up
+    // and returns to the configured interval as soon as it can.
+    void beginEncode();
+    void endEncode();
+    void setPendingMessages(size_t pending_messages);
+    std::chrono::milliseconds recommendedUpdateInterval() const;
+
+    // Idle mode. While enabled recommendedUpdateInterval() returns a fixed thumbnail-rate
+    // interval regardless of the adaptive state; used when nobody is watching the stream.
+    void setIdle(bool idle);
+    bool isIdle() const { return idle_; }
+
+    // Wake-on-input. Returns true when enough time has passed since the last capture for an
+    // extra input-driven capture to be worthwhile; the spacing of such captures is bounded, so
+    // a stream of input events cannot push the frame rate arbitrarily high.
+    bool shouldCaptureAfterInput() const;
+
 private:
     std::chrono::milliseconds update_interval_;
     std::chrono::time_point<std::chrono::high_resolution_clock> begin_time_;
     std::chrono::time_point<std::chrono::high_resolution_clock> end_time_;
 
+    std::chrono::time_point<std::chrono::high_resolution_clock> encode_begin_time_;
+    std::chrono::milliseconds avg_encode_time_{ 0 };
+    size_t pending_messages_ = 0;
+    bool idle_ = false;
+
     DISALLOW_COPY_AND_ASSIGN(CaptureScheduler);
 };
 
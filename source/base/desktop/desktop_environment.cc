@@ -18,16 +18,26 @@
 
 #include "base/desktop/desktop_environment.h"
 
+#include "base/message_loop/message_loop.h"
+#include "base/task_runner.h"
+
 namespace base {
 
 DesktopEnvironment::DesktopEnvironment()
+    : alive_(std::make_shared<bool>(true))
 {
-    applyNewSettings();
+    // Applying the defaults involves slow synchronous system calls; deferring them takes the
+    // stall out of session setup, where the capture subsystem is created.
+    scheduleUpdate();
 }
 
 DesktopEnvironment::~DesktopEnvironment()
 {
-    revertAll();
+    *alive_ = false;
+
+    // Nothing to revert if no update ever changed the desktop.
+    if (!applied_wallpaper_ || !applied_font_smoothing_ || !applied_effects_)
+        revertAll();
 }
 
 void DesktopEnvironment::setWallpaper(bool enable)
@@ -36,9 +46,7 @@ void DesktopEnvironment::setWallpaper(bool enable)
         return;
 
     wallpaper_ = enable;
-
-    revertAll();
-    applyNewSettings();
+    scheduleUpdate();
 }
 
 void DesktopEnvironment::setFontSmoothing(bool enable)
@@ -47,9 +55,7 @@ void DesktopEnvironment::setFontSmoothing(bool enable)
         return;
 
     font_smoothing_ = enable;
-
-    revertAll();
-    applyNewSettings();
+    scheduleUpdate();
 }
 
 void DesktopEnvironment::setEffects(bool enable)
@@ -58,21 +64,61 @@ void DesktopEnvironment::setEffects(bool enable)
         return;
 
     effects_ = enable;
+    scheduleUpdate();
+}
 
-    revertAll();
-    applyNewSettings();
+void DesktopEnvironment::scheduleUpdate()
+{
+    if (update_scheduled_)
+        return;
+
+    MessageLoop* message_loop = MessageLoop::current();
+    if (!message_loop)
+    {
+        // Without a message loop on the thread there is nothing to defer to.
+        updateEnvironment();
+        return;
+    }
+
+    update_scheduled_ = true;
+
+    std::shared_ptr<bool> alive = alive_;
+
+    message_loop->taskRunner()->postTask([this, alive]()
+    {
+        if (*alive)
+            updateEnvironment();
+    });
 }
 
-void DesktopEnvironment::applyNewSettings()
+void DesktopEnvironment::updateEnvironment()
 {
-    if (!wallpaper_)
+    update_scheduled_ = false;
+
+    if (wallpaper_ == applied_wallpaper_ && font_smoothing_ == applied_font_smoothing_ &&
+        effects_ == applied_effects_)
+        return;
+
+    // The user settings are restored from the profile as a whole, so any setting going back to
+    // enabled needs a full revert; the settings that remain disabled are applied again below.
+    const bool reverted = (wallpaper_ && !applied_wallpaper_) ||
+                          (font_smoothing_ && !applied_font_smoothing_) ||
+                          (effects_ && !applied_effects_);
+    if (reverted)
+        revertAll();
+
+    if (!wallpaper_ && (reverted || applied_wallpaper_))
         disableWallpaper();
 
-    if (!font_smoothing_)
+    if (!font_smoothing_ && (reverted || applied_font_smoothing_))
         disableFontSmoothing();
 
-    if (!effects_)
+    if (!effects_ && (reverted || applied_effects_))
         disableEffects();
+
+    applied_wallpaper_ = wallpaper_;
+    applied_font_smoothing_ = font_smoothing_;
+    applied_effects_ = effects_;
 }
 
 } // namespace base
@@ -21,6 +21,8 @@
 
 #include "base/macros_magic.h"
 
+#include <memory>
+
 namespace base {
 
 class DesktopEnvironment
@@ -29,22 +31,40 @@ public:
     DesktopEnvironment();
     ~DesktopEnvironment();
 
+    // The setters record the desired state; the system calls that apply it are batched into a
+    // single deferred update, so a configuration message changing several settings costs one
+    // pass and a message changing nothing costs nothing.
     void setWallpaper(bool enable);
     void setFontSmoothing(bool enable);
     void setEffects(bool enable);
 
 private:
+    void scheduleUpdate();
+    void updateEnvironment();
+
     void disableWallpaper();
     void disableFontSmoothing();
     void disableEffects();
 
     void revertAll();
-    void applyNewSettings();
 
+    // Desired state, as requested through the setters.
     bool wallpaper_ = false;
     bool font_smoothing_ = false;
     bool effects_ = false;
 
+    // State the last update actually applied to the desktop. The environment is untouched
+    // until the first update runs, so everything starts out enabled.
+    bool applied_wallpaper_ = true;
+    bool applied_font_smoothing_ = true;
+    bool applied_effects_ = true;
+
+    bool update_scheduled_ = false;
+
+    // Outlives |this| in the deferred update task; cleared by the destructor so a task that
+    // runs after destruction does nothing.
+    std::shared_ptr<bool> alive_;
+
     bool drop_shadow_changed_ = false;
     bool animation_changed_ = false;
 
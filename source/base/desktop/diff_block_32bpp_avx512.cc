@@ -0,0 +1,80 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/desktop/diff_block_32bpp_avx512.h"
+
+#include "build/build_config.h"
+
+#if defined(CC_MSVC)
+#include <intrin.h>
+#else
+#include <immintrin.h>
+#endif
+
+namespace base {
+
+uint8_t diffFullBlock_32bpp_32x32_AVX512(
+    const uint8_t* image1, const uint8_t* image2, int bytes_per_row)
+{
+    for (int i = 0; i < 32; ++i)
+    {
+        const __m512i* i1 = reinterpret_cast<const __m512i*>(image1);
+        const __m512i* i2 = reinterpret_cast<const __m512i*>(image2);
+
+        // One row of a 32x32 32bpp block is 128 bytes (two cache lines).
+        __mmask8 mask = _mm512_cmpneq_epi64_mask(_mm512_loadu_si512(i1 + 0),
+                                                 _mm512_loadu_si512(i2 + 0));
+
+        mask |= _mm512_cmpneq_epi64_mask(_mm512_loadu_si512(i1 + 1),
+                                         _mm512_loadu_si512(i2 + 1));
+
+        // If the row has differences.
+        if (mask)
+            return 1U;
+
+        image1 += bytes_per_row;
+        image2 += bytes_per_row;
+    }
+
+    return 0U;
+}
+
+uint8_t diffFullBlock_32bpp_16x16_AVX512(
+    const uint8_t* image1, const uint8_t* image2, int bytes_per_row)
+{
+    for (int i = 0; i < 16; ++i)
+    {
+        const __m512i* i1 = reinterpret_cast<const __m512i*>(image1);
+        const __m512i* i2 = reinterpret_cast<const __m512i*>(image2);
+
+        // One row of a 16x16 32bpp block is 64 bytes (a whole cache line).
+        __mmask8 mask = _mm512_cmpneq_epi64_mask(_mm512_loadu_si512(i1),
+                                                 _mm512_loadu_si512(i2));
+
+        // If the row has differences.
+        if (mask)
+            return 1U;
+
+        image1 += bytes_per_row;
+        image2 += bytes_per_row;
+    }
+
+    return 0U;
+}
+
+} // namespace base
@@ -0,0 +1,147 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/cpuid_util.h"
+#include "base/memory/aligned_memory.h"
+#include "base/desktop/diff_block_32bpp_avx2.h"
+#include "base/desktop/diff_block_32bpp_avx512.h"
+#include "base/desktop/diff_block_32bpp_c.h"
+#include "base/desktop/diff_block_32bpp_sse2.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <memory>
+
+namespace base {
+
+namespace {
+
+using AlignedBuffer = std::unique_ptr<uint8_t, AlignedFreeDeleter>;
+using DiffFullBlockFunc = uint8_t(*)(const uint8_t*, const uint8_t*, int);
+
+const int kBytesPerPixel = 4;
+const int kAlignment = 64;
+
+void prepareBuffers(AlignedBuffer* block1, AlignedBuffer* block2, int block_size)
+{
+    int full_block_size = block_size * block_size * kBytesPerPixel;
+
+    block1->reset(reinterpret_cast<uint8_t*>(alignedAlloc(full_block_size, kAlignment)));
+    block2->reset(reinterpret_cast<uint8_t*>(alignedAlloc(full_block_size, kAlignment)));
+
+    for (int i = 0; i < full_block_size; ++i)
+        block1->get()[i] = static_cast<uint8_t>(i);
+
+    memcpy(block2->get(), block1->get(), full_block_size);
+}
+
+// Measures a full-block comparison of two identical blocks: the common case on a mostly idle
+// screen and the only one where the kernel cannot exit early.
+void runDiffFullBlock(benchmark::State& state, DiffFullBlockFunc func, int block_size)
+{
+    AlignedBuffer block1;
+    AlignedBuffer block2;
+    prepareBuffers(&block1, &block2, block_size);
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(
+            func(block1.get(), block2.get(), block_size * kBytesPerPixel));
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                            block_size * block_size * kBytesPerPixel * 2);
+}
+
+void BM_DiffFullBlock_32bpp_32x32_C(benchmark::State& state)
+{
+    runDiffFullBlock(state, diffFullBlock_32bpp_32x32_C, 32);
+}
+
+void BM_DiffFullBlock_32bpp_16x16_C(benchmark::State& state)
+{
+    runDiffFullBlock(state, diffFullBlock_32bpp_16x16_C, 16);
+}
+
+void BM_DiffFullBlock_32bpp_32x32_SSE2(benchmark::State& state)
+{
+    runDiffFullBlock(state, diffFullBlock_32bpp_32x32_SSE2, 32);
+}
+
+void BM_DiffFullBlock_32bpp_16x16_SSE2(benchmark::State& state)
+{
+    runDiffFullBlock(state, diffFullBlock_32bpp_16x16_SSE2, 16);
+}
+
+void BM_DiffFullBlock_32bpp_32x32_AVX2(benchmark::State& state)
+{
+    if (!CpuidUtil::hasAvx2())
+    {
+        state.SkipWithError("AVX2 is not supported");
+        return;
+    }
+
+    runDiffFullBlock(state, diffFullBlock_32bpp_32x32_AVX2, 32);
+}
+
+void BM_DiffFullBlock_32bpp_16x16_AVX2(benchmark::State& state)
+{
+    if (!CpuidUtil::hasAvx2())
+    {
+        state.SkipWithError("AVX2 is not supported");
+        return;
+    }
+
+    runDiffFullBlock(state, diffFullBlock_32bpp_16x16_AVX2, 16);
+}
+
+void BM_DiffFullBlock_32bpp_32x32_AVX512(benchmark::State& state)
+{
+    if (!CpuidUtil::hasAvx512())
+    {
+        state.SkipWithError("AVX-512 is not supported");
+        return;
+    }
+
+    runDiffFullBlock(state, diffFullBlock_32bpp_32x32_AVX512, 32);
+}
+
+void BM_DiffFullBlock_32bpp_16x16_AVX512(benchmark::State& state)
+{
+    if (!CpuidUtil::hasAvx512())
+    {
+        state.SkipWithError("AVX-512 is not supported");
+        return;
+    }
+
+    runDiffFullBlock(state, diffFullBlock_32bpp_16x16_AVX512, 16);
+}
+
+BENCHMARK(BM_DiffFullBlock_32bpp_32x32_C);
+BENCHMARK(BM_DiffFullBlock_32bpp_16x16_C);
+BENCHMARK(BM_DiffFullBlock_32bpp_32x32_SSE2);
+BENCHMARK(BM_DiffFullBlock_32bpp_16x16_SSE2);
+BENCHMARK(BM_DiffFullBlock_32bpp_32x32_AVX2);
+BENCHMARK(BM_DiffFullBlock_32bpp_16x16_AVX2);
+BENCHMARK(BM_DiffFullBlock_32bpp_32x32_AVX512);
+BENCHMARK(BM_DiffFullBlock_32bpp_16x16_AVX512);
+
+} // namespace
+
+} // namespace base
@@ -18,10 +18,14 @@
 
 #include "base/desktop/differ.h"
 
+#include "base/cpuid_util.h"
 #include "base/logging.h"
+#include "base/desktop/diff_block_32bpp_avx2.h"
+#include "base/desktop/diff_block_32bpp_avx512.h"
 #include "base/desktop/diff_block_32bpp_sse2.h"
 #include "base/desktop/diff_block_32bpp_c.h"
 
+#include <algorithm>
 #include <cstring>
 #include <libyuv/cpu_id.h>
 
@@ -33,6 +37,14 @@ const int kBlockSize = 16;
 const int kBytesPerPixel = 4;
 const int kBytesPerBlock = kBlockSize * kBytesPerPixel;
 
+// Limits for the parallel mode. Small frames are still diffed on the calling thread, big frames
+// are split into horizontal bands processed by a small worker pool.
+const int kMaxDiffThreads = 4;
+const int kMinBlockRowsPerBand = 16;
+
+// Row step of the sampled pass in the identical-frame pre-check.
+const int kSampleRowStep = 64;
+
 // Check for diffs in upper-left portion of the block. The size of the portion to check is
 // specified by the |width| and |height| values.
 // Note that if we force the capturer to always return images whose width and height are multiples
@@ -65,7 +77,9 @@ Differ::Differ(const Size& size)
       diff_width_(((size.width() + kBlockSize - 1) / kBlockSize) + 1),
       diff_height_(((size.height() + kBlockSize - 1) / kBlockSize) + 1),
       full_blocks_x_(size.width() / kBlockSize),
-      full_blocks_y_(size.height() / kBlockSize)
+      full_blocks_y_(size.height() / kBlockSize),
+      total_blocks_(((size.width() + kBlockSize - 1) / kBlockSize) *
+                    ((size.height() + kBlockSize - 1) / kBlockSize))
 {
     const int diff_info_size = diff_width_ * diff_height_;
 
@@ -81,6 +95,50 @@ Differ::Differ(const Size& size)
 
     diff_full_block_func_ = diffFunction();
     CHECK(diff_full_block_func_);
+
+    // Total number of block rows, including the partial one at the bottom edge.
+    const int total_block_rows = full_blocks_y_ + ((partial_row_height_ != 0) ? 1 : 0);
+
+    int band_count = std::min(static_cast<int>(std::thread::hardware_concurrency()),
+                              kMaxDiffThreads);
+    band_count = std::min(band_count, total_block_rows / kMinBlockRowsPerBand);
+    band_count = std::max(band_count, 1);
+
+    bands_.resize(static_cast<size_t>(band_count));
+
+    const int rows_per_band = total_block_rows / band_count;
+    int extra_rows = total_block_rows % band_count;
+    int first_block_row = 0;
+
+    for (Band& band : bands_)
+    {
+        band.first_block_row = first_block_row;
+
+        first_block_row += rows_per_band + ((extra_rows > 0) ? 1 : 0);
+        extra_rows = std::max(extra_rows - 1, 0);
+
+        band.last_block_row = first_block_row;
+    }
+
+    // Band 0 is processed by the calling thread.
+    for (size_t i = 1; i < bands_.size(); ++i)
+        threads_.emplace_back(&Differ::bandThreadMain, this, i);
+
+    if (band_count > 1)
+        LOG(LS_INFO) << "Parallel differ loaded (" << band_count << " bands)";
+}
+
+Differ::~Differ()
+{
+    {
+        std::scoped_lock lock(band_lock_);
+        terminate_ = true;
+    }
+
+    work_event_.notify_all();
+
+    for (std::thread& thread : threads_)
+        thread.join();
 }
 
 // static
@@ -88,6 +146,27 @@ Differ::DiffFullBlockFunc Differ::diffFunction()
 {
     DiffFullBlockFunc func = nullptr;
 
+#if defined(ARCH_CPU_X86_FAMILY)
+    if (CpuidUtil::hasAvx512())
+    {
+        LOG(LS_INFO) << "AVX512 differ loaded";
+
+        if constexpr (kBlockSize == 16)
+            func = diffFullBlock_32bpp_16x16_AVX512;
+        else if constexpr (kBlockSize == 32)
+            func = diffFullBlock_32bpp_32x32_AVX512;
+    }
+    else if (CpuidUtil::hasAvx2())
+    {
+        LOG(LS_INFO) << "AVX2 differ loaded";
+
+        if constexpr (kBlockSize == 16)
+            func = diffFullBlock_32bpp_16x16_AVX2;
+        else if constexpr (kBlockSize == 32)
+            func = diffFullBlock_32bpp_32x32_AVX2;
+    }
+    else
+#endif // defined(ARCH_CPU_X86_FAMILY)
     if (libyuv::TestCpuFlag(libyuv::kCpuHasSSE2))
     {
         LOG(LS_INFO) << "SSE2 differ loaded";
@@ -110,18 +189,42 @@ Differ::DiffFullBlockFunc Differ::diffFunction()
     return func;
 }
 
-// Identify all of the blocks that contain changed pixels.
-void Differ::markDirtyBlocks(const uint8_t* prev_image, const uint8_t* curr_image)
+bool Differ::isUnchangedFrame(const uint8_t* prev_image, const uint8_t* curr_image) const
 {
-    const uint8_t* prev_block_row_start = prev_image;
-    const uint8_t* curr_block_row_start = curr_image;
+    const int height = screen_rect_.height();
+    const size_t row_bytes = static_cast<size_t>(bytes_per_row_);
+
+    // Sampled rows first: on a frame with changes this usually fails within a few comparisons
+    // and the differ proceeds as before.
+    for (int y = kSampleRowStep / 2; y < height; y += kSampleRowStep)
+    {
+        const size_t offset = static_cast<size_t>(y) * row_bytes;
+
+        if (memcmp(prev_image + offset, curr_image + offset, row_bytes) != 0)
+            return false;
+    }
+
+    // The samples match; confirm with a full comparison. This touches every byte, like the
+    // differ would, but without the per-block bookkeeping and the merge pass.
+    return memcmp(prev_image, curr_image, static_cast<size_t>(height) * row_bytes) == 0;
+}
+
+// Identify all of the blocks that contain changed pixels in the block row range
+// [first_block_row, last_block_row).
+void Differ::markDirtyBlocks(const uint8_t* prev_image, const uint8_t* curr_image,
+                             int first_block_row, int last_block_row)
+{
+    const uint8_t* prev_block_row_start = prev_image + first_block_row * block_stride_y_;
+    const uint8_t* curr_block_row_start = curr_image + first_block_row * block_stride_y_;
 
     // Offset from the start of one diff_info row to the next.
     const int diff_stride = diff_width_;
 
-    uint8_t* is_diff_row_start = diff_info_.get();
+    uint8_t* is_diff_row_start = diff_info_.get() + first_block_row * diff_stride;
+
+    const int last_full_block_row = std::min(last_block_row, full_blocks_y_);
 
-    for (int y = 0; y < full_blocks_y_; ++y)
+    for (int y = first_block_row; y < last_full_block_row; ++y)
     {
         const uint8_t* prev_block = prev_block_row_start;
         const uint8_t* curr_block = curr_block_row_start;
@@ -160,8 +263,9 @@ void Differ::markDirtyBlocks(const uint8_t* prev_image, const uint8_t* curr_imag
 
     // If the screen height is not a multiple of the block size, then this
     // handles the last partial row. This situation is far more common than
-    // the 'partial column' case.
-    if (partial_row_height_ != 0)
+    // the 'partial column' case. The partial row belongs to the band that
+    // covers block row |full_blocks_y_|.
+    if (partial_row_height_ != 0 && last_block_row > full_blocks_y_)
     {
         const uint8_t* prev_block = prev_block_row_start;
         const uint8_t* curr_block = curr_block_row_start;
@@ -198,12 +302,13 @@ void Differ::markDirtyBlocks(const uint8_t* prev_image, const uint8_t* curr_imag
 // blocks into a region.
 // The goal is to minimize the region that covers the dirty blocks.
 //
-void Differ::mergeBlocks(Region* dirty_region)
+void Differ::mergeBlocks(Region* dirty_region, int first_block_row, int last_block_row,
+                         int* changed_blocks)
 {
-    uint8_t* is_diff_row_start = diff_info_.get();
     const int diff_stride = diff_width_;
+    uint8_t* is_diff_row_start = diff_info_.get() + first_block_row * diff_stride;
 
-    for (int y = 0; y < diff_height_; ++y)
+    for (int y = first_block_row; y < last_block_row; ++y)
     {
         uint8_t* is_different = is_diff_row_start;
 
@@ -233,13 +338,19 @@ void Differ::mergeBlocks(Region* dirty_region)
 
                 // Group with blocks below.
                 // The entire width of blocks that we matched above much match
-                // for each row that we add.
+                // for each row that we add. Rows outside of the band are never
+                // merged so that concurrent bands do not touch each other's
+                // part of diff_info.
                 uint8_t* bottom = is_different;
+                int bottom_y = y;
                 bool found_new_row;
 
                 do
                 {
-                    found_new_row = true;
+                    found_new_row = (++bottom_y < last_block_row);
+                    if (!found_new_row)
+                        break;
+
                     bottom += diff_stride;
                     right = bottom;
 
@@ -264,6 +375,10 @@ void Differ::mergeBlocks(Region* dirty_region)
                     }
                 } while (found_new_row);
 
+                // Merged groups cover only marked blocks, so their areas sum up to the exact
+                // changed-block count.
+                *changed_blocks += width * height;
+
                 Rect dirty_rect = Rect::makeXYWH(x * kBlockSize, y * kBlockSize,
                                                  width * kBlockSize, height * kBlockSize);
 
@@ -282,20 +397,113 @@ void Differ::mergeBlocks(Region* dirty_region)
     }
 }
 
-void Differ::calcDirtyRegion(const uint8_t* prev_image,
-                             const uint8_t* curr_image,
-                             Region* dirty_region)
+void Differ::diffBand(size_t band_index)
 {
-    dirty_region->clear();
+    Band& band = bands_[band_index];
+
+    band.dirty_region.clear();
+    band.changed_blocks = 0;
 
     // Identify all the blocks that contain changed pixels.
-    markDirtyBlocks(prev_image, curr_image);
+    markDirtyBlocks(band_prev_image_, band_curr_image_,
+                    band.first_block_row, band.last_block_row);
 
     //
     // Now that we've identified the blocks that have changed, merge adjacent
     // blocks to minimize the number of rects that we return.
     //
-    mergeBlocks(dirty_region);
+    mergeBlocks(&band.dirty_region, band.first_block_row, band.last_block_row,
+                &band.changed_blocks);
+}
+
+void Differ::bandThreadMain(size_t band_index)
+{
+    uint32_t last_generation = 0;
+
+    for (;;)
+    {
+        {
+            std::unique_lock lock(band_lock_);
+
+            work_event_.wait(lock, [&]()
+            {
+                return terminate_ || work_generation_ != last_generation;
+            });
+
+            if (terminate_)
+                return;
+
+            last_generation = work_generation_;
+        }
+
+        diffBand(band_index);
+
+        {
+            std::scoped_lock lock(band_lock_);
+
+            if (--pending_bands_ == 0)
+                done_event_.notify_one();
+        }
+    }
+}
+
+void Differ::calcDirtyRegion(const uint8_t* prev_image,
+                             const uint8_t* curr_image,
+                             Region* dirty_region)
+{
+    dirty_region->clear();
+
+    // Full-frame capture backends hand over identical frames most of the time on an idle host.
+    // A straight comparison concludes "no change" without diffing and merging every block.
+    if (isUnchangedFrame(prev_image, curr_image))
+    {
+        stats_.changed_blocks = 0;
+        stats_.total_blocks = total_blocks_;
+        stats_.bounding_rect = Rect();
+        return;
+    }
+
+    band_prev_image_ = prev_image;
+    band_curr_image_ = curr_image;
+
+    if (!threads_.empty())
+    {
+        // Wake up the workers for bands 1..N.
+        {
+            std::scoped_lock lock(band_lock_);
+            pending_bands_ = static_cast<int>(threads_.size());
+            ++work_generation_;
+        }
+
+        work_event_.notify_all();
+    }
+
+    // The calling thread always processes the first band.
+    diffBand(0);
+
+    if (!threads_.empty())
+    {
+        std::unique_lock lock(band_lock_);
+        done_event_.wait(lock, [&]() { return pending_bands_ == 0; });
+    }
+
+    stats_.changed_blocks = 0;
+    stats_.total_blocks = total_blocks_;
+    stats_.bounding_rect = Rect();
+
+    for (Band& band : bands_)
+    {
+        dirty_region->addRegion(band.dirty_region);
+        stats_.changed_blocks += band.changed_blocks;
+    }
+
+    for (Region::Iterator it(*dirty_region); !it.isAtEnd(); it.advance())
+    {
+        if (stats_.bounding_rect.isEmpty())
+            stats_.bounding_rect = it.rect();
+        else
+            stats_.bounding_rect.unionWith(it.rect());
+    }
 }
 
 } // namespace base
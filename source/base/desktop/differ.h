@@ -22,7 +22,11 @@
 #include "base/macros_magic.h"
 #include "base/desktop/region.h"
 
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace base {
 
@@ -31,19 +35,49 @@ class Differ
 {
 public:
     explicit Differ(const Size& size);
-    ~Differ() = default;
+    ~Differ();
 
     void calcDirtyRegion(const uint8_t* prev_image,
                          const uint8_t* curr_image,
                          Region* changed_region);
 
+    // Damage statistics of the last calcDirtyRegion() call. The block counts fall out of the
+    // merge pass for free, so consumers that steer encoding by the amount of damage do not have
+    // to re-measure the region.
+    struct Stats
+    {
+        // Number of changed 16x16 blocks.
+        int changed_blocks = 0;
+
+        // Total number of blocks in the diffed area.
+        int total_blocks = 0;
+
+        // Bounding rectangle of the damage; empty when nothing changed. The change density of
+        // the frame is the changed area relative to the area of this rectangle.
+        Rect bounding_rect;
+    };
+
+    const Stats& lastStats() const { return stats_; }
+
 private:
     typedef uint8_t(*DiffFullBlockFunc)(const uint8_t*, const uint8_t*, int);
 
     static DiffFullBlockFunc diffFunction();
 
-    void markDirtyBlocks(const uint8_t* prev_image, const uint8_t* curr_image);
-    void mergeBlocks(Region* dirty_region);
+    // Returns true if the two images are byte-identical. Compares a sample of rows first, so a
+    // frame with changes is rejected after a few rows and only an unchanged frame pays for the
+    // full comparison.
+    bool isUnchangedFrame(const uint8_t* prev_image, const uint8_t* curr_image) const;
+
+    // Diffs and merges block rows in the range [first_block_row, last_block_row). When bands are
+    // used, each band works on its own row range and no row is shared between bands.
+    void markDirtyBlocks(const uint8_t* prev_image, const uint8_t* curr_image,
+                         int first_block_row, int last_block_row);
+    void mergeBlocks(Region* dirty_region, int first_block_row, int last_block_row,
+                     int* changed_blocks);
+
+    void diffBand(size_t band_index);
+    void bandThreadMain(size_t band_index);
 
     const Rect screen_rect_;
     const int bytes_per_row_;
@@ -59,6 +93,33 @@ private:
     std::unique_ptr<uint8_t[]> diff_info_;
     DiffFullBlockFunc diff_full_block_func_;
 
+    // A band is a horizontal range of block rows diffed and merged independently. Band 0 is
+    // processed by the calling thread, the others by the worker threads below. With a single
+    // band the differ works exactly as before.
+    struct Band
+    {
+        int first_block_row = 0;
+        int last_block_row = 0;
+        Region dirty_region;
+        int changed_blocks = 0;
+    };
+
+    std::vector<Band> bands_;
+    std::vector<std::thread> threads_;
+
+    std::mutex band_lock_;
+    std::condition_variable work_event_;
+    std::condition_variable done_event_;
+    uint32_t work_generation_ = 0;
+    int pending_bands_ = 0;
+    bool terminate_ = false;
+
+    const uint8_t* band_prev_image_ = nullptr;
+    const uint8_t* band_curr_image_ = nullptr;
+
+    const int total_blocks_;
+    Stats stats_;
+
     DISALLOW_COPY_AND_ASSIGN(Differ);
 };
 
@@ -0,0 +1,96 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/desktop/differ.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <memory>
+
+namespace base {
+
+namespace {
+
+const int kBytesPerPixel = 4;
+
+// Full-screen diff with a damaged rectangle of the given size in the middle of the screen. The
+// idle screen (0x0 damage), a cursor-sized change, a video window and a full-screen change are
+// the patterns a capturer produces in practice.
+void runCalcDirtyRegion(benchmark::State& state, const Size& screen_size, const Size& damage_size)
+{
+    const size_t buffer_size =
+        static_cast<size_t>(screen_size.width()) * screen_size.height() * kBytesPerPixel;
+
+    std::unique_ptr<uint8_t[]> prev_image = std::make_unique<uint8_t[]>(buffer_size);
+    std::unique_ptr<uint8_t[]> curr_image = std::make_unique<uint8_t[]>(buffer_size);
+
+    for (size_t i = 0; i < buffer_size; ++i)
+        prev_image[i] = static_cast<uint8_t>(i);
+
+    memcpy(curr_image.get(), prev_image.get(), buffer_size);
+
+    Rect damage_rect = Rect::makeXYWH((screen_size.width() - damage_size.width()) / 2,
+                                      (screen_size.height() - damage_size.height()) / 2,
+                                      damage_size.width(),
+                                      damage_size.height());
+    damage_rect.intersectWith(Rect::makeSize(screen_size));
+
+    for (int y = damage_rect.top(); y < damage_rect.bottom(); ++y)
+    {
+        uint8_t* row = curr_image.get() +
+            (static_cast<size_t>(y) * screen_size.width() + damage_rect.left()) * kBytesPerPixel;
+        memset(row, 0xAB, static_cast<size_t>(damage_rect.width()) * kBytesPerPixel);
+    }
+
+    Differ differ(screen_size);
+
+    for (auto _ : state)
+    {
+        Region changed_region;
+        differ.calcDirtyRegion(prev_image.get(), curr_image.get(), &changed_region);
+        benchmark::DoNotOptimize(changed_region);
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * buffer_size * 2);
+    state.counters["changed_blocks"] = static_cast<double>(differ.lastStats().changed_blocks);
+}
+
+void BM_Differ_CalcDirtyRegion(benchmark::State& state)
+{
+    runCalcDirtyRegion(state,
+                       Size(static_cast<int32_t>(state.range(0)),
+                            static_cast<int32_t>(state.range(1))),
+                       Size(static_cast<int32_t>(state.range(2)),
+                            static_cast<int32_t>(state.range(3))));
+}
+
+BENCHMARK(BM_Differ_CalcDirtyRegion)
+    ->ArgNames({"width", "height", "damage_w", "damage_h"})
+    ->Args({1920, 1080, 0, 0})        // Idle screen.
+    ->Args({1920, 1080, 32, 32})      // Cursor-sized change.
+    ->Args({1920, 1080, 960, 540})    // Video window.
+    ->Args({1920, 1080, 1920, 1080})  // Full-screen change.
+    ->Args({3840, 2160, 0, 0})
+    ->Args({3840, 2160, 32, 32})
+    ->Args({3840, 2160, 1920, 1080})
+    ->Args({3840, 2160, 3840, 2160});
+
+} // namespace
+
+} // namespace base
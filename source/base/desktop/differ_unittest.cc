@@ -0,0 +1,126 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/desktop/differ.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace base {
+
+namespace {
+
+const int kBytesPerPixel = 4;
+
+std::vector<uint8_t> makeImage(const Size& size)
+{
+    std::vector<uint8_t> image(
+        static_cast<size_t>(size.width()) * static_cast<size_t>(size.height()) * kBytesPerPixel);
+
+    for (size_t i = 0; i < image.size(); ++i)
+        image[i] = static_cast<uint8_t>(i * 31);
+
+    return image;
+}
+
+void flipPixel(std::vector<uint8_t>* image, const Size& size, int x, int y)
+{
+    const size_t offset =
+        (static_cast<size_t>(y) * static_cast<size_t>(size.width()) + static_cast<size_t>(x)) *
+        kBytesPerPixel;
+
+    (*image)[offset] ^= 0xFF;
+}
+
+} // namespace
+
+TEST(differ_test, identical_frames)
+{
+    const Size size(640, 300);
+    Differ differ(size);
+
+    std::vector<uint8_t> prev = makeImage(size);
+    std::vector<uint8_t> curr = prev;
+
+    Region dirty_region;
+    differ.calcDirtyRegion(prev.data(), curr.data(), &dirty_region);
+
+    EXPECT_TRUE(dirty_region.isEmpty());
+    EXPECT_EQ(differ.lastStats().changed_blocks, 0);
+    EXPECT_TRUE(differ.lastStats().bounding_rect.isEmpty());
+}
+
+TEST(differ_test, single_pixel_in_sampled_row)
+{
+    const Size size(640, 300);
+    Differ differ(size);
+
+    std::vector<uint8_t> prev = makeImage(size);
+    std::vector<uint8_t> curr = prev;
+
+    // Row 32 is one of the rows compared by the sampled pass of the identical-frame pre-check.
+    flipPixel(&curr, size, 100, 32);
+
+    Region dirty_region;
+    differ.calcDirtyRegion(prev.data(), curr.data(), &dirty_region);
+
+    EXPECT_FALSE(dirty_region.isEmpty());
+    EXPECT_TRUE(differ.lastStats().bounding_rect.contains(100, 32));
+}
+
+TEST(differ_test, single_pixel_in_unsampled_row)
+{
+    const Size size(640, 300);
+    Differ differ(size);
+
+    std::vector<uint8_t> prev = makeImage(size);
+    std::vector<uint8_t> curr = prev;
+
+    // No sampled row touches this pixel; the full comparison of the pre-check must reject the
+    // frames as different and the differ must report the change.
+    flipPixel(&curr, size, 500, 33);
+
+    Region dirty_region;
+    differ.calcDirtyRegion(prev.data(), curr.data(), &dirty_region);
+
+    EXPECT_FALSE(dirty_region.isEmpty());
+    EXPECT_TRUE(differ.lastStats().bounding_rect.contains(500, 33));
+}
+
+TEST(differ_test, single_pixel_in_partial_block)
+{
+    // Neither dimension is a multiple of the block size, so the bottom-right corner lies in a
+    // partial block.
+    const Size size(100, 70);
+    Differ differ(size);
+
+    std::vector<uint8_t> prev = makeImage(size);
+    std::vector<uint8_t> curr = prev;
+
+    flipPixel(&curr, size, 99, 69);
+
+    Region dirty_region;
+    differ.calcDirtyRegion(prev.data(), curr.data(), &dirty_region);
+
+    EXPECT_FALSE(dirty_region.isEmpty());
+    EXPECT_TRUE(differ.lastStats().bounding_rect.contains(99, 69));
+}
+
+} // namespace base
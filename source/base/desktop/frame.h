@@ -55,6 +55,11 @@ public:
     void setDpi(const Point& dpi) { dpi_ = dpi; }
     const Point& dpi() const { return dpi_; }
 
+    // Monotonic timestamp (in microseconds) taken when the capture of this frame started.
+    // Zero when the capturer did not stamp the frame.
+    void setCaptureTimeUs(uint64_t capture_time_us) { capture_time_us_ = capture_time_us; }
+    uint64_t captureTimeUs() const { return capture_time_us_; }
+
     // Copies various information from |other|. Anything initialized in constructor are not copied.
     // This function is usually used when sharing a source Frame with several clients: the original
     // Frame should be kept unchanged. For example and SharedFrame::share().
@@ -80,6 +85,7 @@ private:
     Region updated_region_;
     Point top_left_;
     Point dpi_;
+    uint64_t capture_time_us_ = 0;
 
     DISALLOW_COPY_AND_ASSIGN(Frame);
 };
@@ -22,26 +22,54 @@
 
 namespace base {
 
-FrameAligned::FrameAligned(const Size& size, uint8_t* data)
-    : Frame(size, size.width() * kBytesPerPixel, data, nullptr)
+namespace {
+
+// Buffers of at least this size are allocated with alignedHugeAlloc(). A full HD frame is
+// ~8MB and a 4K frame ~33MB; huge pages cut the TLB working set of the capture/diff/encode
+// loops over such buffers, while small frames stay on the regular allocator.
+const size_t kHugeAllocThreshold = 2 * 1024 * 1024;
+
+} // namespace
+
+FrameAligned::FrameAligned(const Size& size, uint8_t* data, size_t huge_memory_size)
+    : Frame(size, size.width() * kBytesPerPixel, data, nullptr),
+      huge_memory_size_(huge_memory_size)
 {
     // Nothing
 }
 
 FrameAligned::~FrameAligned()
 {
-    alignedFree(data_);
+    if (huge_memory_size_)
+        alignedHugeFree(data_, huge_memory_size_);
+    else
+        alignedFree(data_);
 }
 
 // static
 std::unique_ptr<FrameAligned> FrameAligned::create(const Size& size, size_t alignment)
 {
-    uint8_t* data = reinterpret_cast<uint8_t*>(
-        alignedAlloc(calcMemorySize(size, kBytesPerPixel), alignment));
+    const size_t memory_size = calcMemorySize(size, kBytesPerPixel);
+
+    uint8_t* data;
+    size_t huge_memory_size = 0;
+
+    if (memory_size >= kHugeAllocThreshold)
+    {
+        // The pages are committed on first touch, so they end up on the NUMA node of the
+        // capture thread that fills the frame.
+        data = reinterpret_cast<uint8_t*>(alignedHugeAlloc(memory_size, alignment));
+        huge_memory_size = memory_size;
+    }
+    else
+    {
+        data = reinterpret_cast<uint8_t*>(alignedAlloc(memory_size, alignment));
+    }
+
     if (!data)
         return nullptr;
 
-    return std::unique_ptr<FrameAligned>(new FrameAligned(size, data));
+    return std::unique_ptr<FrameAligned>(new FrameAligned(size, data, huge_memory_size));
 }
 
 } // namespace base
@@ -33,7 +33,11 @@ public:
     static std::unique_ptr<FrameAligned> create(const Size& size, size_t alignment);
 
 private:
-    FrameAligned(const Size& size, uint8_t* data);
+    FrameAligned(const Size& size, uint8_t* data, size_t huge_memory_size);
+
+    // Non-zero when the buffer came from alignedHugeAlloc(); alignedHugeFree() needs the
+    // original allocation size back.
+    const size_t huge_memory_size_;
 
     DISALLOW_COPY_AND_ASSIGN(FrameAligned);
 };
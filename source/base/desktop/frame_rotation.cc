@@ -134,4 +134,20 @@ void rotateDesktopFrame(const Frame& source,
     DCHECK_EQ(result, 0);
 }
 
+void rotateDesktopFrame(const Frame& source,
+                        const Region& region,
+                        const Rotation& rotation,
+                        const Point& target_offset,
+                        Frame* target)
+{
+    const Size rotated_size = rotateSize(source.size(), rotation);
+    const Rotation reverse_rotation = reverseRotation(rotation);
+
+    for (Region::Iterator it(region); !it.isAtEnd(); it.advance())
+    {
+        const Rect source_rect = rotateRect(it.rect(), rotated_size, reverse_rotation);
+        rotateDesktopFrame(source, source_rect, rotation, target_offset, target);
+    }
+}
+
 } // namespace base
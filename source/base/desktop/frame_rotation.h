@@ -45,6 +45,16 @@ void rotateDesktopFrame(const Frame& source,
                         const Point& target_offset,
                         Frame* target);
 
+// Rotates only the pixels of |source| covered by |region|, so the cost of a rotated display is
+// proportional to the damaged area instead of the full screen. |region| is in rotated (target)
+// coordinates, starting from (0, 0); each rectangle is rotated back into |source| coordinates
+// before the pixels are copied.
+void rotateDesktopFrame(const Frame& source,
+                        const Region& region,
+                        const Rotation& rotation,
+                        const Point& target_offset,
+                        Frame* target);
+
 // Returns a reverse rotation of |rotation|.
 Rotation reverseRotation(Rotation rotation);
 
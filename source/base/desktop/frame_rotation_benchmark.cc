@@ -0,0 +1,89 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/desktop/frame_rotation.h"
+#include "base/desktop/frame_simple.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <memory>
+
+namespace base {
+
+namespace {
+
+// Rotation of the damaged region of a frame, as a capturer of a rotated display performs it on
+// every captured frame. The damaged rectangle sits in the middle of the screen; the idle screen
+// is not benchmarked because an empty region does not reach the rotation code at all.
+void runRotateDesktopFrame(benchmark::State& state,
+                           const Size& screen_size,
+                           const Size& damage_size,
+                           Rotation rotation)
+{
+    std::unique_ptr<FrameSimple> source = FrameSimple::create(screen_size);
+    std::unique_ptr<FrameSimple> target = FrameSimple::create(rotateSize(screen_size, rotation));
+
+    memset(source->frameData(), 0xAB,
+           Frame::kBytesPerPixel * static_cast<size_t>(screen_size.width()) *
+               screen_size.height());
+
+    // The damaged region is in rotated (target) coordinates, like the region a capturer gets
+    // from the system for a rotated display.
+    const Size rotated_size = rotateSize(screen_size, rotation);
+    Rect damage_rect = Rect::makeXYWH((rotated_size.width() - damage_size.width()) / 2,
+                                      (rotated_size.height() - damage_size.height()) / 2,
+                                      damage_size.width(),
+                                      damage_size.height());
+    damage_rect.intersectWith(Rect::makeSize(rotated_size));
+
+    Region damage_region(damage_rect);
+
+    for (auto _ : state)
+    {
+        rotateDesktopFrame(*source, damage_region, rotation, Point(), target.get());
+        benchmark::DoNotOptimize(target->frameData());
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * damage_rect.width() *
+                            damage_rect.height() * Frame::kBytesPerPixel);
+}
+
+void BM_RotateDesktopFrame(benchmark::State& state)
+{
+    runRotateDesktopFrame(state,
+                          Size(static_cast<int32_t>(state.range(0)),
+                               static_cast<int32_t>(state.range(1))),
+                          Size(static_cast<int32_t>(state.range(2)),
+                               static_cast<int32_t>(state.range(3))),
+                          static_cast<Rotation>(state.range(4)));
+}
+
+BENCHMARK(BM_RotateDesktopFrame)
+    ->ArgNames({"width", "height", "damage_w", "damage_h", "rotation"})
+    ->Args({1920, 1080, 32, 32, 90})       // Cursor-sized change on a portrait display.
+    ->Args({1920, 1080, 540, 960, 90})     // Video window.
+    ->Args({1920, 1080, 1080, 1920, 90})   // Full-screen change.
+    ->Args({1920, 1080, 1080, 1920, 270})
+    ->Args({1920, 1080, 1920, 1080, 180})
+    ->Args({3840, 2160, 32, 32, 90})
+    ->Args({3840, 2160, 2160, 3840, 90});
+
+} // namespace
+
+} // namespace base
@@ -29,14 +29,14 @@ class Point
 public:
     Point() = default;
 
-    Point(int32_t x, int32_t y)
+    constexpr Point(int32_t x, int32_t y)
         : x_(x),
           y_(y)
     {
         // Nothing
     }
 
-    Point(const Point& point)
+    constexpr Point(const Point& point)
         : x_(point.x_),
           y_(point.y_)
     {
@@ -45,47 +45,47 @@ public:
 
     ~Point() = default;
 
-    int32_t x() const { return x_; }
-    int32_t y() const { return y_; }
+    constexpr int32_t x() const { return x_; }
+    constexpr int32_t y() const { return y_; }
 
-    void set(int32_t x, int32_t y)
+    constexpr void set(int32_t x, int32_t y)
     {
         x_ = x;
         y_ = y;
     }
 
-    Point add(const Point& other) const
+    constexpr Point add(const Point& other) const
     {
         return Point(x() + other.x(), y() + other.y());
     }
 
-    Point subtract(const Point& other) const
+    constexpr Point subtract(const Point& other) const
     {
         return Point(x() - other.x(), y() - other.y());
     }
 
-    bool equals(const Point& other) const
+    constexpr bool equals(const Point& other) const
     {
         return (x_ == other.x_ && y_ == other.y_);
     }
 
-    void translate(int32_t x_offset, int32_t y_offset)
+    constexpr void translate(int32_t x_offset, int32_t y_offset)
     {
         x_ += x_offset;
         y_ += y_offset;
     }
 
-    void translate(const Point& offset) { translate(offset.x(), offset.y()); }
+    constexpr void translate(const Point& offset) { translate(offset.x(), offset.y()); }
 
-    Point& operator=(const Point& other)
+    constexpr Point& operator=(const Point& other)
     {
         if (&other != this)
             set(other.x_, other.y_);
         return *this;
     }
 
-    bool operator!=(const Point& other) const { return !equals(other); }
-    bool operator==(const Point& other) const { return equals(other); }
+    constexpr bool operator!=(const Point& other) const { return !equals(other); }
+    constexpr bool operator==(const Point& other) const { return equals(other); }
 
 private:
     int32_t x_ = 0;
@@ -97,14 +97,14 @@ class Size
 public:
     Size() = default;
 
-    Size(int32_t width, int32_t height)
+    constexpr Size(int32_t width, int32_t height)
         : width_(width),
           height_(height)
     {
         // Nothing
     }
 
-    Size(const Size& other)
+    constexpr Size(const Size& other)
         : width_(other.width_),
           height_(other.height_)
     {
@@ -113,145 +113,259 @@ public:
 
     ~Size() = default;
 
-    int32_t width() const { return width_; }
-    int32_t height() const { return height_; }
+    constexpr int32_t width() const { return width_; }
+    constexpr int32_t height() const { return height_; }
 
-    void set(int32_t width, int32_t height)
+    constexpr void set(int32_t width, int32_t height)
     {
         width_ = width;
         height_ = height;
     }
 
-    bool isEmpty() const
+    constexpr bool isEmpty() const
     {
         return width_ <= 0 || height_ <= 0;
     }
 
-    bool equals(const Size& other) const
+    constexpr bool equals(const Size& other) const
     {
         return width_ == other.width_ && height_ == other.height_;
     }
 
-    void clear()
+    constexpr void clear()
     {
         width_ = 0;
         height_ = 0;
     }
 
-    Size& operator=(const Size& other)
+    constexpr Size& operator=(const Size& other)
     {
         if (&other != this)
             set(other.width_, other.height_);
         return *this;
     }
 
-    bool operator!=(const Size& other) const { return !equals(other); }
-    bool operator==(const Size& other) const { return equals(other); }
+    constexpr bool operator!=(const Size& other) const { return !equals(other); }
+    constexpr bool operator==(const Size& other) const { return equals(other); }
 
 private:
     int32_t width_ = 0;
     int32_t height_ = 0;
 };
 
+// The rectangle operations are implemented in the header on purpose: the differ and region
+// code call them millions of times per frame in tight loops, and out-of-line definitions
+// could not inline across translation units.
 class Rect
 {
 public:
     Rect() = default;
-    Rect(const Rect& other);
+
+    constexpr Rect(const Rect& other)
+        : left_(other.left_),
+          top_(other.top_),
+          right_(other.right_),
+          bottom_(other.bottom_)
+    {
+        // Nothing
+    }
+
     ~Rect() = default;
 
-    static Rect makeXYWH(int32_t x, int32_t y, int32_t width, int32_t height)
+    static constexpr Rect makeXYWH(int32_t x, int32_t y, int32_t width, int32_t height)
     {
         return Rect(x, y, x + width, y + height);
     }
 
-    static Rect makeXYWH(const Point& left_top, const Size& size)
+    static constexpr Rect makeXYWH(const Point& left_top, const Size& size)
     {
         return Rect::makeXYWH(left_top.x(), left_top.y(), size.width(), size.height());
     }
 
-    static Rect makeWH(int32_t width, int32_t height)
+    static constexpr Rect makeWH(int32_t width, int32_t height)
     {
         return Rect(0, 0, width, height);
     }
 
-    static Rect makeLTRB(int32_t left, int32_t top, int32_t right, int32_t bottom)
+    static constexpr Rect makeLTRB(int32_t left, int32_t top, int32_t right, int32_t bottom)
     {
         return Rect(left, top, right, bottom);
     }
 
-    static Rect makeSize(const Size& size)
+    static constexpr Rect makeSize(const Size& size)
     {
         return Rect(0, 0, size.width(), size.height());
     }
 
-    int32_t left() const { return left_; }
-    int32_t top() const { return top_; }
-    int32_t right() const { return right_; }
-    int32_t bottom() const { return bottom_; }
+    constexpr int32_t left() const { return left_; }
+    constexpr int32_t top() const { return top_; }
+    constexpr int32_t right() const { return right_; }
+    constexpr int32_t bottom() const { return bottom_; }
 
-    int32_t x() const { return left_; }
-    int32_t y() const { return top_; }
-    int32_t width() const { return right_ - left_; }
-    int32_t height() const { return bottom_ - top_; }
+    constexpr int32_t x() const { return left_; }
+    constexpr int32_t y() const { return top_; }
+    constexpr int32_t width() const { return right_ - left_; }
+    constexpr int32_t height() const { return bottom_ - top_; }
 
-    Point topLeft() const { return Point(left(), top()); }
-    void setTopLeft(const Point& top_left);
+    constexpr Point topLeft() const { return Point(left(), top()); }
 
-    Size size() const { return Size(width(), height()); }
-    void setSize(const Size& size);
+    constexpr void setTopLeft(const Point& top_left)
+    {
+        left_ = top_left.x();
+        top_ = top_left.y();
+    }
+
+    constexpr Size size() const { return Size(width(), height()); }
+
+    constexpr void setSize(const Size& size)
+    {
+        right_ = left_ + size.width();
+        bottom_ = top_ + size.height();
+    }
 
-    bool isEmpty() const { return left_ >= right_ || top_ >= bottom_; }
+    constexpr bool isEmpty() const { return left_ >= right_ || top_ >= bottom_; }
 
-    bool equals(const Rect& other) const
+    constexpr bool equals(const Rect& other) const
     {
         return left_ == other.left_  && top_ == other.top_   &&
                right_ == other.right_ && bottom_ == other.bottom_;
     }
 
     // Returns true if point lies within the rectangle boundaries.
-    bool contains(int32_t x, int32_t y) const;
+    constexpr bool contains(int32_t x, int32_t y) const
+    {
+        return (x >= left_ && x < right_ && y >= top_ && y < bottom_);
+    }
 
     // Returns true if |rect| lies within the boundaries of this rectangle.
-    bool containsRect(const Rect& rect) const;
+    constexpr bool containsRect(const Rect& rect) const
+    {
+        return (rect.left_ >= left_ && rect.right_  <= right_ &&
+                rect.top_  >= top_  && rect.bottom_ <= bottom_);
+    }
 
-    void translate(int32_t dx, int32_t dy);
-    void translate(const Point& pt) { translate(pt.x(), pt.y()); };
+    constexpr void translate(int32_t dx, int32_t dy)
+    {
+        left_   += dx;
+        right_  += dx;
+        top_    += dy;
+        bottom_ += dy;
+    }
 
-    Rect translated(int32_t dx, int32_t dy) const;
-    Rect translated(const Point& pt) const { return translated(pt.x(), pt.y()); }
+    constexpr void translate(const Point& pt) { translate(pt.x(), pt.y()); };
+
+    constexpr Rect translated(int32_t dx, int32_t dy) const
+    {
+        Rect result(*this);
+        result.translate(dx, dy);
+        return result;
+    }
+
+    constexpr Rect translated(const Point& pt) const { return translated(pt.x(), pt.y()); }
 
     // Finds intersection with |rect|.
-    void intersectWith(const Rect& rect);
+    constexpr void intersectWith(const Rect& rect)
+    {
+        left_   = left_   > rect.left_   ? left_   : rect.left_;
+        top_    = top_    > rect.top_    ? top_    : rect.top_;
+        right_  = right_  < rect.right_  ? right_  : rect.right_;
+        bottom_ = bottom_ < rect.bottom_ ? bottom_ : rect.bottom_;
+
+        if (isEmpty())
+        {
+            left_   = 0;
+            top_    = 0;
+            right_  = 0;
+            bottom_ = 0;
+        }
+    }
+
+    // Returns the intersection of |this| and |rect| without modifying either.
+    constexpr Rect intersected(const Rect& rect) const
+    {
+        Rect result(*this);
+        result.intersectWith(rect);
+        return result;
+    }
 
     // Extends the rectangle to cover |rect|. If |this| is empty, replaces |this|
     // with |rect|; if |rect| is empty, this function takes no effect.
-    void unionWith(const Rect& rect);
+    constexpr void unionWith(const Rect& rect)
+    {
+        if (isEmpty())
+        {
+            *this = rect;
+            return;
+        }
+
+        if (rect.isEmpty())
+            return;
+
+        left_   = left_   < rect.left_   ? left_   : rect.left_;
+        top_    = top_    < rect.top_    ? top_    : rect.top_;
+        right_  = right_  > rect.right_  ? right_  : rect.right_;
+        bottom_ = bottom_ > rect.bottom_ ? bottom_ : rect.bottom_;
+    }
+
+    // Returns the union of |this| and |rect| without modifying either.
+    constexpr Rect united(const Rect& rect) const
+    {
+        Rect result(*this);
+        result.unionWith(rect);
+        return result;
+    }
 
     // Enlarges current Rect by subtracting |left_offset| and |top_offset|
     // from |left_| and |top_|, and adding |right_offset| and |bottom_offset| to
     // |right_| and |bottom_|. This function does not normalize the result, so
     // |left_| and |top_| may be less than zero or larger than |right_| and
     // |bottom_|.
-    void extend(int32_t left_offset, int32_t top_offset,
-                int32_t right_offset, int32_t bottom_offset);
+    constexpr void extend(int32_t left_offset, int32_t top_offset,
+                          int32_t right_offset, int32_t bottom_offset)
+    {
+        left_   -= left_offset;
+        top_    -= top_offset;
+        right_  += right_offset;
+        bottom_ += bottom_offset;
+    }
 
     // Scales current Rect. This function does not impact the |top_| and |left_|.
     void scale(double horizontal, double vertical);
 
-    void move(const Point& pt) { move(pt.x(), pt.y()); }
-    void move(int32_t x, int32_t y);
+    constexpr void move(const Point& pt) { move(pt.x(), pt.y()); }
 
-    Rect moved(const Point& pt) const { return moved(pt.x(), pt.y()); };
-    Rect moved(int32_t x, int32_t y) const;
+    constexpr void move(int32_t x, int32_t y)
+    {
+        right_  += x - left_;
+        bottom_ += y - top_;
+        left_ = x;
+        top_  = y;
+    }
+
+    constexpr Rect moved(const Point& pt) const { return moved(pt.x(), pt.y()); };
+
+    constexpr Rect moved(int32_t x, int32_t y) const
+    {
+        Rect moved_rect(*this);
+        moved_rect.move(x, y);
+        return moved_rect;
+    }
+
+    constexpr Rect& operator=(const Rect& other)
+    {
+        left_   = other.left_;
+        top_    = other.top_;
+        right_  = other.right_;
+        bottom_ = other.bottom_;
 
-    Rect& operator=(const Rect& other);
+        return *this;
+    }
 
-    bool operator!=(const Rect& other) const { return !equals(other); }
-    bool operator==(const Rect& other) const { return equals(other); }
+    constexpr bool operator!=(const Rect& other) const { return !equals(other); }
+    constexpr bool operator==(const Rect& other) const { return equals(other); }
 
 private:
-    Rect(int32_t left, int32_t top, int32_t right, int32_t bottom)
+    constexpr Rect(int32_t left, int32_t top, int32_t right, int32_t bottom)
         : left_(left),
           top_(top),
           right_(right),
@@ -16,11 +16,11 @@
 // along with this program. If not, see <https://www.gnu.org/licenses/>.
 //
 
-#include "desktop/geometry.h"
+#include "base/desktop/geometry.h"
 
 #include <gtest/gtest.h>
 
-namespace desktop {
+namespace base {
 
 TEST(desktop_rect_test, union_between_two_non_empty_rects)
 {
@@ -116,4 +116,45 @@ TEST(desktop_rect_test, scale)
     ASSERT_EQ(rect.height(), 110);
 }
 
-} // namespace desktop
+TEST(desktop_rect_test, intersected)
+{
+    Rect rect = Rect::makeLTRB(0, 0, 10, 10);
+
+    ASSERT_TRUE(rect.intersected(Rect::makeLTRB(5, 5, 15, 15)).equals(
+        Rect::makeLTRB(5, 5, 10, 10)));
+    ASSERT_TRUE(rect.intersected(Rect::makeLTRB(20, 20, 30, 30)).isEmpty());
+
+    // The source rectangle is not modified.
+    ASSERT_TRUE(rect.equals(Rect::makeLTRB(0, 0, 10, 10)));
+}
+
+TEST(desktop_rect_test, united)
+{
+    Rect rect = Rect::makeLTRB(1, 1, 2, 2);
+
+    ASSERT_TRUE(rect.united(Rect::makeLTRB(-2, -2, -1, -1)).equals(
+        Rect::makeLTRB(-2, -2, 2, 2)));
+    ASSERT_TRUE(rect.united(Rect()).equals(rect));
+    ASSERT_TRUE(Rect().united(rect).equals(rect));
+
+    // The source rectangle is not modified.
+    ASSERT_TRUE(rect.equals(Rect::makeLTRB(1, 1, 2, 2)));
+}
+
+// The geometry operations are constexpr so that rectangle arithmetic can fold at compile time;
+// this block fails to compile if one of them loses that property.
+static_assert(Rect::makeXYWH(1, 2, 3, 4).equals(Rect::makeLTRB(1, 2, 4, 6)));
+static_assert(Rect::makeWH(10, 10).contains(9, 9));
+static_assert(!Rect::makeWH(10, 10).contains(10, 10));
+static_assert(Rect::makeWH(10, 10).containsRect(Rect::makeLTRB(5, 5, 10, 10)));
+static_assert(Rect::makeWH(10, 10).intersected(Rect::makeLTRB(5, 5, 15, 15)).equals(
+    Rect::makeLTRB(5, 5, 10, 10)));
+static_assert(Rect::makeWH(1, 1).united(Rect::makeLTRB(-1, -1, 0, 0)).equals(
+    Rect::makeLTRB(-1, -1, 1, 1)));
+static_assert(Rect::makeWH(1, 1).translated(2, 3).equals(Rect::makeLTRB(2, 3, 3, 4)));
+static_assert(Rect::makeXYWH(1, 1, 2, 2).moved(5, 5).equals(Rect::makeXYWH(5, 5, 2, 2)));
+static_assert(Point(1, 2).add(Point(3, 4)) == Point(4, 6));
+static_assert(Point(1, 2).subtract(Point(3, 4)) == Point(-2, -2));
+static_assert(Size(0, 1).isEmpty() && !Size(1, 1).isEmpty());
+
+} // namespace base
@@ -112,6 +112,84 @@ bool Region::equals(const Region& region) const
     return (miRegionsEqual(region_cast(&x11reg_), region_cast(&region.x11reg_)) != FALSE);
 }
 
+bool Region::contains(const Point& point) const
+{
+    const int x = point.x();
+    const int y = point.y();
+
+    // Quick reject against the extents; also handles the empty region.
+    const BoxRec& extents = x11reg_.extents;
+    if (x < extents.x1 || x >= extents.x2 || y < extents.y1 || y >= extents.y2)
+        return false;
+
+    RegionPtr reg = region_cast(&x11reg_);
+    const BoxRec* rects = REGION_RECTS(reg);
+    const long count = REGION_NUM_RECTS(reg);
+
+    // Rectangles are sorted by band and by x within a band, so the first rectangle that does not
+    // end before the point can be found with a binary search.
+    long low = 0;
+    long high = count;
+
+    while (low < high)
+    {
+        const long mid = (low + high) / 2;
+        const BoxRec& box = rects[mid];
+
+        if (box.y2 <= y || (box.y1 <= y && box.x2 <= x))
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    if (low == count)
+        return false;
+
+    const BoxRec& box = rects[low];
+    return box.y1 <= y && y < box.y2 && box.x1 <= x && x < box.x2;
+}
+
+bool Region::intersects(const Rect& rect) const
+{
+    if (rect.isEmpty())
+        return false;
+
+    // Quick reject against the extents; also handles the empty region.
+    const BoxRec& extents = x11reg_.extents;
+    if (rect.right() <= extents.x1 || rect.left() >= extents.x2 ||
+        rect.bottom() <= extents.y1 || rect.top() >= extents.y2)
+    {
+        return false;
+    }
+
+    RegionPtr reg = region_cast(&x11reg_);
+    const BoxRec* rects = REGION_RECTS(reg);
+    const long count = REGION_NUM_RECTS(reg);
+
+    // Binary search to the first band that does not end above the rectangle.
+    long low = 0;
+    long high = count;
+
+    while (low < high)
+    {
+        const long mid = (low + high) / 2;
+
+        if (rects[mid].y2 <= rect.top())
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    // Only the bands overlapping the rectangle vertically are scanned.
+    for (long i = low; i < count && rects[i].y1 < rect.bottom(); ++i)
+    {
+        if (rects[i].x1 < rect.right() && rects[i].x2 > rect.left())
+            return true;
+    }
+
+    return false;
+}
+
 void Region::clear()
 {
     miRegionEmpty(&x11reg_);
@@ -71,6 +71,15 @@ public:
 
     bool equals(const Region& region) const;
 
+    // Returns true if the region contains |point|. The banded storage keeps rectangles sorted by
+    // band and by x within a band, so the lookup is a binary search - O(log n) in the number of
+    // rectangles.
+    bool contains(const Point& point) const;
+
+    // Returns true if the region intersects |rect|. Bands above the rectangle are skipped with a
+    // binary search; only potentially overlapping bands are scanned.
+    bool intersects(const Rect& rect) const;
+
     // Reset the region to be empty.
     void clear();
 
@@ -0,0 +1,183 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/desktop/region.h"
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+namespace base {
+
+namespace {
+
+// Builds a checkerboard of |count| x |count| cells of the given size starting at |origin|. This
+// is close to what the differ produces for scattered screen damage and is the worst case for
+// the span-merging logic.
+std::vector<Rect> makeCheckerboard(int count, int cell_size, int origin)
+{
+    std::vector<Rect> rects;
+    rects.reserve(static_cast<size_t>(count) * count / 2);
+
+    for (int y = 0; y < count; ++y)
+    {
+        for (int x = (y & 1); x < count; x += 2)
+        {
+            rects.emplace_back(Rect::makeXYWH(origin + x * cell_size,
+                                              origin + y * cell_size,
+                                              cell_size,
+                                              cell_size));
+        }
+    }
+
+    return rects;
+}
+
+void BM_Region_AddRect(benchmark::State& state)
+{
+    const int count = static_cast<int>(state.range(0));
+    std::vector<Rect> rects = makeCheckerboard(count, 16, 0);
+
+    for (auto _ : state)
+    {
+        Region region;
+        for (const Rect& rect : rects)
+            region.addRect(rect);
+        benchmark::DoNotOptimize(region);
+    }
+}
+
+void BM_Region_AddRects(benchmark::State& state)
+{
+    const int count = static_cast<int>(state.range(0));
+    std::vector<Rect> rects = makeCheckerboard(count, 16, 0);
+
+    for (auto _ : state)
+    {
+        Region region;
+        region.addRects(rects.data(), static_cast<int>(rects.size()));
+        benchmark::DoNotOptimize(region);
+    }
+}
+
+void BM_Region_IntersectWith(benchmark::State& state)
+{
+    const int count = static_cast<int>(state.range(0));
+    std::vector<Rect> rects1 = makeCheckerboard(count, 16, 0);
+    std::vector<Rect> rects2 = makeCheckerboard(count, 16, 8);
+
+    Region region1;
+    region1.addRects(rects1.data(), static_cast<int>(rects1.size()));
+
+    Region region2;
+    region2.addRects(rects2.data(), static_cast<int>(rects2.size()));
+
+    for (auto _ : state)
+    {
+        Region result(region1);
+        result.intersectWith(region2);
+        benchmark::DoNotOptimize(result);
+    }
+}
+
+void BM_Region_Subtract(benchmark::State& state)
+{
+    const int count = static_cast<int>(state.range(0));
+    std::vector<Rect> rects = makeCheckerboard(count, 16, 8);
+
+    Region full;
+    full.setRect(Rect::makeWH(count * 16 + 8, count * 16 + 8));
+
+    Region holes;
+    holes.addRects(rects.data(), static_cast<int>(rects.size()));
+
+    for (auto _ : state)
+    {
+        Region result(full);
+        result.subtract(holes);
+        benchmark::DoNotOptimize(result);
+    }
+}
+
+// Damage of one frame of video playing in a window: the large video rectangle plus a handful
+// of small UI updates around it, clipped to the screen. The region is built and iterated once
+// per captured frame, so this cost is paid at frame rate.
+void BM_Region_VideoDamage(benchmark::State& state)
+{
+    const Rect screen = Rect::makeWH(2560, 1440);
+    const Rect video = Rect::makeXYWH(320, 180, 1280, 720);
+    std::vector<Rect> ui_updates = makeCheckerboard(6, 24, 1900);
+
+    for (auto _ : state)
+    {
+        Region damage;
+        damage.addRect(video);
+        damage.addRects(ui_updates.data(), static_cast<int>(ui_updates.size()));
+        damage.intersectWith(screen);
+
+        int64_t area = 0;
+        for (Region::Iterator it(damage); !it.isAtEnd(); it.advance())
+        {
+            const Rect rect = it.rect();
+            area += static_cast<int64_t>(rect.width()) * rect.height();
+        }
+        benchmark::DoNotOptimize(area);
+    }
+}
+
+// Damage of a scrolling document window: per scroll step the accumulated damage moves with
+// the content, the newly exposed band is merged in and everything is clipped back to the
+// window. Exercises translate and the band merging of full-width rows.
+void BM_Region_ScrollDamage(benchmark::State& state)
+{
+    const Rect window = Rect::makeXYWH(200, 100, 1600, 1000);
+    const int kScrollStep = 60; // Pixels per scroll step.
+    const int kSteps = 16;
+
+    for (auto _ : state)
+    {
+        Region damage;
+
+        for (int i = 0; i < kSteps; ++i)
+        {
+            damage.translate(0, -kScrollStep);
+            damage.addRect(Rect::makeXYWH(window.left(), window.bottom() - kScrollStep,
+                                          window.width(), kScrollStep));
+            damage.intersectWith(window);
+        }
+
+        int64_t area = 0;
+        for (Region::Iterator it(damage); !it.isAtEnd(); it.advance())
+        {
+            const Rect rect = it.rect();
+            area += static_cast<int64_t>(rect.width()) * rect.height();
+        }
+        benchmark::DoNotOptimize(area);
+    }
+}
+
+BENCHMARK(BM_Region_AddRect)->Arg(8)->Arg(32)->Arg(128);
+BENCHMARK(BM_Region_AddRects)->Arg(8)->Arg(32)->Arg(128);
+BENCHMARK(BM_Region_IntersectWith)->Arg(8)->Arg(32)->Arg(128);
+BENCHMARK(BM_Region_Subtract)->Arg(8)->Arg(32)->Arg(128);
+BENCHMARK(BM_Region_VideoDamage);
+BENCHMARK(BM_Region_ScrollDamage);
+
+} // namespace
+
+} // namespace base
@@ -16,13 +16,14 @@
 // along with this program. If not, see <https://www.gnu.org/licenses/>.
 //
 
-#include "desktop/region.h"
+#include "base/desktop/region.h"
 
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <vector>
 
-namespace desktop {
+namespace base {
 
 namespace {
 
@@ -51,6 +52,42 @@ void compareRegion(const Region& region, const Rect rects[], int rects_size)
     EXPECT_TRUE(it.isAtEnd());
 }
 
+// Marks the cells of |rect| in an occupancy map of |grid_size| x |grid_size| cells.
+void fillMap(const Rect& rect, int grid_size, std::vector<bool>* map)
+{
+    for (int y = rect.top(); y < rect.bottom(); ++y)
+    {
+        for (int x = rect.left(); x < rect.right(); ++x)
+            (*map)[y * grid_size + x] = true;
+    }
+}
+
+// Rasterizes |region| into an occupancy map, checking on the way that every rectangle lies
+// within the grid and that the rectangles do not overlap.
+void rasterizeRegion(const Region& region, int grid_size, std::vector<bool>* map)
+{
+    map->assign(grid_size * grid_size, false);
+
+    for (Region::Iterator it(region); !it.isAtEnd(); it.advance())
+    {
+        const Rect rect = it.rect();
+
+        ASSERT_TRUE(rect.left() >= 0 && rect.top() >= 0 &&
+                    rect.right() <= grid_size && rect.bottom() <= grid_size)
+            << rect.left() << "-" << rect.right() << "." << rect.top() << "-" << rect.bottom();
+
+        for (int y = rect.top(); y < rect.bottom(); ++y)
+        {
+            for (int x = rect.left(); x < rect.right(); ++x)
+            {
+                std::vector<bool>::reference cell = (*map)[y * grid_size + x];
+                EXPECT_FALSE(cell) << "overlapping rectangles at " << x << "," << y;
+                cell = true;
+            }
+        }
+    }
+}
+
 } // namespace
 
 // Verify that regions are empty when created.
@@ -1007,4 +1044,135 @@ TEST(desktop_region_test, performance)
     }
 }
 
-} // namespace desktop
+TEST(desktop_region_test, contains_point)
+{
+    Region r;
+
+    EXPECT_FALSE(r.contains(Point(0, 0)));
+
+    r.addRect(Rect::makeXYWH(10, 10, 10, 10));
+    r.addRect(Rect::makeXYWH(40, 10, 10, 10));
+    r.addRect(Rect::makeXYWH(10, 40, 40, 10));
+
+    EXPECT_TRUE(r.contains(Point(10, 10)));
+    EXPECT_TRUE(r.contains(Point(19, 19)));
+    EXPECT_TRUE(r.contains(Point(45, 15)));
+    EXPECT_TRUE(r.contains(Point(30, 45)));
+
+    // Points between and around the rectangles.
+    EXPECT_FALSE(r.contains(Point(9, 10)));
+    EXPECT_FALSE(r.contains(Point(20, 10)));
+    EXPECT_FALSE(r.contains(Point(30, 15)));
+    EXPECT_FALSE(r.contains(Point(15, 30)));
+    EXPECT_FALSE(r.contains(Point(50, 45)));
+
+    // The brute-force check must agree with the binary search for every point.
+    for (int y = 0; y < 60; ++y)
+    {
+        for (int x = 0; x < 60; ++x)
+        {
+            bool expected = false;
+
+            for (Region::Iterator it(r); !it.isAtEnd(); it.advance())
+            {
+                if (it.rect().contains(x, y))
+                    expected = true;
+            }
+
+            EXPECT_EQ(expected, r.contains(Point(x, y))) << x << "," << y;
+        }
+    }
+}
+
+TEST(desktop_region_test, intersects_rect)
+{
+    Region r;
+
+    EXPECT_FALSE(r.intersects(Rect::makeXYWH(0, 0, 100, 100)));
+
+    r.addRect(Rect::makeXYWH(10, 10, 10, 10));
+    r.addRect(Rect::makeXYWH(40, 40, 10, 10));
+
+    EXPECT_TRUE(r.intersects(Rect::makeXYWH(0, 0, 100, 100)));
+    EXPECT_TRUE(r.intersects(Rect::makeXYWH(15, 15, 1, 1)));
+    EXPECT_TRUE(r.intersects(Rect::makeXYWH(0, 0, 11, 11)));
+    EXPECT_TRUE(r.intersects(Rect::makeXYWH(49, 49, 10, 10)));
+
+    // Gaps between the rectangles.
+    EXPECT_FALSE(r.intersects(Rect::makeXYWH(20, 20, 20, 20)));
+    EXPECT_FALSE(r.intersects(Rect::makeXYWH(0, 0, 10, 10)));
+    EXPECT_FALSE(r.intersects(Rect::makeXYWH(10, 25, 40, 10)));
+    EXPECT_FALSE(r.intersects(Rect::makeXYWH(15, 15, 0, 0)));
+}
+
+// Generative stress test: regions built from random rectangle sets are checked against a
+// brute-force occupancy map, for construction as well as for every set operation. The grid is
+// small so the map comparison stays cheap, but overlapping random rectangles still produce
+// complex band structures.
+TEST(desktop_region_test, randomized_reference_model)
+{
+    const int kGridSize = 64;
+    const int kIterations = 200;
+    const int kRectCount = 12;
+
+    for (int iteration = 0; iteration < kIterations; ++iteration)
+    {
+        SCOPED_TRACE(iteration);
+
+        std::vector<bool> model1(kGridSize * kGridSize, false);
+        std::vector<bool> model2(kGridSize * kGridSize, false);
+
+        Region region1;
+        Region region2;
+
+        // Position and size are chosen so the rectangles always stay inside the grid.
+        for (int i = 0; i < kRectCount; ++i)
+        {
+            Rect rect = Rect::makeXYWH(radmonInt(48), radmonInt(48),
+                                       1 + radmonInt(16), 1 + radmonInt(16));
+            region1.addRect(rect);
+            fillMap(rect, kGridSize, &model1);
+
+            rect = Rect::makeXYWH(radmonInt(48), radmonInt(48),
+                                  1 + radmonInt(16), 1 + radmonInt(16));
+            region2.addRect(rect);
+            fillMap(rect, kGridSize, &model2);
+        }
+
+        std::vector<bool> map;
+        std::vector<bool> expected(kGridSize * kGridSize);
+
+        // The built regions must cover exactly the cells of their models.
+        rasterizeRegion(region1, kGridSize, &map);
+        EXPECT_TRUE(model1 == map);
+
+        rasterizeRegion(region2, kGridSize, &map);
+        EXPECT_TRUE(model2 == map);
+
+        // Union.
+        Region union_region(region1);
+        union_region.addRegion(region2);
+        rasterizeRegion(union_region, kGridSize, &map);
+        for (size_t i = 0; i < expected.size(); ++i)
+            expected[i] = model1[i] || model2[i];
+        EXPECT_TRUE(expected == map);
+
+        // Intersection.
+        Region intersection;
+        intersection.intersect(region1, region2);
+        rasterizeRegion(intersection, kGridSize, &map);
+        for (size_t i = 0; i < expected.size(); ++i)
+            expected[i] = model1[i] && model2[i];
+        EXPECT_TRUE(expected == map);
+
+        // Subtraction.
+        Region difference(region1);
+        difference.subtract(region2);
+        rasterizeRegion(difference, kGridSize, &map);
+        for (size_t i = 0; i < expected.size(); ++i)
+            expected[i] = model1[i] && !model2[i];
+        EXPECT_TRUE(expected == map);
+    }
+}
+
+} // namespace base
@@ -0,0 +1,481 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/desktop/screen_capture_portal.h"
+
+#if defined(USE_PIPEWIRE)
+
+#include "base/logging.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include <dbus/dbus.h>
+#include <unistd.h>
+
+namespace base {
+
+namespace {
+
+const char kPortalService[] = "org.freedesktop.portal.Desktop";
+const char kPortalObject[] = "/org/freedesktop/portal/desktop";
+const char kScreenCastInterface[] = "org.freedesktop.portal.ScreenCast";
+const char kRequestInterface[] = "org.freedesktop.portal.Request";
+
+// Timeout for portal calls that complete without user interaction.
+const int kMethodTimeoutMs = 30000;
+
+// Start shows a dialog in which the user picks the shared screen, so its response is waited for
+// much longer.
+const int kStartTimeoutMs = 120000;
+
+// Values from the org.freedesktop.portal.ScreenCast specification.
+const uint32_t kSourceTypeMonitor = 1;
+const uint32_t kCursorModeEmbedded = 2;
+
+void appendStringOption(DBusMessageIter* dict, const char* key, const char* value)
+{
+    DBusMessageIter entry;
+    DBusMessageIter variant;
+
+    dbus_message_iter_open_container(dict, DBUS_TYPE_DICT_ENTRY, nullptr, &entry);
+    dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING, &key);
+    dbus_message_iter_open_container(
+        &entry, DBUS_TYPE_VARIANT, DBUS_TYPE_STRING_AS_STRING, &variant);
+    dbus_message_iter_append_basic(&variant, DBUS_TYPE_STRING, &value);
+    dbus_message_iter_close_container(&entry, &variant);
+    dbus_message_iter_close_container(dict, &entry);
+}
+
+void appendUint32Option(DBusMessageIter* dict, const char* key, uint32_t value)
+{
+    DBusMessageIter entry;
+    DBusMessageIter variant;
+
+    dbus_message_iter_open_container(dict, DBUS_TYPE_DICT_ENTRY, nullptr, &entry);
+    dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING, &key);
+    dbus_message_iter_open_container(
+        &entry, DBUS_TYPE_VARIANT, DBUS_TYPE_UINT32_AS_STRING, &variant);
+    dbus_message_iter_append_basic(&variant, DBUS_TYPE_UINT32, &value);
+    dbus_message_iter_close_container(&entry, &variant);
+    dbus_message_iter_close_container(dict, &entry);
+}
+
+void appendBoolOption(DBusMessageIter* dict, const char* key, bool value)
+{
+    DBusMessageIter entry;
+    DBusMessageIter variant;
+    dbus_bool_t dbus_value = value ? TRUE : FALSE;
+
+    dbus_message_iter_open_container(dict, DBUS_TYPE_DICT_ENTRY, nullptr, &entry);
+    dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING, &key);
+    dbus_message_iter_open_container(
+        &entry, DBUS_TYPE_VARIANT, DBUS_TYPE_BOOLEAN_AS_STRING, &variant);
+    dbus_message_iter_append_basic(&variant, DBUS_TYPE_BOOLEAN, &dbus_value);
+    dbus_message_iter_close_container(&entry, &variant);
+    dbus_message_iter_close_container(dict, &entry);
+}
+
+// Reads the response code of an org.freedesktop.portal.Request.Response signal. 0 means success,
+// 1 means the user cancelled the dialog, 2 means the operation failed.
+bool responseCode(DBusMessage* response, uint32_t* code)
+{
+    DBusMessageIter iter;
+
+    if (!dbus_message_iter_init(response, &iter) ||
+        dbus_message_iter_get_arg_type(&iter) != DBUS_TYPE_UINT32)
+        return false;
+
+    dbus_message_iter_get_basic(&iter, code);
+    return true;
+}
+
+// Positions |value| at the content of the variant stored under |key| in the results vardict of a
+// Response signal. Returns false if the key is not present.
+bool findResult(DBusMessage* response, const char* key, DBusMessageIter* value)
+{
+    DBusMessageIter iter;
+
+    if (!dbus_message_iter_init(response, &iter) ||
+        dbus_message_iter_get_arg_type(&iter) != DBUS_TYPE_UINT32)
+        return false;
+
+    if (!dbus_message_iter_next(&iter) ||
+        dbus_message_iter_get_arg_type(&iter) != DBUS_TYPE_ARRAY)
+        return false;
+
+    DBusMessageIter dict;
+    dbus_message_iter_recurse(&iter, &dict);
+
+    while (dbus_message_iter_get_arg_type(&dict) == DBUS_TYPE_DICT_ENTRY)
+    {
+        DBusMessageIter entry;
+        dbus_message_iter_recurse(&dict, &entry);
+
+        const char* name = nullptr;
+        dbus_message_iter_get_basic(&entry, &name);
+
+        if (name && strcmp(name, key) == 0)
+        {
+            if (!dbus_message_iter_next(&entry) ||
+                dbus_message_iter_get_arg_type(&entry) != DBUS_TYPE_VARIANT)
+                return false;
+
+            dbus_message_iter_recurse(&entry, value);
+            return true;
+        }
+
+        dbus_message_iter_next(&dict);
+    }
+
+    return false;
+}
+
+std::string responseMatchRule(const std::string& request_path)
+{
+    return std::string("type='signal',interface='") + kRequestInterface +
+           "',member='Response',path='" + request_path + "'";
+}
+
+} // namespace
+
+ScreenCapturePortal::ScreenCapturePortal() = default;
+
+ScreenCapturePortal::~ScreenCapturePortal()
+{
+    if (pipewire_fd_ != -1)
+        close(pipewire_fd_);
+
+    if (connection_)
+    {
+        // Private connections must be closed before the last reference is dropped.
+        dbus_connection_close(connection_);
+        dbus_connection_unref(connection_);
+    }
+}
+
+bool ScreenCapturePortal::open()
+{
+    DBusError error;
+    dbus_error_init(&error);
+
+    connection_ = dbus_bus_get_private(DBUS_BUS_SESSION, &error);
+    if (!connection_)
+    {
+        LOG(LS_WARNING) << "Unable to connect to the session bus: "
+                        << (dbus_error_is_set(&error) ? error.message : "unknown error");
+        dbus_error_free(&error);
+        return false;
+    }
+
+    dbus_connection_set_exit_on_disconnect(connection_, FALSE);
+
+    const char* unique_name = dbus_bus_get_unique_name(connection_);
+    if (!unique_name || unique_name[0] != ':')
+    {
+        LOG(LS_WARNING) << "Invalid unique connection name";
+        return false;
+    }
+
+    // ":1.42" becomes "1_42", the form the portal uses in request object paths.
+    sender_token_ = unique_name + 1;
+    std::replace(sender_token_.begin(), sender_token_.end(), '.', '_');
+
+    return createSession() && selectSources() && startStream() && openPipewireRemote();
+}
+
+int ScreenCapturePortal::takePipewireFd()
+{
+    int fd = pipewire_fd_;
+    pipewire_fd_ = -1;
+    return fd;
+}
+
+bool ScreenCapturePortal::createSession()
+{
+    std::string token = nextToken();
+    std::string session_token = nextToken();
+
+    DBusMessage* message = dbus_message_new_method_call(
+        kPortalService, kPortalObject, kScreenCastInterface, "CreateSession");
+    if (!message)
+        return false;
+
+    DBusMessageIter args;
+    DBusMessageIter options;
+
+    dbus_message_iter_init_append(message, &args);
+    dbus_message_iter_open_container(&args, DBUS_TYPE_ARRAY, "{sv}", &options);
+    appendStringOption(&options, "handle_token", token.c_str());
+    appendStringOption(&options, "session_handle_token", session_token.c_str());
+    dbus_message_iter_close_container(&args, &options);
+
+    DBusMessage* response = callWithResponse(message, token, kMethodTimeoutMs);
+    if (!response)
+        return false;
+
+    uint32_t code;
+    DBusMessageIter value;
+
+    bool result = responseCode(response, &code) && code == 0 &&
+                  findResult(response, "session_handle", &value) &&
+                  dbus_message_iter_get_arg_type(&value) == DBUS_TYPE_STRING;
+    if (result)
+    {
+        const char* handle = nullptr;
+        dbus_message_iter_get_basic(&value, &handle);
+        session_handle_ = handle;
+    }
+    else
+    {
+        LOG(LS_WARNING) << "CreateSession failed";
+    }
+
+    dbus_message_unref(response);
+    return result;
+}
+
+bool ScreenCapturePortal::selectSources()
+{
+    std::string token = nextToken();
+
+    DBusMessage* message = dbus_message_new_method_call(
+        kPortalService, kPortalObject, kScreenCastInterface, "SelectSources");
+    if (!message)
+        return false;
+
+    const char* session = session_handle_.c_str();
+
+    DBusMessageIter args;
+    DBusMessageIter options;
+
+    dbus_message_iter_init_append(message, &args);
+    dbus_message_iter_append_basic(&args, DBUS_TYPE_OBJECT_PATH, &session);
+    dbus_message_iter_open_container(&args, DBUS_TYPE_ARRAY, "{sv}", &options);
+    appendStringOption(&options, "handle_token", token.c_str());
+    appendUint32Option(&options, "types", kSourceTypeMonitor);
+    appendBoolOption(&options, "multiple", false);
+    // The compositor composites the cursor into the stream, so no separate cursor channel is
+    // needed on Wayland.
+    appendUint32Option(&options, "cursor_mode", kCursorModeEmbedded);
+    dbus_message_iter_close_container(&args, &options);
+
+    DBusMessage* response = callWithResponse(message, token, kMethodTimeoutMs);
+    if (!response)
+        return false;
+
+    uint32_t code;
+    bool result = responseCode(response, &code) && code == 0;
+    if (!result)
+        LOG(LS_WARNING) << "SelectSources failed";
+
+    dbus_message_unref(response);
+    return result;
+}
+
+bool ScreenCapturePortal::startStream()
+{
+    std::string token = nextToken();
+
+    DBusMessage* message = dbus_message_new_method_call(
+        kPortalService, kPortalObject, kScreenCastInterface, "Start");
+    if (!message)
+        return false;
+
+    const char* session = session_handle_.c_str();
+    const char* parent_window = "";
+
+    DBusMessageIter args;
+    DBusMessageIter options;
+
+    dbus_message_iter_init_append(message, &args);
+    dbus_message_iter_append_basic(&args, DBUS_TYPE_OBJECT_PATH, &session);
+    dbus_message_iter_append_basic(&args, DBUS_TYPE_STRING, &parent_window);
+    dbus_message_iter_open_container(&args, DBUS_TYPE_ARRAY, "{sv}", &options);
+    appendStringOption(&options, "handle_token", token.c_str());
+    dbus_message_iter_close_container(&args, &options);
+
+    DBusMessage* response = callWithResponse(message, token, kStartTimeoutMs);
+    if (!response)
+        return false;
+
+    uint32_t code;
+    DBusMessageIter value;
+    bool result = false;
+
+    // The "streams" result is an array of (node_id, properties) structures; one stream because
+    // SelectSources did not ask for multiple sources.
+    if (responseCode(response, &code) && code == 0 &&
+        findResult(response, "streams", &value) &&
+        dbus_message_iter_get_arg_type(&value) == DBUS_TYPE_ARRAY)
+    {
+        DBusMessageIter streams;
+        dbus_message_iter_recurse(&value, &streams);
+
+        if (dbus_message_iter_get_arg_type(&streams) == DBUS_TYPE_STRUCT)
+        {
+            DBusMessageIter stream;
+            dbus_message_iter_recurse(&streams, &stream);
+
+            if (dbus_message_iter_get_arg_type(&stream) == DBUS_TYPE_UINT32)
+            {
+                dbus_message_iter_get_basic(&stream, &stream_node_id_);
+                result = true;
+            }
+        }
+    }
+
+    if (!result)
+        LOG(LS_WARNING) << "Start failed; capture was probably denied by the user";
+
+    dbus_message_unref(response);
+    return result;
+}
+
+bool ScreenCapturePortal::openPipewireRemote()
+{
+    DBusMessage* message = dbus_message_new_method_call(
+        kPortalService, kPortalObject, kScreenCastInterface, "OpenPipeWireRemote");
+    if (!message)
+        return false;
+
+    const char* session = session_handle_.c_str();
+
+    DBusMessageIter args;
+    DBusMessageIter options;
+
+    dbus_message_iter_init_append(message, &args);
+    dbus_message_iter_append_basic(&args, DBUS_TYPE_OBJECT_PATH, &session);
+    dbus_message_iter_open_container(&args, DBUS_TYPE_ARRAY, "{sv}", &options);
+    dbus_message_iter_close_container(&args, &options);
+
+    DBusError error;
+    dbus_error_init(&error);
+
+    // OpenPipeWireRemote replies directly with the file descriptor, without a Request object.
+    DBusMessage* reply = dbus_connection_send_with_reply_and_block(
+        connection_, message, kMethodTimeoutMs, &error);
+    dbus_message_unref(message);
+
+    if (!reply)
+    {
+        LOG(LS_WARNING) << "OpenPipeWireRemote failed: "
+                        << (dbus_error_is_set(&error) ? error.message : "unknown error");
+        dbus_error_free(&error);
+        return false;
+    }
+
+    bool result = dbus_message_get_args(
+        reply, nullptr, DBUS_TYPE_UNIX_FD, &pipewire_fd_, DBUS_TYPE_INVALID);
+    if (!result)
+        LOG(LS_WARNING) << "No file descriptor in OpenPipeWireRemote reply";
+
+    dbus_message_unref(reply);
+    return result;
+}
+
+DBusMessage* ScreenCapturePortal::callWithResponse(
+    DBusMessage* message, const std::string& handle_token, int timeout_ms)
+{
+    // The Response signal may be emitted right after the method returns, so the match must be in
+    // place before the method call is sent.
+    std::string request_path = requestPath(handle_token);
+    std::string match = responseMatchRule(request_path);
+
+    dbus_bus_add_match(connection_, match.c_str(), nullptr);
+    dbus_connection_flush(connection_);
+
+    DBusError error;
+    dbus_error_init(&error);
+
+    DBusMessage* reply = dbus_connection_send_with_reply_and_block(
+        connection_, message, kMethodTimeoutMs, &error);
+    dbus_message_unref(message);
+
+    if (!reply)
+    {
+        LOG(LS_WARNING) << "Portal call failed: "
+                        << (dbus_error_is_set(&error) ? error.message : "unknown error");
+        dbus_error_free(&error);
+        dbus_bus_remove_match(connection_, match.c_str(), nullptr);
+        return nullptr;
+    }
+
+    // Old portals ignore handle_token and the predicted request path; follow the path from the
+    // reply in that case.
+    const char* handle = nullptr;
+    if (dbus_message_get_args(reply, nullptr,
+                              DBUS_TYPE_OBJECT_PATH, &handle, DBUS_TYPE_INVALID) &&
+        handle && request_path != handle)
+    {
+        LOG(LS_WARNING) << "Request handle does not match the predicted path";
+
+        dbus_bus_remove_match(connection_, match.c_str(), nullptr);
+        request_path = handle;
+        match = responseMatchRule(request_path);
+        dbus_bus_add_match(connection_, match.c_str(), nullptr);
+        dbus_connection_flush(connection_);
+    }
+
+    dbus_message_unref(reply);
+
+    std::chrono::steady_clock::time_point deadline =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+
+    while (std::chrono::steady_clock::now() < deadline)
+    {
+        if (!dbus_connection_read_write(connection_, 100))
+        {
+            LOG(LS_WARNING) << "Session bus connection closed";
+            break;
+        }
+
+        while (DBusMessage* incoming = dbus_connection_pop_message(connection_))
+        {
+            const char* path = dbus_message_get_path(incoming);
+
+            if (dbus_message_is_signal(incoming, kRequestInterface, "Response") &&
+                path && request_path == path)
+            {
+                dbus_bus_remove_match(connection_, match.c_str(), nullptr);
+                return incoming;
+            }
+
+            dbus_message_unref(incoming);
+        }
+    }
+
+    LOG(LS_WARNING) << "Timeout waiting for portal response";
+    dbus_bus_remove_match(connection_, match.c_str(), nullptr);
+    return nullptr;
+}
+
+std::string ScreenCapturePortal::requestPath(const std::string& handle_token) const
+{
+    return "/org/freedesktop/portal/desktop/request/" + sender_token_ + "/" + handle_token;
+}
+
+std::string ScreenCapturePortal::nextToken()
+{
+    return "aspia" + std::to_string(++token_counter_);
+}
+
+} // namespace base
+
+#endif // defined(USE_PIPEWIRE)
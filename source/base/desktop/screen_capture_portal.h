@@ -0,0 +1,92 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__DESKTOP__SCREEN_CAPTURE_PORTAL_H
+#define BASE__DESKTOP__SCREEN_CAPTURE_PORTAL_H
+
+#include "base/macros_magic.h"
+
+#if defined(USE_PIPEWIRE)
+
+#include <cstdint>
+#include <string>
+
+struct DBusConnection;
+struct DBusMessage;
+
+namespace base {
+
+// Performs the org.freedesktop.portal.ScreenCast handshake with xdg-desktop-portal. The portal
+// is the only supported way to capture the screen of a Wayland session: the compositor exports
+// the desktop as a PipeWire video stream and hands us the stream node id together with a file
+// descriptor of an open PipeWire connection.
+class ScreenCapturePortal
+{
+public:
+    ScreenCapturePortal();
+    ~ScreenCapturePortal();
+
+    // Runs the CreateSession / SelectSources / Start / OpenPipeWireRemote sequence. Blocks until
+    // the portal replies; Start may show a dialog and waits for the user to confirm the capture.
+    // Returns false if the portal is not available or the user denied the request.
+    bool open();
+
+    // Id of the PipeWire node exporting the desktop. Valid after a successful open().
+    uint32_t streamNodeId() const { return stream_node_id_; }
+
+    // Returns the file descriptor of the PipeWire connection opened by the portal and transfers
+    // its ownership to the caller. Valid once after a successful open().
+    int takePipewireFd();
+
+private:
+    // Steps of the handshake, in the order open() runs them.
+    bool createSession();
+    bool selectSources();
+    bool startStream();
+    bool openPipewireRemote();
+
+    // Sends |message| and waits for the org.freedesktop.portal.Request.Response signal that
+    // carries the result of the operation. Returns the signal message or nullptr on failure;
+    // the caller owns the returned message. |handle_token| must match the token placed into the
+    // options of |message|.
+    DBusMessage* callWithResponse(DBusMessage* message,
+                                  const std::string& handle_token,
+                                  int timeout_ms);
+
+    std::string requestPath(const std::string& handle_token) const;
+    std::string nextToken();
+
+    DBusConnection* connection_ = nullptr;
+
+    // Unique connection name with the characters D-Bus forbids in object paths replaced, as
+    // required by the portal spec to predict request object paths.
+    std::string sender_token_;
+
+    std::string session_handle_;
+    uint32_t stream_node_id_ = 0;
+    int pipewire_fd_ = -1;
+    int token_counter_ = 0;
+
+    DISALLOW_COPY_AND_ASSIGN(ScreenCapturePortal);
+};
+
+} // namespace base
+
+#endif // defined(USE_PIPEWIRE)
+
+#endif // BASE__DESKTOP__SCREEN_CAPTURE_PORTAL_H
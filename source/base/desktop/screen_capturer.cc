@@ -32,4 +32,14 @@ SharedMemoryFactory* ScreenCapturer::sharedMemoryFactory() const
     return shared_memory_factory_;
 }
 
+void ScreenCapturer::setLowMemoryMode(bool enable)
+{
+    low_memory_mode_ = enable;
+}
+
+bool ScreenCapturer::lowMemoryMode() const
+{
+    return low_memory_mode_;
+}
+
 } // namespace base
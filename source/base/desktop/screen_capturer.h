@@ -20,6 +20,7 @@
 #define BASE__DESKTOP__SCREEN_CAPTURER_H
 
 #include "base/desktop/frame.h"
+#include "base/logging.h"
 
 #include <memory>
 #include <string>
@@ -59,6 +60,12 @@ public:
     void setSharedMemoryFactory(SharedMemoryFactory* shared_memory_factory);
     SharedMemoryFactory* sharedMemoryFactory() const;
 
+    // In low memory mode the capturer keeps a single recycled frame buffer and detects changes
+    // on a downscaled shadow of the screen instead of a second full-resolution frame. Intended
+    // for hosts where the agent footprint matters more than damage granularity.
+    void setLowMemoryMode(bool enable);
+    bool lowMemoryMode() const;
+
 protected:
     friend class ScreenCapturerWrapper;
     virtual void reset() = 0;
@@ -69,6 +76,16 @@ protected:
     public:
         FrameQueue() = default;
 
+        // Three buffers allow the consumer to read one frame while the next one is captured
+        // and one more is kept ready for the handoff. With two buffers the capturer would
+        // overwrite a frame that may still be in use on the other side of the shared memory.
+        static const int kMaxLength = 3;
+
+        // Limits rotation to the first |length| buffers (1..kMaxLength). Capturers running in
+        // low memory mode shorten the queue to trade pipelining for footprint. Changing the
+        // length drops all buffers.
+        void setMaxLength(int length);
+
         // Moves to the next frame in the queue, moving the 'current' frame to become the
         // 'previous' one.
         void moveToNextFrame();
@@ -82,21 +99,34 @@ protected:
     private:
         // Index of the current frame.
         int current_ = 0;
+        int length_ = kMaxLength;
 
-        static const int kQueueLength = 2;
-        std::unique_ptr<FrameType> frames_[kQueueLength];
+        std::unique_ptr<FrameType> frames_[kMaxLength];
 
         DISALLOW_COPY_AND_ASSIGN(FrameQueue);
     };
 
 private:
     SharedMemoryFactory* shared_memory_factory_ = nullptr;
+    bool low_memory_mode_ = false;
 };
 
+template <typename FrameType>
+void ScreenCapturer::FrameQueue<FrameType>::setMaxLength(int length)
+{
+    DCHECK(length >= 1 && length <= kMaxLength);
+
+    if (length_ == length)
+        return;
+
+    length_ = length;
+    reset();
+}
+
 template <typename FrameType>
 void ScreenCapturer::FrameQueue<FrameType>::moveToNextFrame()
 {
-    current_ = (current_ + 1) % kQueueLength;
+    current_ = (current_ + 1) % length_;
 }
 
 template <typename FrameType>
@@ -108,7 +138,7 @@ void ScreenCapturer::FrameQueue<FrameType>::replaceCurrentFrame(std::unique_ptr<
 template <typename FrameType>
 void ScreenCapturer::FrameQueue<FrameType>::reset()
 {
-    for (int i = 0; i < kQueueLength; ++i)
+    for (int i = 0; i < kMaxLength; ++i)
         frames_[i].reset();
     current_ = 0;
 }
@@ -122,7 +152,7 @@ FrameType* ScreenCapturer::FrameQueue<FrameType>::currentFrame() const
 template <typename FrameType>
 FrameType* ScreenCapturer::FrameQueue<FrameType>::previousFrame() const
 {
-    return frames_[(current_ + kQueueLength - 1) % kQueueLength].get();
+    return frames_[(current_ + length_ - 1) % length_].get();
 }
 
 } // namespace base
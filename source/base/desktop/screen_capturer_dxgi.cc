@@ -91,7 +91,7 @@ int indexFromScreenId(ScreenCapturer::ScreenId id, const std::vector<std::wstrin
 } // namespace
 
 ScreenCapturerDxgi::ScreenCapturerDxgi()
-    : controller_(std::make_shared<DxgiDuplicatorController>())
+    : controller_(DxgiDuplicatorController::instance())
 {
     // Nothing
 }
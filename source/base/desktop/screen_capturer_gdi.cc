@@ -23,6 +23,7 @@
 #include "base/desktop/win/screen_capture_utils.h"
 #include "base/desktop/frame_dib.h"
 #include "base/desktop/differ.h"
+#include "base/desktop/shadow_differ.h"
 #include "base/win/scoped_select_object.h"
 
 #include <dwmapi.h>
@@ -79,10 +80,15 @@ void ScreenCapturerGdi::reset()
     // Release GDI resources otherwise SetThreadDesktop will fail.
     desktop_dc_.close();
     memory_dc_.reset();
+    shadow_differ_.reset();
 }
 
 const Frame* ScreenCapturerGdi::captureImage()
 {
+    // In low memory mode only two buffers rotate: one may still be read by the host through
+    // the shared memory while the other is captured into. The full-resolution history frame
+    // of the differ is replaced by the shadow differ.
+    queue_.setMaxLength(lowMemoryMode() ? 2 : FrameQueue<Frame>::kMaxLength);
     queue_.moveToNextFrame();
 
     if (!prepareCaptureResources())
@@ -130,7 +136,14 @@ const Frame* ScreenCapturerGdi::captureImage()
     current->setDpi(Point(GetDeviceCaps(desktop_dc_, LOGPIXELSX),
                           GetDeviceCaps(desktop_dc_, LOGPIXELSY)));
 
-    if (!previous || previous->size() != current->size())
+    if (lowMemoryMode())
+    {
+        if (!shadow_differ_)
+            shadow_differ_ = std::make_unique<ShadowDiffer>();
+
+        shadow_differ_->calcDirtyRegion(current, current->updatedRegion());
+    }
+    else if (!previous || previous->size() != current->size())
     {
         differ_ = std::make_unique<Differ>(screen_rect.size());
         current->updatedRegion()->addRect(Rect::makeSize(screen_rect.size()));
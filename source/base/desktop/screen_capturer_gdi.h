@@ -26,6 +26,7 @@
 namespace base {
 
 class Differ;
+class ShadowDiffer;
 class SharedMemoryFactory;
 
 class ScreenCapturerGdi : public ScreenCapturer
@@ -56,6 +57,7 @@ private:
     Rect desktop_dc_rect_;
 
     std::unique_ptr<Differ> differ_;
+    std::unique_ptr<ShadowDiffer> shadow_differ_;
     win::ScopedGetDC desktop_dc_;
     win::ScopedCreateDC memory_dc_;
 
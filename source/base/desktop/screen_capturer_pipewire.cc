@@ -0,0 +1,446 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/desktop/screen_capturer_pipewire.h"
+
+#if defined(USE_PIPEWIRE)
+
+#include "base/logging.h"
+#include "base/desktop/differ.h"
+#include "base/desktop/frame_aligned.h"
+#include "base/desktop/screen_capture_portal.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <linux/dma-buf.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+
+namespace base {
+
+namespace {
+
+const size_t kFrameAlignment = 32;
+
+// Brackets CPU reads of a dmabuf so the kernel can flush caches of the device that rendered it.
+void syncDmabuf(int fd, uint64_t flags)
+{
+    struct dma_buf_sync sync = {};
+    sync.flags = flags;
+
+    while (ioctl(fd, DMA_BUF_IOCTL_SYNC, &sync) == -1 && (errno == EINTR || errno == EAGAIN))
+    {
+        // Interrupted, try again.
+    }
+}
+
+const spa_pod* buildFormat(spa_pod_builder* builder, bool with_dmabuf_modifier)
+{
+    spa_rectangle default_size = SPA_RECTANGLE(1920, 1080);
+    spa_rectangle min_size = SPA_RECTANGLE(1, 1);
+    spa_rectangle max_size = SPA_RECTANGLE(16384, 16384);
+
+    spa_fraction default_rate = SPA_FRACTION(30, 1);
+    spa_fraction min_rate = SPA_FRACTION(0, 1);
+    spa_fraction max_rate = SPA_FRACTION(120, 1);
+
+    spa_pod_frame frame;
+
+    spa_pod_builder_push_object(builder, &frame, SPA_TYPE_OBJECT_Format, SPA_PARAM_EnumFormat);
+
+    // BGRx and BGRA match the Frame pixel layout, so received rows are copied without
+    // conversion.
+    spa_pod_builder_add(builder,
+        SPA_FORMAT_mediaType, SPA_POD_Id(SPA_MEDIA_TYPE_video),
+        SPA_FORMAT_mediaSubtype, SPA_POD_Id(SPA_MEDIA_SUBTYPE_raw),
+        SPA_FORMAT_VIDEO_format, SPA_POD_CHOICE_ENUM_Id(
+            3, SPA_VIDEO_FORMAT_BGRx, SPA_VIDEO_FORMAT_BGRx, SPA_VIDEO_FORMAT_BGRA),
+        0);
+
+    if (with_dmabuf_modifier)
+    {
+        // Advertising a modifier opts the stream into dmabuf buffers. Only DRM_FORMAT_MOD_LINEAR
+        // (0) is offered because the frames are read with the CPU through a plain mapping.
+        spa_pod_builder_prop(builder, SPA_FORMAT_VIDEO_modifier, SPA_POD_PROP_FLAG_MANDATORY);
+        spa_pod_builder_long(builder, 0);
+    }
+
+    spa_pod_builder_add(builder,
+        SPA_FORMAT_VIDEO_size,
+        SPA_POD_CHOICE_RANGE_Rectangle(&default_size, &min_size, &max_size),
+        SPA_FORMAT_VIDEO_framerate,
+        SPA_POD_CHOICE_RANGE_Fraction(&default_rate, &min_rate, &max_rate),
+        0);
+
+    return reinterpret_cast<const spa_pod*>(spa_pod_builder_pop(builder, &frame));
+}
+
+} // namespace
+
+// static
+const pw_stream_events ScreenCapturerPipewire::kStreamEvents = []()
+{
+    pw_stream_events events = {};
+
+    events.version = PW_VERSION_STREAM_EVENTS;
+    events.state_changed = ScreenCapturerPipewire::onStreamStateChanged;
+    events.param_changed = ScreenCapturerPipewire::onStreamParamChanged;
+    events.process = ScreenCapturerPipewire::onStreamProcess;
+
+    return events;
+}();
+
+ScreenCapturerPipewire::ScreenCapturerPipewire()
+{
+    // Nothing
+}
+
+ScreenCapturerPipewire::~ScreenCapturerPipewire()
+{
+    if (loop_)
+    {
+        pw_thread_loop_lock(loop_);
+
+        if (stream_)
+        {
+            pw_stream_disconnect(stream_);
+            pw_stream_destroy(stream_);
+        }
+
+        if (core_)
+            pw_core_disconnect(core_);
+
+        if (context_)
+            pw_context_destroy(context_);
+
+        pw_thread_loop_unlock(loop_);
+
+        pw_thread_loop_stop(loop_);
+        pw_thread_loop_destroy(loop_);
+    }
+}
+
+bool ScreenCapturerPipewire::start()
+{
+    portal_ = std::make_unique<ScreenCapturePortal>();
+
+    if (!portal_->open())
+        return false;
+
+    pw_init(nullptr, nullptr);
+
+    loop_ = pw_thread_loop_new("aspia-capture", nullptr);
+    if (!loop_)
+        return false;
+
+    if (pw_thread_loop_start(loop_) < 0)
+    {
+        LOG(LS_WARNING) << "Unable to start PipeWire thread loop";
+        return false;
+    }
+
+    pw_thread_loop_lock(loop_);
+
+    context_ = pw_context_new(pw_thread_loop_get_loop(loop_), nullptr, 0);
+    if (context_)
+    {
+        // The descriptor was opened by the portal; connecting through it gives access to the
+        // otherwise restricted desktop stream. The context takes ownership of the descriptor.
+        core_ = pw_context_connect_fd(context_, portal_->takePipewireFd(), nullptr, 0);
+    }
+
+    if (!core_)
+    {
+        LOG(LS_WARNING) << "Unable to connect to PipeWire";
+        pw_thread_loop_unlock(loop_);
+        return false;
+    }
+
+    stream_ = pw_stream_new(core_, "aspia-screen-capture",
+                            pw_properties_new(PW_KEY_MEDIA_TYPE, "Video",
+                                              PW_KEY_MEDIA_CATEGORY, "Capture",
+                                              PW_KEY_MEDIA_ROLE, "Screen",
+                                              nullptr));
+    if (!stream_)
+    {
+        pw_thread_loop_unlock(loop_);
+        return false;
+    }
+
+    pw_stream_add_listener(stream_, &stream_listener_, &kStreamEvents, this);
+
+    // Two format candidates: the first requires the linear dmabuf layout, the second has no
+    // modifier and keeps shared memory buffers as a fallback.
+    uint8_t pod_buffer[1024];
+    spa_pod_builder builder = SPA_POD_BUILDER_INIT(pod_buffer, sizeof(pod_buffer));
+
+    const spa_pod* params[2];
+    params[0] = buildFormat(&builder, true);
+    params[1] = buildFormat(&builder, false);
+
+    int result = pw_stream_connect(
+        stream_, PW_DIRECTION_INPUT, portal_->streamNodeId(),
+        static_cast<pw_stream_flags>(PW_STREAM_FLAG_AUTOCONNECT | PW_STREAM_FLAG_MAP_BUFFERS),
+        params, 2);
+
+    pw_thread_loop_unlock(loop_);
+
+    if (result < 0)
+    {
+        LOG(LS_WARNING) << "Unable to connect PipeWire stream: " << result;
+        return false;
+    }
+
+    return true;
+}
+
+int ScreenCapturerPipewire::screenCount()
+{
+    // The portal exports the picked screen as a single composited stream.
+    return stream_ ? 1 : 0;
+}
+
+bool ScreenCapturerPipewire::screenList(ScreenList* screens)
+{
+    if (!stream_)
+        return false;
+
+    screens->push_back({ kFullDesktopScreenId, std::string(), true });
+    return true;
+}
+
+bool ScreenCapturerPipewire::selectScreen(ScreenId screen_id)
+{
+    return screen_id == kFullDesktopScreenId;
+}
+
+const Frame* ScreenCapturerPipewire::captureFrame(Error* error)
+{
+    DCHECK(error);
+
+    queue_.moveToNextFrame();
+
+    bool updated;
+
+    {
+        std::scoped_lock lock(frame_lock_);
+
+        if (stream_failed_)
+        {
+            LOG(LS_ERROR) << "PipeWire stream is not running";
+            *error = Error::PERMANENT;
+            return nullptr;
+        }
+
+        if (frame_size_.isEmpty())
+        {
+            // The stream has not delivered its first buffer yet.
+            *error = Error::TEMPORARY;
+            return nullptr;
+        }
+
+        if (!queue_.currentFrame() || queue_.currentFrame()->size() != frame_size_)
+        {
+            std::unique_ptr<Frame> frame = FrameAligned::create(frame_size_, kFrameAlignment);
+            if (!frame)
+            {
+                LOG(LS_WARNING) << "Failed to create frame buffer";
+                *error = Error::PERMANENT;
+                return nullptr;
+            }
+
+            queue_.replaceCurrentFrame(std::move(frame));
+        }
+
+        queue_.currentFrame()->copyPixelsFrom(
+            frame_data_.data(), frame_stride_, Rect::makeSize(frame_size_));
+
+        updated = frame_updated_;
+        frame_updated_ = false;
+    }
+
+    Frame* current = queue_.currentFrame();
+    Frame* previous = queue_.previousFrame();
+
+    current->updatedRegion()->clear();
+
+    if (!previous || previous->size() != current->size())
+    {
+        differ_ = std::make_unique<Differ>(current->size());
+        current->updatedRegion()->addRect(Rect::makeSize(current->size()));
+    }
+    else if (updated)
+    {
+        differ_->calcDirtyRegion(previous->frameData(),
+                                 current->frameData(),
+                                 current->updatedRegion());
+    }
+
+    *error = Error::SUCCEEDED;
+    return current;
+}
+
+void ScreenCapturerPipewire::reset()
+{
+    // Force a full update at the next capture.
+    queue_.reset();
+    differ_.reset();
+}
+
+// static
+void ScreenCapturerPipewire::onStreamStateChanged(
+    void* data, pw_stream_state /* old_state */, pw_stream_state state, const char* error)
+{
+    ScreenCapturerPipewire* self = reinterpret_cast<ScreenCapturerPipewire*>(data);
+
+    LOG(LS_INFO) << "PipeWire stream state: " << pw_stream_state_as_string(state);
+
+    if (state == PW_STREAM_STATE_ERROR || state == PW_STREAM_STATE_UNCONNECTED)
+    {
+        if (error)
+            LOG(LS_ERROR) << "PipeWire stream error: " << error;
+
+        std::scoped_lock lock(self->frame_lock_);
+        self->stream_failed_ = true;
+    }
+}
+
+// static
+void ScreenCapturerPipewire::onStreamParamChanged(
+    void* data, uint32_t id, const struct spa_pod* param)
+{
+    ScreenCapturerPipewire* self = reinterpret_cast<ScreenCapturerPipewire*>(data);
+
+    if (!param || id != SPA_PARAM_Format)
+        return;
+
+    uint32_t media_type;
+    uint32_t media_subtype;
+
+    if (spa_format_parse(param, &media_type, &media_subtype) < 0 ||
+        media_type != SPA_MEDIA_TYPE_video || media_subtype != SPA_MEDIA_SUBTYPE_raw)
+        return;
+
+    if (spa_format_video_raw_parse(param, &self->stream_format_) < 0)
+        return;
+
+    LOG(LS_INFO) << "PipeWire stream format: " << self->stream_format_.size.width << "x"
+                 << self->stream_format_.size.height;
+
+    // Accept dmabuf as well as plain memory buffers. MemFd and MemPtr buffers are mapped by the
+    // library because the stream is connected with PW_STREAM_FLAG_MAP_BUFFERS; dmabufs are
+    // mapped in processBuffer().
+    uint8_t pod_buffer[1024];
+    spa_pod_builder builder = SPA_POD_BUILDER_INIT(pod_buffer, sizeof(pod_buffer));
+
+    const spa_pod* params[1];
+    params[0] = reinterpret_cast<const spa_pod*>(spa_pod_builder_add_object(&builder,
+        SPA_TYPE_OBJECT_ParamBuffers, SPA_PARAM_Buffers,
+        SPA_PARAM_BUFFERS_dataType, SPA_POD_CHOICE_FLAGS_Int(
+            (1 << SPA_DATA_DmaBuf) | (1 << SPA_DATA_MemFd) | (1 << SPA_DATA_MemPtr))));
+
+    pw_stream_update_params(self->stream_, params, 1);
+}
+
+// static
+void ScreenCapturerPipewire::onStreamProcess(void* data)
+{
+    ScreenCapturerPipewire* self = reinterpret_cast<ScreenCapturerPipewire*>(data);
+
+    pw_buffer* buffer = pw_stream_dequeue_buffer(self->stream_);
+    if (!buffer)
+        return;
+
+    // Drain the queue so that only the most recent buffer is copied.
+    while (pw_buffer* next = pw_stream_dequeue_buffer(self->stream_))
+    {
+        pw_stream_queue_buffer(self->stream_, buffer);
+        buffer = next;
+    }
+
+    self->processBuffer(buffer);
+    pw_stream_queue_buffer(self->stream_, buffer);
+}
+
+void ScreenCapturerPipewire::processBuffer(pw_buffer* buffer)
+{
+    const spa_data& data = buffer->buffer->datas[0];
+    const spa_chunk* chunk = data.chunk;
+
+    Size size(static_cast<int>(stream_format_.size.width),
+              static_cast<int>(stream_format_.size.height));
+    if (size.isEmpty() || !chunk)
+        return;
+
+    int stride = chunk->stride;
+    if (stride <= 0)
+        stride = size.width() * Frame::kBytesPerPixel;
+
+    const uint8_t* pixels = nullptr;
+    void* mapped = nullptr;
+    size_t mapped_size = 0;
+
+    if (data.data)
+    {
+        // Shared memory buffer, already mapped by the library.
+        pixels = static_cast<const uint8_t*>(data.data) + chunk->offset;
+    }
+    else if (data.type == SPA_DATA_DmaBuf)
+    {
+        // The linear layout was made mandatory during format negotiation, so the dmabuf is
+        // readable through a plain mapping.
+        mapped_size = data.maxsize + data.mapoffset;
+
+        mapped = mmap(nullptr, mapped_size, PROT_READ, MAP_SHARED, data.fd, 0);
+        if (mapped == MAP_FAILED)
+        {
+            LOG(LS_WARNING) << "Unable to map dmabuf: " << errno;
+            return;
+        }
+
+        syncDmabuf(data.fd, DMA_BUF_SYNC_START | DMA_BUF_SYNC_READ);
+        pixels = static_cast<const uint8_t*>(mapped) + data.mapoffset + chunk->offset;
+    }
+
+    if (pixels)
+    {
+        std::scoped_lock lock(frame_lock_);
+
+        frame_size_ = size;
+        frame_stride_ = stride;
+        frame_data_.resize(static_cast<size_t>(stride) * size.height());
+
+        size_t copy_size = frame_data_.size();
+        if (chunk->size > 0 && chunk->size < copy_size)
+            copy_size = chunk->size;
+
+        memcpy(frame_data_.data(), pixels, copy_size);
+        frame_updated_ = true;
+    }
+
+    if (mapped)
+    {
+        syncDmabuf(data.fd, DMA_BUF_SYNC_END | DMA_BUF_SYNC_READ);
+        munmap(mapped, mapped_size);
+    }
+}
+
+} // namespace base
+
+#endif // defined(USE_PIPEWIRE)
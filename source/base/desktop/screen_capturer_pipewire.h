@@ -0,0 +1,105 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__DESKTOP__SCREEN_CAPTURER_PIPEWIRE_H
+#define BASE__DESKTOP__SCREEN_CAPTURER_PIPEWIRE_H
+
+#include "base/desktop/screen_capturer.h"
+
+#if defined(USE_PIPEWIRE)
+
+#include <mutex>
+#include <vector>
+
+#include <pipewire/pipewire.h>
+#include <spa/param/video/format-utils.h>
+
+namespace base {
+
+class Differ;
+class ScreenCapturePortal;
+
+// Captures the desktop of a Wayland session from the PipeWire video stream exported by the
+// compositor through xdg-desktop-portal. Buffers are negotiated as dmabuf with a linear layout
+// when the compositor supports it, so frames reach us without a CPU copy on the producer side;
+// otherwise the stream falls back to shared memory buffers.
+class ScreenCapturerPipewire : public ScreenCapturer
+{
+public:
+    ScreenCapturerPipewire();
+    ~ScreenCapturerPipewire() override;
+
+    // Runs the portal handshake and connects the PipeWire stream. Blocks until the portal
+    // replies (Start waits for the user to confirm the capture). Returns false if the portal or
+    // PipeWire is not available or the user denied the request; the caller should fall back to
+    // another capturer.
+    bool start();
+
+    // ScreenCapturer implementation.
+    int screenCount() override;
+    bool screenList(ScreenList* screens) override;
+    bool selectScreen(ScreenId screen_id) override;
+    const Frame* captureFrame(Error* error) override;
+
+protected:
+    // ScreenCapturer implementation.
+    void reset() override;
+
+private:
+    static void onStreamStateChanged(
+        void* data, pw_stream_state old_state, pw_stream_state state, const char* error);
+    static void onStreamParamChanged(void* data, uint32_t id, const struct spa_pod* param);
+    static void onStreamProcess(void* data);
+
+    void processBuffer(pw_buffer* buffer);
+
+    static const pw_stream_events kStreamEvents;
+
+    std::unique_ptr<ScreenCapturePortal> portal_;
+
+    // All PipeWire objects are owned by the thread loop and must only be touched while the loop
+    // lock is held.
+    pw_thread_loop* loop_ = nullptr;
+    pw_context* context_ = nullptr;
+    pw_core* core_ = nullptr;
+    pw_stream* stream_ = nullptr;
+    spa_hook stream_listener_ = {};
+
+    // Stream format negotiated in onStreamParamChanged; accessed from the loop thread only.
+    spa_video_info_raw stream_format_ = {};
+
+    // Most recent frame delivered by the loop thread, picked up by captureFrame() on the capture
+    // thread. Guarded by frame_lock_.
+    std::mutex frame_lock_;
+    std::vector<uint8_t> frame_data_;
+    Size frame_size_;
+    int frame_stride_ = 0;
+    bool frame_updated_ = false;
+    bool stream_failed_ = false;
+
+    std::unique_ptr<Differ> differ_;
+    FrameQueue<Frame> queue_;
+
+    DISALLOW_COPY_AND_ASSIGN(ScreenCapturerPipewire);
+};
+
+} // namespace base
+
+#endif // defined(USE_PIPEWIRE)
+
+#endif // BASE__DESKTOP__SCREEN_CAPTURER_PIPEWIRE_H
@@ -19,10 +19,13 @@
 #include "base/desktop/screen_capturer_wrapper.h"
 
 #include "base/logging.h"
+#include "base/trace_log.h"
 #include "base/desktop/cursor_capturer.h"
 #include "base/desktop/desktop_environment.h"
+#include "base/desktop/frame_simple.h"
 #include "base/desktop/mouse_cursor.h"
 #include "base/desktop/power_save_blocker.h"
+#include "base/desktop/shared_memory_frame.h"
 #include "base/ipc/shared_memory_factory.h"
 
 #if defined(OS_WIN)
@@ -31,9 +34,17 @@
 #include "base/desktop/screen_capturer_gdi.h"
 #include "base/win/windows_version.h"
 #elif defined(OS_LINUX)
+#include "base/desktop/cursor_capturer_x11.h"
+#include "base/desktop/screen_capturer_x11.h"
+#if defined(USE_PIPEWIRE)
+#include "base/desktop/screen_capturer_pipewire.h"
+#include <cstdlib>
+#endif
 #else
 #endif
 
+#include <chrono>
+
 namespace base {
 
 ScreenCapturerWrapper::ScreenCapturerWrapper(Delegate* delegate)
@@ -58,6 +69,10 @@ void ScreenCapturerWrapper::selectScreen(ScreenCapturer::ScreenId screen_id)
 
     if (screen_capturer_->selectScreen(screen_id))
     {
+        // The region was specified in the coordinates of the previous screen.
+        capture_region_ = Rect();
+        region_queue_.reset();
+
         ScreenCapturer::ScreenList screens;
 
         if (screen_capturer_->screenList(&screens))
@@ -65,6 +80,17 @@ void ScreenCapturerWrapper::selectScreen(ScreenCapturer::ScreenId screen_id)
     }
 }
 
+void ScreenCapturerWrapper::setCaptureRegion(const Rect& region)
+{
+    DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+
+    LOG(LS_INFO) << "Capture region changed: " << region.x() << "," << region.y() << " "
+                 << region.width() << "x" << region.height();
+
+    capture_region_ = region;
+    region_queue_.reset();
+}
+
 void ScreenCapturerWrapper::captureFrame()
 {
     DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
@@ -72,8 +98,24 @@ void ScreenCapturerWrapper::captureFrame()
     if (!screen_capturer_)
         return;
 
+    ScopedTraceEvent trace_event("capture", "CaptureFrame");
+
+    last_capture_time_us_ = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+
     switchToInputDesktop();
 
+#if defined(OS_WIN)
+    if (dxgi_unusable_ && display_config_monitor_.isChanged())
+    {
+        // A display configuration change starts a new desktop generation: the cached probe
+        // result no longer applies and the preferred capturer gets another chance.
+        dxgi_unusable_ = false;
+        selectCapturer();
+    }
+#endif // defined(OS_WIN)
+
     int count = screen_capturer_->screenCount();
     if (screen_count_ != count)
     {
@@ -91,6 +133,15 @@ void ScreenCapturerWrapper::captureFrame()
                 break;
 
             case ScreenCapturer::Error::PERMANENT:
+#if defined(OS_WIN)
+                if (using_dxgi_)
+                {
+                    // DXGI failed on this desktop state; do not pay for another probe until
+                    // the state changes.
+                    dxgi_unusable_ = true;
+                    display_config_monitor_.reset();
+                }
+#endif // defined(OS_WIN)
                 selectCapturer();
                 break;
 
@@ -100,14 +151,37 @@ void ScreenCapturerWrapper::captureFrame()
         }
     }
 
+    if (frame)
+        frame = applyCaptureRegion(frame);
+
     delegate_->onScreenCaptured(frame, cursor_capturer_->captureCursor());
 }
 
 void ScreenCapturerWrapper::setSharedMemoryFactory(SharedMemoryFactory* shared_memory_factory)
 {
+    shared_memory_factory_ = shared_memory_factory;
     screen_capturer_->setSharedMemoryFactory(shared_memory_factory);
 }
 
+void ScreenCapturerWrapper::setLowMemoryMode(bool enable)
+{
+    DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+
+    if (low_memory_mode_ == enable)
+        return;
+
+    LOG(LS_INFO) << "Low memory mode changed: " << enable;
+    low_memory_mode_ = enable;
+
+    if (screen_capturer_)
+    {
+        // Recreated rather than reset: the preferred backend differs between the modes, and
+        // buffers of the old mode must not linger.
+        screen_capturer_.reset();
+        selectCapturer();
+    }
+}
+
 void ScreenCapturerWrapper::enableWallpaper(bool enable)
 {
     environment_->setWallpaper(enable);
@@ -123,6 +197,77 @@ void ScreenCapturerWrapper::enableFontSmoothing(bool enable)
     environment_->setFontSmoothing(enable);
 }
 
+const Frame* ScreenCapturerWrapper::applyCaptureRegion(const Frame* frame)
+{
+    if (capture_region_.isEmpty())
+        return frame;
+
+    Rect region = capture_region_;
+    region.intersectWith(Rect::makeSize(frame->size()));
+
+    // A region outside the screen or covering it completely leaves the frame as it is.
+    if (region.isEmpty() || region.equals(Rect::makeSize(frame->size())))
+        return frame;
+
+    region_queue_.moveToNextFrame();
+
+    bool new_buffer = false;
+
+    Frame* output = region_queue_.currentFrame();
+    if (!output || output->size() != region.size())
+    {
+        std::unique_ptr<Frame> new_frame;
+
+        // The consumer expects frames in shared memory when a factory is installed.
+        if (shared_memory_factory_)
+            new_frame = SharedMemoryFrame::create(region.size(), shared_memory_factory_);
+        else
+            new_frame = FrameSimple::create(region.size());
+
+        if (!new_frame)
+        {
+            LOG(LS_ERROR) << "Unable to create frame for capture region";
+            return frame;
+        }
+
+        region_queue_.replaceCurrentFrame(std::move(new_frame));
+        output = region_queue_.currentFrame();
+        new_buffer = true;
+    }
+
+    // The whole region is copied so each buffer of the queue is complete regardless of which
+    // frames it missed; the region is small, so the copy is cheap. The updated region is the
+    // source damage clipped to the region, so downstream scaling and encoding still pay only
+    // for the damaged part.
+    output->copyPixelsFrom(*frame, region.topLeft(), Rect::makeSize(region.size()));
+    output->copyFrameInfoFrom(*frame);
+
+    output->setTopLeft(Point(frame->topLeft().x() + region.x(),
+                             frame->topLeft().y() + region.y()));
+
+    Region* updated_region = output->updatedRegion();
+    updated_region->clear();
+
+    if (new_buffer)
+    {
+        // The consumer has never seen this buffer; everything in it is news.
+        updated_region->addRect(Rect::makeSize(region.size()));
+    }
+    else
+    {
+        for (Region::Iterator it(frame->constUpdatedRegion()); !it.isAtEnd(); it.advance())
+        {
+            Rect rect = it.rect();
+            rect.intersectWith(region);
+
+            if (!rect.isEmpty())
+                updated_region->addRect(rect.translated(-region.x(), -region.y()));
+        }
+    }
+
+    return output;
+}
+
 ScreenCapturer::ScreenId ScreenCapturerWrapper::defaultScreen()
 {
     ScreenCapturer::ScreenList screens;
@@ -144,8 +289,11 @@ void ScreenCapturerWrapper::selectCapturer()
 
 #if defined(OS_WIN)
     cursor_capturer_ = std::make_unique<CursorCapturerWin>();
+    using_dxgi_ = false;
 
-    if (win::windowsVersion() >= win::VERSION_WIN8)
+    // The duplication API keeps its own per-output frame caches, so in low memory mode the
+    // GDI capturer with the shortened frame queue is preferred despite the higher capture cost.
+    if (win::windowsVersion() >= win::VERSION_WIN8 && !dxgi_unusable_ && !low_memory_mode_)
     {
         // Desktop Duplication API is available in Windows 8+.
         std::unique_ptr<ScreenCapturerDxgi> capturer_dxgi = std::make_unique<ScreenCapturerDxgi>();
@@ -153,6 +301,13 @@ void ScreenCapturerWrapper::selectCapturer()
         {
             LOG(LS_INFO) << "Using DXGI capturer";
             screen_capturer_ = std::move(capturer_dxgi);
+            using_dxgi_ = true;
+        }
+        else
+        {
+            // Remember the failed probe for this desktop state.
+            dxgi_unusable_ = true;
+            display_config_monitor_.reset();
         }
     }
 
@@ -162,12 +317,41 @@ void ScreenCapturerWrapper::selectCapturer()
         screen_capturer_ = std::make_unique<ScreenCapturerGdi>();
     }
 #elif defined(OS_LINUX)
-    NOTIMPLEMENTED();
+    cursor_capturer_ = std::make_unique<CursorCapturerX11>();
+
+#if defined(USE_PIPEWIRE)
+    // A Wayland compositor does not expose other applications through the X server, so XWayland
+    // grabs show an empty desktop. Prefer the portal based PipeWire capturer on Wayland
+    // sessions; the cursor is composited into the stream by the compositor.
+    if (getenv("WAYLAND_DISPLAY"))
+    {
+        std::unique_ptr<ScreenCapturerPipewire> capturer_pipewire =
+            std::make_unique<ScreenCapturerPipewire>();
+        if (capturer_pipewire->start())
+        {
+            LOG(LS_INFO) << "Using PipeWire capturer";
+            screen_capturer_ = std::move(capturer_pipewire);
+        }
+    }
+#endif // defined(USE_PIPEWIRE)
+
+    if (!screen_capturer_)
+    {
+        LOG(LS_INFO) << "Using X11 capturer";
+        screen_capturer_ = std::make_unique<ScreenCapturerX11>();
+    }
 #elif defined(OS_MAC)
     NOTIMPLEMENTED();
 #else
     NOTIMPLEMENTED();
 #endif
+
+    // A replacement capturer starts without the factory installed on its predecessor.
+    if (screen_capturer_ && shared_memory_factory_)
+        screen_capturer_->setSharedMemoryFactory(shared_memory_factory_);
+
+    if (screen_capturer_)
+        screen_capturer_->setLowMemoryMode(low_memory_mode_);
 }
 
 void ScreenCapturerWrapper::switchToInputDesktop()
@@ -188,6 +372,14 @@ void ScreenCapturerWrapper::switchToInputDesktop()
         // If setThreadDesktop() fails, the thread is still assigned a desktop.
         // So we can continue capture screen bits, just from the wrong desktop.
         desktop_.setThreadDesktop(std::move(input_desktop));
+
+        // Another input desktop is another generation: capabilities cached on the previous
+        // one (DXGI is unavailable on secure desktops, for example) do not carry over. When a
+        // fallback is active, the selection is re-run so the preferred capturer gets one probe
+        // on the new desktop.
+        dxgi_unusable_ = false;
+        if (screen_capturer_ && !using_dxgi_)
+            selectCapturer();
     }
 #endif // defined(OS_WIN)
 }
@@ -24,6 +24,7 @@
 #include "build/build_config.h"
 
 #if defined(OS_WIN)
+#include "base/desktop/win/display_configuration_monitor.h"
 #include "base/win/scoped_thread_desktop.h"
 #elif defined(OS_LINUX)
 #endif
@@ -52,24 +53,57 @@ public:
     ~ScreenCapturerWrapper();
 
     void selectScreen(ScreenCapturer::ScreenId screen_id);
+
+    // Restricts the captured output to |region| of the selected screen, in screen coordinates.
+    // An empty rectangle restores full-screen output. Selecting a screen resets the region.
+    void setCaptureRegion(const Rect& region);
+
     void captureFrame();
     void setSharedMemoryFactory(SharedMemoryFactory* shared_memory_factory);
+
+    // Switches the capturer between the regular triple-buffered pipeline and the low memory
+    // mode (single recycled buffer, change detection on a downscaled shadow). The current
+    // frame buffers are dropped and rebuilt on the next capture.
+    void setLowMemoryMode(bool enable);
+
     void enableWallpaper(bool enable);
     void enableEffects(bool enable);
     void enableFontSmoothing(bool enable);
 
+    // Monotonic timestamp (in microseconds) taken when the last call to captureFrame() started.
+    // Used to stamp the captured frame for end-to-end latency measurement.
+    uint64_t lastCaptureTimeUs() const { return last_capture_time_us_; }
+
 private:
     ScreenCapturer::ScreenId defaultScreen();
     void selectCapturer();
     void switchToInputDesktop();
+    const Frame* applyCaptureRegion(const Frame* frame);
 
     Delegate* delegate_;
 
 #if defined(OS_WIN)
     ScopedThreadDesktop desktop_;
+
+    // Capturer capability cache. A failed DXGI probe costs a full device initialization, so a
+    // negative result is remembered and selectCapturer() goes straight to GDI until the
+    // desktop state it was obtained on changes: a switch to another input desktop or a display
+    // configuration change starts a new generation and clears the cache.
+    bool dxgi_unusable_ = false;
+    bool using_dxgi_ = false;
+    DisplayConfigurationMonitor display_config_monitor_;
 #endif // defined(OS_WIN)
 
     int screen_count_ = 0;
+    uint64_t last_capture_time_us_ = 0;
+    bool low_memory_mode_ = false;
+
+    // Region-of-interest state. While |capture_region_| is not empty, captured frames are
+    // cropped to it before they reach the delegate. The queue mirrors the triple buffering of
+    // the capturers: the consumer may still read one frame while the next one is produced.
+    Rect capture_region_;
+    ScreenCapturer::FrameQueue<Frame> region_queue_;
+    SharedMemoryFactory* shared_memory_factory_ = nullptr;
 
     std::unique_ptr<PowerSaveBlocker> power_save_blocker_;
     std::unique_ptr<DesktopEnvironment> environment_;
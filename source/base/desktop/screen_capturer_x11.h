@@ -21,8 +21,16 @@
 
 #include "base/desktop/screen_capturer.h"
 
+#include <X11/Xlib.h>
+#include <X11/extensions/Xdamage.h>
+#include <X11/extensions/Xfixes.h>
+#include <X11/extensions/XShm.h>
+
 namespace base {
 
+class Differ;
+class ShadowDiffer;
+
 class ScreenCapturerX11 : public ScreenCapturer
 {
 public:
@@ -40,6 +48,47 @@ protected:
     void reset() override;
 
 private:
+    void initXDamage();
+    bool initShm(const Size& size);
+    void destroyShm();
+    void issueScreenBlit();
+    void waitScreenBlit();
+    void processPendingXEvents();
+    void handleXEvent(const XEvent& event);
+    const Frame* captureImage();
+    bool copyRect(Frame* frame, const Rect& rect);
+
+    Display* display_ = nullptr;
+    Window root_window_ = None;
+
+    // XDamage state. When the extension is available the X server tells us which parts of the
+    // screen changed between captures; otherwise consecutive frames are compared with the differ.
+    bool use_damage_ = false;
+    Damage damage_handle_ = None;
+    int damage_event_base_ = 0;
+    int damage_error_base_ = 0;
+    XserverRegion damage_region_ = 0;
+
+    // MIT-SHM state. With the extension the server writes the pixels straight into a shared
+    // memory segment instead of streaming them through the display connection. When shared
+    // pixmaps are supported as well, full-screen grabs become asynchronous XCopyArea blits into
+    // the shared pixmap, so the server-side blit overlaps with CPU work on the previous frame.
+    bool use_shm_ = false;
+    bool shm_checked_ = false;
+    XShmSegmentInfo shm_info_ = {};
+    XImage* shm_image_ = nullptr;
+    Pixmap shm_pixmap_ = None;
+    GC shm_gc_ = nullptr;
+
+    // State of the asynchronous blit into the shared pixmap. The completion is signalled by a
+    // NoExpose / GraphicsExpose event on the pixmap.
+    bool blit_issued_ = false;
+    bool blit_completed_ = false;
+
+    std::unique_ptr<Differ> differ_;
+    std::unique_ptr<ShadowDiffer> shadow_differ_;
+    FrameQueue<Frame> queue_;
+
     DISALLOW_COPY_AND_ASSIGN(ScreenCapturerX11);
 };
 
@@ -0,0 +1,93 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/desktop/shadow_differ.h"
+
+#include "base/logging.h"
+#include "base/desktop/differ.h"
+#include "base/desktop/frame_simple.h"
+
+#include <algorithm>
+
+namespace base {
+
+ShadowDiffer::ShadowDiffer() = default;
+
+ShadowDiffer::~ShadowDiffer() = default;
+
+void ShadowDiffer::calcDirtyRegion(Frame* frame, Region* changed_region)
+{
+    DCHECK(frame);
+    DCHECK(changed_region);
+
+    const Size& size = frame->size();
+    const Rect frame_rect = Rect::makeSize(size);
+    const Size shadow_size(std::max(size.width() / kShadowScale, 1),
+                           std::max(size.height() / kShadowScale, 1));
+
+    // The whole frame is rescaled on every capture; the dirty region is exactly what is being
+    // computed here, so there is no smaller region to hand to the reducer.
+    frame->updatedRegion()->clear();
+    frame->updatedRegion()->addRect(frame_rect);
+
+    const Frame* shadow = scale_reducer_.scaleFrame(frame, shadow_size);
+    if (!shadow)
+    {
+        LOG(LS_WARNING) << "Failed to create shadow frame";
+        changed_region->clear();
+        changed_region->addRect(frame_rect);
+        return;
+    }
+
+    const Rect shadow_rect = Rect::makeSize(shadow->size());
+
+    if (!prev_shadow_ || prev_shadow_->size() != shadow->size())
+    {
+        differ_ = std::make_unique<Differ>(shadow->size());
+
+        prev_shadow_ = FrameSimple::create(shadow->size());
+        if (prev_shadow_)
+            prev_shadow_->copyPixelsFrom(*shadow, Point(), shadow_rect);
+
+        changed_region->clear();
+        changed_region->addRect(frame_rect);
+        return;
+    }
+
+    Region shadow_region;
+    differ_->calcDirtyRegion(prev_shadow_->frameData(), shadow->frameData(), &shadow_region);
+
+    prev_shadow_->copyPixelsFrom(*shadow, Point(), shadow_rect);
+
+    changed_region->clear();
+
+    // Scale the shadow rectangles back up, expanded by one shadow pixel on each side to cover
+    // the rounding of the box filter.
+    for (Region::Iterator it(shadow_region); !it.isAtEnd(); it.advance())
+    {
+        const Rect& rect = it.rect();
+
+        changed_region->addRect(frame_rect.intersected(
+            Rect::makeLTRB((rect.left() - 1) * kShadowScale,
+                           (rect.top() - 1) * kShadowScale,
+                           (rect.right() + 1) * kShadowScale,
+                           (rect.bottom() + 1) * kShadowScale)));
+    }
+}
+
+} // namespace base
@@ -0,0 +1,64 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__DESKTOP__SHADOW_DIFFER_H
+#define BASE__DESKTOP__SHADOW_DIFFER_H
+
+#include "base/macros_magic.h"
+#include "base/codec/scale_reducer.h"
+#include "base/desktop/region.h"
+
+#include <memory>
+
+namespace base {
+
+class Differ;
+class Frame;
+
+// Change detection against a downscaled shadow of the screen instead of a second
+// full-resolution frame. Each captured frame is rescaled to half size and compared with the
+// shadow of the previous capture, so the capturer needs only one full-resolution buffer; the
+// history costs a quarter of a frame instead of a whole one. The price is coarser damage
+// granularity: shadow rectangles are scaled back up expanded by one shadow pixel, and changes
+// smaller than the box filter kernel may produce slightly larger update regions.
+class ShadowDiffer
+{
+public:
+    ShadowDiffer();
+    ~ShadowDiffer();
+
+    // Calculates the region of |frame| that changed since the previous call. The first call,
+    // and any call after the frame size changed, marks the whole frame. |changed_region| may
+    // alias frame->updatedRegion(); its previous content is discarded.
+    void calcDirtyRegion(Frame* frame, Region* changed_region);
+
+private:
+    // Linear downscale factor of the shadow. One 16x16 differ block in the shadow covers a
+    // 32x32 area of the screen.
+    static const int kShadowScale = 2;
+
+    ScaleReducer scale_reducer_;
+    std::unique_ptr<Frame> prev_shadow_;
+    std::unique_ptr<Differ> differ_;
+
+    DISALLOW_COPY_AND_ASSIGN(ShadowDiffer);
+};
+
+} // namespace base
+
+#endif // BASE__DESKTOP__SHADOW_DIFFER_H
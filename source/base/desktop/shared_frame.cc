@@ -18,6 +18,8 @@
 
 #include "base/desktop/shared_frame.h"
 
+#include "base/desktop/frame_simple.h"
+
 namespace base {
 
 SharedFrame::SharedFrame(std::shared_ptr<Frame>& frame)
@@ -49,6 +51,28 @@ std::unique_ptr<SharedFrame> SharedFrame::share()
     return result;
 }
 
+std::unique_ptr<const SharedFrame> SharedFrame::snapshot()
+{
+    return share();
+}
+
+// static
+std::unique_ptr<SharedFrame> SharedFrame::makeWritable(std::unique_ptr<SharedFrame> frame)
+{
+    if (!frame->isShared())
+        return frame;
+
+    std::unique_ptr<FrameSimple> copy = FrameSimple::create(frame->size());
+    if (!copy)
+        return nullptr;
+
+    copy->copyPixelsFrom(*frame, Point(), Rect::makeSize(frame->size()));
+    copy->copyFrameInfoFrom(*frame);
+
+    // The constructor of the new wrapper copies the frame information from |copy|.
+    return wrap(std::move(copy));
+}
+
 bool SharedFrame::isShared()
 {
     return frame_.use_count() > 1;
@@ -39,6 +39,20 @@ public:
     // Creates a clone of this object.
     std::unique_ptr<SharedFrame> share();
 
+    // Returns an immutable view of the frame for use on another thread. The view references the
+    // pixel buffer of |this| without copying; the reference count of the underlying Frame keeps
+    // the buffer alive for as long as any view exists. A writer that has handed out views must
+    // detach with makeWritable() before modifying the buffer.
+    std::unique_ptr<const SharedFrame> snapshot();
+
+    // Returns a frame that is guaranteed to own its buffer exclusively and is therefore safe to
+    // modify. When |frame| is not shared it is returned unchanged; otherwise the pixels are
+    // copied into a fresh heap buffer and existing views keep referencing the old, now
+    // effectively immutable, buffer (copy-on-write). The detached copy is heap-allocated, so a
+    // backing shared memory region is not carried over. Returns nullptr if the copy could not
+    // be allocated.
+    static std::unique_ptr<SharedFrame> makeWritable(std::unique_ptr<SharedFrame> frame);
+
     // Checks if the frame is currently shared. If it returns false it's guaranteed that there are
     // no clones of the object.
     bool isShared();
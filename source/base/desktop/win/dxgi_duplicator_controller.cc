@@ -71,15 +71,39 @@ bool DxgiDuplicatorController::isCurrentSessionSupported()
     return session_id != 0;
 }
 
+// static
+std::shared_ptr<DxgiDuplicatorController> DxgiDuplicatorController::instance()
+{
+    // Windows allows only one IDXGIOutputDuplication per monitor per process, and every stream
+    // costs duplication work on the GPU. All capturers therefore share one controller; the
+    // weak pointer lets the controller die together with the last capturer instead of keeping
+    // the DXGI components alive for the lifetime of the process.
+    static std::mutex instance_lock;
+    static std::weak_ptr<DxgiDuplicatorController> weak_instance;
+
+    std::scoped_lock lock(instance_lock);
+
+    std::shared_ptr<DxgiDuplicatorController> result = weak_instance.lock();
+    if (!result)
+    {
+        result.reset(new DxgiDuplicatorController());
+        weak_instance = result;
+    }
+
+    return result;
+}
+
 DxgiDuplicatorController::DxgiDuplicatorController() = default;
 
 DxgiDuplicatorController::~DxgiDuplicatorController()
 {
+    std::scoped_lock lock(lock_);
     deinitialize();
 }
 
 bool DxgiDuplicatorController::isSupported()
 {
+    std::scoped_lock lock(lock_);
     return initialize();
 }
 
@@ -87,6 +111,8 @@ bool DxgiDuplicatorController::retrieveD3dInfo(D3dInfo* info)
 {
     bool result = false;
     {
+        std::scoped_lock lock(lock_);
+
         result = initialize();
         *info = d3d_info_;
     }
@@ -114,6 +140,8 @@ DxgiDuplicatorController::Result DxgiDuplicatorController::duplicateMonitor(
 
 Point DxgiDuplicatorController::dpi()
 {
+    std::scoped_lock lock(lock_);
+
     if (!initialize())
         return Point();
 
@@ -122,6 +150,8 @@ Point DxgiDuplicatorController::dpi()
 
 int DxgiDuplicatorController::screenCount()
 {
+    std::scoped_lock lock(lock_);
+
     if (initialize())
         return doScreenCount();
 
@@ -132,6 +162,8 @@ bool DxgiDuplicatorController::deviceNames(std::vector<std::wstring>* output)
 {
     DCHECK(output);
 
+    std::scoped_lock lock(lock_);
+
     if (initialize())
     {
         for (const auto& duplicator : duplicators_)
@@ -151,6 +183,8 @@ DxgiDuplicatorController::Result DxgiDuplicatorController::doDuplicate(
 {
     DCHECK(frame);
 
+    std::scoped_lock lock(lock_);
+
     // The dxgi components and APIs do not update the screen resolution without a reinitialization.
     // So we use the GetDC() function to retrieve the screen resolution to decide whether dxgi
     // components need to be reinitialized.
@@ -220,6 +254,8 @@ DxgiDuplicatorController::Result DxgiDuplicatorController::doDuplicate(
 
 void DxgiDuplicatorController::unregister(const Context* const context)
 {
+    std::scoped_lock lock(lock_);
+
     if (contextExpired(context))
     {
         // The Context has not been setup after a recent initialization, so it should not been
@@ -27,6 +27,8 @@
 
 #include <D3DCommon.h>
 
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -44,9 +46,15 @@ namespace base {
 class DxgiDuplicatorController
 {
 public:
-    DxgiDuplicatorController();
     ~DxgiDuplicatorController();
 
+    // Returns the process-wide controller instance, creating it on first use. All capturers in
+    // the process share the one instance, so every monitor has a single duplication stream no
+    // matter how many consumers duplicate it; what each consumer has already seen is tracked
+    // through the Context it passes to duplicate(). The instance is destroyed when the last
+    // consumer releases its reference.
+    static std::shared_ptr<DxgiDuplicatorController> instance();
+
     using Context = DxgiFrameContext;
 
     // A collection of D3d information we are interested on, which may impact capturer performance
@@ -118,6 +126,9 @@ private:
     // DxgiFrameContext calls private unregister(Context*) function in reset().
     friend void DxgiFrameContext::reset();
 
+    // Consumers obtain the shared instance through instance().
+    DxgiDuplicatorController();
+
     // Does the real duplication work. Setting |monitor_id| < 0 to capture entire screen. This
     // function calls initialize(). And if the duplication failed, this function calls
     // deinitialize() to ensure the Dxgi components can be reinitialized next time.
@@ -182,6 +193,10 @@ private:
     // DxgiOutputDuplicator instances are initialized.
     void translateRect();
 
+    // Protects all the members below. The instance is shared by every capturer in the process,
+    // and concurrent sessions duplicate from their own threads.
+    std::mutex lock_;
+
     // A self-incremented integer to compare with the one in Context. It ensures a Context instance
     // is always initialized after DxgiDuplicatorController.
     int identity_ = 0;
@@ -228,7 +228,21 @@ bool DxgiOutputDuplicator::duplicate(Context* context, const Point& offset, Shar
         detectUpdatedRegion(frame_info, &context->updated_region);
         spreadContextChange(context);
 
-        if (!texture_->copyFrom(frame_info, resource.Get()))
+        // Region of the acquired texture the staging implementation has to bring into CPU
+        // reach. The region reported by Windows is rotated, while the texture is not, so it is
+        // rotated back into texture coordinates first.
+        Region copy_region = context->updated_region;
+        if (rotation_ != Rotation::CLOCK_WISE_0)
+        {
+            copy_region.clear();
+            for (Region::Iterator it(context->updated_region); !it.isAtEnd(); it.advance())
+            {
+                copy_region.addRect(
+                    rotateRect(it.rect(), desktopSize(), reverseRotation(rotation_)));
+            }
+        }
+
+        if (!texture_->copyFrom(frame_info, resource.Get(), copy_region))
             return false;
 
         updated_region.addRegion(context->updated_region);
@@ -240,14 +254,10 @@ bool DxgiOutputDuplicator::duplicate(Context* context, const Point& offset, Shar
 
         if (rotation_ != Rotation::CLOCK_WISE_0)
         {
-            for (Region::Iterator it(updated_region); !it.isAtEnd(); it.advance())
-            {
-                // The |updated_region| returned by Windows is rotated, but the |source|
-                // frame is not. So we need to rotate it reversely.
-                const Rect source_rect =
-                    rotateRect(it.rect(), desktopSize(), reverseRotation(rotation_));
-                rotateDesktopFrame(source, source_rect, rotation_, offset, target);
-            }
+            // The |updated_region| returned by Windows is rotated, but the |source| frame is
+            // not. The region overload rotates each rectangle reversely and copies only the
+            // damaged pixels.
+            rotateDesktopFrame(source, updated_region, rotation_, offset, target);
         }
         else
         {
@@ -38,8 +38,11 @@ public:
     virtual ~DxgiTexture();
 
     // Copies selected regions of a frame represented by frame_info and resource.
+    // |updated_region| contains the dirty and moved parts of the frame in texture coordinates;
+    // implementations that stage the texture may limit the GPU-to-CPU transfer to it.
     // Returns false if anything wrong.
-    bool copyFrom(const DXGI_OUTDUPL_FRAME_INFO& frame_info, IDXGIResource* resource);
+    bool copyFrom(const DXGI_OUTDUPL_FRAME_INFO& frame_info, IDXGIResource* resource,
+                  const Region& updated_region);
 
     const Size& desktopSize() const { return desktop_size_; }
     uint8_t* bits() const { return static_cast<uint8_t*>(rect_.pBits); }
@@ -60,7 +63,8 @@ protected:
     DXGI_MAPPED_RECT* rect();
 
     virtual bool copyFromTexture(const DXGI_OUTDUPL_FRAME_INFO& frame_info,
-                                 ID3D11Texture2D* texture) = 0;
+                                 ID3D11Texture2D* texture,
+                                 const Region& updated_region) = 0;
 
     virtual bool doRelease() = 0;
 
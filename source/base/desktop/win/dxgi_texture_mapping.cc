@@ -35,8 +35,11 @@ DxgiTextureMapping::DxgiTextureMapping(IDXGIOutputDuplication* duplication)
 DxgiTextureMapping::~DxgiTextureMapping() = default;
 
 bool DxgiTextureMapping::copyFromTexture(const DXGI_OUTDUPL_FRAME_INFO& frame_info,
-                                         ID3D11Texture2D* texture)
+                                         ID3D11Texture2D* texture,
+                                         const Region& /* updated_region */)
 {
+    // The desktop image already lives in system memory; there is no GPU-to-CPU transfer to
+    // limit, the surface is simply mapped.
     DCHECK_GT(frame_info.AccumulatedFrames, 0u);
     DCHECK(texture);
 
@@ -66,6 +66,7 @@ bool DxgiTextureStaging::initializeStage(ID3D11Texture2D* texture)
         // The descriptions are not consistent, we need to create a new ID3D11Texture2D instance.
         stage_.Reset();
         surface_.Reset();
+        stage_valid_ = false;
     }
     else
     {
@@ -106,7 +107,8 @@ void DxgiTextureStaging::assertStageAndSurfaceAreSameObject()
 }
 
 bool DxgiTextureStaging::copyFromTexture(const DXGI_OUTDUPL_FRAME_INFO& frame_info,
-                                         ID3D11Texture2D* texture)
+                                         ID3D11Texture2D* texture,
+                                         const Region& updated_region)
 {
     DCHECK_GT(frame_info.AccumulatedFrames, 0u);
     DCHECK(texture);
@@ -116,8 +118,62 @@ bool DxgiTextureStaging::copyFromTexture(const DXGI_OUTDUPL_FRAME_INFO& frame_in
     if (!initializeStage(texture))
         return false;
 
-    device_.context()->CopyResource(static_cast<ID3D11Resource*>(stage_.Get()),
-                                    static_cast<ID3D11Resource*>(texture));
+    // Decide between staging the whole texture and only the updated parts. Staging only the
+    // dirty and moved rects saves most of the GPU-to-CPU readback on large screens, but a
+    // mostly damaged frame is cheaper to transfer in one piece than rect by rect.
+    static const int64_t kPartialCopyMaxAreaPercent = 80;
+
+    const Rect desktop_rect = Rect::makeSize(desktopSize());
+    const int64_t desktop_area =
+        static_cast<int64_t>(desktop_rect.width()) * desktop_rect.height();
+
+    bool full_copy = !stage_valid_;
+    if (!full_copy)
+    {
+        int64_t updated_area = 0;
+        for (Region::Iterator it(updated_region); !it.isAtEnd(); it.advance())
+        {
+            if (!desktop_rect.containsRect(it.rect()))
+            {
+                // The region does not describe this texture; do not trust it.
+                updated_area = desktop_area;
+                break;
+            }
+
+            updated_area += static_cast<int64_t>(it.rect().width()) * it.rect().height();
+        }
+
+        full_copy = (updated_area == 0 ||
+                     updated_area * 100 > desktop_area * kPartialCopyMaxAreaPercent);
+    }
+
+    if (full_copy)
+    {
+        device_.context()->CopyResource(static_cast<ID3D11Resource*>(stage_.Get()),
+                                        static_cast<ID3D11Resource*>(texture));
+    }
+    else
+    {
+        for (Region::Iterator it(updated_region); !it.isAtEnd(); it.advance())
+        {
+            const Rect& rect = it.rect();
+
+            D3D11_BOX box;
+            box.left = static_cast<UINT>(rect.left());
+            box.top = static_cast<UINT>(rect.top());
+            box.front = 0;
+            box.right = static_cast<UINT>(rect.right());
+            box.bottom = static_cast<UINT>(rect.bottom());
+            box.back = 1;
+
+            device_.context()->CopySubresourceRegion(
+                static_cast<ID3D11Resource*>(stage_.Get()), 0,
+                static_cast<UINT>(rect.left()), static_cast<UINT>(rect.top()), 0,
+                static_cast<ID3D11Resource*>(texture), 0, &box);
+        }
+    }
+
+    stage_valid_ = true;
 
     *rect() = { 0 };
 
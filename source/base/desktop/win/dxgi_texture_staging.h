@@ -44,9 +44,14 @@ public:
 
 protected:
     // Copies selected regions of a frame represented by frame_info and texture.
+    // Only |updated_region| is staged through CopySubresourceRegion when possible; the parts of
+    // the staging texture outside of it still hold their content from earlier frames, which by
+    // definition of the dirty region is identical to the current desktop. This limits the
+    // GPU-to-CPU readback to the pixels that actually changed.
     // Returns false if anything wrong.
     bool copyFromTexture(const DXGI_OUTDUPL_FRAME_INFO& frame_info,
-                         ID3D11Texture2D* texture) override;
+                         ID3D11Texture2D* texture,
+                         const Region& updated_region) override;
 
     bool doRelease() override;
 
@@ -63,6 +68,11 @@ private:
     const D3dDevice device_;
     Microsoft::WRL::ComPtr<ID3D11Texture2D> stage_;
     Microsoft::WRL::ComPtr<IDXGISurface> surface_;
+
+    // Whether stage_ holds a complete copy of a previous frame. A freshly (re)created staging
+    // texture has undefined content outside of the copied rects, so the first copy into it must
+    // always be a full one.
+    bool stage_valid_ = false;
 };
 
 } // namespace base
@@ -21,6 +21,7 @@
 #include "base/location.h"
 #include "base/logging.h"
 #include "base/ipc/ipc_channel_proxy.h"
+#include "base/ipc/shared_memory.h"
 #include "base/message_loop/message_loop.h"
 #include "base/message_loop/message_pump_asio.h"
 #include "base/strings/unicode.h"
@@ -28,6 +29,8 @@
 #include <asio/read.hpp>
 #include <asio/write.hpp>
 
+#include <algorithm>
+#include <cstring>
 #include <functional>
 
 #if defined(OS_WIN)
@@ -41,6 +44,17 @@ namespace {
 
 const uint32_t kMaxMessageSize = 16 * 1024 * 1024; // 16MB
 
+// Messages of this size and above are handed over through a shared memory segment instead of
+// being copied through the pipe buffers.
+const uint32_t kSharedBufferThreshold = 64 * 1024; // 64kB
+
+// The size word of a service frame has this bit set; the low bits carry the size of the frame.
+// Ordinary message sizes are limited by |kMaxMessageSize| and never use the bit.
+const uint32_t kSharedBufferFlag = 0x80000000;
+
+// Maximum number of outgoing shared memory segments per channel.
+const size_t kSharedBufferPoolLimit = 4;
+
 #if defined(OS_WIN)
 
 const char16_t kPipeNamePrefix[] = u"\\\\.\\pipe\\aspia.";
@@ -253,13 +267,26 @@ void IpcChannel::send(ByteArray&& buffer)
 {
     DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
 
-    const bool schedule_write = write_queue_.empty();
-
     // Add the buffer to the queue for sending.
     write_queue_.emplace(std::move(buffer));
 
-    if (schedule_write)
-        doWrite();
+    if (write_queue_.size() > max_write_queue_depth_)
+        max_write_queue_depth_ = write_queue_.size();
+
+    doWrite();
+}
+
+size_t IpcChannel::takeMaxQueueDepth()
+{
+    DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+
+    size_t max_queue_depth = max_write_queue_depth_;
+    max_write_queue_depth_ = 0;
+
+    if (proxy_)
+        max_queue_depth = std::max(max_queue_depth, proxy_->takeMaxQueueDepth());
+
+    return max_queue_depth;
 }
 
 std::filesystem::path IpcChannel::peerFilePath() const
@@ -322,6 +349,19 @@ void IpcChannel::onErrorOccurred(const Location& location, const std::error_code
 
 void IpcChannel::doWrite()
 {
+    if (is_writing_)
+        return;
+
+    is_writing_ = true;
+
+    // Acknowledgments of shared buffers are written first: they are tiny and the peer can not
+    // reuse a segment until its acknowledgment arrives.
+    if (!ack_queue_.empty())
+    {
+        doWriteServiceFrame(ack_queue_.front(), 0);
+        return;
+    }
+
     write_size_ = write_queue_.front().size();
 
     if (!write_size_ || write_size_ > kMaxMessageSize)
@@ -330,6 +370,11 @@ void IpcChannel::doWrite()
         return;
     }
 
+    // A large message is placed into a shared memory segment and only a small service frame
+    // crosses the pipe. This avoids copying the message through the pipe buffers.
+    if (write_size_ >= kSharedBufferThreshold && writeSharedBuffer())
+        return;
+
     asio::async_write(stream_, asio::buffer(&write_size_, sizeof(write_size_)),
         [this](const std::error_code& error_code, size_t bytes_transferred)
     {
@@ -360,15 +405,115 @@ void IpcChannel::doWrite()
             // Delete the sent message from the queue.
             write_queue_.pop();
 
-            // If the queue is not empty, then we send the following message.
-            if (write_queue_.empty() && !proxy_->reloadWriteQueue(&write_queue_))
+            onWriteFinished();
+        });
+    });
+}
+
+void IpcChannel::onWriteFinished()
+{
+    is_writing_ = false;
+
+    // If the queue is not empty, then we send the following message.
+    if (write_queue_.empty() && !proxy_->reloadWriteQueue(&write_queue_) && ack_queue_.empty())
+        return;
+
+    doWrite();
+}
+
+void IpcChannel::doWriteServiceFrame(int32_t id, uint32_t data_size)
+{
+    write_frame_.id = id;
+    write_frame_.data_size = data_size;
+    write_size_ = kSharedBufferFlag | sizeof(SharedBufferFrame);
+
+    asio::async_write(stream_, asio::buffer(&write_size_, sizeof(write_size_)),
+        [this](const std::error_code& error_code, size_t bytes_transferred)
+    {
+        if (error_code)
+        {
+            onErrorOccurred(FROM_HERE, error_code);
+            return;
+        }
+
+        DCHECK_EQ(bytes_transferred, sizeof(write_size_));
+
+        asio::async_write(stream_, asio::buffer(&write_frame_, sizeof(write_frame_)),
+            [this](const std::error_code& error_code, size_t bytes_transferred)
+        {
+            if (error_code)
+            {
+                onErrorOccurred(FROM_HERE, error_code);
                 return;
+            }
+
+            DCHECK_EQ(bytes_transferred, sizeof(write_frame_));
 
-            doWrite();
+            if (write_frame_.data_size)
+            {
+                // The message itself was handed over through the segment.
+                DCHECK(!write_queue_.empty());
+                write_queue_.pop();
+            }
+            else
+            {
+                DCHECK(!ack_queue_.empty());
+                ack_queue_.pop();
+            }
+
+            onWriteFinished();
         });
     });
 }
 
+bool IpcChannel::writeSharedBuffer()
+{
+#if defined(OS_WIN)
+    const ByteArray& buffer = write_queue_.front();
+
+    SharedBuffer* shared_buffer = nullptr;
+
+    for (SharedBuffer& candidate : shared_buffers_)
+    {
+        if (!candidate.in_use && candidate.size >= buffer.size())
+        {
+            shared_buffer = &candidate;
+            break;
+        }
+    }
+
+    if (!shared_buffer)
+    {
+        // All suitable segments are waiting for an acknowledgment; the message goes through
+        // the pipe.
+        if (shared_buffers_.size() >= kSharedBufferPoolLimit)
+            return false;
+
+        // Segment sizes are rounded up, so that a segment can be reused for other messages.
+        const size_t size = (buffer.size() + kSharedBufferThreshold - 1) /
+            kSharedBufferThreshold * kSharedBufferThreshold;
+
+        std::unique_ptr<SharedMemory> memory =
+            SharedMemory::create(SharedMemory::Mode::READ_WRITE, size);
+        if (!memory)
+            return false;
+
+        shared_buffers_.emplace_back();
+        shared_buffer = &shared_buffers_.back();
+        shared_buffer->memory = std::move(memory);
+        shared_buffer->size = size;
+    }
+
+    memcpy(shared_buffer->memory->data(), buffer.data(), buffer.size());
+    shared_buffer->in_use = true;
+
+    doWriteServiceFrame(shared_buffer->memory->id(), static_cast<uint32_t>(buffer.size()));
+    return true;
+#else
+    return false;
+#endif
+}
+
 void IpcChannel::doReadMessage()
 {
     asio::async_read(stream_, asio::buffer(&read_size_, sizeof(read_size_)),
@@ -382,6 +527,12 @@ void IpcChannel::doReadMessage()
 
         DCHECK_EQ(bytes_transferred, sizeof(read_size_));
 
+        if (read_size_ & kSharedBufferFlag)
+        {
+            doReadServiceFrame();
+            return;
+        }
+
         if (!read_size_ || read_size_ > kMaxMessageSize)
         {
             onErrorOccurred(FROM_HERE, asio::error::message_size);
@@ -419,6 +570,112 @@ void IpcChannel::doReadMessage()
     });
 }
 
+void IpcChannel::doReadServiceFrame()
+{
+    if ((read_size_ & ~kSharedBufferFlag) != sizeof(SharedBufferFrame))
+    {
+        onErrorOccurred(FROM_HERE, asio::error::message_size);
+        return;
+    }
+
+    asio::async_read(stream_, asio::buffer(&read_frame_, sizeof(read_frame_)),
+        [this](const std::error_code& error_code, size_t bytes_transferred)
+    {
+        if (error_code)
+        {
+            onErrorOccurred(FROM_HERE, error_code);
+            return;
+        }
+
+        DCHECK_EQ(bytes_transferred, sizeof(read_frame_));
+
+        if (!read_frame_.data_size)
+        {
+            // The peer is done with one of our segments; it can now be reused.
+            releaseSharedBuffer(read_frame_.id);
+        }
+        else
+        {
+            if (!readSharedBuffer())
+            {
+                onErrorOccurred(FROM_HERE, asio::error::message_size);
+                return;
+            }
+
+            if (is_paused_)
+                return;
+
+            onMessageReceived();
+
+            if (is_paused_)
+                return;
+
+            DCHECK_EQ(read_size_, 0);
+        }
+
+        doReadMessage();
+    });
+}
+
+bool IpcChannel::readSharedBuffer()
+{
+    if (read_frame_.data_size > kMaxMessageSize)
+        return false;
+
+    SharedMemory* memory;
+
+    auto result = incoming_shared_buffers_.find(read_frame_.id);
+    if (result != incoming_shared_buffers_.end())
+    {
+        memory = result->second.get();
+    }
+    else
+    {
+        std::unique_ptr<SharedMemory> opened_memory =
+            SharedMemory::open(SharedMemory::Mode::READ_ONLY, read_frame_.id);
+        if (!opened_memory)
+        {
+            LOG(LS_WARNING) << "Unable to open shared buffer: " << read_frame_.id;
+            return false;
+        }
+
+        memory = incoming_shared_buffers_.emplace(
+            read_frame_.id, std::move(opened_memory)).first->second.get();
+    }
+
+    read_size_ = read_frame_.data_size;
+
+    if (read_buffer_.capacity() < read_size_)
+        read_buffer_.reserve(read_size_);
+
+    read_buffer_.resize(read_size_);
+    memcpy(read_buffer_.data(), memory->data(), read_size_);
+
+    // The data is copied out of the segment; the peer can reuse it.
+    sendSharedBufferAck(read_frame_.id);
+    return true;
+}
+
+void IpcChannel::releaseSharedBuffer(int32_t id)
+{
+    for (SharedBuffer& shared_buffer : shared_buffers_)
+    {
+        if (shared_buffer.in_use && shared_buffer.memory->id() == id)
+        {
+            shared_buffer.in_use = false;
+            return;
+        }
+    }
+
+    LOG(LS_WARNING) << "Acknowledgment for unknown shared buffer: " << id;
+}
+
+void IpcChannel::sendSharedBufferAck(int32_t id)
+{
+    ack_queue_.push(id);
+    doWrite();
+}
+
 void IpcChannel::onMessageReceived()
 {
     if (listener_)
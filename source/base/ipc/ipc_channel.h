@@ -31,13 +31,17 @@
 #endif
 
 #include <filesystem>
+#include <map>
+#include <memory>
 #include <queue>
+#include <vector>
 
 namespace base {
 
 class IpcChannelProxy;
 class IpcServer;
 class Location;
+class SharedMemory;
 
 class IpcChannel
 {
@@ -73,6 +77,10 @@ public:
 
     void send(ByteArray&& buffer);
 
+    // Peak depth of the write queue since the last call, including messages posted through the
+    // channel proxy. Reading resets the gauge. Must be called on the channel thread.
+    size_t takeMaxQueueDepth();
+
     ProcessId peerProcessId() const { return peer_process_id_; }
     SessionId peerSessionId() const { return peer_session_id_; }
     std::filesystem::path peerFilePath() const;
@@ -90,9 +98,32 @@ private:
     IpcChannel(std::u16string_view channel_name, Stream&& stream);
     static std::u16string channelName(std::u16string_view channel_id);
 
+    // Service frame of the shared buffer fast path. A frame with a non-zero |data_size|
+    // announces a message placed in the segment |id|; a frame with a zero |data_size|
+    // acknowledges that the segment can be reused.
+    struct SharedBufferFrame
+    {
+        int32_t id = 0;
+        uint32_t data_size = 0;
+    };
+
+    struct SharedBuffer
+    {
+        std::unique_ptr<SharedMemory> memory;
+        size_t size = 0;
+        bool in_use = false;
+    };
+
     void onErrorOccurred(const Location& location, const std::error_code& error_code);
     void doWrite();
+    void onWriteFinished();
+    void doWriteServiceFrame(int32_t id, uint32_t data_size);
+    bool writeSharedBuffer();
     void doReadMessage();
+    void doReadServiceFrame();
+    bool readSharedBuffer();
+    void releaseSharedBuffer(int32_t id);
+    void sendSharedBufferAck(int32_t id);
     void onMessageReceived();
 
     std::u16string channel_name_;
@@ -106,9 +137,25 @@ private:
 
     std::queue<ByteArray> write_queue_;
     uint32_t write_size_ = 0;
+    bool is_writing_ = false;
+
+    // Depth gauge for the stats extension. Only touched on the channel thread.
+    size_t max_write_queue_depth_ = 0;
+
+    // Pool of outgoing shared memory segments. Large messages are handed over through a segment
+    // and only a small service frame crosses the pipe. A segment is reused after the peer has
+    // acknowledged it.
+    std::vector<SharedBuffer> shared_buffers_;
+    std::queue<int32_t> ack_queue_;
+    SharedBufferFrame write_frame_;
 
     uint32_t read_size_ = 0;
     ByteArray read_buffer_;
+    SharedBufferFrame read_frame_;
+
+    // Incoming segments of the peer, cached by id. The peer reuses its segments, so the cache
+    // never grows beyond the size of its pool.
+    std::map<int32_t, std::unique_ptr<SharedMemory>> incoming_shared_buffers_;
 
     ProcessId peer_process_id_ = kNullProcessId;
     SessionId peer_session_id_ = kInvalidSessionId;
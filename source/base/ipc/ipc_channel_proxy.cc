@@ -38,12 +38,25 @@ void IpcChannelProxy::send(ByteArray&& buffer)
 
     incoming_queue_.emplace(std::move(buffer));
 
+    if (incoming_queue_.size() > max_queue_depth_)
+        max_queue_depth_ = incoming_queue_.size();
+
     if (!schedule_write)
         return;
 
     task_runner_->postTask(std::bind(&IpcChannelProxy::scheduleWrite, shared_from_this()));
 }
 
+size_t IpcChannelProxy::takeMaxQueueDepth()
+{
+    std::scoped_lock lock(incoming_queue_lock_);
+
+    size_t max_queue_depth = max_queue_depth_;
+    max_queue_depth_ = 0;
+
+    return max_queue_depth;
+}
+
 void IpcChannelProxy::willDestroyCurrentChannel()
 {
     channel_ = nullptr;
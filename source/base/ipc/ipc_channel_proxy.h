@@ -30,6 +30,9 @@ class IpcChannelProxy : public std::enable_shared_from_this<IpcChannelProxy>
 public:
     void send(ByteArray&& buffer);
 
+    // Peak depth of the incoming queue since the last call. Reading resets the gauge.
+    size_t takeMaxQueueDepth();
+
 private:
     friend class IpcChannel;
     IpcChannelProxy(std::shared_ptr<TaskRunner> task_runner, IpcChannel* channel);
@@ -46,6 +49,9 @@ private:
     std::queue<ByteArray> incoming_queue_;
     std::mutex incoming_queue_lock_;
 
+    // Depth gauge for the stats extension. Guarded by |incoming_queue_lock_|.
+    size_t max_queue_depth_ = 0;
+
     DISALLOW_COPY_AND_ASSIGN(IpcChannelProxy);
 };
 
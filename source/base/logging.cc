@@ -23,11 +23,16 @@
 #include "base/system_time.h"
 #include "base/strings/unicode.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <fstream>
 #include <iomanip>
 #include <mutex>
 #include <ostream>
 #include <thread>
+#include <vector>
 
 #if defined(OS_WIN)
 #include <Windows.h>
@@ -55,6 +60,237 @@ std::filesystem::path g_log_file_path;
 std::ofstream g_log_file;
 std::mutex g_log_file_lock;
 
+// Rotation state, written under |g_log_file_lock|. The file name prefix distinguishes the logs
+// of this process from other processes logging into the same directory.
+std::filesystem::path g_log_file_dir;
+std::string g_log_file_prefix;
+size_t g_log_file_size = 0;
+size_t g_max_log_size = 0;
+int g_max_log_files = 0;
+
+// File writes go through a bounded lock-free queue drained by a background thread, so that a
+// logging statement on a time-critical thread costs only the message formatting and an enqueue.
+// The queue is a Vyukov-style bounded MPMC ring: each cell carries a sequence number that tells
+// producers and consumers whether the cell is free or holds a message.
+constexpr size_t kLogQueueSize = 512; // Must be a power of two.
+
+struct LogQueueCell
+{
+    std::atomic<size_t> sequence;
+    std::string message;
+};
+
+LogQueueCell g_log_queue[kLogQueueSize];
+std::atomic<size_t> g_log_queue_enqueue_pos;
+std::atomic<size_t> g_log_queue_dequeue_pos;
+
+struct LogQueueInitializer
+{
+    LogQueueInitializer()
+    {
+        for (size_t i = 0; i < kLogQueueSize; ++i)
+            g_log_queue[i].sequence.store(i, std::memory_order_relaxed);
+    }
+} g_log_queue_initializer;
+
+// The thread object is intentionally leaked when the process exits without shutdownLogging():
+// a joinable global std::thread would terminate the process from its destructor.
+std::thread* g_log_writer_thread = nullptr;
+std::atomic<bool> g_log_writer_running = false;
+std::condition_variable g_log_writer_event;
+std::mutex g_log_writer_event_lock;
+
+// Returns false when the queue is full; the caller then writes synchronously.
+bool enqueueLogMessage(std::string&& message)
+{
+    size_t pos = g_log_queue_enqueue_pos.load(std::memory_order_relaxed);
+
+    for (;;)
+    {
+        LogQueueCell& cell = g_log_queue[pos & (kLogQueueSize - 1)];
+
+        const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+
+        if (diff == 0)
+        {
+            if (g_log_queue_enqueue_pos.compare_exchange_weak(
+                    pos, pos + 1, std::memory_order_relaxed))
+            {
+                cell.message = std::move(message);
+                cell.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (diff < 0)
+        {
+            // The cell has not been consumed yet - the queue is full.
+            return false;
+        }
+        else
+        {
+            pos = g_log_queue_enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool dequeueLogMessage(std::string* message)
+{
+    size_t pos = g_log_queue_dequeue_pos.load(std::memory_order_relaxed);
+
+    for (;;)
+    {
+        LogQueueCell& cell = g_log_queue[pos & (kLogQueueSize - 1)];
+
+        const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+
+        if (diff == 0)
+        {
+            if (g_log_queue_dequeue_pos.compare_exchange_weak(
+                    pos, pos + 1, std::memory_order_relaxed))
+            {
+                *message = std::move(cell.message);
+                cell.sequence.store(pos + kLogQueueSize, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (diff < 0)
+        {
+            // The cell has not been produced yet - the queue is empty.
+            return false;
+        }
+        else
+        {
+            pos = g_log_queue_dequeue_pos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+// Removes the oldest log files of this process until at most |max_files| remain. Called under
+// |g_log_file_lock|.
+void removeExcessFiles(int max_files)
+{
+    if (max_files < 0)
+        return;
+
+    std::vector<std::pair<std::filesystem::file_time_type, std::filesystem::path>> files;
+
+    std::error_code ignored_code;
+    for (const auto& item : std::filesystem::directory_iterator(g_log_file_dir, ignored_code))
+    {
+        if (item.is_directory())
+            continue;
+
+        // Only the files of this process are counted; other processes may log into the same
+        // directory.
+        const std::string file_name = item.path().filename().u8string();
+        if (file_name.compare(0, g_log_file_prefix.size(), g_log_file_prefix) != 0)
+            continue;
+
+        files.emplace_back(item.last_write_time(ignored_code), item.path());
+    }
+
+    std::sort(files.begin(), files.end());
+
+    for (size_t i = 0; i + static_cast<size_t>(max_files) < files.size(); ++i)
+        std::filesystem::remove(files[i].second, ignored_code);
+}
+
+// Opens a new timestamped log file in |g_log_file_dir|. Called under |g_log_file_lock|.
+bool openLogFile()
+{
+    SystemTime time = SystemTime::now();
+
+    std::ostringstream file_name_stream;
+    file_name_stream << g_log_file_prefix
+                     << std::setfill('0')
+                     << std::setw(4) << time.year()
+                     << std::setw(2) << time.month()
+                     << std::setw(2) << time.day()
+                     << '-'
+                     << std::setw(2) << time.hour()
+                     << std::setw(2) << time.minute()
+                     << std::setw(2) << time.second()
+                     << '.'
+                     << std::setw(3) << time.millisecond()
+                     << ".log";
+
+    std::filesystem::path file_path(g_log_file_dir);
+    file_path.append(file_name_stream.str());
+
+    g_log_file.open(file_path);
+    if (!g_log_file.is_open())
+        return false;
+
+    g_log_file_path = std::move(file_path);
+    g_log_file_size = 0;
+    return true;
+}
+
+// Rotates the log file when the active one has grown past the cap, so one process run never
+// produces an unbounded file. The oldest files make room for the new one. Called under
+// |g_log_file_lock|.
+void rotateLogFileIfNeeded()
+{
+    if (!g_max_log_size || g_log_file_size < g_max_log_size || !g_log_file.is_open())
+        return;
+
+    g_log_file.close();
+
+    if (g_max_log_files > 0)
+        removeExcessFiles(g_max_log_files - 1);
+
+    openLogFile();
+}
+
+// Writes all queued messages to the log file. If |message| is non-null it is written after them,
+// which keeps the file ordered when a caller must bypass the queue (fatal errors, full queue).
+void drainLogQueue(const std::string* message)
+{
+    std::scoped_lock lock(g_log_file_lock);
+
+    bool written = false;
+
+    std::string queued;
+    while (dequeueLogMessage(&queued))
+    {
+        g_log_file.write(queued.c_str(), static_cast<std::streamsize>(queued.size()));
+        g_log_file_size += queued.size();
+        written = true;
+
+        rotateLogFileIfNeeded();
+    }
+
+    if (message)
+    {
+        g_log_file.write(message->c_str(), static_cast<std::streamsize>(message->size()));
+        g_log_file_size += message->size();
+        written = true;
+
+        rotateLogFileIfNeeded();
+    }
+
+    if (written)
+        g_log_file.flush();
+}
+
+void logWriterThreadMain()
+{
+    while (g_log_writer_running.load(std::memory_order_relaxed))
+    {
+        {
+            std::unique_lock lock(g_log_writer_event_lock);
+            g_log_writer_event.wait_for(lock, std::chrono::milliseconds(100));
+        }
+
+        drainLogQueue(nullptr);
+    }
+
+    // Write out everything queued before the stop signal.
+    drainLogQueue(nullptr);
+}
+
 const char* severityName(LoggingSeverity severity)
 {
     static const char* const kLogSeverityNames[] =
@@ -127,35 +363,28 @@ bool initLoggingImpl(const LoggingSettings& settings, const std::filesystem::pat
             return false;
     }
 
-    SystemTime time = SystemTime::now();
+    std::ostringstream prefix_stream;
+    prefix_stream << file_name.c_str() << '-';
 
-    std::ostringstream file_name_stream;
-    file_name_stream << file_name.c_str() << '-'
-                     << std::setfill('0')
-                     << std::setw(4) << time.year()
-                     << std::setw(2) << time.month()
-                     << std::setw(2) << time.day()
-                     << '-'
-                     << std::setw(2) << time.hour()
-                     << std::setw(2) << time.minute()
-                     << std::setw(2) << time.second()
-                     << '.'
-                     << std::setw(3) << time.millisecond()
-                     << ".log";
-
-    std::filesystem::path file_path(file_dir);
-    file_path.append(file_name_stream.str());
+    g_log_file_dir = std::move(file_dir);
+    g_log_file_prefix = prefix_stream.str();
+    g_max_log_size = settings.max_log_size;
+    g_max_log_files = settings.max_log_files;
 
-    g_log_file.open(file_path);
-    if (!g_log_file.is_open())
+    if (!openLogFile())
         return false;
 
     std::filesystem::file_time_type file_time =
-        std::filesystem::last_write_time(file_path, error_code);
+        std::filesystem::last_write_time(g_log_file_path, error_code);
     if (!error_code)
-        removeOldFiles(file_dir, file_time, settings.max_log_age);
+        removeOldFiles(g_log_file_dir, file_time, settings.max_log_age);
+
+    if (!g_log_writer_running.exchange(true))
+    {
+        delete g_log_writer_thread;
+        g_log_writer_thread = new std::thread(logWriterThreadMain);
+    }
 
-    g_log_file_path = std::move(file_path);
     return true;
 }
 
@@ -169,7 +398,9 @@ std::ostream* g_swallow_stream;
 LoggingSettings::LoggingSettings()
     : destination(LOG_DEFAULT),
       min_log_level(LS_INFO),
-      max_log_age(7)
+      max_log_age(7),
+      max_log_size(8 * 1024 * 1024),
+      max_log_files(16)
 {
     // Nothing
 }
@@ -219,6 +450,15 @@ void shutdownLogging()
 {
     LOG(LS_INFO) << "Logging finished";
 
+    if (g_log_writer_running.exchange(false))
+    {
+        g_log_writer_event.notify_one();
+
+        if (g_log_writer_thread && g_log_writer_thread->joinable())
+            g_log_writer_thread->join();
+    }
+
+    // The writer thread drained the queue before exiting.
     std::scoped_lock lock(g_log_file_lock);
     g_log_file.close();
 }
@@ -333,9 +573,19 @@ LogMessage::~LogMessage()
     // Write to log file.
     if ((g_logging_destination & LOG_TO_FILE) != 0)
     {
-        std::scoped_lock lock(g_log_file_lock);
-        g_log_file.write(message.c_str(), message.size());
-        g_log_file.flush();
+        if (severity_ == LS_FATAL || !g_log_writer_running.load(std::memory_order_relaxed))
+        {
+            // Fatal messages must reach the file before the process is crashed, and before the
+            // writer thread is started (or after it is stopped) there is nobody to drain the
+            // queue. Write synchronously, keeping the file ordered.
+            drainLogQueue(&message);
+        }
+        else if (!enqueueLogMessage(std::move(message)))
+        {
+            // The queue is full - the writer thread is behind. Write synchronously instead of
+            // dropping diagnostics.
+            drainLogQueue(&message);
+        }
     }
 
     if (severity_ == LS_FATAL)
@@ -79,6 +79,11 @@
 // (after the message is logged).
 //
 // There is the special severity of DFATAL, which logs LS_FATAL in debug mode, LS_ERROR in normal mode.
+//
+// Messages with a severity below LOG_MIN_LEVEL are removed at compile time: the whole statement,
+// including evaluation of the streamed arguments, is dead code. Define LOG_MIN_LEVEL to one of the
+// severity values (0 = LS_INFO .. 3 = LS_FATAL) in the build to strip verbose logging from hot
+// builds. Do not set it above LS_FATAL - CHECK()s and LOG(LS_FATAL) must always fire.
 
 namespace base {
 
@@ -118,12 +123,22 @@ struct LoggingSettings
     //  destination: LOG_DEFAULT
     //  max_log_age: 7 days
     //  min_log_level: LS_INFO
+    //  max_log_size: 8 MB
+    //  max_log_files: 16
     LoggingSettings();
 
     LoggingDestination destination;
     LoggingSeverity min_log_level;
     int max_log_age;
 
+    // Size at which the active log file is closed and a new one is started, so a long-lived
+    // process never grows one unbounded file. Zero disables rotation.
+    size_t max_log_size;
+
+    // Number of rotated files of this process kept in the log directory; the oldest ones are
+    // removed when a new file is started. Zero disables the cap.
+    int max_log_files;
+
     std::filesystem::path log_dir;
 };
 
@@ -162,14 +177,21 @@ bool shouldCreateLogMessage(LoggingSeverity severity);
 #define COMPACT_LOG_LS_DFATAL  COMPACT_LOG_EX_LS_DFATAL(LogMessage)
 #define COMPACT_LOG_LS_DCHECK  COMPACT_LOG_EX_LS_DCHECK(LogMessage)
 
+// Severity level below which LOG() statements are compiled out entirely. The LS_* values are
+// compile-time constants, so the comparison in LOG_IS_ON folds to a constant and the dead branch
+// of LAZY_STREAM is removed by the compiler.
+#if !defined(LOG_MIN_LEVEL)
+#define LOG_MIN_LEVEL 0
+#endif
+
 // As special cases, we can assume that LOG_IS_ON(LS_FATAL) always holds. Also, LOG_IS_ON(LS_DFATAL)
 // always holds in debug mode. In particular, CHECK()s will always fire if they fail.
 #if defined(CC_MSVC)
 #define LOG_IS_ON(severity) \
-    (::base::shouldCreateLogMessage(::base::##severity))
+    (::base::##severity >= LOG_MIN_LEVEL && ::base::shouldCreateLogMessage(::base::##severity))
 #else
 #define LOG_IS_ON(severity) \
-    (::base::shouldCreateLogMessage(::base::severity))
+    (::base::severity >= LOG_MIN_LEVEL && ::base::shouldCreateLogMessage(::base::severity))
 #endif // CC_MSVC
 
 // Helper macro which avoids evaluating the arguments to a stream if the condition doesn't hold.
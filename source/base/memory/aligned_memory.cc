@@ -24,6 +24,12 @@
 #include <malloc.h>
 #endif
 
+#if defined(OS_WIN)
+#include <Windows.h>
+#elif defined(OS_POSIX)
+#include <sys/mman.h>
+#endif
+
 namespace base {
 
 void* alignedAlloc(size_t size, size_t alignment)
@@ -50,4 +56,55 @@ void* alignedAlloc(size_t size, size_t alignment)
     return ptr;
 }
 
+void* alignedHugeAlloc(size_t size, size_t alignment)
+{
+    DCHECK_GT(size, 0U);
+    DCHECK_EQ((alignment & (alignment - 1)), 0U);
+
+    void* ptr = nullptr;
+
+#if defined(OS_WIN)
+    // Large pages need SeLockMemoryPrivilege; try them first and quietly fall back to regular
+    // pages when the privilege is not held or large page memory is fragmented.
+    static const size_t large_page_size = GetLargePageMinimum();
+    if (large_page_size)
+    {
+        const size_t rounded_size = (size + large_page_size - 1) & ~(large_page_size - 1);
+        ptr = VirtualAlloc(nullptr, rounded_size,
+                           MEM_COMMIT | MEM_RESERVE | MEM_LARGE_PAGES, PAGE_READWRITE);
+    }
+
+    if (!ptr)
+        ptr = VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+#elif defined(OS_POSIX)
+    ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED)
+        ptr = nullptr;
+
+#if defined(MADV_HUGEPAGE)
+    // Best effort; the buffer works the same on kernels without transparent huge pages.
+    if (ptr)
+        madvise(ptr, size, MADV_HUGEPAGE);
+#endif
+#endif
+
+    CHECK(ptr);
+
+    // OS allocations are at least page aligned.
+    DCHECK_EQ((reinterpret_cast<uintptr_t>(ptr) & (alignment - 1)), 0U);
+    return ptr;
+}
+
+void alignedHugeFree(void* ptr, size_t size)
+{
+    if (!ptr)
+        return;
+
+#if defined(OS_WIN)
+    VirtualFree(ptr, 0, MEM_RELEASE);
+#elif defined(OS_POSIX)
+    munmap(ptr, size);
+#endif
+}
+
 } // namespace base
@@ -62,6 +62,14 @@ namespace base {
 
 void* alignedAlloc(size_t size, size_t alignment);
 
+// Allocates a large, long-lived buffer (e.g. a full frame) straight from the OS and asks the
+// kernel to back it with huge pages where available, cutting TLB pressure on multi-megabyte
+// buffers. The pages are committed on first touch, so they land on the NUMA node of the thread
+// that first writes the buffer. |alignment| must not exceed the OS page size. The buffer must
+// be released with alignedHugeFree() and the original |size| must be passed back to it.
+void* alignedHugeAlloc(size_t size, size_t alignment);
+void alignedHugeFree(void* ptr, size_t size);
+
 inline void alignedFree(void* ptr)
 {
 #if defined(OS_WIN)
@@ -20,6 +20,9 @@
 
 #include "base/logging.h"
 
+#include <algorithm>
+#include <utility>
+
 namespace base {
 
 namespace {
@@ -45,6 +48,271 @@ char hexToChar(int value)
 
 } // namespace
 
+ByteArray::ByteArray(size_t count)
+{
+    resize(count);
+}
+
+ByteArray::ByteArray(size_t count, uint8_t value)
+{
+    assign(count, value);
+}
+
+ByteArray::ByteArray(const uint8_t* first, const uint8_t* last)
+{
+    assign(first, last);
+}
+
+ByteArray::ByteArray(std::initializer_list<uint8_t> list)
+{
+    resize(list.size());
+
+    uint8_t* dst = data_;
+    for (uint8_t value : list)
+        *dst++ = value;
+}
+
+ByteArray::ByteArray(const ByteArray& other)
+{
+    assign(other.data_, other.data_ + other.size_);
+}
+
+ByteArray& ByteArray::operator=(const ByteArray& other)
+{
+    if (this != &other)
+        assign(other.data_, other.data_ + other.size_);
+
+    return *this;
+}
+
+ByteArray::ByteArray(ByteArray&& other) noexcept
+{
+    if (other.isInline())
+    {
+        memcpy(inline_buffer_, other.inline_buffer_, other.size_);
+        size_ = other.size_;
+    }
+    else
+    {
+        // Steal the heap block.
+        data_ = other.data_;
+        size_ = other.size_;
+        capacity_ = other.capacity_;
+
+        other.data_ = other.inline_buffer_;
+        other.capacity_ = kInlineCapacity;
+    }
+
+    other.size_ = 0;
+}
+
+ByteArray& ByteArray::operator=(ByteArray&& other) noexcept
+{
+    if (this == &other)
+        return *this;
+
+    if (other.isInline())
+    {
+        memcpy(data_, other.inline_buffer_, other.size_);
+        size_ = other.size_;
+    }
+    else
+    {
+        if (!isInline())
+            delete[] data_;
+
+        data_ = other.data_;
+        size_ = other.size_;
+        capacity_ = other.capacity_;
+
+        other.data_ = other.inline_buffer_;
+        other.capacity_ = kInlineCapacity;
+    }
+
+    other.size_ = 0;
+    return *this;
+}
+
+ByteArray::~ByteArray()
+{
+    if (!isInline())
+        delete[] data_;
+}
+
+void ByteArray::assign(size_t count, uint8_t value)
+{
+    resize(count);
+    memset(data_, value, count);
+}
+
+void ByteArray::assign(const uint8_t* first, const uint8_t* last)
+{
+    const size_t count = static_cast<size_t>(last - first);
+
+    resize(count);
+    memcpy(data_, first, count);
+}
+
+uint8_t& ByteArray::at(size_t pos)
+{
+    CHECK_LT(pos, size_);
+    return data_[pos];
+}
+
+const uint8_t& ByteArray::at(size_t pos) const
+{
+    CHECK_LT(pos, size_);
+    return data_[pos];
+}
+
+void ByteArray::reserve(size_t new_capacity)
+{
+    if (new_capacity <= capacity_)
+        return;
+
+    uint8_t* new_data = new uint8_t[new_capacity];
+    memcpy(new_data, data_, size_);
+
+    if (!isInline())
+        delete[] data_;
+
+    data_ = new_data;
+    capacity_ = new_capacity;
+}
+
+void ByteArray::shrink_to_fit()
+{
+    if (isInline() || size_ == capacity_)
+        return;
+
+    if (size_ <= kInlineCapacity)
+    {
+        uint8_t* heap_data = data_;
+
+        memcpy(inline_buffer_, heap_data, size_);
+        data_ = inline_buffer_;
+        capacity_ = kInlineCapacity;
+
+        delete[] heap_data;
+        return;
+    }
+
+    uint8_t* new_data = new uint8_t[size_];
+    memcpy(new_data, data_, size_);
+
+    delete[] data_;
+    data_ = new_data;
+    capacity_ = size_;
+}
+
+void ByteArray::resize(size_t new_size)
+{
+    if (new_size > capacity_)
+        grow(new_size);
+
+    size_ = new_size;
+}
+
+void ByteArray::resize(size_t new_size, uint8_t value)
+{
+    const size_t old_size = size_;
+
+    resize(new_size);
+
+    if (new_size > old_size)
+        memset(data_ + old_size, value, new_size - old_size);
+}
+
+void ByteArray::push_back(uint8_t value)
+{
+    if (size_ == capacity_)
+        grow(size_ + 1);
+
+    data_[size_++] = value;
+}
+
+uint8_t& ByteArray::emplace_back(uint8_t value)
+{
+    push_back(value);
+    return back();
+}
+
+ByteArray::iterator ByteArray::insert(const_iterator pos, uint8_t value)
+{
+    return insert(pos, &value, &value + 1);
+}
+
+ByteArray::iterator ByteArray::insert(const_iterator pos, size_t count, uint8_t value)
+{
+    uint8_t* gap = makeGap(static_cast<size_t>(pos - data_), count);
+
+    memset(gap, value, count);
+    return gap;
+}
+
+ByteArray::iterator ByteArray::insert(const_iterator pos, const uint8_t* first, const uint8_t* last)
+{
+    const size_t count = static_cast<size_t>(last - first);
+
+    // The source range may point into this buffer, which makeGap would move or reallocate.
+    if (first >= data_ && first < data_ + size_)
+    {
+        ByteArray copy(first, last);
+        return insert(pos, copy.data_, copy.data_ + copy.size_);
+    }
+
+    uint8_t* gap = makeGap(static_cast<size_t>(pos - data_), count);
+
+    memcpy(gap, first, count);
+    return gap;
+}
+
+ByteArray::iterator ByteArray::erase(const_iterator pos)
+{
+    return erase(pos, pos + 1);
+}
+
+ByteArray::iterator ByteArray::erase(const_iterator first, const_iterator last)
+{
+    const size_t offset = static_cast<size_t>(first - data_);
+    const size_t count = static_cast<size_t>(last - first);
+
+    memmove(data_ + offset, data_ + offset + count, size_ - offset - count);
+    size_ -= count;
+
+    return data_ + offset;
+}
+
+void ByteArray::swap(ByteArray& other) noexcept
+{
+    ByteArray temp(std::move(*this));
+
+    *this = std::move(other);
+    other = std::move(temp);
+}
+
+void ByteArray::grow(size_t minimum_capacity)
+{
+    reserve(std::max(minimum_capacity, capacity_ * 2));
+}
+
+uint8_t* ByteArray::makeGap(size_t offset, size_t count)
+{
+    if (size_ + count > capacity_)
+        grow(size_ + count);
+
+    memmove(data_ + offset + count, data_ + offset, size_ - offset);
+    size_ += count;
+
+    return data_ + offset;
+}
+
+bool operator<(const ByteArray& first, const ByteArray& second)
+{
+    return std::lexicographical_compare(first.begin(), first.end(),
+                                        second.begin(), second.end());
+}
+
 ByteArray fromData(const void* data, size_t size)
 {
     if (!data || !size)
@@ -135,6 +403,17 @@ base::ByteArray serialize(const google::protobuf::MessageLite& message)
     return buffer;
 }
 
+void serialize(const google::protobuf::MessageLite& message, base::ByteArray* buffer)
+{
+    const size_t size = message.ByteSizeLong();
+
+    buffer->resize(size);
+    if (!size)
+        return;
+
+    message.SerializeWithCachedSizesToArray(buffer->data());
+}
+
 int compare(const base::ByteArray& first, const base::ByteArray& second)
 {
     if (first.empty() && second.empty())
@@ -22,12 +22,147 @@
 #include <google/protobuf/message_lite.h>
 
 #include <cstdint>
+#include <cstring>
+#include <iterator>
 #include <string>
-#include <vector>
 
 namespace base {
 
-using ByteArray = std::vector<uint8_t>;
+// Dynamically sized byte buffer that replaces the former std::vector<uint8_t> alias.
+//
+// - Buffers of up to kInlineCapacity bytes live inside the object itself (small-buffer
+//   optimization), so keys, hashes and short control messages never touch the heap.
+// - resize() leaves newly added bytes uninitialized. The buffers carry raw I/O data where every
+//   byte is overwritten anyway, and the zero-fill of std::vector::resize showed up prominently
+//   in allocation profiles. Use resize(size, value) when the content matters.
+// - clear() keeps the capacity, so long-lived buffers (network channels, encryptors) settle at
+//   their peak size and stop allocating.
+//
+// The interface follows std::vector, so existing code does not change.
+class ByteArray
+{
+public:
+    using value_type = uint8_t;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using reference = uint8_t&;
+    using const_reference = const uint8_t&;
+    using pointer = uint8_t*;
+    using const_pointer = const uint8_t*;
+    using iterator = uint8_t*;
+    using const_iterator = const uint8_t*;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    static constexpr size_t kInlineCapacity = 64;
+
+    ByteArray() = default;
+    explicit ByteArray(size_t count);
+    ByteArray(size_t count, uint8_t value);
+    ByteArray(const uint8_t* first, const uint8_t* last);
+    ByteArray(std::initializer_list<uint8_t> list);
+
+    ByteArray(const ByteArray& other);
+    ByteArray& operator=(const ByteArray& other);
+
+    ByteArray(ByteArray&& other) noexcept;
+    ByteArray& operator=(ByteArray&& other) noexcept;
+
+    ~ByteArray();
+
+    void assign(size_t count, uint8_t value);
+    void assign(const uint8_t* first, const uint8_t* last);
+
+    uint8_t* data() { return data_; }
+    const uint8_t* data() const { return data_; }
+
+    uint8_t& operator[](size_t pos) { return data_[pos]; }
+    const uint8_t& operator[](size_t pos) const { return data_[pos]; }
+
+    uint8_t& at(size_t pos);
+    const uint8_t& at(size_t pos) const;
+
+    uint8_t& front() { return data_[0]; }
+    const uint8_t& front() const { return data_[0]; }
+
+    uint8_t& back() { return data_[size_ - 1]; }
+    const uint8_t& back() const { return data_[size_ - 1]; }
+
+    iterator begin() { return data_; }
+    const_iterator begin() const { return data_; }
+    const_iterator cbegin() const { return data_; }
+
+    iterator end() { return data_ + size_; }
+    const_iterator end() const { return data_ + size_; }
+    const_iterator cend() const { return data_ + size_; }
+
+    reverse_iterator rbegin() { return reverse_iterator(end()); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator crbegin() const { return const_reverse_iterator(cend()); }
+
+    reverse_iterator rend() { return reverse_iterator(begin()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+    const_reverse_iterator crend() const { return const_reverse_iterator(cbegin()); }
+
+    bool empty() const { return size_ == 0; }
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+
+    void reserve(size_t new_capacity);
+    void shrink_to_fit();
+
+    // Keeps the capacity, so a reused buffer does not reallocate.
+    void clear() { size_ = 0; }
+
+    // Grows without initializing the new bytes; shrinking never reallocates.
+    void resize(size_t new_size);
+    void resize(size_t new_size, uint8_t value);
+
+    void push_back(uint8_t value);
+    uint8_t& emplace_back(uint8_t value);
+    void pop_back() { --size_; }
+
+    iterator insert(const_iterator pos, uint8_t value);
+    iterator insert(const_iterator pos, size_t count, uint8_t value);
+    iterator insert(const_iterator pos, const uint8_t* first, const uint8_t* last);
+
+    iterator erase(const_iterator pos);
+    iterator erase(const_iterator first, const_iterator last);
+
+    void swap(ByteArray& other) noexcept;
+
+private:
+    // Grows the capacity to hold at least |minimum_capacity| bytes, doubling to keep repeated
+    // appends amortized O(1).
+    void grow(size_t minimum_capacity);
+
+    // Makes a gap of |count| bytes at |offset|. Returns a pointer to the gap.
+    uint8_t* makeGap(size_t offset, size_t count);
+
+    bool isInline() const { return data_ == inline_buffer_; }
+
+    size_t size_ = 0;
+    size_t capacity_ = kInlineCapacity;
+    uint8_t* data_ = inline_buffer_;
+    uint8_t inline_buffer_[kInlineCapacity];
+};
+
+inline bool operator==(const ByteArray& first, const ByteArray& second)
+{
+    return first.size() == second.size() &&
+           (first.empty() || memcmp(first.data(), second.data(), first.size()) == 0);
+}
+
+inline bool operator!=(const ByteArray& first, const ByteArray& second)
+{
+    return !(first == second);
+}
+
+bool operator<(const ByteArray& first, const ByteArray& second);
+
+inline bool operator>(const ByteArray& first, const ByteArray& second) { return second < first; }
+inline bool operator<=(const ByteArray& first, const ByteArray& second) { return !(second < first); }
+inline bool operator>=(const ByteArray& first, const ByteArray& second) { return !(first < second); }
 
 ByteArray fromData(const void* data, size_t size);
 
@@ -39,6 +174,10 @@ std::string toHex(const ByteArray& in);
 
 base::ByteArray serialize(const google::protobuf::MessageLite& message);
 
+// Serializes into an existing buffer, so a send path can reuse one grown-once buffer instead of
+// allocating per message. The buffer is resized to the exact message size.
+void serialize(const google::protobuf::MessageLite& message, base::ByteArray* buffer);
+
 template <class T>
 bool parse(const base::ByteArray& buffer, T* message)
 {
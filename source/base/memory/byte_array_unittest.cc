@@ -124,4 +124,85 @@ TEST(ByteArray, HexConvert)
     }
 }
 
+TEST(ByteArray, SmallBuffer)
+{
+    ByteArray array;
+
+    EXPECT_TRUE(array.empty());
+    EXPECT_EQ(array.capacity(), ByteArray::kInlineCapacity);
+
+    for (size_t i = 0; i < ByteArray::kInlineCapacity; ++i)
+        array.push_back(static_cast<uint8_t>(i));
+
+    // Still inside the inline buffer.
+    EXPECT_EQ(array.capacity(), ByteArray::kInlineCapacity);
+
+    // One more byte spills to the heap.
+    array.push_back(0xFF);
+    EXPECT_GT(array.capacity(), ByteArray::kInlineCapacity);
+    EXPECT_EQ(array.size(), ByteArray::kInlineCapacity + 1);
+
+    for (size_t i = 0; i < ByteArray::kInlineCapacity; ++i)
+        EXPECT_EQ(array[i], static_cast<uint8_t>(i));
+    EXPECT_EQ(array.back(), 0xFF);
+}
+
+TEST(ByteArray, MoveSemantics)
+{
+    ByteArray small = fromStdString("small");
+    ByteArray moved_small = std::move(small);
+
+    EXPECT_EQ(toStdString(moved_small), "small");
+    EXPECT_TRUE(small.empty());
+
+    ByteArray large;
+    large.resize(1024, 0xAB);
+
+    const void* heap_data = large.data();
+
+    ByteArray moved_large = std::move(large);
+
+    // A heap block is stolen, not copied.
+    EXPECT_EQ(moved_large.data(), heap_data);
+    EXPECT_EQ(moved_large.size(), 1024u);
+    EXPECT_TRUE(large.empty());
+
+    large = std::move(moved_large);
+    EXPECT_EQ(large.size(), 1024u);
+    EXPECT_EQ(large[1023], 0xAB);
+}
+
+TEST(ByteArray, ClearKeepsCapacity)
+{
+    ByteArray array;
+    array.resize(1024);
+
+    const size_t capacity = array.capacity();
+
+    array.clear();
+    EXPECT_TRUE(array.empty());
+    EXPECT_EQ(array.capacity(), capacity);
+
+    array.shrink_to_fit();
+    EXPECT_EQ(array.capacity(), ByteArray::kInlineCapacity);
+}
+
+TEST(ByteArray, InsertErase)
+{
+    ByteArray array = fromStdString("hello world");
+
+    array.insert(array.begin() + 5, static_cast<uint8_t>(','));
+    EXPECT_EQ(toStdString(array), "hello, world");
+
+    array.erase(array.begin(), array.begin() + 7);
+    EXPECT_EQ(toStdString(array), "world");
+
+    // Inserting a buffer's own bytes must survive reallocation.
+    array.insert(array.end(), array.begin(), array.end());
+    EXPECT_EQ(toStdString(array), "worldworld");
+
+    array.erase(array.begin() + 5);
+    EXPECT_EQ(toStdString(array), "worldorld");
+}
+
 } // namespace base
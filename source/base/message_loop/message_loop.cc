@@ -127,6 +127,13 @@ void MessageLoop::postTask(PendingTask::Callback callback)
     addToIncomingQueue(std::move(callback), Milliseconds::zero(), true);
 }
 
+void MessageLoop::postTask(PendingTask::Callback callback, TaskRunner::Priority priority,
+                           const Milliseconds& deadline)
+{
+    DCHECK(callback != nullptr);
+    addToIncomingQueue(std::move(callback), Milliseconds::zero(), true, priority, deadline);
+}
+
 void MessageLoop::postDelayedTask(PendingTask::Callback callback, const Milliseconds& delay)
 {
     DCHECK(callback != nullptr);
@@ -196,28 +203,26 @@ void MessageLoop::addToDelayedWorkQueue(PendingTask* pending_task)
     // Move to the delayed work queue.  Initialize the sequence number before inserting into the
     // delayed_work_queue_. The sequence number is used to faciliate FIFO sorting when two tasks
     // have the same delayed_run_time value.
-    delayed_work_queue_.emplace(std::move(pending_task->callback),
-                                pending_task->delayed_run_time,
-                                pending_task->nestable,
-                                next_sequence_num_++);
+    delayed_work_queue_.insert(PendingTask(std::move(pending_task->callback),
+                                           pending_task->delayed_run_time,
+                                           pending_task->nestable,
+                                           next_sequence_num_++));
 }
 
 void MessageLoop::addToIncomingQueue(
-    PendingTask::Callback&& callback, const Milliseconds& delay, bool nestable)
+    PendingTask::Callback&& callback, const Milliseconds& delay, bool nestable,
+    TaskRunner::Priority priority, const Milliseconds& deadline)
 {
-    bool empty;
-
-    {
-        std::scoped_lock lock(incoming_queue_lock_);
+    PendingTask pending_task(std::move(callback), calculateDelayedRuntime(delay), nestable);
+    pending_task.priority = priority;
 
-        empty = incoming_queue_.empty();
+    if (deadline != Milliseconds::zero())
+        pending_task.deadline = Clock::now() + deadline;
 
-        incoming_queue_.emplace(std::move(callback),
-                                calculateDelayedRuntime(delay),
-                                nestable);
-    }
+    incoming_queue_.push(std::move(pending_task));
 
-    if (!empty)
+    // Wake the pump up unless a wakeup is pending already.
+    if (wakeup_pending_.exchange(true, std::memory_order_acq_rel))
         return;
 
     std::shared_ptr<MessagePump> pump(pump_);
@@ -229,13 +234,12 @@ void MessageLoop::reloadWorkQueue()
     if (!work_queue_.empty())
         return;
 
-    std::scoped_lock lock(incoming_queue_lock_);
-
-    if (incoming_queue_.empty())
-        return;
+    // Consume the pending wakeup before draining: a task pushed after this point schedules its
+    // own wakeup. The exchange also synchronizes with the producers whose pushes the flag
+    // covers, so their tasks are visible to the drain below.
+    wakeup_pending_.exchange(false, std::memory_order_acq_rel);
 
-    incoming_queue_.Swap(&work_queue_);
-    DCHECK(incoming_queue_.empty());
+    incoming_queue_.drainTo(&work_queue_);
 }
 
 bool MessageLoop::deletePendingTasks()
@@ -255,15 +259,27 @@ bool MessageLoop::deletePendingTasks()
         }
     }
 
+    for (size_t i = 0; i < kPriorityCount; ++i)
+    {
+        did_work |= !priority_queues_[i].empty();
+
+        while (!priority_queues_[i].empty())
+            priority_queues_[i].pop();
+    }
+
+    deadline_task_count_ = 0;
+
     did_work |= !deferred_non_nestable_work_queue_.empty();
 
     while (!deferred_non_nestable_work_queue_.empty())
         deferred_non_nestable_work_queue_.pop();
 
-    did_work |= !delayed_work_queue_.empty();
+    did_work |= !delayed_work_queue_.empty() || !ready_delayed_tasks_.empty();
+
+    delayed_work_queue_.clear();
 
-    while (!delayed_work_queue_.empty())
-        delayed_work_queue_.pop();
+    while (!ready_delayed_tasks_.empty())
+        ready_delayed_tasks_.pop();
 
     return did_work;
 }
@@ -279,6 +295,36 @@ MessageLoop::TimePoint MessageLoop::calculateDelayedRuntime(const Milliseconds&
     return delayed_run_time;
 }
 
+TaskQueue* MessageLoop::nextTaskQueue()
+{
+    // Only the queue fronts are examined, so within one class the order stays FIFO even when
+    // deadlines are mixed; a deadline bounds deferral by the higher classes, not reordering
+    // inside its own class.
+    if (deadline_task_count_ != 0)
+    {
+        const TimePoint now = Clock::now();
+
+        for (size_t i = 1; i < kPriorityCount; ++i)
+        {
+            TaskQueue& queue = priority_queues_[i];
+
+            if (!queue.empty() && queue.front().deadline != TimePoint() &&
+                queue.front().deadline <= now)
+            {
+                return &queue;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < kPriorityCount; ++i)
+    {
+        if (!priority_queues_[i].empty())
+            return &priority_queues_[i];
+    }
+
+    return nullptr;
+}
+
 bool MessageLoop::doWork()
 {
     if (!nestable_tasks_allowed_)
@@ -291,11 +337,9 @@ bool MessageLoop::doWork()
     {
         reloadWorkQueue();
 
-        if (work_queue_.empty())
-            break;
-
-        // Execute oldest task.
-        do
+        // Distribute the drained batch: delayed tasks go to the timer wheel, immediate tasks
+        // to the queue of their scheduling class.
+        while (!work_queue_.empty())
         {
             PendingTask pending_task = work_queue_.front();
             work_queue_.pop();
@@ -308,15 +352,30 @@ bool MessageLoop::doWork()
 
                 // If we changed the topmost task, then it is time to reschedule.
                 if (reschedule)
-                    pump_->scheduleDelayedWork(pending_task.delayed_run_time);
+                    pump_->scheduleDelayedWork(delayed_work_queue_.nextWakeTime());
             }
             else
             {
-                if (deferOrRunPendingTask(pending_task))
-                    return true;
+                if (pending_task.deadline != TimePoint())
+                    ++deadline_task_count_;
+
+                priority_queues_[static_cast<size_t>(pending_task.priority)].emplace(
+                    std::move(pending_task));
             }
         }
-        while (!work_queue_.empty());
+
+        TaskQueue* queue = nextTaskQueue();
+        if (!queue)
+            break;
+
+        PendingTask pending_task = queue->front();
+        queue->pop();
+
+        if (pending_task.deadline != TimePoint())
+            --deadline_task_count_;
+
+        if (deferOrRunPendingTask(pending_task))
+            return true;
     }
 
     // Nothing happened.
@@ -325,7 +384,8 @@ bool MessageLoop::doWork()
 
 bool MessageLoop::doDelayedWork(TimePoint* next_delayed_work_time)
 {
-    if (!nestable_tasks_allowed_ || delayed_work_queue_.empty())
+    if (!nestable_tasks_allowed_ ||
+        (delayed_work_queue_.empty() && ready_delayed_tasks_.empty()))
     {
         recent_time_ = *next_delayed_work_time = TimePoint();
         return false;
@@ -337,23 +397,38 @@ bool MessageLoop::doDelayedWork(TimePoint* next_delayed_work_time)
     // As a result, the more we fall behind (and have a lot of ready-to-run delayed tasks), the more
     // efficient we'll be at handling the tasks.
 
-    TimePoint next_run_time = delayed_work_queue_.top().delayed_run_time;
-
-    if (next_run_time > recent_time_)
+    if (ready_delayed_tasks_.empty())
     {
-        recent_time_ = Clock::now();
+        TimePoint next_run_time = delayed_work_queue_.nextWakeTime();
+
         if (next_run_time > recent_time_)
         {
-            *next_delayed_work_time = next_run_time;
+            recent_time_ = Clock::now();
+            if (next_run_time > recent_time_)
+            {
+                *next_delayed_work_time = next_run_time;
+                return false;
+            }
+        }
+
+        // Collect every task that is due by now in one pass over the wheel.
+        delayed_work_queue_.advanceTo(recent_time_, &ready_delayed_tasks_);
+
+        if (ready_delayed_tasks_.empty())
+        {
+            // Only timers of the coarser wheel levels moved down; nothing is due yet.
+            *next_delayed_work_time = delayed_work_queue_.nextWakeTime();
             return false;
         }
     }
 
-    PendingTask pending_task = delayed_work_queue_.top();
-    delayed_work_queue_.pop();
+    PendingTask pending_task = ready_delayed_tasks_.front();
+    ready_delayed_tasks_.pop();
 
-    if (!delayed_work_queue_.empty())
-        *next_delayed_work_time = delayed_work_queue_.top().delayed_run_time;
+    if (!ready_delayed_tasks_.empty())
+        *next_delayed_work_time = recent_time_;
+    else if (!delayed_work_queue_.empty())
+        *next_delayed_work_time = delayed_work_queue_.nextWakeTime();
 
     return deferOrRunPendingTask(pending_task);
 }
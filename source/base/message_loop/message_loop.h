@@ -23,11 +23,13 @@
 #include "base/task_runner.h"
 #include "base/message_loop/message_pump.h"
 #include "base/message_loop/message_pump_dispatcher.h"
+#include "base/message_loop/mpsc_task_queue.h"
 #include "base/message_loop/pending_task.h"
+#include "base/message_loop/timer_wheel.h"
 #include "build/build_config.h"
 
+#include <atomic>
 #include <memory>
-#include <mutex>
 
 namespace base {
 
@@ -76,6 +78,8 @@ protected:
     using Milliseconds = MessagePump::Milliseconds;
 
     void postTask(PendingTask::Callback callback);
+    void postTask(PendingTask::Callback callback, TaskRunner::Priority priority,
+                  const Milliseconds& deadline);
     void postDelayedTask(PendingTask::Callback callback, const Milliseconds& delay);
     void postNonNestableTask(PendingTask::Callback callback);
     void postNonNestableDelayedTask(PendingTask::Callback callback, const Milliseconds& delay);
@@ -97,7 +101,14 @@ protected:
     // Caller retains ownership of |pending_task|, but this function will reset the value of
     // pending_task->task. This is needed to ensure that the posting call stack does not retain
     // pending_task->task beyond this function call.
-    void addToIncomingQueue(PendingTask::Callback&& callback, const Milliseconds& delay, bool nestable);
+    void addToIncomingQueue(PendingTask::Callback&& callback, const Milliseconds& delay, bool nestable,
+                            TaskRunner::Priority priority = TaskRunner::Priority::INTERACTIVE,
+                            const Milliseconds& deadline = Milliseconds::zero());
+
+    // Returns the queue the next immediate task should be taken from, or nullptr when all of
+    // them are empty. Picks the highest non-empty scheduling class, unless a task of a lower
+    // class has exceeded its deadline.
+    TaskQueue* nextTaskQueue();
 
     // Load tasks from the incoming_queue_ into work_queue_ if the latter is empty. The former
     // requires a lock to access, while the latter is directly accessible on this thread.
@@ -118,13 +129,27 @@ protected:
     // A recent snapshot of Clock::now(), used to check delayed_work_queue_.
     TimePoint recent_time_;
 
-    // Contains delayed tasks, sorted by their 'delayed_run_time' property.
-    DelayedTaskQueue delayed_work_queue_;
+    // Contains delayed tasks, bucketed by their 'delayed_run_time' property. Arming a timer is
+    // O(1), which matters for connection keep-alive and timeout timers at scale.
+    TimerWheel delayed_work_queue_;
+
+    // Delayed tasks whose deadline has been reached, in deadline order. Filled in batches by
+    // advancing |delayed_work_queue_|.
+    TaskQueue ready_delayed_tasks_;
 
     // A list of tasks that need to be processed by this instance.  Note that this queue is only
     // accessed (push/pop) by our current thread.
     TaskQueue work_queue_;
 
+    // Immediate tasks distributed from |work_queue_| by scheduling class, indexed by
+    // TaskRunner::Priority. Drained highest class first, so housekeeping never delays work on
+    // the frame path; an expired deadline lets a lower-class task jump the order.
+    // |deadline_task_count_| tracks how many queued tasks carry a deadline, so selection pays
+    // for a clock read only when one exists.
+    static constexpr size_t kPriorityCount = 3;
+    TaskQueue priority_queues_[kPriorityCount];
+    size_t deadline_task_count_ = 0;
+
     // A queue of non-nestable tasks that we had to defer because when it came time to execute them
     // we were in a nested message loop. They will execute once we're out of nested message loops.
     TaskQueue deferred_non_nestable_work_queue_;
@@ -135,8 +160,13 @@ protected:
 
     std::shared_ptr<MessagePump> pump_;
 
-    TaskQueue incoming_queue_;
-    std::mutex incoming_queue_lock_;
+    // Lock-free queue of tasks posted from other threads. Posting never blocks; the tasks are
+    // drained into |work_queue_| in batches by the loop thread.
+    MpscTaskQueue incoming_queue_;
+
+    // Set when a wakeup of the pump has been scheduled and not consumed yet. Keeps every post
+    // from scheduling its own wakeup.
+    std::atomic_bool wakeup_pending_ = false;
 
     // The next sequence number to use for delayed tasks.
     int next_sequence_num_ = 0;
@@ -18,6 +18,8 @@
 
 #include "base/message_loop/message_loop_task_runner.h"
 
+#include <mutex>
+
 namespace base {
 
 // static
@@ -44,6 +46,15 @@ void MessageLoopTaskRunner::postTask(Callback callback)
         loop_->postTask(std::move(callback));
 }
 
+void MessageLoopTaskRunner::postTask(Callback callback, Priority priority,
+                                     const Milliseconds& deadline)
+{
+    std::shared_lock lock(loop_lock_);
+
+    if (loop_)
+        loop_->postTask(std::move(callback), priority, deadline);
+}
+
 void MessageLoopTaskRunner::postDelayedTask(Callback callback, const Milliseconds& delay)
 {
     std::shared_lock lock(loop_lock_);
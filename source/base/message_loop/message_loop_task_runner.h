@@ -36,6 +36,8 @@ public:
     // TaskRunner implementation.
     bool belongsToCurrentThread() const override;
     void postTask(Callback callback) override;
+    void postTask(Callback callback, Priority priority,
+                  const Milliseconds& deadline = Milliseconds::zero()) override;
     void postDelayedTask(Callback callback, const Milliseconds& delay) override;
     void postNonNestableTask(Callback callback) override;
     void postNonNestableDelayedTask(Callback callback, const Milliseconds& delay) override;
@@ -43,8 +43,22 @@ void MessagePumpForAsio::run(Delegate* delegate)
         // Restart the io_context in preparation for a subsequent pull() invocation.
         io_context_.restart();
 
-        // Run the io_context object's event processing loop to execute ready handlers.
-        did_work |= io_context_.poll() != 0;
+        if (max_handler_batch_size_)
+        {
+            // Execute at most a batch of ready handlers, then give the task and timer queues a
+            // turn again. Without the bound a flood of I/O events would starve them.
+            size_t executed = 0;
+            while (executed < max_handler_batch_size_ && io_context_.poll_one())
+                ++executed;
+
+            did_work |= executed != 0;
+        }
+        else
+        {
+            // Run the io_context object's event processing loop to execute ready handlers.
+            did_work |= io_context_.poll() != 0;
+        }
+
         if (!keep_running_)
             break;
 
@@ -58,6 +72,15 @@ void MessagePumpForAsio::run(Delegate* delegate)
         if (did_work)
             continue;
 
+        if (idle_callback_)
+        {
+            // The loop is about to go to sleep; housekeeping runs here, where it cannot compete
+            // with ready handlers or due tasks.
+            idle_callback_();
+            if (!keep_running_)
+                break;
+        }
+
         if (delayed_work_time_ == TimePoint())
         {
             // Restart the io_context in preparation for a subsequent run_one() invocation.
@@ -24,6 +24,8 @@
 
 #include <asio/io_context.hpp>
 
+#include <functional>
+
 namespace base {
 
 class MessagePumpForAsio : public MessagePump
@@ -40,6 +42,17 @@ public:
 
     asio::io_context& ioContext() { return io_context_; }
 
+    // Limits the number of ready asio handlers executed per loop iteration before the task and
+    // timer queues get a turn again, so a flood of I/O events cannot starve them. Zero removes
+    // the limit. Must be called on the thread that runs the loop.
+    void setMaxHandlerBatchSize(size_t size) { max_handler_batch_size_ = size; }
+
+    // Sets a callback that runs when the loop is about to go to sleep: all ready handlers,
+    // tasks and timers are done. Deferred housekeeping (pool trimming, cache eviction) belongs
+    // here, where it does not compete with frame deadlines. The callback must be cheap, it runs
+    // on every transition to sleep. Must be set on the thread that runs the loop.
+    void setIdleCallback(std::function<void()> callback) { idle_callback_ = std::move(callback); }
+
 private:
     // This flag is set to false when run() should return.
     bool keep_running_ = true;
@@ -49,6 +62,12 @@ private:
     // The time at which we should call doDelayedWork.
     TimePoint delayed_work_time_;
 
+    // Upper bound of ready handlers executed per loop iteration; zero means no limit.
+    size_t max_handler_batch_size_ = 64;
+
+    // Runs when the loop is about to go to sleep. See setIdleCallback().
+    std::function<void()> idle_callback_;
+
     DISALLOW_COPY_AND_ASSIGN(MessagePumpForAsio);
 };
 
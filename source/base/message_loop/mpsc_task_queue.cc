@@ -0,0 +1,135 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/message_loop/mpsc_task_queue.h"
+
+namespace base {
+
+MpscTaskQueue::Node::Node()
+    : next(nullptr),
+      task(PendingTask::Callback(), PendingTask::TimePoint(), true)
+{
+    // Nothing
+}
+
+MpscTaskQueue::Node::Node(PendingTask&& task)
+    : next(nullptr),
+      task(std::move(task))
+{
+    // Nothing
+}
+
+MpscTaskQueue::MpscTaskQueue()
+    : head_(&stub_),
+      tail_(&stub_)
+{
+    // Nothing
+}
+
+MpscTaskQueue::~MpscTaskQueue()
+{
+    // Delete the tasks that were never taken by the consumer. At this point no producers are
+    // running anymore.
+    Node* node = tail_;
+
+    while (node)
+    {
+        Node* next = node->next.load(std::memory_order_acquire);
+
+        if (node != &stub_)
+            delete node;
+
+        node = next;
+    }
+}
+
+void MpscTaskQueue::push(PendingTask&& task)
+{
+    Node* node = new Node(std::move(task));
+
+    // The queue grows at the head. Between the exchange and the store the queue is observed as
+    // ending at the previous node; the consumer detects the gap and stops draining there.
+    Node* prev = head_.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+}
+
+void MpscTaskQueue::drainTo(TaskQueue* work_queue)
+{
+    for (;;)
+    {
+        Node* node = popNode();
+        if (!node)
+            break;
+
+        work_queue->emplace(std::move(node->task));
+        delete node;
+    }
+}
+
+MpscTaskQueue::Node* MpscTaskQueue::popNode()
+{
+    Node* tail = tail_;
+    Node* next = tail->next.load(std::memory_order_acquire);
+
+    if (tail == &stub_)
+    {
+        if (!next)
+        {
+            // The queue is empty.
+            return nullptr;
+        }
+
+        // Skip the permanent stub node.
+        tail_ = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+
+    if (next)
+    {
+        tail_ = next;
+        return tail;
+    }
+
+    if (tail != head_.load(std::memory_order_acquire))
+    {
+        // A producer has exchanged the head but has not linked its node yet. It wakes the
+        // consumer up after the push is finished, so nothing is lost by stopping here.
+        return nullptr;
+    }
+
+    // |tail| is the last node in the queue. The stub is pushed back first, so that the queue
+    // stays properly terminated while |tail| is taken out.
+    stub_.next.store(nullptr, std::memory_order_relaxed);
+
+    Node* prev = head_.exchange(&stub_, std::memory_order_acq_rel);
+    prev->next.store(&stub_, std::memory_order_release);
+
+    next = tail->next.load(std::memory_order_acquire);
+    if (next)
+    {
+        tail_ = next;
+        return tail;
+    }
+
+    // A producer pushed a node between the head check and the stub push; |tail| is linked to
+    // that node shortly and both are taken at the next drain.
+    return nullptr;
+}
+
+} // namespace base
@@ -0,0 +1,68 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__MESSAGE_LOOP__MPSC_TASK_QUEUE_H
+#define BASE__MESSAGE_LOOP__MPSC_TASK_QUEUE_H
+
+#include "base/macros_magic.h"
+#include "base/message_loop/pending_task.h"
+
+#include <atomic>
+
+namespace base {
+
+// Unbounded lock-free queue of pending tasks with multiple producers and a single consumer
+// (an intrusive MPSC queue). Producers never block each other or the consumer, so tasks can be
+// posted from any thread without contention on a lock.
+class MpscTaskQueue
+{
+public:
+    MpscTaskQueue();
+    ~MpscTaskQueue();
+
+    // Adds the task to the end of the queue. Can be called from any thread.
+    void push(PendingTask&& task);
+
+    // Moves the queued tasks to |work_queue| in the order they were pushed. Can be called only
+    // on the consumer thread.
+    void drainTo(TaskQueue* work_queue);
+
+private:
+    struct Node
+    {
+        Node();
+        explicit Node(PendingTask&& task);
+
+        std::atomic<Node*> next;
+        PendingTask task;
+    };
+
+    // Takes the node at the front of the queue. Returns nullptr if the queue is empty or a
+    // producer has not finished linking its node yet.
+    Node* popNode();
+
+    Node stub_;
+    std::atomic<Node*> head_; // Producer side: the most recently pushed node.
+    Node* tail_;              // Consumer side: the next node to take.
+
+    DISALLOW_COPY_AND_ASSIGN(MpscTaskQueue);
+};
+
+} // namespace base
+
+#endif // BASE__MESSAGE_LOOP__MPSC_TASK_QUEUE_H
@@ -0,0 +1,114 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/message_loop/mpsc_task_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+namespace base {
+
+namespace {
+
+PendingTask makeTask(PendingTask::Callback callback)
+{
+    return PendingTask(std::move(callback), PendingTask::TimePoint(), true);
+}
+
+} // namespace
+
+TEST(MpscTaskQueueTest, Empty)
+{
+    MpscTaskQueue queue;
+    TaskQueue work_queue;
+
+    queue.drainTo(&work_queue);
+    EXPECT_TRUE(work_queue.empty());
+}
+
+TEST(MpscTaskQueueTest, FifoOrder)
+{
+    MpscTaskQueue queue;
+    TaskQueue work_queue;
+
+    std::vector<int> order;
+
+    for (int i = 0; i < 10; ++i)
+        queue.push(makeTask([&order, i]() { order.push_back(i); }));
+
+    queue.drainTo(&work_queue);
+    EXPECT_EQ(work_queue.size(), 10u);
+
+    while (!work_queue.empty())
+    {
+        work_queue.front().callback();
+        work_queue.pop();
+    }
+
+    for (int i = 0; i < 10; ++i)
+        EXPECT_EQ(order[static_cast<size_t>(i)], i);
+
+    // After the drain the queue is usable again.
+    queue.drainTo(&work_queue);
+    EXPECT_TRUE(work_queue.empty());
+}
+
+TEST(MpscTaskQueueTest, ConcurrentProducers)
+{
+    const int kProducerCount = 4;
+    const int kTasksPerProducer = 10000;
+
+    MpscTaskQueue queue;
+
+    std::atomic_int counter { 0 };
+    std::vector<std::thread> producers;
+
+    for (int i = 0; i < kProducerCount; ++i)
+    {
+        producers.emplace_back([&queue, &counter]()
+        {
+            for (int k = 0; k < kTasksPerProducer; ++k)
+                queue.push(makeTask([&counter]() { ++counter; }));
+        });
+    }
+
+    // Drain concurrently with the producers. Every task must be received exactly once.
+    size_t received = 0;
+    while (received < kProducerCount * kTasksPerProducer)
+    {
+        TaskQueue work_queue;
+        queue.drainTo(&work_queue);
+
+        received += work_queue.size();
+
+        while (!work_queue.empty())
+        {
+            work_queue.front().callback();
+            work_queue.pop();
+        }
+    }
+
+    for (std::thread& thread : producers)
+        thread.join();
+
+    EXPECT_EQ(counter, kProducerCount * kTasksPerProducer);
+}
+
+} // namespace base
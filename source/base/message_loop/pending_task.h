@@ -19,6 +19,8 @@
 #ifndef BASE__MESSAGE_LOOP__PENDING_TASK_H
 #define BASE__MESSAGE_LOOP__PENDING_TASK_H
 
+#include "base/task_runner.h"
+
 #include <chrono>
 #include <functional>
 #include <queue>
@@ -53,6 +55,13 @@ public:
 
     // OK to dispatch from a nested loop.
     bool nestable;
+
+    // Scheduling class. Applies to immediate tasks; the delayed task machinery ignores it.
+    TaskRunner::Priority priority = TaskRunner::Priority::INTERACTIVE;
+
+    // Optional time after which the task runs ahead of the higher scheduling classes.
+    // A null value means no deadline.
+    TimePoint deadline;
 };
 
 // Wrapper around std::queue specialized for PendingTask which adds a Swap helper method.
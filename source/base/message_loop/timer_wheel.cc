@@ -0,0 +1,208 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/message_loop/timer_wheel.h"
+
+#include "base/logging.h"
+
+namespace base {
+
+TimerWheel::TimerWheel()
+    : origin_(Clock::now())
+{
+    for (int i = 0; i < kWheelCount; ++i)
+        occupancy_[i] = 0;
+}
+
+void TimerWheel::insert(PendingTask&& task)
+{
+    uint64_t expiry_tick = tickFromTime(task.delayed_run_time);
+
+    // A deadline in the past (or at the current tick) fires at the next advance.
+    if (expiry_tick <= current_tick_)
+        expiry_tick = current_tick_ + 1;
+
+    insertAtTick(std::move(task), expiry_tick);
+    ++size_;
+}
+
+void TimerWheel::advanceTo(TimePoint now, TaskQueue* ready)
+{
+    uint64_t target = 0;
+
+    if (now > origin_)
+    {
+        target = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(now - origin_).count());
+    }
+
+    while (size_ != 0 && current_tick_ < target)
+    {
+        // Jump straight to the next slot that expires or cascades; the slots in between are
+        // known to be empty from the occupancy bits.
+        uint64_t next = nextEventTick();
+        DCHECK_GT(next, current_tick_);
+
+        if (next > target)
+            break;
+
+        current_tick_ = next;
+
+        // Move the timers of the coarser levels whose window starts at this tick one level down.
+        for (int level = 1; level < kWheelCount; ++level)
+        {
+            if (current_tick_ & ((1ull << (kWheelBits * level)) - 1))
+                break;
+
+            cascade(level, static_cast<int>(
+                (current_tick_ >> (kWheelBits * level)) & (kWheelSize - 1)));
+        }
+
+        // Everything in the current slot of the finest level is due now.
+        Slot& slot = wheel_[0][current_tick_ & (kWheelSize - 1)];
+
+        for (PendingTask& task : slot)
+        {
+            ready->emplace(std::move(task));
+            --size_;
+        }
+
+        slot.clear();
+        occupancy_[0] &= ~(1ull << (current_tick_ & (kWheelSize - 1)));
+    }
+
+    // The clock in use is not guaranteed to be monotonic; never move the wheel backwards.
+    if (target > current_tick_)
+        current_tick_ = target;
+}
+
+TimerWheel::TimePoint TimerWheel::nextWakeTime() const
+{
+    if (size_ == 0)
+        return TimePoint();
+
+    return timeFromTick(nextEventTick());
+}
+
+void TimerWheel::clear()
+{
+    for (int level = 0; level < kWheelCount; ++level)
+    {
+        for (int slot = 0; slot < kWheelSize; ++slot)
+            wheel_[level][slot].clear();
+
+        occupancy_[level] = 0;
+    }
+
+    size_ = 0;
+}
+
+void TimerWheel::insertAtTick(PendingTask&& task, uint64_t expiry_tick)
+{
+    const uint64_t kMaxDelta = 1ull << (kWheelBits * kWheelCount);
+
+    uint64_t delta = (expiry_tick > current_tick_) ? (expiry_tick - current_tick_) : 0;
+
+    // Deadlines beyond the range of the wheel park at the coarsest level and are re-inserted
+    // with the remaining delay when they cascade.
+    if (delta >= kMaxDelta)
+    {
+        delta = kMaxDelta - 1;
+        expiry_tick = current_tick_ + delta;
+    }
+
+    int level = 0;
+    while (delta >= (1ull << (kWheelBits * (level + 1))))
+        ++level;
+
+    const int slot = static_cast<int>((expiry_tick >> (kWheelBits * level)) & (kWheelSize - 1));
+
+    wheel_[level][slot].emplace_back(std::move(task));
+    occupancy_[level] |= 1ull << slot;
+}
+
+void TimerWheel::cascade(int level, int slot_index)
+{
+    Slot tasks = std::move(wheel_[level][slot_index]);
+
+    wheel_[level][slot_index].clear();
+    occupancy_[level] &= ~(1ull << slot_index);
+
+    // The expiry tick is recomputed from the deadline, so a timer that was parked because its
+    // deadline was out of range ends up at the right place once it fits.
+    for (PendingTask& task : tasks)
+        insertAtTick(std::move(task), tickFromTime(task.delayed_run_time));
+}
+
+uint64_t TimerWheel::nextEventTick() const
+{
+    DCHECK_GT(size_, 0u);
+
+    uint64_t best = 0;
+
+    for (int level = 0; level < kWheelCount; ++level)
+    {
+        if (!occupancy_[level])
+            continue;
+
+        const uint64_t base = current_tick_ >> (kWheelBits * level);
+        const int index = static_cast<int>(base & (kWheelSize - 1));
+
+        for (int off = 1; off <= kWheelSize; ++off)
+        {
+            if (!(occupancy_[level] & (1ull << ((index + off) & (kWheelSize - 1)))))
+                continue;
+
+            // For the finest level this is the expiry tick itself; for the coarser levels it is
+            // the start of the slot's window, where its timers cascade.
+            const uint64_t candidate =
+                (base + static_cast<uint64_t>(off)) << (kWheelBits * level);
+
+            if (!best || candidate < best)
+                best = candidate;
+
+            break;
+        }
+    }
+
+    return best;
+}
+
+uint64_t TimerWheel::tickFromTime(TimePoint time) const
+{
+    if (time <= origin_)
+        return 0;
+
+    const auto delta = time - origin_;
+    const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(delta);
+
+    uint64_t tick = static_cast<uint64_t>(ms.count());
+
+    // Round up, so that a timer never fires before its deadline.
+    if (ms < delta)
+        ++tick;
+
+    return tick;
+}
+
+TimerWheel::TimePoint TimerWheel::timeFromTick(uint64_t tick) const
+{
+    return origin_ + std::chrono::milliseconds(tick);
+}
+
+} // namespace base
@@ -0,0 +1,97 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__MESSAGE_LOOP__TIMER_WHEEL_H
+#define BASE__MESSAGE_LOOP__TIMER_WHEEL_H
+
+#include "base/macros_magic.h"
+#include "base/message_loop/pending_task.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace base {
+
+// Hierarchical timer wheel for delayed tasks with millisecond resolution. Arming a timer is O(1)
+// regardless of how many timers are pending, unlike a binary heap where every insertion and
+// removal costs O(log n). Timers that do not fit the lowest wheel level start at a coarser level
+// and cascade down as their deadline approaches. A timer never fires before its deadline, but
+// because of the millisecond resolution it can fire up to one tick after it.
+class TimerWheel
+{
+public:
+    using Clock = PendingTask::Clock;
+    using TimePoint = PendingTask::TimePoint;
+
+    TimerWheel();
+    ~TimerWheel() = default;
+
+    // Adds the task to the wheel. The deadline is taken from |task.delayed_run_time|. Deadlines
+    // in the past fire at the next advance.
+    void insert(PendingTask&& task);
+
+    // Moves the tasks whose deadline has been reached by |now| to |ready| in deadline order.
+    void advanceTo(TimePoint now, TaskQueue* ready);
+
+    // The earliest moment the wheel has to be advanced again. This is not necessarily a task
+    // deadline: for timers at the coarser levels it is the moment of their next cascade. Returns
+    // a null TimePoint when the wheel is empty.
+    TimePoint nextWakeTime() const;
+
+    bool empty() const { return size_ == 0; }
+
+    // Removes all pending tasks.
+    void clear();
+
+private:
+    static const int kWheelBits = 6;
+    static const int kWheelSize = 1 << kWheelBits; // 64 slots per level.
+    static const int kWheelCount = 4;              // Covers up to 64^4 ms (~4.6 hours) directly.
+
+    using Slot = std::vector<PendingTask>;
+
+    void insertAtTick(PendingTask&& task, uint64_t expiry_tick);
+
+    // Re-inserts the timers of the given slot one level down (or into the expired set).
+    void cascade(int level, int slot_index);
+
+    // The earliest tick at which a slot expires or cascades. Returns zero when the wheel is
+    // empty.
+    uint64_t nextEventTick() const;
+
+    uint64_t tickFromTime(TimePoint time) const;
+    TimePoint timeFromTick(uint64_t tick) const;
+
+    const TimePoint origin_;
+
+    // Number of whole milliseconds elapsed since |origin_| the wheel has been advanced to.
+    uint64_t current_tick_ = 0;
+
+    size_t size_ = 0;
+
+    Slot wheel_[kWheelCount][kWheelSize];
+
+    // One bit per slot, so finding the next non-empty slot does not touch the slot vectors.
+    uint64_t occupancy_[kWheelCount];
+
+    DISALLOW_COPY_AND_ASSIGN(TimerWheel);
+};
+
+} // namespace base
+
+#endif // BASE__MESSAGE_LOOP__TIMER_WHEEL_H
@@ -0,0 +1,161 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/message_loop/timer_wheel.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace base {
+
+namespace {
+
+using namespace std::chrono_literals;
+
+PendingTask makeTask(TimerWheel::TimePoint deadline, int id, std::vector<int>* fired)
+{
+    return PendingTask([fired, id]() { fired->push_back(id); }, deadline, true);
+}
+
+void runAll(TaskQueue* ready)
+{
+    while (!ready->empty())
+    {
+        ready->front().callback();
+        ready->pop();
+    }
+}
+
+} // namespace
+
+TEST(TimerWheelTest, Empty)
+{
+    TimerWheel wheel;
+    TaskQueue ready;
+
+    EXPECT_TRUE(wheel.empty());
+    EXPECT_EQ(wheel.nextWakeTime(), TimerWheel::TimePoint());
+
+    wheel.advanceTo(TimerWheel::Clock::now() + 1h, &ready);
+    EXPECT_TRUE(ready.empty());
+}
+
+TEST(TimerWheelTest, FiresInDeadlineOrder)
+{
+    TimerWheel wheel;
+    TaskQueue ready;
+
+    // Keep the test time well above the wheel origin, so that no deadline is in the past.
+    TimerWheel::TimePoint base = TimerWheel::Clock::now() + 1h;
+
+    std::vector<int> fired;
+
+    wheel.insert(makeTask(base + 50ms, 0, &fired));
+    wheel.insert(makeTask(base + 10ms, 1, &fired));
+    wheel.insert(makeTask(base + 30ms, 2, &fired));
+
+    EXPECT_FALSE(wheel.empty());
+
+    wheel.advanceTo(base + 100ms, &ready);
+    EXPECT_EQ(ready.size(), 3u);
+    EXPECT_TRUE(wheel.empty());
+
+    runAll(&ready);
+
+    ASSERT_EQ(fired.size(), 3u);
+    EXPECT_EQ(fired[0], 1);
+    EXPECT_EQ(fired[1], 2);
+    EXPECT_EQ(fired[2], 0);
+}
+
+TEST(TimerWheelTest, DoesNotFireEarly)
+{
+    TimerWheel wheel;
+    TaskQueue ready;
+
+    TimerWheel::TimePoint base = TimerWheel::Clock::now() + 1h;
+
+    std::vector<int> fired;
+    wheel.insert(makeTask(base + 100ms, 0, &fired));
+
+    wheel.advanceTo(base + 99ms, &ready);
+    EXPECT_TRUE(ready.empty());
+    EXPECT_FALSE(wheel.empty());
+
+    // The next wakeup lies at most one tick (1 ms) beyond the deadline.
+    EXPECT_LE(wheel.nextWakeTime(), base + 101ms);
+
+    wheel.advanceTo(base + 101ms, &ready);
+    EXPECT_EQ(ready.size(), 1u);
+    EXPECT_TRUE(wheel.empty());
+}
+
+TEST(TimerWheelTest, CascadesLongDelays)
+{
+    TimerWheel wheel;
+    TaskQueue ready;
+
+    TimerWheel::TimePoint base = TimerWheel::Clock::now() + 1h;
+
+    std::vector<int> fired;
+
+    // Crosses several wheel levels.
+    wheel.insert(makeTask(base + 10s, 0, &fired));
+
+    // Far beyond the direct range of the wheel (~4.6 hours).
+    wheel.insert(makeTask(base + 24h, 1, &fired));
+
+    wheel.advanceTo(base + 9s, &ready);
+    EXPECT_TRUE(ready.empty());
+
+    wheel.advanceTo(base + 11s, &ready);
+    EXPECT_EQ(ready.size(), 1u);
+    runAll(&ready);
+
+    wheel.advanceTo(base + 23h, &ready);
+    EXPECT_TRUE(ready.empty());
+
+    wheel.advanceTo(base + 24h + 10ms, &ready);
+    EXPECT_EQ(ready.size(), 1u);
+    runAll(&ready);
+
+    ASSERT_EQ(fired.size(), 2u);
+    EXPECT_EQ(fired[0], 0);
+    EXPECT_EQ(fired[1], 1);
+}
+
+TEST(TimerWheelTest, Clear)
+{
+    TimerWheel wheel;
+    TaskQueue ready;
+
+    TimerWheel::TimePoint base = TimerWheel::Clock::now() + 1h;
+
+    std::vector<int> fired;
+    wheel.insert(makeTask(base + 10ms, 0, &fired));
+    wheel.insert(makeTask(base + 10min, 1, &fired));
+
+    wheel.clear();
+    EXPECT_TRUE(wheel.empty());
+
+    wheel.advanceTo(base + 1h, &ready);
+    EXPECT_TRUE(ready.empty());
+}
+
+} // namespace base
@@ -20,25 +20,88 @@
 
 #include "base/location.h"
 #include "base/logging.h"
+#include "base/trace_log.h"
 #include "base/crypto/message_encryptor_fake.h"
 #include "base/crypto/message_decryptor_fake.h"
 #include "base/message_loop/message_loop.h"
 #include "base/message_loop/message_pump_asio.h"
 #include "base/net/network_channel_proxy.h"
 #include "base/net/tcp_keep_alive.h"
+#include "base/net/tcp_send_tuning.h"
 #include "base/strings/string_printf.h"
 #include "base/strings/unicode.h"
 
-#include <asio/connect.hpp>
 #include <asio/read.hpp>
 #include <asio/write.hpp>
 
+#include <algorithm>
+
 namespace base {
 
 namespace {
 
 static const size_t kMaxMessageSize = 16 * 1024 * 1024; // 16 MB
 
+// Limit on the amount of data gathered into a single write. A message larger than the limit is
+// still sent whole; the limit only stops further messages from being added to the batch.
+static const size_t kMaxWriteBatchSize = 4 * 1024 * 1024; // 4 MB
+
+// Number of sent message buffers kept for reuse by takeSpareBuffer().
+static const size_t kMaxSpareBuffers = 4;
+
+// Messages larger than this are encrypted in chunks of this size, each chunk carrying its own
+// authentication tag, and every chunk goes to the socket as soon as it is ready. Encryption of
+// the rest of the message then overlaps its transmission, so the time before the first byte of
+// a large message hits the wire is bounded by one chunk instead of the whole message.
+static const size_t kEncryptChunkSize = 64 * 1024; // 64 kB
+
+// Capacity of the send pacer's token bucket, expressed as transmission time at the configured
+// rate. Gaps shorter than this between writes are absorbed without delay; anything above goes
+// to the socket spaced out instead of as one burst.
+static const int64_t kPacerBurstUs = 2000; // 2 ms.
+
+// Interval between send queue tuning passes and the clamp for the unsent-data watermark.
+// The lower bound keeps small control connections from degenerating into one wake-up per
+// packet; the upper bound caps the kernel queue at about one large encoded frame.
+static const std::chrono::seconds kSendQueueTuneInterval{ 1 };
+static const size_t kMinUnsentLowat = 16 * 1024;        // 16 kB
+static const size_t kMaxUnsentLowat = 1 * 1024 * 1024;  // 1 MB
+
+// Delay before the next connection attempt is started while the previous one is still pending.
+// The value recommended by RFC 8305 section 5.
+static const std::chrono::milliseconds kConnectAttemptDelay{ 250 };
+
+// Orders the resolved endpoints by alternating address families, starting with IPv6, as
+// described in RFC 8305 section 4. A broken route then costs at most one attempt delay before
+// an endpoint of the other family is tried.
+std::vector<asio::ip::tcp::endpoint> interleaveByFamily(
+    const asio::ip::tcp::resolver::results_type& endpoints)
+{
+    std::vector<asio::ip::tcp::endpoint> v6;
+    std::vector<asio::ip::tcp::endpoint> v4;
+
+    for (const auto& entry : endpoints)
+    {
+        if (entry.endpoint().address().is_v6())
+            v6.emplace_back(entry.endpoint());
+        else
+            v4.emplace_back(entry.endpoint());
+    }
+
+    std::vector<asio::ip::tcp::endpoint> result;
+    result.reserve(v6.size() + v4.size());
+
+    for (size_t i = 0; i < std::max(v6.size(), v4.size()); ++i)
+    {
+        if (i < v6.size())
+            result.emplace_back(v6[i]);
+        if (i < v4.size())
+            result.emplace_back(v4[i]);
+    }
+
+    return result;
+}
+
 int calculateSpeed(int last_speed, const std::chrono::milliseconds& duration, int64_t bytes)
 {
     static const double kAlpha = 0.1;
@@ -49,6 +112,11 @@ int calculateSpeed(int last_speed, const std::chrono::milliseconds& duration, in
 
 } // namespace
 
+void NetworkChannel::Listener::onMessagesDropped(uint8_t /* stream_id */, size_t /* count */)
+{
+    // Ignored by default.
+}
+
 NetworkChannel::NetworkChannel()
     : proxy_(new NetworkChannelProxy(MessageLoop::current()->taskRunner(), this)),
       io_context_(MessageLoop::current()->pumpAsio()->ioContext()),
@@ -91,6 +159,16 @@ void NetworkChannel::setListener(Listener* listener)
     listener_ = listener;
 }
 
+void NetworkChannel::setStreamListener(uint8_t stream_id, StreamListener* listener)
+{
+    DCHECK_NE(stream_id, kDefaultStreamId);
+
+    if (listener)
+        stream_listeners_[stream_id] = listener;
+    else
+        stream_listeners_.erase(stream_id);
+}
+
 void NetworkChannel::setEncryptor(std::unique_ptr<MessageEncryptor> encryptor)
 {
     encryptor_ = std::move(encryptor);
@@ -109,6 +187,16 @@ std::u16string NetworkChannel::peerAddress() const
     return utf16FromLocal8Bit(socket_.remote_endpoint().address().to_string());
 }
 
+bool NetworkChannel::isLoopback() const
+{
+    std::error_code error_code;
+    asio::ip::tcp::endpoint endpoint = socket_.remote_endpoint(error_code);
+    if (error_code)
+        return false;
+
+    return endpoint.address().is_loopback();
+}
+
 void NetworkChannel::connect(std::u16string_view address, uint16_t port)
 {
     if (connected_ || !resolver_)
@@ -124,22 +212,106 @@ void NetworkChannel::connect(std::u16string_view address, uint16_t port)
             return;
         }
 
-        asio::async_connect(socket_, endpoints,
-            [this](const std::error_code& error_code,
-                   const asio::ip::tcp::endpoint& /* endpoint */)
+        connect_endpoints_ = interleaveByFamily(endpoints);
+        connect_attempts_.clear();
+        next_endpoint_index_ = 0;
+        pending_connect_attempts_ = 0;
+        last_connect_error_ = std::error_code();
+
+        if (connect_endpoints_.empty())
         {
-            if (error_code)
-            {
-                onErrorOccurred(FROM_HERE, error_code);
-                return;
-            }
+            onErrorOccurred(FROM_HERE, asio::error::host_not_found);
+            return;
+        }
 
-            connected_ = true;
+        if (!connect_timer_)
+            connect_timer_ = std::make_unique<asio::steady_timer>(io_context_);
 
-            if (listener_)
-                listener_->onConnected();
-        });
+        startConnectAttempt();
+    });
+}
+
+void NetworkChannel::startConnectAttempt()
+{
+    if (connected_ || next_endpoint_index_ >= connect_endpoints_.size())
+        return;
+
+    const size_t attempt_index = next_endpoint_index_++;
+    const asio::ip::tcp::endpoint& endpoint = connect_endpoints_[attempt_index];
+
+    connect_attempts_.emplace_back(std::make_unique<ConnectAttempt>(io_context_));
+    ++pending_connect_attempts_;
+
+    connect_attempts_[attempt_index]->socket.async_connect(endpoint,
+        [this, attempt_index](const std::error_code& error_code)
+    {
+        onConnectAttemptComplete(attempt_index, error_code);
     });
+
+    // While this attempt is pending, the next endpoint is tried after a short delay.
+    if (next_endpoint_index_ < connect_endpoints_.size())
+    {
+        connect_timer_->expires_after(kConnectAttemptDelay);
+        connect_timer_->async_wait([this](const std::error_code& error_code)
+        {
+            if (!error_code)
+                startConnectAttempt();
+        });
+    }
+}
+
+void NetworkChannel::onConnectAttemptComplete(
+    size_t attempt_index, const std::error_code& error_code)
+{
+    // A late completion of a losing attempt; the winning socket is already in use.
+    if (connected_)
+        return;
+
+    ConnectAttempt* attempt = connect_attempts_[attempt_index].get();
+    attempt->finished = true;
+
+    DCHECK_GT(pending_connect_attempts_, 0u);
+    --pending_connect_attempts_;
+
+    if (error_code)
+    {
+        if (error_code == asio::error::operation_aborted)
+            return;
+
+        last_connect_error_ = error_code;
+
+        // A failed attempt does not wait for the stagger delay; the next endpoint is tried
+        // right away.
+        if (next_endpoint_index_ < connect_endpoints_.size())
+        {
+            connect_timer_->cancel();
+            startConnectAttempt();
+        }
+        else if (!pending_connect_attempts_)
+        {
+            // All endpoints have been tried and failed.
+            onErrorOccurred(FROM_HERE, last_connect_error_);
+        }
+
+        return;
+    }
+
+    // The first attempt to connect wins; the socket becomes the channel socket and the other
+    // attempts are closed. Their handlers will complete with operation_aborted.
+    socket_ = std::move(attempt->socket);
+    connected_ = true;
+
+    connect_timer_->cancel();
+
+    std::error_code ignored_code;
+    for (auto& other : connect_attempts_)
+    {
+        if (!other->finished)
+            other->socket.close(ignored_code);
+    }
+
+    if (listener_)
+        listener_->onConnected();
 }
 
 bool NetworkChannel::isConnected() const
@@ -177,15 +349,42 @@ void NetworkChannel::resume()
 
 void NetworkChannel::send(ByteArray&& buffer)
 {
-    const bool schedule_write = write_queue_.empty();
+    send(kDefaultStreamId, std::move(buffer), false);
+}
+
+void NetworkChannel::send(uint8_t stream_id, ByteArray&& buffer)
+{
+    send(stream_id, std::move(buffer), false);
+}
+
+void NetworkChannel::send(uint8_t stream_id, ByteArray&& buffer, bool discardable)
+{
+    // The queues can be empty while a previous batch is still being written, so the presence of
+    // a write in progress must be checked too.
+    const bool schedule_write = pendingMessages() == 0 && messages_in_write_ == 0;
 
     // Add the buffer to the queue for sending.
-    write_queue_.emplace(std::move(buffer));
+    write_queue_.emplace(PendingMessage { stream_id, std::move(buffer), discardable });
 
     if (schedule_write)
         doWrite();
 }
 
+void NetworkChannel::setStreamClass(uint8_t stream_id, StreamClass stream_class)
+{
+    stream_classes_[stream_id] = stream_class;
+}
+
+ByteArray NetworkChannel::takeSpareBuffer()
+{
+    if (spare_buffers_.empty())
+        return ByteArray();
+
+    ByteArray buffer = std::move(spare_buffers_.back());
+    spare_buffers_.pop_back();
+    return buffer;
+}
+
 bool NetworkChannel::setNoDelay(bool enable)
 {
     asio::ip::tcp::no_delay option(enable);
@@ -244,6 +443,97 @@ bool NetworkChannel::setWriteBufferSize(size_t size)
     return true;
 }
 
+void NetworkChannel::setSendQueueAutoTuning(bool enable)
+{
+    send_queue_tuning_ = enable;
+    last_tune_time_ = TimePoint();
+    tune_bytes_ = 0;
+    tuned_lowat_ = 0;
+}
+
+void NetworkChannel::tuneSendQueue()
+{
+    const TimePoint now = Clock::now();
+
+    if (last_tune_time_ == TimePoint())
+    {
+        last_tune_time_ = now;
+        return;
+    }
+
+    const int64_t elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        now - last_tune_time_).count();
+    if (elapsed_us < std::chrono::duration_cast<std::chrono::microseconds>(
+            kSendQueueTuneInterval).count())
+    {
+        return;
+    }
+
+    const int64_t rate = tune_bytes_ * 1000000 / elapsed_us; // Bytes per second.
+
+    last_tune_time_ = now;
+    tune_bytes_ = 0;
+
+    if (rate <= 0)
+        return;
+
+    // The watermark covers two round trips of data at the current send rate (at least 20 ms
+    // for LAN paths where the RTT is negligible): enough unsent data that the stack never runs
+    // dry between writable wake-ups, but a few frames instead of the seconds of queue the OS
+    // default send buffer allows.
+    std::chrono::microseconds rtt{ 0 };
+    tcpRoundTripTime(socket_.native_handle(), &rtt);
+
+    int64_t window_us = std::max<int64_t>(2 * rtt.count(), 20000);
+    window_us = std::min<int64_t>(window_us, 200000);
+
+    const size_t lowat = std::clamp(static_cast<size_t>(rate * window_us / 1000000),
+                                    kMinUnsentLowat, kMaxUnsentLowat);
+
+    // Hysteresis: the rate estimate is noisy, and reapplying a near-identical watermark every
+    // second is a system call for nothing.
+    if (tuned_lowat_ != 0)
+    {
+        const size_t diff = lowat > tuned_lowat_ ? lowat - tuned_lowat_ : tuned_lowat_ - lowat;
+        if (diff < tuned_lowat_ / 4)
+            return;
+    }
+
+#if defined(OS_WIN)
+    // No unsent-data watermark on Windows; size the send buffer to the backlog the stack
+    // considers ideal for the path, with the computed watermark as a floor.
+    size_t target = lowat;
+    size_t backlog = 0;
+    if (tcpIdealSendBacklog(socket_.native_handle(), &backlog))
+        target = std::max(target, backlog);
+
+    if (!setWriteBufferSize(target))
+    {
+        send_queue_tuning_ = false;
+        return;
+    }
+#else
+    if (!setTcpNotsentLowat(socket_.native_handle(), lowat))
+    {
+        // The option is not supported; do not retry it every interval.
+        send_queue_tuning_ = false;
+        return;
+    }
+#endif
+
+    tuned_lowat_ = lowat;
+}
+
+void NetworkChannel::setSendRateLimit(uint64_t bytes_per_second)
+{
+    send_rate_limit_ = bytes_per_second;
+
+    // Start from an empty bucket at the new rate; stale tokens earned at the old rate would
+    // allow one unpaced burst right after the change.
+    pacer_tokens_ = 0.0;
+    pacer_last_refill_ = TimePoint();
+}
+
 int NetworkChannel::speedRx()
 {
     TimePoint current_time = Clock::now();
@@ -327,13 +617,27 @@ std::string NetworkChannel::errorToString(ErrorCode error_code)
 
 void NetworkChannel::disconnect()
 {
+    std::error_code ignored_code;
+
+    // Abort a connection establishment that may still be in progress.
+    if (connect_timer_)
+        connect_timer_->cancel();
+
+    // Abort a paced write that is waiting for its send slot.
+    if (pacer_timer_)
+        pacer_timer_->cancel();
+
+    for (auto& attempt : connect_attempts_)
+    {
+        if (!attempt->finished)
+            attempt->socket.close(ignored_code);
+    }
+
     if (!connected_)
         return;
 
     connected_ = false;
 
-    std::error_code ignored_code;
-
     socket_.cancel(ignored_code);
     socket_.close(ignored_code);
 }
@@ -378,73 +682,366 @@ void NetworkChannel::onErrorOccurred(const Location& location, const std::error_
 void NetworkChannel::onMessageWritten()
 {
     if (listener_)
-        listener_->onMessageWritten(write_queue_.size());
+        listener_->onMessageWritten(pendingMessages());
 }
 
 void NetworkChannel::onMessageReceived()
 {
-    const size_t decrypt_buffer_size = decryptor_->decryptedDataSize(read_buffer_.size());
+    // The first byte of the frame is the id of the logical stream, the rest is the encrypted
+    // message.
+    if (read_buffer_.size() < 2)
+    {
+        onErrorOccurred(FROM_HERE, asio::error::message_size);
+        return;
+    }
+
+    const uint8_t stream_id = read_buffer_[0];
+
+    const size_t in_size = read_buffer_.size() - 1;
+
+    // A large message arrives as a sequence of independently encrypted chunks of
+    // kEncryptChunkSize plaintext bytes each (see doWrite()). A full chunk occupies the chunk
+    // size plus the per-chunk tag on the wire, so the chunk count follows from the frame size.
+    const size_t chunk_overhead = in_size - decryptor_->decryptedDataSize(in_size);
+    const size_t max_wire_chunk = kEncryptChunkSize + chunk_overhead;
+    const size_t chunk_count = (in_size + max_wire_chunk - 1) / max_wire_chunk;
+
+    const size_t decrypt_buffer_size = in_size - chunk_count * chunk_overhead;
+    if (decrypt_buffer_size > in_size)
+    {
+        // The frame is too small to hold the authentication tags it should carry.
+        onErrorOccurred(FROM_HERE, asio::error::message_size);
+        return;
+    }
 
     if (decrypt_buffer_.capacity() < decrypt_buffer_size)
         decrypt_buffer_.reserve(decrypt_buffer_size);
 
     decrypt_buffer_.resize(decrypt_buffer_size);
 
-    if (!decryptor_->decrypt(read_buffer_.data(), read_buffer_.size(), decrypt_buffer_.data()))
+    size_t in_offset = 1;
+    size_t out_offset = 0;
+
+    while (in_offset < read_buffer_.size())
+    {
+        const size_t in_chunk = std::min(read_buffer_.size() - in_offset, max_wire_chunk);
+        if (in_chunk <= chunk_overhead)
+        {
+            onErrorOccurred(FROM_HERE, asio::error::message_size);
+            return;
+        }
+
+        if (!decryptor_->decrypt(read_buffer_.data() + in_offset,
+                                 in_chunk,
+                                 decrypt_buffer_.data() + out_offset))
+        {
+            onErrorOccurred(FROM_HERE, asio::error::access_denied);
+            return;
+        }
+
+        in_offset += in_chunk;
+        out_offset += in_chunk - chunk_overhead;
+    }
+
+    if (stream_id == kDefaultStreamId)
     {
-        onErrorOccurred(FROM_HERE, asio::error::access_denied);
+        if (listener_)
+            listener_->onMessageReceived(decrypt_buffer_);
         return;
     }
 
-    if (listener_)
-        listener_->onMessageReceived(decrypt_buffer_);
+    auto it = stream_listeners_.find(stream_id);
+    if (it == stream_listeners_.end())
+    {
+        LOG(LS_WARNING) << "Dropped message for stream " << static_cast<int>(stream_id)
+                        << ": no listener attached";
+        return;
+    }
+
+    it->second->onStreamMessageReceived(stream_id, decrypt_buffer_);
+}
+
+size_t NetworkChannel::pendingMessages() const
+{
+    return queued_messages_ + write_queue_.size();
+}
+
+NetworkChannel::StreamClass NetworkChannel::streamClass(uint8_t stream_id) const
+{
+    auto it = stream_classes_.find(stream_id);
+    if (it == stream_classes_.end())
+        return StreamClass::CONTROL;
+    return it->second;
+}
+
+std::map<uint8_t, std::deque<NetworkChannel::StreamMessage>>::iterator
+NetworkChannel::nextStreamToWrite()
+{
+    auto scan = [this](StreamClass stream_class, uint8_t last_id)
+    {
+        // Round-robin over the streams of one class: the scan starts after the stream served
+        // last and wraps around, visiting every stream once.
+        auto it = stream_queues_.upper_bound(last_id);
+
+        for (size_t left = stream_queues_.size(); left != 0; --left)
+        {
+            if (it == stream_queues_.end())
+                it = stream_queues_.begin();
+
+            if (!it->second.empty() && streamClass(it->first) == stream_class)
+                return it;
+
+            ++it;
+        }
+
+        return stream_queues_.end();
+    };
+
+    auto it = scan(StreamClass::CONTROL, last_control_stream_);
+    if (it == stream_queues_.end())
+        it = scan(StreamClass::BULK, last_bulk_stream_);
+
+    return it;
 }
 
 void NetworkChannel::doWrite()
 {
-    const ByteArray& source_buffer = write_queue_.front();
-    if (source_buffer.empty())
+    // Move newly queued messages into their per-stream queues. A discardable message supersedes
+    // the discardable messages still queued on its stream: they would arrive stale anyway, so
+    // they are dropped instead of being sent.
+    while (!write_queue_.empty())
     {
-        onErrorOccurred(FROM_HERE, asio::error::message_size);
-        return;
+        PendingMessage& message = write_queue_.front();
+        std::deque<StreamMessage>& stream_queue = stream_queues_[message.stream_id];
+
+        if (message.discardable)
+        {
+            size_t dropped = 0;
+
+            for (auto it = stream_queue.begin(); it != stream_queue.end();)
+            {
+                if (it->discardable)
+                {
+                    if (spare_buffers_.size() < kMaxSpareBuffers)
+                    {
+                        it->buffer.clear();
+                        spare_buffers_.emplace_back(std::move(it->buffer));
+                    }
+
+                    it = stream_queue.erase(it);
+                    --queued_messages_;
+                    ++dropped;
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+
+            if (dropped != 0 && listener_)
+                listener_->onMessagesDropped(message.stream_id, dropped);
+        }
+
+        stream_queue.emplace_back(StreamMessage { std::move(message.buffer), message.discardable });
+        ++queued_messages_;
+        write_queue_.pop();
     }
 
-    // Calculate the size of the encrypted message.
-    const size_t target_data_size = encryptor_->encryptedDataSize(source_buffer.size());
+    // Gather queued messages into one buffer, so a burst of messages goes to the socket with a
+    // single write instead of one write per message. Control streams are drained before bulk
+    // ones, so queued bulk data never delays interactive messages; streams of the same class
+    // are served round-robin.
+    write_size_ = 0;
+    messages_in_write_ = 0;
 
-    if (target_data_size > kMaxMessageSize)
+    while (queued_messages_ != 0)
     {
-        onErrorOccurred(FROM_HERE, asio::error::message_size);
-        return;
-    }
+        auto next_stream = nextStreamToWrite();
+        DCHECK(next_stream != stream_queues_.end());
+
+        std::deque<StreamMessage>& stream_queue = next_stream->second;
+
+        const uint8_t stream_id = next_stream->first;
+        const ByteArray& source_buffer = stream_queue.front().buffer;
+
+        if (source_buffer.empty())
+        {
+            onErrorOccurred(FROM_HERE, asio::error::message_size);
+            return;
+        }
+
+        // A large message is written in chunks; already gathered messages are flushed first so
+        // the chunked write starts with an empty buffer.
+        if (source_buffer.size() > kEncryptChunkSize)
+        {
+            if (write_size_ != 0)
+                break;
+
+            chunk_buffer_ = std::move(stream_queue.front().buffer);
+            stream_queue.pop_front();
+            --queued_messages_;
+            ++messages_in_write_;
+
+            if (streamClass(stream_id) == StreamClass::BULK)
+                last_bulk_stream_ = stream_id;
+            else
+                last_control_stream_ = stream_id;
+
+            // The frame size announces the complete message: the stream id byte plus every
+            // encrypted chunk with its tag.
+            const size_t chunk_count =
+                (chunk_buffer_.size() + kEncryptChunkSize - 1) / kEncryptChunkSize;
+            const size_t last_chunk_size =
+                chunk_buffer_.size() - (chunk_count - 1) * kEncryptChunkSize;
+            const size_t target_data_size =
+                (chunk_count - 1) * encryptor_->encryptedDataSize(kEncryptChunkSize) +
+                encryptor_->encryptedDataSize(last_chunk_size);
+
+            if (target_data_size + 1 > kMaxMessageSize)
+            {
+                onErrorOccurred(FROM_HERE, asio::error::message_size);
+                return;
+            }
 
-    asio::const_buffer variable_size = variable_size_writer_.variableSize(target_data_size);
+            asio::const_buffer variable_size =
+                variable_size_writer_.variableSize(target_data_size + 1);
 
-    // Now we can calculate the full size.
-    const size_t total_size = variable_size.size() + target_data_size;
+            const size_t required_size =
+                variable_size.size() + 1 + encryptor_->encryptedDataSize(kEncryptChunkSize);
+            if (write_buffer_.size() < required_size)
+                write_buffer_.resize(required_size);
 
-    // If the reserved buffer size is less, then increase it.
-    if (write_buffer_.capacity() < total_size)
-        write_buffer_.reserve(total_size);
+            memcpy(write_buffer_.data(), variable_size.data(), variable_size.size());
+            write_buffer_[variable_size.size()] = stream_id;
+
+            // Encrypt the first chunk; the rest is encrypted from onWrite() while this chunk
+            // is in flight.
+            if (!encryptor_->encrypt(chunk_buffer_.data(),
+                                     kEncryptChunkSize,
+                                     write_buffer_.data() + variable_size.size() + 1))
+            {
+                onErrorOccurred(FROM_HERE, asio::error::access_denied);
+                return;
+            }
 
-    // Change the size of the buffer.
-    write_buffer_.resize(total_size);
+            chunk_offset_ = kEncryptChunkSize;
+            write_size_ = required_size;
+            break;
+        }
 
-    // Copy the size of the message to the buffer.
-    memcpy(write_buffer_.data(), variable_size.data(), variable_size.size());
+        // Calculate the size of the encrypted message.
+        const size_t target_data_size = encryptor_->encryptedDataSize(source_buffer.size());
 
-    // Encrypt the message.
-    if (!encryptor_->encrypt(source_buffer.data(),
-                             source_buffer.size(),
-                             write_buffer_.data() + variable_size.size()))
-    {
-        onErrorOccurred(FROM_HERE, asio::error::access_denied);
-        return;
+        if (target_data_size + 1 > kMaxMessageSize)
+        {
+            onErrorOccurred(FROM_HERE, asio::error::message_size);
+            return;
+        }
+
+        // The frame size covers the stream id byte and the encrypted message.
+        asio::const_buffer variable_size = variable_size_writer_.variableSize(target_data_size + 1);
+
+        // Grow the buffer only past its high-water mark; the message is written over whatever
+        // is there, so the zero-fill done by resize() is needed just for the new tail.
+        const size_t required_size = write_size_ + variable_size.size() + 1 + target_data_size;
+        if (write_buffer_.size() < required_size)
+            write_buffer_.resize(required_size);
+
+        // Copy the size of the message and the stream id to the buffer.
+        memcpy(write_buffer_.data() + write_size_, variable_size.data(), variable_size.size());
+        write_buffer_[write_size_ + variable_size.size()] = stream_id;
+
+        // Encrypt the message.
+        if (!encryptor_->encrypt(source_buffer.data(),
+                                 source_buffer.size(),
+                                 write_buffer_.data() + write_size_ + variable_size.size() + 1))
+        {
+            onErrorOccurred(FROM_HERE, asio::error::access_denied);
+            return;
+        }
+
+        write_size_ = required_size;
+
+        // The plaintext is not needed anymore; only |write_buffer_| must outlive the write.
+        // Its buffer is kept for reuse by the next serialized message.
+        if (spare_buffers_.size() < kMaxSpareBuffers)
+        {
+            stream_queue.front().buffer.clear();
+            spare_buffers_.emplace_back(std::move(stream_queue.front().buffer));
+        }
+
+        stream_queue.pop_front();
+        --queued_messages_;
+        ++messages_in_write_;
+
+        if (streamClass(stream_id) == StreamClass::BULK)
+            last_bulk_stream_ = stream_id;
+        else
+            last_control_stream_ = stream_id;
+
+        // Bound the amount of data gathered into a single write.
+        if (write_size_ >= kMaxWriteBatchSize)
+            break;
     }
 
+    DCHECK(messages_in_write_ != 0);
+
     // Send the buffer to the recipient.
+    startWrite();
+}
+
+void NetworkChannel::startWrite()
+{
+    if (send_rate_limit_ != 0)
+    {
+        const TimePoint now = Clock::now();
+
+        if (pacer_last_refill_ != TimePoint())
+        {
+            const int64_t elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                now - pacer_last_refill_).count();
+
+            pacer_tokens_ += static_cast<double>(elapsed_us) *
+                static_cast<double>(send_rate_limit_) / 1000000.0;
+        }
+
+        const double burst_limit = static_cast<double>(kPacerBurstUs) *
+            static_cast<double>(send_rate_limit_) / 1000000.0;
+        if (pacer_tokens_ > burst_limit)
+            pacer_tokens_ = burst_limit;
+
+        pacer_last_refill_ = now;
+
+        if (pacer_tokens_ < 0.0)
+        {
+            // The previous write overdrew the bucket. Wait until the deficit is earned back;
+            // this is what spaces consecutive chunks of a large message at the configured rate.
+            const int64_t delay_us = static_cast<int64_t>(
+                -pacer_tokens_ * 1000000.0 / static_cast<double>(send_rate_limit_)) + 1;
+
+            if (!pacer_timer_)
+                pacer_timer_ = std::make_unique<asio::steady_timer>(io_context_);
+
+            pacer_timer_->expires_after(std::chrono::microseconds(delay_us));
+            pacer_timer_->async_wait([this](const std::error_code& error_code)
+            {
+                if (error_code)
+                    return;
+
+                startWrite();
+            });
+            return;
+        }
+
+        // The write may take the bucket negative. A write larger than the bucket then goes out
+        // immediately and only delays the next one, so pacing can never deadlock on write size.
+        pacer_tokens_ -= static_cast<double>(write_size_);
+    }
+
+    write_begin_time_ = Clock::now();
+
     asio::async_write(socket_,
-                      asio::buffer(write_buffer_.data(), write_buffer_.size()),
+                      asio::buffer(write_buffer_.data(), write_size_),
                       std::bind(&NetworkChannel::onWrite,
                                 this,
                                 std::placeholders::_1,
@@ -459,17 +1056,67 @@ void NetworkChannel::onWrite(const std::error_code& error_code, size_t bytes_tra
         return;
     }
 
-    DCHECK(!write_queue_.empty());
+    DCHECK(messages_in_write_ != 0);
 
     // Update TX statistics.
     bytes_tx_ += bytes_transferred;
     total_tx_ += bytes_transferred;
+    tune_bytes_ += bytes_transferred;
+
+    if (send_queue_tuning_)
+        tuneSendQueue();
+
+    ++write_count_;
 
-    // Delete the sent message from the queue.
-    write_queue_.pop();
+    const uint64_t write_duration_us =
+        static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            Clock::now() - write_begin_time_).count());
+    write_time_us_ += write_duration_us;
 
-    // If the queue is not empty, then we send the following message.
-    bool schedule_write = !write_queue_.empty() || proxy_->reloadWriteQueue(&write_queue_);
+    if (TraceLog::isEnabled())
+    {
+        const uint64_t end_us = TraceLog::nowUs();
+        TraceLog::instance().addEvent("net", "SocketWrite", end_us - write_duration_us, end_us);
+    }
+
+    // Continue a chunked large message: encrypt the next chunk and send it. The previous
+    // chunk was transmitted while this one is being encrypted.
+    if (chunk_offset_ != 0 && chunk_offset_ < chunk_buffer_.size())
+    {
+        const size_t chunk_size =
+            std::min(chunk_buffer_.size() - chunk_offset_, kEncryptChunkSize);
+        const size_t target_data_size = encryptor_->encryptedDataSize(chunk_size);
+
+        if (write_buffer_.size() < target_data_size)
+            write_buffer_.resize(target_data_size);
+
+        if (!encryptor_->encrypt(chunk_buffer_.data() + chunk_offset_,
+                                 chunk_size,
+                                 write_buffer_.data()))
+        {
+            onErrorOccurred(FROM_HERE, asio::error::access_denied);
+            return;
+        }
+
+        chunk_offset_ += chunk_size;
+        write_size_ = target_data_size;
+
+        startWrite();
+        return;
+    }
+
+    if (chunk_offset_ != 0)
+    {
+        // The last chunk went out. The plaintext buffer is kept at its high-water size for
+        // the next large message.
+        chunk_offset_ = 0;
+        chunk_buffer_.clear();
+    }
+
+    messages_in_write_ = 0;
+
+    // If the queues are not empty, then we send the following message.
+    bool schedule_write = pendingMessages() != 0 || proxy_->reloadWriteQueue(&write_queue_);
 
     onMessageWritten();
 
@@ -480,12 +1127,20 @@ void NetworkChannel::onWrite(const std::error_code& error_code, size_t bytes_tra
 void NetworkChannel::doReadSize()
 {
     state_ = ReadState::READ_SIZE;
-    asio::async_read(socket_,
-                     variable_size_reader_.buffer(),
-                     std::bind(&NetworkChannel::onReadSize,
-                               this,
-                               std::placeholders::_1,
-                               std::placeholders::_2));
+
+    // Leftover bytes of a previous speculative read may already hold the next header.
+    if (parseHeader())
+        return;
+
+    // Read up to the full header in one operation. async_read_some() completes as soon as
+    // anything arrives, so a short header does not stall on the bytes that never come; a
+    // full buffer always parses, so the read below is only issued with room in the buffer.
+    socket_.async_read_some(
+        asio::buffer(header_buffer_ + header_size_, std::size(header_buffer_) - header_size_),
+        std::bind(&NetworkChannel::onReadSize,
+                  this,
+                  std::placeholders::_1,
+                  std::placeholders::_2));
 }
 
 void NetworkChannel::onReadSize(const std::error_code& error_code, size_t bytes_transferred)
@@ -497,35 +1152,77 @@ void NetworkChannel::onReadSize(const std::error_code& error_code, size_t bytes_
     }
 
     bytes_rx_ += bytes_transferred;
+    header_size_ += bytes_transferred;
 
-    std::optional<size_t> size = variable_size_reader_.messageSize();
-    if (size.has_value())
-    {
-        size_t message_size = size.value();
+    doReadSize();
+}
+
+bool NetworkChannel::parseHeader()
+{
+    size_t message_size = 0;
+    size_t header_length = 0;
 
-        if (!message_size || message_size > kMaxMessageSize)
+    for (size_t i = 0; i < header_size_; ++i)
+    {
+        if (i == 3)
         {
-            onErrorOccurred(FROM_HERE, asio::error::message_size);
-            return;
+            message_size += static_cast<size_t>(header_buffer_[3]) << 21;
+            header_length = 4;
+            break;
         }
 
-        if (read_buffer_.capacity() < message_size)
-            read_buffer_.reserve(message_size);
+        message_size += static_cast<size_t>(header_buffer_[i] & 0x7F) << (7 * i);
+
+        if (!(header_buffer_[i] & 0x80))
+        {
+            header_length = i + 1;
+            break;
+        }
+    }
 
-        read_buffer_.resize(message_size);
+    if (!header_length)
+        return false;
 
-        state_ = ReadState::READ_CONTENT;
-        asio::async_read(socket_,
-                         asio::buffer(read_buffer_.data(), read_buffer_.size()),
-                         std::bind(&NetworkChannel::onReadContent,
-                                   this,
-                                   std::placeholders::_1,
-                                   std::placeholders::_2));
+    // A frame consists of the stream id byte and a non-empty encrypted message.
+    if (message_size < 2 || message_size > kMaxMessageSize)
+    {
+        onErrorOccurred(FROM_HERE, asio::error::message_size);
+        return true;
     }
-    else
+
+    if (read_buffer_.capacity() < message_size)
+        read_buffer_.reserve(message_size);
+
+    read_buffer_.resize(message_size);
+
+    // The speculative read may have fetched bytes past the header: the start of this message
+    // and, when the message is tiny, the start of the next header.
+    const size_t surplus = header_size_ - header_length;
+
+    read_offset_ = std::min(surplus, message_size);
+    memcpy(read_buffer_.data(), header_buffer_ + header_length, read_offset_);
+    total_rx_ += read_offset_;
+
+    header_size_ = surplus - read_offset_;
+    memmove(header_buffer_, header_buffer_ + header_length + read_offset_, header_size_);
+
+    state_ = ReadState::READ_CONTENT;
+
+    if (read_offset_ == message_size)
     {
-        doReadSize();
+        // The whole message arrived together with its header.
+        onContentReady();
+        return true;
     }
+
+    asio::async_read(socket_,
+                     asio::buffer(read_buffer_.data() + read_offset_,
+                                  read_buffer_.size() - read_offset_),
+                     std::bind(&NetworkChannel::onReadContent,
+                               this,
+                               std::placeholders::_1,
+                               std::placeholders::_2));
+    return true;
 }
 
 void NetworkChannel::onReadContent(const std::error_code& error_code, size_t bytes_transferred)
@@ -540,8 +1237,13 @@ void NetworkChannel::onReadContent(const std::error_code& error_code, size_t byt
     bytes_rx_ += bytes_transferred;
     total_rx_ += bytes_transferred;
 
-    DCHECK_EQ(bytes_transferred, read_buffer_.size());
+    DCHECK_EQ(bytes_transferred, read_buffer_.size() - read_offset_);
+
+    onContentReady();
+}
 
+void NetworkChannel::onContentReady()
+{
     if (paused_)
     {
         state_ = ReadState::PENDING;
@@ -23,8 +23,13 @@
 #include "base/net/variable_size.h"
 
 #include <asio/ip/tcp.hpp>
+#include <asio/steady_timer.hpp>
 
+#include <deque>
+#include <map>
+#include <memory>
 #include <queue>
+#include <vector>
 
 namespace base {
 
@@ -83,6 +88,36 @@ public:
         virtual void onDisconnected(ErrorCode error_code) = 0;
         virtual void onMessageReceived(const ByteArray& buffer) = 0;
         virtual void onMessageWritten(size_t pending) = 0;
+
+        // Called when |count| queued discardable messages of a stream were superseded by a
+        // newer one and dropped (see the send() overload with a discardable flag). Invoked
+        // while the next write is being assembled; the listener should only record the fact
+        // (e.g. flag a stream recovery) and not send from this callback. Optional.
+        virtual void onMessagesDropped(uint8_t stream_id, size_t count);
+    };
+
+    // Receiver of messages from one auxiliary stream (see the send() overload with a stream id).
+    // Connection-level events keep going to Listener; a stream has no lifetime of its own.
+    class StreamListener
+    {
+    public:
+        virtual ~StreamListener() = default;
+
+        virtual void onStreamMessageReceived(uint8_t stream_id, const ByteArray& buffer) = 0;
+    };
+
+    // Stream id used by send(ByteArray&&). Messages of this stream are delivered through
+    // Listener::onMessageReceived().
+    static constexpr uint8_t kDefaultStreamId = 0;
+
+    // Scheduling class of a stream. When a write is assembled, CONTROL streams are drained
+    // before BULK streams, so queued bulk data (video frames, file chunks) never delays
+    // interactive messages. BULK streams still get the remainder of every write batch, so they
+    // are slowed down by control traffic but not starved.
+    enum class StreamClass
+    {
+        CONTROL,
+        BULK
     };
 
     std::shared_ptr<NetworkChannelProxy> channelProxy();
@@ -91,6 +126,11 @@ public:
     // You can change this in the process.
     void setListener(Listener* listener);
 
+    // Sets the receiver of messages for the specified auxiliary stream. Passing nullptr detaches
+    // the stream; messages arriving for a stream without a listener are dropped with a warning.
+    // |stream_id| must not be kDefaultStreamId.
+    void setStreamListener(uint8_t stream_id, StreamListener* listener);
+
     // Sets an instance of a class to encrypt and decrypt messages.
     // By default, a fake cryptographer is created that only copies the original message.
     // You must explicitly establish a cryptographer before or after establishing a connection.
@@ -100,6 +140,10 @@ public:
     // Gets the address of the remote host as a string.
     std::u16string peerAddress() const;
 
+    // Returns true if the remote end of the connection is a loopback address, i.e. the peer
+    // runs on the same machine.
+    bool isLoopback() const;
+
     // Connects to a host at the specified address and port.
     void connect(std::u16string_view address, uint16_t port);
 
@@ -122,6 +166,29 @@ public:
     // to the queue to be sent.
     void send(ByteArray&& buffer);
 
+    // Sends a message on a logical stream multiplexed over this connection. All streams share
+    // the socket and the encryption context; queued messages are scheduled round-robin across
+    // streams, so a bulk stream cannot starve an interactive one. Order is preserved within a
+    // stream but not between streams. The method call is thread safe.
+    void send(uint8_t stream_id, ByteArray&& buffer);
+
+    // Same as above; a message sent with |discardable| set is dropped from the queue when a
+    // newer discardable message is queued on the same stream before it went out. Used for video
+    // frames that are superseded by the next frame anyway: when bandwidth collapses, stale
+    // frames are discarded instead of being sent. The listener is told about drops through
+    // onMessagesDropped() so it can arrange stream recovery.
+    void send(uint8_t stream_id, ByteArray&& buffer, bool discardable);
+
+    // Assigns |stream_id| to a scheduling class; all streams are CONTROL until reassigned.
+    // May only be called from the thread the channel runs on.
+    void setStreamClass(uint8_t stream_id, StreamClass stream_class);
+
+    // Returns a buffer with retained capacity from an already sent message, or an empty buffer
+    // if none is available. Serializing into it and passing it back to send() keeps the
+    // steady-state send path free of allocations. Unlike send(), this method may only be called
+    // from the thread the channel runs on.
+    ByteArray takeSpareBuffer();
+
     // Disable or enable the algorithm of Nagle.
     bool setNoDelay(bool enable);
 
@@ -139,11 +206,33 @@ public:
     bool setReadBufferSize(size_t size);
     bool setWriteBufferSize(size_t size);
 
+    // Enables periodic tuning of the socket send queue. The unsent-data watermark
+    // (TCP_NOTSENT_LOWAT) is sized from the measured send rate and round-trip time so that the
+    // kernel holds a few frames of data at most; everything else stays in the channel queues,
+    // where stale discardable messages can still be dropped. OS default send buffers instead
+    // let seconds of video accumulate inside the socket during congestion. On Windows, which
+    // has no watermark option, the send buffer itself is sized to the ideal send backlog
+    // reported by the stack. May only be called from the thread the channel runs on.
+    void setSendQueueAutoTuning(bool enable);
+
+    // Limits the rate at which data leaves the socket. Writes above the rate are delayed by a
+    // token bucket, so an encoded video frame goes out as evenly spaced chunks instead of one
+    // multi-megabit burst that overflows shallow WAN buffers. Zero (the default) disables
+    // pacing. The limit bounds socket writes, not queueing; senders are not blocked by it.
+    // May only be called from the thread the channel runs on.
+    void setSendRateLimit(uint64_t bytes_per_second);
+
     int64_t totalRx() const { return total_rx_; }
     int64_t totalTx() const { return total_tx_; }
     int speedRx();
     int speedTx();
 
+    // Accumulated number of socket write operations and the total time spent waiting for their
+    // completion, in microseconds. Used by the pipeline statistics of desktop sessions. May only
+    // be called from the thread the channel runs on.
+    uint64_t writeCount() const { return write_count_; }
+    uint64_t writeTimeUs() const { return write_time_us_; }
+
     // Converts an error code to a human readable string.
     // Does not support localization. Used for logs.
     static std::string errorToString(ErrorCode error_code);
@@ -162,32 +251,110 @@ protected:
 private:
     friend class NetworkChannelProxy;
 
+    // A message queued for sending together with the logical stream it belongs to.
+    struct PendingMessage
+    {
+        uint8_t stream_id;
+        ByteArray buffer;
+        bool discardable = false;
+    };
+
+    // A message distributed into its per-stream queue.
+    struct StreamMessage
+    {
+        ByteArray buffer;
+        bool discardable = false;
+    };
+
+    void startConnectAttempt();
+    void onConnectAttemptComplete(size_t attempt_index, const std::error_code& error_code);
     void onErrorOccurred(const Location& location, const std::error_code& error_code);
     void onMessageWritten();
     void onMessageReceived();
 
+    size_t pendingMessages() const;
+    StreamClass streamClass(uint8_t stream_id) const;
+    std::map<uint8_t, std::deque<StreamMessage>>::iterator nextStreamToWrite();
     void doWrite();
+    void startWrite();
     void onWrite(const std::error_code& error_code, size_t bytes_transferred);
 
+    void tuneSendQueue();
+
     void doReadSize();
     void onReadSize(const std::error_code& error_code, size_t bytes_transferred);
+    bool parseHeader();
     void onReadContent(const std::error_code& error_code, size_t bytes_transferred);
+    void onContentReady();
 
     std::shared_ptr<NetworkChannelProxy> proxy_;
     asio::io_context& io_context_;
     asio::ip::tcp::socket socket_;
     std::unique_ptr<asio::ip::tcp::resolver> resolver_;
 
+    // Connection establishment state (RFC 8305 "Happy Eyeballs"). The resolved endpoints are
+    // tried with a small stagger between the attempts instead of strictly one after another,
+    // so a dead route to the first address family delays the connection by the stagger interval
+    // and not by a full connect timeout. The first attempt to succeed becomes |socket_|; the
+    // other attempts are then closed. A socket cannot be moved once async_connect is pending on
+    // it, so the attempts are held by unique_ptr and referenced by index in the handlers.
+    struct ConnectAttempt
+    {
+        explicit ConnectAttempt(asio::io_context& io_context)
+            : socket(io_context)
+        {
+            // Nothing
+        }
+
+        asio::ip::tcp::socket socket;
+        bool finished = false;
+    };
+
+    std::vector<asio::ip::tcp::endpoint> connect_endpoints_;
+    std::vector<std::unique_ptr<ConnectAttempt>> connect_attempts_;
+    std::unique_ptr<asio::steady_timer> connect_timer_;
+    size_t next_endpoint_index_ = 0;
+    size_t pending_connect_attempts_ = 0;
+    std::error_code last_connect_error_;
+
     Listener* listener_ = nullptr;
+    std::map<uint8_t, StreamListener*> stream_listeners_;
     bool connected_ = false;
     bool paused_ = true;
 
     std::unique_ptr<MessageEncryptor> encryptor_;
     std::unique_ptr<MessageDecryptor> decryptor_;
 
-    std::queue<ByteArray> write_queue_;
+    std::queue<PendingMessage> write_queue_;
+
+    // Messages from |write_queue_| are distributed here by doWrite(). Streams of the same class
+    // are scheduled round-robin; CONTROL streams are drained before BULK streams.
+    // |queued_messages_| counts messages over all stream queues; |last_control_stream_| and
+    // |last_bulk_stream_| are where the round-robin scans of the two classes resume.
+    std::map<uint8_t, std::deque<StreamMessage>> stream_queues_;
+    std::map<uint8_t, StreamClass> stream_classes_;
+    size_t queued_messages_ = 0;
+    uint8_t last_control_stream_ = 0;
+    uint8_t last_bulk_stream_ = 0;
+
+    // Buffers of already sent messages, kept for reuse through takeSpareBuffer().
+    std::vector<ByteArray> spare_buffers_;
+
     VariableSizeWriter variable_size_writer_;
+    // The write buffer is kept at its high-water size and |write_size_| tracks the used part.
+    // Shrinking it with resize() would make the next vector growth zero-fill memory that the
+    // encryptor overwrites anyway, a full extra pass over every outgoing frame.
     ByteArray write_buffer_;
+    size_t write_size_ = 0;
+
+    // Number of messages gathered into |write_buffer_| for the write in progress.
+    size_t messages_in_write_ = 0;
+
+    // Plaintext of a large message that is being encrypted and written chunk by chunk, and the
+    // offset of the first byte not yet encrypted. Zero offset means no chunked write is in
+    // progress. See doWrite().
+    ByteArray chunk_buffer_;
+    size_t chunk_offset_ = 0;
 
     enum class ReadState
     {
@@ -198,7 +365,17 @@ private:
     };
 
     ReadState state_ = ReadState::IDLE;
-    VariableSizeReader variable_size_reader_;
+
+    // Speculative header read: up to four bytes are fetched in one operation instead of one
+    // read per header byte. Bytes past the variable-length size header belong to the message
+    // content or, for tiny messages, to the next header, and stay buffered here until they
+    // are consumed. See doReadSize().
+    uint8_t header_buffer_[4];
+    size_t header_size_ = 0;
+
+    // Content bytes of the current message that arrived with its header.
+    size_t read_offset_ = 0;
+
     ByteArray read_buffer_;
     ByteArray decrypt_buffer_;
 
@@ -216,6 +393,27 @@ private:
     int64_t bytes_rx_ = 0;
     int speed_rx_ = 0;
 
+    // Start time of the socket write in progress and the accumulated write statistics.
+    TimePoint write_begin_time_;
+    uint64_t write_count_ = 0;
+    uint64_t write_time_us_ = 0;
+
+    // Send pacing state. The token bucket is allowed to go negative: a write larger than the
+    // bucket is never blocked, it only pushes the next write further out, so the average rate
+    // still converges to |send_rate_limit_|. See startWrite().
+    uint64_t send_rate_limit_ = 0;
+    double pacer_tokens_ = 0.0;
+    TimePoint pacer_last_refill_;
+    std::unique_ptr<asio::steady_timer> pacer_timer_;
+
+    // Send queue tuning state (see setSendQueueAutoTuning()). |tuned_lowat_| is the watermark
+    // currently applied to the socket; |tune_bytes_| counts bytes written since the last
+    // tuning pass.
+    bool send_queue_tuning_ = false;
+    TimePoint last_tune_time_;
+    int64_t tune_bytes_ = 0;
+    size_t tuned_lowat_ = 0;
+
     DISALLOW_COPY_AND_ASSIGN(NetworkChannel);
 };
 
@@ -32,12 +32,29 @@ NetworkChannelProxy::NetworkChannelProxy(
 }
 
 void NetworkChannelProxy::send(ByteArray&& buffer)
+{
+    send(NetworkChannel::kDefaultStreamId, std::move(buffer));
+}
+
+void NetworkChannelProxy::send(uint8_t stream_id, ByteArray&& buffer)
+{
+    send(stream_id, std::move(buffer), false);
+}
+
+void NetworkChannelProxy::send(uint8_t stream_id, ByteArray&& buffer, bool discardable)
 {
     std::scoped_lock lock(incoming_queue_lock_);
 
     bool schedule_write = incoming_queue_.empty();
 
-    incoming_queue_.emplace(std::move(buffer));
+    if (schedule_write)
+        oldest_enqueue_time_ = std::chrono::steady_clock::now();
+
+    incoming_queue_.emplace(
+        NetworkChannel::PendingMessage { stream_id, std::move(buffer), discardable });
+
+    if (incoming_queue_.size() > max_queue_depth_)
+        max_queue_depth_ = incoming_queue_.size();
 
     if (!schedule_write)
         return;
@@ -45,6 +62,27 @@ void NetworkChannelProxy::send(ByteArray&& buffer)
     task_runner_->postTask(std::bind(&NetworkChannelProxy::scheduleWrite, shared_from_this()));
 }
 
+size_t NetworkChannelProxy::takeMaxQueueDepth()
+{
+    std::scoped_lock lock(incoming_queue_lock_);
+
+    size_t max_queue_depth = max_queue_depth_;
+    max_queue_depth_ = 0;
+
+    return max_queue_depth;
+}
+
+uint64_t NetworkChannelProxy::queueAgeUs()
+{
+    std::scoped_lock lock(incoming_queue_lock_);
+
+    if (incoming_queue_.empty())
+        return 0;
+
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - oldest_enqueue_time_).count());
+}
+
 void NetworkChannelProxy::willDestroyCurrentChannel()
 {
     channel_ = nullptr;
@@ -58,10 +96,15 @@ void NetworkChannelProxy::scheduleWrite()
     if (!reloadWriteQueue(&channel_->write_queue_))
         return;
 
+    // If a batch is being written right now, onWrite() picks up the reloaded queue when it
+    // completes; starting another write here would interleave two batches on the socket.
+    if (channel_->messages_in_write_ != 0)
+        return;
+
     channel_->doWrite();
 }
 
-bool NetworkChannelProxy::reloadWriteQueue(std::queue<ByteArray>* work_queue)
+bool NetworkChannelProxy::reloadWriteQueue(std::queue<NetworkChannel::PendingMessage>* work_queue)
 {
     if (!work_queue->empty())
         return false;
@@ -21,6 +21,7 @@
 
 #include "base/net/network_channel.h"
 
+#include <chrono>
 #include <shared_mutex>
 
 namespace base {
@@ -32,6 +33,20 @@ class NetworkChannelProxy : public std::enable_shared_from_this<NetworkChannelPr
 public:
     void send(ByteArray&& buffer);
 
+    // See NetworkChannel::send(uint8_t, ByteArray&&).
+    void send(uint8_t stream_id, ByteArray&& buffer);
+
+    // See NetworkChannel::send(uint8_t, ByteArray&&, bool).
+    void send(uint8_t stream_id, ByteArray&& buffer, bool discardable);
+
+    // Peak depth of the incoming queue since the last call. Reading resets the gauge, so each
+    // caller sees the maximum over its own sampling interval.
+    size_t takeMaxQueueDepth();
+
+    // Age of the oldest queued message in microseconds, or 0 when the queue is empty. A growing
+    // age means the channel thread has stopped draining the queue.
+    uint64_t queueAgeUs();
+
 private:
     friend class NetworkChannel;
     NetworkChannelProxy(std::shared_ptr<TaskRunner> task_runner, NetworkChannel* channel);
@@ -40,15 +55,19 @@ private:
     void willDestroyCurrentChannel();
 
     void scheduleWrite();
-    bool reloadWriteQueue(std::queue<ByteArray>* work_queue);
+    bool reloadWriteQueue(std::queue<NetworkChannel::PendingMessage>* work_queue);
 
     std::shared_ptr<TaskRunner> task_runner_;
 
     NetworkChannel* channel_;
 
-    std::queue<ByteArray> incoming_queue_;
+    std::queue<NetworkChannel::PendingMessage> incoming_queue_;
     std::mutex incoming_queue_lock_;
 
+    // Depth/age gauges for the stats extension. Guarded by |incoming_queue_lock_|.
+    size_t max_queue_depth_ = 0;
+    std::chrono::steady_clock::time_point oldest_enqueue_time_;
+
     DISALLOW_COPY_AND_ASSIGN(NetworkChannelProxy);
 };
 
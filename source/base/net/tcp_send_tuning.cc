@@ -0,0 +1,122 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/net/tcp_send_tuning.h"
+
+#include "base/logging.h"
+
+#if defined(OS_WIN)
+#include <winsock2.h>
+#include <mstcpip.h>
+#endif // defined(OS_WIN)
+
+#if defined(OS_POSIX)
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#endif // defined(OS_POSIX)
+
+namespace base {
+
+bool setTcpNotsentLowat(NativeSocket socket, size_t bytes)
+{
+#if defined(OS_LINUX) || defined(OS_MAC)
+    int value = static_cast<int>(bytes);
+    if (setsockopt(socket, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &value, sizeof(value)) == -1)
+    {
+        PLOG(LS_WARNING) << "setsockopt(TCP_NOTSENT_LOWAT) failed";
+        return false;
+    }
+
+    return true;
+#else
+    // No unsent-data watermark on this platform.
+    return false;
+#endif
+}
+
+bool tcpRoundTripTime(NativeSocket socket, std::chrono::microseconds* rtt)
+{
+#if defined(OS_LINUX)
+    struct tcp_info info;
+    socklen_t length = sizeof(info);
+
+    if (getsockopt(socket, IPPROTO_TCP, TCP_INFO, &info, &length) == -1)
+    {
+        PLOG(LS_WARNING) << "getsockopt(TCP_INFO) failed";
+        return false;
+    }
+
+    *rtt = std::chrono::microseconds(info.tcpi_rtt);
+    return true;
+#elif defined(OS_MAC)
+    struct tcp_connection_info info;
+    socklen_t length = sizeof(info);
+
+    if (getsockopt(socket, IPPROTO_TCP, TCP_CONNECTION_INFO, &info, &length) == -1)
+    {
+        PLOG(LS_WARNING) << "getsockopt(TCP_CONNECTION_INFO) failed";
+        return false;
+    }
+
+    // |tcpi_srtt| is reported in milliseconds.
+    *rtt = std::chrono::milliseconds(info.tcpi_srtt);
+    return true;
+#elif defined(OS_WIN)
+    TCP_INFO_v0 info;
+    DWORD version = 0;
+    DWORD bytes_returned = 0;
+
+    if (WSAIoctl(socket, SIO_TCP_INFO,
+                 &version, sizeof(version), &info, sizeof(info), &bytes_returned,
+                 nullptr, nullptr) == SOCKET_ERROR)
+    {
+        PLOG(LS_WARNING) << "WSAIoctl(SIO_TCP_INFO) failed";
+        return false;
+    }
+
+    *rtt = std::chrono::microseconds(info.RttUs);
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool tcpIdealSendBacklog(NativeSocket socket, size_t* bytes)
+{
+#if defined(OS_WIN)
+    ULONG backlog = 0;
+    DWORD bytes_returned = 0;
+
+    if (WSAIoctl(socket, SIO_IDEAL_SEND_BACKLOG_QUERY,
+                 nullptr, 0, &backlog, sizeof(backlog), &bytes_returned,
+                 nullptr, nullptr) == SOCKET_ERROR)
+    {
+        PLOG(LS_WARNING) << "WSAIoctl(SIO_IDEAL_SEND_BACKLOG_QUERY) failed";
+        return false;
+    }
+
+    *bytes = backlog;
+    return true;
+#else
+    return false;
+#endif
+}
+
+} // namespace base
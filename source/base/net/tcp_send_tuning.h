@@ -0,0 +1,44 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__NET__TCP_SEND_TUNING_H
+#define BASE__NET__TCP_SEND_TUNING_H
+
+#include "base/net/tcp_keep_alive.h"
+
+#include <chrono>
+#include <cstddef>
+
+namespace base {
+
+// Bounds the amount of data the kernel keeps queued but not yet sent for |socket|
+// (TCP_NOTSENT_LOWAT). Returns false when the option is not supported on this platform;
+// Windows has no equivalent and bounds the queue through the send buffer size instead
+// (see tcpIdealSendBacklog()).
+bool setTcpNotsentLowat(NativeSocket socket, size_t bytes);
+
+// Returns the smoothed round-trip time the TCP stack measured for |socket|.
+bool tcpRoundTripTime(NativeSocket socket, std::chrono::microseconds* rtt);
+
+// Returns the send backlog the stack considers ideal for the current path (Windows only;
+// SIO_IDEAL_SEND_BACKLOG_QUERY). Returns false on other platforms.
+bool tcpIdealSendBacklog(NativeSocket socket, size_t* bytes);
+
+} // namespace base
+
+#endif // BASE__NET__TCP_SEND_TUNING_H
@@ -0,0 +1,337 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/net/udp_channel.h"
+
+#include "base/endian_util.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/crypto/message_encryptor_fake.h"
+#include "base/crypto/message_decryptor_fake.h"
+#include "base/message_loop/message_loop.h"
+#include "base/message_loop/message_pump_asio.h"
+#include "base/strings/unicode.h"
+
+#include <cstring>
+
+namespace base {
+
+namespace {
+
+// Size of the sequence number prefix of each datagram.
+const size_t kHeaderSize = 8;
+
+// Largest datagram we are prepared to receive.
+const size_t kReadBufferSize = 65536;
+
+// Limit on the number of queued outgoing messages. When it is exceeded the oldest message is
+// dropped: for an unreliable stream retransmitting old data is pointless.
+const size_t kMaxWriteQueueSize = 64;
+
+} // namespace
+
+UdpChannel::UdpChannel()
+    : io_context_(MessageLoop::current()->pumpAsio()->ioContext()),
+      socket_(io_context_),
+      resolver_(std::make_unique<asio::ip::udp::resolver>(io_context_)),
+      encryptor_(std::make_unique<MessageEncryptorFake>()),
+      decryptor_(std::make_unique<MessageDecryptorFake>())
+{
+    read_buffer_.resize(kReadBufferSize);
+}
+
+UdpChannel::~UdpChannel()
+{
+    listener_ = nullptr;
+
+    std::error_code ignored_code;
+    socket_.cancel(ignored_code);
+    socket_.close(ignored_code);
+}
+
+void UdpChannel::setListener(Listener* listener)
+{
+    listener_ = listener;
+}
+
+void UdpChannel::setEncryptor(std::unique_ptr<MessageEncryptor> encryptor)
+{
+    encryptor_ = std::move(encryptor);
+}
+
+void UdpChannel::setDecryptor(std::unique_ptr<MessageDecryptor> decryptor)
+{
+    decryptor_ = std::move(decryptor);
+}
+
+void UdpChannel::connect(std::u16string_view address, uint16_t port)
+{
+    if (connected_ || !resolver_)
+        return;
+
+    resolver_->async_resolve(local8BitFromUtf16(address), std::to_string(port),
+        [this](const std::error_code& error_code,
+               const asio::ip::udp::resolver::results_type& endpoints)
+    {
+        if (error_code)
+        {
+            onErrorOccurred(FROM_HERE, error_code);
+            return;
+        }
+
+        peer_endpoint_ = *endpoints.begin();
+
+        std::error_code open_error_code;
+        socket_.open(peer_endpoint_.protocol(), open_error_code);
+        if (open_error_code)
+        {
+            onErrorOccurred(FROM_HERE, open_error_code);
+            return;
+        }
+
+        connected_ = true;
+
+        if (listener_)
+            listener_->onUdpConnected();
+
+        doReceive();
+
+        if (!write_queue_.empty() && !write_in_progress_)
+            doSend();
+    });
+}
+
+void UdpChannel::listen(uint16_t port)
+{
+    if (connected_ || waiting_for_peer_)
+        return;
+
+    asio::ip::udp::endpoint endpoint(asio::ip::udp::v4(), port);
+
+    std::error_code error_code;
+    socket_.open(endpoint.protocol(), error_code);
+    if (error_code)
+    {
+        onErrorOccurred(FROM_HERE, error_code);
+        return;
+    }
+
+    socket_.bind(endpoint, error_code);
+    if (error_code)
+    {
+        onErrorOccurred(FROM_HERE, error_code);
+        return;
+    }
+
+    waiting_for_peer_ = true;
+    doReceive();
+}
+
+void UdpChannel::send(ByteArray&& buffer)
+{
+    DCHECK(!buffer.empty());
+    DCHECK_LE(buffer.size(), kMaxMessageSize);
+
+    if (write_queue_.size() == kMaxWriteQueueSize)
+        write_queue_.pop();
+
+    write_queue_.emplace(std::move(buffer));
+
+    if (connected_ && !write_in_progress_)
+        doSend();
+}
+
+void UdpChannel::doSend()
+{
+    DCHECK(connected_);
+    DCHECK(!write_queue_.empty());
+
+    const ByteArray& source_buffer = write_queue_.front();
+
+    write_buffer_.resize(kHeaderSize + encryptor_->encryptedDataSize(source_buffer.size()));
+
+    const uint64_t sequence = EndianUtil::toBig(send_sequence_);
+    memcpy(write_buffer_.data(), &sequence, kHeaderSize);
+
+    encryptor_->setMessageId(send_sequence_);
+
+    if (!encryptor_->encrypt(source_buffer.data(),
+                             source_buffer.size(),
+                             write_buffer_.data() + kHeaderSize))
+    {
+        onErrorOccurred(FROM_HERE, asio::error::access_denied);
+        return;
+    }
+
+    ++send_sequence_;
+    write_queue_.pop();
+    write_in_progress_ = true;
+
+    socket_.async_send_to(asio::buffer(write_buffer_.data(), write_buffer_.size()),
+                          peer_endpoint_,
+        [this](const std::error_code& error_code, size_t /* bytes_transferred */)
+    {
+        if (error_code)
+        {
+            onErrorOccurred(FROM_HERE, error_code);
+            return;
+        }
+
+        write_in_progress_ = false;
+
+        if (!write_queue_.empty())
+            doSend();
+    });
+}
+
+void UdpChannel::doReceive()
+{
+    socket_.async_receive_from(
+        asio::buffer(read_buffer_.data(), read_buffer_.size()), sender_endpoint_,
+        [this](const std::error_code& error_code, size_t bytes_transferred)
+    {
+        if (error_code)
+        {
+            if (error_code == asio::error::operation_aborted)
+                return;
+
+            // A previous send may come back as an ICMP error (e.g. port unreachable) on the
+            // next receive. The datagram stream itself is lossy, so keep receiving.
+            if (error_code == asio::error::connection_refused ||
+                error_code == asio::error::connection_reset)
+            {
+                doReceive();
+                return;
+            }
+
+            onErrorOccurred(FROM_HERE, error_code);
+            return;
+        }
+
+        if (bytes_transferred <= kHeaderSize)
+        {
+            LOG(LS_WARNING) << "Datagram is too short: " << bytes_transferred;
+            doReceive();
+            return;
+        }
+
+        if (connected_ && sender_endpoint_ != peer_endpoint_)
+        {
+            // Not our peer.
+            doReceive();
+            return;
+        }
+
+        uint64_t sequence;
+        memcpy(&sequence, read_buffer_.data(), kHeaderSize);
+        sequence = EndianUtil::fromBig(sequence);
+
+        if (has_received_ && sequence <= last_sequence_)
+        {
+            // A reordered datagram. It was already counted as lost when the gap was seen.
+            doReceive();
+            return;
+        }
+
+        const size_t in_size = bytes_transferred - kHeaderSize;
+        const size_t decrypt_buffer_size = decryptor_->decryptedDataSize(in_size);
+
+        if (decrypt_buffer_.capacity() < decrypt_buffer_size)
+            decrypt_buffer_.reserve(decrypt_buffer_size);
+
+        decrypt_buffer_.resize(decrypt_buffer_size);
+
+        // The sequence number selects the nonce, so a datagram with a forged sequence number
+        // does not authenticate.
+        decryptor_->setMessageId(sequence);
+
+        if (!decryptor_->decrypt(read_buffer_.data() + kHeaderSize,
+                                 in_size,
+                                 decrypt_buffer_.data()))
+        {
+            LOG(LS_WARNING) << "Unable to decrypt datagram";
+            doReceive();
+            return;
+        }
+
+        if (waiting_for_peer_)
+        {
+            // Lock the peer to the source of the first datagram that decrypts successfully.
+            peer_endpoint_ = sender_endpoint_;
+            waiting_for_peer_ = false;
+            connected_ = true;
+
+            if (listener_)
+                listener_->onUdpConnected();
+        }
+
+        const uint64_t lost = has_received_ ? sequence - last_sequence_ - 1 : sequence;
+
+        last_sequence_ = sequence;
+        has_received_ = true;
+
+        if (lost && listener_)
+            listener_->onUdpDatagramsLost(lost);
+
+        if (listener_)
+            listener_->onUdpMessageReceived(decrypt_buffer_);
+
+        doReceive();
+
+        if (!write_queue_.empty() && !write_in_progress_)
+            doSend();
+    });
+}
+
+void UdpChannel::onErrorOccurred(const Location& location, const std::error_code& error_code)
+{
+    if (error_code == asio::error::operation_aborted)
+        return;
+
+    NetworkChannel::ErrorCode error = NetworkChannel::ErrorCode::UNKNOWN;
+
+    if (error_code == asio::error::access_denied)
+        error = NetworkChannel::ErrorCode::ACCESS_DENIED;
+    else if (error_code == asio::error::host_not_found)
+        error = NetworkChannel::ErrorCode::SPECIFIED_HOST_NOT_FOUND;
+    else if (error_code == asio::error::address_in_use)
+        error = NetworkChannel::ErrorCode::ADDRESS_IN_USE;
+    else if (error_code == asio::error::host_unreachable)
+        error = NetworkChannel::ErrorCode::ADDRESS_NOT_AVAILABLE;
+    else if (error_code == asio::error::network_down)
+        error = NetworkChannel::ErrorCode::NETWORK_ERROR;
+
+    LOG(LS_WARNING) << "UDP channel error: " << utf16FromLocal8Bit(error_code.message())
+                    << " (code: " << error_code.value()
+                    << ", location: " << location.toString() << ")";
+
+    connected_ = false;
+    waiting_for_peer_ = false;
+
+    std::error_code ignored_code;
+    socket_.cancel(ignored_code);
+    socket_.close(ignored_code);
+
+    if (listener_)
+    {
+        listener_->onUdpErrorOccurred(error);
+        listener_ = nullptr;
+    }
+}
+
+} // namespace base
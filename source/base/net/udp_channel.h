@@ -0,0 +1,126 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__NET__UDP_CHANNEL_H
+#define BASE__NET__UDP_CHANNEL_H
+
+#include "base/memory/byte_array.h"
+#include "base/net/network_channel.h"
+
+#include <asio/ip/udp.hpp>
+
+namespace base {
+
+// Unreliable datagram channel that runs next to a NetworkChannel. It is intended for media
+// streams (e.g. video) where a lost message is cheaper to regenerate than to retransmit;
+// control messages must stay on the reliable channel.
+//
+// Each datagram carries a 64-bit sequence number followed by the ciphertext of one message.
+// The cryptographers must be set up with the same keys on both sides (see setMessageId in
+// MessageEncryptor); the sequence number selects the nonce, so every datagram is decryptable
+// on its own and a forged or corrupted sequence number fails authentication.
+//
+// Datagrams are not fragmented: a message must fit in kMaxMessageSize after encryption
+// overhead. Stale (reordered) datagrams are dropped; gaps in the sequence are reported
+// through Listener::onUdpDatagramsLost() so the sender can be asked to refresh the stream
+// (for video - request a key frame).
+class UdpChannel
+{
+public:
+    UdpChannel();
+    ~UdpChannel();
+
+    class Listener
+    {
+    public:
+        virtual ~Listener() = default;
+
+        // Called when the channel is ready to send and receive datagrams. On the connecting
+        // side this is after the address is resolved; on the listening side, after the first
+        // datagram from the peer is successfully decrypted.
+        virtual void onUdpConnected() = 0;
+
+        // Called for each received datagram, in arrival order. Stale and undecryptable
+        // datagrams are dropped before this point.
+        virtual void onUdpMessageReceived(const ByteArray& buffer) = 0;
+
+        // Called when a gap in sequence numbers shows that |count| datagrams did not arrive.
+        // Reordered datagrams are counted as lost and then dropped on arrival.
+        virtual void onUdpDatagramsLost(uint64_t count) = 0;
+
+        virtual void onUdpErrorOccurred(NetworkChannel::ErrorCode error_code) = 0;
+    };
+
+    // Maximum size of a message before encryption. Kept under the usual path MTU so that
+    // datagrams are not fragmented by the network; the sender splits larger payloads.
+    static constexpr size_t kMaxMessageSize = 1400;
+
+    void setListener(Listener* listener);
+
+    // Sets an instance of a class to encrypt and decrypt messages.
+    // By default, a fake cryptographer is created that only copies the original message.
+    void setEncryptor(std::unique_ptr<MessageEncryptor> encryptor);
+    void setDecryptor(std::unique_ptr<MessageDecryptor> decryptor);
+
+    // Starts exchanging datagrams with a host at the specified address and port.
+    void connect(std::u16string_view address, uint16_t port);
+
+    // Binds to the specified local port and waits for the first datagram. The peer address is
+    // locked to the source of the first datagram that decrypts successfully.
+    void listen(uint16_t port);
+
+    // Sending a message. If the send queue is full, the oldest queued message is dropped:
+    // for an unreliable stream old data loses its value first.
+    void send(ByteArray&& buffer);
+
+private:
+    void doSend();
+    void doReceive();
+    void onErrorOccurred(const Location& location, const std::error_code& error_code);
+
+    asio::io_context& io_context_;
+    asio::ip::udp::socket socket_;
+    std::unique_ptr<asio::ip::udp::resolver> resolver_;
+
+    Listener* listener_ = nullptr;
+    bool connected_ = false;
+
+    // Set when listen() is used and the peer is not locked yet.
+    bool waiting_for_peer_ = false;
+    asio::ip::udp::endpoint peer_endpoint_;
+    asio::ip::udp::endpoint sender_endpoint_;
+
+    std::unique_ptr<MessageEncryptor> encryptor_;
+    std::unique_ptr<MessageDecryptor> decryptor_;
+
+    std::queue<ByteArray> write_queue_;
+    ByteArray write_buffer_;
+    bool write_in_progress_ = false;
+    uint64_t send_sequence_ = 0;
+
+    ByteArray read_buffer_;
+    ByteArray decrypt_buffer_;
+    uint64_t last_sequence_ = 0;
+    bool has_received_ = false;
+
+    DISALLOW_COPY_AND_ASSIGN(UdpChannel);
+};
+
+} // namespace base
+
+#endif // BASE__NET__UDP_CHANNEL_H
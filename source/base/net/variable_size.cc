@@ -18,51 +18,8 @@
 
 #include "base/net/variable_size.h"
 
-#include "base/logging.h"
-
 namespace base {
 
-VariableSizeReader::VariableSizeReader() = default;
-
-VariableSizeReader::~VariableSizeReader() = default;
-
-asio::mutable_buffer VariableSizeReader::buffer()
-{
-    DCHECK_LT(pos_, std::size(buffer_));
-
-    return asio::mutable_buffer(&buffer_[pos_], sizeof(uint8_t));
-}
-
-std::optional<size_t> VariableSizeReader::messageSize()
-{
-    DCHECK_LT(pos_, std::size(buffer_));
-
-    if (pos_ == 3 || !(buffer_[pos_] & 0x80))
-    {
-        size_t result = buffer_[0] & 0x7F;
-
-        if (pos_ >= 1)
-            result += (buffer_[1] & 0x7F) << 7;
-
-        if (pos_ >= 2)
-            result += (buffer_[2] & 0x7F) << 14;
-
-        if (pos_ >= 3)
-            result += buffer_[3] << 21;
-
-        memset(buffer_, 0, std::size(buffer_));
-        pos_ = 0;
-
-        return result;
-    }
-    else
-    {
-        ++pos_;
-
-        return std::nullopt;
-    }
-}
-
 VariableSizeWriter::VariableSizeWriter() = default;
 
 VariableSizeWriter::~VariableSizeWriter() = default;
@@ -24,26 +24,9 @@
 #include <asio/buffer.hpp>
 
 #include <cstdint>
-#include <optional>
 
 namespace base {
 
-class VariableSizeReader
-{
-public:
-    VariableSizeReader();
-    ~VariableSizeReader();
-
-    asio::mutable_buffer buffer();
-    std::optional<size_t> messageSize();
-
-private:
-    uint8_t buffer_[4] = { 0 };
-    size_t pos_ = 0;
-
-    DISALLOW_COPY_AND_ASSIGN(VariableSizeReader);
-};
-
 class VariableSizeWriter
 {
 public:
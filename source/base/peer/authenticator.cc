@@ -20,7 +20,9 @@
 
 #include "base/location.h"
 #include "base/logging.h"
+#include "base/crypto/message_decryptor_fake.h"
 #include "base/crypto/message_decryptor_openssl.h"
+#include "base/crypto/message_encryptor_fake.h"
 #include "base/crypto/message_encryptor_openssl.h"
 
 namespace base {
@@ -70,9 +72,26 @@ std::unique_ptr<NetworkChannel> Authenticator::takeChannel()
     if (state() != State::SUCCESS)
         return nullptr;
 
+    if (plaintext_on_loopback_)
+    {
+        // Both sides of a same-machine connection agreed to drop transport encryption now that
+        // the handshake (including the encrypted session challenge) is complete. Loopback
+        // traffic never leaves the machine, and skipping the cipher removes most of the CPU
+        // cost of local sessions.
+        LOG(LS_INFO) << "Loopback connection; transport encryption disabled";
+
+        channel_->setEncryptor(std::make_unique<MessageEncryptorFake>());
+        channel_->setDecryptor(std::make_unique<MessageDecryptorFake>());
+    }
+
     return std::move(channel_);
 }
 
+bool Authenticator::isLoopbackChannel() const
+{
+    return channel_ && channel_->isLoopback();
+}
+
 // static
 const char* Authenticator::stateToString(State state)
 {
@@ -80,6 +80,9 @@ protected:
 
     void sendMessage(const google::protobuf::MessageLite& message);
     void finish(const Location& location, ErrorCode error_code);
+
+    // Returns true if the peer is connected through the loopback interface.
+    [[nodiscard]] bool isLoopbackChannel() const;
     void setPeerVersion(const proto::Version& version);
     void setPeerOsName(const std::string& name);
     void setPeerComputerName(const std::string& name);
@@ -101,6 +104,11 @@ protected:
     uint32_t session_type_ = 0; // Selected session type.
     std::string user_name_;
 
+    // Both sides are on the same machine and agreed to drop transport encryption once the
+    // handshake is complete (see |ClientHello.plaintext_on_loopback|). The swap happens in
+    // takeChannel(), so every message of the handshake itself is still encrypted.
+    bool plaintext_on_loopback_ = false;
+
 private:
     WaitableTimer timer_;
     std::unique_ptr<NetworkChannel> channel_;
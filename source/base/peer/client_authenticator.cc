@@ -104,6 +104,12 @@ void ClientAuthenticator::setSessionType(uint32_t session_type)
     session_type_ = session_type;
 }
 
+void ClientAuthenticator::setTicket(const ByteArray& ticket, const ByteArray& ticket_secret)
+{
+    ticket_ = ticket;
+    ticket_secret_ = ticket_secret;
+}
+
 bool ClientAuthenticator::onStarted()
 {
     internal_state_ = InternalState::SEND_CLIENT_HELLO;
@@ -119,7 +125,7 @@ void ClientAuthenticator::onReceived(const ByteArray& buffer)
         {
             if (readServerHello(buffer))
             {
-                if (identify_ == proto::IDENTIFY_ANONYMOUS)
+                if (session_resumed_ || identify_ == proto::IDENTIFY_ANONYMOUS)
                 {
                     internal_state_ = InternalState::READ_SESSION_CHALLENGE;
                 }
@@ -223,6 +229,10 @@ void ClientAuthenticator::sendClientHello()
     client_hello.set_encryption(encryption);
     client_hello.set_identify(identify_);
 
+    // Offer to drop transport encryption after the handshake when the host runs on the same
+    // machine. The server confirms only if it sees the connection on loopback too.
+    client_hello.set_plaintext_on_loopback(isLoopbackChannel());
+
     if (!peer_public_key_.empty())
     {
         encrypt_iv_ = Random::byteArray(kIvSize);
@@ -264,6 +274,25 @@ void ClientAuthenticator::sendClientHello()
         client_hello.set_iv(toStdString(encrypt_iv_));
     }
 
+    if (!ticket_.empty() && !ticket_secret_.empty())
+    {
+        // Offer session resumption. The key exchange above is kept, so if the server rejects
+        // the ticket the handshake continues unchanged.
+        if (encrypt_iv_.empty())
+        {
+            encrypt_iv_ = Random::byteArray(kIvSize);
+            if (encrypt_iv_.empty())
+            {
+                finish(FROM_HERE, ErrorCode::UNKNOWN_ERROR);
+                return;
+            }
+
+            client_hello.set_iv(toStdString(encrypt_iv_));
+        }
+
+        client_hello.set_ticket(toStdString(ticket_));
+    }
+
     LOG(LS_INFO) << "Sending: ClientHello";
     sendMessage(client_hello);
 }
@@ -295,6 +324,37 @@ bool ClientAuthenticator::readServerHello(const ByteArray& buffer)
 
     decrypt_iv_ = fromStdString(server_hello.iv());
 
+    // Accept the plaintext downgrade only if we offered it ourselves, i.e. the connection is
+    // on loopback from our side as well; a remote server cannot force it.
+    plaintext_on_loopback_ = server_hello.plaintext_on_loopback() && isLoopbackChannel();
+
+    if (server_hello.session_resumed())
+    {
+        // The server accepted our resumption ticket.
+        if (ticket_secret_.empty() || encrypt_iv_.empty() || decrypt_iv_.empty())
+        {
+            finish(FROM_HERE, ErrorCode::PROTOCOL_ERROR);
+            return false;
+        }
+
+        // Mirrors the derivation on the server side: the session key is a hash of the
+        // resumption secret and the fresh IVs of both sides.
+        GenericHash hash(GenericHash::BLAKE2s256);
+        hash.addData(ticket_secret_);
+        hash.addData(encrypt_iv_);
+        hash.addData(decrypt_iv_);
+        session_key_ = hash.result();
+
+        if (!onSessionKeyChanged())
+        {
+            finish(FROM_HERE, ErrorCode::UNKNOWN_ERROR);
+            return false;
+        }
+
+        session_resumed_ = true;
+        return true;
+    }
+
     if (session_key_.empty() != decrypt_iv_.empty())
     {
         finish(FROM_HERE, ErrorCode::PROTOCOL_ERROR);
@@ -412,6 +472,18 @@ bool ClientAuthenticator::readSessionChallenge(const ByteArray& buffer)
     setPeerOsName(challenge.os_name());
     setPeerComputerName(challenge.computer_name());
 
+    ticket_ = fromStdString(challenge.ticket());
+    if (!ticket_.empty())
+    {
+        // Secret to redeem the ticket on the next connection. Must match the derivation on the
+        // server side.
+        ticket_secret_ = GenericHash::hash(GenericHash::Type::BLAKE2s256, session_key_);
+    }
+    else
+    {
+        ticket_secret_ = ByteArray();
+    }
+
     LOG(LS_INFO) << "Server Version: " << peerVersion();
     LOG(LS_INFO) << "Server Name: " << challenge.computer_name();
     LOG(LS_INFO) << "Server OS: " << challenge.os_name();
@@ -36,6 +36,18 @@ public:
     void setPassword(std::u16string_view password);
     void setSessionType(uint32_t session_type);
 
+    // Sets the session-resumption ticket and its secret saved from a previous connection to
+    // the same server (see ticket()/ticketSecret()). If the server accepts the ticket, the SRP
+    // exchange is skipped; otherwise the full handshake proceeds unchanged. Must be called
+    // before start().
+    void setTicket(const ByteArray& ticket, const ByteArray& ticket_secret);
+
+    // Resumption ticket issued by the server and the secret to redeem it. Valid after
+    // successful authentication; pass both to setTicket() on reconnect. Empty if the server
+    // did not issue a ticket.
+    [[nodiscard]] const ByteArray& ticket() const { return ticket_; }
+    [[nodiscard]] const ByteArray& ticketSecret() const { return ticket_secret_; }
+
 protected:
     // Authenticator implementation.
     bool onStarted() override;
@@ -68,6 +80,10 @@ private:
     std::u16string username_;
     std::u16string password_;
 
+    ByteArray ticket_;
+    ByteArray ticket_secret_;
+    bool session_resumed_ = false;
+
     BigNum N_;
     BigNum g_;
     BigNum s_;
@@ -0,0 +1,57 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__PEER__HEARTBEAT_H
+#define BASE__PEER__HEARTBEAT_H
+
+#include <chrono>
+#include <cstdint>
+
+namespace base {
+
+// Application-level heartbeat between an online host and the router. The host sends a single
+// marker byte on a dedicated stream of the existing channel and the router echoes it back
+// unchanged. The frame is fixed and is handled without a protobuf parse on either side, so at
+// thousands of online hosts the steady-state cost on the router stays negligible.
+//
+// Both sides detect support from the first frame they receive: a router that never sees a
+// heartbeat applies no heartbeat timeout to the session, and a host that never sees an echo
+// applies none to the router, so mixed versions keep the old behavior.
+
+// Stream the heartbeat frames travel on. Reserved; it must not collide with the data streams
+// of any session type.
+const uint8_t kHeartbeatStreamId = 255;
+
+// The only valid content of a heartbeat frame.
+const uint8_t kHeartbeatMarker = 0x48;
+
+// Interval between heartbeats of the host.
+const std::chrono::seconds kHeartbeatInterval{ 30 };
+
+// Tolerated lateness of a heartbeat. Used as the timer slack, so the heartbeats of an idle
+// host coalesce with its other background timers into a single wakeup. Already covered by the
+// slop in kHeartbeatTimeout below.
+const std::chrono::seconds kHeartbeatSlack{ 2 };
+
+// A peer that supports heartbeats but was silent this long is considered gone. Covers three
+// missed heartbeats.
+const std::chrono::seconds kHeartbeatTimeout{ 95 };
+
+} // namespace base
+
+#endif // BASE__PEER__HEARTBEAT_H
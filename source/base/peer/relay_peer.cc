@@ -33,6 +33,8 @@
 #include <asio/connect.hpp>
 #include <asio/write.hpp>
 
+#include <chrono>
+
 namespace base {
 
 RelayPeer::RelayPeer()
@@ -52,42 +54,150 @@ RelayPeer::~RelayPeer()
     socket_.close(ignored_code);
 }
 
+void RelayPeer::preconnect(const std::string& host, uint16_t port, Delegate* delegate)
+{
+    if (connect_state_ != ConnectState::NOT_STARTED)
+        return;
+
+    delegate_ = delegate;
+
+    LOG(LS_INFO) << "Prewarming relay connection to " << host << ":" << port;
+    doConnect(host, port);
+}
+
 void RelayPeer::start(const proto::RelayCredentials& credentials, Delegate* delegate)
 {
     delegate_ = delegate;
     DCHECK(delegate_);
 
     message_ = authenticationMessage(credentials.key(), credentials.secret());
+    has_credentials_ = true;
+
+    if (connect_state_ != ConnectState::NOT_STARTED &&
+        (connect_host_ != credentials.host() || connect_port_ != credentials.port()))
+    {
+        // The prewarmed connection goes to a different relay than the one offered. Discard it
+        // and connect anew; a pending handler completes with operation_aborted.
+        LOG(LS_INFO) << "Prewarmed connection to " << connect_host_ << ":" << connect_port_
+                     << " does not match the offered relay";
+
+        std::error_code ignored_code;
+        resolver_.cancel();
+        socket_.close(ignored_code);
+
+        connect_state_ = ConnectState::NOT_STARTED;
+    }
+
+    switch (connect_state_)
+    {
+        case ConnectState::CONNECTING:
+            // The transport connection is still being established; onConnected() is called
+            // from its handler.
+            return;
+
+        case ConnectState::CONNECTED:
+            LOG(LS_INFO) << "Using prewarmed relay connection";
+            onConnected();
+            return;
+
+        case ConnectState::FAILED:
+            // The prewarmed connection did not come up; retry now that it matters. A repeated
+            // failure is reported through the delegate.
+            connect_state_ = ConnectState::NOT_STARTED;
+            [[fallthrough]];
+
+        case ConnectState::NOT_STARTED:
+            doConnect(credentials.host(), credentials.port());
+            return;
+    }
+}
+
+void RelayPeer::doConnect(const std::string& host, uint16_t port)
+{
+    connect_state_ = ConnectState::CONNECTING;
+    connect_host_ = host;
+    connect_port_ = port;
+
+    const int generation = ++connect_generation_;
 
-    LOG(LS_INFO) << "Start resolving for " << credentials.host() << ":" << credentials.port();
+    LOG(LS_INFO) << "Start resolving for " << host << ":" << port;
 
-    resolver_.async_resolve(local8BitFromUtf16(utf16FromUtf8(credentials.host())),
-                            std::to_string(credentials.port()),
-        [this](const std::error_code& error_code,
-               const asio::ip::tcp::resolver::results_type& endpoints)
+    resolver_.async_resolve(local8BitFromUtf16(utf16FromUtf8(host)), std::to_string(port),
+        [this, generation](const std::error_code& error_code,
+                           const asio::ip::tcp::resolver::results_type& endpoints)
     {
+        // The attempt was abandoned in favor of a new one.
+        if (generation != connect_generation_)
+            return;
+
         if (error_code)
         {
             if (error_code != asio::error::operation_aborted)
-                onErrorOccurred(FROM_HERE, error_code);
+            {
+                if (has_credentials_)
+                {
+                    onErrorOccurred(FROM_HERE, error_code);
+                }
+                else
+                {
+                    LOG(LS_WARNING) << "Prewarmed relay resolve failed: "
+                                    << utf16FromLocal8Bit(error_code.message());
+                    connect_state_ = ConnectState::FAILED;
+                }
+            }
             return;
         }
 
         LOG(LS_INFO) << "Start connecting...";
 
+        // The duration of the TCP connect approximates the round trip to the relay; the
+        // resolve is excluded because it measures the resolver, not the relay.
+        const std::chrono::steady_clock::time_point connect_begin =
+            std::chrono::steady_clock::now();
+
         asio::async_connect(socket_, endpoints,
-                            [this](const std::error_code& error_code,
-                                   const asio::ip::tcp::endpoint& /* endpoint */)
+                            [this, generation, connect_begin](
+                                const std::error_code& error_code,
+                                const asio::ip::tcp::endpoint& /* endpoint */)
         {
+            if (generation != connect_generation_)
+                return;
+
             if (error_code)
             {
                 if (error_code != asio::error::operation_aborted)
-                    onErrorOccurred(FROM_HERE, error_code);
+                {
+                    if (has_credentials_)
+                    {
+                        onErrorOccurred(FROM_HERE, error_code);
+                    }
+                    else
+                    {
+                        LOG(LS_WARNING) << "Prewarmed relay connect failed: "
+                                        << utf16FromLocal8Bit(error_code.message());
+                        connect_state_ = ConnectState::FAILED;
+                    }
+                }
                 return;
             }
 
             LOG(LS_INFO) << "Connected";
-            onConnected();
+            connect_state_ = ConnectState::CONNECTED;
+
+            connect_time_ms_ = static_cast<uint32_t>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - connect_begin).count());
+
+            // Without credentials the authentication message cannot be sent yet; start() picks
+            // the connection up when the offer arrives.
+            if (has_credentials_)
+            {
+                onConnected();
+            }
+            else if (delegate_)
+            {
+                delegate_->onRelayPreconnected();
+            }
         });
     });
 }
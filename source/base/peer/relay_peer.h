@@ -43,12 +43,31 @@ public:
 
         virtual void onRelayConnectionReady(std::unique_ptr<NetworkChannel> channel) = 0;
         virtual void onRelayConnectionError() = 0;
+
+        // Called when a prewarmed connection has been established, before any credentials are
+        // known. Optional; the default does nothing.
+        virtual void onRelayPreconnected() {}
     };
 
+    // Opens the transport connection to the relay before the credentials are known, so the
+    // resolve and connect overlap the rest of the router conversation. When start() is later
+    // called with credentials for the same relay, the authentication message goes out over the
+    // already established connection; for a different relay the connection is discarded and a
+    // regular connect is performed. |delegate| may be null; it only receives
+    // onRelayPreconnected() until start() is called.
+    void preconnect(const std::string& host, uint16_t port, Delegate* delegate = nullptr);
+
     void start(const proto::RelayCredentials& credentials, Delegate* delegate);
     bool isFinished() const { return is_finished_; }
 
+    // Address of the last connection attempt and the duration of its TCP connect. The connect
+    // time is a cheap round-trip estimate to the relay; zero until a connect has completed.
+    const std::string& connectHost() const { return connect_host_; }
+    uint16_t connectPort() const { return connect_port_; }
+    uint32_t connectTimeMs() const { return connect_time_ms_; }
+
 private:
+    void doConnect(const std::string& host, uint16_t port);
     void onConnected();
     void onErrorOccurred(const Location& location, const std::error_code& error_code);
 
@@ -57,6 +76,20 @@ private:
     Delegate* delegate_ = nullptr;
     bool is_finished_ = false;
 
+    // State of the transport connection. FAILED is only reached while prewarming; with
+    // credentials present a connection error is reported to the delegate instead.
+    enum class ConnectState { NOT_STARTED, CONNECTING, CONNECTED, FAILED };
+
+    ConnectState connect_state_ = ConnectState::NOT_STARTED;
+    std::string connect_host_;
+    uint16_t connect_port_ = 0;
+    uint32_t connect_time_ms_ = 0;
+    bool has_credentials_ = false;
+
+    // Incremented for every connection attempt; handlers of an abandoned attempt (a prewarm
+    // to the wrong relay) compare it and bail out.
+    int connect_generation_ = 0;
+
     uint32_t message_size_ = 0;
     ByteArray message_;
 
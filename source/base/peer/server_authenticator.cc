@@ -24,6 +24,8 @@
 #include "base/logging.h"
 #include "base/sys_info.h"
 #include "base/crypto/generic_hash.h"
+#include "base/crypto/message_decryptor_openssl.h"
+#include "base/crypto/message_encryptor_openssl.h"
 #include "base/crypto/random.h"
 #include "base/crypto/srp_constants.h"
 #include "base/crypto/srp_math.h"
@@ -31,16 +33,71 @@
 #include "base/strings/unicode.h"
 #include "build/version.h"
 
+#include <ctime>
+
 namespace base {
 
 namespace {
 
 constexpr size_t kIvSize = 12;
 
+// Resumption tickets older than this are rejected and the client goes through the full
+// handshake again.
+constexpr uint64_t kTicketLifetimeSeconds = 8 * 60 * 60;
+
+// Seals |ticket| with |ticket_key|. Output format: IV (12 bytes) followed by the ciphertext
+// with the authentication tag.
+ByteArray sealTicket(const ByteArray& ticket_key, const proto::SessionTicket& ticket)
+{
+    ByteArray iv = Random::byteArray(kIvSize);
+
+    std::unique_ptr<MessageEncryptor> encryptor =
+        MessageEncryptorOpenssl::createForChaCha20Poly1305(ticket_key, iv);
+    if (!encryptor)
+        return ByteArray();
+
+    ByteArray plaintext = serialize(ticket);
+
+    ByteArray result(kIvSize + encryptor->encryptedDataSize(plaintext.size()));
+    memcpy(result.data(), iv.data(), kIvSize);
+
+    if (!encryptor->encrypt(plaintext.data(), plaintext.size(), result.data() + kIvSize))
+        return ByteArray();
+
+    return result;
+}
+
+// Opens a ticket sealed by sealTicket(). Returns false if the ticket was sealed with a
+// different key or was tampered with.
+bool openTicket(const ByteArray& ticket_key, const ByteArray& sealed, proto::SessionTicket* ticket)
+{
+    if (sealed.size() <= kIvSize)
+        return false;
+
+    std::unique_ptr<MessageDecryptor> decryptor = MessageDecryptorOpenssl::createForChaCha20Poly1305(
+        ticket_key, fromData(sealed.data(), kIvSize));
+    if (!decryptor)
+        return false;
+
+    const size_t in_size = sealed.size() - kIvSize;
+
+    size_t plaintext_size = decryptor->decryptedDataSize(in_size);
+    if (!plaintext_size || plaintext_size > in_size)
+        return false;
+
+    ByteArray plaintext(plaintext_size);
+    if (!decryptor->decrypt(sealed.data() + kIvSize, in_size, plaintext.data()))
+        return false;
+
+    return parse(plaintext, ticket);
+}
+
 } // namespace
 
 ServerAuthenticator::ServerAuthenticator(std::shared_ptr<TaskRunner> task_runner)
-    : Authenticator(std::move(task_runner))
+    : Authenticator(task_runner),
+      task_runner_(std::move(task_runner)),
+      offload_guard_(std::make_shared<int>(0))
 {
     // Nothing
 }
@@ -53,6 +110,18 @@ void ServerAuthenticator::setUserList(std::shared_ptr<UserListBase> user_list)
     DCHECK(user_list_);
 }
 
+void ServerAuthenticator::setCryptoTaskRunner(std::shared_ptr<TaskRunner> crypto_task_runner)
+{
+    DCHECK(state() == State::STOPPED);
+    crypto_task_runner_ = std::move(crypto_task_runner);
+}
+
+void ServerAuthenticator::setTicketKey(const ByteArray& ticket_key)
+{
+    DCHECK(state() == State::STOPPED);
+    ticket_key_ = ticket_key;
+}
+
 bool ServerAuthenticator::setPrivateKey(const ByteArray& private_key)
 {
     // The method must be called before calling start().
@@ -195,6 +264,14 @@ void ServerAuthenticator::onWritten()
                     return;
             }
 
+            if (session_resumed_)
+            {
+                // The SRP exchange is skipped; go straight to the session challenge.
+                internal_state_ = InternalState::SEND_SESSION_CHALLENGE;
+                doSessionChallenge();
+                break;
+            }
+
             switch (identify_)
             {
                 case proto::IDENTIFY_SRP:
@@ -287,12 +364,14 @@ void ServerAuthenticator::onClientHello(const ByteArray& buffer)
 
     proto::ServerHello server_hello;
 
-    if (key_pair_.isValid())
+    if (!resumeSession(client_hello, &server_hello) && key_pair_.isValid())
     {
         ByteArray peer_public_key = fromStdString(client_hello.public_key());
         decrypt_iv_ = fromStdString(client_hello.iv());
 
-        if (peer_public_key.empty() != decrypt_iv_.empty())
+        // An IV without a public key is allowed: the client sends one along with a resumption
+        // ticket, and if the ticket was rejected the IV is simply unused.
+        if (!peer_public_key.empty() && decrypt_iv_.empty())
         {
             finish(FROM_HERE, ErrorCode::PROTOCOL_ERROR);
             return;
@@ -339,6 +418,11 @@ void ServerAuthenticator::onClientHello(const ByteArray& buffer)
         server_hello.set_encryption(proto::ENCRYPTION_CHACHA20_POLY1305);
     }
 
+    // Confirm dropping transport encryption after the handshake only when the client offered
+    // it and the connection is on loopback from this side as well.
+    plaintext_on_loopback_ = client_hello.plaintext_on_loopback() && isLoopbackChannel();
+    server_hello.set_plaintext_on_loopback(plaintext_on_loopback_);
+
     // Now we are in the authentication phase.
     internal_state_ = InternalState::SEND_SERVER_HELLO;
     encryption_ = server_hello.encryption();
@@ -347,6 +431,54 @@ void ServerAuthenticator::onClientHello(const ByteArray& buffer)
     sendMessage(server_hello);
 }
 
+bool ServerAuthenticator::resumeSession(const proto::ClientHello& client_hello,
+                                        proto::ServerHello* server_hello)
+{
+    if (ticket_key_.empty() || client_hello.ticket().empty())
+        return false;
+
+    proto::SessionTicket ticket;
+    if (!openTicket(ticket_key_, fromStdString(client_hello.ticket()), &ticket))
+    {
+        LOG(LS_INFO) << "Invalid resumption ticket. Falling back to full handshake";
+        return false;
+    }
+
+    uint64_t now = static_cast<uint64_t>(std::time(nullptr));
+    if (ticket.timestamp() > now || now - ticket.timestamp() > kTicketLifetimeSeconds)
+    {
+        LOG(LS_INFO) << "Expired resumption ticket. Falling back to full handshake";
+        return false;
+    }
+
+    decrypt_iv_ = fromStdString(client_hello.iv());
+    if (decrypt_iv_.empty())
+        return false;
+
+    encrypt_iv_ = Random::byteArray(kIvSize);
+
+    // The session key is derived from the resumption secret and the fresh IVs of both sides,
+    // so it differs from connection to connection even though the secret is reused. The client
+    // does the same derivation; a mismatch shows up as a failure to decrypt the session
+    // challenge.
+    GenericHash hash(GenericHash::BLAKE2s256);
+    hash.addData(ticket.secret());
+    hash.addData(decrypt_iv_);
+    hash.addData(encrypt_iv_);
+    session_key_ = hash.result();
+
+    session_types_ = ticket.session_types();
+    user_name_ = ticket.username();
+
+    server_hello->set_iv(toStdString(encrypt_iv_));
+    server_hello->set_session_resumed(true);
+
+    LOG(LS_INFO) << "Session resumed for user '" << user_name_ << "'";
+
+    session_resumed_ = true;
+    return true;
+}
+
 void ServerAuthenticator::onIdentify(const ByteArray& buffer)
 {
     LOG(LS_INFO) << "Received: Identify";
@@ -429,7 +561,44 @@ void ServerAuthenticator::onIdentify(const ByteArray& buffer)
     while (false);
 
     b_ = BigNum::fromByteArray(Random::byteArray(128)); // 1024 bits.
+
+    // Leave READ_IDENTIFY before the computation: a message arriving while it runs is then
+    // ignored instead of re-entering this method.
+    internal_state_ = InternalState::SEND_SERVER_KEY_EXCHANGE;
+
+    if (crypto_task_runner_)
+    {
+        // calc_B is a modular exponentiation in an up to 8192-bit group. The task owns copies
+        // of its inputs, so it stays valid even if the authenticator is destroyed while it
+        // runs; the continuation is dropped through |offload_guard_| in that case.
+        crypto_task_runner_->postTask(
+            [this, task_runner = task_runner_, guard = std::weak_ptr<int>(offload_guard_),
+             b = b_.toByteArray(), N = N_.toByteArray(), g = g_.toByteArray(),
+             v = v_.toByteArray()]()
+        {
+            BigNum B = SrpMath::calc_B(BigNum::fromByteArray(b), BigNum::fromByteArray(N),
+                                       BigNum::fromByteArray(g), BigNum::fromByteArray(v));
+
+            task_runner->postTask([this, guard, B = B.toByteArray()]()
+            {
+                if (guard.expired())
+                    return;
+
+                B_ = BigNum::fromByteArray(B);
+                onServerKeyExchangeReady();
+            });
+        });
+        return;
+    }
+
     B_ = SrpMath::calc_B(b_, N_, g_, v_);
+    onServerKeyExchangeReady();
+}
+
+void ServerAuthenticator::onServerKeyExchangeReady()
+{
+    if (state() != State::PENDING)
+        return;
 
     if (!N_.isValid() || !g_.isValid() || !s_.isValid() || !B_.isValid())
     {
@@ -437,7 +606,6 @@ void ServerAuthenticator::onIdentify(const ByteArray& buffer)
         return;
     }
 
-    internal_state_ = InternalState::SEND_SERVER_KEY_EXCHANGE;
     encrypt_iv_ = Random::byteArray(kIvSize);
 
     proto::SrpServerKeyExchange server_key_exchange;
@@ -472,7 +640,40 @@ void ServerAuthenticator::onClientKeyExchange(const ByteArray& buffer)
         return;
     }
 
-    ByteArray srp_key = createSrpKey();
+    internal_state_ = InternalState::SEND_SESSION_CHALLENGE;
+
+    if (crypto_task_runner_)
+    {
+        // Same offload scheme as in onIdentify(); calcServerKey is the other modular
+        // exponentiation of the handshake.
+        crypto_task_runner_->postTask(
+            [this, task_runner = task_runner_, guard = std::weak_ptr<int>(offload_guard_),
+             A = A_.toByteArray(), B = B_.toByteArray(), N = N_.toByteArray(),
+             v = v_.toByteArray(), b = b_.toByteArray()]()
+        {
+            ByteArray srp_key = createSrpKey(
+                BigNum::fromByteArray(A), BigNum::fromByteArray(B), BigNum::fromByteArray(N),
+                BigNum::fromByteArray(v), BigNum::fromByteArray(b));
+
+            task_runner->postTask([this, guard, srp_key = std::move(srp_key)]()
+            {
+                if (guard.expired())
+                    return;
+
+                onSrpKeyReady(srp_key);
+            });
+        });
+        return;
+    }
+
+    onSrpKeyReady(createSrpKey(A_, B_, N_, v_, b_));
+}
+
+void ServerAuthenticator::onSrpKeyReady(const ByteArray& srp_key)
+{
+    if (state() != State::PENDING)
+        return;
+
     if (srp_key.empty())
     {
         finish(FROM_HERE, ErrorCode::UNKNOWN_ERROR);
@@ -505,7 +706,6 @@ void ServerAuthenticator::onClientKeyExchange(const ByteArray& buffer)
     if (!onSessionKeyChanged())
         return;
 
-    internal_state_ = InternalState::SEND_SESSION_CHALLENGE;
     doSessionChallenge();
 }
 
@@ -514,6 +714,23 @@ void ServerAuthenticator::doSessionChallenge()
     proto::SessionChallenge session_challenge;
     session_challenge.set_session_types(session_types_);
 
+    if (!ticket_key_.empty() && !session_key_.empty())
+    {
+        proto::SessionTicket ticket;
+
+        // The secret is a hash of the session key, so a ticket does not reveal the traffic key
+        // of the connection it was issued on.
+        ticket.set_secret(toStdString(
+            GenericHash::hash(GenericHash::Type::BLAKE2s256, session_key_)));
+        ticket.set_session_types(session_types_);
+        ticket.set_username(user_name_);
+        ticket.set_timestamp(static_cast<uint64_t>(std::time(nullptr)));
+
+        ByteArray sealed_ticket = sealTicket(ticket_key_, ticket);
+        if (!sealed_ticket.empty())
+            session_challenge.set_ticket(toStdString(sealed_ticket));
+    }
+
     proto::Version* version = session_challenge.mutable_version();
     version->set_major(ASPIA_VERSION_MAJOR);
     version->set_minor(ASPIA_VERSION_MINOR);
@@ -566,16 +783,18 @@ void ServerAuthenticator::onSessionResponse(const ByteArray& buffer)
     finish(FROM_HERE, ErrorCode::SUCCESS);
 }
 
-ByteArray ServerAuthenticator::createSrpKey()
+// static
+ByteArray ServerAuthenticator::createSrpKey(
+    const BigNum& A, const BigNum& B, const BigNum& N, const BigNum& v, const BigNum& b)
 {
-    if (!SrpMath::verify_A_mod_N(A_, N_))
+    if (!SrpMath::verify_A_mod_N(A, N))
     {
         LOG(LS_ERROR) << "SrpMath::verify_A_mod_N failed";
         return ByteArray();
     }
 
-    BigNum u = SrpMath::calc_u(A_, B_, N_);
-    BigNum server_key = SrpMath::calcServerKey(A_, v_, u, b_, N_);
+    BigNum u = SrpMath::calc_u(A, B, N);
+    BigNum server_key = SrpMath::calcServerKey(A, v, u, b, N);
 
     return server_key.toByteArray();
 }
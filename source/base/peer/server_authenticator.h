@@ -43,6 +43,19 @@ public:
     // Sets the user list.
     void setUserList(std::shared_ptr<UserListBase> user_list);
 
+    // Sets the task runner on which SRP big-number computations run. When set, the modular
+    // exponentiations of the handshake are posted there and the session's own thread only
+    // resumes with the result, so a handshake does not stall other sessions sharing the
+    // message loop. Without it everything is computed inline. Must be called before start().
+    void setCryptoTaskRunner(std::shared_ptr<TaskRunner> crypto_task_runner);
+
+    // Sets the key used to seal session-resumption tickets. When set, a ticket is issued with
+    // the session challenge and a client presenting a valid ticket skips the SRP exchange on
+    // reconnect. The key must be shared by all authenticators of the server; tickets sealed
+    // with another key (or issued before a server restart) are ignored and the client falls
+    // back to the full handshake. Must be called before start().
+    void setTicketKey(const ByteArray& ticket_key);
+
     // Sets the private key.
     [[nodiscard]] bool setPrivateKey(const ByteArray& private_key);
 
@@ -60,11 +73,24 @@ protected:
 
 private:
     void onClientHello(const ByteArray& buffer);
+    [[nodiscard]] bool resumeSession(const proto::ClientHello& client_hello,
+                                     proto::ServerHello* server_hello);
     void onIdentify(const ByteArray& buffer);
+    void onServerKeyExchangeReady();
     void onClientKeyExchange(const ByteArray& buffer);
+    void onSrpKeyReady(const ByteArray& srp_key);
     void doSessionChallenge();
     void onSessionResponse(const ByteArray& buffer);
-    [[nodiscard]] ByteArray createSrpKey();
+
+    [[nodiscard]] static ByteArray createSrpKey(
+        const BigNum& A, const BigNum& B, const BigNum& N, const BigNum& v, const BigNum& b);
+
+    std::shared_ptr<TaskRunner> task_runner_;
+    std::shared_ptr<TaskRunner> crypto_task_runner_;
+
+    // Continuations posted from the crypto task runner capture a weak_ptr to this token and
+    // bail out if it expired, so they never touch a destroyed authenticator.
+    std::shared_ptr<int> offload_guard_;
 
     std::shared_ptr<UserListBase> user_list_;
 
@@ -82,6 +108,9 @@ private:
     AnonymousAccess anonymous_access_ = AnonymousAccess::DISABLE;
     InternalState internal_state_ = InternalState::READ_CLIENT_HELLO;
 
+    ByteArray ticket_key_;
+    bool session_resumed_ = false;
+
     // Bitmask of allowed session types.
     uint32_t session_types_ = 0;
 
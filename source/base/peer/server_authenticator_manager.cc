@@ -20,19 +20,42 @@
 
 #include "base/logging.h"
 #include "base/task_runner.h"
+#include "base/crypto/random.h"
 #include "base/peer/user_list_base.h"
+#include "base/threading/thread.h"
 
 namespace base {
 
+namespace {
+
+// Number of worker threads for SRP big-number computations.
+const size_t kCryptoThreadCount = 2;
+
+// Size of the key used to seal session-resumption tickets.
+const size_t kTicketKeySize = 32;
+
+} // namespace
+
 ServerAuthenticatorManager::ServerAuthenticatorManager(
     std::shared_ptr<TaskRunner> task_runner, Delegate* delegate)
     : task_runner_(std::move(task_runner)),
+      ticket_key_(Random::byteArray(kTicketKeySize)),
       delegate_(delegate)
 {
     DCHECK(task_runner_ && delegate_);
+
+    for (size_t i = 0; i < kCryptoThreadCount; ++i)
+    {
+        crypto_threads_.emplace_back(std::make_unique<Thread>());
+        crypto_threads_.back()->start(MessageLoop::Type::DEFAULT);
+    }
 }
 
-ServerAuthenticatorManager::~ServerAuthenticatorManager() = default;
+ServerAuthenticatorManager::~ServerAuthenticatorManager()
+{
+    for (const auto& crypto_thread : crypto_threads_)
+        crypto_thread->stop();
+}
 
 void ServerAuthenticatorManager::setUserList(std::unique_ptr<UserListBase> user_list)
 {
@@ -60,6 +83,12 @@ void ServerAuthenticatorManager::addNewChannel(std::unique_ptr<NetworkChannel> c
         std::make_unique<ServerAuthenticator>(task_runner_);
     authenticator->setUserList(user_list_);
 
+    // Distribute big-number computations between the worker threads.
+    authenticator->setCryptoTaskRunner(crypto_threads_[next_crypto_thread_]->taskRunner());
+    next_crypto_thread_ = (next_crypto_thread_ + 1) % crypto_threads_.size();
+
+    authenticator->setTicketKey(ticket_key_);
+
     if (!private_key_.empty())
     {
         if (!authenticator->setPrivateKey(private_key_))
@@ -23,6 +23,8 @@
 
 namespace base {
 
+class Thread;
+
 class ServerAuthenticatorManager
 {
 public:
@@ -75,6 +77,15 @@ private:
     std::shared_ptr<UserListBase> user_list_;
     std::vector<std::unique_ptr<ServerAuthenticator>> pending_;
 
+    // Worker threads for SRP big-number computations. Authenticators are assigned to the
+    // threads round-robin, so handshake CPU does not block the I/O thread.
+    std::vector<std::unique_ptr<Thread>> crypto_threads_;
+    size_t next_crypto_thread_ = 0;
+
+    // Key for sealing session-resumption tickets. Generated anew on every start, so tickets
+    // do not survive a server restart; clients then fall back to the full handshake.
+    ByteArray ticket_key_;
+
     ByteArray private_key_;
 
     ServerAuthenticator::AnonymousAccess anonymous_access_ =
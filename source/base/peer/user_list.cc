@@ -25,10 +25,10 @@ namespace base {
 UserList::UserList() = default;
 
 UserList::UserList(const std::vector<User>& list, const ByteArray& seed_key)
-    : list_(list),
-      seed_key_(seed_key)
+    : seed_key_(seed_key)
 {
-    // Nothing
+    for (const auto& user : list)
+        add(user);
 }
 
 UserList::~UserList() = default;
@@ -46,8 +46,11 @@ std::unique_ptr<UserList> UserList::duplicate() const
 
 void UserList::add(const User& user)
 {
-    if (user.isValid())
-        list_.emplace_back(user);
+    if (!user.isValid())
+        return;
+
+    list_.emplace_back(user);
+    index_by_name_[caseFold(user.name)] = list_.size() - 1;
 }
 
 void UserList::merge(const UserList& user_list)
@@ -58,15 +61,11 @@ void UserList::merge(const UserList& user_list)
 
 User UserList::find(std::u16string_view username) const
 {
-    const User* user = &User::kInvalidUser;
-
-    for (const auto& item : list_)
-    {
-        if (compareCaseInsensitive(username, item.name) == 0)
-            user = &item;
-    }
+    auto result = index_by_name_.find(caseFold(username));
+    if (result == index_by_name_.end())
+        return User::kInvalidUser;
 
-    return *user;
+    return list_[result->second];
 }
 
 void UserList::setSeedKey(const ByteArray& seed_key)
@@ -22,6 +22,8 @@
 #include "base/macros_magic.h"
 #include "base/peer/user_list_base.h"
 
+#include <unordered_map>
+
 namespace base {
 
 class UserList : public UserListBase
@@ -47,6 +49,10 @@ private:
     ByteArray seed_key_;
     std::vector<User> list_;
 
+    // Case-folded name to index in |list_|. Keeps find() constant time; with duplicate names
+    // the entry added last wins, just like the linear scan did.
+    std::unordered_map<std::u16string, size_t> index_by_name_;
+
     DISALLOW_COPY_AND_ASSIGN(UserList);
 };
 
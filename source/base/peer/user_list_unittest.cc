@@ -0,0 +1,74 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/peer/user_list.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+TEST(user_list_test, empty_list)
+{
+    std::unique_ptr<UserList> user_list = UserList::createEmpty();
+
+    EXPECT_FALSE(user_list->find(u"admin").isValid());
+    EXPECT_TRUE(user_list->list().empty());
+}
+
+TEST(user_list_test, find_is_case_insensitive)
+{
+    std::unique_ptr<UserList> user_list = UserList::createEmpty();
+    user_list->add(User::create(u"Admin", u"password"));
+
+    EXPECT_TRUE(user_list->find(u"Admin").isValid());
+    EXPECT_TRUE(user_list->find(u"admin").isValid());
+    EXPECT_TRUE(user_list->find(u"ADMIN").isValid());
+    EXPECT_FALSE(user_list->find(u"administrator").isValid());
+
+    EXPECT_EQ(user_list->find(u"admin").name, u"Admin");
+}
+
+TEST(user_list_test, duplicate_name_last_added_wins)
+{
+    User first = User::create(u"user", u"password");
+    first.entry_id = 1;
+
+    User second = User::create(u"USER", u"password");
+    second.entry_id = 2;
+
+    std::unique_ptr<UserList> user_list = UserList::createEmpty();
+    user_list->add(first);
+    user_list->add(second);
+
+    // Both entries stay in the list, but lookups return the entry added last.
+    EXPECT_EQ(user_list->list().size(), 2u);
+    EXPECT_EQ(user_list->find(u"user").entry_id, 2);
+}
+
+TEST(user_list_test, duplicate_keeps_lookup)
+{
+    std::unique_ptr<UserList> user_list = UserList::createEmpty();
+    user_list->add(User::create(u"Admin", u"password"));
+
+    std::unique_ptr<UserList> copy = user_list->duplicate();
+
+    EXPECT_TRUE(copy->find(u"admin").isValid());
+    EXPECT_EQ(copy->list().size(), user_list->list().size());
+}
+
+} // namespace base
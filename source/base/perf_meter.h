@@ -0,0 +1,67 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__PERF_METER_H
+#define BASE__PERF_METER_H
+
+#include <chrono>
+#include <cstdint>
+
+namespace base {
+
+// Lightweight accumulator for timings of a repeated operation. Adding a sample is a couple of
+// additions and a compare, cheap enough for per-frame pipeline stages. Not thread-safe; each
+// meter belongs to the thread that feeds it.
+class PerfMeter
+{
+public:
+    void addSample(uint64_t value)
+    {
+        total_ += value;
+        if (value > max_)
+            max_ = value;
+        ++count_;
+    }
+
+    uint64_t count() const { return count_; }
+    uint64_t average() const { return count_ ? total_ / count_ : 0; }
+    uint64_t max() const { return max_; }
+
+    void reset()
+    {
+        total_ = 0;
+        max_ = 0;
+        count_ = 0;
+    }
+
+    // Monotonic timestamp in microseconds for measuring intervals between two calls.
+    static uint64_t nowUs()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+private:
+    uint64_t total_ = 0;
+    uint64_t max_ = 0;
+    uint64_t count_ = 0;
+};
+
+} // namespace base
+
+#endif // BASE__PERF_METER_H
@@ -29,6 +29,8 @@
 #include <rapidjson/prettywriter.h>
 
 #include <fstream>
+#include <map>
+#include <mutex>
 
 namespace base {
 
@@ -90,6 +92,64 @@ void parseObject(const T& object, std::vector<std::string_view>* segments, Setti
     }
 }
 
+// Process-wide cache of parsed settings files. Snapshots are immutable and shared between
+// readers; a file is re-parsed only when its size or modification time changes.
+class SnapshotCache
+{
+public:
+    static SnapshotCache* instance()
+    {
+        static SnapshotCache cache;
+        return &cache;
+    }
+
+    std::shared_ptr<const Settings::Map> acquire(const std::filesystem::path& file)
+    {
+        std::error_code ignored_code;
+        std::filesystem::file_time_type time =
+            std::filesystem::last_write_time(file, ignored_code);
+        uintmax_t size = std::filesystem::file_size(file, ignored_code);
+
+        std::scoped_lock lock(lock_);
+
+        Entry& entry = entries_[file];
+        if (entry.map && entry.time == time && entry.size == size)
+            return entry.map;
+
+        std::shared_ptr<Settings::Map> map = std::make_shared<Settings::Map>();
+        JsonSettings::readFile(file, *map);
+
+        entry.map = std::move(map);
+        entry.time = time;
+        entry.size = size;
+
+        return entry.map;
+    }
+
+    // Called after a write. Size and modification time alone could miss a same-sized rewrite
+    // on file systems with coarse timestamps.
+    void invalidate(const std::filesystem::path& file)
+    {
+        std::scoped_lock lock(lock_);
+        entries_.erase(file);
+    }
+
+private:
+    SnapshotCache() = default;
+
+    struct Entry
+    {
+        std::shared_ptr<const Settings::Map> map;
+        std::filesystem::file_time_type time;
+        uintmax_t size = 0;
+    };
+
+    std::mutex lock_;
+    std::map<std::filesystem::path, Entry> entries_;
+
+    DISALLOW_COPY_AND_ASSIGN(SnapshotCache);
+};
+
 } // namespace
 
 JsonSettings::JsonSettings(std::string_view file_name)
@@ -98,7 +158,7 @@ JsonSettings::JsonSettings(std::string_view file_name)
     if (path_.empty())
         return;
 
-    readFile(path_, map());
+    map() = *snapshot(path_);
 }
 
 JsonSettings::JsonSettings(Scope scope,
@@ -109,7 +169,7 @@ JsonSettings::JsonSettings(Scope scope,
     if (path_.empty())
         return;
 
-    readFile(path_, map());
+    map() = *snapshot(path_);
 }
 
 JsonSettings::~JsonSettings()
@@ -143,7 +203,7 @@ bool JsonSettings::isWritable() const
 
 void JsonSettings::sync()
 {
-    readFile(path_, map());
+    map() = *snapshot(path_);
 }
 
 void JsonSettings::flush()
@@ -301,7 +361,17 @@ bool JsonSettings::writeFile(const std::filesystem::path& file, const Map& map)
     // End JSON document.
     json.EndObject();
 
-    return json.IsComplete() && !stream.fail();
+    if (!json.IsComplete() || stream.fail())
+        return false;
+
+    SnapshotCache::instance()->invalidate(file);
+    return true;
+}
+
+// static
+std::shared_ptr<const Settings::Map> JsonSettings::snapshot(const std::filesystem::path& file)
+{
+    return SnapshotCache::instance()->acquire(file);
 }
 
 } // namespace base
@@ -23,6 +23,7 @@
 #include "base/settings/settings.h"
 
 #include <filesystem>
+#include <memory>
 
 namespace base {
 
@@ -48,6 +49,11 @@ public:
                                           std::string_view application_name,
                                           std::string_view file_name);
 
+    // Returns a shared immutable snapshot of the settings file. Snapshots are cached
+    // process-wide and re-parsed only when the file on disk has changed, so constructing an
+    // accessor over and over does not re-read or re-parse anything.
+    static std::shared_ptr<const Map> snapshot(const std::filesystem::path& file);
+
     static bool readFile(const std::filesystem::path& file, Map& map);
     static bool writeFile(const std::filesystem::path& file, const Map& map);
 
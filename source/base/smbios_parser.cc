@@ -17,6 +17,8 @@
 //
 
 #include "base/smbios_parser.h"
+
+#include "base/smbios_reader.h"
 #include "base/strings/string_util.h"
 
 #include <cstring>
@@ -109,6 +111,39 @@ std::string smbiosString(const SmbiosTable* table, uint8_t number)
     return result;
 }
 
+SmbiosTableIndex::SmbiosTableIndex(const std::string& smbios_dump)
+    : enumerator_(smbios_dump)
+{
+    // The enumerator is walked once here; the collected pointers point into its copy of the
+    // dump and stay valid as long as the index lives.
+    while (!enumerator_.isAtEnd())
+    {
+        const SmbiosTable* table = enumerator_.table();
+        tables_by_type_[table->type].push_back(table);
+        enumerator_.advance();
+    }
+}
+
+SmbiosTableIndex::~SmbiosTableIndex() = default;
+
+// static
+const SmbiosTableIndex& SmbiosTableIndex::local()
+{
+    // The SMBIOS tables never change while the system is running, so the dump is read and
+    // indexed only for the first query.
+    static const SmbiosTableIndex index(readSmbiosDump());
+    return index;
+}
+
+const std::vector<const SmbiosTable*>& SmbiosTableIndex::tablesWithType(uint8_t type) const
+{
+    auto result = tables_by_type_.find(type);
+    if (result == tables_by_type_.end())
+        return empty_list_;
+
+    return result->second;
+}
+
 SmbiosBios::SmbiosBios(const SmbiosTable* table)
     : table_(static_cast<const SmbiosBiosTable*>(table))
 {
@@ -23,6 +23,7 @@
 #include "base/smbios.h"
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace base {
@@ -54,6 +55,33 @@ private:
 
 std::string smbiosString(const SmbiosTable* table, uint8_t number);
 
+// Index of the SMBIOS tables of this machine by structure type. The firmware tables are
+// immutable, so the dump is read and walked only once; repeated queries return pointers into
+// the cached dump and cost a single map lookup.
+class SmbiosTableIndex
+{
+public:
+    ~SmbiosTableIndex();
+
+    // Returns the shared index, built on the first call and kept for the lifetime of the
+    // process.
+    static const SmbiosTableIndex& local();
+
+    // Returns the tables of the given structure type in firmware order. The pointers stay
+    // valid for the lifetime of the process.
+    const std::vector<const SmbiosTable*>& tablesWithType(uint8_t type) const;
+
+private:
+    explicit SmbiosTableIndex(const std::string& smbios_dump);
+
+    // Owns the copy of the dump that the indexed tables point into.
+    SmbiosTableEnumerator enumerator_;
+    std::unordered_map<uint8_t, std::vector<const SmbiosTable*>> tables_by_type_;
+    const std::vector<const SmbiosTable*> empty_list_;
+
+    DISALLOW_COPY_AND_ASSIGN(SmbiosTableIndex);
+};
+
 class SmbiosBios
 {
 public:
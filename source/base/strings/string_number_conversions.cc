@@ -51,6 +51,20 @@ typename std::make_unsigned<T>::type unsignedAbs(T value)
         0 - static_cast<UnsignedT>(value) : static_cast<UnsignedT>(value);
 }
 
+// Pairs of decimal digits "00".."99" laid out back to back. Emitting two digits per step
+// halves the number of divisions of the integer-to-string conversion.
+const char kDecimalPairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
 template <typename STR, typename INT>
 struct IntToStringT
 {
@@ -65,20 +79,32 @@ struct IntToStringT
         using CHR = typename STR::value_type;
         CHR outbuf[kOutputBufSize];
 
-        // The ValueOrDie call below can never fail, because UnsignedAbs is valid
-        // for all valid inputs.
         typename std::make_unsigned<INT>::type res = unsignedAbs(value);
 
         CHR* end = outbuf + kOutputBufSize;
         CHR* i = end;
-        do
+
+        while (res >= 100)
         {
-            --i;
-            DCHECK(i != outbuf);
-            *i = static_cast<CHR>((res % 10) + '0');
-            res /= 10;
+            const size_t pair = static_cast<size_t>(res % 100) * 2;
+            res /= 100;
+
+            DCHECK(i - 2 >= outbuf);
+            *--i = static_cast<CHR>(kDecimalPairs[pair + 1]);
+            *--i = static_cast<CHR>(kDecimalPairs[pair]);
+        }
+
+        if (res >= 10)
+        {
+            const size_t pair = static_cast<size_t>(res) * 2;
+            *--i = static_cast<CHR>(kDecimalPairs[pair + 1]);
+            *--i = static_cast<CHR>(kDecimalPairs[pair]);
+        }
+        else
+        {
+            *--i = static_cast<CHR>('0' + res);
         }
-        while (res != 0);
+
         if (isValueNegative(value))
         {
             --i;
@@ -0,0 +1,97 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/strings/string_number_conversions.h"
+
+#include <benchmark/benchmark.h>
+
+#include <iterator>
+
+namespace base {
+
+namespace {
+
+// Values with the digit counts the conversions see in practice: router session and host IDs,
+// ports, byte counters.
+const uint64_t kValues[] =
+{
+    7, 42, 514, 8060, 65535, 1048576, 88115375, 2814749767, 73786976294838ULL,
+    9007199254740993ULL, 18446744073709551615ULL
+};
+
+void BM_NumberToString(benchmark::State& state)
+{
+    size_t index = 0;
+
+    for (auto _ : state)
+    {
+        std::string result = numberToString(kValues[index]);
+        benchmark::DoNotOptimize(result);
+
+        if (++index == std::size(kValues))
+            index = 0;
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_NumberToString16(benchmark::State& state)
+{
+    size_t index = 0;
+
+    for (auto _ : state)
+    {
+        std::u16string result = numberToString16(kValues[index]);
+        benchmark::DoNotOptimize(result);
+
+        if (++index == std::size(kValues))
+            index = 0;
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_StringToUint64(benchmark::State& state)
+{
+    std::string strings[std::size(kValues)];
+    for (size_t i = 0; i < std::size(kValues); ++i)
+        strings[i] = numberToString(kValues[i]);
+
+    size_t index = 0;
+
+    for (auto _ : state)
+    {
+        uint64_t value;
+        bool ok = stringToUint64(strings[index], &value);
+        benchmark::DoNotOptimize(ok);
+        benchmark::DoNotOptimize(value);
+
+        if (++index == std::size(kValues))
+            index = 0;
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_NumberToString);
+BENCHMARK(BM_NumberToString16);
+BENCHMARK(BM_StringToUint64);
+
+} // namespace
+
+} // namespace base
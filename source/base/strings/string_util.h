@@ -156,6 +156,11 @@ std::string toLowerASCII(std::string_view in);
 std::u16string toUpper(std::u16string_view in);
 std::u16string toLower(std::u16string_view in);
 
+// Default Unicode case folding, consistent with compareCaseInsensitive(): two strings compare
+// equal there if and only if their folded forms are identical. Suitable as a key for
+// case-insensitive lookup tables.
+std::u16string caseFold(std::u16string_view in);
+
 const std::string& emptyString();
 const std::wstring& emptyStringW();
 
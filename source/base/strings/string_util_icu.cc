@@ -82,4 +82,28 @@ std::u16string toLower(std::u16string_view in)
     return out;
 }
 
+std::u16string caseFold(std::u16string_view in)
+{
+    if (in.empty())
+        return std::u16string();
+
+    UErrorCode error_code = U_ZERO_ERROR;
+    int32_t len = u_strFoldCase(nullptr, 0, in.data(), in.length(),
+                                U_FOLD_CASE_DEFAULT, &error_code);
+    if (error_code != U_BUFFER_OVERFLOW_ERROR || len <= 0)
+        return std::u16string();
+
+    error_code = U_ZERO_ERROR;
+
+    std::u16string out;
+    out.resize(len);
+
+    len = u_strFoldCase(out.data(), out.length(), in.data(), in.length(),
+                        U_FOLD_CASE_DEFAULT, &error_code);
+    if (!U_SUCCESS(error_code) || len <= 0)
+        return std::u16string();
+
+    return out;
+}
+
 } // namespace base
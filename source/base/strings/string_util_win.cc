@@ -76,4 +76,14 @@ std::u16string toLower(std::u16string_view in)
     return out;
 }
 
+std::u16string caseFold(std::u16string_view in)
+{
+    // CompareStringW() with NORM_IGNORECASE applies the simple case mappings of the locale, so
+    // lowercasing under the same invariant locale folds exactly the pairs the comparison
+    // treats as equal. Full Unicode folding (as ICU does on the other platforms) would merge
+    // pairs the comparison distinguishes, and the folded-key index would disagree with
+    // compareCaseInsensitive().
+    return toLower(in);
+}
+
 } // namespace base
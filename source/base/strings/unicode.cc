@@ -29,10 +29,86 @@
 #include <unicode/ustring.h>
 #endif // OS_POSIX || OS_MAC
 
+#include <cstdint>
+#include <cstring>
+
 namespace base {
 
 namespace {
 
+// Returns true when every byte is in the ASCII range. Checks eight bytes per iteration; the
+// strings converted on the hot paths (addresses, user names, file names) are almost always
+// plain ASCII.
+bool isAscii(std::string_view in)
+{
+    const char* data = in.data();
+    size_t length = in.size();
+
+    uint64_t chunk;
+    while (length >= sizeof(chunk))
+    {
+        memcpy(&chunk, data, sizeof(chunk));
+        if (chunk & UINT64_C(0x8080808080808080))
+            return false;
+
+        data += sizeof(chunk);
+        length -= sizeof(chunk);
+    }
+
+    uint8_t accumulator = 0;
+    while (length--)
+        accumulator |= static_cast<uint8_t>(*data++);
+
+    return (accumulator & 0x80) == 0;
+}
+
+// The same for 16-bit code units.
+template <class InputType>
+bool isAscii16(InputType in)
+{
+    static_assert(sizeof(typename InputType::value_type) == 2);
+
+    const typename InputType::value_type* data = in.data();
+    size_t length = in.size();
+
+    uint64_t chunk;
+    while (length >= sizeof(chunk) / 2)
+    {
+        memcpy(&chunk, data, sizeof(chunk));
+        if (chunk & UINT64_C(0xFF80FF80FF80FF80))
+            return false;
+
+        data += sizeof(chunk) / 2;
+        length -= sizeof(chunk) / 2;
+    }
+
+    uint16_t accumulator = 0;
+    while (length--)
+        accumulator |= static_cast<uint16_t>(*data++);
+
+    return (accumulator & 0xFF80) == 0;
+}
+
+// ASCII converts 1:1 between the encodings, so the system converter and its length pre-pass
+// are not needed.
+template <class InputType>
+void narrowFromAscii(InputType in, std::string* out)
+{
+    out->resize(in.size());
+
+    for (size_t i = 0; i < in.size(); ++i)
+        (*out)[i] = static_cast<char>(in[i]);
+}
+
+template <class OutputType>
+void widenFromAscii(std::string_view in, OutputType* out)
+{
+    out->resize(in.size());
+
+    for (size_t i = 0; i < in.size(); ++i)
+        (*out)[i] = static_cast<typename OutputType::value_type>(static_cast<uint8_t>(in[i]));
+}
+
 #if defined(OS_WIN)
 
 template <class InputType>
@@ -44,6 +120,13 @@ bool wideToLocalImpl(InputType in, std::string* out)
     if (!in_len)
         return true;
 
+    // ASCII is mapped identically by every ANSI code page.
+    if (isAscii16(in))
+    {
+        narrowFromAscii(in, out);
+        return true;
+    }
+
     const int out_len = WideCharToMultiByte(CP_ACP, 0,
                                             reinterpret_cast<const wchar_t*>(in.data()),
                                             static_cast<int>(in_len),
@@ -73,6 +156,12 @@ bool localToWideImpl(std::string_view in, OutputType* out)
     if (!in_len)
         return true;
 
+    if (isAscii(in))
+    {
+        widenFromAscii(in, out);
+        return true;
+    }
+
     const int out_len =
         MultiByteToWideChar(CP_ACP, 0, in.data(), static_cast<int>(in_len), nullptr, 0);
     if (out_len <= 0)
@@ -98,6 +187,12 @@ bool wideToUtf8Impl(InputType in, std::string* out)
     if (!in_len)
         return true;
 
+    if (isAscii16(in))
+    {
+        narrowFromAscii(in, out);
+        return true;
+    }
+
     const int out_len = WideCharToMultiByte(CP_UTF8, 0,
                                             reinterpret_cast<const wchar_t*>(in.data()),
                                             static_cast<int>(in_len),
@@ -127,6 +222,12 @@ bool utf8ToWideImpl(std::string_view in, OutputType* out)
     if (!in_len)
         return true;
 
+    if (isAscii(in))
+    {
+        widenFromAscii(in, out);
+        return true;
+    }
+
     const int out_len =
         MultiByteToWideChar(CP_UTF8, 0, in.data(), static_cast<int>(in_len), nullptr, 0);
     if (out_len <= 0)
@@ -152,6 +253,12 @@ bool utf16ToUtf8Impl(std::u16string_view in, std::string* out)
     if (!in.length())
         return true;
 
+    if (isAscii16(in))
+    {
+        narrowFromAscii(in, out);
+        return true;
+    }
+
     UErrorCode error_code = U_ZERO_ERROR;
     int32_t out_len = 0;
     u_strToUTF8(nullptr, 0, &out_len, in.data(), in.length(), &error_code);
@@ -175,6 +282,12 @@ bool utf8ToUtf16Impl(std::string_view in, std::u16string* out)
     if (!in.length())
         return true;
 
+    if (isAscii(in))
+    {
+        widenFromAscii(in, out);
+        return true;
+    }
+
     UErrorCode error_code = U_ZERO_ERROR;
     int32_t out_len = 0;
     u_strFromUTF8(nullptr, 0, &out_len, in.data(), in.length(), &error_code);
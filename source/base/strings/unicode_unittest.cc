@@ -0,0 +1,104 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/strings/unicode.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+TEST(UnicodeTest, Empty)
+{
+    EXPECT_EQ(utf8FromUtf16(std::u16string_view()), std::string());
+    EXPECT_EQ(utf16FromUtf8(std::string_view()), std::u16string());
+}
+
+TEST(UnicodeTest, Ascii)
+{
+    // Lengths around the eight-byte scanning chunk.
+    for (size_t length = 1; length <= 24; ++length)
+    {
+        std::string utf8(length, '\0');
+        std::u16string utf16(length, u'\0');
+
+        for (size_t i = 0; i < length; ++i)
+        {
+            char ch = static_cast<char>('a' + i % 26);
+
+            utf8[i] = ch;
+            utf16[i] = static_cast<char16_t>(ch);
+        }
+
+        EXPECT_EQ(utf16FromUtf8(utf8), utf16);
+        EXPECT_EQ(utf8FromUtf16(utf16), utf8);
+    }
+}
+
+TEST(UnicodeTest, NonAsciiAtEveryPosition)
+{
+    // A single non-ASCII character must disable the ASCII fast path no matter where in the
+    // string it is.
+    for (size_t pos = 0; pos < 20; ++pos)
+    {
+        std::u16string utf16(20, u'x');
+        utf16[pos] = u'é';
+
+        std::string utf8 = utf8FromUtf16(utf16);
+        EXPECT_EQ(utf8.size(), utf16.size() + 1);
+        EXPECT_EQ(utf16FromUtf8(utf8), utf16);
+    }
+}
+
+TEST(UnicodeTest, MultiByte)
+{
+    const std::string utf8 = "\xD0\xBF\xD1\x80\xD0\xB8\xD0\xB2\xD0\xB5\xD1\x82"; // привет
+    const std::u16string utf16 = u"привет";
+
+    EXPECT_EQ(utf16FromUtf8(utf8), utf16);
+    EXPECT_EQ(utf8FromUtf16(utf16), utf8);
+}
+
+TEST(UnicodeTest, SurrogatePair)
+{
+    const std::string utf8 = "\xF0\x9F\x98\x80"; // 😀
+    const std::u16string utf16 = u"\xd83d\xde00";
+
+    EXPECT_EQ(utf16FromUtf8(utf8), utf16);
+    EXPECT_EQ(utf8FromUtf16(utf16), utf8);
+}
+
+TEST(UnicodeTest, OutputReuse)
+{
+    std::string utf8;
+    std::u16string utf16;
+
+    ASSERT_TRUE(utf8ToUtf16("first", &utf16));
+    EXPECT_EQ(utf16, u"first");
+
+    // The previous content must not leak into the next conversion.
+    ASSERT_TRUE(utf8ToUtf16("2", &utf16));
+    EXPECT_EQ(utf16, u"2");
+
+    ASSERT_TRUE(utf16ToUtf8(u"first", &utf8));
+    EXPECT_EQ(utf8, "first");
+
+    ASSERT_TRUE(utf16ToUtf8(u"2", &utf8));
+    EXPECT_EQ(utf8, "2");
+}
+
+} // namespace base
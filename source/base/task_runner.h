@@ -33,8 +33,24 @@ public:
     using Callback = std::function<void()>;
     using Milliseconds = std::chrono::milliseconds;
 
+    // Scheduling class of a posted task. When tasks of several classes are queued,
+    // FRAME_CRITICAL tasks run before INTERACTIVE tasks, which run before BACKGROUND tasks;
+    // within one class the order stays FIFO. postTask(Callback) posts at INTERACTIVE.
+    enum class Priority
+    {
+        FRAME_CRITICAL, // Work on the frame path: encode completions, capture scheduling.
+        INTERACTIVE,    // Ordinary tasks; the default.
+        BACKGROUND      // Housekeeping that tolerates deferral: settings flushes, cleanup.
+    };
+
     virtual bool belongsToCurrentThread() const = 0;
     virtual void postTask(Callback task) = 0;
+
+    // Posts a task with an explicit scheduling class. |deadline| optionally bounds how long
+    // the task may be deferred by higher classes: once it expires, the task runs ahead of
+    // them. Zero means no deadline.
+    virtual void postTask(Callback task, Priority priority,
+                          const Milliseconds& deadline = Milliseconds::zero()) = 0;
     virtual void postDelayedTask(Callback callback, const Milliseconds& delay) = 0;
     virtual void postNonNestableTask(Callback callback) = 0;
     virtual void postNonNestableDelayedTask(Callback callback, const Milliseconds& delay) = 0;
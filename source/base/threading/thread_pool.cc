@@ -0,0 +1,317 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/threading/thread_pool.h"
+
+#include "base/logging.h"
+#include "base/sys_info.h"
+
+#include <algorithm>
+
+namespace base {
+
+namespace {
+
+// Set while a worker runs tasks, so that postTask can recognize posts coming from inside the
+// pool and keep them on the local queue.
+thread_local ThreadPool* current_pool = nullptr;
+thread_local size_t current_worker = 0;
+
+} // namespace
+
+ThreadPool::ThreadPool(int thread_count)
+{
+    if (thread_count <= 0)
+        thread_count = std::max(1, SysInfo::processorThreads());
+
+    queues_.reserve(static_cast<size_t>(thread_count));
+    for (int i = 0; i < thread_count; ++i)
+        queues_.emplace_back(std::make_unique<WorkerQueue>());
+
+    threads_.reserve(static_cast<size_t>(thread_count));
+    for (int i = 0; i < thread_count; ++i)
+        threads_.emplace_back(&ThreadPool::workerMain, this, static_cast<size_t>(i));
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::scoped_lock lock(wake_lock_);
+        stopping_ = true;
+    }
+
+    wake_event_.notify_all();
+
+    for (std::thread& thread : threads_)
+        thread.join();
+}
+
+// static
+ThreadPool* ThreadPool::instance()
+{
+    static ThreadPool pool;
+    return &pool;
+}
+
+void ThreadPool::postTask(Callback task)
+{
+    DCHECK(task);
+
+    size_t index;
+    if (current_pool == this)
+    {
+        // Posted from a worker of this pool: the local queue keeps related work on the same
+        // thread while it remains stealable by the others.
+        index = current_worker;
+    }
+    else
+    {
+        index = next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+    }
+
+    {
+        std::scoped_lock lock(queues_[index]->lock);
+        queues_[index]->tasks.emplace_back(std::move(task));
+    }
+
+    {
+        std::scoped_lock lock(wake_lock_);
+        ++pending_tasks_;
+    }
+
+    wake_event_.notify_one();
+}
+
+std::shared_ptr<ThreadPool::Sequence> ThreadPool::createSequence()
+{
+    return std::make_shared<Sequence>();
+}
+
+void ThreadPool::postSequencedTask(std::shared_ptr<Sequence> sequence, Callback task)
+{
+    DCHECK(sequence);
+    DCHECK(task);
+
+    bool schedule;
+
+    {
+        std::scoped_lock lock(sequence->lock_);
+
+        sequence->tasks_.emplace_back(std::move(task));
+
+        // Only one drain task per sequence is in flight at a time; that is what serializes
+        // the sequence.
+        schedule = !sequence->scheduled_;
+        sequence->scheduled_ = true;
+    }
+
+    if (schedule)
+    {
+        postTask([this, sequence = std::move(sequence)]() mutable
+        {
+            runSequence(std::move(sequence));
+        });
+    }
+}
+
+void ThreadPool::parallelFor(int first, int last, const std::function<void(int)>& body)
+{
+    const int count = last - first;
+    if (count <= 0)
+        return;
+
+    if (count == 1 || threadCount() == 1)
+    {
+        for (int i = first; i < last; ++i)
+            body(i);
+        return;
+    }
+
+    // Indices are handed out one at a time, so a worker stuck on an expensive iteration does
+    // not hold up the cheap ones.
+    std::atomic<int> next_index{ first };
+
+    auto work = [&next_index, last, &body]()
+    {
+        for (int i = next_index.fetch_add(1, std::memory_order_relaxed); i < last;
+             i = next_index.fetch_add(1, std::memory_order_relaxed))
+        {
+            body(i);
+        }
+    };
+
+    const int helper_count = std::min(count, threadCount()) - 1;
+
+    std::mutex done_lock;
+    std::condition_variable done_event;
+    int active_helpers = helper_count;
+
+    for (int i = 0; i < helper_count; ++i)
+    {
+        postTask([&]()
+        {
+            work();
+
+            // Notified under the lock: once the caller observes zero it returns and the
+            // captured locals go away, so nothing may be touched after the lock is released.
+            std::scoped_lock lock(done_lock);
+            --active_helpers;
+            done_event.notify_one();
+        });
+    }
+
+    // The calling thread takes part in the work instead of just blocking.
+    work();
+
+    if (current_pool == this)
+    {
+        // A worker must not sleep here: with every worker inside its own parallelFor the
+        // helper tasks would have no one left to run them. Keep executing pool tasks until
+        // the helpers are done.
+        while (true)
+        {
+            {
+                std::scoped_lock lock(done_lock);
+                if (active_helpers == 0)
+                    break;
+            }
+
+            Callback task = tryTakeTask(current_worker);
+            if (task)
+                task();
+            else
+                std::this_thread::yield();
+        }
+    }
+    else
+    {
+        std::unique_lock lock(done_lock);
+        done_event.wait(lock, [&]() { return active_helpers == 0; });
+    }
+}
+
+void ThreadPool::workerMain(size_t index)
+{
+    current_pool = this;
+    current_worker = index;
+
+    while (true)
+    {
+        Callback task = takeTask(index);
+        if (!task)
+            break;
+
+        task();
+    }
+
+    current_pool = nullptr;
+}
+
+ThreadPool::Callback ThreadPool::takeTask(size_t index)
+{
+    while (true)
+    {
+        Callback task = tryTakeTask(index);
+        if (task)
+            return task;
+
+        std::unique_lock lock(wake_lock_);
+
+        // Queued tasks are drained even when the pool is stopping; only an empty pool exits.
+        if (stopping_ && pending_tasks_ == 0)
+            return nullptr;
+
+        if (pending_tasks_ == 0)
+            wake_event_.wait(lock, [this]() { return pending_tasks_ > 0 || stopping_; });
+    }
+}
+
+ThreadPool::Callback ThreadPool::tryTakeTask(size_t index)
+{
+    // The own queue is served from the back: the most recently posted work is the most likely
+    // to still be hot in the cache.
+    {
+        WorkerQueue* queue = queues_[index].get();
+        std::scoped_lock lock(queue->lock);
+
+        if (!queue->tasks.empty())
+        {
+            Callback task = std::move(queue->tasks.back());
+            queue->tasks.pop_back();
+
+            std::scoped_lock wake(wake_lock_);
+            --pending_tasks_;
+            return task;
+        }
+    }
+
+    // Steal from the front of the other queues (the oldest task), so that the victim keeps
+    // the cache-hot end for itself.
+    for (size_t offset = 1; offset < queues_.size(); ++offset)
+    {
+        WorkerQueue* queue = queues_[(index + offset) % queues_.size()].get();
+        std::scoped_lock lock(queue->lock);
+
+        if (!queue->tasks.empty())
+        {
+            Callback task = std::move(queue->tasks.front());
+            queue->tasks.pop_front();
+
+            std::scoped_lock wake(wake_lock_);
+            --pending_tasks_;
+            return task;
+        }
+    }
+
+    return nullptr;
+}
+
+void ThreadPool::runSequence(std::shared_ptr<Sequence> sequence)
+{
+    Callback task;
+
+    {
+        std::scoped_lock lock(sequence->lock_);
+
+        DCHECK(!sequence->tasks_.empty());
+        task = std::move(sequence->tasks_.front());
+        sequence->tasks_.pop_front();
+    }
+
+    task();
+
+    bool more;
+
+    {
+        std::scoped_lock lock(sequence->lock_);
+
+        more = !sequence->tasks_.empty();
+        sequence->scheduled_ = more;
+    }
+
+    // One task per hop: a busy sequence does not monopolize a worker.
+    if (more)
+    {
+        postTask([this, sequence = std::move(sequence)]() mutable
+        {
+            runSequence(std::move(sequence));
+        });
+    }
+}
+
+} // namespace base
@@ -0,0 +1,113 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__THREADING__THREAD_POOL_H
+#define BASE__THREADING__THREAD_POOL_H
+
+#include "base/macros_magic.h"
+#include "base/task_runner.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace base {
+
+// A fixed pool of worker threads with one task queue per worker. A worker that runs out of
+// work steals from the queues of the other workers, so unevenly sized tasks still keep all
+// threads busy. Unlike Thread, the pool has no message loop: tasks are plain callbacks with no
+// delay or quit semantics.
+class ThreadPool
+{
+public:
+    using Callback = TaskRunner::Callback;
+
+    // Creates a pool with |thread_count| workers. If |thread_count| is zero, the pool is sized
+    // from the number of logical processors (SysInfo::processorThreads()).
+    explicit ThreadPool(int thread_count = 0);
+
+    // Waits for the tasks that are already queued to finish, then joins the workers.
+    ~ThreadPool();
+
+    // Shared process-wide pool sized from the number of logical processors. Subsystems that
+    // need parallelism should use this instance instead of creating their own threads.
+    static ThreadPool* instance();
+
+    int threadCount() const { return static_cast<int>(queues_.size()); }
+
+    // Posts a task for execution on any worker thread. Tasks posted from a worker thread go to
+    // the queue of that worker; everything else is distributed round-robin.
+    void postTask(Callback task);
+
+    // Tasks posted with the same sequence run one at a time in posting order, but on any
+    // worker thread. A sequence is cheap: it occupies a worker only while it has tasks.
+    class Sequence
+    {
+    public:
+        Sequence() = default;
+
+    private:
+        friend class ThreadPool;
+
+        std::mutex lock_;
+        std::deque<Callback> tasks_;
+        bool scheduled_ = false;
+
+        DISALLOW_COPY_AND_ASSIGN(Sequence);
+    };
+
+    std::shared_ptr<Sequence> createSequence();
+    void postSequencedTask(std::shared_ptr<Sequence> sequence, Callback task);
+
+    // Runs |body| for every index in [first, last) across the pool and returns when all
+    // iterations have finished. The calling thread participates in the work; indices are
+    // handed out one at a time, so iterations of very different cost balance themselves.
+    void parallelFor(int first, int last, const std::function<void(int)>& body);
+
+private:
+    struct WorkerQueue
+    {
+        std::mutex lock;
+        std::deque<Callback> tasks;
+    };
+
+    void workerMain(size_t index);
+    Callback takeTask(size_t index);
+    Callback tryTakeTask(size_t index);
+    void runSequence(std::shared_ptr<Sequence> sequence);
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::vector<std::thread> threads_;
+
+    // Guards |pending_tasks_| and |stopping_|; sleeping workers wait on |wake_event_|.
+    std::mutex wake_lock_;
+    std::condition_variable wake_event_;
+    int pending_tasks_ = 0;
+    bool stopping_ = false;
+
+    std::atomic<size_t> next_queue_{ 0 };
+
+    DISALLOW_COPY_AND_ASSIGN(ThreadPool);
+};
+
+} // namespace base
+
+#endif // BASE__THREADING__THREAD_POOL_H
@@ -0,0 +1,121 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/threading/thread_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <numeric>
+
+namespace base {
+
+TEST(ThreadPoolTest, PostTask)
+{
+    const int kTaskCount = 500;
+
+    std::atomic<int> counter{ 0 };
+
+    {
+        ThreadPool pool(4);
+
+        for (int i = 0; i < kTaskCount; ++i)
+            pool.postTask([&counter]() { ++counter; });
+
+        // The destructor drains the queued tasks before joining the workers.
+    }
+
+    EXPECT_EQ(counter, kTaskCount);
+}
+
+TEST(ThreadPoolTest, ParallelFor)
+{
+    ThreadPool pool(4);
+
+    std::vector<int> values(1000, 0);
+
+    pool.parallelFor(0, static_cast<int>(values.size()), [&values](int index)
+    {
+        values[static_cast<size_t>(index)] = index * 2;
+    });
+
+    for (size_t i = 0; i < values.size(); ++i)
+        EXPECT_EQ(values[i], static_cast<int>(i) * 2);
+
+    // Empty and single-element ranges.
+    std::atomic<int> counter{ 0 };
+
+    pool.parallelFor(10, 10, [&counter](int /* index */) { ++counter; });
+    EXPECT_EQ(counter, 0);
+
+    pool.parallelFor(10, 11, [&counter](int /* index */) { ++counter; });
+    EXPECT_EQ(counter, 1);
+}
+
+TEST(ThreadPoolTest, NestedParallelFor)
+{
+    // Every worker enters its own parallelFor; the loops must still finish because waiting
+    // workers keep executing pool tasks.
+    ThreadPool pool(2);
+
+    std::atomic<int> counter{ 0 };
+
+    pool.parallelFor(0, 4, [&pool, &counter](int /* outer */)
+    {
+        pool.parallelFor(0, 8, [&counter](int /* inner */) { ++counter; });
+    });
+
+    EXPECT_EQ(counter, 4 * 8);
+}
+
+TEST(ThreadPoolTest, Sequence)
+{
+    const int kTaskCount = 1000;
+
+    // No synchronization on purpose: a sequence runs its tasks one at a time in posting
+    // order, so the plain vector must end up sorted.
+    std::vector<int> order;
+
+    {
+        ThreadPool pool(4);
+        std::shared_ptr<ThreadPool::Sequence> sequence = pool.createSequence();
+
+        for (int i = 0; i < kTaskCount; ++i)
+            pool.postSequencedTask(sequence, [&order, i]() { order.push_back(i); });
+    }
+
+    ASSERT_EQ(order.size(), static_cast<size_t>(kTaskCount));
+
+    for (int i = 0; i < kTaskCount; ++i)
+        EXPECT_EQ(order[static_cast<size_t>(i)], i);
+}
+
+TEST(ThreadPoolTest, Instance)
+{
+    ThreadPool* pool = ThreadPool::instance();
+    ASSERT_TRUE(pool);
+    EXPECT_EQ(pool, ThreadPool::instance());
+    EXPECT_GE(pool->threadCount(), 1);
+
+    std::atomic<int> sum{ 0 };
+
+    pool->parallelFor(1, 101, [&sum](int index) { sum += index; });
+    EXPECT_EQ(sum, 5050);
+}
+
+} // namespace base
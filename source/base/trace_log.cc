@@ -0,0 +1,165 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/trace_log.h"
+
+#include "base/logging.h"
+#include "base/process_handle.h"
+
+#include <cstdio>
+#include <functional>
+#include <thread>
+
+namespace base {
+
+namespace {
+
+// Upper bound on buffered events. At 40 bytes per event this is about 20 MB; events past the
+// limit are counted and dropped, so a forgotten trace cannot exhaust memory.
+const size_t kMaxBufferedEvents = 512 * 1024;
+
+uint32_t currentThreadId()
+{
+    // The standard thread id hashed down to something compact; collisions only merge timeline
+    // rows in the viewer and do not corrupt the trace.
+    return static_cast<uint32_t>(std::hash<std::thread::id>()(std::this_thread::get_id()));
+}
+
+} // namespace
+
+// static
+std::atomic_bool TraceLog::enabled_ = false;
+
+// static
+TraceLog& TraceLog::instance()
+{
+    static TraceLog trace_log;
+    return trace_log;
+}
+
+TraceLog::TraceLog()
+{
+    // Nothing
+}
+
+TraceLog::~TraceLog()
+{
+    stop();
+}
+
+void TraceLog::start(const std::filesystem::path& file_path)
+{
+    std::scoped_lock lock(lock_);
+
+    if (enabled_.load(std::memory_order_relaxed))
+        return;
+
+    file_path_ = file_path;
+    events_.clear();
+    events_.reserve(4096);
+    dropped_events_ = 0;
+
+    LOG(LS_INFO) << "Trace recording started: " << file_path;
+
+    enabled_.store(true, std::memory_order_relaxed);
+}
+
+void TraceLog::stop()
+{
+    std::scoped_lock lock(lock_);
+
+    if (!enabled_.load(std::memory_order_relaxed))
+        return;
+
+    enabled_.store(false, std::memory_order_relaxed);
+
+    FILE* file = fopen(file_path_.u8string().c_str(), "w");
+    if (!file)
+    {
+        LOG(LS_ERROR) << "Unable to create trace file: " << file_path_;
+        return;
+    }
+
+    // The JSON array form of the trace-event format. The trailing comma before ']' is accepted
+    // by the viewers, so events are written uniformly.
+    const unsigned long long process_id = static_cast<unsigned long long>(currentProcessId());
+
+    fputs("[\n", file);
+
+    for (const Event& event : events_)
+    {
+        if (event.end_us != event.begin_us)
+        {
+            fprintf(file,
+                    "{\"ph\":\"X\",\"cat\":\"%s\",\"name\":\"%s\",\"ts\":%llu,\"dur\":%llu,"
+                    "\"pid\":%llu,\"tid\":%lu},\n",
+                    event.category, event.name,
+                    static_cast<unsigned long long>(event.begin_us),
+                    static_cast<unsigned long long>(event.end_us - event.begin_us),
+                    process_id, static_cast<unsigned long>(event.thread_id));
+        }
+        else
+        {
+            fprintf(file,
+                    "{\"ph\":\"i\",\"s\":\"t\",\"cat\":\"%s\",\"name\":\"%s\",\"ts\":%llu,"
+                    "\"pid\":%llu,\"tid\":%lu},\n",
+                    event.category, event.name,
+                    static_cast<unsigned long long>(event.begin_us),
+                    process_id, static_cast<unsigned long>(event.thread_id));
+        }
+    }
+
+    fputs("]\n", file);
+    fclose(file);
+
+    LOG(LS_INFO) << "Trace recording stopped: " << events_.size() << " events written, "
+                 << dropped_events_ << " dropped";
+
+    events_.clear();
+    events_.shrink_to_fit();
+}
+
+void TraceLog::addEvent(const char* category, const char* name,
+                        uint64_t begin_us, uint64_t end_us)
+{
+    addEventImpl(Event{ category, name, begin_us, end_us, currentThreadId() });
+}
+
+void TraceLog::addInstantEvent(const char* category, const char* name, uint64_t time_us)
+{
+    addEventImpl(Event{ category, name, time_us, time_us, currentThreadId() });
+}
+
+void TraceLog::addEventImpl(const Event& event)
+{
+    std::scoped_lock lock(lock_);
+
+    // Recording may have been stopped between the caller's isEnabled() check and here.
+    if (!enabled_.load(std::memory_order_relaxed))
+        return;
+
+    if (events_.size() >= kMaxBufferedEvents)
+    {
+        ++dropped_events_;
+        return;
+    }
+
+    events_.emplace_back(event);
+}
+
+} // namespace base
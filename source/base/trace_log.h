@@ -0,0 +1,129 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__TRACE_LOG_H
+#define BASE__TRACE_LOG_H
+
+#include "base/macros_magic.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <vector>
+
+namespace base {
+
+// Process-wide recorder of timeline trace events in the Chrome trace-event JSON format, which
+// Perfetto and chrome://tracing load directly. Each process writes its own file tagged with its
+// process id; files of the host processes captured together can be concatenated and correlated
+// on one timeline, since the timestamps come from the monotonic system clock shared by all
+// processes.
+//
+// Recording is off by default and costs one relaxed atomic load per instrumentation point.
+// When enabled, events are buffered in memory (bounded) and written out by stop(), so the
+// traced code path never touches the file system.
+class TraceLog
+{
+public:
+    static TraceLog& instance();
+
+    // True while recording. Cheap enough to gate per-frame instrumentation points.
+    static bool isEnabled() { return enabled_.load(std::memory_order_relaxed); }
+
+    // Starts recording into |file_path|. The file is created on stop(); an existing file is
+    // overwritten.
+    void start(const std::filesystem::path& file_path);
+
+    // Stops recording and writes the buffered events out. Called implicitly by the destructor
+    // of the singleton at process exit.
+    void stop();
+
+    // Timestamp for event boundaries: monotonic microseconds, comparable between processes on
+    // the same machine.
+    static uint64_t nowUs()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    // Records a completed interval on the calling thread. |category| and |name| must be string
+    // literals; they are stored by pointer and read when the trace is written.
+    void addEvent(const char* category, const char* name, uint64_t begin_us, uint64_t end_us);
+
+    // Records a point in time on the calling thread.
+    void addInstantEvent(const char* category, const char* name, uint64_t time_us);
+
+private:
+    TraceLog();
+    ~TraceLog();
+
+    struct Event
+    {
+        const char* category;
+        const char* name;
+        uint64_t begin_us;
+        uint64_t end_us; // Equal to |begin_us| for instant events.
+        uint32_t thread_id;
+    };
+
+    void addEventImpl(const Event& event);
+
+    static std::atomic_bool enabled_;
+
+    std::mutex lock_;
+    std::vector<Event> events_;
+    size_t dropped_events_ = 0;
+    std::filesystem::path file_path_;
+
+    DISALLOW_COPY_AND_ASSIGN(TraceLog);
+};
+
+// Records the lifetime of the enclosing scope as a trace event. Does nothing when recording is
+// disabled. |category| and |name| must be string literals.
+class ScopedTraceEvent
+{
+public:
+    ScopedTraceEvent(const char* category, const char* name)
+    {
+        if (TraceLog::isEnabled())
+        {
+            category_ = category;
+            name_ = name;
+            begin_us_ = TraceLog::nowUs();
+        }
+    }
+
+    ~ScopedTraceEvent()
+    {
+        if (begin_us_ != 0)
+            TraceLog::instance().addEvent(category_, name_, begin_us_, TraceLog::nowUs());
+    }
+
+private:
+    const char* category_ = nullptr;
+    const char* name_ = nullptr;
+    uint64_t begin_us_ = 0;
+
+    DISALLOW_COPY_AND_ASSIGN(ScopedTraceEvent);
+};
+
+} // namespace base
+
+#endif // BASE__TRACE_LOG_H
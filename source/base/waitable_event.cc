@@ -18,8 +18,62 @@
 
 #include "base/waitable_event.h"
 
+#include "base/logging.h"
+
+#include <algorithm>
+
 namespace base {
 
+// Per-call waiter shared by all events of one waitAny(). Events wake it under their own
+// |signal_lock_|, the waiting thread then rescans the events to find one it can claim.
+class WaitableEvent::MultiWaiter
+{
+public:
+    MultiWaiter() = default;
+    ~MultiWaiter() = default;
+
+    // Called by a signaled event. May be called while the event lock is held.
+    void wake()
+    {
+        {
+            std::scoped_lock lock(lock_);
+            woken_ = true;
+        }
+
+        condition_.notify_one();
+    }
+
+    // Blocks until wake() is called or |deadline| (if any) has passed. Consumes the wakeup, so
+    // the caller rescans the events once per call. Returns false on timeout.
+    bool waitForWake(const std::chrono::steady_clock::time_point* deadline)
+    {
+        std::unique_lock lock(lock_);
+
+        while (!woken_)
+        {
+            if (deadline)
+            {
+                if (condition_.wait_until(lock, *deadline) == std::cv_status::timeout && !woken_)
+                    return false;
+            }
+            else
+            {
+                condition_.wait(lock);
+            }
+        }
+
+        woken_ = false;
+        return true;
+    }
+
+private:
+    std::condition_variable condition_;
+    std::mutex lock_;
+    bool woken_ = false;
+
+    DISALLOW_COPY_AND_ASSIGN(MultiWaiter);
+};
+
 WaitableEvent::WaitableEvent(ResetPolicy reset_policy, InitialState initial_state)
     : signal_(initial_state == InitialState::SIGNALED),
       reset_(reset_policy == ResetPolicy::AUTOMATIC)
@@ -40,6 +94,9 @@ void WaitableEvent::signal()
     {
         std::scoped_lock lock(signal_lock_);
         signal_ = true;
+
+        for (MultiWaiter* waiter : waiters_)
+            waiter->wake();
     }
 
     signal_condition_.notify_all();
@@ -81,4 +138,81 @@ void WaitableEvent::wait()
         signal_ = false;
 }
 
+// static
+size_t WaitableEvent::waitAny(WaitableEvent* const events[], size_t count)
+{
+    return waitAnyImpl(events, count, nullptr);
+}
+
+// static
+size_t WaitableEvent::waitAny(WaitableEvent* const events[], size_t count,
+                              const std::chrono::milliseconds& timeout)
+{
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + timeout;
+    return waitAnyImpl(events, count, &deadline);
+}
+
+// static
+size_t WaitableEvent::waitAnyImpl(WaitableEvent* const events[], size_t count,
+                                  const std::chrono::steady_clock::time_point* deadline)
+{
+    DCHECK(events);
+    DCHECK_GT(count, 0u);
+
+    MultiWaiter waiter;
+
+    // Register the waiter with each event, claiming the first one that is already signaled.
+    size_t registered = 0;
+    size_t result = count;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        std::scoped_lock lock(events[i]->signal_lock_);
+
+        if (events[i]->signal_)
+        {
+            if (events[i]->reset_)
+                events[i]->signal_ = false;
+
+            result = i;
+            break;
+        }
+
+        events[i]->waiters_.push_back(&waiter);
+        ++registered;
+    }
+
+    while (result == count)
+    {
+        if (!waiter.waitForWake(deadline))
+            break;
+
+        // Find the event that woke the waiter. An automatic event can be consumed by another
+        // thread first; in that case keep waiting.
+        for (size_t i = 0; i < count; ++i)
+        {
+            std::scoped_lock lock(events[i]->signal_lock_);
+
+            if (events[i]->signal_)
+            {
+                if (events[i]->reset_)
+                    events[i]->signal_ = false;
+
+                result = i;
+                break;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < registered; ++i)
+    {
+        std::scoped_lock lock(events[i]->signal_lock_);
+
+        std::vector<MultiWaiter*>& waiters = events[i]->waiters_;
+        waiters.erase(std::remove(waiters.begin(), waiters.end(), &waiter), waiters.end());
+    }
+
+    return result;
+}
+
 } // namespace base
@@ -24,6 +24,7 @@
 #include <chrono>
 #include <condition_variable>
 #include <mutex>
+#include <vector>
 
 namespace base {
 
@@ -59,12 +60,31 @@ public:
     // Wait indefinitely for the event to be signaled.
     void wait();
 
+    // Waits until any of the |count| events in |events| is signaled and returns the index of a
+    // signaled event. Blocks without polling. An event with ResetPolicy::AUTOMATIC is reset
+    // before returning and releases only one waiter per signal, as with wait().
+    static size_t waitAny(WaitableEvent* const events[], size_t count);
+
+    // Same as waitAny(), but gives up after |timeout| has passed and returns |count|.
+    static size_t waitAny(WaitableEvent* const events[], size_t count,
+                          const std::chrono::milliseconds& timeout);
+
 private:
+    class MultiWaiter;
+
+    static size_t waitAnyImpl(WaitableEvent* const events[], size_t count,
+                              const std::chrono::steady_clock::time_point* deadline);
+
     std::condition_variable signal_condition_;
     std::mutex signal_lock_;
     bool signal_ = false;
     bool reset_ = false;
 
+    // Multi-event waiters currently registered with this event. Guarded by |signal_lock_|;
+    // registration, wakeup and removal all happen under it, so a waiter pointer can never be
+    // used after waitAny() has returned.
+    std::vector<MultiWaiter*> waiters_;
+
     DISALLOW_COPY_AND_ASSIGN(WaitableEvent);
 };
 
@@ -0,0 +1,132 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/waitable_event.h"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <atomic>
+#include <thread>
+
+namespace base {
+
+TEST(WaitableEventTest, WaitAnyAlreadySignaled)
+{
+    WaitableEvent first;
+    WaitableEvent second;
+
+    second.signal();
+
+    std::array<WaitableEvent*, 2> events = { &first, &second };
+    EXPECT_EQ(WaitableEvent::waitAny(events.data(), events.size()), 1u);
+
+    // A manual event stays signaled.
+    EXPECT_EQ(WaitableEvent::waitAny(events.data(), events.size()), 1u);
+}
+
+TEST(WaitableEventTest, WaitAnyTimeout)
+{
+    WaitableEvent first;
+    WaitableEvent second;
+
+    std::array<WaitableEvent*, 2> events = { &first, &second };
+    EXPECT_EQ(WaitableEvent::waitAny(events.data(), events.size(),
+                                     std::chrono::milliseconds(10)),
+              events.size());
+}
+
+TEST(WaitableEventTest, WaitAnyWakesOnSignal)
+{
+    WaitableEvent first;
+    WaitableEvent second;
+
+    std::thread signaler([&second]()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        second.signal();
+    });
+
+    std::array<WaitableEvent*, 2> events = { &first, &second };
+    EXPECT_EQ(WaitableEvent::waitAny(events.data(), events.size()), 1u);
+
+    signaler.join();
+}
+
+TEST(WaitableEventTest, WaitAnyAutomaticResetsAndReleasesOne)
+{
+    WaitableEvent manual;
+    WaitableEvent automatic(WaitableEvent::ResetPolicy::AUTOMATIC);
+
+    automatic.signal();
+
+    std::array<WaitableEvent*, 2> events = { &manual, &automatic };
+    EXPECT_EQ(WaitableEvent::waitAny(events.data(), events.size()), 1u);
+
+    // The automatic event was consumed by the first wait.
+    EXPECT_FALSE(automatic.isSignaled());
+    EXPECT_EQ(WaitableEvent::waitAny(events.data(), events.size(),
+                                     std::chrono::milliseconds(10)),
+              events.size());
+}
+
+TEST(WaitableEventTest, WaitAnyAutomaticManyWaiters)
+{
+    WaitableEvent stop;
+    WaitableEvent work(WaitableEvent::ResetPolicy::AUTOMATIC);
+
+    constexpr size_t kThreadCount = 4;
+    constexpr int kWorkCount = 100;
+
+    std::atomic_int consumed{ 0 };
+    std::array<std::thread, kThreadCount> threads;
+
+    for (std::thread& thread : threads)
+    {
+        thread = std::thread([&]()
+        {
+            std::array<WaitableEvent*, 2> events = { &work, &stop };
+
+            for (;;)
+            {
+                if (WaitableEvent::waitAny(events.data(), events.size()) != 0)
+                    return;
+
+                consumed.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    // Each signal of the automatic event must release exactly one waiter.
+    for (int i = 0; i < kWorkCount; ++i)
+    {
+        work.signal();
+
+        while (consumed.load(std::memory_order_relaxed) != i + 1)
+            std::this_thread::yield();
+    }
+
+    stop.signal();
+
+    for (std::thread& thread : threads)
+        thread.join();
+
+    EXPECT_EQ(consumed.load(std::memory_order_relaxed), kWorkCount);
+}
+
+} // namespace base
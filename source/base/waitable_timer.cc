@@ -27,6 +27,7 @@ class WaitableTimer::Impl : public std::enable_shared_from_this<Impl>
 {
 public:
     explicit Impl(Type type,
+                  const std::chrono::milliseconds& slack,
                   TimeoutCallback signal_callback,
                   std::shared_ptr<TaskRunner> task_runner);
     ~Impl();
@@ -36,8 +37,10 @@ public:
 
 private:
     void onSignal();
+    std::chrono::milliseconds alignedDelay(const std::chrono::milliseconds& time_delta) const;
 
     Type type_;
+    std::chrono::milliseconds slack_;
     TimeoutCallback signal_callback_;
     std::shared_ptr<TaskRunner> task_runner_;
     std::chrono::milliseconds time_delta_;
@@ -46,9 +49,11 @@ private:
 };
 
 WaitableTimer::Impl::Impl(Type type,
+                          const std::chrono::milliseconds& slack,
                           TimeoutCallback signal_callback,
                           std::shared_ptr<TaskRunner> task_runner)
     : type_(type),
+      slack_(slack),
       signal_callback_(std::move(signal_callback)),
       task_runner_(std::move(task_runner))
 {
@@ -62,7 +67,9 @@ WaitableTimer::Impl::~Impl()
 
 void WaitableTimer::Impl::start(const std::chrono::milliseconds& time_delta)
 {
-    task_runner_->postDelayedTask(std::bind(&Impl::onSignal, shared_from_this()), time_delta);
+    time_delta_ = time_delta;
+    task_runner_->postDelayedTask(
+        std::bind(&Impl::onSignal, shared_from_this()), alignedDelay(time_delta));
 }
 
 void WaitableTimer::Impl::dettach()
@@ -70,6 +77,25 @@ void WaitableTimer::Impl::dettach()
     signal_callback_ = nullptr;
 }
 
+std::chrono::milliseconds WaitableTimer::Impl::alignedDelay(
+    const std::chrono::milliseconds& time_delta) const
+{
+    if (slack_ <= std::chrono::milliseconds::zero())
+        return time_delta;
+
+    const std::chrono::milliseconds now =
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch());
+
+    // The shared ticks are the multiples of |slack_| on the monotonic clock. The firing moves
+    // to the first tick at or after the nominal deadline: never early, at most |slack_| late.
+    const int64_t deadline = (now + time_delta).count();
+    const int64_t slack = slack_.count();
+    const int64_t aligned = (deadline + slack - 1) / slack * slack;
+
+    return std::chrono::milliseconds(aligned) - now;
+}
+
 void WaitableTimer::Impl::onSignal()
 {
     if (!signal_callback_)
@@ -96,7 +122,14 @@ WaitableTimer::~WaitableTimer()
 void WaitableTimer::start(const std::chrono::milliseconds& time_delta,
                           TimeoutCallback signal_callback)
 {
-    impl_ = std::make_shared<Impl>(type_, std::move(signal_callback), task_runner_);
+    start(time_delta, std::chrono::milliseconds::zero(), std::move(signal_callback));
+}
+
+void WaitableTimer::start(const std::chrono::milliseconds& time_delta,
+                          const std::chrono::milliseconds& slack,
+                          TimeoutCallback signal_callback)
+{
+    impl_ = std::make_shared<Impl>(type_, slack, std::move(signal_callback), task_runner_);
     impl_->start(time_delta);
 }
 
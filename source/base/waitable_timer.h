@@ -43,6 +43,16 @@ public:
     // If the timer is already in a running state, then no action is taken.
     void start(const std::chrono::milliseconds& time_delta, TimeoutCallback signal_callback);
 
+    // Same, but each firing may be delayed by up to |slack| so that it lands on a shared tick
+    // of the monotonic clock (the multiples of |slack|). Periodic timers started this way by
+    // independent services fire together instead of scattering wakeups across the second, so
+    // an otherwise idle process is woken once per tick. Timers whose slack values divide each
+    // other share ticks too. The callback never fires early. Meant for background maintenance
+    // work whose period is a deadline hint rather than a contract.
+    void start(const std::chrono::milliseconds& time_delta,
+               const std::chrono::milliseconds& slack,
+               TimeoutCallback signal_callback);
+
     // Stops the timer and waits for the callback function to complete, if it is running.
     void stop();
 
@@ -23,8 +23,18 @@
 #include <X11/Xatom.h>
 #include <X11/extensions/Xfixes.h>
 
+#include <algorithm>
+
 namespace base {
 
+namespace {
+
+// Upper bound for a selection received through the INCR protocol. Transfers above this limit
+// are consumed but dropped, so a misbehaving application cannot exhaust the memory.
+const size_t kMaxIncrDataSize = 32 * 1024 * 1024; // 32 MB.
+
+} // namespace
+
 XServerClipboard::XServerClipboard() = default;
 XServerClipboard::~XServerClipboard() = default;
 
@@ -98,8 +108,17 @@ void XServerClipboard::setClipboard(const std::string& data)
 
 void XServerClipboard::processXEvent(XEvent* event)
 {
-    if (clipboard_window_ == BadValue || event->xany.window != clipboard_window_)
+    if (clipboard_window_ == BadValue)
+        return;
+
+    if (event->xany.window != clipboard_window_)
+    {
+        // PropertyNotify events of requestor windows drive outgoing INCR transfers: every
+        // deletion of the chunk property requests the next chunk.
+        if (event->type == PropertyNotify && event->xproperty.state == PropertyDelete)
+            onRequestorPropertyDeleted(event);
         return;
+    }
 
     switch (event->type)
     {
@@ -166,17 +185,47 @@ void XServerClipboard::onPropertyNotify(XEvent* event)
         unsigned long item_count, after;
         unsigned char *data;
 
+        // Retrieving the chunk with delete set acknowledges it and asks the selection owner for
+        // the next one.
         XGetWindowProperty(display_, clipboard_window_, large_selection_property_,
                          0, ~0L, True, AnyPropertyType, &type, &format,
                          &item_count, &after, &data);
         if (type != None)
         {
-            // TODO(lambroslambrou): Properly support large transfers - http://crbug.com/151447.
-            XFree(data);
-
-            // If the property is zero-length then the large transfer is complete.
             if (item_count == 0)
+            {
+                // A zero-length chunk completes the transfer.
+                if (!incr_overflow_ &&
+                    (large_selection_target_ == utf8_string_atom_ ||
+                     large_selection_target_ == XA_STRING))
+                {
+                    notifyClipboardText(incr_data_);
+                }
+
+                incr_data_.clear();
+                incr_data_.shrink_to_fit();
+                incr_overflow_ = false;
                 large_selection_property_ = None;
+                large_selection_target_ = None;
+                get_selections_time_ = TimePoint();
+            }
+            else if (format == 8 && !incr_overflow_)
+            {
+                if (incr_data_.size() + item_count > kMaxIncrDataSize)
+                {
+                    LOG(LS_WARNING) << "INCR selection exceeds " << kMaxIncrDataSize
+                                    << " bytes; dropped";
+                    incr_data_.clear();
+                    incr_data_.shrink_to_fit();
+                    incr_overflow_ = true;
+                }
+                else
+                {
+                    incr_data_.append(reinterpret_cast<char*>(data), item_count);
+                }
+            }
+
+            XFree(data);
         }
     }
 }
@@ -195,8 +244,17 @@ void XServerClipboard::onSelectionNotify(XEvent* event)
                            &item_count, &after, &data);
         if (type == large_selection_atom_)
         {
-            // Large selection - just read and ignore these for now.
+            // The owner transfers the selection through the INCR protocol (ICCCM 2.7.2).
+            // Deleting the INCR property above accepts the transfer; the chunks arrive as
+            // PropertyNewValue notifications and are collected in onPropertyNotify().
             large_selection_property_ = event->xselection.property;
+            large_selection_target_ = event->xselection.target;
+            incr_data_.clear();
+            incr_overflow_ = false;
+            XFree(data);
+
+            // Selection processing stays open until the last chunk has arrived.
+            return;
         }
         else
         {
@@ -282,15 +340,75 @@ void XServerClipboard::sendTimestampResponse(Window requestor, Atom property)
 
 void XServerClipboard::sendStringResponse(Window requestor, Atom property, Atom target)
 {
-    if (!data_.empty())
+    if (data_.empty())
+        return;
+
+    if (data_.size() >= maxPropertySize())
+    {
+        // The selection does not fit into one property change; announce an INCR transfer
+        // (ICCCM 2.7.2). The requestor accepts by deleting the INCR property, and every
+        // further deletion of the chunk property requests the next chunk.
+        long total_size = static_cast<long>(data_.size());
+        XChangeProperty(display_, requestor, property, large_selection_atom_, 32,
+                        PropModeReplace, reinterpret_cast<unsigned char*>(&total_size), 1);
+
+        // The property deletions of the requestor window drive the transfer.
+        XSelectInput(display_, requestor, PropertyChangeMask);
+
+        outgoing_transfers_.push_back({ requestor, property, target, 0 });
+        return;
+    }
+
+    // Return the actual string data; we always return UTF8, regardless of the configured locale.
+    XChangeProperty(display_, requestor, property, target, 8, PropModeReplace,
+                    reinterpret_cast<unsigned char*>(const_cast<char*>(data_.data())),
+                    data_.size());
+}
+
+void XServerClipboard::onRequestorPropertyDeleted(XEvent* event)
+{
+    for (auto it = outgoing_transfers_.begin(); it != outgoing_transfers_.end(); ++it)
     {
-        // Return the actual string data; we always return UTF8, regardless of the configured locale.
-        XChangeProperty(display_, requestor, property, target, 8, PropModeReplace,
-                        reinterpret_cast<unsigned char*>(const_cast<char*>(data_.data())),
-                        data_.size());
+        if (it->requestor != event->xproperty.window || it->property != event->xproperty.atom)
+            continue;
+
+        // The clipboard content can have been replaced while the transfer was running; the
+        // stale transfer is then finished early with the final zero-length chunk.
+        const size_t left_size = it->offset < data_.size() ? data_.size() - it->offset : 0;
+        const size_t chunk_size = std::min(maxPropertySize(), left_size);
+
+        // A zero-length chunk tells the requestor that the transfer is complete.
+        XChangeProperty(display_, it->requestor, it->property, it->target, 8, PropModeReplace,
+                        reinterpret_cast<unsigned char*>(
+                            const_cast<char*>(data_.data() + it->offset)),
+                        chunk_size);
+        XFlush(display_);
+
+        if (!chunk_size)
+        {
+            XSelectInput(display_, it->requestor, 0);
+            outgoing_transfers_.erase(it);
+        }
+        else
+        {
+            it->offset += chunk_size;
+        }
+
+        return;
     }
 }
 
+size_t XServerClipboard::maxPropertySize() const
+{
+    // The request sizes are reported in 4-byte units; leave room for the protocol overhead of
+    // the property change request itself.
+    long max_request_size = XExtendedMaxRequestSize(display_);
+    if (!max_request_size)
+        max_request_size = XMaxRequestSize(display_);
+
+    return static_cast<size_t>(max_request_size) * 4 - 1024;
+}
+
 void XServerClipboard::handleSelectionNotify(XSelectionEvent* event,
                                              Atom /* type */,
                                              int format,
@@ -25,6 +25,7 @@
 #include <functional>
 #include <set>
 #include <string>
+#include <vector>
 
 #include <X11/Xlib.h>
 
@@ -86,6 +87,14 @@ private:
     // Notify the registered callback of new clipboard text.
     void notifyClipboardText(const std::string& text);
 
+    // Called when a requestor deletes a property of its window during an outgoing INCR
+    // transfer; every deletion requests the next chunk (ICCCM 2.7.2).
+    void onRequestorPropertyDeleted(XEvent* event);
+
+    // Largest number of bytes that fit into one property change request. Selections above this
+    // limit are transferred through the INCR protocol.
+    size_t maxPropertySize() const;
+
     // These methods trigger the X server or selection owner to send back an event containing the
     // requested information.
     void requestSelectionTargets(Atom selection);
@@ -124,6 +133,29 @@ private:
     // in-progress.
     Atom large_selection_property_ = None;
 
+    // Target type of the incoming INCR transfer; the collected data is reported only for string
+    // targets.
+    Atom large_selection_target_ = None;
+
+    // Accumulates the chunks of an incoming INCR transfer. Only the chunk received last is held
+    // in an X property at any time, so the memory use is bounded by the selection size.
+    std::string incr_data_;
+
+    // Set when an incoming INCR transfer exceeds the size limit. The remaining chunks are still
+    // consumed, so the selection owner finishes cleanly, but the data is dropped.
+    bool incr_overflow_ = false;
+
+    // State of an outgoing INCR transfer. A chunk of |data_| is written to the requestor's
+    // property each time the requestor deletes the previous one.
+    struct OutgoingTransfer
+    {
+        Window requestor;
+        Atom property;
+        Atom target;
+        size_t offset;
+    };
+    std::vector<OutgoingTransfer> outgoing_transfers_;
+
     // Remembers the start time of selection processing, and is set to null when processing is
     // complete. This is used to decide whether to begin processing a new selection or continue with
     // the current selection.
@@ -0,0 +1,192 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "client/audio_jitter_buffer.h"
+
+#include "base/logging.h"
+#include "proto/desktop.pb.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace client {
+
+namespace {
+
+const size_t kSampleRate = 48000;
+const size_t kChannels = 2;
+const size_t kBytesPerFrame = kChannels * sizeof(int16_t);
+const size_t kBytesPerMs = kSampleRate * kBytesPerFrame / 1000;
+
+// Bounds for the adaptive target delay.
+const int64_t kMinTargetUs = 20 * 1000; // 20 ms.
+const int64_t kMaxTargetUs = 200 * 1000; // 200 ms.
+
+// Target delay is |kJitterMultiplier| times the jitter estimate plus one packet of headroom,
+// so a packet has to be delayed well beyond the typical variance before it misses its slot.
+const int64_t kJitterMultiplier = 3;
+const int64_t kTargetHeadroomUs = 10 * 1000; // 10 ms.
+
+// Surplus above the target that triggers time-stretched (faster) playback. Without the slack
+// the buffer would oscillate around the target and stretch continuously.
+const size_t kShrinkSlackBytes = 20 * kBytesPerMs; // 20 ms.
+
+// While shrinking, every 32 buffered frames are resampled into 31 played frames: a ~3% rate
+// increase, below the audibility threshold for short stretches.
+const size_t kStretchInFrames = 32;
+const size_t kStretchOutFrames = 31;
+
+// Hard cap on buffered audio. Reached only if playback stalls; the oldest audio is dropped,
+// since it would play too late to be useful anyway.
+const size_t kMaxBufferedBytes = 1000 * kBytesPerMs; // 1 second.
+
+} // namespace
+
+AudioJitterBuffer::AudioJitterBuffer()
+    : target_us_(kMinTargetUs)
+{
+    // Nothing
+}
+
+AudioJitterBuffer::~AudioJitterBuffer() = default;
+
+void AudioJitterBuffer::addPacket(std::unique_ptr<proto::AudioPacket> packet)
+{
+    TimePoint now = Clock::now();
+
+    size_t packet_bytes = 0;
+    for (int i = 0; i < packet->data_size(); ++i)
+        packet_bytes += packet->data(i).size();
+
+    if (!packet_bytes)
+        return;
+
+    if (last_packet_duration_us_ != 0)
+    {
+        // RFC 3550 inter-arrival jitter: compare the spacing of two arrivals with the playback
+        // duration of the earlier packet and smooth the deviation with a 1/16 gain.
+        int64_t arrival_delta_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            now - last_arrival_time_).count();
+        int64_t deviation_us = arrival_delta_us - last_packet_duration_us_;
+
+        jitter_us_ += (std::abs(deviation_us) - jitter_us_) / 16;
+        target_us_ = std::clamp(
+            kJitterMultiplier * jitter_us_ + kTargetHeadroomUs, kMinTargetUs, kMaxTargetUs);
+    }
+
+    last_arrival_time_ = now;
+    last_packet_duration_us_ =
+        static_cast<int64_t>(packet_bytes) * 1000 / static_cast<int64_t>(kBytesPerMs);
+
+    for (int i = 0; i < packet->data_size(); ++i)
+    {
+        const std::string& data = packet->data(i);
+        buffer_.insert(buffer_.end(), data.begin(), data.end());
+    }
+
+    if (buffer_.size() > kMaxBufferedBytes)
+    {
+        LOG(LS_WARNING) << "Audio buffer overflow, dropping "
+                        << (buffer_.size() - kMaxBufferedBytes) << " bytes";
+        buffer_.erase(buffer_.begin(),
+                      buffer_.begin() + static_cast<ptrdiff_t>(buffer_.size() - kMaxBufferedBytes));
+    }
+}
+
+size_t AudioJitterBuffer::read(void* buffer, size_t size)
+{
+    if (buffering_)
+    {
+        if (buffer_.size() < targetBytes())
+            return 0;
+
+        buffering_ = false;
+    }
+
+    if (buffer_.empty())
+    {
+        // Underflow: playback caught up with the network. Hold the next packets back until a
+        // full target delay is accumulated again.
+        buffering_ = true;
+        return 0;
+    }
+
+    uint8_t* out = reinterpret_cast<uint8_t*>(buffer);
+
+    if (buffer_.size() > targetBytes() + kShrinkSlackBytes)
+        return compressedRead(out, size);
+
+    size_t bytes = std::min(size - size % kBytesPerFrame, buffer_.size());
+
+    std::copy(buffer_.begin(), buffer_.begin() + static_cast<ptrdiff_t>(bytes), out);
+    buffer_.erase(buffer_.begin(), buffer_.begin() + static_cast<ptrdiff_t>(bytes));
+    return bytes;
+}
+
+std::chrono::milliseconds AudioJitterBuffer::targetDelay() const
+{
+    return std::chrono::milliseconds(target_us_ / 1000);
+}
+
+size_t AudioJitterBuffer::targetBytes() const
+{
+    size_t bytes = static_cast<size_t>(target_us_) * kBytesPerMs / 1000;
+    return bytes - bytes % kBytesPerFrame;
+}
+
+size_t AudioJitterBuffer::compressedRead(uint8_t* out, size_t out_size)
+{
+    size_t out_bytes = 0;
+
+    while (out_size - out_bytes >= kStretchOutFrames * kBytesPerFrame &&
+           buffer_.size() >= kStretchInFrames * kBytesPerFrame &&
+           buffer_.size() > targetBytes())
+    {
+        int16_t in[kStretchInFrames * kChannels];
+        std::copy(buffer_.begin(),
+                  buffer_.begin() + static_cast<ptrdiff_t>(sizeof(in)),
+                  reinterpret_cast<uint8_t*>(in));
+        buffer_.erase(buffer_.begin(), buffer_.begin() + static_cast<ptrdiff_t>(sizeof(in)));
+
+        int16_t* out_samples = reinterpret_cast<int16_t*>(out + out_bytes);
+
+        // Linear resampling of the block; good enough for a 3% rate change.
+        for (size_t frame = 0; frame < kStretchOutFrames; ++frame)
+        {
+            double pos = static_cast<double>(frame) * (kStretchInFrames - 1) /
+                (kStretchOutFrames - 1);
+            size_t index = static_cast<size_t>(pos);
+            double frac = pos - static_cast<double>(index);
+            size_t next = std::min(index + 1, kStretchInFrames - 1);
+
+            for (size_t channel = 0; channel < kChannels; ++channel)
+            {
+                double sample = static_cast<double>(in[index * kChannels + channel]) *
+                    (1.0 - frac) + static_cast<double>(in[next * kChannels + channel]) * frac;
+                out_samples[frame * kChannels + channel] = static_cast<int16_t>(sample);
+            }
+        }
+
+        out_bytes += kStretchOutFrames * kBytesPerFrame;
+    }
+
+    return out_bytes;
+}
+
+} // namespace client
@@ -0,0 +1,88 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef CLIENT__AUDIO_JITTER_BUFFER_H
+#define CLIENT__AUDIO_JITTER_BUFFER_H
+
+#include "base/macros_magic.h"
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+
+namespace proto {
+class AudioPacket;
+} // namespace proto
+
+namespace client {
+
+// Adaptive jitter buffer between the audio decoder and the output device. Decoded PCM is held
+// back just long enough to cover the measured variance of packet arrival times, so a packet
+// delayed by the network still arrives before its playback position and does not become an
+// audible gap. The target delay follows an inter-arrival jitter estimate and adapts in both
+// directions; when it shrinks, the surplus is played back slightly faster by resampling
+// (time-stretch) instead of being cut out, which keeps the transition inaudible.
+//
+// The buffer expects 48 kHz stereo signed 16-bit PCM, the only format the audio pipeline
+// produces. All methods must be called on the same thread.
+class AudioJitterBuffer
+{
+public:
+    AudioJitterBuffer();
+    ~AudioJitterBuffer();
+
+    // Adds a decoded packet. Must be called as packets arrive: the arrival time feeds the
+    // jitter estimate that sizes the buffer.
+    void addPacket(std::unique_ptr<proto::AudioPacket> packet);
+
+    // Fills |buffer| with up to |size| bytes of PCM ready for the device and returns the
+    // number of bytes written. Returns zero while the buffer accumulates its target delay
+    // (initially and after an underflow).
+    size_t read(void* buffer, size_t size);
+
+    // Current adaptive target delay. Exposed for logging.
+    std::chrono::milliseconds targetDelay() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+    using TimePoint = Clock::time_point;
+
+    size_t targetBytes() const;
+    size_t compressedRead(uint8_t* out, size_t out_size);
+
+    std::deque<uint8_t> buffer_;
+
+    // True while the buffer holds data back to build up the target delay. Entered initially
+    // and whenever playback drains the buffer completely.
+    bool buffering_ = true;
+
+    TimePoint last_arrival_time_;
+    int64_t last_packet_duration_us_ = 0;
+
+    // Smoothed estimate of the deviation between expected and actual packet spacing
+    // (RFC 3550 style estimator).
+    int64_t jitter_us_ = 0;
+    int64_t target_us_;
+
+    DISALLOW_COPY_AND_ASSIGN(AudioJitterBuffer);
+};
+
+} // namespace client
+
+#endif // CLIENT__AUDIO_JITTER_BUFFER_H
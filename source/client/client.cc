@@ -52,7 +52,7 @@ Client::~Client()
 #endif // defined(OS_MAC)
 }
 
-void Client::start(const Config& config)
+void Client::start(const Config& config, std::shared_ptr<PrewarmedConnection> prewarmed)
 {
     DCHECK(io_task_runner_->belongsToCurrentThread());
     DCHECK(status_window_proxy_);
@@ -92,6 +92,18 @@ void Client::start(const Config& config)
         status_window_proxy_->onStarted(
             base::strCat({ config_.address_or_id, u":", base::numberToString16(config_.port) }));
 
+        if (prewarmed)
+        {
+            // The connect and the key exchange were started before the session window was
+            // built; pick up whatever stage they reached instead of starting over.
+            LOG(LS_INFO) << "Adopting prewarmed connection";
+
+            prewarmed_ = std::move(prewarmed);
+            prewarmed_->takeResult(
+                std::bind(&Client::onPrewarmFinished, this, std::placeholders::_1));
+            return;
+        }
+
         // Create a network channel for messaging.
         channel_ = std::make_unique<base::NetworkChannel>();
 
@@ -113,6 +125,7 @@ void Client::stop()
         state_ = State::STOPPPED;
 
         router_controller_.reset();
+        prewarmed_.reset();
         authenticator_.reset();
         channel_.reset();
 
@@ -154,6 +167,39 @@ void Client::sendMessage(const google::protobuf::MessageLite& message)
     channel_->send(base::serialize(message));
 }
 
+void Client::sendMessage(uint8_t stream_id, const google::protobuf::MessageLite& message)
+{
+    if (!channel_)
+    {
+        LOG(LS_WARNING) << "sendMessage called but channel not initialized";
+        return;
+    }
+
+    channel_->send(stream_id, base::serialize(message));
+}
+
+void Client::setStreamListener(uint8_t stream_id, base::NetworkChannel::StreamListener* listener)
+{
+    if (!channel_)
+    {
+        LOG(LS_WARNING) << "setStreamListener called but channel not initialized";
+        return;
+    }
+
+    channel_->setStreamListener(stream_id, listener);
+}
+
+void Client::setStreamClass(uint8_t stream_id, base::NetworkChannel::StreamClass stream_class)
+{
+    if (!channel_)
+    {
+        LOG(LS_WARNING) << "setStreamClass called but channel not initialized";
+        return;
+    }
+
+    channel_->setStreamClass(stream_id, stream_class);
+}
+
 int64_t Client::totalRx() const
 {
     if (!channel_)
@@ -227,6 +273,45 @@ void Client::onErrorOccurred(const RouterController::Error& error)
     status_window_proxy_->onRouterError(error);
 }
 
+void Client::onPrewarmFinished(PrewarmedConnection::Result result)
+{
+    DCHECK(io_task_runner_->belongsToCurrentThread());
+
+    switch (result.type)
+    {
+        case PrewarmedConnection::Result::Type::SUCCESS:
+        {
+            channel_ = std::move(result.channel);
+            channel_->setListener(this);
+
+            status_window_proxy_->onConnected();
+
+            // Signal that everything is ready to start the session (connection established,
+            // authentication passed).
+            onSessionStarted(result.peer_version);
+
+            // Now the session will receive incoming messages.
+            channel_->resume();
+        }
+        break;
+
+        case PrewarmedConnection::Result::Type::NETWORK_ERROR:
+            status_window_proxy_->onDisconnected(result.network_error);
+            break;
+
+        case PrewarmedConnection::Result::Type::AUTHENTICATION_ERROR:
+            status_window_proxy_->onAccessDenied(result.authentication_error);
+            break;
+
+        default:
+            NOTREACHED();
+            break;
+    }
+
+    // This runs from inside the prewarm; release it once the stack unwinds.
+    io_task_runner_->postTask([prewarmed = std::move(prewarmed_)]() mutable { prewarmed.reset(); });
+}
+
 void Client::startAuthentication()
 {
     static const size_t kReadBufferSize = 2 * 1024 * 1024; // 2 Mb.
@@ -236,6 +321,7 @@ void Client::startAuthentication()
     channel_->setReadBufferSize(kReadBufferSize);
     channel_->setKeepAlive(true, kKeepAliveTime, kKeepAliveInterval);
     channel_->setNoDelay(true);
+    channel_->setSendQueueAutoTuning(true);
 
     authenticator_ = std::make_unique<base::ClientAuthenticator>(io_task_runner_);
 
@@ -21,6 +21,7 @@
 
 #include "base/version.h"
 #include "client/client_config.h"
+#include "client/prewarmed_connection.h"
 #include "client/router_controller.h"
 #include "base/net/network_channel.h"
 
@@ -42,8 +43,10 @@ public:
     explicit Client(std::shared_ptr<base::TaskRunner> io_task_runner);
     virtual ~Client();
 
-    // Starts a session.
-    void start(const Config& config);
+    // Starts a session. |prewarmed| optionally carries a connection whose connect and key
+    // exchange were started ahead of time (see PrewarmedConnection); when present and valid
+    // for |config|, the client adopts it instead of connecting itself.
+    void start(const Config& config, std::shared_ptr<PrewarmedConnection> prewarmed = nullptr);
 
     // Stops a session.
     void stop();
@@ -70,6 +73,16 @@ protected:
     // Sends outgoing message.
     void sendMessage(const google::protobuf::MessageLite& message);
 
+    // Sends a message on an auxiliary stream of the channel (see NetworkChannel::send with a
+    // stream id).
+    void sendMessage(uint8_t stream_id, const google::protobuf::MessageLite& message);
+
+    // Sets the receiver of messages for the specified auxiliary stream.
+    void setStreamListener(uint8_t stream_id, base::NetworkChannel::StreamListener* listener);
+
+    // Assigns a scheduling class to an outgoing stream.
+    void setStreamClass(uint8_t stream_id, base::NetworkChannel::StreamClass stream_class);
+
     // Methods for obtaining network metrics.
     int64_t totalRx() const;
     int64_t totalTx() const;
@@ -86,9 +99,11 @@ protected:
 
 private:
     void startAuthentication();
+    void onPrewarmFinished(PrewarmedConnection::Result result);
 
     std::shared_ptr<base::TaskRunner> io_task_runner_;
     std::unique_ptr<RouterController> router_controller_;
+    std::shared_ptr<PrewarmedConnection> prewarmed_;
     std::unique_ptr<base::NetworkChannel> channel_;
     std::unique_ptr<base::ClientAuthenticator> authenticator_;
     std::shared_ptr<StatusWindowProxy> status_window_proxy_;
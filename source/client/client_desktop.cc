@@ -23,18 +23,51 @@
 #include "base/codec/audio_decoder_opus.h"
 #include "base/codec/cursor_decoder.h"
 #include "base/codec/video_decoder.h"
+#include "base/crypto/generic_hash.h"
+#include "base/desktop/frame.h"
 #include "base/desktop/mouse_cursor.h"
 #include "client/audio_renderer.h"
 #include "client/desktop_control_proxy.h"
 #include "client/desktop_window.h"
 #include "client/desktop_window_proxy.h"
 #include "client/config_factory.h"
+#include "client/frame_snapshot.h"
 #include "common/desktop_session_constants.h"
 
+#include <chrono>
+
 namespace client {
 
 namespace {
 
+// How often the measured video delivery rate is reported back to the host.
+constexpr std::chrono::seconds kBandwidthReportInterval{ 1 };
+
+// The host streams the system info one category at a time. A category is replaced as a whole
+// instead of using protobuf merge semantics: a category message always arrives complete, and
+// merging would append duplicates to repeated fields (memory modules, drives, adapters).
+void mergeSystemInfo(proto::SystemInfo* target, const proto::SystemInfo& source)
+{
+    if (source.has_computer())
+        *target->mutable_computer() = source.computer();
+    if (source.has_operating_system())
+        *target->mutable_operating_system() = source.operating_system();
+    if (source.has_processor())
+        *target->mutable_processor() = source.processor();
+    if (source.has_bios())
+        *target->mutable_bios() = source.bios();
+    if (source.has_motherboard())
+        *target->mutable_motherboard() = source.motherboard();
+    if (source.has_memory())
+        *target->mutable_memory() = source.memory();
+    if (source.has_logical_drives())
+        *target->mutable_logical_drives() = source.logical_drives();
+    if (source.has_printers())
+        *target->mutable_printers() = source.printers();
+    if (source.has_network_adapters())
+        *target->mutable_network_adapters() = source.network_adapters();
+}
+
 int calculateFps(int last_fps, const std::chrono::milliseconds& duration, int64_t count)
 {
     static const double kAlpha = 0.1;
@@ -63,6 +96,11 @@ ClientDesktop::ClientDesktop(std::shared_ptr<base::TaskRunner> io_task_runner)
 ClientDesktop::~ClientDesktop()
 {
     desktop_control_proxy_->dettach();
+
+    // Keep the last decoded frame for the next connection to this host; after a reconnect it
+    // is shown immediately while the first key frame is still in flight.
+    if (desktop_frame_)
+        saveFrameSnapshot(frameSnapshotPath(config().address_or_id), *desktop_frame_);
 }
 
 void ClientDesktop::setDesktopWindow(std::shared_ptr<DesktopWindowProxy> desktop_window_proxy)
@@ -80,8 +118,55 @@ void ClientDesktop::onSessionStarted(const base::Version& peer_version)
     input_event_filter_.setSessionType(sessionType());
     desktop_window_proxy_->showWindow(desktop_control_proxy_, peer_version);
 
+    // Most reconnects are short network blips with an unchanged screen. Show the frame stored
+    // by the previous session right away instead of a black window; the first key frame
+    // replaces it as soon as it arrives.
+    base::Size snapshot_size;
+    base::ByteArray snapshot_pixels;
+
+    if (loadFrameSnapshot(frameSnapshotPath(config().address_or_id),
+                          &snapshot_size, &snapshot_pixels))
+    {
+        std::shared_ptr<base::Frame> frame = desktop_window_proxy_->allocateFrame(snapshot_size);
+        if (frame)
+        {
+            frame->copyPixelsFrom(snapshot_pixels.data(),
+                                  snapshot_size.width() * base::Frame::kBytesPerPixel,
+                                  base::Rect::makeSize(snapshot_size));
+
+            desktop_window_proxy_->setFrame(snapshot_size, frame);
+
+            DesktopWindow::FrameTiming timing;
+            timing.receive_time = std::chrono::steady_clock::now();
+
+            // An empty region redraws the whole frame.
+            desktop_window_proxy_->drawFrame(base::Region(), timing);
+        }
+    }
+
     clipboard_monitor_ = std::make_unique<common::ClipboardMonitor>();
     clipboard_monitor_->start(ioTaskRunner(), this);
+
+    // Chunked clipboard transfers and video arrive on their own streams.
+    setStreamListener(common::kClipboardStreamId, this);
+    setStreamListener(common::kVideoStreamId, this);
+
+    // Outgoing clipboard chunks are bulk: input events go ahead of a large copy.
+    setStreamClass(common::kClipboardStreamId, base::NetworkChannel::StreamClass::BULK);
+
+    // Start the sampled frame hash audit: the host sends a hash of the encoded data with an
+    // occasional video packet and readVideoPacket() verifies it against the bytes actually
+    // decoded and rendered. Hosts without the extension ignore the request.
+    proto::FrameHash frame_hash;
+    frame_hash.set_enable(true);
+
+    outgoing_message_.Clear();
+
+    proto::DesktopExtension* extension = outgoing_message_.mutable_extension();
+    extension->set_name(common::kFrameHashExtension);
+    extension->set_data(frame_hash.SerializeAsString());
+
+    sendMessage(outgoing_message_);
 }
 
 void ClientDesktop::onMessageReceived(const base::ByteArray& buffer)
@@ -97,7 +182,21 @@ void ClientDesktop::onMessageReceived(const base::ByteArray& buffer)
     if (incoming_message_.has_video_packet() || incoming_message_.has_cursor_shape())
     {
         if (incoming_message_.has_video_packet())
+        {
+            // An audited frame carries the hash of its encoded data in the same message; it is
+            // checked after the frame has been decoded and handed to the renderer.
+            pending_frame_hash_.clear();
+
+            if (incoming_message_.has_extension() &&
+                incoming_message_.extension().name() == common::kFrameHashExtension)
+            {
+                proto::FrameHash frame_hash;
+                if (frame_hash.ParseFromString(incoming_message_.extension().data()))
+                    pending_frame_hash_ = base::fromStdString(frame_hash.hash());
+            }
+
             readVideoPacket(incoming_message_.video_packet());
+        }
 
         if (incoming_message_.has_cursor_shape())
             readCursorShape(incoming_message_.cursor_shape());
@@ -130,12 +229,42 @@ void ClientDesktop::onMessageWritten(size_t /* pending */)
     // Nothing
 }
 
+void ClientDesktop::onStreamMessageReceived(uint8_t stream_id, const base::ByteArray& buffer)
+{
+    if (stream_id == common::kVideoStreamId)
+    {
+        // The video stream carries regular host messages, just scheduled as bulk.
+        onMessageReceived(buffer);
+        return;
+    }
+
+    DCHECK_EQ(stream_id, common::kClipboardStreamId);
+
+    incoming_clipboard_event_.Clear();
+
+    if (!incoming_clipboard_event_.ParseFromArray(buffer.data(), buffer.size()))
+    {
+        LOG(LS_ERROR) << "Invalid clipboard chunk from host";
+        return;
+    }
+
+    readClipboardEvent(incoming_clipboard_event_);
+}
+
 void ClientDesktop::onClipboardEvent(const proto::ClipboardEvent& event)
 {
     std::optional<proto::ClipboardEvent> out_event = input_event_filter_.sendClipboardEvent(event);
     if (!out_event.has_value())
         return;
 
+    if (out_event->total_size() != 0)
+    {
+        // Chunks of a large payload travel on the clipboard stream, scheduled round-robin with
+        // the default stream, so a big copy does not stall video and input.
+        sendMessage(common::kClipboardStreamId, out_event.value());
+        return;
+    }
+
     outgoing_message_.Clear();
     outgoing_message_.mutable_clipboard_event()->CopyFrom(out_event.value());
     sendMessage(outgoing_message_);
@@ -201,6 +330,44 @@ void ClientDesktop::setPreferredSize(int width, int height)
     sendMessage(outgoing_message_);
 }
 
+void ClientDesktop::setVideoProfile(const proto::VideoProfile& video_profile)
+{
+    LOG(LS_INFO) << "Video profile changed (max_fps:" << video_profile.max_fps()
+                 << " max_bitrate_kbps:" << video_profile.max_bitrate_kbps()
+                 << " cpu_used:" << video_profile.cpu_used() << ")";
+
+    outgoing_message_.Clear();
+
+    proto::DesktopExtension* extension = outgoing_message_.mutable_extension();
+
+    extension->set_name(common::kVideoProfileExtension);
+    extension->set_data(video_profile.SerializeAsString());
+
+    sendMessage(outgoing_message_);
+}
+
+void ClientDesktop::setViewerVisible(bool visible)
+{
+    if (viewer_visible_ == visible)
+        return;
+
+    viewer_visible_ = visible;
+
+    LOG(LS_INFO) << "Viewer window is now " << (visible ? "visible" : "hidden");
+
+    proto::ViewerState viewer_state;
+    viewer_state.set_visible(visible);
+
+    outgoing_message_.Clear();
+
+    proto::DesktopExtension* extension = outgoing_message_.mutable_extension();
+
+    extension->set_name(common::kViewerStateExtension);
+    extension->set_data(viewer_state.SerializeAsString());
+
+    sendMessage(outgoing_message_);
+}
+
 void ClientDesktop::onKeyEvent(const proto::KeyEvent& event)
 {
     std::optional<proto::KeyEvent> out_event = input_event_filter_.keyEvent(event);
@@ -219,8 +386,48 @@ void ClientDesktop::onMouseEvent(const proto::MouseEvent& event)
     if (!out_event.has_value())
         return;
 
+    if (out_event->mask() != last_mouse_mask_ ||
+        mouse_event_delay_ == std::chrono::milliseconds::zero())
+    {
+        // Button and wheel changes must keep their place in the stream, so a pending movement
+        // goes out first and the event itself is sent without delay.
+        last_mouse_mask_ = out_event->mask();
+        sendPendingMouseEvent();
+
+        outgoing_message_.Clear();
+        outgoing_message_.mutable_mouse_event()->CopyFrom(out_event.value());
+
+        sendMessage(outgoing_message_);
+        return;
+    }
+
+    // A pure movement. Within the delay window only the latest position is sent, which cuts the
+    // message volume of drags by an order of magnitude.
+    pending_mouse_event_ = std::move(out_event.value());
+    has_pending_mouse_event_ = true;
+
+    if (!mouse_event_timer_)
+    {
+        mouse_event_timer_ = std::make_unique<base::WaitableTimer>(
+            base::WaitableTimer::Type::SINGLE_SHOT, ioTaskRunner());
+    }
+
+    if (!mouse_event_timer_->isActive())
+    {
+        mouse_event_timer_->start(mouse_event_delay_,
+                                  std::bind(&ClientDesktop::sendPendingMouseEvent, this));
+    }
+}
+
+void ClientDesktop::sendPendingMouseEvent()
+{
+    if (!has_pending_mouse_event_)
+        return;
+
+    has_pending_mouse_event_ = false;
+
     outgoing_message_.Clear();
-    outgoing_message_.mutable_mouse_event()->CopyFrom(out_event.value());
+    outgoing_message_.mutable_mouse_event()->CopyFrom(pending_mouse_event_);
 
     sendMessage(outgoing_message_);
 }
@@ -288,6 +495,16 @@ void ClientDesktop::onMetricsRequest()
     metrics.max_audio_packet = max_audio_packet_;
     metrics.avg_audio_packet = avg_audio_packet_;
     metrics.fps = fps_;
+    metrics.host_capture_interval_us = pipeline_stats_.capture_interval_avg_us();
+    metrics.host_scale_us = pipeline_stats_.scale_avg_us();
+    metrics.host_encode_avg_us = pipeline_stats_.encode_avg_us();
+    metrics.host_encode_max_us = pipeline_stats_.encode_max_us();
+    metrics.host_send_us = pipeline_stats_.send_avg_us();
+    metrics.host_network_write_us = pipeline_stats_.network_write_avg_us();
+    metrics.host_pending_messages = pipeline_stats_.pending_messages();
+    metrics.host_network_queue_depth_max = pipeline_stats_.network_queue_depth_max();
+    metrics.host_network_queue_age_us = pipeline_stats_.network_queue_age_us();
+    metrics.host_ipc_queue_depth_max = pipeline_stats_.ipc_queue_depth_max();
     metrics.send_mouse = input_event_filter_.sendMouseCount();
     metrics.drop_mouse = input_event_filter_.dropMouseCount();
     metrics.send_key   = input_event_filter_.sendKeyCount();
@@ -295,6 +512,12 @@ void ClientDesktop::onMetricsRequest()
     metrics.send_clipboard = input_event_filter_.sendClipboardCount();
 
     desktop_window_proxy_->setMetrics(metrics);
+
+    // Ask the host for its pipeline timings. The reply updates |pipeline_stats_| and is shown
+    // at the next metrics update. Hosts without the extension simply never reply.
+    outgoing_message_.Clear();
+    outgoing_message_.mutable_extension()->set_name(common::kPipelineStatsExtension);
+    sendMessage(outgoing_message_);
 }
 
 void ClientDesktop::readConfigRequest(const proto::DesktopConfigRequest& config_request)
@@ -323,6 +546,10 @@ void ClientDesktop::readConfigRequest(const proto::DesktopConfigRequest& config_
 
 void ClientDesktop::readVideoPacket(const proto::VideoPacket& packet)
 {
+    DesktopWindow::FrameTiming timing;
+    timing.receive_time = std::chrono::steady_clock::now();
+    timing.host_latency_us = packet.host_latency_us();
+
     if (video_encoding_ != packet.encoding())
     {
         video_decoder_ = base::VideoDecoder::create(packet.encoding());
@@ -381,9 +608,25 @@ void ClientDesktop::readVideoPacket(const proto::VideoPacket& packet)
     if (!video_decoder_->decode(packet, desktop_frame_.get()))
     {
         LOG(LS_ERROR) << "The video packet could not be decoded";
+
+        // Ask the host for a key frame; the stream recovers with the next frame instead of
+        // requiring a reconnect. Hosts without the extension simply keep the old behavior.
+        proto::VideoRecovery video_recovery;
+        video_recovery.set_action(proto::VideoRecovery::ACTION_KEY_FRAME);
+
+        outgoing_message_.Clear();
+
+        proto::DesktopExtension* extension = outgoing_message_.mutable_extension();
+        extension->set_name(common::kVideoRecoveryExtension);
+        extension->set_data(video_recovery.SerializeAsString());
+
+        sendMessage(outgoing_message_);
         return;
     }
 
+    timing.decode_us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - timing.receive_time).count());
+
     ++video_frame_count_;
 
     size_t packet_size = packet.ByteSizeLong();
@@ -392,7 +635,60 @@ void ClientDesktop::readVideoPacket(const proto::VideoPacket& packet)
     min_video_packet_ = std::min(min_video_packet_, packet_size);
     max_video_packet_ = std::max(max_video_packet_, packet_size);
 
-    desktop_window_proxy_->drawFrame();
+    // Measure the rate at which video actually arrives and report it back to the host, where
+    // it steers the encoder target bitrate. Hosts without the extension ignore the report.
+    delivery_rate_.addMessage(packet_size, timing.receive_time);
+
+    if (timing.receive_time - last_bandwidth_report_ >= kBandwidthReportInterval)
+    {
+        last_bandwidth_report_ = timing.receive_time;
+
+        const int bandwidth_kbps = delivery_rate_.bandwidthKbps();
+        if (bandwidth_kbps > 0)
+        {
+            proto::BandwidthEstimate bandwidth_estimate;
+            bandwidth_estimate.set_bandwidth_kbps(static_cast<uint64_t>(bandwidth_kbps));
+
+            outgoing_message_.Clear();
+
+            proto::DesktopExtension* extension = outgoing_message_.mutable_extension();
+            extension->set_name(common::kBandwidthEstimateExtension);
+            extension->set_data(bandwidth_estimate.SerializeAsString());
+
+            sendMessage(outgoing_message_);
+        }
+    }
+
+    // Take the region changed by this packet out of the frame, so the UI repaints only the
+    // damaged part. The frame buffer itself is shared with the UI thread; the region travels
+    // with the draw request to avoid touching it from two threads.
+    base::Region updated_region;
+    updated_region.swap(desktop_frame_->updatedRegion());
+
+    desktop_window_proxy_->drawFrame(updated_region, timing);
+
+    if (!pending_frame_hash_.empty())
+    {
+        // Sampled end-to-end audit: prove that the frame just handed to the renderer was
+        // produced from exactly the bytes the host encoded (see kFrameHashExtension).
+        const base::ByteArray hash =
+            base::GenericHash::hash(base::GenericHash::BLAKE2s256, packet.data());
+
+        ++frame_hash_checked_count_;
+
+        if (hash != pending_frame_hash_)
+        {
+            ++frame_hash_mismatch_count_;
+
+            LOG(LS_ERROR) << "Frame hash mismatch (frame:" << video_frame_count_
+                          << " expected:" << base::toHex(pending_frame_hash_)
+                          << " actual:" << base::toHex(hash)
+                          << " mismatches:" << frame_hash_mismatch_count_
+                          << " checked:" << frame_hash_checked_count_ << ")";
+        }
+
+        pending_frame_hash_.clear();
+    }
 }
 
 void ClientDesktop::readAudioPacket(const proto::AudioPacket& packet)
@@ -492,7 +788,18 @@ void ClientDesktop::readExtension(const proto::DesktopExtension& extension)
             return;
         }
 
-        desktop_window_proxy_->setSystemInfo(system_info);
+        // Categories arrive as separate partial messages; the window is repopulated from the
+        // union collected so far, so it fills up incrementally.
+        mergeSystemInfo(&system_info_, system_info);
+        desktop_window_proxy_->setSystemInfo(system_info_);
+    }
+    else if (extension.name() == common::kPipelineStatsExtension)
+    {
+        if (!pipeline_stats_.ParseFromString(extension.data()))
+        {
+            LOG(LS_ERROR) << "Unable to parse pipeline stats extension data";
+            return;
+        }
     }
     else
     {
@@ -20,6 +20,8 @@
 #define CLIENT__CLIENT_DESKTOP_H
 
 #include "base/macros_magic.h"
+#include "base/waitable_timer.h"
+#include "base/codec/delivery_rate_estimator.h"
 #include "client/client.h"
 #include "client/desktop_control.h"
 #include "client/input_event_filter.h"
@@ -42,7 +44,8 @@ class DesktopWindowProxy;
 class ClientDesktop
     : public Client,
       public DesktopControl,
-      public common::Clipboard::Delegate
+      public common::Clipboard::Delegate,
+      public base::NetworkChannel::StreamListener
 {
 public:
     explicit ClientDesktop(std::shared_ptr<base::TaskRunner> io_task_runner);
@@ -54,6 +57,8 @@ public:
     void setDesktopConfig(const proto::DesktopConfig& config) override;
     void setCurrentScreen(const proto::Screen& screen) override;
     void setPreferredSize(int width, int height) override;
+    void setVideoProfile(const proto::VideoProfile& video_profile) override;
+    void setViewerVisible(bool visible) override;
     void onKeyEvent(const proto::KeyEvent& event) override;
     void onMouseEvent(const proto::MouseEvent& event) override;
     void onPowerControl(proto::PowerControl::Action action) override;
@@ -69,6 +74,10 @@ protected:
     void onMessageReceived(const base::ByteArray& buffer) override;
     void onMessageWritten(size_t pending) override;
 
+    // base::NetworkChannel::StreamListener implementation. Receives chunked clipboard transfers
+    // from the host off the default stream.
+    void onStreamMessageReceived(uint8_t stream_id, const base::ByteArray& buffer) override;
+
     // common::Clipboard::Delegate implementation.
     void onClipboardEvent(const proto::ClipboardEvent& event) override;
 
@@ -79,9 +88,14 @@ private:
     void readCursorShape(const proto::CursorShape& cursor_shape);
     void readClipboardEvent(const proto::ClipboardEvent& event);
     void readExtension(const proto::DesktopExtension& extension);
+    void sendPendingMouseEvent();
 
     bool started_ = false;
 
+    // Last viewer visibility reported to the host; repeated window state events with the same
+    // visibility are not resent.
+    bool viewer_visible_ = true;
+
     std::shared_ptr<DesktopControlProxy> desktop_control_proxy_;
     std::shared_ptr<DesktopWindowProxy> desktop_window_proxy_;
     std::shared_ptr<base::Frame> desktop_frame_;
@@ -91,6 +105,10 @@ private:
     proto::HostToClient incoming_message_;
     proto::ClientToHost outgoing_message_;
 
+    // Reused for clipboard stream chunks; keeping the message around retains the string
+    // capacity of the previous chunk, so a large transfer does not allocate per chunk.
+    proto::ClipboardEvent incoming_clipboard_event_;
+
     proto::VideoEncoding video_encoding_ = proto::VIDEO_ENCODING_UNKNOWN;
     proto::AudioEncoding audio_encoding_ = proto::AUDIO_ENCODING_UNKNOWN;
 
@@ -101,12 +119,40 @@ private:
 
     InputEventFilter input_event_filter_;
 
+    // Coalescing of mouse movements. Within the delay window only the latest position is kept;
+    // events that change the button or wheel state are never delayed. A zero delay disables
+    // coalescing.
+    std::chrono::milliseconds mouse_event_delay_{ 15 };
+    std::unique_ptr<base::WaitableTimer> mouse_event_timer_;
+    proto::MouseEvent pending_mouse_event_;
+    bool has_pending_mouse_event_ = false;
+    uint32_t last_mouse_mask_ = 0;
+
     using Clock = std::chrono::high_resolution_clock;
     using TimePoint = std::chrono::time_point<Clock>;
 
     TimePoint start_time_;
     TimePoint begin_time_;
     int64_t video_frame_count_ = 0;
+
+    // Sampled frame hash audit (see kFrameHashExtension). The hash of an audited frame arrives
+    // in the same message as its video packet; it is held here while the packet is decoded and
+    // checked once the frame has been handed to the renderer.
+    base::ByteArray pending_frame_hash_;
+    uint64_t frame_hash_checked_count_ = 0;
+    uint64_t frame_hash_mismatch_count_ = 0;
+
+    // Delivery rate of the incoming video stream as seen by this client. Periodically reported
+    // back to the host, where it steers the encoder target bitrate.
+    base::DeliveryRateEstimator delivery_rate_;
+    base::DeliveryRateEstimator::TimePoint last_bandwidth_report_;
+
+    // Union of the partial system info messages streamed by the host; each incoming category
+    // replaces its previous version here before the window is repopulated.
+    proto::SystemInfo system_info_;
+
+    // Last host-side pipeline timings received through the pipeline stats extension.
+    proto::PipelineStats pipeline_stats_;
     size_t min_video_packet_ = std::numeric_limits<size_t>::max();
     size_t max_video_packet_ = 0;
     size_t avg_video_packet_ = 0;
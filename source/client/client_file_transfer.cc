@@ -89,9 +89,6 @@ void ClientFileTransfer::onMessageReceived(const base::ByteArray& buffer)
 
         // Remove the request from the queue.
         remote_task_queue_.pop();
-
-        // Execute the next request.
-        doNextRemoteTask();
     }
     else
     {
@@ -116,8 +113,34 @@ void ClientFileTransfer::onTaskDone(std::shared_ptr<common::FileTask> task)
     }
     else if (request.has_file_list_request())
     {
+        PendingFileList* pending_list = pendingFileList(task->target());
+
+        // A new listing may have been started while chunks of the previous one were still in
+        // flight.
+        if (request.file_list_request().path() != pending_list->path)
+            return;
+
+        if (reply.error_code() != proto::FILE_ERROR_SUCCESS)
+        {
+            pending_list->file_list.Clear();
+            file_manager_window_proxy_->onFileList(
+                task->target(), reply.error_code(), pending_list->file_list);
+            return;
+        }
+
+        pending_list->file_list.mutable_item()->MergeFrom(reply.file_list().item());
+
+        if (reply.file_list().flags() & proto::FileList::MORE_CHUNKS)
+        {
+            // Request the next chunk of the directory.
+            task_consumer_proxy_->doTask(taskFactory(task->target())->fileList(
+                pending_list->path, proto::FileListRequest::NO_FLAGS));
+            return;
+        }
+
         file_manager_window_proxy_->onFileList(
-            task->target(), reply.error_code(), reply.file_list());
+            task->target(), reply.error_code(), pending_list->file_list);
+        pending_list->file_list.Clear();
     }
     else if (request.has_create_directory_request())
     {
@@ -141,26 +164,15 @@ void ClientFileTransfer::doTask(std::shared_ptr<common::FileTask> task)
     }
     else
     {
-        const bool schedule = remote_task_queue_.empty();
+        // Add the request to the queue. The host processes requests sequentially and replies in
+        // the order of the requests, so several requests can be in flight at the same time.
+        remote_task_queue_.emplace(task);
 
-        // Add the request to the queue.
-        remote_task_queue_.emplace(std::move(task));
-
-        // If the request queue was empty, then run execution.
-        if (schedule)
-            doNextRemoteTask();
+        // Send a request to the remote computer.
+        sendMessage(task->request());
     }
 }
 
-void ClientFileTransfer::doNextRemoteTask()
-{
-    if (remote_task_queue_.empty())
-        return;
-
-    // Send a request to the remote computer.
-    sendMessage(remote_task_queue_.front()->request());
-}
-
 common::FileTaskFactory* ClientFileTransfer::taskFactory(common::FileTask::Target target)
 {
     common::FileTaskFactory* task_factory;
@@ -179,6 +191,16 @@ common::FileTaskFactory* ClientFileTransfer::taskFactory(common::FileTask::Targe
     return task_factory;
 }
 
+ClientFileTransfer::PendingFileList* ClientFileTransfer::pendingFileList(
+    common::FileTask::Target target)
+{
+    if (target == common::FileTask::Target::LOCAL)
+        return &local_file_list_;
+
+    DCHECK_EQ(target, common::FileTask::Target::REMOTE);
+    return &remote_file_list_;
+}
+
 void ClientFileTransfer::driveList(common::FileTask::Target target)
 {
     task_consumer_proxy_->doTask(taskFactory(target)->driveList());
@@ -186,7 +208,12 @@ void ClientFileTransfer::driveList(common::FileTask::Target target)
 
 void ClientFileTransfer::fileList(common::FileTask::Target target, const std::string& path)
 {
-    task_consumer_proxy_->doTask(taskFactory(target)->fileList(path));
+    PendingFileList* pending_list = pendingFileList(target);
+    pending_list->path = path;
+    pending_list->file_list.Clear();
+
+    task_consumer_proxy_->doTask(
+        taskFactory(target)->fileList(path, proto::FileListRequest::START));
 }
 
 void ClientFileTransfer::createDirectory(common::FileTask::Target target, const std::string& path)
@@ -67,9 +67,17 @@ protected:
     void onTaskDone(std::shared_ptr<common::FileTask> task) override;
 
 private:
-    void doNextRemoteTask();
+    // Accumulates the chunks of a directory listing until the last one arrives.
+    struct PendingFileList
+    {
+        // Directory currently being listed. Late chunks of an abandoned listing carry another
+        // path and are dropped.
+        std::string path;
+        proto::FileList file_list;
+    };
 
     common::FileTaskFactory* taskFactory(common::FileTask::Target target);
+    PendingFileList* pendingFileList(common::FileTask::Target target);
 
     // FileControl implementation.
     void driveList(common::FileTask::Target target) override;
@@ -93,6 +101,9 @@ private:
     std::unique_ptr<common::FileTaskFactory> local_task_factory_;
     std::unique_ptr<common::FileTaskFactory> remote_task_factory_;
 
+    PendingFileList local_file_list_;
+    PendingFileList remote_file_list_;
+
     std::queue<std::shared_ptr<common::FileTask>> remote_task_queue_;
     std::unique_ptr<common::FileWorker> local_worker_;
 
@@ -30,7 +30,7 @@ public:
     Impl(std::shared_ptr<base::TaskRunner> io_task_runner, std::unique_ptr<Client> client);
     ~Impl();
 
-    void start(const Config& config);
+    void start(const Config& config, std::shared_ptr<PrewarmedConnection> prewarmed);
     void stop();
 
 private:
@@ -53,16 +53,17 @@ ClientProxy::Impl::~Impl()
     DCHECK(!client_);
 }
 
-void ClientProxy::Impl::start(const Config& config)
+void ClientProxy::Impl::start(const Config& config, std::shared_ptr<PrewarmedConnection> prewarmed)
 {
     if (!io_task_runner_->belongsToCurrentThread())
     {
-        io_task_runner_->postTask(std::bind(&Impl::start, shared_from_this(), config));
+        io_task_runner_->postTask(
+            std::bind(&Impl::start, shared_from_this(), config, std::move(prewarmed)));
         return;
     }
 
     if (client_)
-        client_->start(config);
+        client_->start(config, std::move(prewarmed));
 }
 
 void ClientProxy::Impl::stop()
@@ -94,9 +95,9 @@ ClientProxy::~ClientProxy()
     impl_->stop();
 }
 
-void ClientProxy::start()
+void ClientProxy::start(std::shared_ptr<PrewarmedConnection> prewarmed)
 {
-    impl_->start(config_);
+    impl_->start(config_, std::move(prewarmed));
 }
 
 void ClientProxy::stop()
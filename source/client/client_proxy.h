@@ -21,6 +21,7 @@
 
 #include "base/macros_magic.h"
 #include "client/client_config.h"
+#include "client/prewarmed_connection.h"
 
 #include <memory>
 
@@ -40,7 +41,7 @@ public:
                 const Config& config);
     ~ClientProxy();
 
-    void start();
+    void start(std::shared_ptr<PrewarmedConnection> prewarmed = nullptr);
     void stop();
 
     const Config& config() const { return config_; }
@@ -89,6 +89,10 @@ void ConfigFactory::fixupDesktopConfig(proto::DesktopConfig* config)
 
     if (config->audio_encoding() == proto::AUDIO_ENCODING_DEFAULT)
         config->set_audio_encoding(kDefaultAudioEncoding);
+
+    // The cursor decoder of this build understands dictionary-compressed cursors. The host
+    // only sends them when the flag is present, so older hosts and clients interoperate.
+    config->set_flags(config->flags() | proto::CURSOR_DICT);
 }
 
 } // namespace client
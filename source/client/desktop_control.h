@@ -32,6 +32,8 @@ public:
     virtual void setDesktopConfig(const proto::DesktopConfig& desktop_config) = 0;
     virtual void setCurrentScreen(const proto::Screen& screen) = 0;
     virtual void setPreferredSize(int width, int height) = 0;
+    virtual void setVideoProfile(const proto::VideoProfile& video_profile) = 0;
+    virtual void setViewerVisible(bool visible) = 0;
 
     virtual void onKeyEvent(const proto::KeyEvent& event) = 0;
     virtual void onMouseEvent(const proto::MouseEvent& event) = 0;
@@ -83,6 +83,32 @@ void DesktopControlProxy::setPreferredSize(int width, int height)
         desktop_control_->setPreferredSize(width, height);
 }
 
+void DesktopControlProxy::setVideoProfile(const proto::VideoProfile& video_profile)
+{
+    if (!io_task_runner_->belongsToCurrentThread())
+    {
+        io_task_runner_->postTask(std::bind(
+            &DesktopControlProxy::setVideoProfile, shared_from_this(), video_profile));
+        return;
+    }
+
+    if (desktop_control_)
+        desktop_control_->setVideoProfile(video_profile);
+}
+
+void DesktopControlProxy::setViewerVisible(bool visible)
+{
+    if (!io_task_runner_->belongsToCurrentThread())
+    {
+        io_task_runner_->postTask(
+            std::bind(&DesktopControlProxy::setViewerVisible, shared_from_this(), visible));
+        return;
+    }
+
+    if (desktop_control_)
+        desktop_control_->setViewerVisible(visible);
+}
+
 void DesktopControlProxy::onKeyEvent(const proto::KeyEvent& event)
 {
     if (!io_task_runner_->belongsToCurrentThread())
@@ -43,6 +43,8 @@ public:
     void setDesktopConfig(const proto::DesktopConfig& desktop_config);
     void setCurrentScreen(const proto::Screen& screen);
     void setPreferredSize(int width, int height);
+    void setVideoProfile(const proto::VideoProfile& video_profile);
+    void setViewerVisible(bool visible);
     void onKeyEvent(const proto::KeyEvent& event);
     void onMouseEvent(const proto::MouseEvent& event);
     void onPowerControl(proto::PowerControl::Action action);
@@ -26,6 +26,7 @@
 namespace base {
 class Frame;
 class MouseCursor;
+class Region;
 class Size;
 class Version;
 } // namespace base
@@ -60,6 +61,26 @@ public:
         size_t max_audio_packet = 0;
         size_t avg_audio_packet = 0;
         int fps = 0;
+
+        // Host-side pipeline timings delivered through the pipeline stats extension. Zero until
+        // the first reply from the host (or always zero when the host does not support it).
+        uint64_t host_capture_interval_us = 0;
+        uint64_t host_scale_us = 0;
+        uint64_t host_encode_avg_us = 0;
+        uint64_t host_encode_max_us = 0;
+        uint64_t host_send_us = 0;
+        uint64_t host_network_write_us = 0;
+        uint64_t host_pending_messages = 0;
+        uint64_t host_network_queue_depth_max = 0;
+        uint64_t host_network_queue_age_us = 0;
+        uint64_t host_ipc_queue_depth_max = 0;
+
+        // Capture-to-render latency percentiles over the last few hundred frames. Filled by the
+        // window implementation from the per-frame timings; zero until enough frames arrived.
+        uint64_t frame_latency_p50_us = 0;
+        uint64_t frame_latency_p90_us = 0;
+        uint64_t frame_latency_p99_us = 0;
+
         int send_mouse = 0;
         int drop_mouse = 0;
         int send_key = 0;
@@ -80,7 +101,20 @@ public:
     virtual std::unique_ptr<FrameFactory> frameFactory() = 0;
     virtual void setFrame(const base::Size& screen_size,
                           std::shared_ptr<base::Frame> frame) = 0;
-    virtual void drawFrame() = 0;
+    // Per-packet timing used for the latency overlay and statistics. |host_latency_us| is
+    // measured on the host between capturing the screen and handing the encoded packet to the
+    // network. The clocks of the two machines are not synchronized, so network transit time is
+    // not part of any of the values.
+    struct FrameTiming
+    {
+        uint64_t host_latency_us = 0;
+        uint64_t decode_us = 0;
+        std::chrono::steady_clock::time_point receive_time;
+    };
+
+    // |updated_region| is the part of the frame changed by the last decoded packet. An empty
+    // region means the whole frame must be redrawn.
+    virtual void drawFrame(const base::Region& updated_region, const FrameTiming& timing) = 0;
     virtual void setMouseCursor(std::shared_ptr<base::MouseCursor> mouse_cursor) = 0;
 };
 
@@ -22,6 +22,7 @@
 #include "base/task_runner.h"
 #include "base/version.h"
 #include "base/desktop/geometry.h"
+#include "base/desktop/region.h"
 #include "client/audio_renderer.h"
 #include "client/desktop_control_proxy.h"
 #include "client/desktop_window.h"
@@ -158,16 +159,18 @@ void DesktopWindowProxy::setFrame(
         desktop_window_->setFrame(screen_size, frame);
 }
 
-void DesktopWindowProxy::drawFrame()
+void DesktopWindowProxy::drawFrame(
+    const base::Region& updated_region, const DesktopWindow::FrameTiming& timing)
 {
     if (!ui_task_runner_->belongsToCurrentThread())
     {
-        ui_task_runner_->postTask(std::bind(&DesktopWindowProxy::drawFrame, shared_from_this()));
+        ui_task_runner_->postTask(
+            std::bind(&DesktopWindowProxy::drawFrame, shared_from_this(), updated_region, timing));
         return;
     }
 
     if (desktop_window_)
-        desktop_window_->drawFrame();
+        desktop_window_->drawFrame(updated_region, timing);
 }
 
 void DesktopWindowProxy::setMouseCursor(std::shared_ptr<base::MouseCursor> mouse_cursor)
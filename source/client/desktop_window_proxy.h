@@ -55,7 +55,7 @@ public:
     std::shared_ptr<base::Frame> allocateFrame(const base::Size& size);
     std::unique_ptr<AudioRenderer> audioRenderer();
     void setFrame(const base::Size& screen_size, std::shared_ptr<base::Frame> frame);
-    void drawFrame();
+    void drawFrame(const base::Region& updated_region, const DesktopWindow::FrameTiming& timing);
     void setMouseCursor(std::shared_ptr<base::MouseCursor> mouse_cursor);
 
 private:
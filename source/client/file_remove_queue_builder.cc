@@ -85,6 +85,14 @@ void FileRemoveQueueBuilder::onTaskDone(std::shared_ptr<common::FileTask> task)
         pending_tasks_.emplace_back(std::move(item_path), item.is_directory());
     }
 
+    if (reply.file_list().flags() & proto::FileList::MORE_CHUNKS)
+    {
+        // Request the next chunk of the directory.
+        task_consumer_proxy_->doTask(
+            task_factory_->fileList(path, proto::FileListRequest::NO_FLAGS));
+        return;
+    }
+
     doPendingTasks();
 }
 
@@ -97,7 +105,8 @@ void FileRemoveQueueBuilder::doPendingTasks()
 
         if (tasks_.front().isDirectory())
         {
-            task_consumer_proxy_->doTask(task_factory_->fileList(tasks_.front().path()));
+            task_consumer_proxy_->doTask(task_factory_->fileList(
+                tasks_.front().path(), proto::FileListRequest::START));
             return;
         }
     }
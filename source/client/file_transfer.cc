@@ -31,6 +31,15 @@ namespace client {
 
 namespace {
 
+// Maximum number of file packets in flight (read from the source but not yet confirmed by the
+// target). The window hides the network round-trip time: with 16 kB packets it keeps up to 128 kB
+// on the wire instead of one packet per round trip.
+const int kPacketWindowSize = 8;
+
+// Minimum interval between progress pushes to the UI. On a fast link the percentage changes
+// many times per second; ten updates per second are enough for the eye.
+const std::chrono::milliseconds kProgressReportInterval{ 100 };
+
 struct ActionsMap
 {
     FileTransfer::Error::Type type;
@@ -139,41 +148,58 @@ void FileTransfer::start(const std::string& source_path,
     queue_builder_ = std::make_unique<FileTransferQueueBuilder>(
         task_consumer_proxy_, task_factory_source_->target());
 
-    // Start building a list of objects for transfer.
-    queue_builder_->start(source_path, target_path, items, [this](proto::FileError error_code)
+    // Start building a list of objects for transfer. The transfer starts as soon as the first
+    // tasks are ready and runs while the enumeration continues.
+    queue_builder_->start(source_path, target_path, items,
+                          std::bind(&FileTransfer::onQueueReady, this),
+                          [this](proto::FileError error_code)
     {
         if (error_code == proto::FILE_ERROR_SUCCESS)
         {
-            tasks_ = queue_builder_->takeQueue();
-            total_size_ = queue_builder_->totalSize();
+            onQueueReady();
+            queue_builder_.reset();
 
-            if (tasks_.empty())
-            {
+            // The transfer drained the queue (or it was empty from the beginning) and no more
+            // tasks will come.
+            if (waiting_for_tasks_)
                 onFinished();
-            }
-            else
-            {
-                doFrontTask(false);
-            }
         }
         else
         {
+            queue_builder_.reset();
             onError(Error::Type::QUEUE, proto::FILE_ERROR_UNKNOWN);
         }
-
-        queue_builder_.reset();
     });
 }
 
+void FileTransfer::onQueueReady()
+{
+    for (auto& task : queue_builder_->takeQueue())
+        tasks_.emplace_back(std::move(task));
+
+    total_size_ = queue_builder_->totalSize();
+
+    if (waiting_for_tasks_ && !tasks_.empty())
+    {
+        waiting_for_tasks_ = false;
+        doFrontTask(false);
+    }
+}
+
 void FileTransfer::stop()
 {
-    if (queue_builder_)
+    if (waiting_for_tasks_)
     {
+        // No task is running, it is safe to finish immediately.
         queue_builder_.reset();
         onFinished();
     }
     else
     {
+        // Stop the enumeration if it is still running; the active task is finished through the
+        // normal cancellation flow.
+        queue_builder_.reset();
+
         is_canceled_ = true;
         cancel_timer_.start(std::chrono::seconds(5), std::bind(&FileTransfer::onFinished, this));
     }
@@ -237,6 +263,20 @@ void FileTransfer::targetReply(const proto::FileRequest& request, const proto::F
 
         onError(Error::Type::CREATE_DIRECTORY, reply.error_code(), frontTask().targetPath());
     }
+    else if (request.has_block_checksum_request())
+    {
+        if (reply.error_code() != proto::FILE_ERROR_SUCCESS)
+        {
+            // The old copy can not be read, or the target does not support delta transfers and
+            // replied with an error to the unknown request. Transfer the file in full.
+            task_consumer_proxy_->doTask(
+                task_factory_source_->download(frontTask().sourcePath()));
+            return;
+        }
+
+        task_consumer_proxy_->doTask(task_factory_source_->deltaDownload(
+            frontTask().sourcePath(), reply.block_checksum_list()));
+    }
     else if (request.has_upload_request())
     {
         if (reply.error_code() != proto::FILE_ERROR_SUCCESS)
@@ -250,13 +290,93 @@ void FileTransfer::targetReply(const proto::FileRequest& request, const proto::F
             return;
         }
 
-        task_consumer_proxy_->doTask(
-            task_factory_source_->packetRequest(proto::FilePacketRequest::NO_FLAGS));
+        // The target file is created, start the packet pipeline. All in-flight replies of the
+        // previous task are always consumed before this reply arrives.
+        DCHECK_EQ(pending_packet_requests_, 0);
+        DCHECK_EQ(pending_packets_, 0);
+
+        source_exhausted_ = false;
+        packet_error_ = false;
+        compress_packets_ =
+            (reply.capabilities() & proto::FileReply::COMPRESSED_PACKETS) != 0;
+        sparse_packets_ =
+            (reply.capabilities() & proto::FileReply::SPARSE_PACKETS) != 0;
+
+        requestNextPackets();
+    }
+    else if (request.has_write_batch_request())
+    {
+        if (reply.error_code() == proto::FILE_ERROR_INVALID_REQUEST)
+        {
+            // The target does not know batch requests. Transfer the files one by one.
+            batch_supported_ = false;
+            doFrontTask(false);
+            return;
+        }
+
+        if (reply.error_code() != proto::FILE_ERROR_SUCCESS)
+        {
+            onError(Error::Type::CREATE_FILE, reply.error_code(), frontTask().targetPath());
+            return;
+        }
+
+        // Writing stops at the first failing file; everything before it is complete.
+        proto::FileError item_error = proto::FILE_ERROR_SUCCESS;
+        int completed = 0;
+
+        for (int i = 0; i < reply.batch().item_size(); ++i)
+        {
+            const proto::FileBatch::Item& item = reply.batch().item(i);
+            if (item.error_code() != proto::FILE_ERROR_SUCCESS)
+            {
+                item_error = item.error_code();
+                break;
+            }
+
+            ++completed;
+        }
+
+        for (int i = 0; i < completed && !tasks_.empty(); ++i)
+        {
+            total_transfered_size_ += frontTask().size();
+            tasks_.pop_front();
+        }
+
+        if (total_size_)
+        {
+            const int total_percentage =
+                static_cast<int>(total_transfered_size_ * 100 / total_size_);
+
+            const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            if (total_percentage != total_percentage_ &&
+                now - last_progress_report_ >= kProgressReportInterval)
+            {
+                total_percentage_ = total_percentage;
+                last_progress_report_ = now;
+                transfer_window_proxy_->setCurrentProgress(total_percentage_, 100);
+            }
+        }
+
+        if (item_error != proto::FILE_ERROR_SUCCESS)
+        {
+            // The failing file is now at the front of the queue; the per-file path reports the
+            // error with the usual set of actions (and can replace an existing file).
+            skip_batch_for_front_ = true;
+        }
+
+        continueQueue();
     }
     else if (request.has_packet())
     {
+        DCHECK_GT(pending_packets_, 0);
+        --pending_packets_;
+
+        if (packet_error_)
+            return;
+
         if (reply.error_code() != proto::FILE_ERROR_SUCCESS)
         {
+            packet_error_ = true;
             onError(Error::Type::WRITE_FILE, reply.error_code(), frontTask().targetPath());
             return;
         }
@@ -286,21 +406,40 @@ void FileTransfer::targetReply(const proto::FileRequest& request, const proto::F
                 task_percentage_ = task_percentage;
                 total_percentage_ = total_percentage;
 
-                transfer_window_proxy_->setCurrentProgress(total_percentage_, task_percentage_);
+                // The end of a task is always reported, so the bar does not stop short of its
+                // final value between files.
+                const std::chrono::steady_clock::time_point now =
+                    std::chrono::steady_clock::now();
+                if (now - last_progress_report_ >= kProgressReportInterval ||
+                    task_percentage_ == 100)
+                {
+                    last_progress_report_ = now;
+                    transfer_window_proxy_->setCurrentProgress(
+                        total_percentage_, task_percentage_);
+                }
             }
         }
 
         if (request.packet().flags() & proto::FilePacket::LAST_PACKET)
         {
+            // Replies arrive in the order of the packets, so the last packet is confirmed only
+            // after all previous ones.
+            DCHECK_EQ(pending_packets_, 0);
+            DCHECK_EQ(pending_packet_requests_, 0);
+
+            // Blocks skipped by a delta transfer are never acknowledged; account for them now,
+            // so that the progress reaches 100 percent.
+            if (full_task_size && total_size_ && task_transfered_size_ < full_task_size)
+            {
+                total_transfered_size_ += full_task_size - task_transfered_size_;
+                task_transfered_size_ = full_task_size;
+            }
+
             doNextTask();
             return;
         }
 
-        uint32_t flags = proto::FilePacketRequest::NO_FLAGS;
-        if (is_canceled_)
-            flags = proto::FilePacketRequest::CANCEL;
-
-        task_consumer_proxy_->doTask(task_factory_source_->packetRequest(flags));
+        requestNextPackets();
     }
     else
     {
@@ -326,15 +465,92 @@ void FileTransfer::sourceReply(const proto::FileRequest& request, const proto::F
         task_consumer_proxy_->doTask(
             task_factory_target_->upload(front_task.targetPath(), front_task.overwrite()));
     }
+    else if (request.has_delta_download_request())
+    {
+        Task& front_task = frontTask();
+
+        if (reply.error_code() == proto::FILE_ERROR_INVALID_REQUEST)
+        {
+            // The source does not support delta transfers. Transfer the file in full.
+            task_consumer_proxy_->doTask(
+                task_factory_source_->download(front_task.sourcePath()));
+            return;
+        }
+
+        if (reply.error_code() != proto::FILE_ERROR_SUCCESS)
+        {
+            onError(Error::Type::OPEN_FILE, reply.error_code(), front_task.sourcePath());
+            return;
+        }
+
+        task_consumer_proxy_->doTask(
+            task_factory_target_->deltaUpload(front_task.targetPath()));
+    }
+    else if (request.has_read_batch_request())
+    {
+        if (reply.error_code() == proto::FILE_ERROR_INVALID_REQUEST)
+        {
+            // The source does not know batch requests. Transfer the files one by one.
+            batch_supported_ = false;
+            doFrontTask(false);
+            return;
+        }
+
+        if (reply.error_code() != proto::FILE_ERROR_SUCCESS)
+        {
+            onError(Error::Type::OPEN_FILE, reply.error_code(), frontTask().sourcePath());
+            return;
+        }
+
+        // Forward the files that could be read. Reading stops at the first failing file; it
+        // and everything after it stay in the queue.
+        proto::FileBatch write_batch;
+
+        for (int i = 0; i < reply.batch().item_size(); ++i)
+        {
+            const proto::FileBatch::Item& item = reply.batch().item(i);
+            if (item.error_code() != proto::FILE_ERROR_SUCCESS)
+                break;
+
+            DCHECK_LT(static_cast<size_t>(i), tasks_.size());
+
+            proto::FileBatch::Item* write_item = write_batch.add_item();
+            write_item->set_path(tasks_[i].targetPath());
+            write_item->set_data(item.data());
+        }
+
+        if (write_batch.item_size() == 0)
+        {
+            // The very first file could not be read; the per-file path reports the error.
+            skip_batch_for_front_ = true;
+            doFrontTask(false);
+            return;
+        }
+
+        task_consumer_proxy_->doTask(task_factory_target_->writeBatch(write_batch));
+    }
     else if (request.has_packet_request())
     {
+        DCHECK_GT(pending_packet_requests_, 0);
+        --pending_packet_requests_;
+
+        if (packet_error_)
+            return;
+
         if (reply.error_code() != proto::FILE_ERROR_SUCCESS)
         {
+            packet_error_ = true;
             onError(Error::Type::READ_FILE, reply.error_code(), frontTask().sourcePath());
             return;
         }
 
+        if (reply.packet().flags() & proto::FilePacket::LAST_PACKET)
+            source_exhausted_ = true;
+
         task_consumer_proxy_->doTask(task_factory_target_->packet(reply.packet()));
+        ++pending_packets_;
+
+        requestNextPackets();
     }
     else
     {
@@ -342,6 +558,36 @@ void FileTransfer::sourceReply(const proto::FileRequest& request, const proto::F
     }
 }
 
+void FileTransfer::requestNextPackets()
+{
+    if (packet_error_ || source_exhausted_)
+        return;
+
+    if (is_canceled_)
+    {
+        // Let the already requested packets drain, then ask the source to finish the file.
+        if (pending_packet_requests_ == 0 && pending_packets_ == 0)
+        {
+            task_consumer_proxy_->doTask(
+                task_factory_source_->packetRequest(proto::FilePacketRequest::CANCEL));
+            ++pending_packet_requests_;
+        }
+        return;
+    }
+
+    uint32_t flags = proto::FilePacketRequest::NO_FLAGS;
+    if (compress_packets_)
+        flags |= proto::FilePacketRequest::COMPRESS;
+    if (sparse_packets_)
+        flags |= proto::FilePacketRequest::SPARSE;
+
+    while (pending_packet_requests_ + pending_packets_ < kPacketWindowSize)
+    {
+        task_consumer_proxy_->doTask(task_factory_source_->packetRequest(flags));
+        ++pending_packet_requests_;
+    }
+}
+
 void FileTransfer::setAction(Error::Type error_type, Error::Action action)
 {
     switch (action)
@@ -391,7 +637,14 @@ void FileTransfer::doFrontTask(bool overwrite)
         task_consumer_proxy_->doTask(
             task_factory_target_->createDirectory(front_task.targetPath()));
     }
-    else
+    else if (overwrite)
+    {
+        // The target file is being replaced. Ask for the block checksums of the old copy first,
+        // so that the source can skip the blocks that did not change.
+        task_consumer_proxy_->doTask(
+            task_factory_target_->blockChecksum(front_task.targetPath()));
+    }
+    else if (!tryStartBatch())
     {
         task_consumer_proxy_->doTask(
             task_factory_source_->download(front_task.sourcePath()));
@@ -400,20 +653,33 @@ void FileTransfer::doFrontTask(bool overwrite)
 
 void FileTransfer::doNextTask()
 {
-    if (is_canceled_)
-    {
-        while (!tasks_.empty())
-            tasks_.pop_front();
-    }
-
     if (!tasks_.empty())
     {
         // Delete the task only after confirmation of its successful execution.
         tasks_.pop_front();
     }
 
+    continueQueue();
+}
+
+void FileTransfer::continueQueue()
+{
+    if (is_canceled_)
+    {
+        while (!tasks_.empty())
+            tasks_.pop_front();
+    }
+
     if (tasks_.empty())
     {
+        if (queue_builder_ && !is_canceled_)
+        {
+            // The transfer caught up with the directory enumeration. Wait for the next portion
+            // of tasks.
+            waiting_for_tasks_ = true;
+            return;
+        }
+
         if (cancel_timer_.isActive())
             cancel_timer_.stop();
 
@@ -424,6 +690,50 @@ void FileTransfer::doNextTask()
     doFrontTask(false);
 }
 
+bool FileTransfer::tryStartBatch()
+{
+    if (!batch_supported_ || is_canceled_)
+        return false;
+
+    // The front task failed inside a batch before; the per-file path reports its error with
+    // the usual set of actions.
+    if (skip_batch_for_front_)
+    {
+        skip_batch_for_front_ = false;
+        return false;
+    }
+
+    // A pending replace-all or skip-all action changes how existing files are treated. Such
+    // transfers go through the per-file path, which applies the action; a replace also uses
+    // the delta mechanism there.
+    if (actions_.find(Error::Type::ALREADY_EXISTS) != actions_.end())
+        return false;
+
+    std::vector<std::string> paths;
+    int64_t batched_size = 0;
+
+    for (const Task& task : tasks_)
+    {
+        if (task.isDirectory() ||
+            task.size() > static_cast<int64_t>(common::kMaxBatchFileSize))
+        {
+            break;
+        }
+
+        if (batched_size + task.size() > static_cast<int64_t>(common::kMaxBatchSize))
+            break;
+
+        batched_size += task.size();
+        paths.emplace_back(task.sourcePath());
+    }
+
+    if (paths.empty())
+        return false;
+
+    task_consumer_proxy_->doTask(task_factory_source_->readBatch(paths));
+    return true;
+}
+
 void FileTransfer::onError(Error::Type type, proto::FileError code, const std::string& path)
 {
     auto default_action = actions_.find(type);
@@ -24,6 +24,7 @@
 #include "common/file_task_producer.h"
 #include "proto/file_transfer.pb.h"
 
+#include <chrono>
 #include <deque>
 
 namespace base {
@@ -177,8 +178,12 @@ private:
     Task& frontTask();
     void targetReply(const proto::FileRequest& request, const proto::FileReply& reply);
     void sourceReply(const proto::FileRequest& request, const proto::FileReply& reply);
+    void requestNextPackets();
+    void onQueueReady();
     void doFrontTask(bool overwrite);
     void doNextTask();
+    void continueQueue();
+    bool tryStartBatch();
     void onError(Error::Type type, proto::FileError code, const std::string& path = std::string());
     void setActionForErrorType(Error::Type error_type, Error::Action action);
     void onFinished();
@@ -208,8 +213,31 @@ private:
     int total_percentage_ = 0;
     int task_percentage_ = 0;
 
+    // Time of the last progress push to the UI. Progress is reported at a fixed rate instead of
+    // on every confirmed packet, so the hop to the UI thread stays off the data path.
+    std::chrono::steady_clock::time_point last_progress_report_;
+
     bool is_canceled_ = false;
 
+    // The transfer is idle because it caught up with the directory enumeration, which is still
+    // running and will deliver more tasks.
+    bool waiting_for_tasks_ = true;
+
+    // State of the packet pipeline for the current task. Several packets are kept in flight at
+    // the same time, so the transfer rate does not depend on the network round-trip time.
+    int pending_packet_requests_ = 0; // Packet requests sent to the source without a reply yet.
+    int pending_packets_ = 0;         // Packets sent to the target without a reply yet.
+    bool source_exhausted_ = false;   // The last packet of the file has been read.
+    bool packet_error_ = false;       // Replies for in-flight packets are ignored after an error.
+    bool compress_packets_ = false;   // The target announced support for compressed packets.
+    bool sparse_packets_ = false;     // The target announced support for hole packets.
+
+    // State of small-file batching. Runs of consecutive small files at the front of the queue
+    // are read and written through one request pair instead of a round trip per file.
+    bool batch_supported_ = true;       // Cleared when a peer does not know batch requests.
+    bool skip_batch_for_front_ = false; // The front task failed inside a batch; it is retried
+                                        // through the per-file path once.
+
     DISALLOW_COPY_AND_ASSIGN(FileTransfer);
 };
 
@@ -44,10 +44,12 @@ FileTransferQueueBuilder::~FileTransferQueueBuilder()
 void FileTransferQueueBuilder::start(const std::string& source_path,
                                      const std::string& target_path,
                                      const std::vector<FileTransfer::Item>& items,
-                                     const FinishCallback& callback)
+                                     const ReadyCallback& ready_callback,
+                                     const FinishCallback& finish_callback)
 {
-    callback_ = callback;
-    DCHECK(callback_);
+    ready_callback_ = ready_callback;
+    finish_callback_ = finish_callback;
+    DCHECK(finish_callback_);
 
     for (const auto& item : items)
         addPendingTask(source_path, target_path, item.name, item.is_directory, item.size);
@@ -57,7 +59,9 @@ void FileTransferQueueBuilder::start(const std::string& source_path,
 
 FileTransfer::TaskList FileTransferQueueBuilder::takeQueue()
 {
-    return std::move(tasks_);
+    FileTransfer::TaskList tasks;
+    tasks.swap(tasks_);
+    return tasks;
 }
 
 int64_t FileTransferQueueBuilder::totalSize() const
@@ -67,39 +71,89 @@ int64_t FileTransferQueueBuilder::totalSize() const
 
 void FileTransferQueueBuilder::onTaskDone(std::shared_ptr<common::FileTask> task)
 {
-    DCHECK(!tasks_.empty());
-
     const proto::FileRequest& request = task->request();
     const proto::FileReply& reply = task->reply();
 
-    if (!request.has_file_list_request())
+    if (request.has_recursive_file_list_request())
     {
-        onAborted(proto::FILE_ERROR_UNKNOWN);
-        return;
-    }
+        if (reply.error_code() == proto::FILE_ERROR_INVALID_REQUEST &&
+            (request.recursive_file_list_request().flags() & proto::RecursiveFileListRequest::START))
+        {
+            // The peer does not know recursive requests. Fall back to listing every directory
+            // with a separate request.
+            use_recursive_ = false;
+            task_consumer_proxy_->doTask(task_factory_->fileList(
+                walk_source_dir_, proto::FileListRequest::START));
+            return;
+        }
 
-    if (reply.error_code() != proto::FILE_ERROR_SUCCESS)
-    {
-        onAborted(reply.error_code());
-        return;
-    }
+        if (reply.error_code() != proto::FILE_ERROR_SUCCESS)
+        {
+            onAborted(reply.error_code());
+            return;
+        }
 
-    // If we get a list of files, then the last task is a directory.
-    const FileTransfer::Task& last_task = tasks_.back();
-    DCHECK(last_task.isDirectory());
+        // The items of the subtree are already in their final order: the chunks continue each
+        // other and a directory always precedes its content.
+        for (int i = 0; i < reply.recursive_file_list().item_size(); ++i)
+        {
+            const proto::RecursiveFileList::Item& item = reply.recursive_file_list().item(i);
 
-    for (int i = 0; i < reply.file_list().item_size(); ++i)
-    {
-        const proto::FileList::Item& item = reply.file_list().item(i);
+            total_size_ += item.size();
+
+            tasks_.emplace_back(walk_source_dir_ + '/' + item.path(),
+                                walk_target_dir_ + '/' + item.path(),
+                                item.is_directory(),
+                                item.size());
+        }
+
+        if (reply.recursive_file_list().flags() & proto::RecursiveFileList::LAST_CHUNK)
+        {
+            doPendingTasks();
+            return;
+        }
 
-        addPendingTask(last_task.sourcePath(),
-                       last_task.targetPath(),
-                       item.name(),
-                       item.is_directory(),
-                       item.size());
+        // Request the next chunk of the subtree.
+        task_consumer_proxy_->doTask(task_factory_->recursiveFileList(
+            walk_source_dir_, proto::RecursiveFileListRequest::NO_FLAGS));
+
+        notifyReady();
     }
+    else if (request.has_file_list_request())
+    {
+        if (reply.error_code() != proto::FILE_ERROR_SUCCESS)
+        {
+            onAborted(reply.error_code());
+            return;
+        }
 
-    doPendingTasks();
+        for (int i = 0; i < reply.file_list().item_size(); ++i)
+        {
+            const proto::FileList::Item& item = reply.file_list().item(i);
+
+            addPendingTask(walk_source_dir_,
+                           walk_target_dir_,
+                           item.name(),
+                           item.is_directory(),
+                           item.size());
+        }
+
+        if (reply.file_list().flags() & proto::FileList::MORE_CHUNKS)
+        {
+            // Request the next chunk of the directory.
+            task_consumer_proxy_->doTask(task_factory_->fileList(
+                walk_source_dir_, proto::FileListRequest::NO_FLAGS));
+
+            notifyReady();
+            return;
+        }
+
+        doPendingTasks();
+    }
+    else
+    {
+        onAborted(proto::FILE_ERROR_UNKNOWN);
+    }
 }
 
 void FileTransferQueueBuilder::addPendingTask(const std::string& source_dir,
@@ -125,12 +179,33 @@ void FileTransferQueueBuilder::doPendingTasks()
 
         if (tasks_.back().isDirectory())
         {
-            task_consumer_proxy_->doTask(task_factory_->fileList(tasks_.back().sourcePath()));
+            walk_source_dir_ = tasks_.back().sourcePath();
+            walk_target_dir_ = tasks_.back().targetPath();
+
+            if (use_recursive_)
+            {
+                task_consumer_proxy_->doTask(task_factory_->recursiveFileList(
+                    walk_source_dir_, proto::RecursiveFileListRequest::START));
+            }
+            else
+            {
+                task_consumer_proxy_->doTask(task_factory_->fileList(
+                    walk_source_dir_, proto::FileListRequest::START));
+            }
+
+            notifyReady();
             return;
         }
     }
 
-    callback_(proto::FILE_ERROR_SUCCESS);
+    notifyReady();
+    finish_callback_(proto::FILE_ERROR_SUCCESS);
+}
+
+void FileTransferQueueBuilder::notifyReady()
+{
+    if (ready_callback_ && !tasks_.empty())
+        ready_callback_();
 }
 
 void FileTransferQueueBuilder::onAborted(proto::FileError error_code)
@@ -139,7 +214,7 @@ void FileTransferQueueBuilder::onAborted(proto::FileError error_code)
     tasks_.clear();
     total_size_ = 0;
 
-    callback_(error_code);
+    finish_callback_(error_code);
 }
 
 } // namespace client
@@ -32,14 +32,19 @@ public:
         common::FileTask::Target target);
     ~FileTransferQueueBuilder();
 
+    using ReadyCallback = std::function<void()>;
     using FinishCallback = std::function<void(proto::FileError)>;
 
-    // Starts building of the task queue.
+    // Starts building of the task queue. |ready_callback| is called every time new tasks become
+    // available, so the transfer can start while the building is still in progress.
     void start(const std::string& source_path,
                const std::string& target_path,
                const std::vector<FileTransfer::Item>& items,
-               const FinishCallback& callback);
+               const ReadyCallback& ready_callback,
+               const FinishCallback& finish_callback);
 
+    // Takes the tasks that are fully enumerated so far. Can be called while building is still in
+    // progress; the returned tasks are already in their final order.
     FileTransfer::TaskList takeQueue();
     int64_t totalSize() const;
 
@@ -54,13 +59,24 @@ private:
                         bool is_directory,
                         int64_t size);
     void doPendingTasks();
+    void notifyReady();
     void onAborted(proto::FileError error_code);
 
     std::shared_ptr<common::FileTaskConsumerProxy> task_consumer_proxy_;
     std::shared_ptr<common::FileTaskProducerProxy> task_producer_proxy_;
     std::unique_ptr<common::FileTaskFactory> task_factory_;
 
-    FinishCallback callback_;
+    ReadyCallback ready_callback_;
+    FinishCallback finish_callback_;
+
+    // Paths of the directory that is being enumerated now.
+    std::string walk_source_dir_;
+    std::string walk_target_dir_;
+
+    // Whole directory trees are enumerated with one recursive request per chunk. When the peer
+    // does not support recursive requests, the builder falls back to listing every directory
+    // separately.
+    bool use_recursive_ = true;
 
     FileTransfer::TaskList pending_tasks_;
     FileTransfer::TaskList tasks_;
@@ -0,0 +1,222 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "client/frame_snapshot.h"
+
+#include "base/logging.h"
+#include "base/crypto/generic_hash.h"
+#include "base/desktop/frame.h"
+#include "base/files/base_paths.h"
+#include "base/strings/unicode.h"
+
+#include <zstd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <thread>
+
+namespace client {
+
+namespace {
+
+// The file is the header below followed by the zstd-compressed pixel rows.
+struct SnapshotHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    int32_t width;
+    int32_t height;
+};
+
+const uint32_t kSnapshotMagic = 0x53464341;
+const uint32_t kSnapshotVersion = 1;
+
+// The snapshot is written on every disconnect, so compression speed matters more than size.
+const int kCompressLevel = 1;
+
+// Worker threads for the compression of large frames. More workers stop paying off long before
+// the core count on typical hosts, because the frame is split into a fixed number of jobs.
+const int kMaxCompressWorkers = 4;
+
+// Compresses |pixels| into |compressed| and returns the compressed size, or 0 on error. Large
+// frames are compressed with the zstd worker pool when the library supports it; a 4K frame is
+// over 30 MB of pixels and takes noticeable time on one core even at the lowest level.
+size_t compressPixels(const base::ByteArray& pixels, base::ByteArray* compressed)
+{
+    ZSTD_CCtx* context = ZSTD_createCCtx();
+    if (!context)
+        return 0;
+
+    ZSTD_CCtx_setParameter(context, ZSTD_c_compressionLevel, kCompressLevel);
+
+    const int workers = std::min(
+        kMaxCompressWorkers, static_cast<int>(std::thread::hardware_concurrency()));
+    if (workers > 1)
+    {
+        // Fails when libzstd is built without multithread support; the compression then simply
+        // runs on the calling thread.
+        ZSTD_CCtx_setParameter(context, ZSTD_c_nbWorkers, workers);
+    }
+
+    const size_t ret = ZSTD_compress2(context, compressed->data(), compressed->size(),
+                                      pixels.data(), pixels.size());
+    ZSTD_freeCCtx(context);
+
+    if (ZSTD_isError(ret))
+    {
+        LOG(LS_ERROR) << "ZSTD_compress2 failed: " << ZSTD_getErrorName(ret);
+        return 0;
+    }
+
+    return ret;
+}
+
+// 8K at 32bpp. Anything bigger than that is a damaged file.
+const int64_t kMaxPixelBytes = 7680LL * 4320 * base::Frame::kBytesPerPixel;
+
+} // namespace
+
+std::filesystem::path frameSnapshotPath(std::u16string_view address_or_id)
+{
+    if (address_or_id.empty())
+        return std::filesystem::path();
+
+    std::filesystem::path path;
+    if (!base::BasePaths::userAppData(&path))
+        return std::filesystem::path();
+
+    base::ByteArray digest = base::GenericHash::hash(
+        base::GenericHash::SHA256, base::utf8FromUtf16(address_or_id));
+
+    path.append("Aspia/FrameCache");
+    path.append(base::toHex(digest) + ".frame");
+
+    return path;
+}
+
+bool saveFrameSnapshot(const std::filesystem::path& file, const base::Frame& frame)
+{
+    if (file.empty())
+        return false;
+
+    const base::Size& size = frame.size();
+
+    const int64_t row_bytes = static_cast<int64_t>(size.width()) * base::Frame::kBytesPerPixel;
+    const int64_t pixel_bytes = row_bytes * size.height();
+
+    if (pixel_bytes <= 0 || pixel_bytes > kMaxPixelBytes)
+        return false;
+
+    // Pack the rows tightly; the stride of the frame may be wider than the row.
+    base::ByteArray pixels(static_cast<size_t>(pixel_bytes));
+    for (int y = 0; y < size.height(); ++y)
+    {
+        memcpy(pixels.data() + row_bytes * y,
+               frame.frameData() + static_cast<int64_t>(frame.stride()) * y,
+               static_cast<size_t>(row_bytes));
+    }
+
+    base::ByteArray compressed(ZSTD_compressBound(pixels.size()));
+
+    const size_t ret = compressPixels(pixels, &compressed);
+    if (!ret)
+        return false;
+
+    std::error_code error_code;
+    if (!std::filesystem::create_directories(file.parent_path(), error_code))
+    {
+        if (error_code)
+            return false;
+    }
+
+    std::ofstream stream(file, std::ofstream::binary | std::ofstream::trunc);
+    if (!stream.is_open())
+        return false;
+
+    SnapshotHeader header;
+    header.magic = kSnapshotMagic;
+    header.version = kSnapshotVersion;
+    header.width = size.width();
+    header.height = size.height();
+
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(compressed.data()),
+                 static_cast<std::streamsize>(ret));
+
+    return !stream.fail();
+}
+
+bool loadFrameSnapshot(const std::filesystem::path& file, base::Size* size, base::ByteArray* pixels)
+{
+    DCHECK(size);
+    DCHECK(pixels);
+
+    if (file.empty())
+        return false;
+
+    std::ifstream stream(file, std::ifstream::binary);
+    if (!stream.is_open())
+        return false;
+
+    SnapshotHeader header;
+    stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+    if (stream.fail() || header.magic != kSnapshotMagic || header.version != kSnapshotVersion)
+        return false;
+
+    static const int kMaxValue = std::numeric_limits<uint16_t>::max();
+
+    if (header.width <= 0 || header.width >= kMaxValue ||
+        header.height <= 0 || header.height >= kMaxValue)
+    {
+        return false;
+    }
+
+    const int64_t pixel_bytes =
+        static_cast<int64_t>(header.width) * header.height * base::Frame::kBytesPerPixel;
+    if (pixel_bytes > kMaxPixelBytes)
+        return false;
+
+    std::error_code error_code;
+    const uintmax_t file_size = std::filesystem::file_size(file, error_code);
+    if (error_code || file_size <= sizeof(header))
+        return false;
+
+    base::ByteArray compressed(static_cast<size_t>(file_size - sizeof(header)));
+    stream.read(reinterpret_cast<char*>(compressed.data()),
+                static_cast<std::streamsize>(compressed.size()));
+    if (stream.fail())
+        return false;
+
+    pixels->resize(static_cast<size_t>(pixel_bytes));
+
+    const size_t ret = ZSTD_decompress(pixels->data(), pixels->size(),
+                                       compressed.data(), compressed.size());
+    if (ZSTD_isError(ret) || ret != pixels->size())
+    {
+        LOG(LS_ERROR) << "Damaged frame snapshot: " << file;
+        return false;
+    }
+
+    *size = base::Size(header.width, header.height);
+    return true;
+}
+
+} // namespace client
@@ -0,0 +1,52 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef CLIENT__FRAME_SNAPSHOT_H
+#define CLIENT__FRAME_SNAPSHOT_H
+
+#include "base/desktop/geometry.h"
+#include "base/memory/byte_array.h"
+
+#include <filesystem>
+#include <string_view>
+
+namespace base {
+class Frame;
+} // namespace base
+
+namespace client {
+
+// Persists the last decoded desktop frame between sessions. Most reconnects are short network
+// blips with an unchanged screen; showing the stored frame immediately avoids the black window
+// while the first key frame is still in flight.
+
+// Returns the snapshot file for the given peer address inside the user profile, or an empty
+// path when the profile directory is not available. The address is hashed, so it does not end
+// up in the file system in clear text.
+std::filesystem::path frameSnapshotPath(std::u16string_view address_or_id);
+
+// Writes |frame| to |file|, compressed with zstd.
+bool saveFrameSnapshot(const std::filesystem::path& file, const base::Frame& frame);
+
+// Reads a snapshot written by saveFrameSnapshot. On success |size| and |pixels| receive the
+// frame dimensions and the tightly packed 32bpp pixel rows.
+bool loadFrameSnapshot(const std::filesystem::path& file, base::Size* size, base::ByteArray* pixels);
+
+} // namespace client
+
+#endif // CLIENT__FRAME_SNAPSHOT_H
@@ -20,8 +20,22 @@
 
 #include "base/logging.h"
 
+#include <chrono>
+
 namespace client {
 
+namespace {
+
+// Milliseconds of the monotonic clock; stamped into outgoing input events so the host can
+// recognize events that sat in a stalled connection.
+uint64_t currentTimeMs()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+} // namespace
+
 InputEventFilter::InputEventFilter()
 {
     // Nothing
@@ -59,7 +73,11 @@ std::optional<proto::MouseEvent> InputEventFilter::mouseEvent(const proto::Mouse
         last_mask_ = event.mask() & ~kWheelMask;
 
         ++send_mouse_count_;
-        return event;
+
+        proto::MouseEvent out_event = event;
+        out_event.set_sequence(++input_sequence_);
+        out_event.set_timestamp(currentTimeMs());
+        return out_event;
     }
     else
     {
@@ -75,7 +93,11 @@ std::optional<proto::KeyEvent> InputEventFilter::keyEvent(const proto::KeyEvent&
         return std::nullopt;
 
     ++send_key_count_;
-    return event;
+
+    proto::KeyEvent out_event = event;
+    out_event.set_sequence(++input_sequence_);
+    out_event.set_timestamp(currentTimeMs());
+    return out_event;
 }
 
 std::optional<proto::ClipboardEvent> InputEventFilter::readClipboardEvent(
@@ -55,6 +55,10 @@ private:
     int32_t last_pos_y_ = 0;
     uint32_t last_mask_ = 0;
 
+    // Mouse and key events share one sequence: the host uses it to spot duplicates and gaps
+    // regardless of the event type.
+    uint32_t input_sequence_ = 0;
+
     int send_mouse_count_ = 0;
     int drop_mouse_count_ = 0;
     int send_key_count_ = 0;
@@ -0,0 +1,159 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "client/prewarmed_connection.h"
+
+#include "base/logging.h"
+#include "base/task_runner.h"
+
+namespace client {
+
+PrewarmedConnection::PrewarmedConnection(std::shared_ptr<base::TaskRunner> io_task_runner)
+    : io_task_runner_(std::move(io_task_runner))
+{
+    DCHECK(io_task_runner_);
+}
+
+PrewarmedConnection::~PrewarmedConnection() = default;
+
+// static
+std::shared_ptr<PrewarmedConnection> PrewarmedConnection::create(
+    std::shared_ptr<base::TaskRunner> io_task_runner, const Config& config)
+{
+    DCHECK(!config.router_config.has_value());
+    DCHECK(!config.username.empty() && !config.password.empty());
+
+    std::shared_ptr<PrewarmedConnection> connection(
+        new PrewarmedConnection(std::move(io_task_runner)));
+
+    connection->io_task_runner_->postTask(
+        std::bind(&PrewarmedConnection::connect, connection, config));
+
+    return connection;
+}
+
+void PrewarmedConnection::takeResult(ResultCallback callback)
+{
+    DCHECK(io_task_runner_->belongsToCurrentThread());
+    DCHECK(callback);
+
+    callback_ = std::move(callback);
+
+    if (finished_)
+        finish();
+}
+
+void PrewarmedConnection::connect(const Config& config)
+{
+    DCHECK(io_task_runner_->belongsToCurrentThread());
+
+    LOG(LS_INFO) << "Prewarming connection to host";
+
+    config_ = config;
+
+    channel_ = std::make_unique<base::NetworkChannel>();
+    channel_->setListener(this);
+    channel_->connect(config_.address_or_id, config_.port);
+}
+
+void PrewarmedConnection::onConnected()
+{
+    // The same channel tuning the client applies before authentication.
+    static const size_t kReadBufferSize = 2 * 1024 * 1024; // 2 Mb.
+    static const std::chrono::minutes kKeepAliveTime{ 1 };
+    static const std::chrono::seconds kKeepAliveInterval{ 3 };
+
+    channel_->setReadBufferSize(kReadBufferSize);
+    channel_->setKeepAlive(true, kKeepAliveTime, kKeepAliveInterval);
+    channel_->setNoDelay(true);
+
+    authenticator_ = std::make_unique<base::ClientAuthenticator>(io_task_runner_);
+
+    authenticator_->setIdentify(proto::IDENTIFY_SRP);
+    authenticator_->setUserName(config_.username);
+    authenticator_->setPassword(config_.password);
+    authenticator_->setSessionType(config_.session_type);
+
+    authenticator_->start(std::move(channel_),
+                          [self = shared_from_this()](base::ClientAuthenticator::ErrorCode error_code)
+    {
+        if (error_code == base::ClientAuthenticator::ErrorCode::SUCCESS)
+        {
+            self->result_.type = Result::Type::SUCCESS;
+            self->result_.channel = self->authenticator_->takeChannel();
+            self->result_.peer_version = self->authenticator_->peerVersion();
+
+            // Connection level events before the handover (e.g. the peer going away while the
+            // session window is still being built) must turn the buffered success into an
+            // error, so the prewarm stays the listener until the client takes over.
+            self->result_.channel->setListener(self.get());
+        }
+        else
+        {
+            self->result_.type = Result::Type::AUTHENTICATION_ERROR;
+            self->result_.authentication_error = error_code;
+        }
+
+        // Authenticator is no longer needed.
+        self->io_task_runner_->deleteSoon(std::move(self->authenticator_));
+
+        self->finish();
+    });
+}
+
+void PrewarmedConnection::onDisconnected(base::NetworkChannel::ErrorCode error_code)
+{
+    LOG(LS_INFO) << "Prewarmed connection lost: " << static_cast<int>(error_code);
+
+    result_.type = Result::Type::NETWORK_ERROR;
+    result_.network_error = error_code;
+
+    // The channel cannot be destroyed from its own callback.
+    if (channel_)
+        io_task_runner_->deleteSoon(std::move(channel_));
+    if (result_.channel)
+        io_task_runner_->deleteSoon(std::move(result_.channel));
+
+    finish();
+}
+
+void PrewarmedConnection::onMessageReceived(const base::ByteArray& /* buffer */)
+{
+    // The channel is never resumed while the prewarm owns it.
+    NOTREACHED();
+}
+
+void PrewarmedConnection::onMessageWritten(size_t /* pending */)
+{
+    NOTREACHED();
+}
+
+void PrewarmedConnection::finish()
+{
+    finished_ = true;
+
+    if (!callback_)
+        return;
+
+    // The callback may release the last reference to |this|; it must not run as a member.
+    ResultCallback callback;
+    callback.swap(callback_);
+    callback(std::move(result_));
+}
+
+} // namespace client
@@ -0,0 +1,108 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef CLIENT__PREWARMED_CONNECTION_H
+#define CLIENT__PREWARMED_CONNECTION_H
+
+#include "base/version.h"
+#include "base/net/network_channel.h"
+#include "base/peer/client_authenticator.h"
+#include "client/client_config.h"
+
+#include <functional>
+#include <memory>
+
+namespace base {
+class TaskRunner;
+} // namespace base
+
+namespace client {
+
+// Runs the TCP connect and the key exchange of a direct connection ahead of time, so the
+// network round trips overlap with the construction of the session window on the UI thread
+// instead of starting after it. Created from any thread; all work happens on the I/O thread.
+// The outcome is handed to the Client with takeResult() once the window is ready; if the key
+// exchange finishes first, the outcome is buffered.
+//
+// Prewarming needs the credentials up front (the key exchange uses them), so sessions that ask
+// for credentials interactively keep the ordinary serial path.
+class PrewarmedConnection
+    : public std::enable_shared_from_this<PrewarmedConnection>,
+      public base::NetworkChannel::Listener
+{
+public:
+    ~PrewarmedConnection() override;
+
+    struct Result
+    {
+        enum class Type { SUCCESS, NETWORK_ERROR, AUTHENTICATION_ERROR };
+
+        Type type = Type::NETWORK_ERROR;
+
+        // Authenticated channel without a listener, not yet resumed. Valid only when |type|
+        // is SUCCESS.
+        std::unique_ptr<base::NetworkChannel> channel;
+        base::Version peer_version;
+
+        base::NetworkChannel::ErrorCode network_error =
+            base::NetworkChannel::ErrorCode::UNKNOWN;
+        base::ClientAuthenticator::ErrorCode authentication_error =
+            base::ClientAuthenticator::ErrorCode::UNKNOWN_ERROR;
+    };
+
+    using ResultCallback = std::function<void(Result result)>;
+
+    // Creates the connection and immediately starts connecting. |config| must contain the
+    // credentials and must not use a router.
+    static std::shared_ptr<PrewarmedConnection> create(
+        std::shared_ptr<base::TaskRunner> io_task_runner, const Config& config);
+
+    // Sets the receiver of the outcome. Must be called on the I/O thread; the callback also
+    // runs on the I/O thread, immediately when the outcome is already known. Called at most
+    // once.
+    void takeResult(ResultCallback callback);
+
+protected:
+    // base::NetworkChannel::Listener implementation.
+    void onConnected() override;
+    void onDisconnected(base::NetworkChannel::ErrorCode error_code) override;
+    void onMessageReceived(const base::ByteArray& buffer) override;
+    void onMessageWritten(size_t pending) override;
+
+private:
+    explicit PrewarmedConnection(std::shared_ptr<base::TaskRunner> io_task_runner);
+
+    void connect(const Config& config);
+    void finish();
+
+    std::shared_ptr<base::TaskRunner> io_task_runner_;
+    Config config_;
+
+    std::unique_ptr<base::NetworkChannel> channel_;
+    std::unique_ptr<base::ClientAuthenticator> authenticator_;
+
+    bool finished_ = false;
+    Result result_;
+    ResultCallback callback_;
+
+    DISALLOW_COPY_AND_ASSIGN(PrewarmedConnection);
+};
+
+} // namespace client
+
+#endif // CLIENT__PREWARMED_CONNECTION_H
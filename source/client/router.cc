@@ -25,6 +25,14 @@
 
 namespace client {
 
+namespace {
+
+// Number of entries requested per list page. Large fleets are delivered in several messages of
+// this size instead of one message with the whole list.
+const uint32_t kListPageSize = 500;
+
+} // namespace
+
 Router::Router(std::shared_ptr<RouterWindowProxy> window_proxy,
                std::shared_ptr<base::TaskRunner> io_task_runner)
     : io_task_runner_(io_task_runner),
@@ -54,12 +62,22 @@ void Router::connectToRouter(std::u16string_view address, uint16_t port)
     channel_->connect(address, port);
 }
 
-void Router::refreshHostList()
+void Router::refreshHostList(uint64_t cursor, const std::string& filter)
 {
-    LOG(LS_INFO) << "Sending host list request";
+    LOG(LS_INFO) << "Sending host list request (cursor: " << cursor << ")";
 
     proto::AdminToRouter message;
-    message.mutable_host_list_request()->set_dummy(1);
+
+    proto::HostListRequest* request = message.mutable_host_list_request();
+    request->set_dummy(1);
+    request->set_cursor(cursor);
+    request->set_page_size(kListPageSize);
+    request->set_filter(filter);
+
+    // Subscribe to host status deltas: connects and disconnects arrive as push events, so the
+    // list stays current without polling full snapshots.
+    request->set_subscribe(true);
+
     channel_->send(base::serialize(message));
 }
 
@@ -76,21 +94,31 @@ void Router::disconnectHost(base::HostId host_id)
     channel_->send(base::serialize(message));
 }
 
-void Router::refreshRelayList()
+void Router::refreshRelayList(uint64_t cursor)
 {
-    LOG(LS_INFO) << "Sending relay list request";
+    LOG(LS_INFO) << "Sending relay list request (cursor: " << cursor << ")";
 
     proto::AdminToRouter message;
-    message.mutable_relay_list_request()->set_dummy(1);
+
+    proto::RelayListRequest* request = message.mutable_relay_list_request();
+    request->set_dummy(1);
+    request->set_cursor(cursor);
+    request->set_page_size(kListPageSize);
+
     channel_->send(base::serialize(message));
 }
 
-void Router::refreshUserList()
+void Router::refreshUserList(uint64_t cursor)
 {
-    LOG(LS_INFO) << "Sending user list request";
+    LOG(LS_INFO) << "Sending user list request (cursor: " << cursor << ")";
 
     proto::AdminToRouter message;
-    message.mutable_user_list_request()->set_dummy(1);
+
+    proto::UserListRequest* request = message.mutable_user_list_request();
+    request->set_dummy(1);
+    request->set_cursor(cursor);
+    request->set_page_size(kListPageSize);
+
     channel_->send(base::serialize(message));
 }
 
@@ -191,6 +219,11 @@ void Router::onMessageReceived(const base::ByteArray& buffer)
         window_proxy_->onHostResult(
             std::shared_ptr<proto::HostResult>(message.release_host_result()));
     }
+    else if (message.has_host_status_event())
+    {
+        window_proxy_->onHostStatusEvent(
+            std::shared_ptr<proto::HostStatusEvent>(message.release_host_status_event()));
+    }
     else if (message.has_relay_list())
     {
         LOG(LS_INFO) << "Relay list received";
@@ -44,10 +44,13 @@ public:
 
     void connectToRouter(std::u16string_view address, uint16_t port);
 
-    void refreshHostList();
+    // List refreshes are cursor-paginated: |cursor| zero requests the first page and the value
+    // of |next_cursor| from the reply continues the list. |filter| is matched by the router, so
+    // only matching entries travel over the wire.
+    void refreshHostList(uint64_t cursor, const std::string& filter);
     void disconnectHost(base::HostId host_id);
-    void refreshRelayList();
-    void refreshUserList();
+    void refreshRelayList(uint64_t cursor);
+    void refreshUserList(uint64_t cursor);
     void addUser(const proto::User& user);
     void modifyUser(const proto::User& user);
     void deleteUser(int64_t entry_id);
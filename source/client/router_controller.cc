@@ -21,10 +21,37 @@
 #include "base/logging.h"
 #include "base/task_runner.h"
 #include "base/peer/client_authenticator.h"
+#include "base/strings/unicode.h"
 #include "proto/router_client.pb.h"
 
 namespace client {
 
+RouterController::DirectConnector::DirectConnector(RouterController* controller)
+    : controller_(controller)
+{
+    DCHECK(controller_);
+}
+
+void RouterController::DirectConnector::onConnected()
+{
+    controller_->onDirectConnected();
+}
+
+void RouterController::DirectConnector::onDisconnected(base::NetworkChannel::ErrorCode error_code)
+{
+    controller_->onDirectConnectionError(error_code);
+}
+
+void RouterController::DirectConnector::onMessageReceived(const base::ByteArray& /* buffer */)
+{
+    // The channel is handed over before it is resumed; no messages arrive here.
+}
+
+void RouterController::DirectConnector::onMessageWritten(size_t /* pending */)
+{
+    // Nothing
+}
+
 RouterController::RouterController(const RouterConfig& router_config,
                                    std::shared_ptr<base::TaskRunner> task_runner)
     : task_runner_(std::move(task_runner)),
@@ -133,12 +160,14 @@ void RouterController::onMessageReceived(const base::ByteArray& buffer)
 
     if (message.has_connection_offer())
     {
-        if (relay_peer_)
+        if (offer_received_)
         {
             LOG(LS_ERROR) << "Re-offer connection detected";
             return;
         }
 
+        offer_received_ = true;
+
         const proto::ConnectionOffer& connection_offer = message.connection_offer();
 
         if (connection_offer.error_code() != proto::ConnectionOffer::SUCCESS)
@@ -172,10 +201,34 @@ void RouterController::onMessageReceived(const base::ByteArray& buffer)
         }
         else
         {
-            relay_peer_ = std::make_unique<base::RelayPeer>();
+            // Try the direct path in parallel with the relay setup: when the host endpoint is
+            // reachable, the session skips the relay entirely. The loser of the race is
+            // discarded.
+            if (connection_offer.has_host_endpoint())
+                connectToHostDirectly(connection_offer.host_endpoint());
+
+            // The peer may already exist and be prewarming the connection from a relay hint;
+            // start() then sends the authentication over the established connection.
+            if (!relay_peer_)
+                relay_peer_ = std::make_unique<base::RelayPeer>();
+
             relay_peer_->start(connection_offer.relay(), this);
         }
     }
+    else if (message.has_relay_hint())
+    {
+        const proto::RelayHint& relay_hint = message.relay_hint();
+
+        // Open the transport connection to the relay while the connection request is still
+        // being negotiated; the later offer completes over it without an extra round trip.
+        if (!relay_peer_ && !offer_received_)
+        {
+            relay_peer_ = std::make_unique<base::RelayPeer>();
+            relay_peer_->preconnect(relay_hint.host(),
+                                    static_cast<uint16_t>(relay_hint.port()),
+                                    this);
+        }
+    }
     else
     {
         LOG(LS_WARNING) << "Unhandled message from router";
@@ -187,14 +240,92 @@ void RouterController::onMessageWritten(size_t /* pending */)
     // Nothing
 }
 
+void RouterController::onRelayPreconnected()
+{
+    if (!channel_ || !relay_peer_)
+        return;
+
+    // Report the measured connect time to the router; it approximates the round trip to the
+    // relay. Best effort: the report usually arrives after the current connection request, but
+    // it steers relay selection for later requests of this router session.
+    proto::ClientToRouter message;
+    proto::RelayRtt::Entry* entry = message.mutable_relay_rtt()->add_entry();
+
+    entry->set_host(relay_peer_->connectHost());
+    entry->set_port(relay_peer_->connectPort());
+    entry->set_rtt_ms(relay_peer_->connectTimeMs());
+
+    channel_->send(base::serialize(message));
+}
+
+void RouterController::connectToHostDirectly(const proto::HostEndpoint& host_endpoint)
+{
+    if (direct_channel_)
+        return;
+
+    LOG(LS_INFO) << "Attempting direct connection to host " << host_endpoint.host()
+                 << ":" << host_endpoint.port();
+
+    direct_connector_ = std::make_unique<DirectConnector>(this);
+
+    direct_channel_ = std::make_unique<base::NetworkChannel>();
+    direct_channel_->setListener(direct_connector_.get());
+    direct_channel_->connect(base::utf16FromUtf8(host_endpoint.host()),
+                             static_cast<uint16_t>(host_endpoint.port()));
+}
+
+void RouterController::onDirectConnected()
+{
+    if (host_channel_delivered_)
+        return;
+
+    host_channel_delivered_ = true;
+
+    LOG(LS_INFO) << "Direct connection to host established; relay path discarded";
+
+    direct_channel_->setListener(nullptr);
+    direct_connector_.reset();
+
+    if (delegate_)
+        delegate_->onHostConnected(std::move(direct_channel_));
+}
+
+void RouterController::onDirectConnectionError(base::NetworkChannel::ErrorCode error_code)
+{
+    LOG(LS_INFO) << "Direct connection to host failed ("
+                 << base::NetworkChannel::errorToString(error_code)
+                 << "); continuing through relay";
+
+    // The callback comes from inside the channel, so it cannot be destroyed here.
+    if (direct_channel_)
+        direct_channel_->setListener(nullptr);
+
+    task_runner_->deleteSoon(std::move(direct_channel_));
+    task_runner_->deleteSoon(std::move(direct_connector_));
+}
+
 void RouterController::onRelayConnectionReady(std::unique_ptr<base::NetworkChannel> channel)
 {
+    if (host_channel_delivered_)
+        return;
+
+    host_channel_delivered_ = true;
+
+    // Drop the direct attempt that lost the race.
+    if (direct_channel_)
+        direct_channel_->setListener(nullptr);
+    direct_channel_.reset();
+    direct_connector_.reset();
+
     if (delegate_)
         delegate_->onHostConnected(std::move(channel));
 }
 
 void RouterController::onRelayConnectionError()
 {
+    if (host_channel_delivered_)
+        return;
+
     if (!delegate_)
         return;
 
@@ -25,6 +25,7 @@
 #include "base/peer/host_id.h"
 #include "base/peer/relay_peer.h"
 #include "client/router_config.h"
+#include "proto/router_common.pb.h"
 
 namespace base {
 class ClientAuthenticator;
@@ -91,12 +92,49 @@ protected:
     // base::RelayPeer::Delegate implementation.
     void onRelayConnectionReady(std::unique_ptr<base::NetworkChannel> channel) override;
     void onRelayConnectionError() override;
+    void onRelayPreconnected() override;
 
 private:
+    // Listener of the direct connection attempt to the host that runs in parallel with the
+    // relay setup. A separate listener keeps its callbacks apart from those of the router
+    // channel.
+    class DirectConnector : public base::NetworkChannel::Listener
+    {
+    public:
+        explicit DirectConnector(RouterController* controller);
+        ~DirectConnector() = default;
+
+        // base::NetworkChannel::Listener implementation.
+        void onConnected() override;
+        void onDisconnected(base::NetworkChannel::ErrorCode error_code) override;
+        void onMessageReceived(const base::ByteArray& buffer) override;
+        void onMessageWritten(size_t pending) override;
+
+    private:
+        RouterController* controller_;
+
+        DISALLOW_COPY_AND_ASSIGN(DirectConnector);
+    };
+
+    void connectToHostDirectly(const proto::HostEndpoint& host_endpoint);
+    void onDirectConnected();
+    void onDirectConnectionError(base::NetworkChannel::ErrorCode error_code);
+
     std::shared_ptr<base::TaskRunner> task_runner_;
     std::unique_ptr<base::NetworkChannel> channel_;
     std::unique_ptr<base::ClientAuthenticator> authenticator_;
     std::unique_ptr<base::RelayPeer> relay_peer_;
+
+    std::unique_ptr<DirectConnector> direct_connector_;
+    std::unique_ptr<base::NetworkChannel> direct_channel_;
+
+    // Set when one of the two paths to the host has been handed to the delegate; callbacks of
+    // the path that lost the race are ignored.
+    bool host_channel_delivered_ = false;
+
+    // Set when a connection offer has been received. |relay_peer_| alone does not mean that:
+    // it may exist earlier, prewarming the relay connection from a relay hint.
+    bool offer_received_ = false;
     RouterConfig router_config_;
 
     base::HostId host_id_ = base::kInvalidHostId;
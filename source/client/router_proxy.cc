@@ -32,10 +32,10 @@ public:
 
     void connectToRouter(const std::u16string& address, uint16_t port);
     void disconnectFromRouter();
-    void refreshHostList();
+    void refreshHostList(uint64_t cursor, const std::string& filter);
     void disconnectHost(base::HostId host_id);
-    void refreshRelayList();
-    void refreshUserList();
+    void refreshRelayList(uint64_t cursor);
+    void refreshUserList(uint64_t cursor);
     void addUser(const proto::User& user);
     void modifyUser(const proto::User& user);
     void deleteUser(int64_t entry_id);
@@ -85,16 +85,17 @@ void RouterProxy::Impl::disconnectFromRouter()
     router_.reset();
 }
 
-void RouterProxy::Impl::refreshHostList()
+void RouterProxy::Impl::refreshHostList(uint64_t cursor, const std::string& filter)
 {
     if (!io_task_runner_->belongsToCurrentThread())
     {
-        io_task_runner_->postTask(std::bind(&Impl::refreshHostList, shared_from_this()));
+        io_task_runner_->postTask(
+            std::bind(&Impl::refreshHostList, shared_from_this(), cursor, filter));
         return;
     }
 
     if (router_)
-        router_->refreshHostList();
+        router_->refreshHostList(cursor, filter);
 }
 
 void RouterProxy::Impl::disconnectHost(base::HostId host_id)
@@ -109,28 +110,28 @@ void RouterProxy::Impl::disconnectHost(base::HostId host_id)
         router_->disconnectHost(host_id);
 }
 
-void RouterProxy::Impl::refreshRelayList()
+void RouterProxy::Impl::refreshRelayList(uint64_t cursor)
 {
     if (!io_task_runner_->belongsToCurrentThread())
     {
-        io_task_runner_->postTask(std::bind(&Impl::refreshRelayList, shared_from_this()));
+        io_task_runner_->postTask(std::bind(&Impl::refreshRelayList, shared_from_this(), cursor));
         return;
     }
 
     if (router_)
-        router_->refreshRelayList();
+        router_->refreshRelayList(cursor);
 }
 
-void RouterProxy::Impl::refreshUserList()
+void RouterProxy::Impl::refreshUserList(uint64_t cursor)
 {
     if (!io_task_runner_->belongsToCurrentThread())
     {
-        io_task_runner_->postTask(std::bind(&Impl::refreshUserList, shared_from_this()));
+        io_task_runner_->postTask(std::bind(&Impl::refreshUserList, shared_from_this(), cursor));
         return;
     }
 
     if (router_)
-        router_->refreshUserList();
+        router_->refreshUserList(cursor);
 }
 
 void RouterProxy::Impl::addUser(const proto::User& user)
@@ -191,9 +192,9 @@ void RouterProxy::disconnectFromRouter()
     impl_->disconnectFromRouter();
 }
 
-void RouterProxy::refreshHostList()
+void RouterProxy::refreshHostList(uint64_t cursor, const std::string& filter)
 {
-    impl_->refreshHostList();
+    impl_->refreshHostList(cursor, filter);
 }
 
 void RouterProxy::disconnectHost(base::HostId host_id)
@@ -201,14 +202,14 @@ void RouterProxy::disconnectHost(base::HostId host_id)
     impl_->disconnectHost(host_id);
 }
 
-void RouterProxy::refreshRelayList()
+void RouterProxy::refreshRelayList(uint64_t cursor)
 {
-    impl_->refreshRelayList();
+    impl_->refreshRelayList(cursor);
 }
 
-void RouterProxy::refreshUserList()
+void RouterProxy::refreshUserList(uint64_t cursor)
 {
-    impl_->refreshUserList();
+    impl_->refreshUserList(cursor);
 }
 
 void RouterProxy::addUser(const proto::User& user)
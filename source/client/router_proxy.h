@@ -43,10 +43,10 @@ public:
 
     void connectToRouter(const std::u16string& address, uint16_t port);
     void disconnectFromRouter();
-    void refreshHostList();
+    void refreshHostList(uint64_t cursor, const std::string& filter);
     void disconnectHost(base::HostId host_id);
-    void refreshRelayList();
-    void refreshUserList();
+    void refreshRelayList(uint64_t cursor);
+    void refreshUserList(uint64_t cursor);
     void addUser(const proto::User& user);
     void modifyUser(const proto::User& user);
     void deleteUser(int64_t entry_id);
@@ -24,6 +24,7 @@
 namespace proto {
 class HostList;
 class HostResult;
+class HostStatusEvent;
 class RelayList;
 class UserList;
 class UserResult;
@@ -41,6 +42,7 @@ public:
     virtual void onAccessDenied(base::ClientAuthenticator::ErrorCode error_code) = 0;
     virtual void onHostList(std::shared_ptr<proto::HostList> host_list) = 0;
     virtual void onHostResult(std::shared_ptr<proto::HostResult> host_result) = 0;
+    virtual void onHostStatusEvent(std::shared_ptr<proto::HostStatusEvent> event) = 0;
     virtual void onRelayList(std::shared_ptr<proto::RelayList> relay_list) = 0;
     virtual void onUserList(std::shared_ptr<proto::UserList> user_list) = 0;
     virtual void onUserResult(std::shared_ptr<proto::UserResult> user_result) = 0;
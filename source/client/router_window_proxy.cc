@@ -109,6 +109,19 @@ void RouterWindowProxy::onHostResult(std::shared_ptr<proto::HostResult> host_res
         router_window_->onHostResult(host_result);
 }
 
+void RouterWindowProxy::onHostStatusEvent(std::shared_ptr<proto::HostStatusEvent> event)
+{
+    if (!ui_task_runner_->belongsToCurrentThread())
+    {
+        ui_task_runner_->postTask(
+            std::bind(&RouterWindowProxy::onHostStatusEvent, shared_from_this(), event));
+        return;
+    }
+
+    if (router_window_)
+        router_window_->onHostStatusEvent(event);
+}
+
 void RouterWindowProxy::onRelayList(std::shared_ptr<proto::RelayList> relay_list)
 {
     if (!ui_task_runner_->belongsToCurrentThread())
@@ -41,6 +41,7 @@ public:
     void onAccessDenied(base::ClientAuthenticator::ErrorCode error_code);
     void onHostList(std::shared_ptr<proto::HostList> host_list);
     void onHostResult(std::shared_ptr<proto::HostResult> host_result);
+    void onHostStatusEvent(std::shared_ptr<proto::HostStatusEvent> event);
     void onRelayList(std::shared_ptr<proto::RelayList> relay_list);
     void onUserList(std::shared_ptr<proto::UserList> user_list);
     void onUserResult(std::shared_ptr<proto::UserResult> user_result);
@@ -41,7 +41,7 @@ ClientWindow::~ClientWindow()
     status_window_proxy_->dettach();
 }
 
-bool ClientWindow::connectToHost(Config config)
+bool ClientWindow::connectToHost(Config config, std::shared_ptr<PrewarmedConnection> prewarmed)
 {
     if (client_proxy_)
     {
@@ -75,7 +75,7 @@ bool ClientWindow::connectToHost(Config config)
     client_proxy_ = std::make_unique<ClientProxy>(
         qt_base::Application::ioTaskRunner(), std::move(client), config);
 
-    client_proxy_->start();
+    client_proxy_->start(std::move(prewarmed));
     return true;
 }
 
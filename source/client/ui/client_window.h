@@ -20,6 +20,7 @@
 #define CLIENT__UI__CLIENT_WINDOW_H
 
 #include "client/client_config.h"
+#include "client/prewarmed_connection.h"
 #include "client/status_window.h"
 
 #include <QWidget>
@@ -51,7 +52,9 @@ public:
     // Connects to a host.
     // If the username and/or password are not specified in the connection parameters, the
     // authorization dialog will be displayed.
-    bool connectToHost(Config config);
+    // |prewarmed| optionally carries a connection started before this window was constructed
+    // (see PrewarmedConnection); the client adopts it instead of connecting from scratch.
+    bool connectToHost(Config config, std::shared_ptr<PrewarmedConnection> prewarmed = nullptr);
 
     Config config() const;
 
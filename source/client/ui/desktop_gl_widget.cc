@@ -0,0 +1,249 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "client/ui/desktop_gl_widget.h"
+
+#include "base/logging.h"
+#include "base/desktop/frame.h"
+
+#include <QOpenGLContext>
+#include <QOpenGLShaderProgram>
+
+namespace client {
+
+namespace {
+
+// Not part of the OpenGL ES 2 headers; unsupported contexts are rejected in isSupported().
+#ifndef GL_UNPACK_ROW_LENGTH
+#define GL_UNPACK_ROW_LENGTH 0x0CF2
+#endif
+
+const char kVertexShader[] =
+    "attribute vec2 in_position;\n"
+    "attribute vec2 in_texcoord;\n"
+    "varying vec2 texcoord;\n"
+    "void main() {\n"
+    "    gl_Position = vec4(in_position, 0.0, 1.0);\n"
+    "    texcoord = in_texcoord;\n"
+    "}\n";
+
+// The frame memory is BGRA but is uploaded as RGBA to avoid relying on the GL_BGRA upload
+// format, which OpenGL ES lacks; the swizzle below restores the channel order for free.
+const char kFragmentShader[] =
+    "uniform sampler2D frame_texture;\n"
+    "varying vec2 texcoord;\n"
+    "void main() {\n"
+    "    gl_FragColor = vec4(texture2D(frame_texture, texcoord).bgr, 1.0);\n"
+    "}\n";
+
+// Fullscreen quad as a triangle strip. The frame has its first row at the top, so the top of
+// the quad (y = 1) maps to texture coordinate v = 0.
+const GLfloat kQuadVertices[] =
+{
+    // x      y     u     v
+    -1.0f, -1.0f, 0.0f, 1.0f,
+     1.0f, -1.0f, 1.0f, 1.0f,
+    -1.0f,  1.0f, 0.0f, 0.0f,
+     1.0f,  1.0f, 1.0f, 0.0f
+};
+
+} // namespace
+
+DesktopGLWidget::DesktopGLWidget(QWidget* parent)
+    : QOpenGLWidget(parent)
+{
+    // All input goes to the parent DesktopWidget.
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    setFocusPolicy(Qt::NoFocus);
+
+    connect(this, &QOpenGLWidget::frameSwapped, this, &DesktopGLWidget::onFrameSwapped);
+}
+
+DesktopGLWidget::~DesktopGLWidget()
+{
+    makeCurrent();
+
+    if (texture_)
+        glDeleteTextures(1, &texture_);
+
+    program_.reset();
+    vertex_buffer_.destroy();
+    vao_.destroy();
+
+    doneCurrent();
+}
+
+// static
+bool DesktopGLWidget::isSupported()
+{
+    QOpenGLContext context;
+
+    if (!context.create())
+        return false;
+
+    // Partial texture uploads need GL_UNPACK_ROW_LENGTH, which OpenGL ES gained in version 3.
+    return !context.isOpenGLES() || context.format().majorVersion() >= 3;
+}
+
+void DesktopGLWidget::setDesktopFrame(base::Frame* frame)
+{
+    frame_ = frame;
+    full_upload_ = true;
+    pending_region_.clear();
+}
+
+void DesktopGLWidget::drawFrame(const base::Region& updated_region)
+{
+    if (updated_region.isEmpty())
+        full_upload_ = true;
+    else
+        pending_region_.addRegion(updated_region);
+
+    ++unpainted_frames_;
+
+    if (swap_pending_)
+    {
+        // The previous paint has not been presented yet. The damage stays accumulated and the
+        // next paint is issued after the swap; painting now would outrun the display.
+        update_deferred_ = true;
+        return;
+    }
+
+    update();
+}
+
+void DesktopGLWidget::onFrameSwapped()
+{
+    swap_pending_ = false;
+
+    if (update_deferred_)
+    {
+        update_deferred_ = false;
+        update();
+    }
+}
+
+void DesktopGLWidget::initializeGL()
+{
+    initializeOpenGLFunctions();
+
+    program_ = std::make_unique<QOpenGLShaderProgram>();
+
+    if (!program_->addShaderFromSourceCode(QOpenGLShader::Vertex, kVertexShader) ||
+        !program_->addShaderFromSourceCode(QOpenGLShader::Fragment, kFragmentShader) ||
+        !program_->link())
+    {
+        LOG(LS_ERROR) << "Unable to build shader program: "
+                      << program_->log().toStdString();
+        program_.reset();
+        return;
+    }
+
+    vao_.create();
+    vao_.bind();
+
+    vertex_buffer_.create();
+    vertex_buffer_.bind();
+    vertex_buffer_.allocate(kQuadVertices, sizeof(kQuadVertices));
+
+    program_->bind();
+    program_->enableAttributeArray("in_position");
+    program_->setAttributeBuffer("in_position", GL_FLOAT, 0, 2, 4 * sizeof(GLfloat));
+    program_->enableAttributeArray("in_texcoord");
+    program_->setAttributeBuffer(
+        "in_texcoord", GL_FLOAT, 2 * sizeof(GLfloat), 2, 4 * sizeof(GLfloat));
+    program_->setUniformValue("frame_texture", 0);
+    program_->release();
+
+    vertex_buffer_.release();
+    vao_.release();
+
+    glGenTextures(1, &texture_);
+    glBindTexture(GL_TEXTURE_2D, texture_);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+void DesktopGLWidget::paintGL()
+{
+    // A buffer swap follows every paint; until it completes new damage is only accumulated.
+    swap_pending_ = true;
+
+    if (unpainted_frames_ > 0)
+    {
+        ++painted_frames_;
+        dropped_frames_ += static_cast<uint64_t>(unpainted_frames_ - 1);
+        unpainted_frames_ = 0;
+    }
+
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    if (!frame_ || !program_)
+        return;
+
+    const base::Size& frame_size = frame_->size();
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture_);
+
+    if (texture_size_ != QSize(frame_size.width(), frame_size.height()))
+    {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, frame_size.width(), frame_size.height(),
+                     0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+        texture_size_ = QSize(frame_size.width(), frame_size.height());
+        full_upload_ = true;
+    }
+
+    // The frame rows may be padded; tell GL the real row length in pixels.
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, frame_->stride() / base::Frame::kBytesPerPixel);
+
+    if (full_upload_)
+    {
+        uploadRect(base::Rect::makeSize(frame_size));
+        full_upload_ = false;
+    }
+    else
+    {
+        for (base::Region::Iterator it(pending_region_); !it.isAtEnd(); it.advance())
+            uploadRect(it.rect());
+    }
+
+    pending_region_.clear();
+
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+    program_->bind();
+    vao_.bind();
+
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    vao_.release();
+    program_->release();
+}
+
+void DesktopGLWidget::uploadRect(const base::Rect& rect)
+{
+    glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x(), rect.y(), rect.width(), rect.height(),
+                    GL_RGBA, GL_UNSIGNED_BYTE, frame_->frameDataAtPos(rect.topLeft()));
+}
+
+} // namespace client
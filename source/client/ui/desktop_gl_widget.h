@@ -0,0 +1,112 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef CLIENT__UI__DESKTOP_GL_WIDGET_H
+#define CLIENT__UI__DESKTOP_GL_WIDGET_H
+
+#include "base/macros_magic.h"
+#include "base/desktop/region.h"
+
+#include <QOpenGLBuffer>
+#include <QOpenGLFunctions>
+#include <QOpenGLVertexArrayObject>
+#include <QOpenGLWidget>
+
+#include <memory>
+
+class QOpenGLShaderProgram;
+
+namespace base {
+class Frame;
+} // namespace base
+
+namespace client {
+
+// GPU-backed rendering surface for the desktop frame. The frame lives in a texture; every
+// decoded packet uploads only the damaged rectangles (glTexSubImage2D) and scaling happens in
+// the fragment sampler, so a scaled 4K session no longer burns a core on QPainter blits.
+//
+// The widget sits on top of DesktopWidget and is transparent for input, so all mouse and
+// keyboard handling stays in the parent.
+class DesktopGLWidget : public QOpenGLWidget, protected QOpenGLFunctions
+{
+    Q_OBJECT
+
+public:
+    explicit DesktopGLWidget(QWidget* parent);
+    ~DesktopGLWidget() override;
+
+    // Returns true if an OpenGL context can be created on this machine. When it cannot,
+    // DesktopWidget keeps its software paint path.
+    static bool isSupported();
+
+    // The frame is owned by the parent widget and outlives this widget.
+    void setDesktopFrame(base::Frame* frame);
+
+    // Schedules an upload of |updated_region| (in frame coordinates) and a redraw. An empty
+    // region re-uploads the whole frame.
+    void drawFrame(const base::Region& updated_region);
+
+    // Number of decoded frames presented to the screen, and number that were superseded by a
+    // newer frame before they reached the screen.
+    uint64_t paintedFrames() const { return painted_frames_; }
+    uint64_t droppedFrames() const { return dropped_frames_; }
+
+protected:
+    // QOpenGLWidget implementation.
+    void initializeGL() override;
+    void paintGL() override;
+
+private slots:
+    void onFrameSwapped();
+
+private:
+    void uploadRect(const base::Rect& rect);
+
+    base::Frame* frame_ = nullptr;
+
+    // Part of the frame that changed since the last paint and must be re-uploaded.
+    base::Region pending_region_;
+    bool full_upload_ = true;
+
+    // Present-rate pacing. While the buffer swap of the last paint has not completed, further
+    // decoded frames only extend |pending_region_| and the next paint is issued from
+    // onFrameSwapped(). With vsync this caps paints at the display refresh rate, so frames
+    // nobody would see are never uploaded separately.
+    bool swap_pending_ = false;
+    bool update_deferred_ = false;
+
+    // Decoded frames accumulated since the last paint; all but the newest are dropped.
+    int unpainted_frames_ = 0;
+
+    uint64_t painted_frames_ = 0;
+    uint64_t dropped_frames_ = 0;
+
+    GLuint texture_ = 0;
+    QSize texture_size_;
+
+    std::unique_ptr<QOpenGLShaderProgram> program_;
+    QOpenGLBuffer vertex_buffer_;
+    QOpenGLVertexArrayObject vao_;
+
+    DISALLOW_COPY_AND_ASSIGN(DesktopGLWidget);
+};
+
+} // namespace client
+
+#endif // CLIENT__UI__DESKTOP_GL_WIDGET_H
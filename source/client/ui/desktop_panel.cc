@@ -77,6 +77,8 @@ DesktopPanel::DesktopPanel(proto::SessionType session_type, QWidget* parent)
     connect(ui.action_update, &QAction::triggered, this, &DesktopPanel::startRemoteUpdate);
     connect(ui.action_system_info, &QAction::triggered, this, &DesktopPanel::startSystemInfo);
     connect(ui.action_statistics, &QAction::triggered, this, &DesktopPanel::startStatistics);
+    connect(ui.action_latency_overlay, &QAction::triggered,
+            this, &DesktopPanel::latencyOverlayChanged);
     connect(ui.action_minimize, &QAction::triggered, this, &DesktopPanel::minimizeSession);
     connect(ui.action_close, &QAction::triggered, this, &DesktopPanel::closeSession);
 
@@ -370,6 +372,28 @@ void DesktopPanel::createAdditionalMenu(proto::SessionType session_type)
 
     updateScaleMenu();
 
+    // Video profiles limit the frame rate and bitrate of the host encoder. They are applied
+    // on the fly, so an operator can park a background session at a low frame rate and bring
+    // it back to full speed without restarting the stream.
+    profile_group_ = new QActionGroup(additional_menu_);
+    profile_menu_ = additional_menu_->addMenu(tr("Video Profile"));
+
+    QAction* profile_full = profile_menu_->addAction(tr("Full speed"));
+    profile_full->setCheckable(true);
+    profile_full->setChecked(true);
+    profile_full->setData(0);
+    profile_group_->addAction(profile_full);
+
+    QAction* profile_reduced = profile_menu_->addAction(tr("Reduced (15 fps)"));
+    profile_reduced->setCheckable(true);
+    profile_reduced->setData(15);
+    profile_group_->addAction(profile_reduced);
+
+    QAction* profile_background = profile_menu_->addAction(tr("Background (5 fps)"));
+    profile_background->setCheckable(true);
+    profile_background->setData(5);
+    profile_group_->addAction(profile_background);
+
     additional_menu_->addAction(ui.action_autoscroll);
 
     if (session_type == proto::SESSION_TYPE_DESKTOP_MANAGE)
@@ -378,6 +402,7 @@ void DesktopPanel::createAdditionalMenu(proto::SessionType session_type)
     additional_menu_->addSeparator();
     additional_menu_->addAction(ui.action_screenshot);
     additional_menu_->addAction(ui.action_statistics);
+    additional_menu_->addAction(ui.action_latency_overlay);
 
     // Set the menu for the button on the toolbar.
     ui.action_menu->setMenu(additional_menu_);
@@ -412,6 +437,21 @@ void DesktopPanel::createAdditionalMenu(proto::SessionType session_type)
         emit scaleChanged();
     });
 
+    connect(profile_group_, &QActionGroup::triggered, [this](QAction* action)
+    {
+        const int max_fps = action->data().toInt();
+
+        proto::VideoProfile video_profile;
+        video_profile.set_max_fps(max_fps);
+
+        // The background profile also caps the bitrate; a parked session should not compete
+        // with the foreground one for the uplink.
+        if (max_fps != 0 && max_fps <= 5)
+            video_profile.set_max_bitrate_kbps(1024);
+
+        emit videoProfileChanged(video_profile);
+    });
+
     connect(ui.action_fit_window, &QAction::toggled, [this](bool checked)
     {
         ui.action_autoscroll->setEnabled(!checked);
@@ -52,10 +52,12 @@ signals:
     void switchToAutosize();
     void settingsButton();
     void screenSelected(const proto::Screen& screen);
+    void videoProfileChanged(const proto::VideoProfile& video_profile);
     void scaleChanged();
     void autoScrollChanged(bool enabled);
     void keyCombinationsChanged(bool enabled);
     void takeScreenshot();
+    void latencyOverlayChanged(bool enabled);
     void startSession(proto::SessionType session_type);
     void powerControl(proto::PowerControl::Action action);
     void startRemoteUpdate();
@@ -99,6 +101,9 @@ private:
     QMenu* screens_menu_ = nullptr;
     QActionGroup* screens_group_ = nullptr;
 
+    QMenu* profile_menu_ = nullptr;
+    QActionGroup* profile_group_ = nullptr;
+
     QTimer* hide_timer_ = nullptr;
 
     bool allow_hide_ = true;
@@ -20,10 +20,18 @@
 
 #include "base/logging.h"
 #include "common/keycode_converter.h"
+#include "client/ui/desktop_gl_widget.h"
 #include "client/ui/frame_qimage.h"
 
 #include <QApplication>
+#include <QPaintEvent>
+#include <QScreen>
+#include <QTimer>
 #include <QWheelEvent>
+#include <QWindow>
+
+#include <algorithm>
+#include <cmath>
 
 #if defined(OS_LINUX)
 #include <X11/XKBlib.h>
@@ -100,6 +108,19 @@ bool isModifierKey(int key)
            key == Qt::Key_Shift || key == Qt::Key_Meta;
 }
 
+int refreshIntervalMs(const QWidget* widget)
+{
+    const QWindow* window = widget->window()->windowHandle();
+
+    QScreen* screen = window ? window->screen() : QApplication::primaryScreen();
+    qreal refresh_rate = screen ? screen->refreshRate() : 0.0;
+
+    if (refresh_rate <= 0.0)
+        refresh_rate = 60.0;
+
+    return std::max(1, qRound(1000.0 / refresh_rate));
+}
+
 } // namespace
 
 DesktopWidget::DesktopWidget(Delegate* delegate, QWidget* parent)
@@ -111,6 +132,23 @@ DesktopWidget::DesktopWidget(Delegate* delegate, QWidget* parent)
     setAttribute(Qt::WA_OpaquePaintEvent);
     setAttribute(Qt::WA_NoSystemBackground);
     setMouseTracking(true);
+
+    if (DesktopGLWidget::isSupported())
+    {
+        LOG(LS_INFO) << "Using OpenGL rendering";
+
+        gl_widget_ = new DesktopGLWidget(this);
+        gl_widget_->show();
+    }
+    else
+    {
+        LOG(LS_INFO) << "OpenGL is not available, using software rendering";
+
+        update_timer_ = new QTimer(this);
+        update_timer_->setSingleShot(true);
+        update_timer_->setTimerType(Qt::PreciseTimer);
+        connect(update_timer_, &QTimer::timeout, this, &DesktopWidget::flushPendingUpdate);
+    }
 }
 
 base::Frame* DesktopWidget::desktopFrame()
@@ -121,6 +159,17 @@ base::Frame* DesktopWidget::desktopFrame()
 void DesktopWidget::setDesktopFrame(std::shared_ptr<base::Frame>& frame)
 {
     frame_ = std::move(frame);
+
+    if (gl_widget_)
+    {
+        gl_widget_->setDesktopFrame(frame_.get());
+    }
+    else
+    {
+        // Damage accumulated so far is in the coordinates of the previous frame.
+        pending_update_region_.clear();
+        pending_full_update_ = true;
+    }
 }
 
 void DesktopWidget::doMouseEvent(QEvent::Type event_type,
@@ -312,14 +361,163 @@ void DesktopWidget::enableKeyCombinations(bool enable)
 #endif // defined(OS_WIN)
 }
 
-void DesktopWidget::paintEvent(QPaintEvent* /* event */)
+void DesktopWidget::drawFrame(const base::Region& updated_region)
+{
+    if (!frame_)
+        return;
+
+    if (gl_widget_)
+    {
+        gl_widget_->drawFrame(updated_region);
+
+        // The GL surface covers this widget, so paintEvent() is not called for frame updates;
+        // give the delegate its per-frame callback here.
+        delegate_->onDrawDesktop();
+        return;
+    }
+
+    if (updated_region.isEmpty())
+    {
+        // No damage information (for example the first packet for a new frame). Repaint fully.
+        pending_full_update_ = true;
+    }
+    else
+    {
+        pending_update_region_.addRegion(updated_region);
+    }
+
+    ++unpainted_frames_;
+
+    if (update_timer_->isActive())
+    {
+        // A flush is already scheduled; this frame's damage rides along with it.
+        return;
+    }
+
+    const int refresh_interval = refreshIntervalMs(this);
+    const qint64 elapsed =
+        last_update_time_.isValid() ? last_update_time_.elapsed() : refresh_interval;
+
+    if (elapsed >= refresh_interval)
+        flushPendingUpdate();
+    else
+        update_timer_->start(static_cast<int>(refresh_interval - elapsed));
+}
+
+void DesktopWidget::flushPendingUpdate()
+{
+    if (!frame_)
+        return;
+
+    if (unpainted_frames_ > 0)
+    {
+        ++painted_frames_;
+        dropped_frames_ += static_cast<uint64_t>(unpainted_frames_ - 1);
+        unpainted_frames_ = 0;
+    }
+
+    last_update_time_.start();
+
+    if (pending_full_update_)
+    {
+        pending_full_update_ = false;
+        pending_update_region_.clear();
+
+        update();
+        return;
+    }
+
+    const base::Size& frame_size = frame_->size();
+
+    if (width() == frame_size.width() && height() == frame_size.height())
+    {
+        for (base::Region::Iterator it(pending_update_region_); !it.isAtEnd(); it.advance())
+        {
+            const base::Rect frame_rect = it.rect();
+
+            update(frame_rect.x(), frame_rect.y(), frame_rect.width(), frame_rect.height());
+        }
+
+        pending_update_region_.clear();
+        return;
+    }
+
+    const double scale_x = static_cast<double>(width()) / frame_size.width();
+    const double scale_y = static_cast<double>(height()) / frame_size.height();
+
+    for (base::Region::Iterator it(pending_update_region_); !it.isAtEnd(); it.advance())
+    {
+        const base::Rect frame_rect = it.rect();
+
+        // Expanded by one pixel on each side, so the smooth scaling filter at the edges of the
+        // damaged area is repainted too.
+        QRect widget_rect(
+            QPoint(static_cast<int>(frame_rect.left() * scale_x) - 1,
+                   static_cast<int>(frame_rect.top() * scale_y) - 1),
+            QPoint(static_cast<int>(std::ceil(frame_rect.right() * scale_x)) + 1,
+                   static_cast<int>(std::ceil(frame_rect.bottom() * scale_y)) + 1));
+
+        update(widget_rect.intersected(rect()));
+    }
+
+    pending_update_region_.clear();
+}
+
+uint64_t DesktopWidget::paintedFrames() const
+{
+    if (gl_widget_)
+        return gl_widget_->paintedFrames();
+
+    return painted_frames_;
+}
+
+uint64_t DesktopWidget::droppedFrames() const
+{
+    if (gl_widget_)
+        return gl_widget_->droppedFrames();
+
+    return dropped_frames_;
+}
+
+void DesktopWidget::resizeEvent(QResizeEvent* event)
+{
+    if (gl_widget_)
+        gl_widget_->setGeometry(rect());
+
+    QWidget::resizeEvent(event);
+}
+
+void DesktopWidget::paintEvent(QPaintEvent* event)
 {
     FrameQImage* frame = reinterpret_cast<FrameQImage*>(frame_.get());
-    if (frame)
+    if (frame && !gl_widget_)
     {
+        const QImage& image = frame->constImage();
+        const QRect& target_rect = event->rect();
+
         painter_.begin(this);
         painter_.setRenderHint(QPainter::SmoothPixmapTransform);
-        painter_.drawImage(rect(), frame->constImage());
+
+        if (size() == image.size())
+        {
+            // 1:1 output - blit only the damaged bytes.
+            painter_.drawImage(target_rect, image, target_rect);
+        }
+        else
+        {
+            // Map the damaged widget area back onto the frame, so only the changed part is
+            // rescaled instead of the whole frame.
+            const double scale_x = static_cast<double>(image.width()) / width();
+            const double scale_y = static_cast<double>(image.height()) / height();
+
+            QRectF source_rect(target_rect.x() * scale_x,
+                               target_rect.y() * scale_y,
+                               target_rect.width() * scale_x,
+                               target_rect.height() * scale_y);
+
+            painter_.drawImage(QRectF(target_rect), image, source_rect);
+        }
+
         painter_.end();
     }
 
@@ -27,6 +27,7 @@
 #include "base/win/scoped_user_object.h"
 #endif // defined(OS_WIN)
 
+#include <QElapsedTimer>
 #include <QEvent>
 #include <QPainter>
 #include <QWidget>
@@ -34,8 +35,12 @@
 #include <memory>
 #include <set>
 
+class QTimer;
+
 namespace client {
 
+class DesktopGLWidget;
+
 class DesktopWidget : public QWidget
 {
     Q_OBJECT
@@ -57,6 +62,16 @@ public:
     base::Frame* desktopFrame();
     void setDesktopFrame(std::shared_ptr<base::Frame>& frame);
 
+    // Schedules a repaint of the widget area covered by |updated_region| (in frame coordinates).
+    // An empty region repaints the whole widget. Repaints are paced to the display refresh
+    // rate; when decoding outpaces it, superseded frames are merged before they are painted.
+    void drawFrame(const base::Region& updated_region);
+
+    // Number of decoded frames presented to the screen, and number that were superseded by a
+    // newer frame before they reached the screen. Shown in the latency overlay.
+    uint64_t paintedFrames() const;
+    uint64_t droppedFrames() const;
+
     void doMouseEvent(QEvent::Type event_type,
                       const Qt::MouseButtons& buttons,
                       const QPoint& pos,
@@ -73,6 +88,7 @@ public slots:
 protected:
     // QWidget implementation.
     void paintEvent(QPaintEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
     void mouseMoveEvent(QMouseEvent* event) override;
     void mousePressEvent(QMouseEvent* event) override;
     void mouseReleaseEvent(QMouseEvent* event) override;
@@ -85,6 +101,7 @@ protected:
 
 private:
     void executeKeyEvent(uint32_t usb_keycode, uint32_t flags);
+    void flushPendingUpdate();
 
     QPainter painter_;
 
@@ -95,9 +112,25 @@ private:
 
     Delegate* delegate_;
 
+    // GPU rendering surface; nullptr when OpenGL is not available, in which case the frame is
+    // painted in software by paintEvent().
+    DesktopGLWidget* gl_widget_ = nullptr;
+
     std::shared_ptr<base::Frame> frame_;
     bool enable_key_sequenses_ = true;
 
+    // Present-rate pacing for the software path. Damage is handed to update() at most once per
+    // display refresh interval; damage that arrives earlier accumulates here and is flushed by
+    // |update_timer_|. The GL widget paces itself with the frameSwapped signal instead.
+    base::Region pending_update_region_;
+    bool pending_full_update_ = false;
+    int unpainted_frames_ = 0;
+    QTimer* update_timer_ = nullptr;
+    QElapsedTimer last_update_time_;
+
+    uint64_t painted_frames_ = 0;
+    uint64_t dropped_frames_ = 0;
+
     QPoint prev_pos_;
     uint32_t prev_mask_ = 0;
 
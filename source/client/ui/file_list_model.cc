@@ -35,19 +35,21 @@ enum Column
     COLUMN_COUNT      = 4
 };
 
+// Number of rows handed to the view per fetchMore() call.
+const int kFetchBatchSize = 1000;
+
 template<class T>
 void sortByName(T& list, Qt::SortOrder order)
 {
     std::sort(list.begin(), list.end(),
               [order](const typename T::value_type& f1, const typename T::value_type& f2)
     {
-        const QString& f1_name = f1.name;
-        const QString& f2_name = f2.name;
-
+        // The precomputed lowercase keys are compared directly; lowercasing both sides on
+        // every comparison dominated the sort time on large directories.
         if (order == Qt::AscendingOrder)
-            return f1_name.toLower() < f2_name.toLower();
+            return f1.name_key < f2.name_key;
         else
-            return f1_name.toLower() > f2_name.toLower();
+            return f2.name_key < f1.name_key;
     });
 }
 
@@ -112,7 +114,7 @@ void FileListModel::setFileList(const proto::FileList& list)
     if (!list.item_size())
         return;
 
-    beginInsertRows(QModelIndex(), 0, list.item_size() - 1);
+    file_items_.reserve(list.item_size());
 
     for (int i = 0; i < list.item_size(); ++i)
     {
@@ -122,6 +124,7 @@ void FileListModel::setFileList(const proto::FileList& list)
         {
             Folder folder;
             folder.name       = QString::fromStdString(item.name());
+            folder.name_key   = folder.name.toLower();
             folder.last_write = item.modification_time();
 
             folder_items_.append(folder);
@@ -130,20 +133,21 @@ void FileListModel::setFileList(const proto::FileList& list)
         {
             File file;
             file.name       = QString::fromStdString(item.name());
+            file.name_key   = file.name.toLower();
             file.last_write = item.modification_time();
             file.size       = item.size();
 
-            QPair<QIcon, QString> file_info = common::FilePlatformUtil::fileTypeInfo(file.name);
-            file.icon = file_info.first;
-            file.type = file_info.second;
-
+            // Icon and type are resolved lazily when the row becomes visible.
             file_items_.append(file);
         }
     }
 
+    // The rows are not exposed yet, so sorting the backing store emits no signals.
     sortItems(current_column_, current_order_);
 
-    endInsertRows();
+    // Expose the first batch immediately; the view pulls the rest through fetchMore() while
+    // scrolling, so even a directory with 100k entries renders right away.
+    fetchMore(QModelIndex());
 }
 
 void FileListModel::setSortOrder(int column, Qt::SortOrder order)
@@ -157,12 +161,17 @@ void FileListModel::clear()
     if (folder_items_.isEmpty() && file_items_.isEmpty())
         return;
 
-    beginRemoveRows(QModelIndex(), 0, folder_items_.count() + file_items_.count() - 1);
+    const bool had_rows = visible_count_ > 0;
+
+    if (had_rows)
+        beginRemoveRows(QModelIndex(), 0, visible_count_ - 1);
 
     folder_items_.clear();
     file_items_.clear();
+    visible_count_ = 0;
 
-    endRemoveRows();
+    if (had_rows)
+        endRemoveRows();
 }
 
 bool FileListModel::isFolder(const QModelIndex& index) const
@@ -188,6 +197,10 @@ int64_t FileListModel::sizeAt(const QModelIndex& index) const
 
 QModelIndex FileListModel::createFolder()
 {
+    // The new row goes behind the existing folders; materialize the rows that have not been
+    // fetched yet so the insert position is within the exposed range.
+    fetchAllRows();
+
     int row = folder_items_.count();
 
     if (row > 0)
@@ -199,6 +212,7 @@ QModelIndex FileListModel::createFolder()
 
     beginInsertRows(QModelIndex(), row, row);
     folder_items_.append(Folder());
+    ++visible_count_;
     endInsertRows();
 
     return createIndex(row, COLUMN_NAME);
@@ -219,7 +233,7 @@ QModelIndex FileListModel::parent(const QModelIndex& /* child */) const
 
 int FileListModel::rowCount(const QModelIndex& /* parent */) const
 {
-    return folder_items_.count() + file_items_.count();
+    return visible_count_;
 }
 
 int FileListModel::columnCount(const QModelIndex& /* parent */) const
@@ -274,7 +288,13 @@ QVariant FileListModel::data(const QModelIndex& index, int role) const
     }
     else
     {
-        const File& file = file_items_.at(row - folder_items_.count());
+        File& file = file_items_[row - folder_items_.count()];
+
+        if (role == Qt::DecorationRole || ((role == Qt::DisplayRole || role == Qt::EditRole) &&
+                                           column == COLUMN_TYPE))
+        {
+            resolveTypeInfo(&file);
+        }
 
         switch (role)
         {
@@ -334,6 +354,7 @@ bool FileListModel::setData(const QModelIndex& index, const QVariant& value, int
     {
         beginRemoveRows(QModelIndex(), index.row(), index.row());
         folder_items_.removeLast();
+        --visible_count_;
         endRemoveRows();
 
         emit createFolderRequest(new_name);
@@ -497,8 +518,15 @@ void FileListModel::sortItems(int column, Qt::SortOrder order)
             break;
 
         case COLUMN_TYPE:
+        {
+            // Sorting by type needs the type of every file, not only the visible ones. The
+            // extension cache keeps this to one lookup per distinct extension.
+            for (File& file : file_items_)
+                resolveTypeInfo(&file);
+
             sortByType(file_items_, order);
-            break;
+        }
+        break;
 
         case COLUMN_LAST_WRITE:
             sortByTime(folder_items_, order);
@@ -510,6 +538,58 @@ void FileListModel::sortItems(int column, Qt::SortOrder order)
     }
 }
 
+bool FileListModel::canFetchMore(const QModelIndex& parent) const
+{
+    return !parent.isValid() && visible_count_ < totalCount();
+}
+
+void FileListModel::fetchMore(const QModelIndex& parent)
+{
+    if (parent.isValid())
+        return;
+
+    int count = totalCount() - visible_count_;
+    if (count <= 0)
+        return;
+
+    if (count > kFetchBatchSize)
+        count = kFetchBatchSize;
+
+    beginInsertRows(QModelIndex(), visible_count_, visible_count_ + count - 1);
+    visible_count_ += count;
+    endInsertRows();
+}
+
+void FileListModel::fetchAllRows()
+{
+    if (visible_count_ >= totalCount())
+        return;
+
+    beginInsertRows(QModelIndex(), visible_count_, totalCount() - 1);
+    visible_count_ = totalCount();
+    endInsertRows();
+}
+
+void FileListModel::resolveTypeInfo(File* file) const
+{
+    if (file->type_resolved)
+        return;
+
+    int dot_index = file->name.lastIndexOf(QLatin1Char('.'));
+    QString extension = (dot_index != -1) ? file->name.mid(dot_index).toLower() : QString();
+
+    auto it = type_info_cache_.find(extension);
+    if (it == type_info_cache_.end())
+    {
+        it = type_info_cache_.insert(
+            extension, common::FilePlatformUtil::fileTypeInfo(file->name));
+    }
+
+    file->icon = it.value().first;
+    file->type = it.value().second;
+    file->type_resolved = true;
+}
+
 // static
 QString FileListModel::sizeToString(int64_t size)
 {
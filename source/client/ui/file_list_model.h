@@ -22,7 +22,9 @@
 #include "client/file_transfer.h"
 
 #include <QAbstractItemModel>
+#include <QHash>
 #include <QIcon>
+#include <QVector>
 
 namespace client {
 
@@ -61,6 +63,8 @@ public:
     Qt::DropActions supportedDragActions() const override;
     Qt::ItemFlags flags(const QModelIndex& index) const override;
     void sort(int column, Qt::SortOrder order) override;
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
 
 signals:
     void nameChangeRequest(const QString& old_name, const QString& new_name);
@@ -77,19 +81,40 @@ private:
     {
         int64_t size = 0;
         time_t last_write = 0;
-        QIcon icon;
         QString name;
+
+        // Lowercased name precomputed at population time, so sorting by name does not lowercase
+        // both sides on every comparison.
+        QString name_key;
+
+        // Icon and type are resolved lazily in data() through the extension cache; on large
+        // directories only the rows that actually become visible pay for the lookup.
+        QIcon icon;
         QString type;
+        bool type_resolved = false;
     };
 
     struct Folder
     {
         QString name;
+        QString name_key;
         time_t last_write = 0;
     };
 
-    QList<Folder> folder_items_;
-    QList<File> file_items_;
+    void resolveTypeInfo(File* file) const;
+    int totalCount() const { return folder_items_.count() + file_items_.count(); }
+    void fetchAllRows();
+
+    QVector<Folder> folder_items_;
+    mutable QVector<File> file_items_;
+
+    // Number of rows exposed to the view so far. The remaining items are handed out in batches
+    // through fetchMore(), so a huge directory renders progressively instead of freezing the UI.
+    int visible_count_ = 0;
+
+    // fileTypeInfo() is an expensive shell call whose result depends only on the extension; one
+    // lookup per distinct extension instead of one per file.
+    mutable QHash<QString, QPair<QIcon, QString>> type_info_cache_;
 
     const QIcon dir_icon_;
     const QString dir_type_;
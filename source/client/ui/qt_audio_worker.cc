@@ -21,11 +21,26 @@
 #include "base/logging.h"
 #include "proto/desktop.pb.h"
 
+#include <algorithm>
+
 #include <QAudioOutput>
 #include <QEvent>
+#include <QTimer>
 
 namespace client {
 
+namespace {
+
+// Size of the device-side buffer. It only has to bridge the pull timer interval; the network
+// jitter is absorbed by the adaptive jitter buffer, so keeping this small keeps the total
+// playback latency low.
+const int kDeviceBufferBytes = 50 * 48000 * 4 / 1000; // 50 ms of 48 kHz stereo S16.
+
+// How often buffered audio is moved to the device.
+const int kPullIntervalMs = 10;
+
+} // namespace
+
 QtAudioWorker::QtAudioWorker() = default;
 
 QtAudioWorker::~QtAudioWorker() = default;
@@ -73,6 +88,8 @@ bool QtAudioWorker::init()
         return false;
     }
 
+    audio_output_->setBufferSize(kDeviceBufferBytes);
+
     audio_device_ = audio_output_->start();
     if (!audio_device_)
     {
@@ -80,6 +97,10 @@ bool QtAudioWorker::init()
         return false;
     }
 
+    pull_timer_ = new QTimer(this);
+    connect(pull_timer_, &QTimer::timeout, this, &QtAudioWorker::pullAudio);
+    pull_timer_->start(kPullIntervalMs);
+
     return true;
 }
 
@@ -100,15 +121,32 @@ void QtAudioWorker::processEvents()
 
     while (!work_queue.empty())
     {
-        const proto::AudioPacket& packet = *work_queue.front();
+        jitter_buffer_.addPacket(std::move(work_queue.front()));
+        work_queue.pop();
+    }
 
-        for (int i = 0; i < packet.data_size(); ++i)
-        {
-            const std::string& data = packet.data(i);
-            audio_device_->write(data.data(), data.size());
-        }
+    // Move audio to the device right away if it has room; the timer covers the case where
+    // the device drains between packet arrivals.
+    pullAudio();
+}
 
-        work_queue.pop();
+void QtAudioWorker::pullAudio()
+{
+    if (!audio_output_ || !audio_device_)
+        return;
+
+    char chunk[8192];
+    int free_bytes = audio_output_->bytesFree();
+
+    while (free_bytes > 0)
+    {
+        size_t size = jitter_buffer_.read(
+            chunk, std::min(sizeof(chunk), static_cast<size_t>(free_bytes)));
+        if (!size)
+            break;
+
+        audio_device_->write(chunk, static_cast<qint64>(size));
+        free_bytes -= static_cast<int>(size);
     }
 }
 
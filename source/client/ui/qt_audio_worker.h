@@ -19,6 +19,8 @@
 #ifndef CLIENT__UI__QT_AUDIO_WORKER_H
 #define CLIENT__UI__QT_AUDIO_WORKER_H
 
+#include "client/audio_jitter_buffer.h"
+
 #include <memory>
 #include <mutex>
 #include <queue>
@@ -27,6 +29,7 @@
 
 class QAudioOutput;
 class QIODevice;
+class QTimer;
 
 namespace proto {
 class AudioPacket;
@@ -49,12 +52,17 @@ private:
     friend class QtAudioRenderer;
     bool init();
     void processEvents();
+    void pullAudio();
 
     std::queue<std::unique_ptr<proto::AudioPacket>> incoming_queue_;
     std::mutex incoming_queue_lock_;
 
+    // Accessed only on the worker thread.
+    AudioJitterBuffer jitter_buffer_;
+
     QAudioOutput* audio_output_ = nullptr;
     QIODevice* audio_device_ = nullptr;
+    QTimer* pull_timer_ = nullptr;
 };
 
 } // namespace client
@@ -41,6 +41,7 @@
 #include <QDesktopWidget>
 #include <QFileDialog>
 #include <QHBoxLayout>
+#include <QLabel>
 #include <QMessageBox>
 #include <QPalette>
 #include <QResizeEvent>
@@ -50,10 +51,23 @@
 #include <QTimer>
 #include <QWindow>
 
+#include <algorithm>
+
 namespace client {
 
 namespace {
 
+// Number of per-frame latency samples kept for the percentile calculation. At 30 frames per
+// second this is about 17 seconds of history.
+const size_t kLatencySampleCount = 512;
+
+// How often the latency overlay text is refreshed.
+const std::chrono::milliseconds kOverlayUpdateInterval{500};
+
+// Upper bound for converted platform cursors; matches the size of the shape cache in the
+// cursor decoder.
+const size_t kCursorCacheSize = 30;
+
 QSize scaledSize(const QSize& source_size, int scale)
 {
     if (scale == -1)
@@ -103,6 +117,13 @@ QtDesktopWindow::QtDesktopWindow(proto::SessionType session_type,
     scroll_timer_ = new QTimer(this);
     connect(scroll_timer_, &QTimer::timeout, this, &QtDesktopWindow::onScrollTimer);
 
+    latency_overlay_ = new QLabel(this);
+    latency_overlay_->setStyleSheet(
+        QLatin1String("background-color: rgba(0, 0, 0, 160); color: white; padding: 4px;"));
+    latency_overlay_->setAttribute(Qt::WA_TransparentForMouseEvents);
+    latency_overlay_->move(10, 10);
+    latency_overlay_->hide();
+
     desktop_->enableKeyCombinations(panel_->sendKeyCombinations());
 
     connect(panel_, &DesktopPanel::keyCombination, desktop_, &DesktopWidget::executeKeyCombination);
@@ -118,6 +139,12 @@ QtDesktopWindow::QtDesktopWindow(proto::SessionType session_type,
         desktop_control_proxy_->setCurrentScreen(screen);
     });
 
+    connect(panel_, &DesktopPanel::videoProfileChanged,
+            [this](const proto::VideoProfile& video_profile)
+    {
+        desktop_control_proxy_->setVideoProfile(video_profile);
+    });
+
     connect(panel_, &DesktopPanel::powerControl, [this](proto::PowerControl::Action action)
     {
         desktop_control_proxy_->onPowerControl(action);
@@ -138,6 +165,16 @@ QtDesktopWindow::QtDesktopWindow(proto::SessionType session_type,
         desktop_control_proxy_->onMetricsRequest();
     });
 
+    connect(panel_, &DesktopPanel::latencyOverlayChanged, [this](bool enabled)
+    {
+        latency_overlay_->setVisible(enabled);
+        if (enabled)
+        {
+            updateLatencyOverlay();
+            latency_overlay_->raise();
+        }
+    });
+
     connect(panel_, &DesktopPanel::switchToFullscreen, [this](bool fullscreen)
     {
         if (fullscreen)
@@ -304,7 +341,12 @@ void QtDesktopWindow::setMetrics(const DesktopWindow::Metrics& metrics)
         statistics_dialog_->activateWindow();
     }
 
-    statistics_dialog_->setMetrics(metrics);
+    DesktopWindow::Metrics full_metrics = metrics;
+    full_metrics.frame_latency_p50_us = latencyPercentile(50);
+    full_metrics.frame_latency_p90_us = latencyPercentile(90);
+    full_metrics.frame_latency_p99_us = latencyPercentile(99);
+
+    statistics_dialog_->setMetrics(full_metrics);
 }
 
 std::unique_ptr<FrameFactory> QtDesktopWindow::frameFactory()
@@ -329,21 +371,48 @@ void QtDesktopWindow::setFrame(
     }
 }
 
-void QtDesktopWindow::drawFrame()
+void QtDesktopWindow::drawFrame(const base::Region& updated_region, const FrameTiming& timing)
 {
-    desktop_->update();
+    desktop_->drawFrame(updated_region);
+    addLatencySample(timing);
 }
 
 void QtDesktopWindow::setMouseCursor(std::shared_ptr<base::MouseCursor> mouse_cursor)
 {
-    QImage image(mouse_cursor->constImage().data(),
-                 mouse_cursor->width(),
-                 mouse_cursor->height(),
-                 mouse_cursor->stride(),
-                 QImage::Format::Format_ARGB32);
-
-    desktop_->setCursor(QCursor(
-        QPixmap::fromImage(image), mouse_cursor->hotSpotX(), mouse_cursor->hotSpotY()));
+    auto it = std::find_if(cursor_cache_.begin(), cursor_cache_.end(),
+                           [&mouse_cursor](const auto& entry)
+    {
+        return entry.first == mouse_cursor;
+    });
+
+    if (it != cursor_cache_.end())
+    {
+        // Move the cursor to the most recently used position.
+        std::pair<std::shared_ptr<base::MouseCursor>, QCursor> entry = std::move(*it);
+
+        cursor_cache_.erase(it);
+        cursor_cache_.emplace_back(std::move(entry));
+    }
+    else
+    {
+        // The image is premultiplied and copied into a pixmap here; during drag operations the
+        // same few shapes alternate quickly, so the result is kept for reuse.
+        QImage image(mouse_cursor->constImage().data(),
+                     mouse_cursor->width(),
+                     mouse_cursor->height(),
+                     mouse_cursor->stride(),
+                     QImage::Format::Format_ARGB32);
+
+        QCursor cursor(QPixmap::fromImage(image),
+                       mouse_cursor->hotSpotX(), mouse_cursor->hotSpotY());
+
+        cursor_cache_.emplace_back(std::move(mouse_cursor), std::move(cursor));
+
+        if (cursor_cache_.size() > kCursorCacheSize)
+            cursor_cache_.erase(cursor_cache_.begin());
+    }
+
+    desktop_->setCursor(cursor_cache_.back().second);
 }
 
 void QtDesktopWindow::onMouseEvent(const proto::MouseEvent& event)
@@ -437,6 +506,18 @@ void QtDesktopWindow::resizeEvent(QResizeEvent* event)
     QWidget::resizeEvent(event);
 }
 
+void QtDesktopWindow::changeEvent(QEvent* event)
+{
+    if (event->type() == QEvent::WindowStateChange && desktop_control_proxy_)
+    {
+        // While the window is minimized the host captures only thumbnail frames; restoring
+        // the window brings the session back to the full rate.
+        desktop_control_proxy_->setViewerVisible(!(windowState() & Qt::WindowMinimized));
+    }
+
+    QWidget::changeEvent(event);
+}
+
 void QtDesktopWindow::leaveEvent(QEvent* event)
 {
     if (scroll_timer_->isActive())
@@ -621,4 +702,60 @@ void QtDesktopWindow::onScrollTimer()
     }
 }
 
+void QtDesktopWindow::addLatencySample(const FrameTiming& timing)
+{
+    // The sample covers the host part (capture to network handoff) plus everything the client
+    // did with the packet up to handing the damaged area to Qt for painting. Network transit
+    // time is not included; see FrameTiming.
+    uint64_t client_latency_us = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - timing.receive_time).count());
+    uint64_t sample = timing.host_latency_us + client_latency_us;
+
+    if (latency_samples_.size() < kLatencySampleCount)
+    {
+        latency_samples_.push_back(sample);
+    }
+    else
+    {
+        latency_samples_[latency_sample_pos_] = sample;
+        latency_sample_pos_ = (latency_sample_pos_ + 1) % kLatencySampleCount;
+    }
+
+    if (latency_overlay_->isVisible())
+    {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (now - last_overlay_update_ >= kOverlayUpdateInterval)
+        {
+            last_overlay_update_ = now;
+            updateLatencyOverlay();
+        }
+    }
+}
+
+uint64_t QtDesktopWindow::latencyPercentile(int percent) const
+{
+    if (latency_samples_.empty())
+        return 0;
+
+    std::vector<uint64_t> sorted(latency_samples_);
+    size_t index = (sorted.size() - 1) * static_cast<size_t>(percent) / 100;
+
+    std::nth_element(sorted.begin(), sorted.begin() + static_cast<ptrdiff_t>(index), sorted.end());
+    return sorted[index];
+}
+
+void QtDesktopWindow::updateLatencyOverlay()
+{
+    latency_overlay_->setText(
+        QString("Latency (without network): p50 %1 ms / p90 %2 ms / p99 %3 ms\n"
+                "Frames: %4 painted / %5 dropped")
+            .arg(static_cast<double>(latencyPercentile(50)) / 1000.0, 0, 'f', 1)
+            .arg(static_cast<double>(latencyPercentile(90)) / 1000.0, 0, 'f', 1)
+            .arg(static_cast<double>(latencyPercentile(99)) / 1000.0, 0, 'f', 1)
+            .arg(static_cast<qulonglong>(desktop_->paintedFrames()))
+            .arg(static_cast<qulonglong>(desktop_->droppedFrames())));
+    latency_overlay_->adjustSize();
+}
+
 } // namespace client
@@ -25,9 +25,14 @@
 #include "client/ui/client_window.h"
 #include "client/ui/desktop_widget.h"
 
+#include <QCursor>
 #include <QPointer>
 
+#include <chrono>
+#include <vector>
+
 class QHBoxLayout;
+class QLabel;
 class QScrollArea;
 
 namespace desktop {
@@ -68,7 +73,7 @@ public:
     void setMetrics(const DesktopWindow::Metrics& metrics) override;
     std::unique_ptr<FrameFactory> frameFactory() override;
     void setFrame(const base::Size& screen_size, std::shared_ptr<base::Frame> frame) override;
-    void drawFrame() override;
+    void drawFrame(const base::Region& updated_region, const FrameTiming& timing) override;
     void setMouseCursor(std::shared_ptr<base::MouseCursor> mouse_cursor) override;
 
     // DesktopWidget::Delegate implementation.
@@ -80,6 +85,7 @@ protected:
     // QWidget implementation.
     void resizeEvent(QResizeEvent* event) override;
     void leaveEvent(QEvent* event) override;
+    void changeEvent(QEvent* event) override;
     bool eventFilter(QObject* object, QEvent* event) override;
 
 private slots:
@@ -92,6 +98,10 @@ private slots:
     void onScrollTimer();
 
 private:
+    void addLatencySample(const FrameTiming& timing);
+    uint64_t latencyPercentile(int percent) const;
+    void updateLatencyOverlay();
+
     const proto::SessionType session_type_;
     proto::DesktopConfig desktop_config_;
 
@@ -115,6 +125,18 @@ private:
 
     bool is_maximized_ = false;
 
+    // Platform cursors converted from decoded shapes, ordered from the least to the most
+    // recently used. Keyed by object identity: the cursor decoder returns the same object for
+    // every repeated use of a cached shape.
+    std::vector<std::pair<std::shared_ptr<base::MouseCursor>, QCursor>> cursor_cache_;
+
+    // Ring of capture-to-render latency samples, one per decoded video packet. Network transit
+    // time is not included because the clocks of the two machines are not synchronized.
+    std::vector<uint64_t> latency_samples_;
+    size_t latency_sample_pos_ = 0;
+    QLabel* latency_overlay_ = nullptr;
+    std::chrono::steady_clock::time_point last_overlay_update_;
+
     DISALLOW_COPY_AND_ASSIGN(QtDesktopWindow);
 };
 
@@ -115,6 +115,9 @@ RouterManagerWindow::RouterManagerWindow(QWidget* parent)
     connect(ui->button_refresh_hosts, &QPushButton::released,
             this, &RouterManagerWindow::refreshHostList);
 
+    connect(ui->edit_host_filter, &QLineEdit::returnPressed,
+            this, &RouterManagerWindow::refreshHostList);
+
     connect(ui->button_disconnect_host, &QPushButton::released,
             this, &RouterManagerWindow::disconnectHost);
 
@@ -186,12 +189,9 @@ void RouterManagerWindow::onConnected(const base::Version& peer_version)
     show();
     activateWindow();
 
-    if (router_proxy_)
-    {
-        router_proxy_->refreshHostList();
-        router_proxy_->refreshRelayList();
-        router_proxy_->refreshUserList();
-    }
+    refreshHostList();
+    refreshRelayList();
+    refreshUserList();
 }
 
 void RouterManagerWindow::onDisconnected(base::NetworkChannel::ErrorCode error_code)
@@ -286,13 +286,22 @@ void RouterManagerWindow::onAccessDenied(base::ClientAuthenticator::ErrorCode er
 void RouterManagerWindow::onHostList(std::shared_ptr<proto::HostList> host_list)
 {
     QTreeWidget* tree_hosts = ui->tree_hosts;
-    tree_hosts->clear();
 
-    int host_size = host_list->host_size();
-
-    for (int i = 0; i < host_size; ++i)
+    // The list arrives in pages; the tree was cleared when the refresh started.
+    for (int i = 0; i < host_list->host_size(); ++i)
         tree_hosts->addTopLevelItem(new HostTreeItem(host_list->host(i)));
-    ui->label_hosts_conn_count->setText(QString::number(host_size));
+    ui->label_hosts_conn_count->setText(QString::number(tree_hosts->topLevelItemCount()));
+
+    host_cursor_ = host_list->next_cursor();
+
+    if (host_list->has_more())
+    {
+        if (router_proxy_)
+            router_proxy_->refreshHostList(host_cursor_, host_filter_);
+        return;
+    }
+
+    host_refresh_active_ = false;
 
     for (int i = 0; i < tree_hosts->columnCount(); ++i)
         tree_hosts->resizeColumnToContents(i);
@@ -336,15 +345,52 @@ void RouterManagerWindow::onHostResult(std::shared_ptr<proto::HostResult> host_r
     afterRequest();
 }
 
+void RouterManagerWindow::onHostStatusEvent(std::shared_ptr<proto::HostStatusEvent> event)
+{
+    if (host_refresh_active_)
+        return;
+
+    QTreeWidget* tree_hosts = ui->tree_hosts;
+
+    // A reconnect arrives as HOST_CONNECTED for a session id that is already displayed, so a
+    // connect event always replaces an existing row.
+    int index = findHostItem(event->session_id());
+    if (index != -1)
+        delete tree_hosts->takeTopLevelItem(index);
+
+    if (event->type() == proto::HostStatusEvent::HOST_CONNECTED)
+    {
+        const proto::Host& host = event->host();
+
+        // The router does not filter pushed events; apply the filter of the current view.
+        QString filter = ui->edit_host_filter->text();
+        if (filter.isEmpty() ||
+            QString::fromStdString(host.computer_name()).contains(filter, Qt::CaseInsensitive) ||
+            QString::fromStdString(host.ip_address()).contains(filter, Qt::CaseInsensitive))
+        {
+            tree_hosts->addTopLevelItem(new HostTreeItem(host));
+        }
+    }
+
+    ui->label_hosts_conn_count->setText(QString::number(tree_hosts->topLevelItemCount()));
+}
+
 void RouterManagerWindow::onRelayList(std::shared_ptr<proto::RelayList> relay_list)
 {
     QTreeWidget* tree_relay = ui->tree_relay;
-    tree_relay->clear();
 
-    int relay_size = relay_list->relay_size();
-    for (int i = 0; i < relay_size; ++i)
+    for (int i = 0; i < relay_list->relay_size(); ++i)
         tree_relay->addTopLevelItem(new RelayTreeItem(relay_list->relay(i)));
-    ui->label_relay_conn_count->setText(QString::number(relay_size));
+    ui->label_relay_conn_count->setText(QString::number(tree_relay->topLevelItemCount()));
+
+    relay_cursor_ = relay_list->next_cursor();
+
+    if (relay_list->has_more())
+    {
+        if (router_proxy_)
+            router_proxy_->refreshRelayList(relay_cursor_);
+        return;
+    }
 
     for (int i = 0; i < tree_relay->columnCount(); ++i)
         tree_relay->resizeColumnToContents(i);
@@ -355,11 +401,19 @@ void RouterManagerWindow::onRelayList(std::shared_ptr<proto::RelayList> relay_li
 void RouterManagerWindow::onUserList(std::shared_ptr<proto::UserList> user_list)
 {
     QTreeWidget* tree_users = ui->tree_users;
-    tree_users->clear();
 
     for (int i = 0; i < user_list->user_size(); ++i)
         tree_users->addTopLevelItem(new UserTreeItem(user_list->user(i)));
 
+    user_cursor_ = user_list->next_cursor();
+
+    if (user_list->has_more())
+    {
+        if (router_proxy_)
+            router_proxy_->refreshUserList(user_cursor_);
+        return;
+    }
+
     afterRequest();
 }
 
@@ -406,7 +460,13 @@ void RouterManagerWindow::refreshHostList()
     if (router_proxy_)
     {
         beforeRequest();
-        router_proxy_->refreshHostList();
+
+        ui->tree_hosts->clear();
+        host_cursor_ = 0;
+        host_filter_ = ui->edit_host_filter->text().toStdString();
+        host_refresh_active_ = true;
+
+        router_proxy_->refreshHostList(host_cursor_, host_filter_);
     }
 }
 
@@ -465,7 +525,11 @@ void RouterManagerWindow::refreshRelayList()
     if (router_proxy_)
     {
         beforeRequest();
-        router_proxy_->refreshRelayList();
+
+        ui->tree_relay->clear();
+        relay_cursor_ = 0;
+
+        router_proxy_->refreshRelayList(relay_cursor_);
     }
 }
 
@@ -474,7 +538,11 @@ void RouterManagerWindow::refreshUserList()
     if (router_proxy_)
     {
         beforeRequest();
-        router_proxy_->refreshUserList();
+
+        ui->tree_users->clear();
+        user_cursor_ = 0;
+
+        router_proxy_->refreshUserList(user_cursor_);
     }
 }
 
@@ -608,6 +676,20 @@ void RouterManagerWindow::onCurrentHostChanged(QTreeWidgetItem* current, QTreeWi
     }
 }
 
+int RouterManagerWindow::findHostItem(uint64_t session_id) const
+{
+    QTreeWidget* tree_hosts = ui->tree_hosts;
+
+    for (int i = 0; i < tree_hosts->topLevelItemCount(); ++i)
+    {
+        HostTreeItem* item = static_cast<HostTreeItem*>(tree_hosts->topLevelItem(i));
+        if (item->host.session_id() == session_id)
+            return i;
+    }
+
+    return -1;
+}
+
 void RouterManagerWindow::beforeRequest()
 {
     ui->tab->setEnabled(false);
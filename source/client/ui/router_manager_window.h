@@ -55,6 +55,7 @@ public:
     void onAccessDenied(base::ClientAuthenticator::ErrorCode error_code) override;
     void onHostList(std::shared_ptr<proto::HostList> peer_list) override;
     void onHostResult(std::shared_ptr<proto::HostResult> peer_result) override;
+    void onHostStatusEvent(std::shared_ptr<proto::HostStatusEvent> event) override;
     void onRelayList(std::shared_ptr<proto::RelayList> relay_list) override;
     void onUserList(std::shared_ptr<proto::UserList> user_list) override;
     void onUserResult(std::shared_ptr<proto::UserResult> user_result) override;
@@ -78,6 +79,9 @@ private:
     void beforeRequest();
     void afterRequest();
 
+    // Returns the index of the host row with |session_id|, or -1 if there is none.
+    int findHostItem(uint64_t session_id) const;
+
     std::unique_ptr<Ui::RouterManagerWindow> ui;
 
     QString peer_address_;
@@ -88,6 +92,20 @@ private:
     std::shared_ptr<RouterWindowProxy> window_proxy_;
     std::unique_ptr<RouterProxy> router_proxy_;
 
+    // Cursors of the list refreshes in progress. Lists arrive in pages; each page is appended
+    // to the model and the next one is requested until the router reports the end of the list.
+    uint64_t host_cursor_ = 0;
+    uint64_t relay_cursor_ = 0;
+    uint64_t user_cursor_ = 0;
+
+    // Filter of the host list refresh in progress. Continuation pages must use the filter the
+    // refresh was started with, even if the filter field has changed since.
+    std::string host_filter_;
+
+    // Set while host list pages are being received. Status events pushed by the router are
+    // ignored until the snapshot is complete, so they cannot duplicate rows of later pages.
+    bool host_refresh_active_ = false;
+
     DISALLOW_COPY_AND_ASSIGN(RouterManagerWindow);
 };
 
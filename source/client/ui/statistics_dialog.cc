@@ -111,6 +111,58 @@ void StatisticsDialog::setMetrics(const DesktopWindow::Metrics& metrics)
             case 16:
                 item->setText(1, QString::number(metrics.send_clipboard));
                 break;
+
+            case 17:
+                item->setText(1, timeToString(metrics.host_capture_interval_us));
+                break;
+
+            case 18:
+                item->setText(1, timeToString(metrics.host_scale_us));
+                break;
+
+            case 19:
+                item->setText(1, timeToString(metrics.host_encode_avg_us));
+                break;
+
+            case 20:
+                item->setText(1, timeToString(metrics.host_encode_max_us));
+                break;
+
+            case 21:
+                item->setText(1, timeToString(metrics.host_send_us));
+                break;
+
+            case 22:
+                item->setText(1, timeToString(metrics.host_network_write_us));
+                break;
+
+            case 23:
+                item->setText(1, QString::number(metrics.host_pending_messages));
+                break;
+
+            case 24:
+                item->setText(1, timeToString(metrics.frame_latency_p50_us));
+                break;
+
+            case 25:
+                item->setText(1, timeToString(metrics.frame_latency_p90_us));
+                break;
+
+            case 26:
+                item->setText(1, timeToString(metrics.frame_latency_p99_us));
+                break;
+
+            case 27:
+                item->setText(1, QString::number(metrics.host_network_queue_depth_max));
+                break;
+
+            case 28:
+                item->setText(1, timeToString(metrics.host_network_queue_age_us));
+                break;
+
+            case 29:
+                item->setText(1, QString::number(metrics.host_ipc_queue_depth_max));
+                break;
         }
     }
 }
@@ -199,4 +251,10 @@ QString StatisticsDialog::speedToString(int64_t speed)
         .arg(units);
 }
 
+// static
+QString StatisticsDialog::timeToString(uint64_t time_us)
+{
+    return QString("%1 ms").arg(static_cast<double>(time_us) / 1000.0, 0, 'f', 2);
+}
+
 } // namespace client
@@ -43,6 +43,7 @@ signals:
 private:
     static QString sizeToString(int64_t size);
     static QString speedToString(int64_t speed);
+    static QString timeToString(uint64_t time_us);
 
     Ui::StatisticsDialog ui;
     QTimer* update_timer_ = nullptr;
@@ -20,6 +20,8 @@
 
 #include "base/logging.h"
 
+#include <algorithm>
+
 #include <zstd.h>
 
 namespace common {
@@ -35,6 +37,15 @@ const int kCompressionRatio = 8;
 // Smaller data will not be compressed.
 const size_t kMinSizeToCompress = 512;
 
+// Payloads larger than this are split into chunks of this size. Each chunk travels as its own
+// message, so video and input traffic interleave between the chunks instead of waiting behind
+// one huge message.
+const size_t kMaxChunkSize = 512 * 1024;
+
+// Upper bound for an announced chunked payload; protects the receiver from allocating an
+// absurd reassembly buffer.
+const size_t kMaxPayloadSize = 1024 * 1024 * 1024;
+
 uint8_t* outputBuffer(std::string* out, size_t size)
 {
     out->resize(size);
@@ -109,23 +120,70 @@ void Clipboard::start(Delegate* delegate)
 
 void Clipboard::injectClipboardEvent(const proto::ClipboardEvent& event)
 {
-    if (event.mime_type() == kMimeTypeCompressedTextUtf8)
+    if (event.total_size() != 0)
+    {
+        // One chunk of a larger payload.
+        if (event.total_size() > kMaxPayloadSize)
+        {
+            LOG(LS_ERROR) << "Clipboard payload too large: " << event.total_size();
+            chunk_buffer_.clear();
+            chunk_mime_type_.clear();
+            return;
+        }
+
+        if (event.offset() == 0)
+        {
+            // First chunk; any unfinished transfer is discarded.
+            chunk_mime_type_ = event.mime_type();
+            chunk_buffer_.clear();
+            chunk_buffer_.reserve(static_cast<size_t>(event.total_size()));
+        }
+        else if (event.offset() != chunk_buffer_.size() ||
+                 event.mime_type() != chunk_mime_type_)
+        {
+            LOG(LS_ERROR) << "Unexpected clipboard chunk at offset " << event.offset();
+            chunk_buffer_.clear();
+            chunk_mime_type_.clear();
+            return;
+        }
+
+        chunk_buffer_ += event.data();
+
+        if (chunk_buffer_.size() < event.total_size())
+            return;
+
+        std::string mime_type = std::move(chunk_mime_type_);
+        std::string data = std::move(chunk_buffer_);
+
+        chunk_mime_type_.clear();
+        chunk_buffer_.clear();
+
+        injectData(mime_type, data);
+        return;
+    }
+
+    injectData(event.mime_type(), event.data());
+}
+
+void Clipboard::injectData(const std::string& mime_type, const std::string& data)
+{
+    if (mime_type == kMimeTypeCompressedTextUtf8)
     {
         std::string decompressed_data;
-        if (!decompress(event.data(), &decompressed_data))
+        if (!decompress(data, &decompressed_data))
             return;
 
         // Store last injected data.
         last_data_ = std::move(decompressed_data);
     }
-    else if (event.mime_type() == kMimeTypeTextUtf8)
+    else if (mime_type == kMimeTypeTextUtf8)
     {
         // Store last injected data.
-        last_data_ = event.data();
+        last_data_ = data;
     }
     else
     {
-        LOG(LS_WARNING) << "Unsupported mime type: " << event.mime_type();
+        LOG(LS_WARNING) << "Unsupported mime type: " << mime_type;
         return;
     }
 
@@ -137,25 +195,48 @@ void Clipboard::onData(const std::string& data)
     if (last_data_ == data)
         return;
 
-    proto::ClipboardEvent event;
+    if (!delegate_)
+        return;
+
+    std::string mime_type;
+    std::string payload;
 
     if (data.size() > kMinSizeToCompress)
     {
-        std::string compressed_data;
-        if (!compress(data, &compressed_data))
+        if (!compress(data, &payload))
             return;
 
-        event.set_mime_type(kMimeTypeCompressedTextUtf8);
-        event.set_data(std::move(compressed_data));
+        mime_type = kMimeTypeCompressedTextUtf8;
     }
     else
     {
-        event.set_mime_type(kMimeTypeTextUtf8);
-        event.set_data(std::move(data));
+        mime_type = kMimeTypeTextUtf8;
+        payload = data;
     }
 
-    if (delegate_)
+    if (payload.size() <= kMaxChunkSize)
+    {
+        proto::ClipboardEvent event;
+        event.set_mime_type(mime_type);
+        event.set_data(std::move(payload));
+
         delegate_->onClipboardEvent(event);
+        return;
+    }
+
+    // Stream the payload in chunks.
+    for (size_t offset = 0; offset < payload.size(); offset += kMaxChunkSize)
+    {
+        const size_t chunk_size = std::min(kMaxChunkSize, payload.size() - offset);
+
+        proto::ClipboardEvent event;
+        event.set_mime_type(mime_type);
+        event.set_total_size(payload.size());
+        event.set_offset(offset);
+        event.set_data(payload.substr(offset, chunk_size));
+
+        delegate_->onClipboardEvent(event);
+    }
 }
 
 } // namespace common
@@ -49,8 +49,15 @@ protected:
     void onData(const std::string& data);
 
 private:
+    void injectData(const std::string& mime_type, const std::string& data);
+
     Delegate* delegate_ = nullptr;
     std::string last_data_;
+
+    // Reassembly state of a chunked transfer in progress. Chunks arrive in order; |chunk_buffer_|
+    // grows until it reaches the announced total size.
+    std::string chunk_buffer_;
+    std::string chunk_mime_type_;
 };
 
 } // namespace common
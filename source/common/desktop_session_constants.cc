@@ -27,14 +27,28 @@ const char kPreferredSizeExtension[] = "preferred_size";
 const char kPowerControlExtension[] = "power_control";
 const char kRemoteUpdateExtension[] = "remote_update";
 const char kSystemInfoExtension[] = "system_info";
+const char kPipelineStatsExtension[] = "pipeline_stats";
+const char kVideoRecoveryExtension[] = "video_recovery";
+const char kVideoProfileExtension[] = "video_profile";
+const char kViewerStateExtension[] = "viewer_state";
+const char kBandwidthEstimateExtension[] = "bandwidth_estimate";
+const char kScreenThumbnailExtension[] = "screen_thumbnail";
+const char kCaptureRegionExtension[] = "capture_region";
+const char kFrameHashExtension[] = "frame_hash";
 
 const char kSupportedExtensionsForManage[] =
-    "select_screen;preferred_size;power_control;remote_update;system_info";
+    "select_screen;preferred_size;power_control;remote_update;system_info;pipeline_stats;"
+    "video_recovery;video_profile;viewer_state;bandwidth_estimate;screen_thumbnail;"
+    "capture_region;frame_hash";
 
 const char kSupportedExtensionsForView[] =
-    "select_screen;preferred_size;system_info";
+    "select_screen;preferred_size;system_info;pipeline_stats;video_recovery;video_profile;"
+    "viewer_state;bandwidth_estimate;screen_thumbnail;capture_region;frame_hash";
 
 const uint32_t kSupportedVideoEncodings = proto::VIDEO_ENCODING_VP8 | proto::VIDEO_ENCODING_VP9;
 const uint32_t kSupportedAudioEncodings = proto::AUDIO_ENCODING_OPUS;
 
+const uint8_t kClipboardStreamId = 1;
+const uint8_t kVideoStreamId = 2;
+
 } // namespace common
@@ -28,6 +28,14 @@ extern const char kPreferredSizeExtension[];
 extern const char kPowerControlExtension[];
 extern const char kRemoteUpdateExtension[];
 extern const char kSystemInfoExtension[];
+extern const char kPipelineStatsExtension[];
+extern const char kVideoRecoveryExtension[];
+extern const char kVideoProfileExtension[];
+extern const char kViewerStateExtension[];
+extern const char kBandwidthEstimateExtension[];
+extern const char kScreenThumbnailExtension[];
+extern const char kCaptureRegionExtension[];
+extern const char kFrameHashExtension[];
 
 extern const char kSupportedExtensionsForManage[];
 extern const char kSupportedExtensionsForView[];
@@ -35,6 +43,16 @@ extern const char kSupportedExtensionsForView[];
 extern const uint32_t kSupportedVideoEncodings;
 extern const uint32_t kSupportedAudioEncodings;
 
+// Auxiliary network channel stream carrying chunked clipboard transfers. Bulk clipboard chunks
+// are scheduled round-robin with the default stream, so a large copy does not stall video and
+// input traffic.
+extern const uint8_t kClipboardStreamId;
+
+// Bulk stream carrying encoded video from host to client. Keeping video off the default stream
+// lets queued frames be dropped when they are superseded and keeps input and control messages
+// ahead of queued frames when bandwidth collapses.
+extern const uint8_t kVideoStreamId;
+
 } // namespace common
 
 #endif // COMMON__DESKTOP_SESSION_CONSTANTS_H
@@ -22,6 +22,15 @@
 
 namespace common {
 
+namespace {
+
+// Size at which the write buffer is handed to the file system. Large sequential writes keep a
+// fast network link from stalling on per-chunk disk latency; the page cache of the system
+// flushes them in the background.
+const size_t kWriteBufferSize = 4 * 1024 * 1024; // 4 MB.
+
+} // namespace
+
 FileDepacketizer::FileDepacketizer(const std::filesystem::path& file_path,
                                    std::ofstream&& file_stream)
     : file_path_(file_path),
@@ -35,11 +44,21 @@ FileDepacketizer::~FileDepacketizer()
     // If the file is opened, it was not completely written.
     if (file_stream_.is_open())
     {
+        // After a lost connection the data received so far is flushed and the partial file is
+        // kept: a repeated transfer with the replace action continues through the delta
+        // mechanism, which verifies the existing blocks by checksums and sends only the rest.
+        if (!canceled_)
+            flushBuffer();
+
         file_stream_.close();
 
-        // The transfer of files was canceled. Delete the file.
-        std::error_code ignored_error;
-        std::filesystem::remove(file_path_, ignored_error);
+        // An explicitly canceled transfer deletes the unfinished file. A delta update is done
+        // in place, so the existing file is kept.
+        if (!delta_mode_ && canceled_)
+        {
+            std::error_code ignored_error;
+            std::filesystem::remove(file_path_, ignored_error);
+        }
     }
 }
 
@@ -62,17 +81,80 @@ std::unique_ptr<FileDepacketizer> FileDepacketizer::create(
         new FileDepacketizer(file_path, std::move(file_stream)));
 }
 
+// static
+std::unique_ptr<FileDepacketizer> FileDepacketizer::createForDelta(
+    const std::filesystem::path& file_path)
+{
+    // Open the existing file for updating in place, without truncation.
+    std::ofstream file_stream;
+
+    file_stream.open(file_path, std::ofstream::binary | std::ofstream::in | std::ofstream::out);
+    if (!file_stream.is_open())
+        return nullptr;
+
+    std::unique_ptr<FileDepacketizer> depacketizer(
+        new FileDepacketizer(file_path, std::move(file_stream)));
+    depacketizer->delta_mode_ = true;
+    return depacketizer;
+}
+
 bool FileDepacketizer::writeNextPacket(const proto::FilePacket& packet)
 {
     DCHECK(file_stream_.is_open());
 
+    if (delta_mode_)
+        return writeNextDeltaPacket(packet);
+
+    // A hole packet describes a region of zeros without carrying it. Nothing is written: the
+    // file gets its final size with the first packet and the skipped region reads as zeros.
+    if (packet.flags() & proto::FilePacket::HOLE)
+    {
+        if (packet.flags() & proto::FilePacket::FIRST_PACKET)
+        {
+            file_size_ = packet.file_size();
+            left_size_ = file_size_;
+
+            std::error_code ignored_code;
+            std::filesystem::resize_file(file_path_, file_size_, ignored_code);
+        }
+
+        if (!packet.hole_size() || packet.hole_size() > left_size_)
+        {
+            LOG(LS_WARNING) << "Wrong hole size";
+            return false;
+        }
+
+        // Mirrors the source: a hole contributes its size to the digest, not its zero content.
+        const uint64_t hole_size = packet.hole_size();
+        transfer_hash_.addData(&hole_size, sizeof(hole_size));
+
+        left_size_ -= packet.hole_size();
+
+        if (packet.flags() & proto::FilePacket::LAST_PACKET)
+        {
+            if (!flushBuffer())
+                return false;
+
+            if (!verifyChecksum(packet))
+                return false;
+
+            file_size_ = 0;
+            file_stream_.close();
+        }
+
+        return true;
+    }
+
     const size_t packet_size = packet.data().size();
     if (!packet_size)
     {
         // If an empty data packet with the last packet flag set is received, the transfer
         // is canceled.
         if (packet.flags() & proto::FilePacket::LAST_PACKET)
+        {
+            canceled_ = true;
             return true;
+        }
 
         LOG(LS_WARNING) << "Wrong packet size";
         return false;
@@ -83,20 +165,42 @@ bool FileDepacketizer::writeNextPacket(const proto::FilePacket& packet)
     {
         file_size_ = packet.file_size();
         left_size_ = file_size_;
+
+        // Give the file system the final size up front. The space is allocated in one piece
+        // instead of growing with every chunk, so the file does not fragment, and an existing
+        // longer file is cut to the new size right away.
+        std::error_code ignored_code;
+        std::filesystem::resize_file(file_path_, file_size_, ignored_code);
     }
 
-    file_stream_.seekp(file_size_ - left_size_);
-    file_stream_.write(packet.data().data(), packet_size);
-    if (file_stream_.fail())
+    const uint64_t offset = file_size_ - left_size_;
+
+    size_t written_size = packet_size;
+
+    if (packet.flags() & proto::FilePacket::COMPRESSED)
     {
-        LOG(LS_WARNING) << "Unable to write file";
-        return false;
+        int64_t decompressed_size = writeCompressedData(packet, offset);
+        if (decompressed_size < 0)
+            return false;
+
+        written_size = static_cast<size_t>(decompressed_size);
+    }
+    else
+    {
+        if (!bufferData(packet.data().data(), packet_size, offset))
+            return false;
     }
 
-    left_size_ -= packet_size;
+    left_size_ -= written_size;
 
     if (packet.flags() & proto::FilePacket::LAST_PACKET)
     {
+        if (!flushBuffer())
+            return false;
+
+        if (!verifyChecksum(packet))
+            return false;
+
         file_size_ = 0;
         file_stream_.close();
     }
@@ -104,4 +208,152 @@ bool FileDepacketizer::writeNextPacket(const proto::FilePacket& packet)
     return true;
 }
 
+bool FileDepacketizer::writeNextDeltaPacket(const proto::FilePacket& packet)
+{
+    // Every delta packet carries the final size of the file, except the empty finishing packet
+    // of a canceled transfer.
+    if (packet.file_size() || (packet.flags() & proto::FilePacket::FIRST_PACKET))
+        file_size_ = packet.file_size();
+
+    if (!packet.data().empty())
+    {
+        if (packet.flags() & proto::FilePacket::COMPRESSED)
+        {
+            if (writeCompressedData(packet, packet.offset()) < 0)
+                return false;
+        }
+        else
+        {
+            if (!bufferData(packet.data().data(), packet.data().size(), packet.offset()))
+                return false;
+        }
+    }
+
+    if (packet.flags() & proto::FilePacket::LAST_PACKET)
+    {
+        if (!flushBuffer())
+            return false;
+
+        if (!verifyChecksum(packet))
+            return false;
+
+        file_stream_.close();
+
+        // An empty last packet without the first packet flag and without a file size means the
+        // transfer was canceled; the existing content is kept as is.
+        const bool canceled = packet.data().empty() && !packet.file_size() &&
+                              !(packet.flags() & proto::FilePacket::FIRST_PACKET);
+        if (!canceled)
+        {
+            // The new content can be shorter than the old one.
+            std::error_code ignored_code;
+            std::filesystem::resize_file(file_path_, file_size_, ignored_code);
+        }
+    }
+
+    return true;
+}
+
+int64_t FileDepacketizer::writeCompressedData(const proto::FilePacket& packet, uint64_t offset)
+{
+    if (!dstream_)
+    {
+        dstream_.reset(ZSTD_createDStream());
+        if (!dstream_)
+            return -1;
+    }
+
+    // Every compressed packet is an independent zstd frame.
+    size_t ret = ZSTD_initDStream(dstream_.get());
+    DCHECK(!ZSTD_isError(ret)) << ZSTD_getErrorName(ret);
+
+    char output_buffer[8 * 1024];
+    int64_t written_size = 0;
+
+    ZSTD_inBuffer input = { packet.data().data(), packet.data().size(), 0 };
+
+    while (input.pos < input.size)
+    {
+        ZSTD_outBuffer output = { output_buffer, sizeof(output_buffer), 0 };
+
+        ret = ZSTD_decompressStream(dstream_.get(), &output, &input);
+        if (ZSTD_isError(ret))
+        {
+            LOG(LS_WARNING) << "ZSTD_decompressStream failed: " << ZSTD_getErrorName(ret);
+            return -1;
+        }
+
+        if (!bufferData(output_buffer, output.pos, offset + written_size))
+            return -1;
+
+        written_size += output.pos;
+    }
+
+    return written_size;
+}
+
+bool FileDepacketizer::bufferData(const char* data, size_t size, uint64_t offset)
+{
+    // Every chunk passes through here exactly once and in transfer order (compressed packets
+    // are decompressed first), which makes it the natural place to feed the digest. The data
+    // is still hot in the cache, so verification adds no extra pass over the file.
+    transfer_hash_.addData(data, size);
+
+
+    if (!write_buffer_.empty() && offset != buffer_offset_ + write_buffer_.size())
+    {
+        // Delta packets can jump within the file; the buffered run ends here.
+        if (!flushBuffer())
+            return false;
+    }
+
+    if (write_buffer_.empty())
+        buffer_offset_ = offset;
+
+    write_buffer_.insert(write_buffer_.end(),
+                         reinterpret_cast<const uint8_t*>(data),
+                         reinterpret_cast<const uint8_t*>(data) + size);
+
+    if (write_buffer_.size() >= kWriteBufferSize)
+        return flushBuffer();
+
+    return true;
+}
+
+bool FileDepacketizer::flushBuffer()
+{
+    if (write_buffer_.empty())
+        return true;
+
+    file_stream_.seekp(static_cast<std::streamoff>(buffer_offset_));
+    file_stream_.write(reinterpret_cast<const char*>(write_buffer_.data()),
+                       static_cast<std::streamsize>(write_buffer_.size()));
+    if (file_stream_.fail())
+    {
+        LOG(LS_WARNING) << "Unable to write file";
+        return false;
+    }
+
+    buffer_offset_ += write_buffer_.size();
+
+    // The capacity is kept, so the buffer of a long transfer settles at its full size.
+    write_buffer_.clear();
+    return true;
+}
+
+bool FileDepacketizer::verifyChecksum(const proto::FilePacket& packet)
+{
+    // No checksum: the source predates verification or the transfer was canceled.
+    if (packet.checksum().empty())
+        return true;
+
+    if (base::toStdString(transfer_hash_.result()) != packet.checksum())
+    {
+        LOG(LS_ERROR) << "Transfer checksum mismatch; the written file is corrupted";
+        return false;
+    }
+
+    return true;
+}
+
 } // namespace common
@@ -20,6 +20,9 @@
 #define COMMON__FILE_DEPACKETIZER_H
 
 #include "base/macros_magic.h"
+#include "base/codec/scoped_zstd_stream.h"
+#include "base/crypto/generic_hash.h"
+#include "base/memory/byte_array.h"
 #include "proto/file_transfer.pb.h"
 
 #include <filesystem>
@@ -36,18 +39,59 @@ public:
     static std::unique_ptr<FileDepacketizer> create(const std::filesystem::path& file_path,
                                                     bool overwrite);
 
+    // Opens an existing file for a delta update: packets carry offsets and only the changed
+    // regions of the file; the rest of the content is kept.
+    static std::unique_ptr<FileDepacketizer> createForDelta(
+        const std::filesystem::path& file_path);
+
     // Reads the packet and writes its contents to a file.
     bool writeNextPacket(const proto::FilePacket& packet);
 
 private:
     FileDepacketizer(const std::filesystem::path& file_path, std::ofstream&& file_stream);
 
+    bool writeNextDeltaPacket(const proto::FilePacket& packet);
+
+    // Decompresses the packet data and buffers it for writing at |offset|. Returns the number
+    // of written bytes or -1 on failure.
+    int64_t writeCompressedData(const proto::FilePacket& packet, uint64_t offset);
+
+    // Appends |size| bytes at file position |offset| to the write buffer. A non-contiguous
+    // offset or a full buffer flushes the buffered data first.
+    bool bufferData(const char* data, size_t size, uint64_t offset);
+
+    // Writes the buffered data to the file in one call.
+    bool flushBuffer();
+
+    // Compares the accumulated digest with the checksum of the last packet. Returns true when
+    // they match or the packet carries no checksum (older sender or canceled transfer).
+    bool verifyChecksum(const proto::FilePacket& packet);
+
     std::filesystem::path file_path_;
     std::ofstream file_stream_;
+    base::ScopedZstdDStream dstream_;
+
+    // Arriving chunks are collected here and written in multi-megabyte pieces, so the disk
+    // sees large sequential writes instead of one small write per network packet.
+    base::ByteArray write_buffer_;
+    uint64_t buffer_offset_ = 0;
 
     uint64_t file_size_ = 0;
     uint64_t left_size_ = 0;
 
+    // Running digest of the received content, fed with every chunk as it passes through the
+    // write buffer and compared with the checksum of the last packet.
+    base::GenericHash transfer_hash_{ base::GenericHash::BLAKE2s256 };
+
+    // In delta mode the existing file is updated in place and is kept when the transfer is
+    // canceled.
+    bool delta_mode_ = false;
+
+    // Set when the sending side explicitly cancels the transfer. A file interrupted in any
+    // other way (for example by a lost connection) is kept, so a repeated transfer can resume
+    // from it through a delta update.
+    bool canceled_ = false;
+
     DISALLOW_COPY_AND_ASSIGN(FileDepacketizer);
 };
 
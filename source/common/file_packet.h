@@ -25,6 +25,13 @@ namespace common {
 // This parameter specifies the size of the part.
 static const size_t kMaxFilePacketSize = 16 * 1024; // 16 kB
 
+// Files up to this size may be bundled into one batch request instead of being transferred
+// through the per-file pipeline.
+static const size_t kMaxBatchFileSize = 64 * 1024; // 64 kB
+
+// Upper bound for the payload of one batch request.
+static const size_t kMaxBatchSize = 1024 * 1024; // 1 MB
+
 } // namespace common
 
 #endif // COMMON__FILE_PACKET_H
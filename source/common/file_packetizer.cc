@@ -18,19 +18,70 @@
 
 #include "common/file_packetizer.h"
 
+#include "base/crc32.h"
 #include "base/logging.h"
+#include "base/crypto/generic_hash.h"
+#include "base/strings/string_util.h"
 #include "common/file_packet.h"
 
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+#if defined(OS_WIN)
+#include <winioctl.h>
+#endif // defined(OS_WIN)
+
+#if defined(OS_POSIX)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif // defined(OS_POSIX)
+
 namespace common {
 
 namespace {
 
+// Size of a single mapped window of the source file. Mapping the file in windows instead of as a
+// whole keeps the used address space bounded for multi-gigabyte transfers.
+const uint64_t kMappingWindowSize = 64 * 1024 * 1024; // 64 MB.
+
+// The compression ratio can be in the range of 1 to 22. The low level keeps compression much
+// cheaper than the network for compressible data.
+const int kCompressionRatio = 3;
+
+// Minimum size of an unallocated region that is sent as a hole descriptor instead of data.
+// Shorter holes are cheap to transfer as chunks of zeros, which also compress very well.
+const uint64_t kMinHoleSize = 256 * 1024; // 256 kB.
+
+// Extensions of formats that are already compressed. Compressing them again wastes CPU for no
+// gain in size.
+const char* const kAlreadyCompressedExtensions[] =
+{
+    ".7z", ".avi", ".bz2", ".flac", ".gif", ".gz", ".jpeg", ".jpg", ".mkv", ".mov", ".mp3",
+    ".mp4", ".ogg", ".png", ".rar", ".webm", ".webp", ".xz", ".zip", ".zst"
+};
+
 char* outputBuffer(proto::FilePacket* packet, size_t size)
 {
     packet->mutable_data()->resize(size);
     return packet->mutable_data()->data();
 }
 
+bool isAlreadyCompressed(const std::filesystem::path& file_path)
+{
+    std::string extension = base::toLowerASCII(file_path.extension().u8string());
+
+    for (size_t i = 0; i < std::size(kAlreadyCompressedExtensions); ++i)
+    {
+        if (extension == kAlreadyCompressedExtensions[i])
+            return true;
+    }
+
+    return false;
+}
+
 } // namespace
 
 FilePacketizer::FilePacketizer(std::ifstream&& file_stream)
@@ -42,6 +93,11 @@ FilePacketizer::FilePacketizer(std::ifstream&& file_stream)
     left_size_ = file_size_;
 }
 
+FilePacketizer::~FilePacketizer()
+{
+    closeMapping();
+}
+
 std::unique_ptr<FilePacketizer> FilePacketizer::create(const std::filesystem::path& file_path)
 {
     std::ifstream file_stream;
@@ -50,7 +106,10 @@ std::unique_ptr<FilePacketizer> FilePacketizer::create(const std::filesystem::pa
     if (!file_stream.is_open())
         return nullptr;
 
-    return std::unique_ptr<FilePacketizer>(new FilePacketizer(std::move(file_stream)));
+    std::unique_ptr<FilePacketizer> packetizer(new FilePacketizer(std::move(file_stream)));
+    packetizer->compressible_ = !isAlreadyCompressed(file_path);
+    packetizer->openMapping(file_path);
+    return packetizer;
 }
 
 std::unique_ptr<proto::FilePacket> FilePacketizer::readNextPacket(
@@ -67,21 +126,65 @@ std::unique_ptr<proto::FilePacket> FilePacketizer::readNextPacket(
         return packet;
     }
 
+    if (delta_mode_)
+        return readNextDeltaPacket(request, std::move(packet));
+
     size_t packet_buffer_size = kMaxFilePacketSize;
 
     if (left_size_ < kMaxFilePacketSize)
         packet_buffer_size = static_cast<size_t>(left_size_);
 
-    char* packet_buffer = outputBuffer(packet.get(), packet_buffer_size);
-
-    // Moving to a new position in file.
-    file_stream_.seekg(file_size_ - left_size_);
+    // Position of the packet in the file.
+    const uint64_t offset = file_size_ - left_size_;
 
-    file_stream_.read(packet_buffer, packet_buffer_size);
-    if (file_stream_.fail())
+    if (request.flags() & proto::FilePacketRequest::SPARSE)
     {
-        LOG(LS_WARNING) << "Unable to read file";
+        const uint64_t hole_size = holeSizeAt(offset);
+        if (hole_size >= kMinHoleSize)
+        {
+            // The region is not allocated in the file system and reads as zeros; describe it
+            // instead of sending it.
+            packet->set_flags(packet->flags() | proto::FilePacket::HOLE);
+            packet->set_hole_size(hole_size);
+
+            // The hole contributes its size to the digest instead of its zero content, so
+            // neither side has to run gigabytes of zeros through the hash.
+            transfer_hash_.addData(&hole_size, sizeof(hole_size));
+
+            if (left_size_ == file_size_)
+            {
+                packet->set_flags(packet->flags() | proto::FilePacket::FIRST_PACKET);
+                packet->set_file_size(file_size_);
+            }
+
+            left_size_ -= hole_size;
+
+            if (!left_size_)
+            {
+                file_size_ = 0;
+                file_stream_.close();
+                closeMapping();
+
+                packet->set_flags(packet->flags() | proto::FilePacket::LAST_PACKET);
+                packet->set_checksum(base::toStdString(transfer_hash_.result()));
+            }
+
+            return packet;
+        }
+    }
+
+    const uint8_t* chunk_data = chunkAt(offset, packet_buffer_size);
+    if (!chunk_data)
         return nullptr;
+
+    // The digest is updated while the chunk is still hot in the cache, so verification adds no
+    // extra pass over the file.
+    transfer_hash_.addData(chunk_data, packet_buffer_size);
+
+    if (!compressChunk(request, chunk_data, packet_buffer_size, packet.get()))
+    {
+        // Store the chunk uncompressed.
+        memcpy(outputBuffer(packet.get(), packet_buffer_size), chunk_data, packet_buffer_size);
     }
 
     if (left_size_ == file_size_)
@@ -98,11 +201,371 @@ std::unique_ptr<proto::FilePacket> FilePacketizer::readNextPacket(
     {
         file_size_ = 0;
         file_stream_.close();
+        closeMapping();
+
+        packet->set_flags(packet->flags() | proto::FilePacket::LAST_PACKET);
+        packet->set_checksum(base::toStdString(transfer_hash_.result()));
+    }
+
+    return packet;
+}
+
+uint64_t FilePacketizer::holeSizeAt(uint64_t offset)
+{
+#if defined(OS_WIN)
+    if (!file_.isValid())
+        return 0;
+
+    FILE_ALLOCATED_RANGE_BUFFER query;
+    query.FileOffset.QuadPart = static_cast<LONGLONG>(offset);
+    query.Length.QuadPart = static_cast<LONGLONG>(file_size_ - offset);
+
+    FILE_ALLOCATED_RANGE_BUFFER range;
+    DWORD bytes_returned = 0;
+
+    if (!DeviceIoControl(file_.get(), FSCTL_QUERY_ALLOCATED_RANGES, &query, sizeof(query),
+                         &range, sizeof(range), &bytes_returned, nullptr))
+    {
+        // With more ranges than fit into the output buffer the first range is still filled in.
+        if (GetLastError() != ERROR_MORE_DATA)
+            return 0;
+    }
+
+    if (!bytes_returned)
+    {
+        // No allocated range up to the end of the file.
+        return file_size_ - offset;
+    }
+
+    const uint64_t range_offset = static_cast<uint64_t>(range.FileOffset.QuadPart);
+    return range_offset > offset ? range_offset - offset : 0;
+#elif defined(OS_POSIX) && defined(SEEK_DATA)
+    if (file_ == -1)
+        return 0;
+
+    const off_t data_offset = lseek(file_, static_cast<off_t>(offset), SEEK_DATA);
+    if (data_offset == -1)
+    {
+        // Past the last data: the rest of the file is a hole.
+        return errno == ENXIO ? file_size_ - offset : 0;
+    }
+
+    const uint64_t next_data = static_cast<uint64_t>(data_offset);
+    return next_data > offset ? next_data - offset : 0;
+#else
+    (void)offset; // No hole detection on this platform.
+    return 0;
+#endif
+}
+
+const uint8_t* FilePacketizer::chunkAt(uint64_t offset, size_t size)
+{
+    bool in_window = window_data_ && offset >= window_offset_ &&
+                     offset + size <= window_offset_ + window_size_;
+    if (!in_window)
+        in_window = mapWindow(offset) && offset + size <= window_offset_ + window_size_;
+
+    if (in_window)
+    {
+        // The chunk is used directly from the file mapping. This avoids the buffered-IO copy
+        // and the read system call.
+        return window_data_ + (offset - window_offset_);
+    }
+
+    read_buffer_.resize(size);
+
+    // Moving to a new position in file.
+    file_stream_.seekg(offset);
+
+    file_stream_.read(read_buffer_.data(), size);
+    if (file_stream_.fail())
+    {
+        LOG(LS_WARNING) << "Unable to read file";
+        return nullptr;
+    }
+
+    return reinterpret_cast<const uint8_t*>(read_buffer_.data());
+}
+
+void FilePacketizer::setTargetChecksums(const proto::BlockChecksumList& checksums)
+{
+    target_checksums_ = checksums;
+    delta_mode_ = target_checksums_.block_size() != 0;
+}
+
+std::unique_ptr<proto::FilePacket> FilePacketizer::readNextDeltaPacket(
+    const proto::FilePacketRequest& request, std::unique_ptr<proto::FilePacket> packet)
+{
+    const uint32_t block_size = target_checksums_.block_size();
+
+    // Skip the blocks that the target already has.
+    while (delta_offset_ < file_size_ && delta_offset_ >= delta_run_end_)
+    {
+        const uint64_t block_index = delta_offset_ / block_size;
+
+        if (!blockMatches(block_index))
+        {
+            // The block differs (or is beyond the target copy); it has to be sent.
+            delta_run_end_ = std::min<uint64_t>(delta_offset_ + block_size, file_size_);
+            break;
+        }
+
+        delta_offset_ += block_size;
+    }
+
+    // Delta packets always carry the position and the full file size, so the target can update
+    // its copy in place and truncate it at the end.
+    packet->set_file_size(file_size_);
+
+    if (delta_offset_ >= file_size_)
+    {
+        // The rest of the file matches the target copy.
+        uint32_t flags = proto::FilePacket::LAST_PACKET;
+        if (!delta_first_sent_)
+        {
+            flags |= proto::FilePacket::FIRST_PACKET;
+            delta_first_sent_ = true;
+        }
+
+        packet->set_flags(flags);
+        packet->set_checksum(base::toStdString(transfer_hash_.result()));
+
+        file_size_ = 0;
+        file_stream_.close();
+        closeMapping();
+
+        return packet;
+    }
+
+    const size_t packet_size = static_cast<size_t>(
+        std::min<uint64_t>(kMaxFilePacketSize, delta_run_end_ - delta_offset_));
+
+    const uint8_t* chunk_data = chunkAt(delta_offset_, packet_size);
+    if (!chunk_data)
+        return nullptr;
 
+    packet->set_offset(delta_offset_);
+
+    transfer_hash_.addData(chunk_data, packet_size);
+
+    if (!compressChunk(request, chunk_data, packet_size, packet.get()))
+        memcpy(outputBuffer(packet.get(), packet_size), chunk_data, packet_size);
+
+    if (!delta_first_sent_)
+    {
+        packet->set_flags(packet->flags() | proto::FilePacket::FIRST_PACKET);
+        delta_first_sent_ = true;
+    }
+
+    delta_offset_ += packet_size;
+
+    if (delta_offset_ >= file_size_)
+    {
         packet->set_flags(packet->flags() | proto::FilePacket::LAST_PACKET);
+        packet->set_checksum(base::toStdString(transfer_hash_.result()));
+
+        file_size_ = 0;
+        file_stream_.close();
+        closeMapping();
     }
 
     return packet;
 }
 
+bool FilePacketizer::blockMatches(uint64_t block_index)
+{
+    if (block_index >= static_cast<uint64_t>(target_checksums_.checksum_size()))
+        return false;
+
+    const uint64_t offset = block_index * target_checksums_.block_size();
+    const size_t size = static_cast<size_t>(
+        std::min<uint64_t>(target_checksums_.block_size(), file_size_ - offset));
+
+    const uint8_t* data = chunkAt(offset, size);
+    if (!data)
+        return false;
+
+    const proto::BlockChecksum& checksum = target_checksums_.checksum(
+        static_cast<int>(block_index));
+
+    if (base::crc32(0, data, size) != checksum.crc32())
+        return false;
+
+    // The cheap checksum matches; verify with the strong hash.
+    base::ByteArray hash = base::GenericHash::hash(base::GenericHash::BLAKE2s256, data, size);
+    return base::toStdString(hash) == checksum.hash();
+}
+
+bool FilePacketizer::compressChunk(const proto::FilePacketRequest& request,
+                                   const uint8_t* data,
+                                   size_t size,
+                                   proto::FilePacket* packet)
+{
+    if (!(request.flags() & proto::FilePacketRequest::COMPRESS) || !compressible_ || !size)
+        return false;
+
+    if (!cstream_)
+    {
+        cstream_.reset(ZSTD_createCStream());
+        if (!cstream_)
+            return false;
+    }
+
+    size_t ret = ZSTD_initCStream(cstream_.get(), kCompressionRatio);
+    DCHECK(!ZSTD_isError(ret)) << ZSTD_getErrorName(ret);
+
+    // A chunk that does not shrink is stored uncompressed, so the output is limited by the
+    // input size.
+    uint8_t* output_data = reinterpret_cast<uint8_t*>(outputBuffer(packet, size));
+
+    ZSTD_inBuffer input = { data, size, 0 };
+    ZSTD_outBuffer output = { output_data, size, 0 };
+
+    while (input.pos < input.size)
+    {
+        ret = ZSTD_compressStream(cstream_.get(), &output, &input);
+        if (ZSTD_isError(ret))
+        {
+            LOG(LS_ERROR) << "ZSTD_compressStream failed: " << ZSTD_getErrorName(ret);
+            return false;
+        }
+
+        // The compressed chunk would be bigger than the original.
+        if (input.pos < input.size && output.pos == output.size)
+            return false;
+    }
+
+    ret = ZSTD_endStream(cstream_.get(), &output);
+    if (ZSTD_isError(ret) || ret != 0)
+        return false;
+
+    packet->mutable_data()->resize(output.pos);
+    packet->set_flags(packet->flags() | proto::FilePacket::COMPRESSED);
+    return true;
+}
+
+void FilePacketizer::openMapping(const std::filesystem::path& file_path)
+{
+    // An empty file can not be mapped.
+    if (!file_size_)
+        return;
+
+#if defined(OS_WIN)
+    SYSTEM_INFO system_info;
+    GetSystemInfo(&system_info);
+    allocation_granularity_ = system_info.dwAllocationGranularity;
+
+    file_.reset(CreateFileW(file_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr));
+    if (!file_.isValid())
+    {
+        PLOG(LS_WARNING) << "CreateFileW failed";
+        return;
+    }
+
+    mapping_.reset(CreateFileMappingW(file_.get(), nullptr, PAGE_READONLY, 0, 0, nullptr));
+    if (!mapping_.isValid())
+    {
+        PLOG(LS_WARNING) << "CreateFileMappingW failed";
+        file_.reset();
+        return;
+    }
+#elif defined(OS_POSIX)
+    allocation_granularity_ = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+
+    file_ = open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file_ == -1)
+    {
+        PLOG(LS_WARNING) << "open failed";
+        return;
+    }
+
+#if defined(OS_LINUX)
+    // The file is read strictly from the beginning to the end.
+    posix_fadvise(file_, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif // defined(OS_LINUX)
+#endif
+}
+
+bool FilePacketizer::mapWindow(uint64_t offset)
+{
+    unmapWindow();
+
+#if defined(OS_WIN)
+    if (!mapping_.isValid())
+        return false;
+#elif defined(OS_POSIX)
+    if (file_ == -1)
+        return false;
+#else
+    return false;
+#endif
+
+    DCHECK(allocation_granularity_);
+    DCHECK_LT(offset, file_size_);
+
+    const uint64_t window_offset = (offset / allocation_granularity_) * allocation_granularity_;
+    const size_t window_size =
+        static_cast<size_t>(std::min(kMappingWindowSize, file_size_ - window_offset));
+
+#if defined(OS_WIN)
+    window_data_ = reinterpret_cast<const uint8_t*>(
+        MapViewOfFile(mapping_.get(), FILE_MAP_READ, static_cast<DWORD>(window_offset >> 32),
+                      static_cast<DWORD>(window_offset), window_size));
+    if (!window_data_)
+    {
+        PLOG(LS_WARNING) << "MapViewOfFile failed";
+        closeMapping();
+        return false;
+    }
+#elif defined(OS_POSIX)
+    void* data = mmap(nullptr, window_size, PROT_READ, MAP_PRIVATE, file_,
+                      static_cast<off_t>(window_offset));
+    if (data == MAP_FAILED)
+    {
+        PLOG(LS_WARNING) << "mmap failed";
+        closeMapping();
+        return false;
+    }
+
+    madvise(data, window_size, MADV_SEQUENTIAL);
+    window_data_ = reinterpret_cast<const uint8_t*>(data);
+#endif
+
+    window_offset_ = window_offset;
+    window_size_ = window_size;
+    return true;
+}
+
+void FilePacketizer::unmapWindow()
+{
+    if (!window_data_)
+        return;
+
+#if defined(OS_WIN)
+    UnmapViewOfFile(window_data_);
+#elif defined(OS_POSIX)
+    munmap(const_cast<uint8_t*>(window_data_), window_size_);
+#endif
+
+    window_data_ = nullptr;
+    window_size_ = 0;
+}
+
+void FilePacketizer::closeMapping()
+{
+    unmapWindow();
+
+#if defined(OS_WIN)
+    mapping_.reset();
+    file_.reset();
+#elif defined(OS_POSIX)
+    if (file_ != -1)
+    {
+        close(file_);
+        file_ = -1;
+    }
+#endif
+}
+
 } // namespace common
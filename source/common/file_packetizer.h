@@ -20,8 +20,15 @@
 #define COMMON__FILE_PACKETIZER_H
 
 #include "base/macros_magic.h"
+#include "base/codec/scoped_zstd_stream.h"
+#include "base/crypto/generic_hash.h"
+#include "build/build_config.h"
 #include "proto/file_transfer.pb.h"
 
+#if defined(OS_WIN)
+#include "base/win/scoped_object.h"
+#endif // defined(OS_WIN)
+
 #include <filesystem>
 #include <fstream>
 #include <memory>
@@ -31,7 +38,7 @@ namespace common {
 class FilePacketizer
 {
 public:
-    ~FilePacketizer() = default;
+    ~FilePacketizer();
 
     // Creates an instance of the class.
     // Parameter |file_path| contains the full path to the file.
@@ -41,14 +48,78 @@ public:
     // Creates a packet for transferring.
     std::unique_ptr<proto::FilePacket> readNextPacket(const proto::FilePacketRequest& request);
 
+    // Enables delta mode: blocks whose checksums match |checksums| of the target copy are
+    // skipped and every produced packet carries its position in the file.
+    void setTargetChecksums(const proto::BlockChecksumList& checksums);
+
 private:
     explicit FilePacketizer(std::ifstream&& file_stream);
 
+    // Opens a memory mapping of the source file. The mapping is optional: when it can not be
+    // created, packets are read through |file_stream_|.
+    void openMapping(const std::filesystem::path& file_path);
+
+    // Maps the window of the file containing |offset|. Returns false if the window can not be
+    // mapped.
+    bool mapWindow(uint64_t offset);
+    void unmapWindow();
+    void closeMapping();
+
+    // Compresses the chunk into the packet data when compression is requested and worthwhile.
+    // Returns false if the chunk should be stored uncompressed.
+    bool compressChunk(const proto::FilePacketRequest& request,
+                       const uint8_t* data,
+                       size_t size,
+                       proto::FilePacket* packet);
+
+    // Returns a pointer to |size| bytes of the file at |offset|, either into the file mapping or
+    // into |read_buffer_|. Returns nullptr if the file can not be read.
+    const uint8_t* chunkAt(uint64_t offset, size_t size);
+
+    // Returns the number of unallocated bytes starting exactly at |offset|, or zero when data
+    // is allocated there or hole detection is not available.
+    uint64_t holeSizeAt(uint64_t offset);
+
+    std::unique_ptr<proto::FilePacket> readNextDeltaPacket(
+        const proto::FilePacketRequest& request, std::unique_ptr<proto::FilePacket> packet);
+    bool blockMatches(uint64_t block_index);
+
     std::ifstream file_stream_;
+    std::string read_buffer_;
+
+    // Whether the file content is worth compressing. Files with extensions of already compressed
+    // formats are transferred as is.
+    bool compressible_ = false;
+    base::ScopedZstdCStream cstream_;
+
+    // Delta mode state. The file is compared block by block against the target checksums; only
+    // the blocks that differ are packed.
+    bool delta_mode_ = false;
+    proto::BlockChecksumList target_checksums_;
+    uint64_t delta_offset_ = 0;    // Current read position.
+    uint64_t delta_run_end_ = 0;   // End of the changed region that is being sent now.
+    bool delta_first_sent_ = false;
 
     uint64_t file_size_ = 0;
     uint64_t left_size_ = 0;
 
+    // Running digest of the transferred content, updated with every produced chunk. The final
+    // digest rides on the last packet, so verification needs no extra pass over the file.
+    base::GenericHash transfer_hash_{ base::GenericHash::BLAKE2s256 };
+
+    // Large files are mapped in windows of fixed size instead of as a whole, so that the used
+    // address space stays bounded. Window offsets are aligned to |allocation_granularity_|.
+#if defined(OS_WIN)
+    base::win::ScopedHandle file_;
+    base::win::ScopedHandle mapping_;
+#elif defined(OS_POSIX)
+    int file_ = -1;
+#endif
+    uint64_t allocation_granularity_ = 0;
+    const uint8_t* window_data_ = nullptr;
+    uint64_t window_offset_ = 0;
+    size_t window_size_ = 0;
+
     DISALLOW_COPY_AND_ASSIGN(FilePacketizer);
 };
 
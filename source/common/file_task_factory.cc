@@ -41,10 +41,26 @@ std::shared_ptr<FileTask> FileTaskFactory::driveList()
     return makeTask(std::move(request));
 }
 
-std::shared_ptr<FileTask> FileTaskFactory::fileList(const std::string& path)
+std::shared_ptr<FileTask> FileTaskFactory::fileList(const std::string& path, uint32_t flags)
 {
     auto request = std::make_unique<proto::FileRequest>();
-    request->mutable_file_list_request()->set_path(path);
+
+    proto::FileListRequest* file_list_request = request->mutable_file_list_request();
+    file_list_request->set_path(path);
+    file_list_request->set_flags(flags);
+
+    return makeTask(std::move(request));
+}
+
+std::shared_ptr<FileTask> FileTaskFactory::recursiveFileList(const std::string& path, uint32_t flags)
+{
+    auto request = std::make_unique<proto::FileRequest>();
+
+    proto::RecursiveFileListRequest* recursive_request =
+        request->mutable_recursive_file_list_request();
+    recursive_request->set_flags(flags);
+    recursive_request->set_path(path);
+
     return makeTask(std::move(request));
 }
 
@@ -81,6 +97,25 @@ std::shared_ptr<FileTask> FileTaskFactory::download(const std::string& file_path
     return makeTask(std::move(request));
 }
 
+std::shared_ptr<FileTask> FileTaskFactory::blockChecksum(const std::string& file_path)
+{
+    auto request = std::make_unique<proto::FileRequest>();
+    request->mutable_block_checksum_request()->set_path(file_path);
+    return makeTask(std::move(request));
+}
+
+std::shared_ptr<FileTask> FileTaskFactory::deltaDownload(
+    const std::string& file_path, const proto::BlockChecksumList& checksums)
+{
+    auto request = std::make_unique<proto::FileRequest>();
+
+    proto::DeltaDownloadRequest* delta_request = request->mutable_delta_download_request();
+    delta_request->set_path(file_path);
+    delta_request->mutable_checksums()->CopyFrom(checksums);
+
+    return makeTask(std::move(request));
+}
+
 std::shared_ptr<FileTask> FileTaskFactory::upload(const std::string& file_path, bool overwrite)
 {
     auto request = std::make_unique<proto::FileRequest>();
@@ -92,6 +127,36 @@ std::shared_ptr<FileTask> FileTaskFactory::upload(const std::string& file_path,
     return makeTask(std::move(request));
 }
 
+std::shared_ptr<FileTask> FileTaskFactory::deltaUpload(const std::string& file_path)
+{
+    auto request = std::make_unique<proto::FileRequest>();
+
+    proto::UploadRequest* upload_request = request->mutable_upload_request();
+    upload_request->set_path(file_path);
+    upload_request->set_overwrite(true);
+    upload_request->set_delta(true);
+
+    return makeTask(std::move(request));
+}
+
+std::shared_ptr<FileTask> FileTaskFactory::readBatch(const std::vector<std::string>& file_paths)
+{
+    auto request = std::make_unique<proto::FileRequest>();
+
+    proto::ReadBatchRequest* batch_request = request->mutable_read_batch_request();
+    for (const std::string& file_path : file_paths)
+        batch_request->add_path(file_path);
+
+    return makeTask(std::move(request));
+}
+
+std::shared_ptr<FileTask> FileTaskFactory::writeBatch(const proto::FileBatch& batch)
+{
+    auto request = std::make_unique<proto::FileRequest>();
+    request->mutable_write_batch_request()->mutable_batch()->CopyFrom(batch);
+    return makeTask(std::move(request));
+}
+
 std::shared_ptr<FileTask> FileTaskFactory::packetRequest(uint32_t flags)
 {
     auto request = std::make_unique<proto::FileRequest>();
@@ -22,8 +22,11 @@
 #include "common/file_task.h"
 
 #include <string>
+#include <vector>
 
 namespace proto {
+class BlockChecksumList;
+class FileBatch;
 class FilePacket;
 } // namespace proto
 
@@ -38,12 +41,19 @@ public:
     FileTask::Target target() const { return target_; }
 
     std::shared_ptr<FileTask> driveList();
-    std::shared_ptr<FileTask> fileList(const std::string& path);
+    std::shared_ptr<FileTask> fileList(const std::string& path, uint32_t flags);
+    std::shared_ptr<FileTask> recursiveFileList(const std::string& path, uint32_t flags);
     std::shared_ptr<FileTask> createDirectory(const std::string& path);
     std::shared_ptr<FileTask> rename(const std::string& old_name, const std::string& new_name);
     std::shared_ptr<FileTask> remove(const std::string& path);
     std::shared_ptr<FileTask> download(const std::string& file_path);
+    std::shared_ptr<FileTask> blockChecksum(const std::string& file_path);
+    std::shared_ptr<FileTask> deltaDownload(const std::string& file_path,
+                                            const proto::BlockChecksumList& checksums);
     std::shared_ptr<FileTask> upload(const std::string& file_path, bool overwrite);
+    std::shared_ptr<FileTask> deltaUpload(const std::string& file_path);
+    std::shared_ptr<FileTask> readBatch(const std::vector<std::string>& file_paths);
+    std::shared_ptr<FileTask> writeBatch(const proto::FileBatch& batch);
     std::shared_ptr<FileTask> packetRequest(uint32_t flags);
     std::shared_ptr<FileTask> packet(const proto::FilePacket& packet);
     std::shared_ptr<FileTask> packet(std::unique_ptr<proto::FilePacket> packet);
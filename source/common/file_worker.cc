@@ -18,22 +18,40 @@
 
 #include "common/file_worker.h"
 
+#include "base/crc32.h"
 #include "base/logging.h"
 #include "base/task_runner.h"
+#include "base/crypto/generic_hash.h"
 #include "base/files/base_paths.h"
 #include "build/build_config.h"
 #include "common/file_depacketizer.h"
+#include "common/file_packet.h"
 #include "common/file_packetizer.h"
 #include "common/file_enumerator.h"
 #include "common/file_platform_util.h"
 #include "common/file_task.h"
 
+#include <deque>
+
 #if defined(OS_WIN)
 #include "base/win/drive_enumerator.h"
 #endif // defined(OS_WIN)
 
 namespace common {
 
+namespace {
+
+// Maximum number of items in one chunk of a file list reply.
+const int kFileListChunkSize = 1000;
+
+// Maximum number of items in one chunk of a recursive file list reply.
+const int kRecursiveFileListChunkSize = 1000;
+
+// Size of the blocks a file is split into for delta synchronization.
+const uint32_t kDeltaBlockSize = 64 * 1024; // 64 kB.
+
+} // namespace
+
 class FileWorker::Impl : public std::enable_shared_from_this<Impl>
 {
 public:
@@ -48,17 +66,62 @@ private:
     std::unique_ptr<proto::FileReply> doRequest(const proto::FileRequest& request);
     std::unique_ptr<proto::FileReply> doDriveListRequest();
     std::unique_ptr<proto::FileReply> doFileListRequest(const proto::FileListRequest& request);
+    std::unique_ptr<proto::FileReply> doRecursiveFileListRequest(
+        const proto::RecursiveFileListRequest& request);
     std::unique_ptr<proto::FileReply> doCreateDirectoryRequest(const proto::CreateDirectoryRequest& request);
     std::unique_ptr<proto::FileReply> doRenameRequest(const proto::RenameRequest& request);
     std::unique_ptr<proto::FileReply> doRemoveRequest(const proto::RemoveRequest& request);
     std::unique_ptr<proto::FileReply> doDownloadRequest(const proto::DownloadRequest& request);
+    std::unique_ptr<proto::FileReply> doDeltaDownloadRequest(
+        const proto::DeltaDownloadRequest& request);
+    std::unique_ptr<proto::FileReply> doBlockChecksumRequest(
+        const proto::BlockChecksumRequest& request);
     std::unique_ptr<proto::FileReply> doUploadRequest(const proto::UploadRequest& request);
     std::unique_ptr<proto::FileReply> doPacketRequest(const proto::FilePacketRequest& request);
     std::unique_ptr<proto::FileReply> doPacket(const proto::FilePacket& packet);
+    std::unique_ptr<proto::FileReply> doReadBatchRequest(const proto::ReadBatchRequest& request);
+    std::unique_ptr<proto::FileReply> doWriteBatchRequest(const proto::WriteBatchRequest& request);
+    void doReadAhead();
+
+    // State of a chunked directory listing between requests.
+    struct FileListEnumeration
+    {
+        // Path the listing was started for. A request with another path implicitly starts a
+        // new listing.
+        std::string path;
+        std::unique_ptr<FileEnumerator> enumerator;
+    };
+
+    // State of a recursive enumeration between requests. The tree is walked in breadth-first
+    // order, so the item of a directory always precedes the items inside it.
+    struct RecursiveEnumeration
+    {
+        std::filesystem::path root_path;
+
+        // Directories that have been discovered but not yet enumerated. Paths are relative to
+        // |root_path|.
+        std::deque<std::filesystem::path> pending_directories;
+
+        // Relative path of the directory that |enumerator| is walking now.
+        std::filesystem::path current_directory;
+        std::unique_ptr<FileEnumerator> enumerator;
+    };
 
     std::shared_ptr<base::TaskRunner> task_runner_;
     std::unique_ptr<FileDepacketizer> depacketizer_;
     std::unique_ptr<FilePacketizer> packetizer_;
+    std::unique_ptr<FileListEnumeration> file_list_enumeration_;
+    std::unique_ptr<RecursiveEnumeration> recursive_enumeration_;
+
+    // The next packet, read from disk after the reply for the previous one has been handed off.
+    // While the previous packet travels over the network, the disk read of the next one already
+    // runs, so disk and network latency overlap instead of alternating.
+    std::unique_ptr<proto::FilePacket> read_ahead_packet_;
+    bool read_ahead_failed_ = false;
+
+    // Flags of the last served packet request; the read-ahead repeats them, so a compressed
+    // transfer keeps compressing the packets read ahead of time.
+    uint32_t read_ahead_flags_ = proto::FilePacketRequest::NO_FLAGS;
 
     DISALLOW_COPY_AND_ASSIGN(Impl);
 };
@@ -73,6 +136,18 @@ FileWorker::Impl::~Impl() = default;
 
 void FileWorker::Impl::doTask(std::shared_ptr<FileTask> task)
 {
+    // Data packets of a transfer are served in place when the caller already runs on the worker
+    // thread. The client drives transfers from the thread the local worker lives on, and a queue
+    // hop per packet costs more than the disk access itself. Re-entrancy is bounded: the reply
+    // handler keeps at most a fixed window of packets in flight. Other requests stay posted;
+    // chunked directory listings would otherwise recurse once per chunk.
+    if (task_runner_->belongsToCurrentThread() &&
+        (task->request().has_packet() || task->request().has_packet_request()))
+    {
+        task->setReply(doRequest(task->request()));
+        return;
+    }
+
     auto self = shared_from_this();
     task_runner_->postTask([self, task]()
     {
@@ -96,6 +171,10 @@ std::unique_ptr<proto::FileReply> FileWorker::Impl::doRequest(const proto::FileR
     {
         return doFileListRequest(request.file_list_request());
     }
+    else if (request.has_recursive_file_list_request())
+    {
+        return doRecursiveFileListRequest(request.recursive_file_list_request());
+    }
     else if (request.has_create_directory_request())
     {
         return doCreateDirectoryRequest(request.create_directory_request());
@@ -112,6 +191,14 @@ std::unique_ptr<proto::FileReply> FileWorker::Impl::doRequest(const proto::FileR
     {
         return doDownloadRequest(request.download_request());
     }
+    else if (request.has_delta_download_request())
+    {
+        return doDeltaDownloadRequest(request.delta_download_request());
+    }
+    else if (request.has_block_checksum_request())
+    {
+        return doBlockChecksumRequest(request.block_checksum_request());
+    }
     else if (request.has_upload_request())
     {
         return doUploadRequest(request.upload_request());
@@ -124,6 +211,14 @@ std::unique_ptr<proto::FileReply> FileWorker::Impl::doRequest(const proto::FileR
     {
         return doPacket(request.packet());
     }
+    else if (request.has_read_batch_request())
+    {
+        return doReadBatchRequest(request.read_batch_request());
+    }
+    else if (request.has_write_batch_request())
+    {
+        return doWriteBatchRequest(request.write_batch_request());
+    }
     else
     {
         std::unique_ptr<proto::FileReply> reply = std::make_unique<proto::FileReply>();
@@ -218,29 +313,41 @@ std::unique_ptr<proto::FileReply> FileWorker::Impl::doFileListRequest(
 {
     std::unique_ptr<proto::FileReply> reply = std::make_unique<proto::FileReply>();
 
-    std::filesystem::path path = std::filesystem::u8path(request.path());
+    // A request for another path aborts the previous listing even without the START flag; a
+    // peer that predates chunked listings never sets the flag.
+    if ((request.flags() & proto::FileListRequest::START) ||
+        !file_list_enumeration_ || file_list_enumeration_->path != request.path())
+    {
+        file_list_enumeration_.reset();
 
-    std::error_code ignored_code;
-    std::filesystem::file_status status = std::filesystem::status(path, ignored_code);
+        std::filesystem::path path = std::filesystem::u8path(request.path());
 
-    if (!std::filesystem::exists(status))
-    {
-        reply->set_error_code(proto::FILE_ERROR_PATH_NOT_FOUND);
-        return reply;
-    }
+        std::error_code ignored_code;
+        std::filesystem::file_status status = std::filesystem::status(path, ignored_code);
 
-    if (!std::filesystem::is_directory(status))
-    {
-        reply->set_error_code(proto::FILE_ERROR_INVALID_PATH_NAME);
-        return reply;
+        if (!std::filesystem::exists(status))
+        {
+            reply->set_error_code(proto::FILE_ERROR_PATH_NOT_FOUND);
+            return reply;
+        }
+
+        if (!std::filesystem::is_directory(status))
+        {
+            reply->set_error_code(proto::FILE_ERROR_INVALID_PATH_NAME);
+            return reply;
+        }
+
+        file_list_enumeration_ = std::make_unique<FileListEnumeration>();
+        file_list_enumeration_->path = request.path();
+        file_list_enumeration_->enumerator = std::make_unique<FileEnumerator>(path);
     }
 
     proto::FileList* file_list = reply->mutable_file_list();
-    FileEnumerator enumerator(path);
+    FileEnumerator* enumerator = file_list_enumeration_->enumerator.get();
 
-    while (!enumerator.isAtEnd())
+    while (file_list->item_size() < kFileListChunkSize && !enumerator->isAtEnd())
     {
-        const FileEnumerator::FileInfo& file_info = enumerator.fileInfo();
+        const FileEnumerator::FileInfo& file_info = enumerator->fileInfo();
 
         proto::FileList::Item* item = file_list->add_item();
         item->set_name(file_info.u8name());
@@ -248,10 +355,108 @@ std::unique_ptr<proto::FileReply> FileWorker::Impl::doFileListRequest(
         item->set_modification_time(file_info.lastWriteTime());
         item->set_is_directory(file_info.isDirectory());
 
-        enumerator.advance();
+        enumerator->advance();
+    }
+
+    if (enumerator->isAtEnd())
+    {
+        reply->set_error_code(enumerator->errorCode());
+        file_list_enumeration_.reset();
+    }
+    else
+    {
+        file_list->set_flags(proto::FileList::MORE_CHUNKS);
+        reply->set_error_code(proto::FILE_ERROR_SUCCESS);
+    }
+
+    return reply;
+}
+
+std::unique_ptr<proto::FileReply> FileWorker::Impl::doRecursiveFileListRequest(
+    const proto::RecursiveFileListRequest& request)
+{
+    std::unique_ptr<proto::FileReply> reply = std::make_unique<proto::FileReply>();
+
+    if (request.flags() & proto::RecursiveFileListRequest::START)
+    {
+        std::filesystem::path path = std::filesystem::u8path(request.path());
+
+        std::error_code ignored_code;
+        std::filesystem::file_status status = std::filesystem::status(path, ignored_code);
+
+        if (!std::filesystem::exists(status))
+        {
+            reply->set_error_code(proto::FILE_ERROR_PATH_NOT_FOUND);
+            return reply;
+        }
+
+        if (!std::filesystem::is_directory(status))
+        {
+            reply->set_error_code(proto::FILE_ERROR_INVALID_PATH_NAME);
+            return reply;
+        }
+
+        recursive_enumeration_ = std::make_unique<RecursiveEnumeration>();
+        recursive_enumeration_->root_path = std::move(path);
+        recursive_enumeration_->enumerator =
+            std::make_unique<FileEnumerator>(recursive_enumeration_->root_path);
+    }
+    else if (!recursive_enumeration_)
+    {
+        LOG(LS_WARNING) << "Unexpected recursive file list request";
+        reply->set_error_code(proto::FILE_ERROR_INVALID_REQUEST);
+        return reply;
+    }
+
+    proto::RecursiveFileList* file_list = reply->mutable_recursive_file_list();
+
+    while (file_list->item_size() < kRecursiveFileListChunkSize)
+    {
+        FileEnumerator* enumerator = recursive_enumeration_->enumerator.get();
+
+        if (enumerator->isAtEnd())
+        {
+            if (enumerator->errorCode() != proto::FILE_ERROR_SUCCESS)
+            {
+                reply->set_error_code(enumerator->errorCode());
+                recursive_enumeration_.reset();
+                return reply;
+            }
+
+            if (recursive_enumeration_->pending_directories.empty())
+            {
+                // The whole tree has been enumerated.
+                file_list->set_flags(proto::RecursiveFileList::LAST_CHUNK);
+                recursive_enumeration_.reset();
+                break;
+            }
+
+            // Go to the next discovered directory.
+            recursive_enumeration_->current_directory =
+                std::move(recursive_enumeration_->pending_directories.front());
+            recursive_enumeration_->pending_directories.pop_front();
+            recursive_enumeration_->enumerator = std::make_unique<FileEnumerator>(
+                recursive_enumeration_->root_path / recursive_enumeration_->current_directory);
+            continue;
+        }
+
+        const FileEnumerator::FileInfo& file_info = enumerator->fileInfo();
+
+        std::filesystem::path relative_path =
+            recursive_enumeration_->current_directory / file_info.name();
+
+        proto::RecursiveFileList::Item* item = file_list->add_item();
+        item->set_path(relative_path.generic_u8string());
+        item->set_size(file_info.size());
+        item->set_is_directory(file_info.isDirectory());
+
+        if (file_info.isDirectory())
+            recursive_enumeration_->pending_directories.emplace_back(std::move(relative_path));
+
+        enumerator->advance();
     }
 
-    reply->set_error_code(enumerator.errorCode());
+    reply->set_error_code(proto::FILE_ERROR_SUCCESS);
     return reply;
 }
 
@@ -369,12 +574,108 @@ std::unique_ptr<proto::FileReply> FileWorker::Impl::doDownloadRequest(
 {
     std::unique_ptr<proto::FileReply> reply = std::make_unique<proto::FileReply>();
 
+    read_ahead_packet_.reset();
+    read_ahead_failed_ = false;
+
+    packetizer_ = FilePacketizer::create(std::filesystem::u8path(request.path()));
+    if (!packetizer_)
+        reply->set_error_code(proto::FILE_ERROR_FILE_OPEN_ERROR);
+    else
+        reply->set_error_code(proto::FILE_ERROR_SUCCESS);
+
+    return reply;
+}
+
+std::unique_ptr<proto::FileReply> FileWorker::Impl::doDeltaDownloadRequest(
+    const proto::DeltaDownloadRequest& request)
+{
+    std::unique_ptr<proto::FileReply> reply = std::make_unique<proto::FileReply>();
+
+    read_ahead_packet_.reset();
+    read_ahead_failed_ = false;
+
     packetizer_ = FilePacketizer::create(std::filesystem::u8path(request.path()));
     if (!packetizer_)
+    {
         reply->set_error_code(proto::FILE_ERROR_FILE_OPEN_ERROR);
+    }
     else
+    {
+        packetizer_->setTargetChecksums(request.checksums());
         reply->set_error_code(proto::FILE_ERROR_SUCCESS);
+    }
+
+    return reply;
+}
+
+std::unique_ptr<proto::FileReply> FileWorker::Impl::doBlockChecksumRequest(
+    const proto::BlockChecksumRequest& request)
+{
+    std::unique_ptr<proto::FileReply> reply = std::make_unique<proto::FileReply>();
+
+    std::filesystem::path path = std::filesystem::u8path(request.path());
+
+    std::error_code ignored_code;
+    std::filesystem::file_status status = std::filesystem::status(path, ignored_code);
+
+    if (!std::filesystem::exists(status))
+    {
+        reply->set_error_code(proto::FILE_ERROR_PATH_NOT_FOUND);
+        return reply;
+    }
+
+    if (!std::filesystem::is_regular_file(status))
+    {
+        reply->set_error_code(proto::FILE_ERROR_INVALID_PATH_NAME);
+        return reply;
+    }
+
+    std::ifstream file_stream;
+
+    file_stream.open(path, std::ifstream::binary);
+    if (!file_stream.is_open())
+    {
+        reply->set_error_code(proto::FILE_ERROR_FILE_OPEN_ERROR);
+        return reply;
+    }
+
+    proto::BlockChecksumList* checksum_list = reply->mutable_block_checksum_list();
+    checksum_list->set_block_size(kDeltaBlockSize);
+
+    std::string buffer;
+    buffer.resize(kDeltaBlockSize);
+
+    uint64_t file_size = 0;
+
+    for (;;)
+    {
+        file_stream.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+
+        const size_t read_size = static_cast<size_t>(file_stream.gcount());
+        if (!read_size)
+            break;
+
+        file_size += read_size;
 
+        proto::BlockChecksum* checksum = checksum_list->add_checksum();
+        checksum->set_crc32(base::crc32(0, buffer.data(), read_size));
+        checksum->set_hash(base::toStdString(base::GenericHash::hash(
+            base::GenericHash::BLAKE2s256, reinterpret_cast<const uint8_t*>(buffer.data()),
+            read_size)));
+
+        if (file_stream.eof())
+            break;
+
+        if (file_stream.fail())
+        {
+            reply->clear_block_checksum_list();
+            reply->set_error_code(proto::FILE_ERROR_FILE_READ_ERROR);
+            return reply;
+        }
+    }
+
+    checksum_list->set_file_size(file_size);
+    reply->set_error_code(proto::FILE_ERROR_SUCCESS);
     return reply;
 }
 
@@ -387,6 +688,21 @@ std::unique_ptr<proto::FileReply> FileWorker::Impl::doUploadRequest(
 
     do
     {
+        if (request.delta())
+        {
+            // The file is updated in place, so the existing copy must be there.
+            depacketizer_ = FileDepacketizer::createForDelta(file_path);
+            if (!depacketizer_)
+            {
+                reply->set_error_code(proto::FILE_ERROR_FILE_CREATE_ERROR);
+                break;
+            }
+
+            reply->set_error_code(proto::FILE_ERROR_SUCCESS);
+            reply->set_capabilities(proto::FileReply::COMPRESSED_PACKETS);
+            break;
+        }
+
         if (!request.overwrite())
         {
             std::error_code ignored_code;
@@ -405,6 +721,11 @@ std::unique_ptr<proto::FileReply> FileWorker::Impl::doUploadRequest(
         }
 
         reply->set_error_code(proto::FILE_ERROR_SUCCESS);
+
+        // Holes are only usable in sequential transfers; a delta update keeps the existing
+        // content in the skipped regions instead of zeros.
+        reply->set_capabilities(proto::FileReply::COMPRESSED_PACKETS |
+                                proto::FileReply::SPARSE_PACKETS);
     }
     while (false);
 
@@ -422,9 +743,28 @@ std::unique_ptr<proto::FileReply> FileWorker::Impl::doPacketRequest(
         reply->set_error_code(proto::FILE_ERROR_UNKNOWN);
         LOG(LS_WARNING) << "Unexpected file packet request";
     }
+    else if (read_ahead_failed_)
+    {
+        reply->set_error_code(proto::FILE_ERROR_FILE_READ_ERROR);
+        read_ahead_failed_ = false;
+        packetizer_.reset();
+    }
     else
     {
-        std::unique_ptr<proto::FilePacket> packet = packetizer_->readNextPacket(request);
+        std::unique_ptr<proto::FilePacket> packet;
+
+        // Use the packet read ahead of time, if there is one. A cancellation discards it,
+        // because the source has to produce a finishing packet instead.
+        if (read_ahead_packet_ && !(request.flags() & proto::FilePacketRequest::CANCEL))
+        {
+            packet = std::move(read_ahead_packet_);
+        }
+        else
+        {
+            read_ahead_packet_.reset();
+            packet = packetizer_->readNextPacket(request);
+        }
+
         if (!packet)
         {
             reply->set_error_code(proto::FILE_ERROR_FILE_READ_ERROR);
@@ -433,7 +773,20 @@ std::unique_ptr<proto::FileReply> FileWorker::Impl::doPacketRequest(
         else
         {
             if (packet->flags() & proto::FilePacket::LAST_PACKET)
+            {
                 packetizer_.reset();
+            }
+            else
+            {
+                // Read the next packet from disk after the reply has been handed off.
+                read_ahead_flags_ = request.flags() & ~proto::FilePacketRequest::CANCEL;
+
+                auto self = shared_from_this();
+                task_runner_->postTask([self]()
+                {
+                    self->doReadAhead();
+                });
+            }
 
             reply->set_error_code(proto::FILE_ERROR_SUCCESS);
             reply->set_allocated_packet(packet.release());
@@ -443,6 +796,21 @@ std::unique_ptr<proto::FileReply> FileWorker::Impl::doPacketRequest(
     return reply;
 }
 
+void FileWorker::Impl::doReadAhead()
+{
+    // The transfer could be finished or canceled between the posting and the execution, and
+    // another packet request may have been served in between.
+    if (!packetizer_ || read_ahead_packet_ || read_ahead_failed_)
+        return;
+
+    proto::FilePacketRequest request;
+    request.set_flags(read_ahead_flags_);
+
+    read_ahead_packet_ = packetizer_->readNextPacket(request);
+    if (!read_ahead_packet_)
+        read_ahead_failed_ = true;
+}
+
 std::unique_ptr<proto::FileReply> FileWorker::Impl::doPacket(const proto::FilePacket& packet)
 {
     std::unique_ptr<proto::FileReply> reply = std::make_unique<proto::FileReply>();
@@ -472,6 +840,100 @@ std::unique_ptr<proto::FileReply> FileWorker::Impl::doPacket(const proto::FilePa
     return reply;
 }
 
+std::unique_ptr<proto::FileReply> FileWorker::Impl::doReadBatchRequest(
+    const proto::ReadBatchRequest& request)
+{
+    std::unique_ptr<proto::FileReply> reply = std::make_unique<proto::FileReply>();
+    proto::FileBatch* batch = reply->mutable_batch();
+
+    for (int i = 0; i < request.path_size(); ++i)
+    {
+        proto::FileBatch::Item* item = batch->add_item();
+        item->set_path(request.path(i));
+
+        std::ifstream file_stream;
+
+        file_stream.open(std::filesystem::u8path(request.path(i)), std::ifstream::binary);
+        if (!file_stream.is_open())
+        {
+            // The first failing file ends the batch; it and the following files are
+            // transferred through the per-file path.
+            item->set_error_code(proto::FILE_ERROR_FILE_OPEN_ERROR);
+            break;
+        }
+
+        // One byte more than the limit, so a file that grew past it is detected.
+        std::string data;
+        data.resize(kMaxBatchFileSize + 1);
+
+        file_stream.read(data.data(), static_cast<std::streamsize>(data.size()));
+
+        const size_t read_size = static_cast<size_t>(file_stream.gcount());
+        if (file_stream.bad() || read_size > kMaxBatchFileSize)
+        {
+            item->set_error_code(proto::FILE_ERROR_FILE_READ_ERROR);
+            break;
+        }
+
+        data.resize(read_size);
+        item->set_data(std::move(data));
+        item->set_error_code(proto::FILE_ERROR_SUCCESS);
+    }
+
+    reply->set_error_code(proto::FILE_ERROR_SUCCESS);
+    return reply;
+}
+
+std::unique_ptr<proto::FileReply> FileWorker::Impl::doWriteBatchRequest(
+    const proto::WriteBatchRequest& request)
+{
+    std::unique_ptr<proto::FileReply> reply = std::make_unique<proto::FileReply>();
+    proto::FileBatch* batch = reply->mutable_batch();
+
+    for (int i = 0; i < request.batch().item_size(); ++i)
+    {
+        const proto::FileBatch::Item& source_item = request.batch().item(i);
+
+        proto::FileBatch::Item* item = batch->add_item();
+        item->set_path(source_item.path());
+
+        std::filesystem::path file_path = std::filesystem::u8path(source_item.path());
+
+        // A batch never replaces files; an existing file is handled through the per-file path,
+        // which asks the user before replacing it.
+        std::error_code ignored_code;
+        if (std::filesystem::exists(file_path, ignored_code))
+        {
+            item->set_error_code(proto::FILE_ERROR_PATH_ALREADY_EXISTS);
+            break;
+        }
+
+        std::ofstream file_stream;
+
+        file_stream.open(file_path, std::ofstream::binary);
+        if (!file_stream.is_open())
+        {
+            item->set_error_code(proto::FILE_ERROR_FILE_CREATE_ERROR);
+            break;
+        }
+
+        file_stream.write(source_item.data().data(),
+                          static_cast<std::streamsize>(source_item.data().size()));
+        if (file_stream.fail())
+        {
+            file_stream.close();
+            std::filesystem::remove(file_path, ignored_code);
+            item->set_error_code(proto::FILE_ERROR_FILE_WRITE_ERROR);
+            break;
+        }
+
+        item->set_error_code(proto::FILE_ERROR_SUCCESS);
+    }
+
+    reply->set_error_code(proto::FILE_ERROR_SUCCESS);
+    return reply;
+}
+
 FileWorker::FileWorker(std::shared_ptr<base::TaskRunner> task_runner)
     : impl_(std::make_shared<Impl>(std::move(task_runner)))
 {
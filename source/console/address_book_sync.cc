@@ -0,0 +1,273 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "console/address_book_sync.h"
+
+#include "base/logging.h"
+#include "base/crypto/data_cryptor.h"
+#include "base/crypto/generic_hash.h"
+#include "base/files/base_paths.h"
+#include "base/files/file_util.h"
+#include "base/memory/byte_array.h"
+
+#include <set>
+
+namespace console {
+
+namespace {
+
+const char kManifestFileName[] = "manifest";
+
+std::filesystem::path chunkDirectory(const std::filesystem::path& file_path)
+{
+    std::filesystem::path directory = file_path;
+    directory += ".chunks";
+    return directory;
+}
+
+std::filesystem::path manifestPath(const std::filesystem::path& file_path)
+{
+    return chunkDirectory(file_path) / kManifestFileName;
+}
+
+// Local chunk cache. Entries are ciphertext keyed by the plaintext hash, so nothing readable
+// without the book password touches the disk; a key change simply makes old entries fail to
+// decrypt and they are refetched.
+std::filesystem::path cacheDirectory()
+{
+    std::filesystem::path directory;
+    if (!base::BasePaths::userAppData(&directory))
+        return std::filesystem::path();
+
+    directory.append("aspia");
+    directory.append("address_book_cache");
+    return directory;
+}
+
+base::ByteArray chunkId(std::string_view plaintext)
+{
+    return base::GenericHash::hash(base::GenericHash::Type::BLAKE2s256, plaintext);
+}
+
+// Reads a chunk from |path| and decrypts it. Returns false if the file is missing, does not
+// decrypt with the current key or the plaintext does not hash to |id|.
+bool readChunk(const std::filesystem::path& path,
+               const base::ByteArray& id,
+               base::DataCryptor* cryptor,
+               std::string* plaintext)
+{
+    std::string ciphertext;
+    if (!base::readFile(path, &ciphertext))
+        return false;
+
+    if (!cryptor->decrypt(ciphertext, plaintext))
+        return false;
+
+    return chunkId(*plaintext) == id;
+}
+
+// Splits |data| into plaintext chunks in assembly order: the book without the child groups of
+// the root first, then one chunk per child group.
+std::vector<std::string> splitToChunks(const proto::address_book::Data& data)
+{
+    std::vector<std::string> chunks;
+    chunks.reserve(static_cast<size_t>(data.root_group().computer_group_size()) + 1);
+
+    proto::address_book::Data root_chunk = data;
+    root_chunk.mutable_root_group()->clear_computer_group();
+    chunks.emplace_back(root_chunk.SerializeAsString());
+
+    for (int i = 0; i < data.root_group().computer_group_size(); ++i)
+        chunks.emplace_back(data.root_group().computer_group(i).SerializeAsString());
+
+    return chunks;
+}
+
+} // namespace
+
+// static
+bool AddressBookSync::chunksEnabled(const std::filesystem::path& file_path)
+{
+    std::error_code ignored_code;
+    return std::filesystem::is_directory(chunkDirectory(file_path), ignored_code);
+}
+
+// static
+bool AddressBookSync::hasChunks(const std::filesystem::path& file_path)
+{
+    std::error_code ignored_code;
+    return std::filesystem::exists(manifestPath(file_path), ignored_code);
+}
+
+// static
+bool AddressBookSync::readManifest(const std::filesystem::path& file_path,
+                                   proto::address_book::SyncManifest* manifest)
+{
+    std::string buffer;
+    if (!base::readFile(manifestPath(file_path), &buffer))
+    {
+        LOG(LS_WARNING) << "Unable to read address book manifest";
+        return false;
+    }
+
+    if (!manifest->ParseFromString(buffer))
+    {
+        LOG(LS_WARNING) << "Invalid address book manifest";
+        return false;
+    }
+
+    return true;
+}
+
+// static
+bool AddressBookSync::loadData(const std::filesystem::path& file_path,
+                               const proto::address_book::SyncManifest& manifest,
+                               base::DataCryptor* cryptor,
+                               proto::address_book::Data* data)
+{
+    if (manifest.chunk_id_size() == 0)
+    {
+        LOG(LS_WARNING) << "Address book manifest contains no chunks";
+        return false;
+    }
+
+    const std::filesystem::path chunk_directory = chunkDirectory(file_path);
+    const std::filesystem::path cache_directory = cacheDirectory();
+
+    std::error_code ignored_code;
+    if (!cache_directory.empty())
+        std::filesystem::create_directories(cache_directory, ignored_code);
+
+    size_t fetched_chunks = 0;
+
+    for (int i = 0; i < manifest.chunk_id_size(); ++i)
+    {
+        const base::ByteArray id = base::fromStdString(manifest.chunk_id(i));
+        const std::string name = base::toHex(id);
+
+        std::string plaintext;
+
+        if (cache_directory.empty() ||
+            !readChunk(cache_directory / name, id, cryptor, &plaintext))
+        {
+            // Not cached (or stale); fetch from the share and remember it for the next open.
+            if (!readChunk(chunk_directory / name, id, cryptor, &plaintext))
+            {
+                LOG(LS_WARNING) << "Unable to read address book chunk " << name;
+                return false;
+            }
+
+            ++fetched_chunks;
+
+            if (!cache_directory.empty())
+            {
+                std::string ciphertext;
+                if (cryptor->encrypt(plaintext, &ciphertext))
+                    base::writeFile(cache_directory / name, ciphertext);
+            }
+        }
+
+        if (i == 0)
+        {
+            if (!data->ParseFromString(plaintext))
+            {
+                LOG(LS_WARNING) << "Invalid root chunk in address book";
+                return false;
+            }
+        }
+        else
+        {
+            if (!data->mutable_root_group()->add_computer_group()->ParseFromString(plaintext))
+            {
+                LOG(LS_WARNING) << "Invalid group chunk in address book";
+                return false;
+            }
+        }
+    }
+
+    LOG(LS_INFO) << "Address book assembled from " << manifest.chunk_id_size()
+                 << " chunks (" << fetched_chunks << " fetched)";
+    return true;
+}
+
+// static
+bool AddressBookSync::saveData(const std::filesystem::path& file_path,
+                               proto::address_book::EncryptionType encryption_type,
+                               const std::string& hashing_salt,
+                               const proto::address_book::Data& data,
+                               base::DataCryptor* cryptor)
+{
+    const std::filesystem::path chunk_directory = chunkDirectory(file_path);
+
+    std::error_code error_code;
+    std::filesystem::create_directories(chunk_directory, error_code);
+
+    proto::address_book::SyncManifest manifest;
+    manifest.set_encryption_type(encryption_type);
+    manifest.set_hashing_salt(hashing_salt);
+
+    std::set<std::string> live_names;
+
+    for (std::string& plaintext : splitToChunks(data))
+    {
+        const base::ByteArray id = chunkId(plaintext);
+        const std::string name = base::toHex(id);
+
+        manifest.add_chunk_id(base::toStdString(id));
+        live_names.emplace(name);
+
+        // Content-addressed: an existing file already holds this plaintext, so unchanged
+        // groups cost the share nothing on save.
+        std::error_code ignored_code;
+        if (std::filesystem::exists(chunk_directory / name, ignored_code))
+            continue;
+
+        std::string ciphertext;
+        if (!cryptor->encrypt(plaintext, &ciphertext))
+            return false;
+
+        if (!base::writeFile(chunk_directory / name, ciphertext))
+        {
+            LOG(LS_WARNING) << "Unable to write address book chunk " << name;
+            return false;
+        }
+    }
+
+    // The manifest is replaced last, so a reader sees either the old complete book or the
+    // new one.
+    if (!base::writeFile(manifestPath(file_path), manifest.SerializeAsString()))
+    {
+        LOG(LS_WARNING) << "Unable to write address book manifest";
+        return false;
+    }
+
+    // Remove chunks that no longer belong to the book.
+    for (const auto& entry : std::filesystem::directory_iterator(chunk_directory, error_code))
+    {
+        const std::string name = entry.path().filename().string();
+        if (name == kManifestFileName || live_names.find(name) != live_names.end())
+            continue;
+
+        std::error_code ignored_code;
+        std::filesystem::remove(entry.path(), ignored_code);
+    }
+
+    return true;
+}
+
+} // namespace console
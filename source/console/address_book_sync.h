@@ -0,0 +1,84 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef CONSOLE__ADDRESS_BOOK_SYNC_H
+#define CONSOLE__ADDRESS_BOOK_SYNC_H
+
+#include "base/macros_magic.h"
+#include "proto/address_book.pb.h"
+
+#include <filesystem>
+
+namespace base {
+class DataCryptor;
+} // namespace base
+
+namespace console {
+
+// Chunked storage of an address book for consoles that load it from a network share.
+//
+// Next to the regular ".aab" file a directory "<file name>.chunks" holds a small manifest and
+// one content-addressed file per chunk (named by the BLAKE2s-256 hash of the chunk plaintext;
+// the first chunk is the book without the child groups of the root, each following chunk one
+// child group). A console opening the book reads only the manifest and the chunks it does not
+// already have in its local cache, so at start of shift an unchanged 30k-entry book costs one
+// small read instead of the whole file, and an edited book costs only the changed groups.
+//
+// The chunk directory is written on every save if it exists; creating it (even empty) next to
+// the book is how an administrator enables the chunked mode for a share.
+class AddressBookSync
+{
+public:
+    // Returns true if |file_path| has a chunk directory next to it. The directory may still be
+    // empty; saving the book fills it.
+    static bool chunksEnabled(const std::filesystem::path& file_path);
+
+    // Returns true if |file_path| has a chunk directory with a manifest next to it.
+    static bool hasChunks(const std::filesystem::path& file_path);
+
+    // Reads the manifest of the chunk directory next to |file_path|. The manifest carries the
+    // encryption type and hashing salt, so the caller can ask for the password and build the
+    // cryptor before any chunk is fetched.
+    static bool readManifest(const std::filesystem::path& file_path,
+                             proto::address_book::SyncManifest* manifest);
+
+    // Assembles the book from the chunks listed in |manifest|. Chunks found in the local cache
+    // are decrypted from there; missing chunks are fetched from the chunk directory next to
+    // |file_path| and added to the cache. Returns false if a chunk cannot be fetched, does not
+    // decrypt or does not match its hash.
+    static bool loadData(const std::filesystem::path& file_path,
+                         const proto::address_book::SyncManifest& manifest,
+                         base::DataCryptor* cryptor,
+                         proto::address_book::Data* data);
+
+    // Rewrites the manifest and the chunks of |data| in the chunk directory next to
+    // |file_path|. Chunk files whose content did not change are left untouched, so the share
+    // sees writes only for edited groups. Stale chunk files are removed.
+    static bool saveData(const std::filesystem::path& file_path,
+                         proto::address_book::EncryptionType encryption_type,
+                         const std::string& hashing_salt,
+                         const proto::address_book::Data& data,
+                         base::DataCryptor* cryptor);
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(AddressBookSync);
+};
+
+} // namespace console
+
+#endif // CONSOLE__ADDRESS_BOOK_SYNC_H
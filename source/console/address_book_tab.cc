@@ -25,6 +25,7 @@
 #include "base/crypto/secure_memory.h"
 #include "base/strings/unicode.h"
 #include "console/address_book_dialog.h"
+#include "console/address_book_sync.h"
 #include "console/computer_dialog.h"
 #include "console/computer_group_dialog.h"
 #include "console/computer_item.h"
@@ -120,20 +121,22 @@ AddressBookTab::AddressBookTab(const QString& file_path,
     updateComputerList(group_item);
     updateRouterList();
 
-    group_item->setExpanded(group_item->IsExpanded());
-
+    // Only the groups that were expanded when the book was saved are materialized now. The
+    // rest of the tree is created on first expansion, so opening does not depend on the size
+    // of the book.
     std::function<void(ComputerGroupItem*)> restore_child = [&](ComputerGroupItem* item)
     {
+        if (!item->IsExpanded())
+            return;
+
+        item->createChildren();
+        item->setExpanded(true);
+
         for (int i = 0; i < item->childCount(); ++i)
         {
             ComputerGroupItem* child_item = dynamic_cast<ComputerGroupItem*>(item->child(i));
             if (child_item)
-            {
-                if (child_item->IsExpanded())
-                    child_item->setExpanded(true);
-
                 restore_child(child_item);
-            }
         }
     };
 
@@ -175,6 +178,9 @@ AddressBookTab::AddressBookTab(const QString& file_path,
 
     connect(ui.tree_routers, &QTreeWidget::itemDoubleClicked,
             this, &AddressBookTab::onRouterItemDoubleClicked);
+
+    connect(ui.edit_search, &QLineEdit::textChanged,
+            this, &AddressBookTab::onSearchTextChanged);
 }
 
 AddressBookTab::~AddressBookTab()
@@ -212,28 +218,50 @@ AddressBookTab* AddressBookTab::openFromFile(const QString& file_path, QWidget*
     if (file_path.isEmpty())
         return nullptr;
 
-    QFile file(file_path);
-    if (!file.open(QIODevice::ReadOnly))
-    {
-        showOpenError(parent, tr("Unable to open address book file \"%1\".").arg(file_path));
-        return nullptr;
-    }
+    const std::filesystem::path std_path = std::filesystem::u8path(file_path.toStdString());
+    const bool chunked = AddressBookSync::hasChunks(std_path);
+
+    proto::address_book::File address_book_file;
+    proto::address_book::SyncManifest manifest;
 
-    QByteArray buffer = file.readAll();
-    if (buffer.isEmpty())
+    if (chunked)
     {
-        showOpenError(parent, tr("Unable to read address book file \"%1\".").arg(file_path));
-        return nullptr;
+        // The manifest carries the encryption type and salt, so the regular file is not read
+        // at all.
+        if (!AddressBookSync::readManifest(std_path, &manifest))
+        {
+            showOpenError(parent,
+                          tr("Unable to read the manifest of address book \"%1\".")
+                          .arg(file_path));
+            return nullptr;
+        }
+
+        address_book_file.set_encryption_type(manifest.encryption_type());
+        address_book_file.set_hashing_salt(manifest.hashing_salt());
     }
+    else
+    {
+        QFile file(file_path);
+        if (!file.open(QIODevice::ReadOnly))
+        {
+            showOpenError(parent, tr("Unable to open address book file \"%1\".").arg(file_path));
+            return nullptr;
+        }
 
-    proto::address_book::File address_book_file;
+        QByteArray buffer = file.readAll();
+        if (buffer.isEmpty())
+        {
+            showOpenError(parent, tr("Unable to read address book file \"%1\".").arg(file_path));
+            return nullptr;
+        }
 
-    if (!address_book_file.ParseFromArray(buffer.constData(), buffer.size()))
-    {
-        showOpenError(parent,
-                      tr("The address book file \"%1\" is corrupted or has an unknown format.")
-                      .arg(file_path));
-        return nullptr;
+        if (!address_book_file.ParseFromArray(buffer.constData(), buffer.size()))
+        {
+            showOpenError(parent,
+                          tr("The address book file \"%1\" is corrupted or has an unknown format.")
+                          .arg(file_path));
+            return nullptr;
+        }
     }
 
     proto::address_book::Data address_book_data;
@@ -272,20 +300,33 @@ AddressBookTab* AddressBookTab::openFromFile(const QString& file_path, QWidget*
         return nullptr;
     }
 
-    std::string decrypted_data;
-    if (!cryptor->decrypt(address_book_file.data(), &decrypted_data))
+    if (chunked)
     {
-        showOpenError(parent, tr("Unable to decrypt the address book with the specified password."));
-        return nullptr;
+        if (!AddressBookSync::loadData(std_path, manifest, cryptor.get(), &address_book_data))
+        {
+            showOpenError(parent,
+                          tr("Unable to load the address book from its chunk directory. "
+                             "It is corrupted or the password is incorrect."));
+            return nullptr;
+        }
     }
-
-    if (!address_book_data.ParseFromString(decrypted_data))
+    else
     {
-        showOpenError(parent, tr("The address book file is corrupted or has an unknown format."));
-        return nullptr;
-    }
+        std::string decrypted_data;
+        if (!cryptor->decrypt(address_book_file.data(), &decrypted_data))
+        {
+            showOpenError(parent, tr("Unable to decrypt the address book with the specified password."));
+            return nullptr;
+        }
+
+        if (!address_book_data.ParseFromString(decrypted_data))
+        {
+            showOpenError(parent, tr("The address book file is corrupted or has an unknown format."));
+            return nullptr;
+        }
 
-    base::memZero(&decrypted_data);
+        base::memZero(&decrypted_data);
+    }
 
     return new AddressBookTab(file_path,
                               std::move(address_book_file),
@@ -325,6 +366,11 @@ AddressBookTab* AddressBookTab::duplicateTab() const
 
 bool AddressBookTab::save()
 {
+    // Callers save defensively before closing a tab; serializing and encrypting the whole book
+    // again when nothing has changed is pointless.
+    if (!is_changed_ && !file_path_.isEmpty())
+        return true;
+
     return saveToFile(file_path_);
 }
 
@@ -614,6 +660,7 @@ void AddressBookTab::onGroupItemExpanded(QTreeWidgetItem* item)
     if (!current_item)
         return;
 
+    current_item->createChildren();
     current_item->SetExpanded(true);
     setChanged(true);
 }
@@ -668,6 +715,20 @@ void AddressBookTab::onRouterItemDoubleClicked(QTreeWidgetItem* item, int column
     emit routerDoubleClicked(current_item->guid());
 }
 
+void AddressBookTab::onSearchTextChanged(const QString& text)
+{
+    if (text.isEmpty())
+    {
+        ComputerGroupItem* current_item =
+            dynamic_cast<ComputerGroupItem*>(ui.tree_group->currentItem());
+        if (current_item)
+            updateComputerList(current_item);
+        return;
+    }
+
+    updateSearchResults();
+}
+
 void AddressBookTab::showEvent(QShowEvent* event)
 {
     ComputerGroupItem* current_group =
@@ -760,6 +821,9 @@ void AddressBookTab::keyPressEvent(QKeyEvent* event)
 
 void AddressBookTab::setChanged(bool value)
 {
+    if (value)
+        search_index_dirty_ = true;
+
     is_changed_ = value;
     emit addressBookChanged(value);
 }
@@ -831,6 +895,13 @@ void AddressBookTab::restoreState(const QByteArray& state)
 
 void AddressBookTab::updateComputerList(ComputerGroupItem* computer_group)
 {
+    // Selecting a group ends an active search.
+    if (!ui.edit_search->text().isEmpty())
+    {
+        QSignalBlocker blocker(ui.edit_search);
+        ui.edit_search->clear();
+    }
+
     for (int i = ui.tree_computer->topLevelItemCount() - 1; i >= 0; --i)
         std::unique_ptr<QTreeWidgetItem> item_deleter(ui.tree_computer->takeTopLevelItem(i));
 
@@ -856,6 +927,82 @@ void AddressBookTab::updateRouterList()
     }
 }
 
+void AddressBookTab::rebuildSearchIndex()
+{
+    search_index_.clear();
+
+    QVector<int> path;
+
+    std::function<void(proto::address_book::ComputerGroup*)> add_group =
+        [&](proto::address_book::ComputerGroup* group)
+    {
+        for (int i = 0; i < group->computer_size(); ++i)
+        {
+            proto::address_book::Computer* computer = group->mutable_computer(i);
+
+            SearchIndexEntry entry;
+            entry.text = (QString::fromStdString(computer->name()) + QLatin1Char('\n') +
+                          QString::fromStdString(computer->address()) + QLatin1Char('\n') +
+                          QString::fromStdString(computer->comment())).toLower();
+            entry.computer = computer;
+            entry.group_path = path;
+
+            search_index_.emplace_back(std::move(entry));
+        }
+
+        for (int i = 0; i < group->computer_group_size(); ++i)
+        {
+            path.push_back(i);
+            add_group(group->mutable_computer_group(i));
+            path.pop_back();
+        }
+    };
+
+    add_group(data_.mutable_root_group());
+    search_index_dirty_ = false;
+}
+
+void AddressBookTab::updateSearchResults()
+{
+    if (search_index_dirty_)
+        rebuildSearchIndex();
+
+    const QString filter = ui.edit_search->text().toLower();
+
+    for (int i = ui.tree_computer->topLevelItemCount() - 1; i >= 0; --i)
+        std::unique_ptr<QTreeWidgetItem> item_deleter(ui.tree_computer->takeTopLevelItem(i));
+
+    QList<QTreeWidgetItem*> items;
+
+    for (const SearchIndexEntry& entry : search_index_)
+    {
+        if (!entry.text.contains(filter))
+            continue;
+
+        ComputerGroupItem* group_item = groupItemForPath(entry.group_path);
+        if (group_item)
+            items.push_back(new ComputerItem(entry.computer, group_item));
+    }
+
+    ui.tree_computer->addTopLevelItems(items);
+}
+
+ComputerGroupItem* AddressBookTab::groupItemForPath(const QVector<int>& path)
+{
+    ComputerGroupItem* item = rootComputerGroup();
+
+    for (int index : path)
+    {
+        if (!item)
+            return nullptr;
+
+        item->createChildren();
+        item = dynamic_cast<ComputerGroupItem*>(item->child(index));
+    }
+
+    return item;
+}
+
 bool AddressBookTab::saveToFile(const QString& file_path)
 {
     std::string serialized_data = data_.SerializeAsString();
@@ -876,12 +1023,11 @@ bool AddressBookTab::saveToFile(const QString& file_path)
             return false;
     }
 
-    std::string encrypted_data;
-    CHECK(cryptor->encrypt(serialized_data, &encrypted_data));
+    // Encrypt straight into the file message; a separate output buffer would be another copy
+    // of the whole book.
+    CHECK(cryptor->encrypt(serialized_data, file_.mutable_data()));
     base::memZero(&serialized_data);
 
-    file_.set_data(std::move(encrypted_data));
-
     QString path = file_path;
     if (path.isEmpty())
     {
@@ -917,6 +1063,22 @@ bool AddressBookTab::saveToFile(const QString& file_path)
         return false;
     }
 
+    // If an administrator enabled the chunked form for this book (see address_book_sync.h),
+    // refresh the chunk directory so other consoles fetch only the changed groups.
+    const std::filesystem::path std_path = std::filesystem::u8path(path.toStdString());
+    if (AddressBookSync::chunksEnabled(std_path))
+    {
+        if (!AddressBookSync::saveData(std_path,
+                                       file_.encryption_type(),
+                                       file_.hashing_salt(),
+                                       data_,
+                                       cryptor.get()))
+        {
+            showSaveError(this, tr("Unable to update the chunk directory of the address book."));
+            return false;
+        }
+    }
+
     file_path_ = path;
 
     setChanged(false);
@@ -25,6 +25,7 @@
 #include "ui_address_book_tab.h"
 
 #include <optional>
+#include <vector>
 
 namespace console {
 
@@ -91,6 +92,7 @@ private slots:
     void onComputerContextMenu(const QPoint& point);
     void onComputerItemDoubleClicked(QTreeWidgetItem* item, int column);
     void onRouterItemDoubleClicked(QTreeWidgetItem* item, int column);
+    void onSearchTextChanged(const QString& text);
 
 private:
     AddressBookTab(const QString& file_path,
@@ -99,8 +101,22 @@ private:
                    std::string&& key,
                    QWidget* parent);
 
+    // One entry per computer in the book. |text| holds the searchable fields lowercased in
+    // advance, so a search keystroke does plain substring scans without case conversion.
+    struct SearchIndexEntry
+    {
+        QString text;
+        proto::address_book::Computer* computer;
+
+        // Child indices from the root group to the group that owns the computer.
+        QVector<int> group_path;
+    };
+
     QByteArray saveState();
     void restoreState(const QByteArray& state);
+    void rebuildSearchIndex();
+    void updateSearchResults();
+    ComputerGroupItem* groupItemForPath(const QVector<int>& path);
     void updateComputerList(ComputerGroupItem* computer_group);
     void updateRouterList();
     bool saveToFile(const QString& file_path);
@@ -121,6 +137,10 @@ private:
 
     bool is_changed_ = false;
 
+    // Rebuilt lazily on the first search keystroke after a modification.
+    std::vector<SearchIndexEntry> search_index_;
+    bool search_index_dirty_ = true;
+
     DISALLOW_COPY_AND_ASSIGN(AddressBookTab);
 };
 
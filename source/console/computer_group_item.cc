@@ -30,6 +30,20 @@ ComputerGroupItem::ComputerGroupItem(proto::address_book::ComputerGroup* compute
     setIcon(0, QIcon(":/img/folder.png"));
     updateItem();
 
+    // Child items are created on demand by createChildren(). Only the expand indicator tells
+    // the view that the group has children.
+    if (computer_group_->computer_group_size() > 0)
+        setChildIndicatorPolicy(QTreeWidgetItem::ShowIndicator);
+}
+
+void ComputerGroupItem::createChildren()
+{
+    if (children_created_)
+        return;
+
+    children_created_ = true;
+    setChildIndicatorPolicy(QTreeWidgetItem::DontShowIndicatorWhenChildless);
+
     for (int i = 0; i < computer_group_->computer_group_size(); ++i)
     {
         addChild(new ComputerGroupItem(computer_group_->mutable_computer_group(i), this));
@@ -39,6 +53,8 @@ ComputerGroupItem::ComputerGroupItem(proto::address_book::ComputerGroup* compute
 ComputerGroupItem* ComputerGroupItem::addChildComputerGroup(
     proto::address_book::ComputerGroup* computer_group)
 {
+    createChildren();
+
     computer_group_->mutable_computer_group()->AddAllocated(computer_group);
 
     ComputerGroupItem* item = new ComputerGroupItem(computer_group, this);
@@ -31,6 +31,10 @@ public:
                       ComputerGroupItem* parent_item);
     virtual ~ComputerGroupItem() = default;
 
+    // Creates the items of the child groups. The constructor does not descend into child
+    // groups, so opening a large address book only materializes the visible part of the tree.
+    void createChildren();
+
     ComputerGroupItem* addChildComputerGroup(proto::address_book::ComputerGroup* computer_group);
     bool deleteChildComputerGroup(ComputerGroupItem* computer_group_item);
     proto::address_book::ComputerGroup* takeChildComputerGroup(ComputerGroupItem* computer_group_item);
@@ -50,6 +54,7 @@ private:
     friend class ComputerGroupTree;
 
     proto::address_book::ComputerGroup* computer_group_;
+    bool children_created_ = false;
 
     DISALLOW_COPY_AND_ASSIGN(ComputerGroupItem);
 };
@@ -32,6 +32,8 @@
 #include "console/mru_action.h"
 #include "console/update_settings_dialog.h"
 #include "common/ui/update_dialog.h"
+#include "client/prewarmed_connection.h"
+#include "qt_base/application.h"
 #include "qt_base/qt_logging.h"
 
 #include <QCloseEvent>
@@ -1144,6 +1146,18 @@ void MainWindow::connectToComputer(const proto::address_book::Computer& computer
     config.password      = base::utf16FromUtf8(computer.password());
     config.session_type  = computer.session_type();
 
+    // Start the TCP connect and the key exchange on the I/O thread right away: constructing
+    // the Qt session window below is the slow part of the launch, and it now overlaps the
+    // network round trips instead of preceding them. Prewarming needs the credentials up
+    // front, so connections that pop the authorization dialog keep the serial path.
+    std::shared_ptr<client::PrewarmedConnection> prewarmed;
+    if (!config.router_config.has_value() &&
+        !config.username.empty() && !config.password.empty())
+    {
+        prewarmed = client::PrewarmedConnection::create(
+            qt_base::Application::ioTaskRunner(), config);
+    }
+
     client::ClientWindow* client_window = nullptr;
 
     switch (config.session_type)
@@ -1175,7 +1189,7 @@ void MainWindow::connectToComputer(const proto::address_book::Computer& computer
         return;
 
     client_window->setAttribute(Qt::WA_DeleteOnClose);
-    if (!client_window->connectToHost(config))
+    if (!client_window->connectToHost(config, std::move(prewarmed)))
         client_window->close();
 }
 
@@ -115,6 +115,28 @@ void ClientSession::sendMessage(base::ByteArray&& buffer)
     channel_->send(std::move(buffer));
 }
 
+void ClientSession::sendMessage(const google::protobuf::MessageLite& message)
+{
+    // Serialization reuses the buffer of an already sent message, so the steady-state send path
+    // does not allocate.
+    base::ByteArray buffer = channel_->takeSpareBuffer();
+    base::serialize(message, &buffer);
+    channel_->send(std::move(buffer));
+}
+
+void ClientSession::sendMessage(uint8_t stream_id, const google::protobuf::MessageLite& message)
+{
+    sendMessage(stream_id, message, false);
+}
+
+void ClientSession::sendMessage(uint8_t stream_id, const google::protobuf::MessageLite& message,
+                                bool discardable)
+{
+    base::ByteArray buffer = channel_->takeSpareBuffer();
+    base::serialize(message, &buffer);
+    channel_->send(stream_id, std::move(buffer), discardable);
+}
+
 void ClientSession::onConnected()
 {
     NOTREACHED();
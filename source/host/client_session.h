@@ -43,6 +43,7 @@ public:
         virtual ~Delegate() = default;
 
         virtual void onClientSessionConfigured() = 0;
+        virtual void onClientSessionViewerStateChanged() = 0;
         virtual void onClientSessionFinished() = 0;
     };
 
@@ -84,7 +85,17 @@ protected:
     virtual void onStarted() = 0;
 
     std::shared_ptr<base::NetworkChannelProxy> channelProxy();
+    base::NetworkChannel* channel() const { return channel_.get(); }
     void sendMessage(base::ByteArray&& buffer);
+    void sendMessage(const google::protobuf::MessageLite& message);
+
+    // Sends a message on an auxiliary stream of the channel (see NetworkChannel::send with a
+    // stream id).
+    void sendMessage(uint8_t stream_id, const google::protobuf::MessageLite& message);
+
+    // Same as above with the discardable flag of NetworkChannel::send.
+    void sendMessage(uint8_t stream_id, const google::protobuf::MessageLite& message,
+                     bool discardable);
 
     // base::NetworkChannel::Listener implementation.
     void onConnected() override;
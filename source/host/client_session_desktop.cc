@@ -23,16 +23,42 @@
 #include "base/codec/audio_encoder_opus.h"
 #include "base/codec/cursor_encoder.h"
 #include "base/codec/scale_reducer.h"
-#include "base/codec/video_encoder_vpx.h"
+#include "base/codec/video_encoder.h"
+#include "base/crypto/generic_hash.h"
 #include "base/desktop/frame.h"
+#include "base/desktop/mouse_cursor.h"
+#include "base/net/network_channel_proxy.h"
 #include "common/desktop_session_constants.h"
 #include "host/desktop_session_proxy.h"
 #include "host/system_info.h"
 #include "host/win/updater_launcher.h"
 #include "proto/desktop_internal.pb.h"
 
+#include <zstd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
 namespace host {
 
+namespace {
+
+// An input event delayed this far beyond the usual path delay sat in a stalled connection.
+// Measured against the baseline delay, not an absolute threshold, because the clocks of the
+// two machines are not synchronized.
+const int64_t kStaleInputDelayMs = 500;
+
+// Milliseconds of the host monotonic clock, comparable with the client input timestamps up
+// to a constant offset (both sides use their steady clock).
+int64_t currentTimeMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
 ClientSessionDesktop::ClientSessionDesktop(
     proto::SessionType session_type, std::unique_ptr<base::NetworkChannel> channel)
     : ClientSession(session_type, std::move(channel))
@@ -64,15 +90,26 @@ void ClientSessionDesktop::onMessageReceived(const base::ByteArray& buffer)
         if (sessionType() != proto::SESSION_TYPE_DESKTOP_MANAGE)
             return;
 
-        if (!scale_reducer_)
+        if (video_encoding_ == proto::VIDEO_ENCODING_UNKNOWN)
             return;
 
         const proto::MouseEvent& mouse_event = incoming_message_.mouse_event();
 
+        bool is_stale = false;
+        if (!checkInputEvent(mouse_event.sequence(), mouse_event.timestamp(), &is_stale))
+            return;
+
+        // A stale move with unchanged buttons is superseded by fresher positions already in
+        // the stream; replaying it would only drag the cursor through the backlog.
+        if (is_stale && mouse_event.mask() == last_mouse_mask_)
+            return;
+
+        last_mouse_mask_ = mouse_event.mask();
+
         int pos_x = static_cast<int>(
-            static_cast<double>(mouse_event.x() * 100) / scale_reducer_->scaleFactorX());
+            static_cast<double>(mouse_event.x() * 100) / scale_factor_x_);
         int pos_y = static_cast<int>(
-            static_cast<double>(mouse_event.y() * 100) / scale_reducer_->scaleFactorY());
+            static_cast<double>(mouse_event.y() * 100) / scale_factor_y_);
 
         proto::MouseEvent out_mouse_event;
         out_mouse_event.set_mask(mouse_event.mask());
@@ -83,8 +120,26 @@ void ClientSessionDesktop::onMessageReceived(const base::ByteArray& buffer)
     }
     else if (incoming_message_.has_key_event())
     {
-        if (sessionType() == proto::SESSION_TYPE_DESKTOP_MANAGE)
-            desktop_session_proxy_->injectKeyEvent(incoming_message_.key_event());
+        if (sessionType() != proto::SESSION_TYPE_DESKTOP_MANAGE)
+            return;
+
+        const proto::KeyEvent& key_event = incoming_message_.key_event();
+
+        bool is_stale = false;
+        if (!checkInputEvent(key_event.sequence(), key_event.timestamp(), &is_stale))
+            return;
+
+        // Collapse stale auto-repeats: an identical consecutive key event is a repeat of a
+        // held key, not a new keystroke. Press/release pairs differ in flags and still go
+        // through, so keystrokes typed during a stall are not lost.
+        if (is_stale && key_event.usb_keycode() == last_key_usb_keycode_ &&
+            key_event.flags() == last_key_flags_)
+            return;
+
+        last_key_usb_keycode_ = key_event.usb_keycode();
+        last_key_flags_ = key_event.flags();
+
+        desktop_session_proxy_->injectKeyEvent(key_event);
     }
     else if (incoming_message_.has_clipboard_event())
     {
@@ -106,13 +161,33 @@ void ClientSessionDesktop::onMessageReceived(const base::ByteArray& buffer)
     }
 }
 
-void ClientSessionDesktop::onMessageWritten(size_t /* pending */)
+void ClientSessionDesktop::onMessageWritten(size_t pending)
 {
-    // Nothing
+    pending_messages_ = pending;
+}
+
+void ClientSessionDesktop::onMessagesDropped(uint8_t stream_id, size_t count)
+{
+    if (stream_id != common::kVideoStreamId)
+        return;
+
+    LOG(LS_INFO) << "Dropped " << count << " superseded video frames";
+
+    // The client has seen none of the dropped frames, so the next encoded frame must not
+    // reference them. A pending key frame request already covers that.
+    if (video_recovery_ != proto::VideoRecovery::ACTION_KEY_FRAME)
+        video_recovery_ = proto::VideoRecovery::ACTION_INVALIDATE_REFERENCES;
 }
 
 void ClientSessionDesktop::onStarted()
 {
+    channel()->setStreamListener(common::kClipboardStreamId, this);
+
+    // Video and clipboard chunks are bulk traffic: input and control messages on the default
+    // stream go ahead of whatever is queued on them.
+    channel()->setStreamClass(common::kVideoStreamId, base::NetworkChannel::StreamClass::BULK);
+    channel()->setStreamClass(common::kClipboardStreamId, base::NetworkChannel::StreamClass::BULK);
+
     const char* extensions;
 
     // Supported extensions are different for managing and viewing the desktop.
@@ -140,78 +215,242 @@ void ClientSessionDesktop::onStarted()
     LOG(LS_INFO) << "Supported audio encodings: " << request->audio_encodings();
 
     // Send the request.
-    sendMessage(base::serialize(outgoing_message_));
+    sendMessage(outgoing_message_);
 }
 
-void ClientSessionDesktop::encodeScreen(const base::Frame* frame, const base::MouseCursor* cursor)
+base::Size ClientSessionDesktop::videoSize(const base::Size& source_size) const
 {
+    base::Size current_size = preferred_size_;
+
+    if (current_size.width() > source_size.width() ||
+        current_size.height() > source_size.height())
+    {
+        // Preferred size is larger than the original; the original frame size is used.
+        current_size = source_size;
+    }
+
+    if (current_size.isEmpty())
+    {
+        // Preferred size has not been set; the original frame size is used.
+        current_size = source_size;
+    }
+
+    return current_size;
+}
+
+void ClientSessionDesktop::sendEncodedScreen(
+    const proto::VideoPacket* packet, const base::MouseCursor* cursor, const PipelinePass& pass)
+{
+    if (packet)
+    {
+        const uint64_t frame_time_us = base::PerfMeter::nowUs();
+
+        if (last_frame_time_us_ != 0)
+            capture_meter_.addSample(frame_time_us - last_frame_time_us_);
+        last_frame_time_us_ = frame_time_us;
+
+        scale_meter_.addSample(pass.scale_time_us);
+        encode_meter_.addSample(pass.encode_time_us);
+
+        scale_factor_x_ = pass.scale_x;
+        scale_factor_y_ = pass.scale_y;
+    }
+
     outgoing_message_.Clear();
 
-    if (frame && video_encoder_ && scale_reducer_)
+    if (packet)
     {
-        const base::Size& source_size = frame->size();
-        base::Size current_size = preferred_size_;
+        proto::VideoPacket* out_packet = outgoing_message_.mutable_video_packet();
+        out_packet->CopyFrom(*packet);
+
+        // The capture timestamp is stamped by the capturer in the desktop agent process. Both
+        // processes share the monotonic clock, so the difference is the host part of the
+        // glass-to-glass latency.
+        if (pass.capture_time_us != 0)
+            out_packet->set_host_latency_us(base::PerfMeter::nowUs() - pass.capture_time_us);
+    }
 
-        if (current_size.width() > source_size.width() ||
-            current_size.height() > source_size.height())
-        {
-            LOG(LS_INFO) << "Preferred size is larger than the original. "
-                            "Original frame size will be used";
-            current_size = source_size;
-        }
+    if (cursor && cursor_pipeline_)
+        encodeCursor(*cursor);
 
-        if (current_size.isEmpty())
+    if (outgoing_message_.has_video_packet())
+    {
+        if (frame_hash_interval_ != 0 && ++frame_hash_countdown_ >= frame_hash_interval_)
         {
-            LOG(LS_INFO) << "Preferred size has not been set. Original frame size will be used";
-            current_size = source_size;
+            frame_hash_countdown_ = 0;
+
+            // The hash rides in the same message as the packet it covers: the two share the
+            // fate of the message, so a frame dropped under congestion can never produce a
+            // false mismatch on the client.
+            proto::FrameHash frame_hash;
+            frame_hash.set_hash(base::toStdString(base::GenericHash::hash(
+                base::GenericHash::BLAKE2s256, outgoing_message_.video_packet().data())));
+
+            proto::DesktopExtension* extension = outgoing_message_.mutable_extension();
+            extension->set_name(common::kFrameHashExtension);
+            extension->set_data(frame_hash.SerializeAsString());
         }
 
-        const base::Frame* scaled_frame = scale_reducer_->scaleFrame(frame, current_size);
-        if (!scaled_frame)
-        {
-            LOG(LS_ERROR) << "No scaled frame";
-            return;
-        }
+        // A delta frame is superseded by the next frame, so it may be dropped from the send
+        // queue under congestion; the drop is repaired through onMessagesDropped(). Packets
+        // with a format (stream restarts) must arrive and are not discardable.
+        const bool discardable = !outgoing_message_.video_packet().has_format();
+
+        const uint64_t send_begin_us = base::PerfMeter::nowUs();
+        sendMessage(common::kVideoStreamId, outgoing_message_, discardable);
+        send_meter_.addSample(base::PerfMeter::nowUs() - send_begin_us);
+    }
+}
+
+proto::VideoRecovery::Action ClientSessionDesktop::takeVideoRecovery()
+{
+    proto::VideoRecovery::Action action = video_recovery_;
+    video_recovery_ = proto::VideoRecovery::ACTION_UNKNOWN;
+    return action;
+}
+
+void ClientSessionDesktop::encodeThumbnail(const base::Frame* frame)
+{
+    DCHECK(frame);
 
-        proto::VideoPacket* packet = outgoing_message_.mutable_video_packet();
+    if (thumbnail_interval_ms_ == 0)
+        return;
 
-        // Encode the frame into a video packet.
-        video_encoder_->encode(scaled_frame, packet);
+    // Damage of the skipped frames is carried over, so the next still contains it even if the
+    // screen went quiet in between.
+    thumbnail_pending_region_.addRegion(frame->constUpdatedRegion());
 
-        if (packet->has_format())
-        {
-            proto::Size* screen_size = packet->mutable_format()->mutable_screen_size();
-            screen_size->set_width(frame->size().width());
-            screen_size->set_height(frame->size().height());
-
-            LOG(LS_INFO) << "Video packet has format";
-            LOG(LS_INFO) << "Screen size: " << screen_size->width() << "x" << screen_size->height();
-            LOG(LS_INFO) << "Video size: " << packet->format().video_rect().width() << "x"
-                         << packet->format().video_rect().height();
-        }
+    const uint64_t now_us = base::PerfMeter::nowUs();
+    if (last_thumbnail_time_us_ != 0 &&
+        now_us - last_thumbnail_time_us_ < static_cast<uint64_t>(thumbnail_interval_ms_) * 1000)
+    {
+        return;
+    }
+
+    last_thumbnail_time_us_ = now_us;
+
+    // Fit the screen into the requested box with the aspect ratio preserved. A screen that
+    // already fits is sent unscaled.
+    const base::Size& source_size = frame->size();
+    if (source_size.width() <= 0 || source_size.height() <= 0)
+        return;
+
+    base::Size target_size = source_size;
+    if (target_size.width() > thumbnail_max_size_.width() ||
+        target_size.height() > thumbnail_max_size_.height())
+    {
+        const double scale = std::min(
+            static_cast<double>(thumbnail_max_size_.width()) / source_size.width(),
+            static_cast<double>(thumbnail_max_size_.height()) / source_size.height());
+
+        target_size.set(std::max(1, static_cast<int>(source_size.width() * scale)),
+                        std::max(1, static_cast<int>(source_size.height() * scale)));
+    }
+
+    if (!thumbnail_scaler_)
+        thumbnail_scaler_ = std::make_unique<base::ScaleReducer>();
+
+    // The accumulated damage replaces the frame region for the scale pass only; the region is
+    // restored afterwards so the other consumers of the frame are unaffected.
+    base::Frame* mutable_frame = const_cast<base::Frame*>(frame);
+
+    base::Region saved_update_region = *mutable_frame->updatedRegion();
+    *mutable_frame->updatedRegion() = thumbnail_pending_region_;
+    thumbnail_pending_region_.clear();
+
+    const base::Frame* scaled_frame = thumbnail_scaler_->scaleFrame(frame, target_size);
+
+    *mutable_frame->updatedRegion() = saved_update_region;
+
+    if (!scaled_frame)
+    {
+        LOG(LS_ERROR) << "No scaled frame";
+        return;
     }
 
-    if (cursor && cursor_encoder_)
+    // Pack the rows tightly; the stride of the scaled frame may be wider than the row.
+    const base::Size& size = scaled_frame->size();
+    const size_t row_bytes = static_cast<size_t>(size.width()) * base::Frame::kBytesPerPixel;
+
+    base::ByteArray pixels(row_bytes * static_cast<size_t>(size.height()));
+    for (int y = 0; y < size.height(); ++y)
     {
-        if (!cursor_encoder_->encode(*cursor, outgoing_message_.mutable_cursor_shape()))
-            outgoing_message_.clear_cursor_shape();
+        memcpy(pixels.data() + row_bytes * static_cast<size_t>(y),
+               scaled_frame->frameData() + static_cast<size_t>(scaled_frame->stride()) * y,
+               row_bytes);
     }
 
-    if (outgoing_message_.has_video_packet() || outgoing_message_.has_cursor_shape())
-        sendMessage(base::serialize(outgoing_message_));
+    // At one still per second a fast compression level is the right trade: the downscaled
+    // image is small and the bytes saved by a higher level do not matter.
+    static const int kCompressionRatio = 3;
+
+    proto::ScreenThumbnail screen_thumbnail;
+    screen_thumbnail.set_width(static_cast<uint32_t>(size.width()));
+    screen_thumbnail.set_height(static_cast<uint32_t>(size.height()));
+
+    std::string* data = screen_thumbnail.mutable_data();
+    data->resize(ZSTD_compressBound(pixels.size()));
+
+    const size_t ret = ZSTD_compress(
+        data->data(), data->size(), pixels.data(), pixels.size(), kCompressionRatio);
+    if (ZSTD_isError(ret))
+    {
+        LOG(LS_ERROR) << "ZSTD_compress failed: " << ZSTD_getErrorName(ret);
+        return;
+    }
+
+    data->resize(ret);
+
+    outgoing_message_.Clear();
+
+    proto::DesktopExtension* desktop_extension = outgoing_message_.mutable_extension();
+    desktop_extension->set_name(common::kScreenThumbnailExtension);
+    desktop_extension->set_data(screen_thumbnail.SerializeAsString());
+
+    sendMessage(outgoing_message_);
 }
 
 void ClientSessionDesktop::encodeAudio(const proto::AudioPacket& audio_packet)
 {
-    if (!audio_encoder_)
+    if (!audio_pipeline_)
         return;
 
-    outgoing_message_.Clear();
+    // Opus encoding runs sequenced on a worker thread, so a video encode spike on the session
+    // thread does not turn into audio dropouts. The packet is copied into the task; the caller
+    // hands the same packet to the other sessions.
+    base::ThreadPool::instance()->postSequencedTask(
+        audio_sequence_, [pipeline = audio_pipeline_, audio_packet]()
+    {
+        proto::HostToClient& message = pipeline->outgoing_message;
+        message.Clear();
 
-    if (!audio_encoder_->encode(audio_packet, outgoing_message_.mutable_audio_packet()))
-        return;
+        if (!pipeline->encoder->encode(audio_packet, message.mutable_audio_packet()))
+            return;
 
-    sendMessage(base::serialize(outgoing_message_));
+        pipeline->channel_proxy->send(base::serialize(message));
+    });
+}
+
+void ClientSessionDesktop::encodeCursor(const base::MouseCursor& mouse_cursor)
+{
+    // Hashing and compression run sequenced on a worker thread, so a cursor change never
+    // delays the video frame it arrived with. The cursor is copied into the task; the caller
+    // hands the same cursor to the other sessions.
+    base::ThreadPool::instance()->postSequencedTask(
+        cursor_sequence_, [pipeline = cursor_pipeline_, mouse_cursor]()
+    {
+        proto::HostToClient& message = pipeline->outgoing_message;
+        message.Clear();
+
+        if (!pipeline->encoder->encode(mouse_cursor, message.mutable_cursor_shape()))
+            return;
+
+        // Cursor shapes are never discardable: the cursor caches on both sides have to stay
+        // in lockstep. Tasks of one sequence run in posting order, so the decoder sees the
+        // shapes in encoding order.
+        pipeline->channel_proxy->send(
+            common::kVideoStreamId, base::serialize(message), false);
+    });
 }
 
 void ClientSessionDesktop::setScreenList(const proto::ScreenList& list)
@@ -222,18 +461,44 @@ void ClientSessionDesktop::setScreenList(const proto::ScreenList& list)
     extension->set_name(common::kSelectScreenExtension);
     extension->set_data(list.SerializeAsString());
 
-    sendMessage(base::serialize(outgoing_message_));
+    sendMessage(outgoing_message_);
 }
 
 void ClientSessionDesktop::injectClipboardEvent(const proto::ClipboardEvent& event)
 {
-    if (sessionType() == proto::SESSION_TYPE_DESKTOP_MANAGE)
+    if (sessionType() != proto::SESSION_TYPE_DESKTOP_MANAGE)
+        return;
+
+    if (event.total_size() != 0)
     {
-        outgoing_message_.Clear();
+        // Chunks of a large payload travel on the clipboard stream, scheduled round-robin with
+        // the default stream carrying video and input.
+        sendMessage(common::kClipboardStreamId, event);
+        return;
+    }
+
+    outgoing_message_.Clear();
+
+    outgoing_message_.mutable_clipboard_event()->CopyFrom(event);
+    sendMessage(outgoing_message_);
+}
 
-        outgoing_message_.mutable_clipboard_event()->CopyFrom(event);
-        sendMessage(base::serialize(outgoing_message_));
+void ClientSessionDesktop::onStreamMessageReceived(uint8_t stream_id, const base::ByteArray& buffer)
+{
+    DCHECK_EQ(stream_id, common::kClipboardStreamId);
+
+    if (sessionType() != proto::SESSION_TYPE_DESKTOP_MANAGE)
+        return;
+
+    incoming_clipboard_event_.Clear();
+
+    if (!base::parse(buffer, &incoming_clipboard_event_))
+    {
+        LOG(LS_ERROR) << "Invalid clipboard chunk from client";
+        return;
     }
+
+    desktop_session_proxy_->injectClipboardEvent(incoming_clipboard_event_);
 }
 
 void ClientSessionDesktop::readExtension(const proto::DesktopExtension& extension)
@@ -251,6 +516,36 @@ void ClientSessionDesktop::readExtension(const proto::DesktopExtension& extensio
         desktop_session_proxy_->selectScreen(screen);
         preferred_size_ = base::Size();
     }
+    else if (extension.name() == common::kCaptureRegionExtension)
+    {
+        proto::CaptureRegion capture_region;
+
+        if (!capture_region.ParseFromString(extension.data()))
+        {
+            LOG(LS_ERROR) << "Unable to parse capture region extension data";
+            return;
+        }
+
+        static const int kMaxScreenSize = std::numeric_limits<int16_t>::max();
+
+        if (capture_region.x() < 0 || capture_region.x() > kMaxScreenSize ||
+            capture_region.y() < 0 || capture_region.y() > kMaxScreenSize ||
+            capture_region.width() < 0 || capture_region.width() > kMaxScreenSize ||
+            capture_region.height() < 0 || capture_region.height() > kMaxScreenSize)
+        {
+            LOG(LS_ERROR) << "Invalid capture region: "
+                          << capture_region.x() << "," << capture_region.y() << " "
+                          << capture_region.width() << "x" << capture_region.height();
+            return;
+        }
+
+        LOG(LS_INFO) << "Capture region changed: "
+                     << capture_region.x() << "," << capture_region.y() << " "
+                     << capture_region.width() << "x" << capture_region.height();
+
+        desktop_session_proxy_->setCaptureRegion(capture_region);
+        desktop_session_proxy_->captureScreen();
+    }
     else if (extension.name() == common::kPreferredSizeExtension)
     {
         proto::PreferredSize preferred_size;
@@ -327,70 +622,311 @@ void ClientSessionDesktop::readExtension(const proto::DesktopExtension& extensio
             LOG(LS_WARNING) << "Update can only be launched from a desktop manage session";
         }
     }
-    else if (extension.name() == common::kSystemInfoExtension)
+    else if (extension.name() == common::kPipelineStatsExtension)
     {
-        proto::SystemInfo system_info;
-        createSystemInfo(&system_info);
+        proto::PipelineStats stats;
+
+        stats.set_frame_count(capture_meter_.count());
+        stats.set_capture_interval_avg_us(capture_meter_.average());
+        stats.set_scale_avg_us(scale_meter_.average());
+        stats.set_encode_avg_us(encode_meter_.average());
+        stats.set_encode_max_us(encode_meter_.max());
+        stats.set_send_avg_us(send_meter_.average());
+        stats.set_pending_messages(pending_messages_);
+
+        if (channel())
+        {
+            const uint64_t write_count = channel()->writeCount() - last_write_count_;
+            const uint64_t write_time_us = channel()->writeTimeUs() - last_write_time_us_;
+
+            stats.set_network_write_avg_us(write_count ? write_time_us / write_count : 0);
+
+            last_write_count_ += write_count;
+            last_write_time_us_ += write_time_us;
+        }
+
+        std::shared_ptr<base::NetworkChannelProxy> channel_proxy = channelProxy();
+        if (channel_proxy)
+        {
+            stats.set_network_queue_depth_max(channel_proxy->takeMaxQueueDepth());
+            stats.set_network_queue_age_us(channel_proxy->queueAgeUs());
+        }
+
+        if (desktop_session_proxy_)
+            stats.set_ipc_queue_depth_max(desktop_session_proxy_->takeMaxQueueDepth());
+
+        capture_meter_.reset();
+        scale_meter_.reset();
+        encode_meter_.reset();
+        send_meter_.reset();
 
         outgoing_message_.Clear();
 
         proto::DesktopExtension* desktop_extension = outgoing_message_.mutable_extension();
-        desktop_extension->set_name(common::kSystemInfoExtension);
-        desktop_extension->set_data(system_info.SerializeAsString());
+        desktop_extension->set_name(common::kPipelineStatsExtension);
+        desktop_extension->set_data(stats.SerializeAsString());
 
-        sendMessage(base::serialize(outgoing_message_));
+        sendMessage(outgoing_message_);
     }
-    else
+    else if (extension.name() == common::kVideoRecoveryExtension)
     {
-        LOG(LS_WARNING) << "Unknown extension: " << extension.name();
+        proto::VideoRecovery video_recovery;
+
+        if (!video_recovery.ParseFromString(extension.data()))
+        {
+            LOG(LS_ERROR) << "Unable to parse video recovery extension data";
+            return;
+        }
+
+        if (video_recovery.action() == proto::VideoRecovery::ACTION_UNKNOWN)
+        {
+            LOG(LS_WARNING) << "Unknown video recovery action";
+            return;
+        }
+
+        LOG(LS_INFO) << "Video recovery requested: " << video_recovery.action();
+
+        // A pending key frame request is never downgraded to a reference invalidation.
+        if (video_recovery_ != proto::VideoRecovery::ACTION_KEY_FRAME)
+            video_recovery_ = video_recovery.action();
+
+        // Make sure a frame is produced soon even if the screen is static.
+        desktop_session_proxy_->captureScreen();
     }
-}
+    else if (extension.name() == common::kBandwidthEstimateExtension)
+    {
+        proto::BandwidthEstimate bandwidth_estimate;
 
-void ClientSessionDesktop::readConfig(const proto::DesktopConfig& config)
-{
-    switch (config.video_encoding())
+        if (!bandwidth_estimate.ParseFromString(extension.data()))
+        {
+            LOG(LS_ERROR) << "Unable to parse bandwidth estimate extension data";
+            return;
+        }
+
+        // An unreasonable value from a peer is clamped instead of trusted.
+        static const uint64_t kMaxBandwidthKbps = 1000 * 1000; // 1 Gbit/s.
+
+        uint64_t bandwidth_kbps = bandwidth_estimate.bandwidth_kbps();
+        if (bandwidth_kbps > kMaxBandwidthKbps)
+            bandwidth_kbps = kMaxBandwidthKbps;
+
+        bandwidth_estimate_kbps_ = static_cast<int>(bandwidth_kbps);
+
+        if (bandwidth_kbps != 0)
+        {
+            // Pace socket writes at 1.5x the estimated link rate. The headroom keeps pacing
+            // from ever becoming the bottleneck; it only spreads an encoded frame over a few
+            // milliseconds instead of letting it hit a slower link as one burst.
+            channel()->setSendRateLimit(bandwidth_kbps * 1000 / 8 * 3 / 2);
+        }
+    }
+    else if (extension.name() == common::kVideoProfileExtension)
     {
-        case proto::VIDEO_ENCODING_VP8:
-            video_encoder_ = base::VideoEncoderVPX::createVP8();
-            break;
+        proto::VideoProfile video_profile;
+
+        if (!video_profile.ParseFromString(extension.data()))
+        {
+            LOG(LS_ERROR) << "Unable to parse video profile extension data";
+            return;
+        }
 
-        case proto::VIDEO_ENCODING_VP9:
-            video_encoder_ = base::VideoEncoderVPX::createVP9();
-            break;
+        LOG(LS_INFO) << "Video profile changed (max_fps:" << video_profile.max_fps()
+                     << " max_bitrate_kbps:" << video_profile.max_bitrate_kbps()
+                     << " cpu_used:" << video_profile.cpu_used() << ")";
 
-        default:
+        // The user session picks the profile up on the next captured frame; no stream restart.
+        video_profile_ = video_profile;
+    }
+    else if (extension.name() == common::kViewerStateExtension)
+    {
+        proto::ViewerState viewer_state;
+
+        if (!viewer_state.ParseFromString(extension.data()))
         {
-            // No supported video encoding.
-            LOG(LS_WARNING) << "Unsupported video encoding: " << config.video_encoding();
+            LOG(LS_ERROR) << "Unable to parse viewer state extension data";
+            return;
         }
-        break;
+
+        if (viewer_visible_ == viewer_state.visible())
+            return;
+
+        LOG(LS_INFO) << "Viewer window is now " << (viewer_state.visible() ? "visible" : "hidden");
+
+        viewer_visible_ = viewer_state.visible();
+        delegate_->onClientSessionViewerStateChanged();
     }
+    else if (extension.name() == common::kScreenThumbnailExtension)
+    {
+        proto::ScreenThumbnail screen_thumbnail;
+
+        if (!screen_thumbnail.ParseFromString(extension.data()))
+        {
+            LOG(LS_ERROR) << "Unable to parse screen thumbnail extension data";
+            return;
+        }
+
+        if (!screen_thumbnail.enable())
+        {
+            LOG(LS_INFO) << "Screen thumbnails disabled";
 
-    if (!video_encoder_)
+            thumbnail_interval_ms_ = 0;
+            thumbnail_scaler_.reset();
+            thumbnail_pending_region_.clear();
+            return;
+        }
+
+        static const uint32_t kDefaultIntervalMs = 1000;
+        static const uint32_t kMinIntervalMs = 200;
+        static const uint32_t kMaxIntervalMs = 60 * 1000;
+
+        static const int kDefaultMaxWidth = 320;
+        static const int kDefaultMaxHeight = 240;
+        static const int kMaxThumbnailSize = 1024;
+
+        uint32_t interval_ms = screen_thumbnail.interval_ms();
+        if (interval_ms == 0)
+            interval_ms = kDefaultIntervalMs;
+
+        // An unreasonable interval from a peer is clamped instead of trusted.
+        if (interval_ms < kMinIntervalMs)
+            interval_ms = kMinIntervalMs;
+        if (interval_ms > kMaxIntervalMs)
+            interval_ms = kMaxIntervalMs;
+
+        int max_width = static_cast<int>(screen_thumbnail.max_width());
+        int max_height = static_cast<int>(screen_thumbnail.max_height());
+
+        if (max_width == 0)
+            max_width = kDefaultMaxWidth;
+        if (max_height == 0)
+            max_height = kDefaultMaxHeight;
+
+        if (max_width < 0 || max_width > kMaxThumbnailSize ||
+            max_height < 0 || max_height > kMaxThumbnailSize)
+        {
+            LOG(LS_ERROR) << "Invalid thumbnail size: " << max_width << "x" << max_height;
+            return;
+        }
+
+        LOG(LS_INFO) << "Screen thumbnails enabled (interval:" << interval_ms
+                     << "ms box:" << max_width << "x" << max_height << ")";
+
+        thumbnail_interval_ms_ = interval_ms;
+        thumbnail_max_size_.set(max_width, max_height);
+        thumbnail_scaler_.reset();
+        thumbnail_pending_region_.clear();
+        last_thumbnail_time_us_ = 0;
+
+        // Make sure the first still arrives promptly even if the screen is static.
+        desktop_session_proxy_->captureScreen();
+    }
+    else if (extension.name() == common::kFrameHashExtension)
+    {
+        proto::FrameHash frame_hash;
+
+        if (!frame_hash.ParseFromString(extension.data()))
+        {
+            LOG(LS_ERROR) << "Unable to parse frame hash extension data";
+            return;
+        }
+
+        if (!frame_hash.enable())
+        {
+            LOG(LS_INFO) << "Frame hash audit disabled";
+            frame_hash_interval_ = 0;
+            return;
+        }
+
+        static const uint32_t kDefaultInterval = 64;
+        static const uint32_t kMinInterval = 8;
+
+        uint32_t interval = frame_hash.interval();
+        if (interval == 0)
+            interval = kDefaultInterval;
+
+        // An unreasonable interval from a peer is clamped instead of trusted.
+        if (interval < kMinInterval)
+            interval = kMinInterval;
+
+        LOG(LS_INFO) << "Frame hash audit enabled (interval:" << interval << ")";
+
+        frame_hash_interval_ = interval;
+        frame_hash_countdown_ = 0;
+    }
+    else if (extension.name() == common::kSystemInfoExtension)
     {
-        LOG(LS_ERROR) << "Video encoder not initialized!";
+        // The inventory is collected on worker threads and streamed one category at a time; the
+        // channel proxy is safe to use from them. The session thread is not blocked and the
+        // client merges the partial messages as they arrive.
+        std::shared_ptr<base::NetworkChannelProxy> channel_proxy = channelProxy();
+
+        SystemInfoCollector::instance()->collect(
+            [channel_proxy](const proto::SystemInfo& system_info)
+        {
+            proto::HostToClient message;
+
+            proto::DesktopExtension* desktop_extension = message.mutable_extension();
+            desktop_extension->set_name(common::kSystemInfoExtension);
+            desktop_extension->set_data(system_info.SerializeAsString());
+
+            channel_proxy->send(base::serialize(message));
+        });
+    }
+    else
+    {
+        LOG(LS_WARNING) << "Unknown extension: " << extension.name();
+    }
+}
+
+void ClientSessionDesktop::readConfig(const proto::DesktopConfig& config)
+{
+    // The encoder itself lives in the shared pipeline of the user session; here the encoding is
+    // only validated.
+    if (!base::VideoEncoder::create(config.video_encoding()))
+    {
+        // No supported video encoding.
+        LOG(LS_ERROR) << "Unsupported video encoding: " << config.video_encoding();
         return;
     }
 
+    video_encoding_ = config.video_encoding();
+
     switch (config.audio_encoding())
     {
         case proto::AUDIO_ENCODING_OPUS:
-            audio_encoder_ = std::make_unique<base::AudioEncoderOpus>();
-            break;
+        {
+            // A new pipeline replaces the old one; tasks already queued keep their reference,
+            // so the old encoder is destroyed after the last of them has finished.
+            audio_pipeline_ = std::make_shared<AudioPipeline>();
+            audio_pipeline_->encoder = std::make_unique<base::AudioEncoderOpus>();
+            audio_pipeline_->channel_proxy = channelProxy();
+
+            if (!audio_sequence_)
+                audio_sequence_ = base::ThreadPool::instance()->createSequence();
+        }
+        break;
 
         default:
         {
             LOG(LS_WARNING) << "Unsupported audio encoding: " << config.audio_encoding();
-            audio_encoder_.reset();
+            audio_pipeline_.reset();
         }
         break;
     }
 
-    cursor_encoder_.reset();
+    // A new pipeline replaces the old one; queued tasks keep their reference and run before
+    // the tasks of the new pipeline, because the sequence is shared.
+    cursor_pipeline_.reset();
     if (config.flags() & proto::ENABLE_CURSOR_SHAPE)
-        cursor_encoder_ = std::make_unique<base::CursorEncoder>();
+    {
+        cursor_pipeline_ = std::make_shared<CursorPipeline>();
+        cursor_pipeline_->encoder = std::make_unique<base::CursorEncoder>(
+            (config.flags() & proto::CURSOR_DICT) != 0);
+        cursor_pipeline_->channel_proxy = channelProxy();
 
-    scale_reducer_ = std::make_unique<base::ScaleReducer>();
+        if (!cursor_sequence_)
+            cursor_sequence_ = base::ThreadPool::instance()->createSequence();
+    }
 
     desktop_session_config_.disable_font_smoothing =
         (config.flags() & proto::DISABLE_FONT_SMOOTHING);
@@ -405,7 +941,7 @@ void ClientSessionDesktop::readConfig(const proto::DesktopConfig& config)
 
     LOG(LS_INFO) << "NEW CLIENT CONFIGURATION";
     LOG(LS_INFO) << "Video encoding: " << config.video_encoding();
-    LOG(LS_INFO) << "Enable cursor shape: " << (cursor_encoder_ != nullptr);
+    LOG(LS_INFO) << "Enable cursor shape: " << (cursor_pipeline_ != nullptr);
     LOG(LS_INFO) << "Disable font smoothing: " << desktop_session_config_.disable_font_smoothing;
     LOG(LS_INFO) << "Disable desktop effects: " << desktop_session_config_.disable_effects;
     LOG(LS_INFO) << "Disable desktop wallpaper: " << desktop_session_config_.disable_wallpaper;
@@ -415,4 +951,36 @@ void ClientSessionDesktop::readConfig(const proto::DesktopConfig& config)
     delegate_->onClientSessionConfigured();
 }
 
+bool ClientSessionDesktop::checkInputEvent(uint32_t sequence, uint64_t timestamp, bool* is_stale)
+{
+    DCHECK(is_stale);
+    *is_stale = false;
+
+    // Zero in both fields means the client does not number its events; inject everything as
+    // before.
+    if (sequence != 0)
+    {
+        // TCP delivers in order, so an out-of-order or repeated sequence is a replay of an
+        // event that was already injected.
+        if (last_input_sequence_ != 0 && sequence <= last_input_sequence_)
+            return false;
+
+        last_input_sequence_ = sequence;
+    }
+
+    if (timestamp != 0)
+    {
+        const int64_t delay_ms = currentTimeMs() - static_cast<int64_t>(timestamp);
+
+        // The smallest delay ever observed approximates the constant clock offset plus the
+        // minimum path delay. Both clocks are monotonic, so the baseline does not drift.
+        if (delay_ms < input_delay_baseline_ms_)
+            input_delay_baseline_ms_ = delay_ms;
+
+        *is_stale = (delay_ms - input_delay_baseline_ms_) > kStaleInputDelayMs;
+    }
+
+    return true;
+}
+
 } // namespace host
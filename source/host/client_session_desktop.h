@@ -20,24 +20,30 @@
 #define HOST__CLIENT_SESSION_DESKTOP_H
 
 #include "base/macros_magic.h"
+#include "base/perf_meter.h"
 #include "base/desktop/geometry.h"
+#include "base/desktop/region.h"
+#include "base/threading/thread_pool.h"
 #include "host/client_session.h"
 #include "host/desktop_session.h"
 
+#include <limits>
+
 namespace base {
 class AudioEncoder;
 class CursorEncoder;
 class Frame;
 class MouseCursor;
 class ScaleReducer;
-class VideoEncoder;
 } // namespace base
 
 namespace host {
 
 class DesktopSessionProxy;
 
-class ClientSessionDesktop : public ClientSession
+class ClientSessionDesktop
+    : public ClientSession,
+      public base::NetworkChannel::StreamListener
 {
 public:
     ClientSessionDesktop(proto::SessionType session_type,
@@ -46,17 +52,76 @@ public:
 
     void setDesktopSessionProxy(std::shared_ptr<DesktopSessionProxy> desktop_session_proxy);
 
-    void encodeScreen(const base::Frame* frame, const base::MouseCursor* cursor);
+    // Shared video pipeline interface. The user session groups its desktop clients by video
+    // profile (encoding and target size), scales and encodes each profile once and hands every
+    // member of the group the same encoded packet.
+
+    // Timing and scale information of the pipeline pass that produced a packet. Recorded into
+    // the per-client statistics; the scale factors map client input coordinates back to the
+    // source screen.
+    struct PipelinePass
+    {
+        uint64_t capture_time_us = 0;
+        uint64_t scale_time_us = 0;
+        uint64_t encode_time_us = 0;
+        double scale_x = 100.0;
+        double scale_y = 100.0;
+    };
+
+    // Video encoding requested by the client, VIDEO_ENCODING_UNKNOWN until a supported
+    // configuration is received.
+    proto::VideoEncoding videoEncoding() const { return video_encoding_; }
+
+    // Size the video stream of this client should have for a source screen of |source_size|.
+    base::Size videoSize(const base::Size& source_size) const;
+
+    // Sends an already encoded video packet and/or the mouse cursor to the client. |packet| may
+    // be nullptr when only the cursor has changed.
+    void sendEncodedScreen(const proto::VideoPacket* packet, const base::MouseCursor* cursor,
+                           const PipelinePass& pass);
+
+    // Returns the pending video recovery request of this client and clears it. The user session
+    // consumes it before encoding the next frame.
+    proto::VideoRecovery::Action takeVideoRecovery();
+
+    // Last delivery rate reported by the client in kilobits per second, 0 until the first
+    // report. The user session feeds it into the bitrate selection of the shared encoder.
+    int bandwidthEstimateKbps() const { return bandwidth_estimate_kbps_; }
+
+    // Encoding profile requested by the client. All fields are 0 (no limits) until the client
+    // sends a video profile extension. The user session applies it to the video pipeline of
+    // this client without restarting the stream.
+    const proto::VideoProfile& videoProfile() const { return video_profile_; }
+
+    // True while the viewer window of this client is visible. Starts as true; updated by the
+    // viewer state extension. The user session downshifts screen capture to a thumbnail rate
+    // when no connected client has a visible viewer window.
+    bool isViewerVisible() const { return viewer_visible_; }
+
+    // Produces a thumbnail still from |frame| if the client has enabled the screen thumbnail
+    // extension and the configured interval has passed. The user session calls it with the
+    // frame of the regular capture pass, so no additional capture is performed. Damage of the
+    // skipped frames accumulates and the next still carries it.
+    void encodeThumbnail(const base::Frame* frame);
+
     void encodeAudio(const proto::AudioPacket& audio_packet);
     void setScreenList(const proto::ScreenList& list);
     void injectClipboardEvent(const proto::ClipboardEvent& event);
 
     const DesktopSession::Config& desktopSessionConfig() const { return desktop_session_config_; }
 
+    // Number of messages queued for sending to the client.
+    size_t pendingMessages() const { return pending_messages_; }
+
 protected:
     // net::Listener implementation.
     void onMessageReceived(const base::ByteArray& buffer) override;
     void onMessageWritten(size_t pending) override;
+    void onMessagesDropped(uint8_t stream_id, size_t count) override;
+
+    // base::NetworkChannel::StreamListener implementation. Carries chunked clipboard transfers
+    // off the default stream, so bulk copies do not stall video and input traffic.
+    void onStreamMessageReceived(uint8_t stream_id, const base::ByteArray& buffer) override;
 
     // ClientSession implementation.
     void onStarted() override;
@@ -64,18 +129,96 @@ protected:
 private:
     void readExtension(const proto::DesktopExtension& extension);
     void readConfig(const proto::DesktopConfig& config);
+    bool checkInputEvent(uint32_t sequence, uint64_t timestamp, bool* is_stale);
+
+    void encodeCursor(const base::MouseCursor& mouse_cursor);
 
     std::shared_ptr<DesktopSessionProxy> desktop_session_proxy_;
-    std::unique_ptr<base::ScaleReducer> scale_reducer_;
-    std::unique_ptr<base::VideoEncoder> video_encoder_;
-    std::unique_ptr<base::CursorEncoder> cursor_encoder_;
-    std::unique_ptr<base::AudioEncoder> audio_encoder_;
+
+    // Cursor encoding state. It is touched only from tasks on |cursor_sequence_|, so
+    // compression of a large cursor (accessibility cursors reach 256x256 with alpha) never
+    // delays the video frame it arrived with. Held through a shared pointer: tasks in flight
+    // may outlive the session.
+    struct CursorPipeline
+    {
+        std::unique_ptr<base::CursorEncoder> encoder;
+        std::shared_ptr<base::NetworkChannelProxy> channel_proxy;
+        proto::HostToClient outgoing_message;
+    };
+
+    std::shared_ptr<CursorPipeline> cursor_pipeline_;
+    std::shared_ptr<base::ThreadPool::Sequence> cursor_sequence_;
+
+    // Audio encoding state. It is touched only from tasks on |audio_sequence_|, so opus
+    // encoding runs off the session thread and a long video encode does not stall the audio
+    // stream. Held through a shared pointer: tasks in flight may outlive the session.
+    struct AudioPipeline
+    {
+        std::unique_ptr<base::AudioEncoder> encoder;
+        std::shared_ptr<base::NetworkChannelProxy> channel_proxy;
+        proto::HostToClient outgoing_message;
+    };
+
+    std::shared_ptr<AudioPipeline> audio_pipeline_;
+    std::shared_ptr<base::ThreadPool::Sequence> audio_sequence_;
+
     DesktopSession::Config desktop_session_config_;
+    proto::VideoEncoding video_encoding_ = proto::VIDEO_ENCODING_UNKNOWN;
+    proto::VideoRecovery::Action video_recovery_ = proto::VideoRecovery::ACTION_UNKNOWN;
+    int bandwidth_estimate_kbps_ = 0;
+    proto::VideoProfile video_profile_;
+    bool viewer_visible_ = true;
     base::Size preferred_size_;
 
+    // Screen thumbnail state, active while |thumbnail_interval_ms_| is not zero. The scaler is
+    // the same incremental ScaleReducer the video pipelines use, so a still of a mostly static
+    // screen only rescales the damaged area.
+    std::unique_ptr<base::ScaleReducer> thumbnail_scaler_;
+    base::Size thumbnail_max_size_;
+    base::Region thumbnail_pending_region_;
+    uint32_t thumbnail_interval_ms_ = 0;
+    uint64_t last_thumbnail_time_us_ = 0;
+
+    // Frame hash audit state, active while |frame_hash_interval_| is not zero. Every
+    // |frame_hash_interval_|-th video packet carries a hash of its encoded data for the client
+    // to verify (see kFrameHashExtension).
+    uint32_t frame_hash_interval_ = 0;
+    uint32_t frame_hash_countdown_ = 0;
+
+    size_t pending_messages_ = 0;
+
+    // Scale factors of the last pipeline pass, used to map client input coordinates back to
+    // the source screen.
+    double scale_factor_x_ = 100.0;
+    double scale_factor_y_ = 100.0;
+
+    // Input staleness state (see checkInputEvent). The baseline is the smallest observed
+    // difference between the host clock and the client timestamps; events delayed well beyond
+    // it sat in a stalled connection.
+    uint32_t last_input_sequence_ = 0;
+    int64_t input_delay_baseline_ms_ = std::numeric_limits<int64_t>::max();
+    uint32_t last_mouse_mask_ = 0;
+    uint32_t last_key_usb_keycode_ = 0;
+    uint32_t last_key_flags_ = 0;
+
+    // Pipeline timing meters, reset when a pipeline stats request is answered.
+    base::PerfMeter capture_meter_;
+    base::PerfMeter scale_meter_;
+    base::PerfMeter encode_meter_;
+    base::PerfMeter send_meter_;
+    uint64_t last_frame_time_us_ = 0;
+
+    // Channel write statistics at the time of the previous stats report.
+    uint64_t last_write_count_ = 0;
+    uint64_t last_write_time_us_ = 0;
+
     proto::ClientToHost incoming_message_;
     proto::HostToClient outgoing_message_;
 
+    // Reused for clipboard stream chunks; keeping the message around retains the string
+    // capacity of the previous chunk, so a large transfer does not allocate per chunk.
+    proto::ClipboardEvent incoming_clipboard_event_;
+
     DISALLOW_COPY_AND_ASSIGN(ClientSessionDesktop);
 };
 
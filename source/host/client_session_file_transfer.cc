@@ -31,10 +31,19 @@
 
 #include <wtsapi32.h>
 
+#include <mutex>
+
 namespace host {
 
 namespace {
 
+// How long a parked worker is kept for reuse. Long enough to cover back-to-back transfers,
+// short enough that a worker impersonating an already logged off user does not linger.
+const std::chrono::seconds kWorkerIdleTimeout{ 60 };
+
+// Upper bound on parked workers across all user sessions.
+const size_t kMaxPooledWorkers = 4;
+
 bool createLoggedOnUserToken(DWORD session_id, base::win::ScopedHandle* token_out)
 {
     base::win::ScopedHandle user_token;
@@ -103,6 +112,13 @@ public:
     void start();
     void postRequest(std::unique_ptr<proto::FileRequest> request);
 
+    base::SessionId sessionId() const { return session_id_; }
+    bool hasUserContext() const { return impl_ != nullptr; }
+
+    // Points the worker at the channel of a new session, or detaches it with nullptr. Replies
+    // to tasks of the previous session are dropped after detaching.
+    void attachChannel(std::shared_ptr<base::NetworkChannelProxy> channel_proxy);
+
 protected:
     // base::Thread::Delegate implementation.
     void onBeforeThreadRunning() override;
@@ -115,6 +131,10 @@ private:
     base::Thread thread_;
     const base::SessionId session_id_;
     std::unique_ptr<base::win::ScopedImpersonator> impersonator_;
+
+    // Replies are sent from the worker thread while the channel can be swapped from the session
+    // thread when a pooled worker is reused.
+    std::mutex channel_lock_;
     std::shared_ptr<base::NetworkChannelProxy> channel_proxy_;
     std::shared_ptr<common::FileTaskProducerProxy> producer_proxy_;
     std::unique_ptr<common::FileWorker> impl_;
@@ -153,10 +173,20 @@ void ClientSessionFileTransfer::Worker::postRequest(std::unique_ptr<proto::FileR
     {
         proto::FileReply reply;
         reply.set_error_code(proto::FILE_ERROR_NO_LOGGED_ON_USER);
-        channel_proxy_->send(base::serialize(reply));
+
+        std::scoped_lock lock(channel_lock_);
+        if (channel_proxy_)
+            channel_proxy_->send(base::serialize(reply));
     }
 }
 
+void ClientSessionFileTransfer::Worker::attachChannel(
+    std::shared_ptr<base::NetworkChannelProxy> channel_proxy)
+{
+    std::scoped_lock lock(channel_lock_);
+    channel_proxy_ = std::move(channel_proxy);
+}
+
 void ClientSessionFileTransfer::Worker::onBeforeThreadRunning()
 {
     base::win::ScopedHandle user_token;
@@ -185,7 +215,9 @@ void ClientSessionFileTransfer::Worker::onAfterThreadRunning()
 
 void ClientSessionFileTransfer::Worker::onTaskDone(std::shared_ptr<common::FileTask> task)
 {
-    channel_proxy_->send(base::serialize(task->reply()));
+    std::scoped_lock lock(channel_lock_);
+    if (channel_proxy_)
+        channel_proxy_->send(base::serialize(task->reply()));
 }
 
 ClientSessionFileTransfer::ClientSessionFileTransfer(std::unique_ptr<base::NetworkChannel> channel)
@@ -194,7 +226,74 @@ ClientSessionFileTransfer::ClientSessionFileTransfer(std::unique_ptr<base::Netwo
     // Nothing
 }
 
-ClientSessionFileTransfer::~ClientSessionFileTransfer() = default;
+ClientSessionFileTransfer::~ClientSessionFileTransfer()
+{
+    if (worker_)
+        releaseWorker(std::move(worker_));
+}
+
+// static
+std::unique_ptr<ClientSessionFileTransfer::Worker> ClientSessionFileTransfer::acquireWorker(
+    base::SessionId session_id, std::shared_ptr<base::NetworkChannelProxy> channel_proxy)
+{
+    WorkerPool& pool = workerPool();
+    const auto now = std::chrono::steady_clock::now();
+
+    // Drop the workers that have been parked for too long.
+    for (auto it = pool.begin(); it != pool.end();)
+    {
+        if (now - it->second >= kWorkerIdleTimeout)
+            it = pool.erase(it);
+        else
+            ++it;
+    }
+
+    for (auto it = pool.begin(); it != pool.end(); ++it)
+    {
+        if (it->first->sessionId() != session_id)
+            continue;
+
+        std::unique_ptr<Worker> worker = std::move(it->first);
+        pool.erase(it);
+
+        LOG(LS_INFO) << "Reusing parked file transfer worker for session " << session_id;
+
+        worker->attachChannel(std::move(channel_proxy));
+        return worker;
+    }
+
+    std::unique_ptr<Worker> worker = std::make_unique<Worker>(
+        session_id, std::move(channel_proxy));
+    worker->start();
+    return worker;
+}
+
+// static
+void ClientSessionFileTransfer::releaseWorker(std::unique_ptr<Worker> worker)
+{
+    // A worker without a user context failed to impersonate. It is cheap to recreate and a new
+    // attempt can succeed after the user has logged on, so it is not kept.
+    if (!worker->hasUserContext())
+        return;
+
+    worker->attachChannel(nullptr);
+
+    WorkerPool& pool = workerPool();
+
+    // The oldest parked worker gives way when the pool is full.
+    if (pool.size() >= kMaxPooledWorkers)
+        pool.erase(pool.begin());
+
+    pool.emplace_back(std::move(worker), std::chrono::steady_clock::now());
+}
+
+// static
+ClientSessionFileTransfer::WorkerPool& ClientSessionFileTransfer::workerPool()
+{
+    // All client sessions run on the same thread, so the pool needs no locking.
+    static WorkerPool pool;
+    return pool;
+}
 
 void ClientSessionFileTransfer::onMessageReceived(const base::ByteArray& buffer)
 {
@@ -207,10 +306,7 @@ void ClientSessionFileTransfer::onMessageReceived(const base::ByteArray& buffer)
     }
 
     if (!worker_)
-    {
-        worker_ = std::make_unique<Worker>(sessionId(), channelProxy());
-        worker_->start();
-    }
+        worker_ = acquireWorker(sessionId(), channelProxy());
 
     worker_->postRequest(std::move(request));
 }
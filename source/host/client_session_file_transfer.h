@@ -22,6 +22,10 @@
 #include "base/macros_magic.h"
 #include "host/client_session.h"
 
+#include <chrono>
+#include <utility>
+#include <vector>
+
 namespace host {
 
 class ClientSessionFileTransfer : public ClientSession
@@ -40,6 +44,19 @@ protected:
 
 private:
     class Worker;
+
+    // A worker carries a running thread and an impersonation token of the user session, both
+    // expensive to set up. A finished session parks its worker instead of destroying it and the
+    // next transfer session of the same user session picks it up, so a repeated transfer starts
+    // without the setup cost. Workers that stay idle for too long are dropped.
+    using WorkerPool =
+        std::vector<std::pair<std::unique_ptr<Worker>, std::chrono::steady_clock::time_point>>;
+
+    static std::unique_ptr<Worker> acquireWorker(
+        base::SessionId session_id, std::shared_ptr<base::NetworkChannelProxy> channel_proxy);
+    static void releaseWorker(std::unique_ptr<Worker> worker);
+    static WorkerPool& workerPool();
+
     std::unique_ptr<Worker> worker_;
 
     DISALLOW_COPY_AND_ASSIGN(ClientSessionFileTransfer);
@@ -20,9 +20,12 @@
 
 #include "base/command_line.h"
 #include "base/logging.h"
+#include "base/process_handle.h"
+#include "base/trace_log.h"
 #include "base/files/base_paths.h"
 #include "base/message_loop/message_loop.h"
 #include "host/desktop_session_agent.h"
+#include "host/system_settings.h"
 
 namespace {
 
@@ -46,11 +49,34 @@ void shutdownLogging()
     base::shutdownLogging();
 }
 
+// Starts timeline trace recording next to the logs when enabled in the system settings.
+void initTracing()
+{
+    if (!host::SystemSettings().isTraceEventsEnabled())
+        return;
+
+    std::filesystem::path path;
+    if (!base::BasePaths::commonAppData(&path))
+        return;
+
+    path.append("aspia/logs");
+    path.append("trace_desktop_agent_" +
+        std::to_string(base::currentProcessId()) + ".json");
+
+    base::TraceLog::instance().start(path);
+}
+
+void shutdownTracing()
+{
+    base::TraceLog::instance().stop();
+}
+
 } // namespace
 
 void desktopAgentMain(int argc, const char* const* argv)
 {
     initLogging();
+    initTracing();
 
     base::CommandLine::init(argc, argv);
     base::CommandLine* command_line = base::CommandLine::forCurrentProcess();
@@ -71,5 +97,6 @@ void desktopAgentMain(int argc, const char* const* argv)
         LOG(LS_ERROR) << "Parameter channel_id is not specified";
     }
 
+    shutdownTracing();
     shutdownLogging();
 }
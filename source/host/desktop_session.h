@@ -44,6 +44,10 @@ public:
         virtual void onAudioCaptured(const proto::AudioPacket& audio_packet) = 0;
         virtual void onScreenListChanged(const proto::ScreenList& list) = 0;
         virtual void onClipboardEvent(const proto::ClipboardEvent& event) = 0;
+
+        // Number of messages queued for sending to clients. Used to slow down screen capture
+        // when the network cannot keep up.
+        virtual size_t pendingMessages() const = 0;
     };
 
     struct Config
@@ -53,6 +57,7 @@ public:
         bool disable_effects = true;
         bool block_input = false;
         bool lock_at_disconnect = false;
+        bool low_memory_mode = false;
 
         bool equals(const Config& other) const
         {
@@ -60,7 +65,8 @@ public:
                    (disable_wallpaper == other.disable_wallpaper) &&
                    (disable_effects == other.disable_effects) &&
                    (block_input == other.block_input) &&
-                   (lock_at_disconnect == other.lock_at_disconnect);
+                   (lock_at_disconnect == other.lock_at_disconnect) &&
+                   (low_memory_mode == other.low_memory_mode);
         }
     };
 
@@ -75,6 +81,19 @@ public:
     virtual void injectKeyEvent(const proto::KeyEvent& event) = 0;
     virtual void injectMouseEvent(const proto::MouseEvent& event) = 0;
     virtual void injectClipboardEvent(const proto::ClipboardEvent& event) = 0;
+
+    // Peak depth of the queue to the desktop agent since the last call. Reading resets the
+    // gauge. Implementations without a queue report 0.
+    virtual size_t takeMaxQueueDepth() { return 0; }
+
+    // While idle the session captures only occasional thumbnail frames; used when no viewer
+    // window is visible on any connected client.
+    virtual void setViewerIdle(bool idle) {}
+
+    // Restricts capture to a sub-rectangle of the selected screen, in screen coordinates. An
+    // empty rectangle restores full-screen capture. Implementations without region support
+    // ignore the call.
+    virtual void setCaptureRegion(const proto::CaptureRegion& region) {}
 };
 
 } // namespace host
@@ -20,6 +20,7 @@
 
 #include "base/logging.h"
 #include "base/power_controller.h"
+#include "base/trace_log.h"
 #include "base/audio/audio_capturer_wrapper.h"
 #include "base/desktop/capture_scheduler.h"
 #include "base/desktop/mouse_cursor.h"
@@ -31,6 +32,14 @@
 
 namespace host {
 
+namespace {
+
+// Input events arrive in bursts (pointer moves, key autorepeat). The early capture fires after
+// the burst has settled, so one burst produces one capture.
+const std::chrono::milliseconds kInputSettleDelay{ 5 };
+
+} // namespace
+
 DesktopSessionAgent::DesktopSessionAgent(std::shared_ptr<base::TaskRunner> task_runner)
     : task_runner_(std::move(task_runner))
 {
@@ -50,6 +59,14 @@ void DesktopSessionAgent::start(std::u16string_view channel_id)
 
     channel_->setListener(this);
     channel_->resume();
+
+    // Create the capture subsystem right away, while the service is still finishing the
+    // attach. Screen capturer initialization is the slow part of a session start; doing it
+    // here means the first ENABLE request begins streaming immediately.
+    shared_memory_factory_ = std::make_unique<base::SharedMemoryFactory>(this);
+
+    screen_capturer_ = std::make_unique<base::ScreenCapturerWrapper>(this);
+    screen_capturer_->setSharedMemoryFactory(shared_memory_factory_.get());
 }
 
 void DesktopSessionAgent::onDisconnected()
@@ -70,18 +87,24 @@ void DesktopSessionAgent::onMessageReceived(const base::ByteArray& buffer)
 
     if (incoming_message_.has_next_screen_capture())
     {
-        captureEnd(std::chrono::milliseconds(
+        onNextScreenCapture(std::chrono::milliseconds(
             incoming_message_.next_screen_capture().update_interval()));
     }
     else if (incoming_message_.has_mouse_event())
     {
         if (input_injector_)
+        {
             input_injector_->injectMouseEvent(incoming_message_.mouse_event());
+            wakeCaptureOnInput();
+        }
     }
     else if (incoming_message_.has_key_event())
     {
         if (input_injector_)
+        {
             input_injector_->injectKeyEvent(incoming_message_.key_event());
+            wakeCaptureOnInput();
+        }
     }
     else if (incoming_message_.has_clipboard_event())
     {
@@ -96,6 +119,16 @@ void DesktopSessionAgent::onMessageReceived(const base::ByteArray& buffer)
                 incoming_message_.select_source().screen().id()));
         }
     }
+    else if (incoming_message_.has_capture_region())
+    {
+        if (screen_capturer_)
+        {
+            const proto::CaptureRegion& region = incoming_message_.capture_region();
+
+            screen_capturer_->setCaptureRegion(base::Rect::makeXYWH(
+                region.x(), region.y(), region.width(), region.height()));
+        }
+    }
     else if (incoming_message_.has_configure())
     {
         const proto::internal::Configure& config = incoming_message_.configure();
@@ -105,6 +138,7 @@ void DesktopSessionAgent::onMessageReceived(const base::ByteArray& buffer)
             screen_capturer_->enableWallpaper(!config.disable_wallpaper());
             screen_capturer_->enableEffects(!config.disable_effects());
             screen_capturer_->enableFontSmoothing(!config.disable_font_smoothing());
+            screen_capturer_->setLowMemoryMode(config.low_memory_mode());
         }
 
         if (input_injector_)
@@ -206,6 +240,7 @@ void DesktopSessionAgent::onScreenCaptured(
         serialized_frame->set_height(frame->size().height());
         serialized_frame->set_dpi_x(frame->dpi().x());
         serialized_frame->set_dpi_y(frame->dpi().y());
+        serialized_frame->set_capture_time_us(screen_capturer_->lastCaptureTimeUs());
 
         for (base::Region::Iterator it(frame->constUpdatedRegion()); !it.isAtEnd(); it.advance())
         {
@@ -233,12 +268,32 @@ void DesktopSessionAgent::onScreenCaptured(
 
     if (screen_captured->has_frame() || screen_captured->has_mouse_cursor())
     {
+        if (frame_in_flight_)
+        {
+            // The host is still encoding the previous frame. The new one is kept until the
+            // acknowledgment arrives; the capture loop pauses, because the frame ring is full.
+            pending_frame_ = base::serialize(outgoing_message_);
+
+            if (capture_scheduler_)
+                capture_scheduler_->endCapture();
+            return;
+        }
+
+        frame_in_flight_ = true;
+
+        if (base::TraceLog::isEnabled())
+        {
+            base::TraceLog::instance().addInstantEvent(
+                "ipc", "FrameToHost", base::TraceLog::nowUs());
+        }
+
         channel_->send(base::serialize(outgoing_message_));
+
+        // The next frame is captured into another buffer of the ring while the host encodes
+        // the one just sent.
     }
-    else
-    {
-        captureEnd(capture_scheduler_->updateInterval());
-    }
+
+    captureEnd(capture_scheduler_->updateInterval());
 }
 
 void DesktopSessionAgent::onClipboardEvent(const proto::ClipboardEvent& event)
@@ -267,34 +322,46 @@ void DesktopSessionAgent::setEnabled(bool enable)
         clipboard_monitor_ = std::make_unique<common::ClipboardMonitor>();
         clipboard_monitor_->start(task_runner_, this);
 
-        // Create a shared memory factory.
-        // We will receive notifications of all creations and destruction of shared memory.
-        shared_memory_factory_ = std::make_unique<base::SharedMemoryFactory>(this);
+        // The capture subsystem is normally created at process start and kept across
+        // enable/disable cycles; recreate it here only if that failed.
+        if (!shared_memory_factory_)
+        {
+            // Create a shared memory factory.
+            // We will receive notifications of all creations and destruction of shared memory.
+            shared_memory_factory_ = std::make_unique<base::SharedMemoryFactory>(this);
+        }
 
         capture_scheduler_ = std::make_unique<base::CaptureScheduler>(
             std::chrono::milliseconds(40));
 
-        screen_capturer_ = std::make_unique<base::ScreenCapturerWrapper>(this);
-        screen_capturer_->setSharedMemoryFactory(shared_memory_factory_.get());
+        if (!screen_capturer_)
+        {
+            screen_capturer_ = std::make_unique<base::ScreenCapturerWrapper>(this);
+            screen_capturer_->setSharedMemoryFactory(shared_memory_factory_.get());
+        }
 
         audio_capturer_ = std::make_unique<base::AudioCapturerWrapper>(channel_->channelProxy());
         audio_capturer_->start();
 
         LOG(LS_INFO) << "Session successfully started";
 
-        task_runner_->postTask(std::bind(&DesktopSessionAgent::captureBegin, shared_from_this()));
+        scheduleNextCapture(std::chrono::milliseconds::zero());
     }
     else
     {
         LOG(LS_INFO) << "Session stop...";
 
+        // The screen capturer and shared memory factory are deliberately kept: the process
+        // stays attached as a warm standby and the next ENABLE reuses them, skipping capture
+        // initialization and shared buffer setup.
         input_injector_.reset();
         capture_scheduler_.reset();
-        screen_capturer_.reset();
-        shared_memory_factory_.reset();
         clipboard_monitor_.reset();
         audio_capturer_.reset();
 
+        frame_in_flight_ = false;
+        pending_frame_.clear();
+
         if (lock_at_disconnect_)
         {
             base::PowerController::lock();
@@ -305,11 +372,18 @@ void DesktopSessionAgent::setEnabled(bool enable)
     }
 }
 
-void DesktopSessionAgent::captureBegin()
+void DesktopSessionAgent::captureBegin(uint32_t epoch)
 {
     if (!capture_scheduler_ || !screen_capturer_)
         return;
 
+    // A stale epoch means this capture was replaced by one scheduled later (an input wake);
+    // dropping it keeps a single capture chain running.
+    if (epoch != capture_epoch_)
+        return;
+
+    base::ScopedTraceEvent trace_event("capture", "CaptureTick");
+
     capture_scheduler_->beginCapture();
     screen_capturer_->captureFrame();
 }
@@ -320,20 +394,87 @@ void DesktopSessionAgent::captureEnd(const std::chrono::milliseconds& update_int
         return;
 
     capture_scheduler_->endCapture();
+    scheduleNextCapture(update_interval);
+}
+
+void DesktopSessionAgent::scheduleNextCapture(const std::chrono::milliseconds& update_interval)
+{
+    if (!capture_scheduler_)
+        return;
+
+    uint32_t epoch = ++capture_epoch_;
 
     if (update_interval == std::chrono::milliseconds::zero())
     {
         // Capture immediately.
-        task_runner_->postTask(std::bind(&DesktopSessionAgent::captureBegin, shared_from_this()));
+        task_runner_->postTask(
+            std::bind(&DesktopSessionAgent::captureBegin, shared_from_this(), epoch));
     }
     else
     {
         capture_scheduler_->setUpdateInterval(update_interval);
 
         task_runner_->postDelayedTask(
-            std::bind(&DesktopSessionAgent::captureBegin, shared_from_this()),
+            std::bind(&DesktopSessionAgent::captureBegin, shared_from_this(), epoch),
             capture_scheduler_->nextCaptureDelay());
     }
 }
 
+void DesktopSessionAgent::onNextScreenCapture(const std::chrono::milliseconds& update_interval)
+{
+    frame_in_flight_ = false;
+
+    if (pending_frame_.empty())
+    {
+        // The capture loop is running ahead of the encoder; only the recommended interval has
+        // to be applied.
+        if (capture_scheduler_ && update_interval != std::chrono::milliseconds::zero())
+            capture_scheduler_->setUpdateInterval(update_interval);
+        return;
+    }
+
+    // A frame was captured while the previous one was being encoded. Hand it over and resume
+    // the capture loop.
+    frame_in_flight_ = true;
+
+    if (base::TraceLog::isEnabled())
+    {
+        base::TraceLog::instance().addInstantEvent(
+            "ipc", "FrameToHost", base::TraceLog::nowUs());
+    }
+
+    channel_->send(std::move(pending_frame_));
+    pending_frame_.clear();
+
+    scheduleNextCapture(update_interval);
+}
+
+void DesktopSessionAgent::wakeCaptureOnInput()
+{
+    if (!capture_scheduler_ || input_wake_pending_)
+        return;
+
+    input_wake_pending_ = true;
+
+    task_runner_->postDelayedTask(
+        std::bind(&DesktopSessionAgent::onInputSettled, shared_from_this()), kInputSettleDelay);
+}
+
+void DesktopSessionAgent::onInputSettled()
+{
+    input_wake_pending_ = false;
+
+    if (!capture_scheduler_ || !screen_capturer_)
+        return;
+
+    // Capture right away so the effect of the injected input reaches the client without waiting
+    // out the rest of the update interval. Skipped while captures are frequent enough anyway;
+    // the idle frame rate is unaffected because the loop returns to the regular schedule right
+    // after the early capture.
+    if (!capture_scheduler_->shouldCaptureAfterInput())
+        return;
+
+    scheduleNextCapture(std::chrono::milliseconds::zero());
+}
+
 } // namespace host
@@ -70,8 +70,12 @@ protected:
 
 private:
     void setEnabled(bool enable);
-    void captureBegin();
+    void captureBegin(uint32_t epoch);
     void captureEnd(const std::chrono::milliseconds& update_interval);
+    void scheduleNextCapture(const std::chrono::milliseconds& update_interval);
+    void onNextScreenCapture(const std::chrono::milliseconds& update_interval);
+    void wakeCaptureOnInput();
+    void onInputSettled();
 
     std::shared_ptr<base::TaskRunner> task_runner_;
 
@@ -89,6 +93,18 @@ private:
 
     bool lock_at_disconnect_ = false;
 
+    // The capture loop runs ahead of the encoder: while the host encodes the frame that is in
+    // flight, the next one is captured into another buffer of the frame ring. Only one frame is
+    // kept waiting; the loop pauses until the acknowledgment arrives.
+    bool frame_in_flight_ = false;
+    base::ByteArray pending_frame_;
+
+    // Wake-on-input: injected input schedules an early capture once the event burst settles, so
+    // click feedback does not wait out the rest of the update interval. Scheduled captures carry
+    // an epoch number; bumping it invalidates the regular capture replaced by the early one.
+    bool input_wake_pending_ = false;
+    uint32_t capture_epoch_ = 0;
+
     DISALLOW_COPY_AND_ASSIGN(DesktopSessionAgent);
 };
 
@@ -111,6 +111,7 @@ void DesktopSessionIpc::configure(const Config& config)
     configure->set_disable_effects(config.disable_effects);
     configure->set_block_input(config.block_input);
     configure->set_lock_at_disconnect(config.lock_at_disconnect);
+    configure->set_low_memory_mode(config.low_memory_mode);
 
     channel_->send(base::serialize(outgoing_message_));
 }
@@ -122,6 +123,16 @@ void DesktopSessionIpc::selectScreen(const proto::Screen& screen)
     channel_->send(base::serialize(outgoing_message_));
 }
 
+void DesktopSessionIpc::setCaptureRegion(const proto::CaptureRegion& region)
+{
+    // The cached frame has the old geometry; do not replay it after the region has changed.
+    last_frame_ = nullptr;
+
+    outgoing_message_.Clear();
+    outgoing_message_.mutable_capture_region()->CopyFrom(region);
+    channel_->send(base::serialize(outgoing_message_));
+}
+
 void DesktopSessionIpc::captureScreen()
 {
     if (last_frame_)
@@ -131,7 +142,7 @@ void DesktopSessionIpc::captureScreen()
         if (last_screen_list_)
             delegate_->onScreenListChanged(*last_screen_list_);
 
-        delegate_->onScreenCaptured(last_frame_.get(), last_mouse_cursor_.get());
+        delegate_->onScreenCaptured(last_frame_, last_mouse_cursor_.get());
     }
     else
     {
@@ -162,6 +173,23 @@ void DesktopSessionIpc::injectClipboardEvent(const proto::ClipboardEvent& event)
     channel_->send(base::serialize(outgoing_message_));
 }
 
+size_t DesktopSessionIpc::takeMaxQueueDepth()
+{
+    return channel_->takeMaxQueueDepth();
+}
+
+void DesktopSessionIpc::setViewerIdle(bool idle)
+{
+    if (capture_scheduler_.isIdle() == idle)
+        return;
+
+    LOG(LS_INFO) << "Viewer idle mode changed: " << idle;
+
+    // The new interval takes effect with the next captured frame. Leaving idle mode therefore
+    // takes at most one idle interval; the caller resends the last frame in the meantime.
+    capture_scheduler_.setIdle(idle);
+}
+
 void DesktopSessionIpc::onDisconnected()
 {
     if (delegate_)
@@ -231,17 +259,17 @@ void DesktopSessionIpc::onScreenCaptured(const proto::internal::ScreenCaptured&
     {
         const proto::internal::DesktopFrame& serialized_frame = screen_captured.frame();
 
-        std::unique_ptr<SharedBuffer> shared_buffer = sharedBuffer(
-            serialized_frame.shared_buffer_id());
-        if (shared_buffer)
+        last_frame_ = attachedFrame(
+            serialized_frame.shared_buffer_id(),
+            base::Size(serialized_frame.width(), serialized_frame.height()));
+        if (last_frame_)
         {
-            last_frame_ = base::SharedMemoryFrame::attach(
-                base::Size(serialized_frame.width(), serialized_frame.height()),
-                std::move(shared_buffer));
             last_frame_->setDpi(base::Point(
                 serialized_frame.dpi_x(), serialized_frame.dpi_y()));
+            last_frame_->setCaptureTimeUs(serialized_frame.capture_time_us());
 
             base::Region* updated_region = last_frame_->updatedRegion();
+            updated_region->clear();
 
             for (int i = 0; i < serialized_frame.dirty_rect_size(); ++i)
             {
@@ -250,7 +278,7 @@ void DesktopSessionIpc::onScreenCaptured(const proto::internal::ScreenCaptured&
                     dirty_rect.x(), dirty_rect.y(), dirty_rect.width(), dirty_rect.height()));
             }
 
-            frame = last_frame_.get();
+            frame = last_frame_;
         }
     }
 
@@ -270,10 +298,15 @@ void DesktopSessionIpc::onScreenCaptured(const proto::internal::ScreenCaptured&
         mouse_cursor = last_mouse_cursor_.get();
     }
 
+    capture_scheduler_.beginEncode();
     delegate_->onScreenCaptured(frame, mouse_cursor);
+    capture_scheduler_.endEncode();
+
+    capture_scheduler_.setPendingMessages(delegate_->pendingMessages());
 
     outgoing_message_.Clear();
-    outgoing_message_.mutable_next_screen_capture()->set_update_interval(40);
+    outgoing_message_.mutable_next_screen_capture()->set_update_interval(
+        static_cast<uint32_t>(capture_scheduler_.recommendedUpdateInterval().count()));
     channel_->send(base::serialize(outgoing_message_));
 }
 
@@ -298,6 +331,15 @@ void DesktopSessionIpc::onCreateSharedBuffer(int shared_buffer_id)
 
 void DesktopSessionIpc::onReleaseSharedBuffer(int shared_buffer_id)
 {
+    auto result = attached_frames_.find(shared_buffer_id);
+    if (result != attached_frames_.end())
+    {
+        if (last_frame_ == result->second.get())
+            last_frame_ = nullptr;
+
+        attached_frames_.erase(result);
+    }
+
     shared_buffers_.erase(shared_buffer_id);
 }
 
@@ -314,4 +356,24 @@ std::unique_ptr<DesktopSessionIpc::SharedBuffer> DesktopSessionIpc::sharedBuffer
     return result->second->share();
 }
 
+base::Frame* DesktopSessionIpc::attachedFrame(int shared_buffer_id, const base::Size& size)
+{
+    // The desktop agent cycles through a fixed set of shared buffers, so after the first few
+    // frames this is a lookup without any allocation.
+    auto result = attached_frames_.find(shared_buffer_id);
+    if (result != attached_frames_.end() && result->second->size() == size)
+        return result->second.get();
+
+    std::unique_ptr<SharedBuffer> shared_buffer = sharedBuffer(shared_buffer_id);
+    if (!shared_buffer)
+        return nullptr;
+
+    std::unique_ptr<base::Frame> frame =
+        base::SharedMemoryFrame::attach(size, std::move(shared_buffer));
+    base::Frame* frame_ptr = frame.get();
+
+    attached_frames_.insert_or_assign(shared_buffer_id, std::move(frame));
+    return frame_ptr;
+}
+
 } // namespace host
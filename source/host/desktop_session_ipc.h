@@ -20,6 +20,7 @@
 #define HOST__DESKTOP_SESSION_IPC_H
 
 #include "base/ipc/ipc_channel.h"
+#include "base/desktop/capture_scheduler.h"
 #include "host/desktop_session.h"
 
 namespace host {
@@ -38,10 +39,13 @@ public:
     void control(proto::internal::Control::Action action) override;
     void configure(const Config& config) override;
     void selectScreen(const proto::Screen& screen) override;
+    void setCaptureRegion(const proto::CaptureRegion& region) override;
     void captureScreen() override;
     void injectKeyEvent(const proto::KeyEvent& event) override;
     void injectMouseEvent(const proto::MouseEvent& event) override;
     void injectClipboardEvent(const proto::ClipboardEvent& event) override;
+    size_t takeMaxQueueDepth() override;
+    void setViewerIdle(bool idle) override;
 
 protected:
     // base::IpcChannel::Listener implementation.
@@ -51,16 +55,23 @@ protected:
 private:
     class SharedBuffer;
     using SharedBuffers = std::map<int, std::unique_ptr<SharedBuffer>>;
+    using AttachedFrames = std::map<int, std::unique_ptr<base::Frame>>;
 
     void onScreenCaptured(const proto::internal::ScreenCaptured& screen_captured);
     void onAudioCaptured(const proto::AudioPacket& audio_packet);
     void onCreateSharedBuffer(int shared_buffer_id);
     void onReleaseSharedBuffer(int shared_buffer_id);
     std::unique_ptr<SharedBuffer> sharedBuffer(int shared_buffer_id);
+    base::Frame* attachedFrame(int shared_buffer_id, const base::Size& size);
 
     std::unique_ptr<base::IpcChannel> channel_;
     SharedBuffers shared_buffers_;
-    std::unique_ptr<base::Frame> last_frame_;
+
+    // Frames attached to the shared buffers. The desktop agent reuses a fixed set of buffers, so
+    // attaching once per buffer instead of once per captured frame keeps the capture hot path
+    // free of allocations. |last_frame_| points into this map.
+    AttachedFrames attached_frames_;
+    base::Frame* last_frame_ = nullptr;
     std::unique_ptr<base::MouseCursor> last_mouse_cursor_;
     std::unique_ptr<proto::ScreenList> last_screen_list_;
 
@@ -68,6 +79,10 @@ private:
     proto::internal::DesktopToService incoming_message_;
     Delegate* delegate_;
 
+    // Adapts the update interval sent to the desktop agent to the measured encode time and to
+    // the network send queue depth.
+    base::CaptureScheduler capture_scheduler_{ std::chrono::milliseconds(40) };
+
     DISALLOW_COPY_AND_ASSIGN(DesktopSessionIpc);
 };
 
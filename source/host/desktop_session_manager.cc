@@ -65,6 +65,7 @@ void DesktopSessionManager::attachSession(
     }
 
     state_ = State::STARTING;
+    session_id_ = session_id;
 
     std::u16string channel_id = base::IpcServer::createUniqueId();
 
@@ -164,7 +165,18 @@ void DesktopSessionManager::onDesktopSessionStarted()
 
 void DesktopSessionManager::onDesktopSessionStopped()
 {
+    // When the process ends while we are attached, it was not us who stopped it.
+    const bool respawn = (state_ == State::ATTACHED);
+
     dettachSession(FROM_HERE);
+
+    if (respawn && session_id_ != base::kInvalidSessionId)
+    {
+        // Bring up a standby agent right away instead of waiting for the next attach request,
+        // so the next attach costs only the IPC handshake. Clients stay on the fake session
+        // created by dettachSession() until the new process connects.
+        attachSession(FROM_HERE, session_id_);
+    }
 }
 
 void DesktopSessionManager::onScreenCaptured(
@@ -178,6 +190,11 @@ void DesktopSessionManager::onAudioCaptured(const proto::AudioPacket& audio_pack
     delegate_->onAudioCaptured(audio_packet);
 }
 
+size_t DesktopSessionManager::pendingMessages() const
+{
+    return delegate_->pendingMessages();
+}
+
 void DesktopSessionManager::onScreenListChanged(const proto::ScreenList& list)
 {
     delegate_->onScreenListChanged(list);
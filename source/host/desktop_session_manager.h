@@ -62,6 +62,7 @@ protected:
     void onAudioCaptured(const proto::AudioPacket& audio_packet) override;
     void onScreenListChanged(const proto::ScreenList& list) override;
     void onClipboardEvent(const proto::ClipboardEvent& event) override;
+    size_t pendingMessages() const override;
 
 private:
     enum class State { STOPPED, STARTING, STOPPING, DETACHED, ATTACHED };
@@ -73,6 +74,11 @@ private:
     base::WaitableTimer session_attach_timer_;
 
     State state_ = State::STOPPED;
+
+    // Session the manager is (or was last) attached to. Used to respawn a standby agent when
+    // the session process ends unexpectedly.
+    base::SessionId session_id_ = base::kInvalidSessionId;
+
     DesktopSession::Delegate* delegate_;
 
     DISALLOW_COPY_AND_ASSIGN(DesktopSessionManager);
@@ -41,12 +41,24 @@ void DesktopSessionProxy::configure(const DesktopSession::Config& config)
         desktop_session_->configure(config);
 }
 
+void DesktopSessionProxy::setViewerIdle(bool idle)
+{
+    if (desktop_session_)
+        desktop_session_->setViewerIdle(idle);
+}
+
 void DesktopSessionProxy::selectScreen(const proto::Screen& screen)
 {
     if (desktop_session_)
         desktop_session_->selectScreen(screen);
 }
 
+void DesktopSessionProxy::setCaptureRegion(const proto::CaptureRegion& region)
+{
+    if (desktop_session_)
+        desktop_session_->setCaptureRegion(region);
+}
+
 void DesktopSessionProxy::captureScreen()
 {
     if (desktop_session_)
@@ -71,6 +83,14 @@ void DesktopSessionProxy::injectClipboardEvent(const proto::ClipboardEvent& even
         desktop_session_->injectClipboardEvent(event);
 }
 
+size_t DesktopSessionProxy::takeMaxQueueDepth()
+{
+    if (desktop_session_)
+        return desktop_session_->takeMaxQueueDepth();
+
+    return 0;
+}
+
 void DesktopSessionProxy::attachAndStart(DesktopSession* desktop_session)
 {
     desktop_session_ = desktop_session;
@@ -34,11 +34,14 @@ public:
 
     void control(proto::internal::Control::Action action);
     void configure(const DesktopSession::Config& config);
+    void setViewerIdle(bool idle);
     void selectScreen(const proto::Screen& screen);
+    void setCaptureRegion(const proto::CaptureRegion& region);
     void captureScreen();
     void injectKeyEvent(const proto::KeyEvent& event);
     void injectMouseEvent(const proto::MouseEvent& event);
     void injectClipboardEvent(const proto::ClipboardEvent& event);
+    size_t takeMaxQueueDepth();
 
 private:
     friend class DesktopSessionManager;
@@ -19,7 +19,11 @@
 #include "host/host_key_storage.h"
 
 #include "base/crypto/generic_hash.h"
+#include "base/settings/json_settings.h"
 #include "base/strings/strcat.h"
+#include "base/threading/thread_pool.h"
+
+#include <mutex>
 
 namespace host {
 
@@ -32,32 +36,76 @@ std::string sessionKey(std::string_view session_name)
     return base::strCat({ "session/", base::toHex(session_hash) });
 }
 
+// Process-wide store behind HostKeyStorage. The settings file is parsed once when the store is
+// first used; after that queries are answered from the in-memory map, so ID requests during
+// reconnect storms never wait for disk. Writes update the map synchronously and rewrite the
+// file on a pool thread.
+class KeyStore
+{
+public:
+    static KeyStore* instance()
+    {
+        static KeyStore store;
+        return &store;
+    }
+
+    base::ByteArray get(const std::string& value_name)
+    {
+        std::scoped_lock lock(lock_);
+        return settings_.get<base::ByteArray>(value_name);
+    }
+
+    void set(const std::string& value_name, const base::ByteArray& key)
+    {
+        std::scoped_lock lock(lock_);
+        settings_.set<base::ByteArray>(value_name, key);
+
+        // Persist on a pool thread. The sequence keeps rewrites in posting order and the store
+        // lock is taken again inside the task, so the flushed map always contains this update.
+        base::ThreadPool::instance()->postSequencedTask(flush_sequence_, []()
+        {
+            KeyStore* store = instance();
+
+            std::scoped_lock lock(store->lock_);
+            store->settings_.flush();
+        });
+    }
+
+private:
+    KeyStore()
+        : settings_(base::JsonSettings::Scope::SYSTEM, "aspia", "host_key"),
+          flush_sequence_(base::ThreadPool::instance()->createSequence())
+    {
+        // Nothing
+    }
+
+    std::mutex lock_;
+    base::JsonSettings settings_;
+    std::shared_ptr<base::ThreadPool::Sequence> flush_sequence_;
+
+    DISALLOW_COPY_AND_ASSIGN(KeyStore);
+};
+
 } // namespace
 
-HostKeyStorage::HostKeyStorage()
-    : impl_(base::JsonSettings::Scope::SYSTEM, "aspia", "host_key")
-{
-    // Nothing
-}
+HostKeyStorage::HostKeyStorage() = default;
 
 HostKeyStorage::~HostKeyStorage() = default;
 
 base::ByteArray HostKeyStorage::key(std::string_view session_name) const
 {
     if (session_name.empty())
-        return impl_.get<base::ByteArray>("console");
+        return KeyStore::instance()->get("console");
 
-    return impl_.get<base::ByteArray>(sessionKey(session_name));
+    return KeyStore::instance()->get(sessionKey(session_name));
 }
 
 void HostKeyStorage::setKey(std::string_view session_name, const base::ByteArray& key)
 {
     if (session_name.empty())
-        impl_.set<base::ByteArray>("console", key);
+        KeyStore::instance()->set("console", key);
     else
-        impl_.set<base::ByteArray>(sessionKey(session_name), key);
-
-    impl_.flush();
+        KeyStore::instance()->set(sessionKey(session_name), key);
 }
 
 } // namespace host
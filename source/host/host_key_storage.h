@@ -20,10 +20,15 @@
 #define HOST__HOST_KEY_STORAGE_H
 
 #include "base/macros_magic.h"
-#include "base/settings/json_settings.h"
+#include "base/memory/byte_array.h"
+
+#include <string_view>
 
 namespace host {
 
+// Accessor for the host keys issued by the router. The keys are kept in a process-wide
+// in-memory store: the backing file is parsed once, queries are answered from memory and
+// writes are persisted on a pool thread, so ID requests never wait for disk.
 class HostKeyStorage
 {
 public:
@@ -34,8 +39,6 @@ public:
     void setKey(std::string_view session_name, const base::ByteArray& key);
 
 private:
-    base::JsonSettings impl_;
-
     DISALLOW_COPY_AND_ASSIGN(HostKeyStorage);
 };
 
@@ -27,10 +27,22 @@ namespace host {
 namespace {
 
 const uint32_t kUsbCodeDelete = 0x07004c;
-const uint32_t kUsbCodeLeftCtrl = 0x0700e0;
-const uint32_t kUsbCodeRightCtrl = 0x0700e4;
-const uint32_t kUsbCodeLeftAlt = 0x0700e2;
-const uint32_t kUsbCodeRightAlt = 0x0700e6;
+
+// Windows set-1 scancodes of the modifier keys (0xE0xx = extended).
+const int kScancodeLeftCtrl = 0x001d;
+const int kScancodeRightCtrl = 0xe01d;
+const int kScancodeLeftAlt = 0x0038;
+const int kScancodeRightAlt = 0xe038;
+
+// Index of |scancode| in the pressed-key state: the low byte selects the slot, extended
+// scancodes go to the second group of 256 slots.
+size_t keyStateIndex(int scancode)
+{
+    size_t index = static_cast<size_t>(scancode) & 0xFF;
+    if (scancode & 0xFF00)
+        index += 256;
+    return index;
+}
 
 void sendKeyboardScancode(WORD scancode, DWORD flags)
 {
@@ -79,13 +91,25 @@ InputInjectorWin::InputInjectorWin() = default;
 
 InputInjectorWin::~InputInjectorWin()
 {
-    for (const auto& key : pressed_keys_)
+    // Release any keys the remote side still holds, otherwise they stay stuck for the local
+    // user. Words with no pressed keys are skipped with a single compare.
+    for (size_t word = 0; word < kKeyStateWords; ++word)
     {
-        int scancode = common::KeycodeConverter::usbKeycodeToNativeKeycode(key);
-        if (scancode != common::KeycodeConverter::invalidNativeKeycode())
+        if (pressed_keys_[word].none())
+            continue;
+
+        for (size_t bit = 0; bit < base::BitSet<uint64_t>::size(); ++bit)
         {
-            sendKeyboardScancode(
-                static_cast<WORD>(scancode), KEYEVENTF_SCANCODE | KEYEVENTF_KEYUP);
+            if (!pressed_keys_[word].test(bit))
+                continue;
+
+            size_t index = word * base::BitSet<uint64_t>::size() + bit;
+
+            WORD scancode = static_cast<WORD>(index & 0xFF);
+            if (index >= 256)
+                scancode |= 0xE000;
+
+            sendKeyboardScancode(scancode, KEYEVENTF_SCANCODE | KEYEVENTF_KEYUP);
         }
     }
 }
@@ -104,9 +128,13 @@ void InputInjectorWin::setBlockInput(bool enable)
 
 void InputInjectorWin::injectKeyEvent(const proto::KeyEvent& event)
 {
+    int scancode = common::KeycodeConverter::usbKeycodeToNativeKeycode(event.usb_keycode());
+    if (scancode == common::KeycodeConverter::invalidNativeKeycode())
+        return;
+
     if (event.flags() & proto::KeyEvent::PRESSED)
     {
-        pressed_keys_.insert(event.usb_keycode());
+        setKeyPressed(scancode, true);
 
         if (event.usb_keycode() == kUsbCodeDelete && isCtrlAndAltPressed())
         {
@@ -116,13 +144,9 @@ void InputInjectorWin::injectKeyEvent(const proto::KeyEvent& event)
     }
     else
     {
-        pressed_keys_.erase(event.usb_keycode());
+        setKeyPressed(scancode, false);
     }
 
-    int scancode = common::KeycodeConverter::usbKeycodeToNativeKeycode(event.usb_keycode());
-    if (scancode == common::KeycodeConverter::invalidNativeKeycode())
-        return;
-
     switchToInputDesktop();
 
     bool prev_state = GetKeyState(VK_CAPITAL) != 0;
@@ -248,21 +272,24 @@ void InputInjectorWin::switchToInputDesktop()
     SetThreadExecutionState(ES_SYSTEM_REQUIRED);
 }
 
-bool InputInjectorWin::isCtrlAndAltPressed()
+bool InputInjectorWin::isCtrlAndAltPressed() const
 {
-    bool ctrl_pressed = false;
-    bool alt_pressed = false;
-
-    for (const auto& key : pressed_keys_)
-    {
-        if (key == kUsbCodeLeftCtrl || key == kUsbCodeRightCtrl)
-            ctrl_pressed = true;
+    return (isKeyPressed(kScancodeLeftCtrl) || isKeyPressed(kScancodeRightCtrl)) &&
+           (isKeyPressed(kScancodeLeftAlt) || isKeyPressed(kScancodeRightAlt));
+}
 
-        if (key == kUsbCodeLeftAlt || key == kUsbCodeRightAlt)
-            alt_pressed = true;
-    }
+bool InputInjectorWin::isKeyPressed(int scancode) const
+{
+    size_t index = keyStateIndex(scancode);
+    return pressed_keys_[index / base::BitSet<uint64_t>::size()].test(
+        index % base::BitSet<uint64_t>::size());
+}
 
-    return ctrl_pressed && alt_pressed;
+void InputInjectorWin::setKeyPressed(int scancode, bool pressed)
+{
+    size_t index = keyStateIndex(scancode);
+    pressed_keys_[index / base::BitSet<uint64_t>::size()].set(
+        index % base::BitSet<uint64_t>::size(), pressed);
 }
 
 } // namespace host
@@ -19,6 +19,7 @@
 #ifndef HOST__INPUT_INJECTOR_WIN_H
 #define HOST__INPUT_INJECTOR_WIN_H
 
+#include "base/bitset.h"
 #include "base/win/scoped_thread_desktop.h"
 #include "host/input_injector.h"
 
@@ -38,12 +39,20 @@ public:
 
 private:
     void switchToInputDesktop();
-    bool isCtrlAndAltPressed();
+    bool isCtrlAndAltPressed() const;
+    bool isKeyPressed(int scancode) const;
+    void setKeyPressed(int scancode, bool pressed);
 
     base::ScopedThreadDesktop desktop_;
 
     bool block_input_ = false;
-    std::set<uint32_t> pressed_keys_;
+
+    // Pressed-key state indexed by native scancode: 256 slots for plain scancodes followed by
+    // 256 for extended (0xE0-prefixed) ones, so Right Ctrl does not alias Left Ctrl. One
+    // machine word per 64 keys keeps per-event updates and the mass release on disconnect to
+    // a few bit operations.
+    static constexpr size_t kKeyStateWords = 8;
+    base::BitSet<uint64_t> pressed_keys_[kKeyStateWords];
 
     base::Point screen_offset_;
     base::Point last_mouse_pos_;
@@ -21,6 +21,7 @@
 #include "base/logging.h"
 #include "base/task_runner.h"
 #include "base/peer/client_authenticator.h"
+#include "base/peer/heartbeat.h"
 #include "base/strings/unicode.h"
 #include "host/host_key_storage.h"
 #include "proto/router_host.pb.h"
@@ -36,7 +37,8 @@ const std::chrono::seconds kReconnectTimeout{ 10 };
 RouterController::RouterController(std::shared_ptr<base::TaskRunner> task_runner)
     : task_runner_(task_runner),
       peer_manager_(std::make_unique<base::RelayPeerManager>(task_runner, this)),
-      reconnect_timer_(base::WaitableTimer::Type::SINGLE_SHOT, task_runner)
+      reconnect_timer_(base::WaitableTimer::Type::SINGLE_SHOT, task_runner),
+      heartbeat_timer_(base::WaitableTimer::Type::REPEATED, task_runner)
 {
     // TODO
 }
@@ -84,6 +86,8 @@ void RouterController::hostIdRequest(const std::string& session_name)
         host_id_request->set_key(base::toStdString(host_key));
     }
 
+    host_id_request->set_direct_port(direct_port_);
+
     // Send host ID request.
     LOG(LS_INFO) << "Send ID request to router";
     channel_->send(base::serialize(message));
@@ -127,6 +131,13 @@ void RouterController::onConnected()
             LOG(LS_INFO) << "Router connected";
             routerStateChanged(proto::internal::RouterState::CONNECTED);
 
+            // Start heartbeats towards the router. The echo time is reset: support of the
+            // router on the other end of this connection is not known yet.
+            channel_->setStreamListener(base::kHeartbeatStreamId, this);
+            last_heartbeat_echo_time_ = std::chrono::steady_clock::time_point();
+            heartbeat_timer_.start(base::kHeartbeatInterval, base::kHeartbeatSlack,
+                                   std::bind(&RouterController::onHeartbeatTimer, this));
+
             // Now the session will receive incoming messages.
             channel_->resume();
         }
@@ -147,6 +158,8 @@ void RouterController::onDisconnected(base::NetworkChannel::ErrorCode error_code
     LOG(LS_INFO) << "Connection to the router is lost ("
                  << base::NetworkChannel::errorToString(error_code) << ")";
 
+    heartbeat_timer_.stop();
+
     routerStateChanged(proto::internal::RouterState::FAILED);
     delayedConnectToRouter();
 }
@@ -209,6 +222,19 @@ void RouterController::onMessageWritten(size_t /* pending */)
     // Nothing
 }
 
+void RouterController::onStreamMessageReceived(uint8_t stream_id, const base::ByteArray& buffer)
+{
+    if (stream_id != base::kHeartbeatStreamId ||
+        buffer.size() != 1 || buffer[0] != base::kHeartbeatMarker)
+    {
+        LOG(LS_WARNING) << "Unexpected stream message from router (stream: "
+                        << static_cast<int>(stream_id) << ", size: " << buffer.size() << ")";
+        return;
+    }
+
+    last_heartbeat_echo_time_ = std::chrono::steady_clock::now();
+}
+
 void RouterController::onNewPeerConnected(std::unique_ptr<base::NetworkChannel> channel)
 {
     if (delegate_)
@@ -232,6 +258,29 @@ void RouterController::delayedConnectToRouter()
     reconnect_timer_.start(kReconnectTimeout, std::bind(&RouterController::connectToRouter, this));
 }
 
+void RouterController::onHeartbeatTimer()
+{
+    if (!channel_)
+        return;
+
+    // The router answered at least once, so it supports heartbeats; silence beyond the
+    // timeout means the connection is dead even if TCP has not noticed yet.
+    if (last_heartbeat_echo_time_ != std::chrono::steady_clock::time_point() &&
+        (std::chrono::steady_clock::now() - last_heartbeat_echo_time_) > base::kHeartbeatTimeout)
+    {
+        LOG(LS_WARNING) << "Heartbeat echoes of the router stopped; reconnecting";
+
+        heartbeat_timer_.stop();
+        channel_.reset();
+
+        routerStateChanged(proto::internal::RouterState::FAILED);
+        delayedConnectToRouter();
+        return;
+    }
+
+    channel_->send(base::kHeartbeatStreamId, base::ByteArray{ base::kHeartbeatMarker });
+}
+
 void RouterController::routerStateChanged(proto::internal::RouterState::State state)
 {
     if (!delegate_)
@@ -33,6 +33,7 @@ namespace host {
 
 class RouterController
     : public base::NetworkChannel::Listener,
+      public base::NetworkChannel::StreamListener,
       public base::RelayPeerManager::Delegate
 {
 public:
@@ -58,6 +59,11 @@ public:
 
     void start(const RouterInfo& router_info, Delegate* delegate);
 
+    // Sets the TCP port on which the host accepts direct connections. It is reported to the
+    // router, which can then offer clients a direct path next to the relay. Must be called
+    // before start().
+    void setDirectPort(uint16_t port) { direct_port_ = port; }
+
     void hostIdRequest(const std::string& session_name);
     void resetHostId(base::HostId host_id);
 
@@ -72,12 +78,17 @@ protected:
     void onMessageReceived(const base::ByteArray& buffer) override;
     void onMessageWritten(size_t pending) override;
 
+    // base::NetworkChannel::StreamListener implementation. Receives the heartbeat echoes of
+    // the router (see base/peer/heartbeat.h).
+    void onStreamMessageReceived(uint8_t stream_id, const base::ByteArray& buffer) override;
+
     // base::RelayPeerManager::Delegate implementation.
     void onNewPeerConnected(std::unique_ptr<base::NetworkChannel> channel) override;
 
 private:
     void connectToRouter();
     void delayedConnectToRouter();
+    void onHeartbeatTimer();
     void routerStateChanged(proto::internal::RouterState::State state);
 
     Delegate* delegate_ = nullptr;
@@ -88,6 +99,13 @@ private:
     std::unique_ptr<base::RelayPeerManager> peer_manager_;
     base::WaitableTimer reconnect_timer_;
     RouterInfo router_info_;
+    uint16_t direct_port_ = 0;
+
+    // Heartbeat state. The timer sends a marker frame every heartbeat interval; the echo time
+    // stays zero until the router answers the first one, so a router without heartbeat support
+    // is never timed out.
+    base::WaitableTimer heartbeat_timer_;
+    std::chrono::steady_clock::time_point last_heartbeat_echo_time_;
 
     std::queue<std::string> pending_id_requests_;
 
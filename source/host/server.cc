@@ -184,6 +184,7 @@ void Server::startAuthentication(std::unique_ptr<base::NetworkChannel> channel)
     channel->setReadBufferSize(kReadBufferSize);
     channel->setKeepAlive(true, kKeepAliveTime, kKeepAliveInterval);
     channel->setNoDelay(true);
+    channel->setSendQueueAutoTuning(true);
 
     if (authenticator_manager_)
         authenticator_manager_->addNewChannel(std::move(channel));
@@ -293,6 +294,7 @@ void Server::connectToRouter()
 
     // Connect to the router.
     router_controller_ = std::make_unique<RouterController>(task_runner_);
+    router_controller_->setDirectPort(settings_.tcpPort());
     router_controller_->start(router_info, this);
 }
 
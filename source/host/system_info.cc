@@ -18,16 +18,24 @@
 
 #include "host/system_info.h"
 
+#include "base/logging.h"
 #include "base/smbios_parser.h"
-#include "base/smbios_reader.h"
 #include "base/sys_info.h"
 #include "base/net/adapter_enumerator.h"
 #include "base/win/drive_enumerator.h"
 #include "base/win/printer_enumerator.h"
 
+#include <thread>
+
 namespace host {
 
-void createSystemInfo(proto::SystemInfo* system_info)
+namespace {
+
+// How long a collected category stays fresh. Inventory data changes rarely; within the TTL a
+// request is answered from the cache without touching the system.
+const std::chrono::seconds kCacheTtl{ 60 };
+
+void collectSystem(proto::SystemInfo* system_info)
 {
     proto::system_info::Computer* computer = system_info->mutable_computer();
     computer->set_name(base::SysInfo::computerName());
@@ -46,66 +54,63 @@ void createSystemInfo(proto::SystemInfo* system_info)
     processor->set_packages(base::SysInfo::processorPackages());
     processor->set_cores(base::SysInfo::processorCores());
     processor->set_threads(base::SysInfo::processorThreads());
+}
 
-    for (base::SmbiosTableEnumerator enumerator(base::readSmbiosDump());
-         !enumerator.isAtEnd(); enumerator.advance())
-    {
-        const base::SmbiosTable* table = enumerator.table();
-
-        switch (table->type)
-        {
-            case base::SMBIOS_TABLE_TYPE_BIOS:
-            {
-                base::SmbiosBios bios_table(table);
+void collectSmbios(proto::SystemInfo* system_info)
+{
+    // The index reads and parses the firmware dump only for the first request; repeated
+    // requests query the cached tables.
+    const base::SmbiosTableIndex& index = base::SmbiosTableIndex::local();
 
-                proto::system_info::Bios* bios = system_info->mutable_bios();
-                bios->set_vendor(bios_table.vendor());
-                bios->set_version(bios_table.version());
-                bios->set_date(bios_table.releaseDate());
-            }
-            break;
+    for (const base::SmbiosTable* table : index.tablesWithType(base::SMBIOS_TABLE_TYPE_BIOS))
+    {
+        base::SmbiosBios bios_table(table);
 
-            case base::SMBIOS_TABLE_TYPE_BASEBOARD:
-            {
-                base::SmbiosBaseboard baseboard_table(table);
-                if (!baseboard_table.isValid())
-                    continue;
+        proto::system_info::Bios* bios = system_info->mutable_bios();
+        bios->set_vendor(bios_table.vendor());
+        bios->set_version(bios_table.version());
+        bios->set_date(bios_table.releaseDate());
+    }
 
-                proto::system_info::Motherboard* motherboard = system_info->mutable_motherboard();
-                motherboard->set_manufacturer(baseboard_table.manufacturer());
-                motherboard->set_model(baseboard_table.product());
-            }
-            break;
+    for (const base::SmbiosTable* table :
+         index.tablesWithType(base::SMBIOS_TABLE_TYPE_BASEBOARD))
+    {
+        base::SmbiosBaseboard baseboard_table(table);
+        if (!baseboard_table.isValid())
+            continue;
 
-            case base::SMBIOS_TABLE_TYPE_MEMORY_DEVICE:
-            {
-                base::SmbiosMemoryDevice memory_device_table(table);
-                if (!memory_device_table.isValid())
-                    continue;
+        proto::system_info::Motherboard* motherboard = system_info->mutable_motherboard();
+        motherboard->set_manufacturer(baseboard_table.manufacturer());
+        motherboard->set_model(baseboard_table.product());
+    }
 
-                proto::system_info::Memory::Module* module =
-                    system_info->mutable_memory()->add_module();
+    for (const base::SmbiosTable* table :
+         index.tablesWithType(base::SMBIOS_TABLE_TYPE_MEMORY_DEVICE))
+    {
+        base::SmbiosMemoryDevice memory_device_table(table);
+        if (!memory_device_table.isValid())
+            continue;
 
-                module->set_present(memory_device_table.isPresent());
-                module->set_location(memory_device_table.location());
+        proto::system_info::Memory::Module* module =
+            system_info->mutable_memory()->add_module();
 
-                if (memory_device_table.isPresent())
-                {
-                    module->set_manufacturer(memory_device_table.manufacturer());
-                    module->set_size(memory_device_table.size());
-                    module->set_type(memory_device_table.type());
-                    module->set_form_factor(memory_device_table.formFactor());
-                    module->set_part_number(memory_device_table.partNumber());
-                    module->set_speed(memory_device_table.speed());
-                }
-            }
-            break;
+        module->set_present(memory_device_table.isPresent());
+        module->set_location(memory_device_table.location());
 
-            default:
-                break;
+        if (memory_device_table.isPresent())
+        {
+            module->set_manufacturer(memory_device_table.manufacturer());
+            module->set_size(memory_device_table.size());
+            module->set_type(memory_device_table.type());
+            module->set_form_factor(memory_device_table.formFactor());
+            module->set_part_number(memory_device_table.partNumber());
+            module->set_speed(memory_device_table.speed());
         }
     }
+}
 
+void collectDrives(proto::SystemInfo* system_info)
+{
     for (base::win::DriveEnumerator enumerator; !enumerator.isAtEnd(); enumerator.advance())
     {
         const base::win::DriveEnumerator::DriveInfo& drive_info = enumerator.driveInfo();
@@ -118,7 +123,10 @@ void createSystemInfo(proto::SystemInfo* system_info)
         drive->set_total_size(drive_info.totalSpace());
         drive->set_free_size(drive_info.freeSpace());
     }
+}
 
+void collectPrinters(proto::SystemInfo* system_info)
+{
     for (base::win::PrinterEnumerator enumerator; !enumerator.isAtEnd(); enumerator.advance())
     {
         proto::system_info::Printers::Printer* printer =
@@ -132,7 +140,10 @@ void createSystemInfo(proto::SystemInfo* system_info)
         printer->set_jobs_count(enumerator.jobsCount());
         printer->set_share_name(enumerator.shareName());
     }
+}
 
+void collectNetwork(proto::SystemInfo* system_info)
+{
     for (base::AdapterEnumerator enumerator; !enumerator.isAtEnd(); enumerator.advance())
     {
         proto::system_info::NetworkAdapters::Adapter* adapter =
@@ -175,4 +186,105 @@ void createSystemInfo(proto::SystemInfo* system_info)
     }
 }
 
+} // namespace
+
+// static
+SystemInfoCollector* SystemInfoCollector::instance()
+{
+    static SystemInfoCollector instance;
+    return &instance;
+}
+
+void SystemInfoCollector::collect(Callback callback)
+{
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < kCategoryCount; ++i)
+    {
+        Category category = static_cast<Category>(i);
+
+        proto::SystemInfo cached;
+        bool has_cached = false;
+
+        {
+            std::scoped_lock lock(lock_);
+            CacheEntry& entry = cache_[i];
+
+            // A cached category, even a stale one, is delivered right away so the requester
+            // shows something immediately; the fresh result replaces it when it arrives.
+            if (entry.valid)
+            {
+                cached = entry.data;
+                has_cached = true;
+            }
+
+            if (!entry.valid || now - entry.collect_time >= kCacheTtl)
+            {
+                entry.waiters.push_back(callback);
+
+                if (!entry.collecting)
+                {
+                    entry.collecting = true;
+
+                    std::thread([this, category]()
+                    {
+                        proto::SystemInfo system_info;
+                        collectCategory(category, &system_info);
+
+                        std::vector<Callback> waiters;
+
+                        {
+                            std::scoped_lock lock(lock_);
+                            CacheEntry& entry = cache_[category];
+
+                            entry.data = system_info;
+                            entry.collect_time = std::chrono::steady_clock::now();
+                            entry.valid = true;
+                            entry.collecting = false;
+                            entry.waiters.swap(waiters);
+                        }
+
+                        for (const auto& waiter : waiters)
+                            waiter(system_info);
+                    }).detach();
+                }
+            }
+        }
+
+        if (has_cached)
+            callback(cached);
+    }
+}
+
+// static
+void SystemInfoCollector::collectCategory(Category category, proto::SystemInfo* system_info)
+{
+    switch (category)
+    {
+        case CATEGORY_SYSTEM:
+            collectSystem(system_info);
+            break;
+
+        case CATEGORY_SMBIOS:
+            collectSmbios(system_info);
+            break;
+
+        case CATEGORY_DRIVES:
+            collectDrives(system_info);
+            break;
+
+        case CATEGORY_PRINTERS:
+            collectPrinters(system_info);
+            break;
+
+        case CATEGORY_NETWORK:
+            collectNetwork(system_info);
+            break;
+
+        default:
+            NOTREACHED();
+            break;
+    }
+}
+
 } // namespace host
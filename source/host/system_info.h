@@ -19,11 +19,69 @@
 #ifndef HOST__SYSTEM_INFO_H
 #define HOST__SYSTEM_INFO_H
 
+#include "base/macros_magic.h"
 #include "proto/desktop_extensions.pb.h"
 
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <vector>
+
 namespace host {
 
-void createSystemInfo(proto::SystemInfo* system_info);
+// Collects the hardware and system inventory category by category on worker threads. Slow
+// sources (SMBIOS, printers, network adapters) no longer block the session thread; every
+// category is delivered to the caller as soon as it is ready and results are cached with a TTL,
+// so a repeated request is answered from the cache instantly.
+class SystemInfoCollector
+{
+public:
+    // The collector is shared by all client sessions, so the inventory is gathered once per
+    // machine no matter how many clients ask for it.
+    static SystemInfoCollector* instance();
+
+    // Receives a partial proto::SystemInfo containing the fields of one category. Invoked once
+    // per category: directly from collect() for cached categories, from a worker thread when a
+    // fresh collection completes. The callback must therefore be safe to run on any thread.
+    using Callback = std::function<void(const proto::SystemInfo&)>;
+
+    // Delivers every category to |callback|. Cached categories are delivered immediately; stale
+    // or missing ones are collected on worker threads, one thread per category, and streamed to
+    // the callback as they complete.
+    void collect(Callback callback);
+
+private:
+    enum Category
+    {
+        CATEGORY_SYSTEM = 0, // Computer, operating system, processor.
+        CATEGORY_SMBIOS,     // BIOS, motherboard, memory modules.
+        CATEGORY_DRIVES,
+        CATEGORY_PRINTERS,
+        CATEGORY_NETWORK,
+        kCategoryCount
+    };
+
+    SystemInfoCollector() = default;
+    ~SystemInfoCollector() = default;
+
+    static void collectCategory(Category category, proto::SystemInfo* system_info);
+
+    struct CacheEntry
+    {
+        proto::SystemInfo data;
+        std::chrono::steady_clock::time_point collect_time;
+        bool valid = false;
+
+        // A collection for this category is running; its result is fanned out to |waiters|.
+        bool collecting = false;
+        std::vector<Callback> waiters;
+    };
+
+    std::mutex lock_;
+    CacheEntry cache_[kCategoryCount];
+
+    DISALLOW_COPY_AND_ASSIGN(SystemInfoCollector);
+};
 
 } // namespace host
 
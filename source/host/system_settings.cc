@@ -24,8 +24,28 @@
 #include "base/peer/user_list.h"
 #include "base/settings/xml_settings.h"
 
+#include <mutex>
+
 namespace host {
 
+// Typed view over one generation of the settings file. All values are converted from their
+// stored string form (and the user credentials decoded) once, when the generation is first
+// read; accessors then only copy the ready values out.
+struct SystemSettings::Data
+{
+    uint16_t tcp_port = DEFAULT_HOST_TCP_PORT;
+    bool router_enabled = false;
+    std::u16string router_address;
+    uint16_t router_port = DEFAULT_ROUTER_TCP_PORT;
+    base::ByteArray router_public_key;
+    std::u16string update_server;
+    bool trace_events_enabled = false;
+    bool low_memory_mode = false;
+
+    std::vector<base::User> users;
+    base::ByteArray seed_key;
+};
+
 namespace {
 
 // This should be removed in the next release.
@@ -90,10 +110,61 @@ void settingsMigration(base::JsonSettings* json_settings)
 
 } // namespace
 
+// static
+std::shared_ptr<const SystemSettings::Data> SystemSettings::typedData(
+    std::shared_ptr<const base::Settings::Map> map)
+{
+    static std::mutex lock;
+    static std::shared_ptr<const base::Settings::Map> source;
+    static std::shared_ptr<const SystemSettings::Data> data;
+
+    std::scoped_lock scoped_lock(lock);
+
+    // Snapshots are shared process-wide, so pointer identity means the same file generation.
+    if (map == source)
+        return data;
+
+    base::Settings settings(*map);
+    std::shared_ptr<SystemSettings::Data> new_data = std::make_shared<SystemSettings::Data>();
+
+    new_data->tcp_port = settings.get<uint16_t>("TcpPort", DEFAULT_HOST_TCP_PORT);
+    new_data->router_enabled = settings.get<bool>("RouterEnabled", false);
+    new_data->router_address = settings.get<std::u16string>("RouterAddress");
+    new_data->router_port = settings.get<uint16_t>("RouterPort", DEFAULT_ROUTER_TCP_PORT);
+    new_data->router_public_key = settings.get<base::ByteArray>("RouterPublicKey");
+    new_data->update_server = settings.get<std::u16string>("UpdateServer", DEFAULT_UPDATE_SERVER);
+    new_data->trace_events_enabled = settings.get<bool>("TraceEvents", false);
+    new_data->low_memory_mode = settings.get<bool>("LowMemoryMode", false);
+
+    for (const auto& item : settings.getArray("Users"))
+    {
+        base::User user;
+
+        user.name     = item.get<std::u16string>("Name");
+        user.group    = item.get<std::string>("Group");
+        user.salt     = item.get<base::ByteArray>("Salt");
+        user.verifier = item.get<base::ByteArray>("Verifier");
+        user.sessions = item.get<uint32_t>("Sessions");
+        user.flags    = item.get<uint32_t>("Flags");
+
+        new_data->users.emplace_back(std::move(user));
+    }
+
+    new_data->seed_key = settings.get<base::ByteArray>("SeedKey");
+    if (new_data->seed_key.empty())
+        new_data->seed_key = base::Random::byteArray(64);
+
+    source = std::move(map);
+    data = std::move(new_data);
+
+    return data;
+}
+
 SystemSettings::SystemSettings()
     : settings_(base::JsonSettings::Scope::SYSTEM, "aspia", "host")
 {
     settingsMigration(&settings_);
+    reloadData();
 }
 
 SystemSettings::~SystemSettings() = default;
@@ -111,62 +182,92 @@ bool SystemSettings::isWritable() const
 void SystemSettings::sync()
 {
     settings_.sync();
+    reloadData();
 }
 
 uint16_t SystemSettings::tcpPort() const
 {
+    if (data_)
+        return data_->tcp_port;
+
     return settings_.get<uint16_t>("TcpPort", DEFAULT_HOST_TCP_PORT);
 }
 
 void SystemSettings::setTcpPort(uint16_t port)
 {
     settings_.set<uint16_t>("TcpPort", port);
+    data_.reset();
 }
 
 bool SystemSettings::isRouterEnabled() const
 {
+    if (data_)
+        return data_->router_enabled;
+
     return settings_.get<bool>("RouterEnabled", false);
 }
 
 void SystemSettings::setRouterEnabled(bool enable)
 {
     settings_.set<bool>("RouterEnabled", enable);
+    data_.reset();
 }
 
 std::u16string SystemSettings::routerAddress() const
 {
+    if (data_)
+        return data_->router_address;
+
     return settings_.get<std::u16string>("RouterAddress");
 }
 
 void SystemSettings::setRouterAddress(const std::u16string& address)
 {
     settings_.set<std::u16string>("RouterAddress", address);
+    data_.reset();
 }
 
 uint16_t SystemSettings::routerPort() const
 {
+    if (data_)
+        return data_->router_port;
+
     return settings_.get<uint16_t>("RouterPort", DEFAULT_ROUTER_TCP_PORT);
 }
 
 void SystemSettings::setRouterPort(uint16_t port)
 {
     settings_.set<uint16_t>("RouterPort", port);
+    data_.reset();
 }
 
 base::ByteArray SystemSettings::routerPublicKey() const
 {
+    if (data_)
+        return data_->router_public_key;
+
     return settings_.get<base::ByteArray>("RouterPublicKey");
 }
 
 void SystemSettings::setRouterPublicKey(const base::ByteArray& key)
 {
     settings_.set<base::ByteArray>("RouterPublicKey", key);
+    data_.reset();
 }
 
 std::unique_ptr<base::UserList> SystemSettings::userList() const
 {
     std::unique_ptr<base::UserList> users = base::UserList::createEmpty();
 
+    if (data_)
+    {
+        for (const auto& user : data_->users)
+            users->add(user);
+
+        users->setSeedKey(data_->seed_key);
+        return users;
+    }
+
     for (const auto& item : settings_.getArray("Users"))
     {
         base::User user;
@@ -211,16 +312,62 @@ void SystemSettings::setUserList(const base::UserList& users)
 
     settings_.setArray("Users", users_array);
     settings_.set("SeedKey", users.seedKey());
+    data_.reset();
 }
 
 std::u16string SystemSettings::updateServer() const
 {
+    if (data_)
+        return data_->update_server;
+
     return settings_.get<std::u16string>("UpdateServer", DEFAULT_UPDATE_SERVER);
 }
 
 void SystemSettings::setUpdateServer(const std::u16string& server)
 {
     settings_.set("UpdateServer", server);
+    data_.reset();
+}
+
+bool SystemSettings::isTraceEventsEnabled() const
+{
+    if (data_)
+        return data_->trace_events_enabled;
+
+    return settings_.get<bool>("TraceEvents", false);
+}
+
+void SystemSettings::setTraceEventsEnabled(bool enable)
+{
+    settings_.set("TraceEvents", enable);
+    data_.reset();
+}
+
+bool SystemSettings::lowMemoryMode() const
+{
+    if (data_)
+        return data_->low_memory_mode;
+
+    return settings_.get<bool>("LowMemoryMode", false);
+}
+
+void SystemSettings::setLowMemoryMode(bool enable)
+{
+    settings_.set("LowMemoryMode", enable);
+    data_.reset();
+}
+
+void SystemSettings::reloadData()
+{
+    if (settings_.isChanged() || filePath().empty())
+    {
+        // Unsaved local modifications must win over the cached file generation, so accessors
+        // fall back to reading the local map until the changes are written out.
+        data_.reset();
+        return;
+    }
+
+    data_ = typedData(base::JsonSettings::snapshot(filePath()));
 }
 
 } // namespace host
@@ -61,9 +61,37 @@ public:
     std::u16string updateServer() const;
     void setUpdateServer(const std::u16string& server);
 
+    // When set, every host process records a timeline trace (capture ticks, IPC handoffs,
+    // socket writes) next to the logs. Read at process start; meant for diagnosing production
+    // installations without debug builds.
+    bool isTraceEventsEnabled() const;
+    void setTraceEventsEnabled(bool enable);
+
+    // When set, the desktop agent captures with a minimal memory footprint: a single recycled
+    // frame buffer and change detection on a downscaled shadow of the screen, trading some
+    // bandwidth for memory. Meant for thin terminals and other machines with little RAM.
+    bool lowMemoryMode() const;
+    void setLowMemoryMode(bool enable);
+
 private:
+    struct Data;
+
+    // Returns the typed view of the settings snapshot |map|, building it on the first request
+    // for a given file generation.
+    static std::shared_ptr<const Data> typedData(std::shared_ptr<const base::Settings::Map> map);
+
+    // Rebinds |data_| to the typed view of the current file snapshot, or drops it when the
+    // local map carries unsaved modifications.
+    void reloadData();
+
     base::JsonSettings settings_;
 
+    // Typed decrypt-once view of the settings file. Built once per file generation and shared
+    // between all instances reading the same generation; accessors serve values from it
+    // instead of converting the stored strings on every call. Null while there are local
+    // modifications that have not been written back yet.
+    std::shared_ptr<const Data> data_;
+
     DISALLOW_COPY_AND_ASSIGN(SystemSettings);
 };
 
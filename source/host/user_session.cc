@@ -20,7 +20,10 @@
 
 #include "base/location.h"
 #include "base/logging.h"
+#include "base/perf_meter.h"
 #include "base/task_runner.h"
+#include "base/codec/scale_reducer.h"
+#include "base/codec/video_encoder.h"
 #include "base/crypto/password_generator.h"
 #include "base/desktop/frame.h"
 #include "base/strings/string_number_conversions.h"
@@ -29,9 +32,34 @@
 #include "base/win/session_info.h"
 #include "host/client_session_desktop.h"
 #include "host/desktop_session_proxy.h"
+#include "host/system_settings.h"
+
+#include <algorithm>
 
 namespace host {
 
+namespace {
+
+// Share of one processor core the encode pipelines of a session may use, measured over the
+// governor window. Above the budget the frame rate of every pipeline is scaled down, so the
+// console user keeps the rest of the machine even when many operators are connected.
+const int kEncodeCpuBudgetPercent = 60;
+
+// Length of one governor measurement window.
+const uint64_t kGovernorWindowUs = 1000 * 1000; // 1 second.
+
+// The governor never slows the pipelines below this share of their configured frame rate;
+// every viewer keeps getting a usable picture.
+const int kMinGovernorFpsPercent = 20;
+
+// Step by which the frame rate recovers once the load stays clearly below the budget.
+const int kGovernorRecoveryPercent = 10;
+
+// Pipelines without a frame rate cap of their own are governed from this nominal rate.
+const int kGovernorNominalFps = 30;
+
+} // namespace
+
 UserSession::UserSession(std::shared_ptr<base::TaskRunner> task_runner,
                          base::SessionId session_id,
                          std::unique_ptr<base::IpcChannel> channel)
@@ -320,8 +348,290 @@ void UserSession::onDesktopSessionStopped()
 
 void UserSession::onScreenCaptured(const base::Frame* frame, const base::MouseCursor* cursor)
 {
+    if (!frame)
+    {
+        // Only the cursor has changed; there is nothing to encode.
+        for (const auto& client : desktop_clients_)
+        {
+            static_cast<ClientSessionDesktop*>(client.get())->sendEncodedScreen(
+                nullptr, cursor, ClientSessionDesktop::PipelinePass());
+        }
+        return;
+    }
+
+    // VP8 costs noticeably less CPU on full-motion content, while VP9 renders mostly static
+    // screens sharper at the same bitrate. The classifier watches the damage statistics of
+    // the captured frames and the pipelines deviate from the configured encoding when the
+    // content clearly calls for it. Receivers follow the encoding carried in every video
+    // packet, so the switch needs no renegotiation.
+    const base::VideoContentClassifier::ContentType content_type =
+        content_classifier_.classify(frame->constUpdatedRegion(), frame->size());
+
+    // Group the clients by video profile. Clients without a valid configuration receive only
+    // the cursor.
+    std::map<VideoPipelineKey, std::vector<ClientSessionDesktop*>> groups;
+
+    for (const auto& client : desktop_clients_)
+    {
+        ClientSessionDesktop* desktop_client = static_cast<ClientSessionDesktop*>(client.get());
+
+        if (desktop_client->videoEncoding() == proto::VIDEO_ENCODING_UNKNOWN)
+        {
+            desktop_client->sendEncodedScreen(
+                nullptr, cursor, ClientSessionDesktop::PipelinePass());
+            continue;
+        }
+
+        proto::VideoEncoding encoding = desktop_client->videoEncoding();
+
+        if (encoding == proto::VIDEO_ENCODING_VP8 || encoding == proto::VIDEO_ENCODING_VP9)
+        {
+            switch (content_type)
+            {
+                case base::VideoContentClassifier::ContentType::STATIC_UI:
+                    encoding = proto::VIDEO_ENCODING_VP9;
+                    break;
+
+                case base::VideoContentClassifier::ContentType::MOTION_VIDEO:
+                    encoding = proto::VIDEO_ENCODING_VP8;
+                    break;
+
+                default:
+                    // Not enough evidence yet; the configured encoding stands.
+                    break;
+            }
+        }
+
+        const base::Size video_size = desktop_client->videoSize(frame->size());
+
+        groups[VideoPipelineKey(
+            encoding,
+            video_size.width(),
+            video_size.height(),
+            static_cast<int>(desktop_client->videoProfile().max_fps()))]
+                .emplace_back(desktop_client);
+    }
+
+    // Drop pipelines whose profile no client uses anymore.
+    for (auto it = video_pipelines_.begin(); it != video_pipelines_.end();)
+    {
+        if (groups.find(it->first) == groups.end())
+            it = video_pipelines_.erase(it);
+        else
+            ++it;
+    }
+
+    uint64_t frame_busy_us = 0;
+
+    for (auto& [key, members] : groups)
+    {
+        VideoPipeline& pipeline = video_pipelines_[key];
+
+        // When the membership of the group has changed the encoder is recreated, so every
+        // member starts on a key frame with a full format description.
+        std::vector<ClientSession*> current_members(members.begin(), members.end());
+        if (!pipeline.encoder || pipeline.members != current_members)
+        {
+            pipeline.scale_reducer = std::make_unique<base::ScaleReducer>();
+            pipeline.encoder = base::VideoEncoder::create(
+                static_cast<proto::VideoEncoding>(std::get<0>(key)));
+            pipeline.members = std::move(current_members);
+
+            if (!pipeline.encoder)
+            {
+                LOG(LS_ERROR) << "Unable to create video encoder: " << std::get<0>(key);
+                continue;
+            }
+        }
+
+        // Apply pending recovery requests of the members. In a shared pipeline one client's
+        // recovery produces a key frame for the whole group; the other members simply decode
+        // it as a regular frame.
+        for (ClientSessionDesktop* member : members)
+        {
+            switch (member->takeVideoRecovery())
+            {
+                case proto::VideoRecovery::ACTION_KEY_FRAME:
+                    pipeline.encoder->requestKeyFrame();
+                    break;
+
+                case proto::VideoRecovery::ACTION_INVALIDATE_REFERENCES:
+                    pipeline.encoder->invalidateReferences();
+                    break;
+
+                default:
+                    break;
+            }
+        }
+
+        // Feed the encoder the delivery rate observed by the receivers. With several clients on
+        // one pipeline the slowest one sets the pace, just as it already does for the capture
+        // rate. Recorded every frame so the bitrate filter can average it over time.
+        int bandwidth_kbps = 0;
+        for (ClientSessionDesktop* member : members)
+        {
+            const int member_kbps = member->bandwidthEstimateKbps();
+            if (member_kbps > 0 && (bandwidth_kbps == 0 || member_kbps < bandwidth_kbps))
+                bandwidth_kbps = member_kbps;
+        }
+
+        if (bandwidth_kbps > 0)
+            pipeline.encoder->setBandwidthEstimateKbps(bandwidth_kbps);
+
+        // Apply the profile limits of the members: the lowest bitrate ceiling and the fastest
+        // requested encoding win. The encoder applies both to the live codec context.
+        int max_bitrate_kbps = 0;
+        int speed = 0;
+        for (ClientSessionDesktop* member : members)
+        {
+            const proto::VideoProfile& profile = member->videoProfile();
+
+            const int member_max = static_cast<int>(profile.max_bitrate_kbps());
+            if (member_max > 0 && (max_bitrate_kbps == 0 || member_max < max_bitrate_kbps))
+                max_bitrate_kbps = member_max;
+
+            speed = std::max(speed, profile.cpu_used());
+        }
+
+        pipeline.encoder->setMaxBitrateKbps(max_bitrate_kbps);
+        pipeline.encoder->setSpeed(speed);
+
+        // Frame rate cap of this pipeline. Skipped frames are not lost: their damage
+        // accumulates and the next encoded frame carries it.
+        int max_fps = std::get<3>(key);
+
+        // A reduced budget scales every cap by the same factor, so the relative rates of the
+        // profiles are preserved.
+        if (governor_fps_percent_ < 100)
+        {
+            const int base_fps = (max_fps > 0) ? max_fps : kGovernorNominalFps;
+            max_fps = std::max(1, base_fps * governor_fps_percent_ / 100);
+        }
+
+        if (max_fps > 0)
+        {
+            const uint64_t now_us = base::PerfMeter::nowUs();
+            const uint64_t min_interval_us = 1000000 / static_cast<uint64_t>(max_fps);
+
+            if (pipeline.last_encode_time_us != 0 &&
+                now_us - pipeline.last_encode_time_us < min_interval_us)
+            {
+                pipeline.pending_update_region.addRegion(frame->constUpdatedRegion());
+                continue;
+            }
+
+            pipeline.last_encode_time_us = now_us;
+        }
+
+        const base::Size video_size(std::get<1>(key), std::get<2>(key));
+
+        const uint64_t scale_begin_us = base::PerfMeter::nowUs();
+
+        // Damage accumulated while this pipeline was skipping frames is added for its scale and
+        // encode pass only, and the frame region is restored afterwards so the other pipelines
+        // do not rescan it.
+        base::Region saved_update_region;
+        const bool has_pending_region = !pipeline.pending_update_region.isEmpty();
+        if (has_pending_region)
+        {
+            base::Frame* mutable_frame = const_cast<base::Frame*>(frame);
+
+            saved_update_region = *mutable_frame->updatedRegion();
+            mutable_frame->updatedRegion()->addRegion(pipeline.pending_update_region);
+            pipeline.pending_update_region.clear();
+        }
+
+        const base::Frame* scaled_frame = pipeline.scale_reducer->scaleFrame(frame, video_size);
+        if (!scaled_frame)
+        {
+            LOG(LS_ERROR) << "No scaled frame";
+            continue;
+        }
+
+        const uint64_t encode_begin_us = base::PerfMeter::nowUs();
+
+        // Encode the frame into a video packet once for the whole group.
+        proto::VideoPacket packet;
+        pipeline.encoder->encode(scaled_frame, &packet);
+
+        const uint64_t encode_end_us = base::PerfMeter::nowUs();
+
+        if (has_pending_region)
+            *const_cast<base::Frame*>(frame)->updatedRegion() = saved_update_region;
+
+        if (packet.has_format())
+        {
+            proto::Size* screen_size = packet.mutable_format()->mutable_screen_size();
+            screen_size->set_width(frame->size().width());
+            screen_size->set_height(frame->size().height());
+
+            LOG(LS_INFO) << "Video packet has format";
+            LOG(LS_INFO) << "Screen size: " << screen_size->width() << "x" << screen_size->height();
+            LOG(LS_INFO) << "Video size: " << packet.format().video_rect().width() << "x"
+                         << packet.format().video_rect().height();
+        }
+
+        ClientSessionDesktop::PipelinePass pass;
+        pass.capture_time_us = frame->captureTimeUs();
+        pass.scale_time_us = encode_begin_us - scale_begin_us;
+        pass.encode_time_us = encode_end_us - encode_begin_us;
+        pass.scale_x = pipeline.scale_reducer->scaleFactorX();
+        pass.scale_y = pipeline.scale_reducer->scaleFactorY();
+
+        frame_busy_us += pass.scale_time_us + pass.encode_time_us;
+
+        for (ClientSessionDesktop* member : members)
+            member->sendEncodedScreen(&packet, cursor, pass);
+    }
+
+    // Thumbnail stills are produced from the frame of this capture pass; clients that enabled
+    // the extension get one at their configured interval with no additional capture.
     for (const auto& client : desktop_clients_)
-        static_cast<ClientSessionDesktop*>(client.get())->encodeScreen(frame, cursor);
+        static_cast<ClientSessionDesktop*>(client.get())->encodeThumbnail(frame);
+
+    updateEncodeGovernor(frame_busy_us);
+}
+
+void UserSession::updateEncodeGovernor(uint64_t busy_us)
+{
+    const uint64_t now_us = base::PerfMeter::nowUs();
+
+    if (governor_window_start_us_ == 0)
+        governor_window_start_us_ = now_us;
+
+    governor_busy_us_ += busy_us;
+
+    const uint64_t elapsed_us = now_us - governor_window_start_us_;
+    if (elapsed_us < kGovernorWindowUs)
+        return;
+
+    const int busy_percent = static_cast<int>(governor_busy_us_ * 100 / elapsed_us);
+
+    if (busy_percent > kEncodeCpuBudgetPercent)
+    {
+        // Scale the frame rate down in proportion to the overload.
+        governor_fps_percent_ = std::max(
+            kMinGovernorFpsPercent,
+            governor_fps_percent_ * kEncodeCpuBudgetPercent / busy_percent);
+
+        LOG(LS_INFO) << "Encode budget exceeded (" << busy_percent
+                     << "% busy); pipelines slowed to " << governor_fps_percent_
+                     << "% of their frame rate";
+    }
+    else if (governor_fps_percent_ < 100 &&
+             busy_percent < kEncodeCpuBudgetPercent * 3 / 4)
+    {
+        // The skipped frames freed enough time; recover in steps, so the rate does not
+        // oscillate around the budget.
+        governor_fps_percent_ =
+            std::min(100, governor_fps_percent_ + kGovernorRecoveryPercent);
+
+        if (governor_fps_percent_ == 100)
+            LOG(LS_INFO) << "Encode budget restored; pipelines run at full frame rate";
+    }
+
+    governor_window_start_us_ = now_us;
+    governor_busy_us_ = 0;
 }
 
 void UserSession::onAudioCaptured(const proto::AudioPacket& audio_packet)
@@ -330,6 +640,20 @@ void UserSession::onAudioCaptured(const proto::AudioPacket& audio_packet)
         static_cast<ClientSessionDesktop*>(client.get())->encodeAudio(audio_packet);
 }
 
+size_t UserSession::pendingMessages() const
+{
+    // The slowest client determines the capture rate for the whole session.
+    size_t pending_messages = 0;
+
+    for (const auto& client : desktop_clients_)
+    {
+        pending_messages = std::max(
+            pending_messages, static_cast<ClientSessionDesktop*>(client.get())->pendingMessages());
+    }
+
+    return pending_messages;
+}
+
 void UserSession::onScreenListChanged(const proto::ScreenList& list)
 {
     for (const auto& client : desktop_clients_)
@@ -378,10 +702,33 @@ void UserSession::onClientSessionConfigured()
             system_config.lock_at_disconnect || client_config.lock_at_disconnect;
     }
 
+    // Host-wide setting, not negotiable by clients: the administrator decides whether the
+    // desktop agent trades bandwidth for a smaller footprint on this machine.
+    system_config.low_memory_mode = SystemSettings().lowMemoryMode();
+
     desktop_session_proxy_->configure(system_config);
+
+    // A newly configured client starts with a visible viewer window, so an idle downshift
+    // from before it joined no longer applies.
+    desktop_session_proxy_->setViewerIdle(!hasVisibleViewer());
+
     desktop_session_proxy_->captureScreen();
 }
 
+void UserSession::onClientSessionViewerStateChanged()
+{
+    if (desktop_clients_.empty())
+        return;
+
+    bool viewer_visible = hasVisibleViewer();
+    desktop_session_proxy_->setViewerIdle(!viewer_visible);
+
+    // Refresh a restored viewer from the last captured frame immediately; the capture loop
+    // itself returns to the full rate with the next scheduled capture.
+    if (viewer_visible)
+        desktop_session_proxy_->captureScreen();
+}
+
 void UserSession::onClientSessionFinished()
 {
     auto delete_finished = [this](ClientSessionList* list)
@@ -412,7 +759,14 @@ void UserSession::onClientSessionFinished()
     delete_finished(&file_transfer_clients_);
 
     if (desktop_clients_.empty())
+    {
         desktop_session_proxy_->control(proto::internal::Control::DISABLE);
+    }
+    else
+    {
+        // The departed client may have been the only one with a visible viewer window.
+        onClientSessionViewerStateChanged();
+    }
 }
 
 void UserSession::onSessionDettached(const base::Location& location)
@@ -546,4 +900,17 @@ void UserSession::sendRouterState()
     channel_->send(base::serialize(outgoing_message_));
 }
 
+bool UserSession::hasVisibleViewer() const
+{
+    // One visible viewer window keeps the full capture rate for everyone; the downshift to
+    // thumbnail captures happens only when the whole audience is in the background.
+    for (const auto& client : desktop_clients_)
+    {
+        if (static_cast<ClientSessionDesktop*>(client.get())->isViewerVisible())
+            return true;
+    }
+
+    return false;
+}
+
 } // namespace host
@@ -21,6 +21,8 @@
 
 #include "base/session_id.h"
 #include "base/waitable_timer.h"
+#include "base/codec/video_content_classifier.h"
+#include "base/desktop/region.h"
 #include "base/ipc/ipc_channel.h"
 #include "base/peer/host_id.h"
 #include "base/peer/user_list.h"
@@ -29,6 +31,14 @@
 #include "host/desktop_session_manager.h"
 #include "proto/host_internal.pb.h"
 
+#include <map>
+#include <tuple>
+
+namespace base {
+class ScaleReducer;
+class VideoEncoder;
+} // namespace base
+
 namespace host {
 
 class UserSession
@@ -92,9 +102,11 @@ protected:
     void onAudioCaptured(const proto::AudioPacket& audio_packet) override;
     void onScreenListChanged(const proto::ScreenList& list) override;
     void onClipboardEvent(const proto::ClipboardEvent& event) override;
+    size_t pendingMessages() const override;
 
     // ClientSession::Delegate implementation.
     void onClientSessionConfigured() override;
+    void onClientSessionViewerStateChanged() override;
     void onClientSessionFinished() override;
 
 private:
@@ -105,6 +117,8 @@ private:
     void sendCredentials();
     void killClientSession(uint32_t id);
     void sendRouterState();
+    bool hasVisibleViewer() const;
+    void updateEncodeGovernor(uint64_t busy_us);
 
     std::shared_ptr<base::TaskRunner> task_runner_;
     std::unique_ptr<base::IpcChannel> channel_;
@@ -124,6 +138,42 @@ private:
     ClientSessionList desktop_clients_;
     ClientSessionList file_transfer_clients_;
 
+    // Shared video pipeline. Clients with the same encoding and output size share one scaler
+    // and one encoder; the captured frame is scaled and encoded once per distinct profile and
+    // the encoded packet is fanned out to all members.
+    struct VideoPipeline
+    {
+        std::unique_ptr<base::ScaleReducer> scale_reducer;
+        std::unique_ptr<base::VideoEncoder> encoder;
+
+        // Members of the previous pass. When the membership changes the encoder is recreated,
+        // so a newly joined client starts on a key frame.
+        std::vector<ClientSession*> members;
+
+        // Frame rate cap support. Frames arriving before the cap interval has elapsed are
+        // skipped and their damage accumulates here, so the next encoded frame carries all of
+        // the missed updates.
+        base::Region pending_update_region;
+        uint64_t last_encode_time_us = 0;
+    };
+
+    // Keyed by (video encoding, output width, output height, frame rate cap). Members with
+    // different caps need different encode cadences, so they cannot share an encoder.
+    using VideoPipelineKey = std::tuple<int, int, int, int>;
+    std::map<VideoPipelineKey, VideoPipeline> video_pipelines_;
+
+    // Classifies the captured content from the damage statistics of the frames, so that the
+    // pipelines can run the cheapest encoding that suits the content.
+    base::VideoContentClassifier content_classifier_;
+
+    // Encode budget governor. All pipelines encode serially on the session thread, so the busy
+    // share of that thread is the CPU cost of the session pile-up. When it exceeds the budget
+    // the frame rate of every pipeline is scaled down proportionally, keeping the host
+    // responsive for the console user; the relative rates of the profiles are preserved.
+    uint64_t governor_window_start_us_ = 0;
+    uint64_t governor_busy_us_ = 0;
+    int governor_fps_percent_ = 100;
+
     std::unique_ptr<DesktopSessionManager> desktop_session_;
     std::shared_ptr<DesktopSessionProxy> desktop_session_proxy_;
 
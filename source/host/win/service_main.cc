@@ -19,7 +19,10 @@
 #include "host/win/service_main.h"
 
 #include "base/logging.h"
+#include "base/process_handle.h"
+#include "base/trace_log.h"
 #include "base/files/base_paths.h"
+#include "host/system_settings.h"
 #include "host/win/service.h"
 
 namespace host {
@@ -46,12 +49,36 @@ void shutdownLogging()
     base::shutdownLogging();
 }
 
+// Starts timeline trace recording next to the logs when enabled in the system settings.
+void initTracing()
+{
+    if (!SystemSettings().isTraceEventsEnabled())
+        return;
+
+    std::filesystem::path path;
+
+    if (!base::BasePaths::commonAppData(&path))
+        return;
+    path.append("Aspia/Logs");
+    path.append("trace_host_service_" +
+        std::to_string(base::currentProcessId()) + ".json");
+
+    base::TraceLog::instance().start(path);
+}
+
+void shutdownTracing()
+{
+    base::TraceLog::instance().stop();
+}
+
 } // namespace
 
 void hostServiceMain()
 {
     initLogging();
+    initTracing();
     Service().exec();
+    shutdownTracing();
     shutdownLogging();
 }
 
@@ -23,6 +23,7 @@
 #include <QCoreApplication>
 #include <QDir>
 #include <QLocale>
+#include <QResource>
 #include <QTranslator>
 
 namespace qt_base {
@@ -35,31 +36,7 @@ const QString kTranslationsDir = QLatin1String(":/tr/");
 
 LocaleLoader::LocaleLoader()
 {
-    const QStringList qm_file_list =
-        QDir(kTranslationsDir).entryList(QStringList(QLatin1String("*.qm")), QDir::Files);
-
-    for (const auto& qm_file : qm_file_list)
-    {
-        QString locale_name = qm_file.chopped(3); // Remove file extension (*.qm).
-
-        if (locale_name.right(2).isUpper())
-        {
-            // xx_XX (language / country).
-            locale_name = locale_name.right(5);
-        }
-        else
-        {
-            // xx (language only).
-            locale_name = locale_name.right(2);
-        }
-
-        LOG(LS_INFO) << "Translation file added: " << qm_file << " (" << locale_name << ")";
-
-        if (locale_list_.contains(locale_name))
-            locale_list_[locale_name].push_back(qm_file);
-        else
-            locale_list_.insert(locale_name, QStringList(qm_file));
-    }
+    // The translation files are enumerated on first use; nothing is parsed at startup.
 }
 
 LocaleLoader::~LocaleLoader()
@@ -69,6 +46,8 @@ LocaleLoader::~LocaleLoader()
 
 LocaleLoader::LocaleList LocaleLoader::localeList() const
 {
+    ensureFileListLoaded();
+
     LocaleList list;
 
     auto add_locale = [&](const QString& locale_code)
@@ -104,16 +83,29 @@ LocaleLoader::LocaleList LocaleLoader::localeList() const
 
 bool LocaleLoader::contains(const QString& locale) const
 {
+    ensureFileListLoaded();
     return locale_list_.contains(locale);
 }
 
 void LocaleLoader::installTranslators(const QString& locale)
 {
+    ensureFileListLoaded();
     removeTranslators();
 
     LOG(LS_INFO) << "Install translators for: " << locale;
 
     auto file_list = locale_list_.constFind(locale);
+
+    // Fall back from a regional locale to its plain language (xx_XX to xx). English is
+    // built-in; for it and for unknown locales no translators are installed.
+    if (file_list == locale_list_.constEnd() && locale.length() > 2)
+    {
+        const QString language = locale.left(2);
+
+        LOG(LS_INFO) << "No translation for " << locale << "; falling back to " << language;
+        file_list = locale_list_.constFind(language);
+    }
+
     if (file_list == locale_list_.constEnd())
         return;
 
@@ -121,7 +113,22 @@ void LocaleLoader::installTranslators(const QString& locale)
     {
         QScopedPointer<QTranslator> translator(new QTranslator());
 
-        if (translator->load(file, kTranslationsDir))
+        // Uncompressed resource data is used in place: it is already part of the binary
+        // image, so the translator does not copy or parse-and-repack it. A compressed
+        // resource has to go through the regular file loader.
+        QResource resource(kTranslationsDir + file);
+
+        bool loaded;
+        if (resource.isValid() && !resource.isCompressed())
+        {
+            loaded = translator->load(resource.data(), static_cast<int>(resource.size()));
+        }
+        else
+        {
+            loaded = translator->load(file, kTranslationsDir);
+        }
+
+        if (loaded)
         {
             if (QCoreApplication::installTranslator(translator.get()))
                 translator_list_.push_back(translator.take());
@@ -129,10 +136,43 @@ void LocaleLoader::installTranslators(const QString& locale)
     }
 }
 
-void LocaleLoader::removeTranslators()
+void LocaleLoader::ensureFileListLoaded() const
 {
-    LOG(LS_INFO) << "Cleanup translators";
+    if (file_list_loaded_)
+        return;
+
+    file_list_loaded_ = true;
+
+    const QStringList qm_file_list =
+        QDir(kTranslationsDir).entryList(QStringList(QLatin1String("*.qm")), QDir::Files);
+
+    for (const auto& qm_file : qm_file_list)
+    {
+        QString locale_name = qm_file.chopped(3); // Remove file extension (*.qm).
+
+        if (locale_name.right(2).isUpper())
+        {
+            // xx_XX (language / country).
+            locale_name = locale_name.right(5);
+        }
+        else
+        {
+            // xx (language only).
+            locale_name = locale_name.right(2);
+        }
 
+        if (locale_list_.contains(locale_name))
+            locale_list_[locale_name].push_back(qm_file);
+        else
+            locale_list_.insert(locale_name, QStringList(qm_file));
+    }
+
+    LOG(LS_INFO) << "Translation files found: " << qm_file_list.size()
+                 << " (" << locale_list_.size() << " locales)";
+}
+
+void LocaleLoader::removeTranslators()
+{
     for (const auto& translator : translator_list_)
     {
         QCoreApplication::removeTranslator(translator);
@@ -43,9 +43,14 @@ public:
     void installTranslators(const QString& locale);
 
 private:
+    void ensureFileListLoaded() const;
     void removeTranslators();
 
-    QHash<QString, QStringList> locale_list_;
+    // Map from locale code to its translation files, built on first use. Most binaries never
+    // ask for it: the startup path installs only the configured locale.
+    mutable QHash<QString, QStringList> locale_list_;
+    mutable bool file_list_loaded_ = false;
+
     QVector<QTranslator*> translator_list_;
 
     DISALLOW_COPY_AND_ASSIGN(LocaleLoader);
@@ -0,0 +1,107 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "relay/buffer_pool.h"
+
+#include "base/logging.h"
+
+namespace relay {
+
+namespace {
+
+// Upper bound of cached free buffers per class, chosen so each class caches about the same
+// number of bytes (4 MB small and medium, 8 MB large). Buffers released beyond the limit are
+// freed.
+const size_t kMaxFreeBuffers[] = { 1024, 64, 16 };
+
+const size_t kClassSizes[] =
+{
+    BufferPool::kSmallBufferSize,
+    BufferPool::kMediumBufferSize,
+    BufferPool::kLargeBufferSize
+};
+
+} // namespace
+
+// static
+BufferPool* BufferPool::instance()
+{
+    static BufferPool buffer_pool;
+    return &buffer_pool;
+}
+
+// static
+size_t BufferPool::classSize(size_t size)
+{
+    return kClassSizes[classIndex(size)];
+}
+
+std::unique_ptr<uint8_t[]> BufferPool::lease(size_t size)
+{
+    const int index = classIndex(size);
+
+    {
+        std::scoped_lock lock(lock_);
+
+        std::vector<std::unique_ptr<uint8_t[]>>& free_list = free_lists_[index];
+        if (!free_list.empty())
+        {
+            std::unique_ptr<uint8_t[]> buffer = std::move(free_list.back());
+            free_list.pop_back();
+            return buffer;
+        }
+    }
+
+    return std::make_unique<uint8_t[]>(kClassSizes[index]);
+}
+
+void BufferPool::release(std::unique_ptr<uint8_t[]> buffer, size_t size)
+{
+    DCHECK(buffer);
+
+    const int index = classIndex(size);
+
+    std::scoped_lock lock(lock_);
+
+    std::vector<std::unique_ptr<uint8_t[]>>& free_list = free_lists_[index];
+    if (free_list.size() < kMaxFreeBuffers[index])
+        free_list.emplace_back(std::move(buffer));
+
+    // Otherwise the buffer is freed; the class has enough cached already.
+}
+
+// static
+int BufferPool::classIndex(size_t size)
+{
+    if (size <= kSmallBufferSize)
+        return 0;
+
+    if (size <= kMediumBufferSize)
+        return 1;
+
+    return 2;
+}
+
+BufferPool::BufferPool()
+{
+    // Nothing
+}
+
+BufferPool::~BufferPool() = default;
+
+} // namespace relay
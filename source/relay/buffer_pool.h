@@ -0,0 +1,76 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef RELAY__BUFFER_POOL_H
+#define RELAY__BUFFER_POOL_H
+
+#include "base/macros_magic.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace relay {
+
+// Relay-wide pool of receive buffers, shared by the sessions of all session threads. Buffers
+// come in three size classes; a session leases one scaled to its measured rate, so the few busy
+// sessions get large buffers while the many trickle sessions share the small class. Released
+// buffers are kept for reuse up to a per-class limit and handed out warm instead of being
+// reallocated per session.
+class BufferPool
+{
+public:
+    // The size classes. A trickle session (remote console, keystrokes) fits into the small
+    // class; the medium class matches a typical screen-update burst; the large class serves
+    // file transfers and other bulk streams.
+    static const size_t kSmallBufferSize = 4 * 1024;
+    static const size_t kMediumBufferSize = 64 * 1024;
+    static const size_t kLargeBufferSize = 512 * 1024;
+
+    static BufferPool* instance();
+
+    // Size of the smallest class that holds |size| bytes; anything above the medium class is
+    // served by the large one.
+    static size_t classSize(size_t size);
+
+    // Leases a buffer of the class of |size| bytes, reusing a released one when available. The
+    // returned buffer is classSize(|size|) bytes long.
+    std::unique_ptr<uint8_t[]> lease(size_t size);
+
+    // Returns a buffer obtained from lease() to the pool. |size| is the value lease() was
+    // called with.
+    void release(std::unique_ptr<uint8_t[]> buffer, size_t size);
+
+private:
+    BufferPool();
+    ~BufferPool();
+
+    static const int kNumberOfClasses = 3;
+
+    static int classIndex(size_t size);
+
+    std::mutex lock_;
+    std::vector<std::unique_ptr<uint8_t[]>> free_lists_[kNumberOfClasses];
+
+    DISALLOW_COPY_AND_ASSIGN(BufferPool);
+};
+
+} // namespace relay
+
+#endif // RELAY__BUFFER_POOL_H
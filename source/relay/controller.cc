@@ -20,15 +20,27 @@
 
 #include "base/logging.h"
 #include "base/task_runner.h"
+#include "base/crypto/random.h"
 #include "base/peer/client_authenticator.h"
 #include "proto/router_common.pb.h"
 #include "relay/settings.h"
 
+#include <algorithm>
+
 namespace relay {
 
 namespace {
 
-const std::chrono::seconds kReconnectTimeout{ 15 };
+// Reconnect backoff. The delay starts at the minimum, doubles with every failed attempt up to
+// the maximum, and half of it is replaced with random jitter, so relays that lost the router
+// together do not storm it with simultaneous handshakes when it comes back.
+const std::chrono::milliseconds kMinReconnectTimeout{ 5000 };
+const std::chrono::milliseconds kMaxReconnectTimeout{ 120000 };
+
+// Smallest block of keys sent to the router when topping up its pool. Small deficits are
+// held back until the pool is half-drained, so a steady trickle of finished sessions does
+// not turn into one message (and one key generation) per session.
+const uint32_t kKeyRefillBlockSize = 16;
 
 #if defined(OS_WIN)
 const wchar_t kFirewallRuleName[] = L"Aspia Relay Service";
@@ -85,6 +97,11 @@ Controller::Controller(std::shared_ptr<base::TaskRunner> task_runner)
     LOG(LS_INFO) << "Peer address: " << peer_address_;
     LOG(LS_INFO) << "Peer port: " << peer_port_;
     LOG(LS_INFO) << "Max peer count: " << max_peer_count_;
+
+    // Traffic accounting settings.
+    database_path_ = settings.databasePath();
+
+    LOG(LS_INFO) << "Database path: " << database_path_.u8string();
 }
 
 Controller::~Controller() = default;
@@ -123,13 +140,39 @@ bool Controller::start()
         return false;
     }
 
-    sessions_worker_ = std::make_unique<SessionsWorker>(peer_port_, shared_pool_->share());
+    sessions_worker_ = std::make_unique<SessionsWorker>(
+        peer_port_, database_path_, shared_pool_->share());
     sessions_worker_->start(task_runner_, this);
 
     connectToRouter();
     return true;
 }
 
+void Controller::drain()
+{
+    if (draining_)
+        return;
+
+    draining_ = true;
+
+    LOG(LS_INFO) << "Drain requested (active sessions: " << active_session_count_ << ")";
+
+    if (channel_)
+    {
+        // Tell the router to stop using this relay for new sessions. Sessions already running
+        // through the relay are unaffected.
+        proto::RelayToRouter message;
+        message.mutable_relay_drain()->set_drain(true);
+        channel_->send(base::serialize(message));
+    }
+
+    if (active_session_count_ == 0)
+    {
+        LOG(LS_INFO) << "No active sessions; drain complete";
+        task_runner_->postQuit();
+    }
+}
+
 void Controller::onConnected()
 {
     LOG(LS_INFO) << "Connection to the router is established";
@@ -146,6 +189,11 @@ void Controller::onConnected()
     authenticator_->setPeerPublicKey(router_public_key_);
     authenticator_->setSessionType(proto::ROUTER_SESSION_RELAY);
 
+    // Offer the resumption ticket from the previous connection. If the router accepts it the
+    // SRP handshake is skipped; a restarted router silently falls back to the full handshake.
+    if (!router_ticket_.empty())
+        authenticator_->setTicket(router_ticket_, router_ticket_secret_);
+
     authenticator_->start(std::move(channel_),
                           [this](base::ClientAuthenticator::ErrorCode error_code)
     {
@@ -158,10 +206,16 @@ void Controller::onConnected()
 
             LOG(LS_INFO) << "Authentication complete";
 
+            // Save the ticket for the next reconnect and restart the backoff.
+            router_ticket_ = authenticator_->ticket();
+            router_ticket_secret_ = authenticator_->ticketSecret();
+            reconnect_attempts_ = 0;
+
             // Now the session will receive incoming messages.
             channel_->resume();
 
-            sendKeyPool(max_peer_count_);
+            refillKeyPool();
+            sendRelayLoad();
         }
         else
         {
@@ -182,6 +236,12 @@ void Controller::onDisconnected(base::NetworkChannel::ErrorCode error_code)
 
     // Clearing the key pool.
     shared_pool_->clear();
+    router_key_count_ = 0;
+
+    // A draining relay does not come back; the router forgot its keys when the session
+    // closed.
+    if (draining_)
+        return;
 
     // Retrying a connection at a time interval.
     delayedConnectToRouter();
@@ -205,6 +265,13 @@ void Controller::onMessageReceived(const base::ByteArray& buffer)
         // If it is not used during this time, then it will be removed from the pool.
         task_runner_->postDelayedTask(
             std::bind(&KeyDeleter::deleteKey, key_deleter), std::chrono::seconds(30));
+
+        if (router_key_count_ > 0)
+            --router_key_count_;
+
+        // Replace the key right away instead of waiting for the session to finish, so a burst
+        // of brokered connections never finds the router's pool empty.
+        refillKeyPool();
     }
     else
     {
@@ -217,18 +284,37 @@ void Controller::onMessageWritten(size_t /* pending */)
     // Nothing
 }
 
+void Controller::onSessionStarted()
+{
+    ++active_session_count_;
+    sendRelayLoad();
+}
+
 void Controller::onSessionFinished()
 {
-    // After disconnecting the peer, one key is released.
-    // Add a new key to the pool and send it to the router.
-    sendKeyPool(1);
+    if (active_session_count_ > 0)
+        --active_session_count_;
+
+    if (draining_)
+    {
+        if (active_session_count_ == 0)
+        {
+            LOG(LS_INFO) << "Last session finished; drain complete";
+            task_runner_->postQuit();
+        }
+        return;
+    }
+
+    // After disconnecting the peer, capacity for one more key is released.
+    refillKeyPool();
+    sendRelayLoad();
 }
 
 void Controller::onPoolKeyExpired(uint32_t /* key_id */)
 {
-    // The key has expired and has been removed from the pool.
-    // Add a new key to the pool and send it to the router.
-    sendKeyPool(1);
+    // The key has expired and has been removed from the pool. The router's copy was already
+    // replaced when the key was reported as used; top up in case capacity has freed since.
+    refillKeyPool();
 }
 
 void Controller::connectToRouter()
@@ -245,12 +331,51 @@ void Controller::connectToRouter()
 
 void Controller::delayedConnectToRouter()
 {
-    LOG(LS_INFO) << "Reconnect after " << kReconnectTimeout.count() << " seconds";
-    reconnect_timer_.start(kReconnectTimeout, std::bind(&Controller::connectToRouter, this));
+    std::chrono::milliseconds delay = kMinReconnectTimeout;
+
+    for (int i = 0; i < reconnect_attempts_ && delay < kMaxReconnectTimeout; ++i)
+        delay *= 2;
+    delay = std::min(delay, kMaxReconnectTimeout);
+
+    // Equal jitter: half of the delay is fixed, the other half is random.
+    delay = delay / 2 + std::chrono::milliseconds(
+        base::Random::number64() % static_cast<uint64_t>(delay.count() / 2 + 1));
+
+    ++reconnect_attempts_;
+
+    LOG(LS_INFO) << "Reconnect after " << delay.count() << " ms (attempt: "
+                 << reconnect_attempts_ << ")";
+    reconnect_timer_.start(delay, std::bind(&Controller::connectToRouter, this));
+}
+
+void Controller::refillKeyPool()
+{
+    if (draining_ || !channel_)
+        return;
+
+    // The router should never hold more keys than the relay has spare capacity for.
+    const uint32_t target =
+        max_peer_count_ > active_session_count_ ? max_peer_count_ - active_session_count_ : 0;
+
+    if (router_key_count_ >= target)
+        return;
+
+    const uint32_t deficit = target - router_key_count_;
+
+    // Top up in blocks: one message carrying many keys costs the router one read instead of
+    // one per key. Small deficits wait until the pool is half-drained.
+    if (deficit < kKeyRefillBlockSize && router_key_count_ * 2 >= target)
+        return;
+
+    sendKeyPool(deficit);
 }
 
 void Controller::sendKeyPool(uint32_t key_count)
 {
+    // A draining relay must not offer keys for new sessions.
+    if (draining_)
+        return;
+
     proto::RelayToRouter message;
     proto::RelayKeyPool* relay_key_pool = message.mutable_key_pool();
 
@@ -262,7 +387,7 @@ void Controller::sendKeyPool(uint32_t key_count)
     {
         SessionKey session_key = SessionKey::create();
         if (!session_key.isValid())
-            return;
+            break;
 
         // Add the key to the outgoing message.
         proto::RelayKey* key = relay_key_pool->add_key();
@@ -276,8 +401,24 @@ void Controller::sendKeyPool(uint32_t key_count)
         key->set_key_id(shared_pool_->addKey(std::move(session_key)));
     }
 
+    if (relay_key_pool->key_size() == 0)
+        return;
+
+    router_key_count_ += static_cast<uint32_t>(relay_key_pool->key_size());
+
     // Send a message to the router.
     channel_->send(base::serialize(message));
 }
 
+void Controller::sendRelayLoad()
+{
+    proto::RelayToRouter message;
+    proto::RelayLoad* relay_load = message.mutable_relay_load();
+
+    relay_load->set_active_sessions(active_session_count_);
+    relay_load->set_max_sessions(max_peer_count_);
+
+    channel_->send(base::serialize(message));
+}
+
 } // namespace relay
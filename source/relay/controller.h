@@ -43,6 +43,11 @@ public:
 
     bool start();
 
+    // Starts draining the relay for maintenance. The router is told to stop using this relay
+    // for new sessions; sessions already running keep forwarding until their peers disconnect.
+    // When the last session finishes, the message loop is asked to quit.
+    void drain();
+
 protected:
     // base::NetworkChannel::Listener implementation.
     void onConnected() override;
@@ -51,6 +56,7 @@ protected:
     void onMessageWritten(size_t pending) override;
 
     // SessionManager::Delegate implementation.
+    void onSessionStarted() override;
     void onSessionFinished() override;
 
     // SharedPool::Delegate implementation.
@@ -59,7 +65,9 @@ protected:
 private:
     void connectToRouter();
     void delayedConnectToRouter();
+    void refillKeyPool();
     void sendKeyPool(uint32_t key_count);
+    void sendRelayLoad();
 
     // Router settings.
     std::u16string router_address_;
@@ -71,6 +79,30 @@ private:
     uint16_t peer_port_ = 0;
     uint32_t max_peer_count_ = 0;
 
+    // Traffic accounting settings.
+    std::filesystem::path database_path_;
+
+    // Session-resumption ticket from the last successful authentication. Offered on reconnect
+    // so the router can skip the SRP handshake; empty until the first connection.
+    base::ByteArray router_ticket_;
+    base::ByteArray router_ticket_secret_;
+
+    // Number of reconnect attempts since the last successful authentication. Drives the
+    // exponential backoff.
+    int reconnect_attempts_ = 0;
+
+    // Number of active relay sessions. Reported to the router, which prefers lightly loaded
+    // relays when selecting one for a new connection.
+    uint32_t active_session_count_ = 0;
+
+    // Number of unused keys believed to be in the router's pool. Incremented when keys are
+    // sent, decremented when the router reports a key as used; drives the batched refill.
+    uint32_t router_key_count_ = 0;
+
+    // Set when a drain has been requested. No new keys are sent to the router and the process
+    // quits once the active sessions are gone.
+    bool draining_ = false;
+
     std::shared_ptr<base::TaskRunner> task_runner_;
     base::WaitableTimer reconnect_timer_;
     std::unique_ptr<base::NetworkChannel> channel_;
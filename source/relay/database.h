@@ -45,9 +45,24 @@ public:
 
     using SessionList = std::vector<Session>;
 
+    // One traffic record accumulated in memory by the session manager. |key_id| is the
+    // identifier of the shared key the session was created with; the router assigns keys per
+    // connection request, so the records can be matched with the owning tenant there.
+    struct Traffic
+    {
+        uint32_t key_id;
+        time_t timestamp;
+        int64_t bytes;
+    };
+
+    using TrafficList = std::vector<Traffic>;
+
     virtual bool addSession(const Session& session) = 0;
     virtual bool removeSession(int64_t entry_id) = 0;
     virtual SessionList sessions(int64_t limit) = 0;
+
+    // Writes a batch of traffic records in a single transaction.
+    virtual bool addTraffic(const TrafficList& traffic) = 0;
 };
 
 } // namespace relay
@@ -18,16 +18,94 @@
 
 #include "relay/database_sqlite.h"
 
+#include "base/logging.h"
+
+#include <sqlite3.h>
+
 namespace relay {
 
-DatabaseSqlite::DatabaseSqlite()
+namespace {
+
+bool writeInt64(sqlite3_stmt* statement, int64_t number, int column)
 {
+    int error_code = sqlite3_bind_int64(statement, column, number);
+    if (error_code != SQLITE_OK)
+    {
+        LOG(LS_ERROR) << "sqlite3_bind_int64 failed: " << sqlite3_errstr(error_code)
+                      << " (column: " << column << ")";
+        return false;
+    }
+
+    return true;
+}
 
+} // namespace
+
+DatabaseSqlite::DatabaseSqlite(sqlite3* db)
+    : db_(db)
+{
+    DCHECK(db_);
 }
 
 DatabaseSqlite::~DatabaseSqlite()
 {
+    for (const auto& entry : statement_cache_)
+        sqlite3_finalize(entry.second);
+
+    sqlite3_close(db_);
+}
+
+// static
+std::unique_ptr<DatabaseSqlite> DatabaseSqlite::open(const std::filesystem::path& file_path)
+{
+    if (file_path.empty())
+    {
+        LOG(LS_WARNING) << "Invalid file path";
+        return nullptr;
+    }
+
+    std::string file_path_utf8 = file_path.u8string();
+    LOG(LS_INFO) << "Opening database: " << file_path_utf8;
+
+    sqlite3* db = nullptr;
+
+    int error_code = sqlite3_open(file_path_utf8.c_str(), &db);
+    if (error_code != SQLITE_OK)
+    {
+        LOG(LS_WARNING) << "sqlite3_open failed: " << sqlite3_errstr(error_code);
+        return nullptr;
+    }
+
+    // WAL keeps a batch commit down to one sequential append; with the default journal mode a
+    // commit rewrites the database pages in place and fsyncs twice. A failure is not fatal
+    // (e.g. read-only media); the database then runs in the default mode.
+    static const char kPragmas[] = "PRAGMA journal_mode=WAL; PRAGMA synchronous=NORMAL;";
 
+    char* error_message = nullptr;
+    if (sqlite3_exec(db, kPragmas, nullptr, nullptr, &error_message) != SQLITE_OK)
+    {
+        LOG(LS_WARNING) << "Failed to set database pragmas: "
+                        << (error_message ? error_message : "unknown error");
+        sqlite3_free(error_message);
+        error_message = nullptr;
+    }
+
+    static const char kCreateTable[] =
+        "CREATE TABLE IF NOT EXISTS traffic ("
+        "key_id INTEGER NOT NULL, "
+        "timestamp INTEGER NOT NULL, "
+        "bytes INTEGER NOT NULL)";
+
+    if (sqlite3_exec(db, kCreateTable, nullptr, nullptr, &error_message) != SQLITE_OK)
+    {
+        LOG(LS_ERROR) << "Failed to create traffic table: "
+                      << (error_message ? error_message : "unknown error");
+        sqlite3_free(error_message);
+        sqlite3_close(db);
+        return nullptr;
+    }
+
+    return std::unique_ptr<DatabaseSqlite>(new DatabaseSqlite(db));
 }
 
 bool DatabaseSqlite::addSession(const Session& session)
@@ -45,4 +123,89 @@ Database::SessionList DatabaseSqlite::sessions(int64_t limit)
     return SessionList();
 }
 
+bool DatabaseSqlite::addTraffic(const TrafficList& traffic)
+{
+    if (traffic.empty())
+        return true;
+
+    const char kQuery[] = "INSERT INTO traffic (key_id, timestamp, bytes) VALUES (?, ?, ?)";
+
+    sqlite3_stmt* statement = preparedStatement(kQuery, sizeof(kQuery));
+    if (!statement)
+        return false;
+
+    // All records of the batch go into one transaction, so the database is synced to disk once
+    // per flush instead of once per record.
+    char* error_message = nullptr;
+    if (sqlite3_exec(db_, "BEGIN TRANSACTION", nullptr, nullptr, &error_message) != SQLITE_OK)
+    {
+        LOG(LS_ERROR) << "Failed to begin transaction: "
+                      << (error_message ? error_message : "unknown error");
+        sqlite3_free(error_message);
+        return false;
+    }
+
+    bool result = true;
+
+    for (const Traffic& record : traffic)
+    {
+        if (!writeInt64(statement, record.key_id, 1) ||
+            !writeInt64(statement, record.timestamp, 2) ||
+            !writeInt64(statement, record.bytes, 3))
+        {
+            result = false;
+            break;
+        }
+
+        int error_code = sqlite3_step(statement);
+        if (error_code != SQLITE_DONE)
+        {
+            LOG(LS_ERROR) << "sqlite3_step failed: " << sqlite3_errstr(error_code);
+            result = false;
+            break;
+        }
+
+        sqlite3_reset(statement);
+    }
+
+    resetStatement(statement);
+
+    const char* finish_query = result ? "COMMIT" : "ROLLBACK";
+    if (sqlite3_exec(db_, finish_query, nullptr, nullptr, &error_message) != SQLITE_OK)
+    {
+        LOG(LS_ERROR) << "Failed to finish transaction: "
+                      << (error_message ? error_message : "unknown error");
+        sqlite3_free(error_message);
+        return false;
+    }
+
+    return result;
+}
+
+sqlite3_stmt* DatabaseSqlite::preparedStatement(const char* query, size_t query_size) const
+{
+    auto it = statement_cache_.find(query);
+    if (it != statement_cache_.end())
+        return it->second;
+
+    sqlite3_stmt* statement = nullptr;
+    int error_code = sqlite3_prepare_v3(
+        db_, query, query_size, SQLITE_PREPARE_PERSISTENT, &statement, nullptr);
+    if (error_code != SQLITE_OK)
+    {
+        LOG(LS_ERROR) << "sqlite3_prepare_v3 failed: " << sqlite3_errstr(error_code);
+        return nullptr;
+    }
+
+    statement_cache_.emplace(query, statement);
+    return statement;
+}
+
+// static
+void DatabaseSqlite::resetStatement(sqlite3_stmt* statement)
+{
+    sqlite3_reset(statement);
+    sqlite3_clear_bindings(statement);
+}
+
 } // namespace relay
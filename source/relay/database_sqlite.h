@@ -22,20 +22,43 @@
 #include "base/macros_magic.h"
 #include "relay/database.h"
 
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+struct sqlite3;
+struct sqlite3_stmt;
+
 namespace relay {
 
 class DatabaseSqlite : public Database
 {
 public:
-    DatabaseSqlite();
     ~DatabaseSqlite();
 
+    // Opens (creating it if necessary) the database at |file_path|. Returns nullptr if the
+    // database could not be opened.
+    static std::unique_ptr<DatabaseSqlite> open(const std::filesystem::path& file_path);
+
     // Database implementation.
     bool addSession(const Session& session) override;
     bool removeSession(int64_t entry_id) override;
     SessionList sessions(int64_t limit) override;
+    bool addTraffic(const TrafficList& traffic) override;
 
 private:
+    explicit DatabaseSqlite(sqlite3* db);
+
+    sqlite3_stmt* preparedStatement(const char* query, size_t query_size) const;
+    static void resetStatement(sqlite3_stmt* statement);
+
+    sqlite3* const db_;
+
+    // The same few statements run over and over; preparing them once and rebinding the
+    // parameters avoids recompiling the SQL on every call.
+    mutable std::unordered_map<std::string, sqlite3_stmt*> statement_cache_;
+
     DISALLOW_COPY_AND_ASSIGN(DatabaseSqlite);
 };
 
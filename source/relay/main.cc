@@ -28,7 +28,10 @@
 #else
 #include "base/crypto/scoped_crypto_initializer.h"
 #include "base/message_loop/message_loop.h"
+#include "base/message_loop/message_pump_asio.h"
 #include "relay/controller.h"
+
+#include <asio/signal_set.hpp>
 #endif
 
 #include <iostream>
@@ -206,6 +209,25 @@ int main(int /* argc */, const char* const* /* argv */)
         std::make_unique<relay::Controller>(message_loop->taskRunner());
 
     controller->start();
+
+    // The first SIGINT or SIGTERM starts a drain for maintenance: the router stops using the
+    // relay for new sessions and the process exits once the running sessions are gone. A
+    // second signal exits immediately.
+    asio::signal_set signals(message_loop->pumpAsio()->ioContext(), SIGINT, SIGTERM);
+    signals.async_wait([&](const std::error_code& error_code, int /* signal_number */)
+    {
+        if (error_code)
+            return;
+
+        controller->drain();
+
+        signals.async_wait([&](const std::error_code& error_code, int /* signal_number */)
+        {
+            if (!error_code)
+                message_loop->taskRunner()->postQuit();
+        });
+    });
+
     message_loop->run();
 
     controller.reset();
@@ -21,21 +21,61 @@
 #include "base/location.h"
 #include "base/logging.h"
 #include "base/strings/unicode.h"
+#include "relay/buffer_pool.h"
 
 #include <asio/write.hpp>
 
+#if defined(OS_LINUX)
+#include <fcntl.h>
+#include <unistd.h>
+#endif // defined(OS_LINUX)
+
 namespace relay {
 
+namespace {
+
+// Interval of the idle check. A session that transferred nothing within one interval is
+// parked: its receive buffers are released until data arrives again.
+const std::chrono::seconds kIdleCheckInterval{ 30 };
+
+#if defined(OS_LINUX)
+// Amount of data moved by a single splice call. The kernel clamps it to the pipe capacity.
+const size_t kSpliceChunkSize = 1048576; // 1 MB
+#endif // defined(OS_LINUX)
+
+} // namespace
+
 Session::Session(std::pair<asio::ip::tcp::socket, asio::ip::tcp::socket>&& sockets)
-    : socket_{ std::move(sockets.first), std::move(sockets.second) }
+    : socket_{ std::move(sockets.first), std::move(sockets.second) },
+      idle_timer_(socket_[0].get_executor())
 {
-    for (size_t i = 0; i < kNumberOfSides; ++i)
-        std::fill(buffer_[i].begin(), buffer_[i].end(), 0);
+    // Every session starts in the small class; the first full read or the first idle check
+    // moves a busy direction up.
+    for (int i = 0; i < kNumberOfSides; ++i)
+        desired_buffer_size_[i] = BufferPool::kSmallBufferSize;
+
+#if defined(OS_LINUX)
+    initSplice();
+#endif // defined(OS_LINUX)
 }
 
 Session::~Session()
 {
     stop();
+
+    for (int i = 0; i < kNumberOfSides; ++i)
+        releaseBuffer(i);
+
+#if defined(OS_LINUX)
+    for (int i = 0; i < kNumberOfSides; ++i)
+    {
+        for (int j = 0; j < 2; ++j)
+        {
+            if (pipe_fd_[i][j] != -1)
+                close(pipe_fd_[i][j]);
+        }
+    }
+#endif // defined(OS_LINUX)
 }
 
 void Session::start(Delegate* delegate)
@@ -46,7 +86,33 @@ void Session::start(Delegate* delegate)
     delegate_ = delegate;
 
     for (int i = 0; i < kNumberOfSides; ++i)
-        Session::doReadSome(this, i);
+    {
+#if defined(OS_LINUX)
+        if (use_splice_)
+        {
+            Session::doSplice(this, i);
+            continue;
+        }
+#endif // defined(OS_LINUX)
+
+        // The sockets are read with non-blocking calls from readiness handlers.
+        std::error_code ignored_code;
+        socket_[i].non_blocking(true, ignored_code);
+
+        Session::doWaitRead(this, i);
+    }
+
+#if defined(OS_LINUX)
+    if (use_splice_)
+        return;
+#endif // defined(OS_LINUX)
+
+    idle_timer_.expires_after(kIdleCheckInterval);
+    idle_timer_.async_wait([this](const std::error_code& error_code)
+    {
+        if (!error_code)
+            onIdleCheck();
+    });
 }
 
 void Session::stop()
@@ -56,6 +122,8 @@ void Session::stop()
 
     delegate_ = nullptr;
 
+    idle_timer_.cancel();
+
     std::error_code ignored_code;
     for (int i = 0; i < kNumberOfSides; ++i)
     {
@@ -80,26 +148,234 @@ int64_t Session::bytesTransferred() const
     return bytes_transferred_;
 }
 
+// static
+void Session::doWaitRead(Session* session, int source)
+{
+    // A bufferless wait for readability instead of a posted read: no receive buffer is pinned
+    // while the direction is quiet, which lets onIdleCheck release it.
+    session->socket_[source].async_wait(
+        asio::ip::tcp::socket::wait_read,
+        [session, source](const std::error_code& error_code)
+    {
+        if (error_code)
+        {
+            if (error_code != asio::error::operation_aborted)
+                session->onErrorOccurred(FROM_HERE, error_code);
+            return;
+        }
+
+        doReadSome(session, source);
+    });
+}
+
 // static
 void Session::doReadSome(Session* session, int source)
 {
-    session->socket_[source].async_read_some(
-        asio::buffer(session->buffer_[source].data(), session->buffer_[source].size()),
-        [session, source](const std::error_code& error_code, size_t bytes_transferred)
+    std::error_code error_code;
+    size_t bytes_transferred = session->socket_[source].read_some(
+        asio::buffer(session->ensureBuffer(source), session->buffer_size_[source]), error_code);
+    if (error_code)
     {
+        if (error_code == asio::error::would_block)
+        {
+            // Spurious readiness; keep waiting.
+            doWaitRead(session, source);
+        }
+        else if (error_code != asio::error::operation_aborted)
+        {
+            session->onErrorOccurred(FROM_HERE, error_code);
+        }
+        return;
+    }
+
+    session->bytes_transferred_ += bytes_transferred;
+    session->direction_bytes_[source] += bytes_transferred;
+    session->pending_bytes_.fetch_add(bytes_transferred, std::memory_order_relaxed);
+    session->transfer_active_[source] = true;
+
+    // A read that fills the whole buffer means the direction runs faster than the buffer;
+    // move to the next class without waiting for the idle check.
+    if (bytes_transferred == session->buffer_size_[source] &&
+        session->desired_buffer_size_[source] <= session->buffer_size_[source] &&
+        session->buffer_size_[source] < BufferPool::kLargeBufferSize)
+    {
+        session->desired_buffer_size_[source] =
+            BufferPool::classSize(session->buffer_size_[source] + 1);
+    }
+
+    asio::async_write(
+        session->socket_[(source + kNumberOfSides - 1) % kNumberOfSides],
+        asio::const_buffer(session->buffer_[source].get(), bytes_transferred),
+        [session, source](const std::error_code& error_code, size_t /* bytes_transferred */)
+    {
+        session->transfer_active_[source] = false;
+
         if (error_code)
         {
             if (error_code != asio::error::operation_aborted)
                 session->onErrorOccurred(FROM_HERE, error_code);
+            return;
         }
-        else
+
+        // Swap a buffer of the wrong class between two transfers; the next read leases one
+        // of the desired size.
+        if (session->buffer_size_[source] != session->desired_buffer_size_[source])
+            session->releaseBuffer(source);
+
+        doWaitRead(session, source);
+    });
+}
+
+uint8_t* Session::ensureBuffer(int source)
+{
+    if (!buffer_[source])
+    {
+        buffer_[source] = BufferPool::instance()->lease(desired_buffer_size_[source]);
+        buffer_size_[source] = BufferPool::classSize(desired_buffer_size_[source]);
+    }
+
+    return buffer_[source].get();
+}
+
+void Session::releaseBuffer(int source)
+{
+    if (!buffer_[source])
+        return;
+
+    BufferPool::instance()->release(std::move(buffer_[source]), buffer_size_[source]);
+    buffer_size_[source] = 0;
+}
+
+void Session::onIdleCheck()
+{
+    // Park the session when the interval passed without traffic: return the receive buffers to
+    // the pool and keep only the readiness waits pending. A parked session costs the sockets
+    // and their reactor registrations; the first byte that arrives leases a buffer again in
+    // ensureBuffer. A buffer whose data is still being written to the other side is left alone.
+    if (bytes_transferred_ == idle_check_bytes_)
+    {
+        for (int i = 0; i < kNumberOfSides; ++i)
         {
-            session->bytes_transferred_ += bytes_transferred;
+            if (!transfer_active_[i])
+                releaseBuffer(i);
+        }
+    }
+
+    idle_check_bytes_ = bytes_transferred_;
 
-            asio::async_write(
-                session->socket_[(source + kNumberOfSides - 1) % kNumberOfSides],
-                asio::const_buffer(session->buffer_[source].data(), bytes_transferred),
-                [session, source](const std::error_code& error_code, size_t bytes_transferred)
+    // Settle each direction on the class that holds about 100 ms of its measured rate, so the
+    // size class follows the traffic down again after a burst.
+    for (int i = 0; i < kNumberOfSides; ++i)
+    {
+        const int64_t interval_bytes = direction_bytes_[i] - idle_check_direction_bytes_[i];
+        idle_check_direction_bytes_[i] = direction_bytes_[i];
+
+        const int64_t rate = interval_bytes / kIdleCheckInterval.count();
+        desired_buffer_size_[i] = BufferPool::classSize(static_cast<size_t>(rate / 10));
+    }
+
+    idle_timer_.expires_after(kIdleCheckInterval);
+    idle_timer_.async_wait([this](const std::error_code& error_code)
+    {
+        if (!error_code)
+            onIdleCheck();
+    });
+}
+
+#if defined(OS_LINUX)
+
+void Session::initSplice()
+{
+    for (int i = 0; i < kNumberOfSides; ++i)
+    {
+        if (pipe2(pipe_fd_[i], O_NONBLOCK | O_CLOEXEC) != 0)
+        {
+            PLOG(LS_WARNING) << "Unable to create pipe, fallback to buffered relay";
+            return;
+        }
+
+        // Not fatal if it fails; the pipe keeps its default capacity.
+        fcntl(pipe_fd_[i][1], F_SETPIPE_SZ, static_cast<int>(kSpliceChunkSize));
+    }
+
+    use_splice_ = true;
+}
+
+// static
+void Session::doSplice(Session* session, int source)
+{
+    const int target = (source + kNumberOfSides - 1) % kNumberOfSides;
+
+    asio::ip::tcp::socket& source_socket = session->socket_[source];
+    asio::ip::tcp::socket& target_socket = session->socket_[target];
+
+    // The sockets are handled through their native descriptors, so asio must not restore
+    // blocking mode behind our back.
+    std::error_code ignored_code;
+    source_socket.native_non_blocking(true, ignored_code);
+    target_socket.native_non_blocking(true, ignored_code);
+
+    while (true)
+    {
+        if (!session->pipe_filled_[source])
+        {
+            // Move the received data from the socket into the pipe. The data stays in the
+            // kernel; no copy into userspace is made.
+            ssize_t bytes_read = splice(source_socket.native_handle(), nullptr,
+                                        session->pipe_fd_[source][1], nullptr,
+                                        kSpliceChunkSize,
+                                        SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            if (bytes_read > 0)
+            {
+                session->pipe_filled_[source] = static_cast<size_t>(bytes_read);
+                session->bytes_transferred_ += bytes_read;
+                session->pending_bytes_.fetch_add(bytes_read, std::memory_order_relaxed);
+            }
+            else if (bytes_read == 0)
+            {
+                session->onErrorOccurred(FROM_HERE, asio::error::eof);
+                return;
+            }
+            else if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                source_socket.async_wait(
+                    asio::ip::tcp::socket::wait_read,
+                    [session, source](const std::error_code& error_code)
+                {
+                    if (error_code)
+                    {
+                        if (error_code != asio::error::operation_aborted)
+                            session->onErrorOccurred(FROM_HERE, error_code);
+                    }
+                    else
+                    {
+                        doSplice(session, source);
+                    }
+                });
+                return;
+            }
+            else
+            {
+                session->onErrorOccurred(
+                    FROM_HERE, std::error_code(errno, std::generic_category()));
+                return;
+            }
+        }
+
+        // Move the data from the pipe into the other socket.
+        ssize_t bytes_written = splice(session->pipe_fd_[source][0], nullptr,
+                                       target_socket.native_handle(), nullptr,
+                                       session->pipe_filled_[source],
+                                       SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (bytes_written > 0)
+        {
+            session->pipe_filled_[source] -= static_cast<size_t>(bytes_written);
+        }
+        else if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            target_socket.async_wait(
+                asio::ip::tcp::socket::wait_write,
+                [session, source](const std::error_code& error_code)
             {
                 if (error_code)
                 {
@@ -108,13 +384,22 @@ void Session::doReadSome(Session* session, int source)
                 }
                 else
                 {
-                    doReadSome(session, source);
+                    doSplice(session, source);
                 }
             });
+            return;
         }
-    });
+        else
+        {
+            session->onErrorOccurred(
+                FROM_HERE, std::error_code(errno, std::generic_category()));
+            return;
+        }
+    }
 }
 
+#endif // defined(OS_LINUX)
+
 void Session::onErrorOccurred(const base::Location& location, const std::error_code& error_code)
 {
     LOG(LS_ERROR) << "Connection finished: " << base::utf16FromLocal8Bit(error_code.message())
@@ -20,8 +20,13 @@
 #define RELAY__SESSION_H
 
 #include "base/macros_magic.h"
+#include "build/build_config.h"
 
 #include <asio/ip/tcp.hpp>
+#include <asio/steady_timer.hpp>
+
+#include <atomic>
+#include <memory>
 
 namespace base {
 class Location;
@@ -46,21 +51,78 @@ public:
     void start(Delegate* delegate);
     void stop();
 
+    // Index of the session thread the data transfer runs on. Assigned by the session manager.
+    void setThreadIndex(size_t thread_index) { thread_index_ = thread_index; }
+    size_t threadIndex() const { return thread_index_; }
+
+    // Identifier of the shared key the session was created with. Assigned by the session manager.
+    void setKeyId(uint32_t key_id) { key_id_ = key_id; }
+    uint32_t keyId() const { return key_id_; }
+
     std::chrono::seconds duration() const;
     int64_t bytesTransferred() const;
 
+    // Returns the number of bytes transferred since the previous call and resets the counter.
+    // Called by the session manager from its own thread for the traffic accounting; the counter
+    // is updated on the session thread, so it is the only cross-thread member of the session.
+    int64_t takePendingBytes() { return pending_bytes_.exchange(0, std::memory_order_relaxed); }
+
 private:
+    static void doWaitRead(Session* session, int source);
     static void doReadSome(Session* session, int source);
+    uint8_t* ensureBuffer(int source);
+    void releaseBuffer(int source);
+    void onIdleCheck();
     void onErrorOccurred(const base::Location& location, const std::error_code& error_code);
 
+#if defined(OS_LINUX)
+    void initSplice();
+    static void doSplice(Session* session, int source);
+#endif // defined(OS_LINUX)
+
     std::chrono::time_point<std::chrono::high_resolution_clock> start_time_;
     int64_t bytes_transferred_ = 0;
+    std::atomic<int64_t> pending_bytes_{0};
+    size_t thread_index_ = 0;
+    uint32_t key_id_ = 0;
 
     static const int kNumberOfSides = 2;
-    static const int kBufferSize = 8192;
 
     asio::ip::tcp::socket socket_[kNumberOfSides];
-    std::array<uint8_t, kBufferSize> buffer_[kNumberOfSides];
+
+    // Receive buffers, leased from the relay-wide BufferPool on the first byte of a direction
+    // and returned again when the session idles (see onIdleCheck). The pending operations are
+    // bufferless readiness waits, so an idle session holds no buffer memory at all.
+    std::unique_ptr<uint8_t[]> buffer_[kNumberOfSides];
+    size_t buffer_size_[kNumberOfSides] = { 0, 0 };
+
+    // Size class the next lease of the direction should use, adjusted to the measured rate: a
+    // read that fills the whole buffer upgrades it, the idle check settles it on the class
+    // matching the traffic of the last interval. A mismatching buffer is swapped between two
+    // transfers.
+    size_t desired_buffer_size_[kNumberOfSides];
+
+    // True while a read buffer of the direction is in use (between reading the data and the
+    // completion of the write to the other side). Such a buffer must not be released.
+    bool transfer_active_[kNumberOfSides] = { false, false };
+
+    // Periodic idle check for the buffered relay path. The splice path holds no userspace
+    // buffers, so it needs no parking.
+    asio::steady_timer idle_timer_;
+    int64_t idle_check_bytes_ = 0;
+
+    // Bytes relayed per direction, total and at the last idle check; their difference is the
+    // traffic of the interval the buffer size class is derived from.
+    int64_t direction_bytes_[kNumberOfSides] = { 0, 0 };
+    int64_t idle_check_direction_bytes_[kNumberOfSides] = { 0, 0 };
+
+#if defined(OS_LINUX)
+    // Pipes for splice(2) forwarding. The data moves between the sockets inside the kernel
+    // without crossing into userspace; the buffers above are used only when pipe creation fails.
+    bool use_splice_ = false;
+    int pipe_fd_[kNumberOfSides][2] = { { -1, -1 }, { -1, -1 } };
+    size_t pipe_filled_[kNumberOfSides] = { 0, 0 };
+#endif // defined(OS_LINUX)
 
     Delegate* delegate_ = nullptr;
 
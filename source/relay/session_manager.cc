@@ -25,11 +25,37 @@
 #include "base/crypto/message_decryptor_openssl.h"
 #include "base/peer/host_id.h"
 #include "base/strings/unicode.h"
+#include "relay/database_sqlite.h"
+
+#include <algorithm>
 
 namespace relay {
 
 namespace {
 
+// Interval between writes of the accumulated traffic records to the database.
+const std::chrono::minutes kTrafficFlushInterval{ 1 };
+
+// Timer slack of the flush. The records carry their own timestamps, so a flush that runs a few
+// seconds late changes nothing; in exchange the timer shares its wakeup with other background
+// work.
+const std::chrono::seconds kTrafficFlushSlack{ 10 };
+
+// When this many records are pending, they are written without waiting for the timer. With the
+// flush interval above the threshold is reached only when sessions finish in large numbers.
+const size_t kTrafficFlushThreshold = 256;
+
+// Upper bound of the pending session table. Pending sessions are peers that have connected but
+// not yet completed the key exchange; legitimate peers finish within seconds.
+const size_t kMaxPendingSessions = 512;
+
+// Limit of connection attempts from one address within the window below.
+const std::chrono::seconds kConnectRateWindow{ 10 };
+const size_t kMaxConnectsPerWindow = 50;
+
+// When the rate map reaches this size, entries with an expired window are pruned.
+const size_t kMaxConnectRateEntries = 4096;
+
 // Decrypts an encrypted pair of peer identifiers using key |session_key|.
 base::ByteArray decryptSecret(const proto::PeerToRelay& message, const SharedPool::Key& key)
 {
@@ -66,9 +92,30 @@ base::ByteArray decryptSecret(const proto::PeerToRelay& message, const SharedPoo
     return target;
 }
 
+// Rebinds a socket to another io_context, so the session can run on a different thread than the
+// one that accepted the connection.
+asio::ip::tcp::socket migrateSocket(asio::io_context* io_context, asio::ip::tcp::socket socket)
+{
+    std::error_code error_code;
+
+    asio::ip::tcp::endpoint endpoint = socket.local_endpoint(error_code);
+    if (error_code)
+        return asio::ip::tcp::socket(*io_context);
+
+    asio::ip::tcp::socket::native_handle_type handle = socket.release(error_code);
+    if (error_code)
+    {
+        LOG(LS_WARNING) << "Unable to release socket: "
+                        << base::utf16FromLocal8Bit(error_code.message());
+        return asio::ip::tcp::socket(*io_context);
+    }
+
+    return asio::ip::tcp::socket(*io_context, endpoint.protocol(), handle);
+}
+
 // Removes a session from the list and returns a pointer to it.
-template<class T>
-std::unique_ptr<T> removeSessionT(std::vector<std::unique_ptr<T>>* session_list, T* session)
+template<class Container, class T>
+std::unique_ptr<T> removeSessionT(Container* session_list, T* session)
 {
     session->stop();
 
@@ -93,14 +140,28 @@ std::unique_ptr<T> removeSessionT(std::vector<std::unique_ptr<T>>* session_list,
 
 } // namespace
 
-SessionManager::SessionManager(std::shared_ptr<base::TaskRunner> task_runner, uint16_t port)
+SessionManager::SessionManager(std::shared_ptr<base::TaskRunner> task_runner,
+                               uint16_t port,
+                               const std::filesystem::path& database_path)
     : task_runner_(std::move(task_runner)),
       acceptor_(base::MessageLoop::current()->pumpAsio()->ioContext(),
-                asio::ip::tcp::endpoint(asio::ip::tcp::v4(), port))
+                asio::ip::tcp::endpoint(asio::ip::tcp::v4(), port)),
+      traffic_flush_timer_(base::WaitableTimer::Type::REPEATED, task_runner_)
 {
     DCHECK(task_runner_);
 
     LOG(LS_INFO) << "Session manager port: " << port;
+
+    if (!database_path.empty())
+    {
+        database_ = DatabaseSqlite::open(database_path);
+        if (!database_)
+            LOG(LS_ERROR) << "Unable to open traffic database. Accounting is disabled";
+    }
+    else
+    {
+        LOG(LS_INFO) << "Database path is empty. Traffic accounting is disabled";
+    }
 }
 
 SessionManager::~SessionManager()
@@ -108,6 +169,16 @@ SessionManager::~SessionManager()
     std::error_code ignored_code;
     acceptor_.cancel(ignored_code);
     acceptor_.close(ignored_code);
+
+    // Write the not yet flushed traffic. The counters are atomic, so they can be collected
+    // while the session threads are still running.
+    traffic_flush_timer_.stop();
+    flushTraffic();
+
+    // The session threads must be joined before the sessions are destroyed, so that no handler
+    // touches a session while it is being deleted.
+    for (SessionThread& session_thread : session_threads_)
+        session_thread.thread->stop();
 }
 
 void SessionManager::start(std::unique_ptr<SharedPool> shared_pool, Delegate* delegate)
@@ -119,6 +190,31 @@ void SessionManager::start(std::unique_ptr<SharedPool> shared_pool, Delegate* de
 
     DCHECK(delegate_ && shared_pool_);
 
+    // One session thread per core. The key pool is shared between the threads and is protected
+    // by its own lock.
+    const size_t thread_count = std::max(1u, std::thread::hardware_concurrency());
+
+    LOG(LS_INFO) << "Starting " << thread_count << " session threads";
+
+    for (size_t i = 0; i < thread_count; ++i)
+    {
+        SessionThread session_thread;
+
+        session_thread.thread = std::make_unique<base::Thread>();
+        session_thread.thread->start(base::MessageLoop::Type::ASIO);
+        session_thread.task_runner = session_thread.thread->taskRunner();
+        session_thread.io_context =
+            &session_thread.thread->messageLoop()->pumpAsio()->ioContext();
+
+        session_threads_.emplace_back(std::move(session_thread));
+    }
+
+    if (database_)
+    {
+        traffic_flush_timer_.start(kTrafficFlushInterval, kTrafficFlushSlack,
+                                   std::bind(&SessionManager::flushTraffic, this));
+    }
+
     SessionManager::doAccept(this);
 }
 
@@ -148,10 +244,27 @@ void SessionManager::onPendingSessionReady(
                     // Delete the key from the pool. It can no longer be used.
                     shared_pool_->removeKey(message.key_id());
 
+                    // Assign the session to the thread with the fewest active sessions and move
+                    // the sockets to the io_context of that thread.
+                    const size_t thread_index = leastLoadedThread();
+                    SessionThread& session_thread = session_threads_[thread_index];
+
                     // Now the opposite peer is found, start the data transfer between them.
-                    active_sessions_.emplace_back(std::make_unique<Session>(
-                        std::make_pair(session->takeSocket(), other_session->takeSocket())));
-                    active_sessions_.back()->start(this);
+                    active_sessions_.emplace_back(std::make_unique<Session>(std::make_pair(
+                        migrateSocket(session_thread.io_context, session->takeSocket()),
+                        migrateSocket(session_thread.io_context, other_session->takeSocket()))));
+
+                    Session* new_session = active_sessions_.back().get();
+                    new_session->setThreadIndex(thread_index);
+                    new_session->setKeyId(message.key_id());
+                    ++session_thread.session_count;
+
+                    // The transfer is started on the thread that owns the sockets now.
+                    session_thread.task_runner->postTask(
+                        std::bind(&Session::start, new_session, this));
+
+                    if (delegate_)
+                        delegate_->onSessionStarted();
 
                     // Pending sessions are no longer needed, remove them.
                     removePendingSession(other_session.get());
@@ -184,6 +297,13 @@ void SessionManager::onPendingSessionFailed(PendingSession* session)
 
 void SessionManager::onSessionFinished(Session* session)
 {
+    // Sessions finish on their session thread; the bookkeeping lives on the manager thread.
+    if (!task_runner_->belongsToCurrentThread())
+    {
+        task_runner_->postTask(std::bind(&SessionManager::onSessionFinished, this, session));
+        return;
+    }
+
     removeSession(session);
 }
 
@@ -195,13 +315,38 @@ void SessionManager::doAccept(SessionManager* session_manager)
     {
         if (!error_code)
         {
-            LOG(LS_INFO) << "New accepted connection: " << base::utf16FromLocal8Bit(
-                socket.remote_endpoint().address().to_string());
+            std::error_code endpoint_error;
+            asio::ip::tcp::endpoint endpoint = socket.remote_endpoint(endpoint_error);
+
+            if (endpoint_error || !session_manager->acceptConnectionFrom(endpoint.address()))
+            {
+                // The socket is simply closed. Nothing has been allocated for the peer yet, so
+                // a rejected connect is as cheap as possible.
+                std::error_code ignored_code;
+                socket.close(ignored_code);
+            }
+            else
+            {
+                LOG(LS_INFO) << "New accepted connection: "
+                             << base::utf16FromLocal8Bit(endpoint.address().to_string());
+
+                // The table is full; the oldest pending session is the least likely to still
+                // complete its handshake, drop it to make room.
+                if (session_manager->pending_sessions_.size() >= kMaxPendingSessions)
+                {
+                    LOG(LS_WARNING) << "Pending session table is full, dropping the oldest";
 
-            // A new peer is connected. Create and start the pending session.
-            session_manager->pending_sessions_.emplace_back(std::make_unique<PendingSession>(
-                session_manager->task_runner_, std::move(socket), session_manager));
-            session_manager->pending_sessions_.back()->start();
+                    session_manager->pending_sessions_.front()->stop();
+                    session_manager->task_runner_->deleteSoon(
+                        std::move(session_manager->pending_sessions_.front()));
+                    session_manager->pending_sessions_.pop_front();
+                }
+
+                // A new peer is connected. Create and start the pending session.
+                session_manager->pending_sessions_.emplace_back(std::make_unique<PendingSession>(
+                    session_manager->task_runner_, std::move(socket), session_manager));
+                session_manager->pending_sessions_.back()->start();
+            }
         }
         else
         {
@@ -217,6 +362,47 @@ void SessionManager::doAccept(SessionManager* session_manager)
     });
 }
 
+bool SessionManager::acceptConnectionFrom(const asio::ip::address& address)
+{
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    // Forget addresses with an expired window before the map can grow without bound.
+    if (connect_rates_.size() >= kMaxConnectRateEntries)
+    {
+        for (auto it = connect_rates_.begin(); it != connect_rates_.end();)
+        {
+            if (now - it->second.window_start >= kConnectRateWindow)
+                it = connect_rates_.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    ConnectRate& rate = connect_rates_[address];
+
+    if (now - rate.window_start >= kConnectRateWindow)
+    {
+        rate.window_start = now;
+        rate.count = 0;
+    }
+
+    ++rate.count;
+
+    if (rate.count > kMaxConnectsPerWindow)
+    {
+        // The message is logged once per window, not for every rejected connect.
+        if (rate.count == kMaxConnectsPerWindow + 1)
+        {
+            LOG(LS_WARNING) << "Connection rate limit exceeded for "
+                            << base::utf16FromLocal8Bit(address.to_string());
+        }
+
+        return false;
+    }
+
+    return true;
+}
+
 void SessionManager::removePendingSession(PendingSession* session)
 {
     task_runner_->deleteSoon(removeSessionT(&pending_sessions_, session));
@@ -224,10 +410,89 @@ void SessionManager::removePendingSession(PendingSession* session)
 
 void SessionManager::removeSession(Session* session)
 {
-    task_runner_->deleteSoon(removeSessionT(&active_sessions_, session));
+    const size_t thread_index = session->threadIndex();
+    DCHECK_LT(thread_index, session_threads_.size());
+
+    SessionThread& session_thread = session_threads_[thread_index];
+
+    if (session_thread.session_count > 0)
+        --session_thread.session_count;
+
+    // Pick up the bytes transferred since the last flush before the session goes away.
+    collectTraffic(session);
+
+    // The session is deleted on its own thread, after any handler that may still reference it.
+    session_thread.task_runner->deleteSoon(removeSessionT(&active_sessions_, session));
 
     if (delegate_)
         delegate_->onSessionFinished();
 }
 
+void SessionManager::collectTraffic(Session* session)
+{
+    if (!database_)
+        return;
+
+    // The counter is only reset here, so no transferred byte is lost even when a flush races
+    // with the data transfer: the bytes that arrive after the exchange go into the next record.
+    int64_t bytes = session->takePendingBytes();
+    if (!bytes)
+        return;
+
+    pending_traffic_.emplace_back(Database::Traffic{ session->keyId(), time(nullptr), bytes });
+
+    if (pending_traffic_.size() >= kTrafficFlushThreshold)
+        flushTraffic();
+}
+
+void SessionManager::flushTraffic()
+{
+    if (!database_)
+        return;
+
+    for (auto& session : active_sessions_)
+    {
+        int64_t bytes = session->takePendingBytes();
+        if (bytes)
+        {
+            pending_traffic_.emplace_back(
+                Database::Traffic{ session->keyId(), time(nullptr), bytes });
+        }
+    }
+
+    if (pending_traffic_.empty())
+        return;
+
+    if (database_->addTraffic(pending_traffic_))
+    {
+        pending_traffic_.clear();
+    }
+    else
+    {
+        // The records are kept for the next flush, but without a bound a persistent database
+        // failure would grow the list indefinitely.
+        if (pending_traffic_.size() >= kTrafficFlushThreshold * 2)
+        {
+            LOG(LS_ERROR) << "Too many unsaved traffic records, dropping "
+                          << pending_traffic_.size() << " records";
+            pending_traffic_.clear();
+        }
+    }
+}
+
+size_t SessionManager::leastLoadedThread() const
+{
+    DCHECK(!session_threads_.empty());
+
+    size_t result = 0;
+
+    for (size_t i = 1; i < session_threads_.size(); ++i)
+    {
+        if (session_threads_[i].session_count < session_threads_[result].session_count)
+            result = i;
+    }
+
+    return result;
+}
+
 } // namespace relay
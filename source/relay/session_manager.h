@@ -19,11 +19,19 @@
 #ifndef RELAY__SESSION_MANAGER_H
 #define RELAY__SESSION_MANAGER_H
 
+#include "base/threading/thread.h"
+#include "base/waitable_timer.h"
 #include "proto/relay_peer.pb.h"
+#include "relay/database.h"
 #include "relay/pending_session.h"
 #include "relay/session.h"
 #include "relay/shared_pool.h"
 
+#include <chrono>
+#include <deque>
+#include <filesystem>
+#include <map>
+
 namespace base {
 class TaskRunner;
 } // namespace base
@@ -40,10 +48,13 @@ public:
     public:
         virtual ~Delegate() = default;
 
+        virtual void onSessionStarted() = 0;
         virtual void onSessionFinished() = 0;
     };
 
-    SessionManager(std::shared_ptr<base::TaskRunner> task_runner, uint16_t port);
+    SessionManager(std::shared_ptr<base::TaskRunner> task_runner,
+                   uint16_t port,
+                   const std::filesystem::path& database_path);
     ~SessionManager();
 
     void start(std::unique_ptr<SharedPool> shared_pool, Delegate* delegate);
@@ -59,15 +70,54 @@ protected:
 
 private:
     static void doAccept(SessionManager* session_manager);
+    bool acceptConnectionFrom(const asio::ip::address& address);
     void removePendingSession(PendingSession* sessions);
     void removeSession(Session* session);
+    size_t leastLoadedThread() const;
+    void collectTraffic(Session* session);
+    void flushTraffic();
 
     std::shared_ptr<base::TaskRunner> task_runner_;
 
     asio::ip::tcp::acceptor acceptor_;
-    std::vector<std::unique_ptr<PendingSession>> pending_sessions_;
+
+    // Sessions waiting for the handshake of the opposite peer. The table is bounded; when it is
+    // full the oldest pending session is dropped, so a flood of bogus connects cannot exhaust
+    // memory or hold sockets forever.
+    std::deque<std::unique_ptr<PendingSession>> pending_sessions_;
     std::vector<std::unique_ptr<Session>> active_sessions_;
 
+    // Connection attempts per address within the current rate window. Expired entries are
+    // pruned when the map grows too large.
+    struct ConnectRate
+    {
+        std::chrono::steady_clock::time_point window_start;
+        size_t count = 0;
+    };
+
+    std::map<asio::ip::address, ConnectRate> connect_rates_;
+
+    // Threads carrying the data transfer of the active sessions. Handshakes and bookkeeping stay
+    // on the manager thread; each new session is assigned to the thread with the fewest sessions,
+    // so one busy session cannot starve the sessions of the other threads.
+    struct SessionThread
+    {
+        std::unique_ptr<base::Thread> thread;
+        std::shared_ptr<base::TaskRunner> task_runner;
+        asio::io_context* io_context = nullptr;
+        size_t session_count = 0;
+    };
+
+    std::vector<SessionThread> session_threads_;
+
+    // Traffic accounting. The byte counters are collected from the sessions on the manager
+    // thread and flushed to the database in batches, so the transfer hot path never touches
+    // the disk. When the database path in the settings is empty, |database_| stays nullptr and
+    // accounting is disabled.
+    std::unique_ptr<Database> database_;
+    Database::TrafficList pending_traffic_;
+    base::WaitableTimer traffic_flush_timer_;
+
     std::unique_ptr<SharedPool> shared_pool_;
     Delegate* delegate_ = nullptr;
 
@@ -22,8 +22,11 @@
 
 namespace relay {
 
-SessionsWorker::SessionsWorker(uint16_t peer_port, std::unique_ptr<SharedPool> shared_pool)
+SessionsWorker::SessionsWorker(uint16_t peer_port,
+                               const std::filesystem::path& database_path,
+                               std::unique_ptr<SharedPool> shared_pool)
     : peer_port_(peer_port),
+      database_path_(database_path),
       shared_pool_(std::move(shared_pool)),
       thread_(std::make_unique<base::Thread>())
 {
@@ -52,7 +55,8 @@ void SessionsWorker::onBeforeThreadRunning()
     self_task_runner_ = thread_->taskRunner();
     DCHECK(self_task_runner_);
 
-    session_manager_ = std::make_unique<SessionManager>(self_task_runner_, peer_port_);
+    session_manager_ = std::make_unique<SessionManager>(
+        self_task_runner_, peer_port_, database_path_);
     session_manager_->start(std::move(shared_pool_), this);
 }
 
@@ -61,6 +65,18 @@ void SessionsWorker::onAfterThreadRunning()
     session_manager_.reset();
 }
 
+void SessionsWorker::onSessionStarted()
+{
+    if (!caller_task_runner_->belongsToCurrentThread())
+    {
+        caller_task_runner_->postTask(std::bind(&SessionsWorker::onSessionStarted, this));
+        return;
+    }
+
+    if (delegate_)
+        delegate_->onSessionStarted();
+}
+
 void SessionsWorker::onSessionFinished()
 {
     if (!caller_task_runner_->belongsToCurrentThread())
@@ -31,7 +31,9 @@ class SessionsWorker
       public SessionManager::Delegate
 {
 public:
-    SessionsWorker(uint16_t peer_port, std::unique_ptr<SharedPool> shared_pool);
+    SessionsWorker(uint16_t peer_port,
+                   const std::filesystem::path& database_path,
+                   std::unique_ptr<SharedPool> shared_pool);
     ~SessionsWorker();
 
     void start(std::shared_ptr<base::TaskRunner> caller_task_runner,
@@ -43,10 +45,12 @@ protected:
     void onAfterThreadRunning() override;
 
     // SessionManager::Delegate implementation.
+    void onSessionStarted() override;
     void onSessionFinished() override;
 
 private:
     uint16_t peer_port_;
+    std::filesystem::path database_path_;
     std::unique_ptr<SharedPool> shared_pool_;
 
     std::unique_ptr<base::Thread> thread_;
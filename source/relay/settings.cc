@@ -91,6 +91,16 @@ uint32_t Settings::maxPeerCount() const
     return impl_.get<uint32_t>("MaxPeerCount", 100);
 }
 
+void Settings::setDatabasePath(const std::filesystem::path& path)
+{
+    impl_.set<std::filesystem::path>("DatabasePath", path);
+}
+
+std::filesystem::path Settings::databasePath() const
+{
+    return impl_.get<std::filesystem::path>("DatabasePath");
+}
+
 void Settings::setLogPath(const std::filesystem::path& path)
 {
     impl_.set<std::filesystem::path>("LogPath", path);
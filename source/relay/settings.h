@@ -47,6 +47,11 @@ public:
     void setMaxPeerCount(uint32_t count);
     uint32_t maxPeerCount() const;
 
+    // Path to the SQLite database file with the traffic records. When the path is empty,
+    // traffic accounting is disabled.
+    void setDatabasePath(const std::filesystem::path& path);
+    std::filesystem::path databasePath() const;
+
     void setLogPath(const std::filesystem::path& path);
     std::filesystem::path logPath() const;
 
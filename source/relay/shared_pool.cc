@@ -20,10 +20,33 @@
 
 #include "base/logging.h"
 
-#include <mutex>
+#include <atomic>
+#include <memory>
 
 namespace relay {
 
+namespace {
+
+// Number of slots in the pool; must be a power of two. The pool only holds keys of handshakes
+// that are currently in flight, so this is far beyond the worst connection storms.
+constexpr uint32_t kSlotCount = 4096;
+constexpr uint32_t kIndexBits = 12;
+constexpr uint32_t kIndexMask = kSlotCount - 1;
+constexpr uint32_t kGenerationMask = (1u << (32 - kIndexBits)) - 1;
+
+static_assert((kSlotCount & (kSlotCount - 1)) == 0, "kSlotCount must be a power of two");
+
+// A key id is the slot index in the low bits and the slot generation in the high bits, so a
+// stale id never matches a reused slot.
+uint32_t makeKeyId(uint32_t index, uint32_t busy_state)
+{
+    return (((busy_state >> 1) & kGenerationMask) << kIndexBits) | index;
+}
+
+} // namespace
+
+// Pre-allocated slot array with atomic claim and release. The controller issues keys and the
+// session threads look them up; all operations are constant-time and take no locks.
 class SharedPool::Pool
 {
 public:
@@ -39,11 +62,31 @@ public:
     void clear();
 
 private:
+    struct Slot
+    {
+        // Even values mean the slot is free, odd values busy; the value grows by one on every
+        // claim and release, so the upper bits act as the generation of the slot.
+        std::atomic<uint32_t> state{ 0 };
+
+        // Accessed with std::atomic_load / std::atomic_store: a lookup may still hold the key
+        // while the slot is released on another thread.
+        std::shared_ptr<SessionKey> session_key;
+
+        // Link of the free list; the slot index plus one, zero terminates the list.
+        std::atomic<uint32_t> next_free{ 0 };
+    };
+
+    bool releaseSlot(uint32_t key_id);
+    void pushFree(uint32_t index);
+    bool popFree(uint32_t* index);
+
     Delegate* delegate_;
 
-    mutable std::mutex pool_lock_;
-    std::map<uint32_t, SessionKey> map_;
-    uint32_t current_key_id_ = 0;
+    std::unique_ptr<Slot[]> slots_ = std::make_unique<Slot[]>(kSlotCount);
+
+    // Head of the free list. The upper half is a change counter that protects the list
+    // against ABA, the lower half is the slot index plus one (zero means an empty list).
+    std::atomic<uint64_t> free_head_{ 0 };
 
     DISALLOW_COPY_AND_ASSIGN(Pool);
 };
@@ -52,6 +95,12 @@ SharedPool::Pool::Pool(Delegate* delegate)
     : delegate_(delegate)
 {
     DCHECK(delegate_);
+
+    // Chain all slots into the free list. No other thread sees the pool yet.
+    for (uint32_t i = 0; i < kSlotCount - 1; ++i)
+        slots_[i].next_free.store(i + 2, std::memory_order_relaxed);
+
+    free_head_.store(1, std::memory_order_relaxed);
 }
 
 void SharedPool::Pool::dettach()
@@ -61,10 +110,25 @@ void SharedPool::Pool::dettach()
 
 uint32_t SharedPool::Pool::addKey(SessionKey&& session_key)
 {
-    std::scoped_lock lock(pool_lock_);
+    uint32_t index;
+    if (!popFree(&index))
+    {
+        // Every slot is claimed; the id below matches no slot, so the peers of this handshake
+        // simply fail to connect instead of growing the pool without bound.
+        LOG(LS_ERROR) << "Key pool exhausted";
+        return makeKeyId(kIndexMask, ~0u);
+    }
+
+    Slot& slot = slots_[index];
+
+    // Between the pop and the state change below the slot belongs to this thread alone.
+    std::atomic_store(&slot.session_key,
+                      std::make_shared<SessionKey>(std::move(session_key)));
 
-    uint32_t key_id = current_key_id_++;
-    map_.emplace(key_id, std::move(session_key));
+    const uint32_t busy = slot.state.load(std::memory_order_relaxed) + 1;
+    slot.state.store(busy, std::memory_order_release);
+
+    const uint32_t key_id = makeKeyId(index, busy);
 
     LOG(LS_INFO) << "Key with id " << key_id << " added to pool";
     return key_id;
@@ -72,13 +136,8 @@ uint32_t SharedPool::Pool::addKey(SessionKey&& session_key)
 
 bool SharedPool::Pool::removeKey(uint32_t key_id)
 {
-    std::scoped_lock lock(pool_lock_);
-
-    auto result = map_.find(key_id);
-    if (result != map_.end())
+    if (releaseSlot(key_id))
     {
-        map_.erase(result);
-
         LOG(LS_INFO) << "Key with id " << key_id << " removed from pool";
         return true;
     }
@@ -100,22 +159,102 @@ void SharedPool::Pool::setKeyExpired(uint32_t key_id)
 std::optional<SharedPool::Key> SharedPool::Pool::key(
     uint32_t key_id, std::string_view peer_public_key) const
 {
-    std::scoped_lock lock(pool_lock_);
+    const uint32_t index = key_id & kIndexMask;
+    const Slot& slot = slots_[index];
+
+    const uint32_t state = slot.state.load(std::memory_order_acquire);
+
+    if (!(state & 1) || ((state >> 1) & kGenerationMask) != (key_id >> kIndexBits))
+        return std::nullopt;
 
-    auto result = map_.find(key_id);
-    if (result == map_.end())
+    // The shared pointer keeps the key alive even if the slot is released concurrently; a
+    // remove after this point behaves like a remove right after the lookup did under a lock.
+    std::shared_ptr<SessionKey> session_key = std::atomic_load(&slot.session_key);
+    if (!session_key)
         return std::nullopt;
 
-    const SessionKey& session_key = result->second;
-    return std::make_pair(session_key.sessionKey(peer_public_key), session_key.iv());
+    return std::make_pair(session_key->sessionKey(peer_public_key), session_key->iv());
 }
 
 void SharedPool::Pool::clear()
 {
-    std::scoped_lock lock(pool_lock_);
+    for (uint32_t index = 0; index < kSlotCount; ++index)
+    {
+        Slot& slot = slots_[index];
+
+        uint32_t state = slot.state.load(std::memory_order_acquire);
+        if (!(state & 1))
+            continue;
+
+        if (!slot.state.compare_exchange_strong(state, state + 1, std::memory_order_acq_rel))
+            continue;
+
+        std::atomic_store(&slot.session_key, std::shared_ptr<SessionKey>());
+        pushFree(index);
+    }
 
     LOG(LS_INFO) << "Key pool cleared";
-    map_.clear();
+}
+
+bool SharedPool::Pool::releaseSlot(uint32_t key_id)
+{
+    const uint32_t index = key_id & kIndexMask;
+    Slot& slot = slots_[index];
+
+    uint32_t state = slot.state.load(std::memory_order_acquire);
+
+    if (!(state & 1) || ((state >> 1) & kGenerationMask) != (key_id >> kIndexBits))
+        return false;
+
+    // A failed exchange means another thread released the slot first.
+    if (!slot.state.compare_exchange_strong(state, state + 1, std::memory_order_acq_rel))
+        return false;
+
+    std::atomic_store(&slot.session_key, std::shared_ptr<SessionKey>());
+    pushFree(index);
+    return true;
+}
+
+void SharedPool::Pool::pushFree(uint32_t index)
+{
+    uint64_t head = free_head_.load(std::memory_order_relaxed);
+
+    for (;;)
+    {
+        slots_[index].next_free.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+
+        const uint64_t new_head = (((head >> 32) + 1) << 32) | (index + 1);
+        if (free_head_.compare_exchange_weak(head, new_head,
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed))
+        {
+            return;
+        }
+    }
+}
+
+bool SharedPool::Pool::popFree(uint32_t* index)
+{
+    uint64_t head = free_head_.load(std::memory_order_acquire);
+
+    for (;;)
+    {
+        const uint32_t encoded = static_cast<uint32_t>(head);
+        if (!encoded)
+            return false;
+
+        const uint32_t next =
+            slots_[encoded - 1].next_free.load(std::memory_order_relaxed);
+
+        const uint64_t new_head = (((head >> 32) + 1) << 32) | next;
+        if (free_head_.compare_exchange_weak(head, new_head,
+                                             std::memory_order_acq_rel,
+                                             std::memory_order_acquire))
+        {
+            *index = encoded - 1;
+            return true;
+        }
+    }
 }
 
 SharedPool::SharedPool(Delegate* delegate)
@@ -29,13 +29,23 @@ class Database
 public:
     virtual ~Database() = default;
 
+    struct Host
+    {
+        base::HostId host_id;
+        base::ByteArray key_hash;
+    };
+
     virtual std::vector<base::User> userList() const = 0;
     virtual bool addUser(const base::User& user) = 0;
     virtual bool modifyUser(const base::User& user) = 0;
     virtual bool removeUser(int64_t entry_id) = 0;
     virtual base::User findUser(std::u16string_view username) = 0;
+    virtual std::vector<Host> hostList() const = 0;
     virtual base::HostId hostId(const base::ByteArray& keyHash) const = 0;
-    virtual bool addHost(const base::ByteArray& keyHash) = 0;
+    virtual bool addHost(const base::ByteArray& keyHash, base::HostId host_id) = 0;
+
+    // Writes a batch of host registrations in a single transaction.
+    virtual bool addHostBatch(const std::vector<Host>& hosts) = 0;
 };
 
 } // namespace router
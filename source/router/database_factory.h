@@ -31,6 +31,10 @@ public:
     virtual ~DatabaseFactory() = default;
 
     virtual std::unique_ptr<Database> openDatabase() const = 0;
+
+    // Opens a connection for exclusive use by the caller, e.g. on another thread. Unlike
+    // openDatabase(), the returned connection is not shared with anyone.
+    virtual std::unique_ptr<Database> openExclusiveDatabase() const = 0;
 };
 
 } // namespace router
@@ -18,15 +18,95 @@
 
 #include "router/database_factory_sqlite.h"
 
+#include "base/logging.h"
 #include "router/database_sqlite.h"
 
 namespace router {
 
+namespace {
+
+// Handle to the shared connection returned by the factory. The callers own the handle with
+// a unique_ptr and destroy it when done; the connection itself lives in the factory.
+class DatabaseHandle : public Database
+{
+public:
+    explicit DatabaseHandle(std::shared_ptr<DatabaseSqlite> database)
+        : database_(std::move(database))
+    {
+        DCHECK(database_);
+    }
+
+    // Database implementation.
+    std::vector<base::User> userList() const override
+    {
+        return database_->userList();
+    }
+
+    bool addUser(const base::User& user) override
+    {
+        return database_->addUser(user);
+    }
+
+    bool modifyUser(const base::User& user) override
+    {
+        return database_->modifyUser(user);
+    }
+
+    bool removeUser(int64_t entry_id) override
+    {
+        return database_->removeUser(entry_id);
+    }
+
+    base::User findUser(std::u16string_view username) override
+    {
+        return database_->findUser(username);
+    }
+
+    std::vector<Host> hostList() const override
+    {
+        return database_->hostList();
+    }
+
+    base::HostId hostId(const base::ByteArray& keyHash) const override
+    {
+        return database_->hostId(keyHash);
+    }
+
+    bool addHost(const base::ByteArray& keyHash, base::HostId host_id) override
+    {
+        return database_->addHost(keyHash, host_id);
+    }
+
+    bool addHostBatch(const std::vector<Host>& hosts) override
+    {
+        return database_->addHostBatch(hosts);
+    }
+
+private:
+    std::shared_ptr<DatabaseSqlite> database_;
+
+    DISALLOW_COPY_AND_ASSIGN(DatabaseHandle);
+};
+
+} // namespace
+
 DatabaseFactorySqlite::DatabaseFactorySqlite() = default;
 
 DatabaseFactorySqlite::~DatabaseFactorySqlite() = default;
 
 std::unique_ptr<Database> DatabaseFactorySqlite::openDatabase() const
+{
+    if (!database_)
+    {
+        database_ = DatabaseSqlite::open();
+        if (!database_)
+            return nullptr;
+    }
+
+    return std::make_unique<DatabaseHandle>(database_);
+}
+
+std::unique_ptr<Database> DatabaseFactorySqlite::openExclusiveDatabase() const
 {
     return DatabaseSqlite::open();
 }
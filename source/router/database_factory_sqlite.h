@@ -24,15 +24,24 @@
 
 namespace router {
 
+class DatabaseSqlite;
+
 class DatabaseFactorySqlite : public DatabaseFactory
 {
 public:
     DatabaseFactorySqlite();
     ~DatabaseFactorySqlite();
 
+    // Returns a handle to the shared connection. The connection is opened on first use and
+    // kept for the lifetime of the factory, so a lookup does not pay for sqlite3_open and the
+    // prepared-statement cache of the connection stays warm. All callers run on the same
+    // message loop, so the connection is never used concurrently.
     std::unique_ptr<Database> openDatabase() const override;
+    std::unique_ptr<Database> openExclusiveDatabase() const override;
 
 private:
+    mutable std::shared_ptr<DatabaseSqlite> database_;
+
     DISALLOW_COPY_AND_ASSIGN(DatabaseFactorySqlite);
 };
 
@@ -230,6 +230,9 @@ DatabaseSqlite::DatabaseSqlite(sqlite3* db)
 
 DatabaseSqlite::~DatabaseSqlite()
 {
+    for (const auto& entry : statement_cache_)
+        sqlite3_finalize(entry.second);
+
     sqlite3_close(db_);
 }
 
@@ -255,6 +258,19 @@ std::unique_ptr<DatabaseSqlite> DatabaseSqlite::open()
         return nullptr;
     }
 
+    // WAL avoids the synchronous journal rewrite of the default mode, so readers are not
+    // blocked by writes and a host registration does not wait for two fsyncs. A failure is
+    // not fatal (e.g. read-only media); the database then runs in the default mode.
+    static const char kPragmas[] = "PRAGMA journal_mode=WAL; PRAGMA synchronous=NORMAL;";
+
+    char* error_message = nullptr;
+    if (sqlite3_exec(db, kPragmas, nullptr, nullptr, &error_message) != SQLITE_OK)
+    {
+        LOG(LS_WARNING) << "Failed to set database pragmas: "
+                        << (error_message ? error_message : "unknown error");
+        sqlite3_free(error_message);
+    }
+
     return std::unique_ptr<DatabaseSqlite>(new DatabaseSqlite(db));
 }
 
@@ -282,13 +298,9 @@ std::vector<base::User> DatabaseSqlite::userList() const
 {
     const char kQuery[] = "SELECT * FROM users";
 
-    sqlite3_stmt* statement;
-    int error_code = sqlite3_prepare(db_, kQuery, std::size(kQuery), &statement, nullptr);
-    if (error_code != SQLITE_OK)
-    {
-        LOG(LS_ERROR) << "sqlite3_prepare failed: " << sqlite3_errstr(error_code);
+    sqlite3_stmt* statement = preparedStatement(kQuery, std::size(kQuery));
+    if (!statement)
         return std::vector<base::User>();
-    }
 
     std::vector<base::User> users;
     for (;;)
@@ -301,7 +313,7 @@ std::vector<base::User> DatabaseSqlite::userList() const
             users.emplace_back(std::move(user.value()));
     }
 
-    sqlite3_finalize(statement);
+    resetStatement(statement);
     return users;
 }
 
@@ -317,14 +329,11 @@ bool DatabaseSqlite::addUser(const base::User& user)
         "INSERT INTO users ('id', 'name', 'group', 'salt', 'verifier', 'sessions', 'flags') "
         "VALUES (NULL, ?, ?, ?, ?, ?, ?)";
 
-    sqlite3_stmt* statement = nullptr;
-    int error_code = sqlite3_prepare(db_, kQuery, std::size(kQuery), &statement, nullptr);
-    if (error_code != SQLITE_OK)
-    {
-        LOG(LS_ERROR) << "sqlite3_prepare failed: " << sqlite3_errstr(error_code);
+    sqlite3_stmt* statement = preparedStatement(kQuery, std::size(kQuery));
+    if (!statement)
         return false;
-    }
 
+    int error_code;
     std::string username = base::utf8FromUtf16(user.name);
     bool result = false;
 
@@ -359,7 +368,7 @@ bool DatabaseSqlite::addUser(const base::User& user)
     }
     while (false);
 
-    sqlite3_finalize(statement);
+    resetStatement(statement);
     return result;
 }
 
@@ -375,14 +384,11 @@ bool DatabaseSqlite::modifyUser(const base::User& user)
         "UPDATE users SET ('name', 'group', 'salt', 'verifier', 'sessions', 'flags') = "
         "(?, ?, ?, ?, ?, ?) WHERE id=?";
 
-    sqlite3_stmt* statement = nullptr;
-    int error_code = sqlite3_prepare(db_, kQuery, std::size(kQuery), &statement, nullptr);
-    if (error_code != SQLITE_OK)
-    {
-        LOG(LS_ERROR) << "sqlite3_prepare failed: " << sqlite3_errstr(error_code);
+    sqlite3_stmt* statement = preparedStatement(kQuery, std::size(kQuery));
+    if (!statement)
         return false;
-    }
 
+    int error_code;
     std::string username = base::utf8FromUtf16(user.name);
     bool result = false;
 
@@ -420,7 +426,7 @@ bool DatabaseSqlite::modifyUser(const base::User& user)
     }
     while (false);
 
-    sqlite3_finalize(statement);
+    resetStatement(statement);
     return result;
 }
 
@@ -428,14 +434,11 @@ bool DatabaseSqlite::removeUser(int64_t entry_id)
 {
     static const char kQuery[] = "DELETE FROM users WHERE id=?";
 
-    sqlite3_stmt* statement = nullptr;
-    int error_code = sqlite3_prepare(db_, kQuery, std::size(kQuery), &statement, nullptr);
-    if (error_code != SQLITE_OK)
-    {
-        LOG(LS_ERROR) << "sqlite3_prepare failed: " << sqlite3_errstr(error_code);
+    sqlite3_stmt* statement = preparedStatement(kQuery, std::size(kQuery));
+    if (!statement)
         return false;
-    }
 
+    int error_code;
     bool result = false;
 
     do
@@ -454,7 +457,7 @@ bool DatabaseSqlite::removeUser(int64_t entry_id)
     }
     while (false);
 
-    sqlite3_finalize(statement);
+    resetStatement(statement);
     return result;
 }
 
@@ -462,13 +465,9 @@ base::User DatabaseSqlite::findUser(std::u16string_view username)
 {
     const char kQuery[] = "SELECT * FROM users WHERE name=?";
 
-    sqlite3_stmt* statement = nullptr;
-    int error_code = sqlite3_prepare(db_, kQuery, std::size(kQuery), &statement, nullptr);
-    if (error_code != SQLITE_OK)
-    {
-        LOG(LS_ERROR) << "sqlite3_prepare failed: " << sqlite3_errstr(error_code);
+    sqlite3_stmt* statement = preparedStatement(kQuery, std::size(kQuery));
+    if (!statement)
         return base::User::kInvalidUser;
-    }
 
     std::string username_utf8 = base::utf8FromUtf16(username);
     std::optional<base::User> user;
@@ -485,10 +484,49 @@ base::User DatabaseSqlite::findUser(std::u16string_view username)
     }
     while (false);
 
-    sqlite3_finalize(statement);
+    resetStatement(statement);
     return user.value_or(base::User::kInvalidUser);
 }
 
+std::vector<Database::Host> DatabaseSqlite::hostList() const
+{
+    const char kQuery[] = "SELECT id, key FROM hosts";
+
+    sqlite3_stmt* statement = preparedStatement(kQuery, std::size(kQuery));
+    if (!statement)
+        return std::vector<Host>();
+
+    std::vector<Host> hosts;
+    for (;;)
+    {
+        if (sqlite3_step(statement) != SQLITE_ROW)
+            break;
+
+        std::optional<int64_t> host_id = readInteger<int64_t>(statement, 0);
+        if (!host_id.has_value())
+        {
+            LOG(LS_ERROR) << "Failed to get field 'id'";
+            continue;
+        }
+
+        std::optional<base::ByteArray> key_hash = readBlob(statement, 1);
+        if (!key_hash.has_value())
+        {
+            LOG(LS_ERROR) << "Failed to get field 'key'";
+            continue;
+        }
+
+        Host host;
+        host.host_id = static_cast<base::HostId>(host_id.value());
+        host.key_hash = std::move(key_hash.value());
+
+        hosts.emplace_back(std::move(host));
+    }
+
+    resetStatement(statement);
+    return hosts;
+}
+
 base::HostId DatabaseSqlite::hostId(const base::ByteArray& keyHash) const
 {
     if (keyHash.empty())
@@ -499,13 +537,9 @@ base::HostId DatabaseSqlite::hostId(const base::ByteArray& keyHash) const
 
     const char kQuery[] = "SELECT * FROM hosts WHERE key=?";
 
-    sqlite3_stmt* statement;
-    int error_code = sqlite3_prepare(db_, kQuery, std::size(kQuery), &statement, nullptr);
-    if (error_code != SQLITE_OK)
-    {
-        LOG(LS_ERROR) << "sqlite3_prepare failed: " << sqlite3_errstr(error_code);
+    sqlite3_stmt* statement = preparedStatement(kQuery, std::size(kQuery));
+    if (!statement)
         return base::kInvalidHostId;
-    }
 
     base::HostId result = base::kInvalidHostId;
 
@@ -514,7 +548,8 @@ base::HostId DatabaseSqlite::hostId(const base::ByteArray& keyHash) const
         if (!writeBlob(statement, keyHash, 1))
             break;
 
-        if (sqlite3_step(statement) != SQLITE_ROW)
+        int error_code = sqlite3_step(statement);
+        if (error_code != SQLITE_ROW)
         {
             LOG(LS_ERROR) << "sqlite3_step failed: " << sqlite3_errstr(error_code);
             break;
@@ -531,33 +566,33 @@ base::HostId DatabaseSqlite::hostId(const base::ByteArray& keyHash) const
     }
     while (false);
 
-    sqlite3_finalize(statement);
+    resetStatement(statement);
     return result;
 }
 
-bool DatabaseSqlite::addHost(const base::ByteArray& keyHash)
+bool DatabaseSqlite::addHost(const base::ByteArray& keyHash, base::HostId host_id)
 {
-    if (keyHash.empty())
+    if (keyHash.empty() || host_id == base::kInvalidHostId)
     {
         LOG(LS_ERROR) << "Invalid parameters";
         return false;
     }
 
-    const char kQuery[] = "INSERT INTO hosts ('id', 'key') VALUES (NULL, ?)";
+    const char kQuery[] = "INSERT INTO hosts ('id', 'key') VALUES (?, ?)";
 
-    sqlite3_stmt* statement = nullptr;
-    int error_code = sqlite3_prepare(db_, kQuery, std::size(kQuery), &statement, nullptr);
-    if (error_code != SQLITE_OK)
-    {
-        LOG(LS_ERROR) << "sqlite3_prepare failed: " << sqlite3_errstr(error_code);
+    sqlite3_stmt* statement = preparedStatement(kQuery, std::size(kQuery));
+    if (!statement)
         return false;
-    }
 
+    int error_code;
     bool result = false;
 
     do
     {
-        if (!writeBlob(statement, keyHash, 1))
+        if (!writeInt64(statement, static_cast<int64_t>(host_id), 1))
+            break;
+
+        if (!writeBlob(statement, keyHash, 2))
             break;
 
         error_code = sqlite3_step(statement);
@@ -572,8 +607,76 @@ bool DatabaseSqlite::addHost(const base::ByteArray& keyHash)
     }
     while (false);
 
-    sqlite3_finalize(statement);
+    resetStatement(statement);
     return result;
 }
 
+bool DatabaseSqlite::addHostBatch(const std::vector<Host>& hosts)
+{
+    if (hosts.empty())
+        return true;
+
+    // The whole batch goes into one transaction, so the database is synced to disk once per
+    // batch instead of once per registration.
+    char* error_message = nullptr;
+    if (sqlite3_exec(db_, "BEGIN TRANSACTION", nullptr, nullptr, &error_message) != SQLITE_OK)
+    {
+        LOG(LS_ERROR) << "Failed to begin transaction: "
+                      << (error_message ? error_message : "unknown error");
+        sqlite3_free(error_message);
+        return false;
+    }
+
+    bool result = true;
+
+    for (const Host& host : hosts)
+    {
+        if (!addHost(host.key_hash, host.host_id))
+        {
+            result = false;
+            break;
+        }
+    }
+
+    const char* finish_query = result ? "COMMIT" : "ROLLBACK";
+    if (sqlite3_exec(db_, finish_query, nullptr, nullptr, &error_message) != SQLITE_OK)
+    {
+        LOG(LS_ERROR) << "Failed to finish transaction: "
+                      << (error_message ? error_message : "unknown error");
+        sqlite3_free(error_message);
+        return false;
+    }
+
+    return result;
+}
+
+sqlite3_stmt* DatabaseSqlite::preparedStatement(const char* query, size_t query_size) const
+{
+    auto it = statement_cache_.find(query);
+    if (it != statement_cache_.end())
+        return it->second;
+
+    sqlite3_stmt* statement = nullptr;
+    int error_code = sqlite3_prepare_v3(
+        db_, query, query_size, SQLITE_PREPARE_PERSISTENT, &statement, nullptr);
+    if (error_code != SQLITE_OK)
+    {
+        LOG(LS_ERROR) << "sqlite3_prepare_v3 failed: " << sqlite3_errstr(error_code);
+        return nullptr;
+    }
+
+    statement_cache_.emplace(query, statement);
+    return statement;
+}
+
+// static
+void DatabaseSqlite::resetStatement(sqlite3_stmt* statement)
+{
+    sqlite3_reset(statement);
+
+    // Parameters are bound with SQLITE_STATIC, so the pointers are only valid for the duration
+    // of the call; clear them before the statement goes back to the cache.
+    sqlite3_clear_bindings(statement);
+}
+
 } // namespace router
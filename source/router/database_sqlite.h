@@ -23,6 +23,7 @@
 #include "router/database.h"
 
 #include <filesystem>
+#include <unordered_map>
 
 #include <sqlite3.h>
 
@@ -42,14 +43,25 @@ public:
     bool modifyUser(const base::User& user) override;
     bool removeUser(int64_t entry_id) override;
     base::User findUser(std::u16string_view username) override;
+    std::vector<Host> hostList() const override;
     base::HostId hostId(const base::ByteArray& keyHash) const override;
-    bool addHost(const base::ByteArray& keyHash) override;
+    bool addHost(const base::ByteArray& keyHash, base::HostId host_id) override;
+    bool addHostBatch(const std::vector<Host>& hosts) override;
 
 private:
     explicit DatabaseSqlite(sqlite3* db);
 
+    // Returns the compiled statement for |query|, compiling it on first use. Statements are
+    // kept for the lifetime of the connection; callers pass them to resetStatement() when done
+    // instead of finalizing.
+    sqlite3_stmt* preparedStatement(const char* query, size_t query_size) const;
+    static void resetStatement(sqlite3_stmt* statement);
+
     sqlite3* db_;
 
+    // Compiled statements keyed by their SQL text.
+    mutable std::unordered_map<std::string, sqlite3_stmt*> statement_cache_;
+
     DISALLOW_COPY_AND_ASSIGN(DatabaseSqlite);
 };
 
@@ -0,0 +1,108 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "router/database_writer.h"
+
+#include "base/logging.h"
+#include "base/task_runner.h"
+#include "router/database_factory.h"
+
+namespace router {
+
+namespace {
+
+// Time the queue keeps collecting updates before they are written. Long enough to gather a
+// registration storm into large batches, short enough that a single registration is persisted
+// almost immediately.
+const std::chrono::milliseconds kFlushDelay{ 100 };
+
+} // namespace
+
+DatabaseWriter::DatabaseWriter(std::shared_ptr<DatabaseFactory> database_factory)
+    : database_factory_(std::move(database_factory)),
+      thread_(std::make_unique<base::Thread>())
+{
+    DCHECK(database_factory_);
+}
+
+DatabaseWriter::~DatabaseWriter()
+{
+    thread_->stop();
+
+    // The writer thread is joined; write whatever is still queued right here.
+    flush();
+}
+
+void DatabaseWriter::start()
+{
+    thread_->start(base::MessageLoop::Type::DEFAULT);
+    task_runner_ = thread_->taskRunner();
+    DCHECK(task_runner_);
+}
+
+void DatabaseWriter::addHost(const base::ByteArray& key_hash, base::HostId host_id)
+{
+    bool schedule_flush = false;
+
+    {
+        std::scoped_lock lock(queue_lock_);
+
+        queue_.emplace_back(Database::Host{ host_id, key_hash });
+
+        // Later registrations ride on the already scheduled flush.
+        if (!flush_scheduled_)
+        {
+            flush_scheduled_ = true;
+            schedule_flush = true;
+        }
+    }
+
+    if (schedule_flush)
+        task_runner_->postDelayedTask(std::bind(&DatabaseWriter::flush, this), kFlushDelay);
+}
+
+void DatabaseWriter::flush()
+{
+    std::vector<Database::Host> batch;
+
+    {
+        std::scoped_lock lock(queue_lock_);
+
+        batch.swap(queue_);
+        flush_scheduled_ = false;
+    }
+
+    if (batch.empty())
+        return;
+
+    if (!database_)
+    {
+        database_ = database_factory_->openExclusiveDatabase();
+        if (!database_)
+        {
+            LOG(LS_ERROR) << "Failed to open the database; " << batch.size()
+                          << " updates lost";
+            return;
+        }
+    }
+
+    if (!database_->addHostBatch(batch))
+        LOG(LS_ERROR) << "Failed to write a batch of " << batch.size() << " updates";
+}
+
+} // namespace router
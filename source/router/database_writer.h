@@ -0,0 +1,67 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef ROUTER__DATABASE_WRITER_H
+#define ROUTER__DATABASE_WRITER_H
+
+#include "base/macros_magic.h"
+#include "base/threading/thread.h"
+#include "router/database.h"
+
+#include <mutex>
+#include <vector>
+
+namespace router {
+
+class DatabaseFactory;
+
+// Coalesces write-behind database updates into batches written on a dedicated thread.
+// Registrations queued within the collect window go to the database as a single transaction,
+// so a registration storm after a network blip costs a handful of transactions instead of one
+// per host, and the router thread never blocks on the disk.
+class DatabaseWriter
+{
+public:
+    explicit DatabaseWriter(std::shared_ptr<DatabaseFactory> database_factory);
+    ~DatabaseWriter();
+
+    void start();
+
+    // Queues a host registration for persisting. Can be called from any thread.
+    void addHost(const base::ByteArray& key_hash, base::HostId host_id);
+
+private:
+    void flush();
+
+    std::shared_ptr<DatabaseFactory> database_factory_;
+    std::unique_ptr<base::Thread> thread_;
+    std::shared_ptr<base::TaskRunner> task_runner_;
+
+    // Connection owned by the writer thread; opened on the first flush.
+    std::unique_ptr<Database> database_;
+
+    std::mutex queue_lock_;
+    std::vector<Database::Host> queue_;
+    bool flush_scheduled_ = false;
+
+    DISALLOW_COPY_AND_ASSIGN(DatabaseWriter);
+};
+
+} // namespace router
+
+#endif // ROUTER__DATABASE_WRITER_H
@@ -21,11 +21,14 @@
 #include "base/logging.h"
 #include "base/task_runner.h"
 #include "base/crypto/key_pair.h"
+#include "base/strings/string_util.h"
 #include "base/files/base_paths.h"
 #include "base/files/file_util.h"
 #include "base/net/network_channel.h"
+#include "base/peer/heartbeat.h"
 #include "router/database_factory_sqlite.h"
 #include "router/database_sqlite.h"
+#include "router/database_writer.h"
 #include "router/session_admin.h"
 #include "router/session_client.h"
 #include "router/session_host.h"
@@ -42,6 +45,14 @@ const wchar_t kFirewallRuleName[] = L"Aspia Router Service";
 const wchar_t kFirewallRuleDecription[] = L"Allow incoming TCP connections";
 #endif // defined(OS_WIN)
 
+// Interval of the sweep for host sessions with expired heartbeats. One linear pass over the
+// session list; heartbeats themselves are handled per session without timers.
+const std::chrono::seconds kHeartbeatSweepInterval{ 60 };
+
+// Timer slack of the sweep. A sweep that runs a few seconds late only delays the disconnect of
+// an already dead session; in exchange the timer shares its wakeup with other background work.
+const std::chrono::seconds kHeartbeatSweepSlack{ 10 };
+
 const char* sessionTypeToString(proto::RouterSession session_type)
 {
     switch (session_type)
@@ -63,11 +74,36 @@ const char* sessionTypeToString(proto::RouterSession session_type)
     }
 }
 
+// Returns true if |value| contains |filter|. |filter| must already be lower-cased; an empty
+// filter matches everything.
+bool matchesFilter(const std::string& filter, std::string_view value)
+{
+    if (filter.empty())
+        return true;
+
+    return base::toLowerASCII(value).find(filter) != std::string::npos;
+}
+
+void fillHost(proto::Host* host, const SessionHost* session_host)
+{
+    host->set_timepoint(session_host->startTime());
+
+    for (const auto& host_id : session_host->hostIdList())
+        host->add_host_id(host_id);
+
+    host->set_ip_address(session_host->address());
+    host->mutable_version()->CopyFrom(session_host->version().toProto());
+    host->set_os_name(session_host->osName());
+    host->set_computer_name(session_host->computerName());
+    host->set_session_id(session_host->sessionId());
+}
+
 } // namespace
 
 Server::Server(std::shared_ptr<base::TaskRunner> task_runner)
     : task_runner_(std::move(task_runner)),
-      database_factory_(std::make_shared<DatabaseFactorySqlite>())
+      database_factory_(std::make_shared<DatabaseFactorySqlite>()),
+      heartbeat_sweep_timer_(base::WaitableTimer::Type::REPEATED, task_runner_)
 {
     DCHECK(task_runner_);
 }
@@ -141,6 +177,18 @@ bool Server::start()
         LOG(LS_INFO) << "New public key: " << public_key;
     }
 
+    // Load the host key index into memory. Host ID lookups during connection setup are then
+    // served from the index without touching the database.
+    for (auto& host : database->hostList())
+    {
+        if (host.host_id >= next_host_id_)
+            next_host_id_ = host.host_id + 1;
+
+        host_key_index_.emplace(base::toStdString(host.key_hash), host.host_id);
+    }
+
+    LOG(LS_INFO) << "Host key index loaded (entries: " << host_key_index_.size() << ")";
+
     uint16_t port = settings.port();
     if (!port)
     {
@@ -160,22 +208,48 @@ bool Server::start()
 
     relay_key_pool_ = std::make_unique<SharedKeyPool>(this);
 
+    database_writer_ = std::make_unique<DatabaseWriter>(database_factory_);
+    database_writer_->start();
+
     server_ = std::make_unique<base::NetworkServer>();
     server_->start(port, this);
 
+    heartbeat_sweep_timer_.start(kHeartbeatSweepInterval, kHeartbeatSweepSlack,
+                                 std::bind(&Server::sweepExpiredHeartbeats, this));
+
     return true;
 }
 
-std::unique_ptr<proto::RelayList> Server::relayList() const
+std::unique_ptr<proto::RelayList> Server::relayList(const proto::RelayListRequest& request) const
 {
     std::unique_ptr<proto::RelayList> result = std::make_unique<proto::RelayList>();
 
+    const std::string filter = base::toLowerASCII(request.filter());
+    result->set_next_cursor(request.cursor());
+
     for (const auto& session : sessions_)
     {
         if (session->sessionType() != proto::ROUTER_SESSION_RELAY)
             continue;
 
+        if (session->sessionId() <= request.cursor())
+            continue;
+
         SessionRelay* session_relay = static_cast<SessionRelay*>(session.get());
+
+        if (!matchesFilter(filter, session_relay->address()) &&
+            !matchesFilter(filter, session_relay->computerName()))
+        {
+            continue;
+        }
+
+        if (request.page_size() != 0 &&
+            result->relay_size() >= static_cast<int>(request.page_size()))
+        {
+            result->set_has_more(true);
+            break;
+        }
+
         proto::Relay* relay = result->add_relay();
 
         relay->set_timepoint(session_relay->startTime());
@@ -184,33 +258,46 @@ std::unique_ptr<proto::RelayList> Server::relayList() const
         relay->mutable_version()->CopyFrom(session_relay->version().toProto());
         relay->set_os_name(session_relay->osName());
         relay->set_computer_name(session_relay->computerName());
+
+        result->set_next_cursor(session_relay->sessionId());
     }
 
     result->set_error_code(proto::RelayList::SUCCESS);
     return result;
 }
 
-std::unique_ptr<proto::HostList> Server::hostList() const
+std::unique_ptr<proto::HostList> Server::hostList(const proto::HostListRequest& request) const
 {
     std::unique_ptr<proto::HostList> result = std::make_unique<proto::HostList>();
 
+    const std::string filter = base::toLowerASCII(request.filter());
+    result->set_next_cursor(request.cursor());
+
     for (const auto& session : sessions_)
     {
         if (session->sessionType() != proto::ROUTER_SESSION_HOST)
             continue;
 
+        if (session->sessionId() <= request.cursor())
+            continue;
+
         SessionHost* session_host = static_cast<SessionHost*>(session.get());
-        proto::Host* host = result->add_host();
 
-        host->set_timepoint(session_host->startTime());
+        if (!matchesFilter(filter, session_host->computerName()) &&
+            !matchesFilter(filter, session_host->address()))
+        {
+            continue;
+        }
 
-        for (const auto& host_id : session_host->hostIdList())
-            host->add_host_id(host_id);
+        if (request.page_size() != 0 &&
+            result->host_size() >= static_cast<int>(request.page_size()))
+        {
+            result->set_has_more(true);
+            break;
+        }
 
-        host->set_ip_address(session_host->address());
-        host->mutable_version()->CopyFrom(session_host->version().toProto());
-        host->set_os_name(session_host->osName());
-        host->set_computer_name(session_host->computerName());
+        fillHost(result->add_host(), session_host);
+        result->set_next_cursor(session_host->sessionId());
     }
 
     result->set_error_code(proto::HostList::SUCCESS);
@@ -219,72 +306,119 @@ std::unique_ptr<proto::HostList> Server::hostList() const
 
 bool Server::disconnectHost(base::HostId host_id)
 {
-    for (auto it = sessions_.begin(); it != sessions_.end(); ++it)
-    {
-        Session* entry = it->get();
+    SessionHost* host_session = hostSessionById(host_id);
+    if (!host_session)
+        return false;
 
-        if (entry->sessionType() != proto::ROUTER_SESSION_HOST)
-            continue;
+    removeSessionFromIndex(host_session);
 
-        if (static_cast<SessionHost*>(entry)->hasHostId(host_id))
+    for (auto it = sessions_.begin(); it != sessions_.end(); ++it)
+    {
+        if (it->get() == host_session)
         {
+            Session::SessionId session_id = host_session->sessionId();
+
             sessions_.erase(it);
+            broadcastHostStatusEvent(
+                proto::HostStatusEvent::HOST_DISCONNECTED, session_id, nullptr);
             return true;
         }
     }
 
+    NOTREACHED();
     return false;
 }
 
 void Server::onHostSessionWithId(SessionHost* session)
 {
-    for (auto it = sessions_.begin(); it != sessions_.end();)
+    for (const auto& host_id : session->hostIdList())
     {
-        if (it->get()->sessionType() == proto::ROUTER_SESSION_HOST)
+        auto result = hosts_by_id_.emplace(host_id, session);
+        if (result.second)
+            continue;
+
+        SessionHost* other_session = result.first->second;
+        if (other_session == session)
+            continue;
+
+        LOG(LS_INFO) << "Detected previous connection with ID " << host_id;
+
+        // Reassign the entry before removing the old session from the indexes, otherwise
+        // removeSessionFromIndex() would erase it.
+        result.first->second = session;
+        removeSessionFromIndex(other_session);
+
+        for (auto it = sessions_.begin(); it != sessions_.end(); ++it)
         {
-            SessionHost* other_session = reinterpret_cast<SessionHost*>(it->get());
-            if (other_session != session)
+            if (it->get() == other_session)
             {
-                for (const auto& host_id : session->hostIdList())
-                {
-                    if (other_session->hasHostId(host_id))
-                    {
-                        LOG(LS_INFO) << "Detected previous connection with ID " << host_id;
-
-                        it = sessions_.erase(it);
-                        continue;
-                    }
-                }
+                Session::SessionId other_session_id = other_session->sessionId();
+
+                sessions_.erase(it);
+                broadcastHostStatusEvent(
+                    proto::HostStatusEvent::HOST_DISCONNECTED, other_session_id, nullptr);
+                break;
             }
         }
-
-        ++it;
     }
+
+    // The host ids arrived after the connect event, push the completed row.
+    broadcastHostStatusEvent(proto::HostStatusEvent::HOST_CONNECTED,
+                             session->sessionId(), session);
 }
 
-SessionHost* Server::hostSessionById(base::HostId host_id)
+void Server::onHostSessionIdRemoved(SessionHost* session, base::HostId host_id)
 {
-    for (auto it = sessions_.begin(); it != sessions_.end(); ++it)
-    {
-        Session* entry = it->get();
+    auto it = hosts_by_id_.find(host_id);
+    if (it != hosts_by_id_.end() && it->second == session)
+        hosts_by_id_.erase(it);
+}
 
-        if (entry->sessionType() == proto::ROUTER_SESSION_HOST &&
-            static_cast<SessionHost*>(entry)->hasHostId(host_id))
-        {
-            return static_cast<SessionHost*>(entry);
-        }
-    }
+base::HostId Server::hostIdByKeyHash(const base::ByteArray& key_hash) const
+{
+    auto it = host_key_index_.find(base::toStdString(key_hash));
+    if (it != host_key_index_.end())
+        return it->second;
+
+    return base::kInvalidHostId;
+}
+
+base::HostId Server::registerHostKey(const base::ByteArray& key_hash)
+{
+    if (key_hash.empty())
+        return base::kInvalidHostId;
+
+    std::string index_key = base::toStdString(key_hash);
+
+    auto it = host_key_index_.find(index_key);
+    if (it != host_key_index_.end())
+        return it->second;
+
+    base::HostId host_id = next_host_id_++;
+    host_key_index_.emplace(std::move(index_key), host_id);
+
+    // Write-behind: the host gets its ID now, the insert is batched with other registrations
+    // and written on the database thread. If the insert fails the ID is still served from the
+    // index until the router restarts.
+    database_writer_->addHost(key_hash, host_id);
+
+    return host_id;
+}
+
+SessionHost* Server::hostSessionById(base::HostId host_id)
+{
+    auto it = hosts_by_id_.find(host_id);
+    if (it != hosts_by_id_.end())
+        return it->second;
 
     return nullptr;
 }
 
 Session* Server::sessionById(Session::SessionId session_id)
 {
-    for (auto& session : sessions_)
-    {
-        if (session->sessionId() == session_id)
-            return session.get();
-    }
+    auto it = sessions_by_id_.find(session_id);
+    if (it != sessions_by_id_.end())
+        return it->second;
 
     return nullptr;
 }
@@ -358,7 +492,15 @@ void Server::onNewSession(base::ServerAuthenticatorManager::SessionInfo&& sessio
     session->setComputerName(session_info.computer_name);
 
     sessions_.emplace_back(std::move(session));
+    sessions_by_id_.emplace(sessions_.back()->sessionId(), sessions_.back().get());
     sessions_.back()->start(this);
+
+    if (session_type == proto::ROUTER_SESSION_HOST)
+    {
+        SessionHost* session_host = static_cast<SessionHost*>(sessions_.back().get());
+        broadcastHostStatusEvent(proto::HostStatusEvent::HOST_CONNECTED,
+                                 session_host->sessionId(), session_host);
+    }
 }
 
 void Server::onSessionFinished(Session::SessionId session_id, proto::RouterSession session_type)
@@ -367,14 +509,79 @@ void Server::onSessionFinished(Session::SessionId session_id, proto::RouterSessi
     {
         if (it->get()->sessionId() == session_id)
         {
+            removeSessionFromIndex(it->get());
+
             // Session will be destroyed after completion of the current call.
             task_runner_->deleteSoon(std::move(*it));
 
             // Delete a session from the list.
             sessions_.erase(it);
+
+            if (session_type == proto::ROUTER_SESSION_HOST)
+            {
+                broadcastHostStatusEvent(
+                    proto::HostStatusEvent::HOST_DISCONNECTED, session_id, nullptr);
+            }
             break;
         }
     }
 }
 
+void Server::sweepExpiredHeartbeats()
+{
+    std::vector<Session::SessionId> expired;
+
+    for (const auto& session : sessions_)
+    {
+        if (session->sessionType() != proto::ROUTER_SESSION_HOST)
+            continue;
+
+        const SessionHost* session_host = static_cast<const SessionHost*>(session.get());
+        if (session_host->isHeartbeatExpired())
+            expired.push_back(session->sessionId());
+    }
+
+    for (Session::SessionId session_id : expired)
+    {
+        LOG(LS_INFO) << "Heartbeats of host session " << session_id
+                     << " stopped; dropping the session";
+        onSessionFinished(session_id, proto::ROUTER_SESSION_HOST);
+    }
+}
+
+void Server::broadcastHostStatusEvent(proto::HostStatusEvent::Type type,
+                                      Session::SessionId session_id,
+                                      const SessionHost* session) const
+{
+    proto::HostStatusEvent event;
+    event.set_type(type);
+    event.set_session_id(session_id);
+
+    if (session)
+        fillHost(event.mutable_host(), session);
+
+    for (const auto& other : sessions_)
+    {
+        if (other->sessionType() != proto::ROUTER_SESSION_ADMIN)
+            continue;
+
+        static_cast<SessionAdmin*>(other.get())->onHostStatusEvent(event);
+    }
+}
+
+void Server::removeSessionFromIndex(Session* session)
+{
+    sessions_by_id_.erase(session->sessionId());
+
+    if (session->sessionType() != proto::ROUTER_SESSION_HOST)
+        return;
+
+    for (const auto& host_id : static_cast<SessionHost*>(session)->hostIdList())
+    {
+        auto it = hosts_by_id_.find(host_id);
+        if (it != hosts_by_id_.end() && it->second == session)
+            hosts_by_id_.erase(it);
+    }
+}
+
 } // namespace router
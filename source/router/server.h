@@ -19,6 +19,7 @@
 #ifndef ROUTER__SERVER_H
 #define ROUTER__SERVER_H
 
+#include "base/waitable_timer.h"
 #include "base/net/network_server.h"
 #include "base/peer/host_id.h"
 #include "base/peer/server_authenticator_manager.h"
@@ -27,9 +28,12 @@
 #include "router/session.h"
 #include "router/shared_key_pool.h"
 
+#include <unordered_map>
+
 namespace router {
 
 class DatabaseFactory;
+class DatabaseWriter;
 class SessionHost;
 class SessionRelay;
 
@@ -45,10 +49,23 @@ public:
 
     bool start();
 
-    std::unique_ptr<proto::RelayList> relayList() const;
-    std::unique_ptr<proto::HostList> hostList() const;
+    // Builds a page of the relay or host list. Sessions are stored in connection order with
+    // monotonically increasing ids, so the request cursor selects sessions with an id greater
+    // than the last one already delivered; a page size of zero returns the whole list.
+    std::unique_ptr<proto::RelayList> relayList(const proto::RelayListRequest& request) const;
+    std::unique_ptr<proto::HostList> hostList(const proto::HostListRequest& request) const;
     bool disconnectHost(base::HostId host_id);
     void onHostSessionWithId(SessionHost* session);
+    void onHostSessionIdRemoved(SessionHost* session, base::HostId host_id);
+
+    // Returns the host ID registered for |key_hash|, or kInvalidHostId if the key is unknown.
+    // Served from the in-memory index; the database is not touched.
+    base::HostId hostIdByKeyHash(const base::ByteArray& key_hash) const;
+
+    // Registers |key_hash| and returns its host ID, allocating a new one for an unknown key.
+    // The ID is usable immediately; the insert is persisted write-behind, so the connection
+    // setup path never waits for the database.
+    base::HostId registerHostKey(const base::ByteArray& key_hash);
 
     SessionHost* hostSessionById(base::HostId host_id);
     Session* sessionById(Session::SessionId session_id);
@@ -68,13 +85,40 @@ protected:
                            proto::RouterSession session_type) override;
 
 private:
+    // Removes the session from the lookup indexes. The session itself stays in |sessions_|.
+    void removeSessionFromIndex(Session* session);
+
+    // Drops host sessions whose heartbeats stopped (see base/peer/heartbeat.h). Hosts that
+    // never sent a heartbeat are left to the TCP keep-alive, as before.
+    void sweepExpiredHeartbeats();
+
+    // Sends a host status delta to the admin sessions that subscribed to them. |session| is
+    // required for HOST_CONNECTED and ignored for HOST_DISCONNECTED.
+    void broadcastHostStatusEvent(proto::HostStatusEvent::Type type,
+                                  Session::SessionId session_id,
+                                  const SessionHost* session) const;
+
     std::shared_ptr<base::TaskRunner> task_runner_;
     std::shared_ptr<DatabaseFactory> database_factory_;
+    std::unique_ptr<DatabaseWriter> database_writer_;
     std::unique_ptr<base::NetworkServer> server_;
     std::unique_ptr<base::ServerAuthenticatorManager> authenticator_manager_;
     std::unique_ptr<SharedKeyPool> relay_key_pool_;
     std::vector<std::unique_ptr<Session>> sessions_;
 
+    base::WaitableTimer heartbeat_sweep_timer_;
+
+    // Lookup indexes over |sessions_|. Connection brokering resolves a host ID on every client
+    // connection, so with thousands of registered hosts a linear scan of |sessions_| dominates
+    // connection setup time; the indexes keep the lookups O(1).
+    std::unordered_map<base::HostId, SessionHost*> hosts_by_id_;
+    std::unordered_map<Session::SessionId, Session*> sessions_by_id_;
+
+    // Host key index loaded from the database at startup: key hash (as raw bytes) to host ID.
+    // New registrations are added here first and persisted write-behind.
+    std::unordered_map<std::string, base::HostId> host_key_index_;
+    base::HostId next_host_id_ = 1;
+
     DISALLOW_COPY_AND_ASSIGN(Server);
 };
 
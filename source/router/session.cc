@@ -140,7 +140,24 @@ std::chrono::seconds Session::duration() const
 void Session::sendMessage(const google::protobuf::MessageLite& message)
 {
     if (channel_)
-        channel_->send(base::serialize(message));
+    {
+        base::ByteArray buffer = channel_->takeSpareBuffer();
+        base::serialize(message, &buffer);
+        channel_->send(std::move(buffer));
+    }
+}
+
+void Session::sendStreamMessage(uint8_t stream_id, base::ByteArray&& buffer)
+{
+    if (channel_)
+        channel_->send(stream_id, std::move(buffer));
+}
+
+void Session::setStreamListener(uint8_t stream_id,
+                                base::NetworkChannel::StreamListener* listener)
+{
+    if (channel_)
+        channel_->setStreamListener(stream_id, listener);
 }
 
 void Session::onConnected()
@@ -71,6 +71,8 @@ public:
 
 protected:
     void sendMessage(const google::protobuf::MessageLite& message);
+    void sendStreamMessage(uint8_t stream_id, base::ByteArray&& buffer);
+    void setStreamListener(uint8_t stream_id, base::NetworkChannel::StreamListener* listener);
     std::unique_ptr<Database> openDatabase() const;
 
     virtual void onSessionReady() = 0;
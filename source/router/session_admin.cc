@@ -19,6 +19,7 @@
 #include "router/session_admin.h"
 
 #include "base/logging.h"
+#include "base/strings/string_util.h"
 #include "base/strings/unicode.h"
 #include "base/net/network_channel.h"
 #include "base/peer/user.h"
@@ -52,7 +53,7 @@ void SessionAdmin::onMessageReceived(const base::ByteArray& buffer)
 
     if (message.has_host_list_request())
     {
-        doHostListRequest();
+        doHostListRequest(message.host_list_request());
     }
     else if (message.has_host_request())
     {
@@ -60,11 +61,11 @@ void SessionAdmin::onMessageReceived(const base::ByteArray& buffer)
     }
     else if (message.has_relay_list_request())
     {
-        doRelayListRequest();
+        doRelayListRequest(message.relay_list_request());
     }
     else if (message.has_user_list_request())
     {
-        doUserListRequest();
+        doUserListRequest(message.user_list_request());
     }
     else if (message.has_user_request())
     {
@@ -81,7 +82,7 @@ void SessionAdmin::onMessageWritten(size_t /* pending */)
     // Nothing
 }
 
-void SessionAdmin::doUserListRequest()
+void SessionAdmin::doUserListRequest(const proto::UserListRequest& request)
 {
     std::unique_ptr<Database> database = openDatabase();
     if (!database)
@@ -93,9 +94,33 @@ void SessionAdmin::doUserListRequest()
     proto::RouterToAdmin message;
     proto::UserList* list = message.mutable_user_list();
 
+    const std::string filter = base::toLowerASCII(request.filter());
+    list->set_next_cursor(request.cursor());
+
+    // Entries arrive from the database in ascending id order, so the cursor from the previous
+    // page selects the remainder of the list.
     std::vector<base::User> users = database->userList();
     for (const auto& user : users)
+    {
+        if (user.entry_id <= static_cast<int64_t>(request.cursor()))
+            continue;
+
+        if (!filter.empty() &&
+            base::toLowerASCII(base::utf8FromUtf16(user.name)).find(filter) == std::string::npos)
+        {
+            continue;
+        }
+
+        if (request.page_size() != 0 &&
+            list->user_size() >= static_cast<int>(request.page_size()))
+        {
+            list->set_has_more(true);
+            break;
+        }
+
         list->add_user()->CopyFrom(user.serialize());
+        list->set_next_cursor(static_cast<uint64_t>(user.entry_id));
+    }
 
     sendMessage(message);
 }
@@ -128,22 +153,34 @@ void SessionAdmin::doUserRequest(const proto::UserRequest& request)
     sendMessage(message);
 }
 
-void SessionAdmin::doRelayListRequest()
+void SessionAdmin::doRelayListRequest(const proto::RelayListRequest& request)
 {
     proto::RouterToAdmin message;
 
-    message.set_allocated_relay_list(server().relayList().release());
+    message.set_allocated_relay_list(server().relayList(request).release());
     if (!message.has_relay_list())
         message.mutable_relay_list()->set_error_code(proto::RelayList::UNKNOWN_ERROR);
 
     sendMessage(message);
 }
 
-void SessionAdmin::doHostListRequest()
+void SessionAdmin::onHostStatusEvent(const proto::HostStatusEvent& event)
 {
+    if (!host_events_enabled_)
+        return;
+
+    proto::RouterToAdmin message;
+    message.mutable_host_status_event()->CopyFrom(event);
+    sendMessage(message);
+}
+
+void SessionAdmin::doHostListRequest(const proto::HostListRequest& request)
+{
+    host_events_enabled_ = request.subscribe();
+
     proto::RouterToAdmin message;
 
-    message.set_allocated_host_list(server().hostList().release());
+    message.set_allocated_host_list(server().hostList(request).release());
     if (!message.has_host_list())
         message.mutable_host_list()->set_error_code(proto::HostList::UNKNOWN_ERROR);
 
@@ -32,6 +32,10 @@ public:
     SessionAdmin();
     ~SessionAdmin();
 
+    // Forwards a host status delta to the manager. Dropped unless the manager subscribed to
+    // the deltas with its host list request.
+    void onHostStatusEvent(const proto::HostStatusEvent& event);
+
 protected:
     // Session implementation.
     void onSessionReady() override;
@@ -41,16 +45,20 @@ protected:
     void onMessageWritten(size_t pending) override;
 
 private:
-    void doUserListRequest();
+    void doUserListRequest(const proto::UserListRequest& request);
     void doUserRequest(const proto::UserRequest& request);
-    void doRelayListRequest();
-    void doHostListRequest();
+    void doRelayListRequest(const proto::RelayListRequest& request);
+    void doHostListRequest(const proto::HostListRequest& request);
     void doHostRequest(const proto::HostRequest& request);
 
     proto::UserResult::ErrorCode addUser(const proto::User& user);
     proto::UserResult::ErrorCode modifyUser(const proto::User& user);
     proto::UserResult::ErrorCode deleteUser(const proto::User& user);
 
+    // Set by the last host list request. Subscribed sessions receive host status deltas and do
+    // not need to poll full snapshots.
+    bool host_events_enabled_ = false;
+
     DISALLOW_COPY_AND_ASSIGN(SessionAdmin);
 };
 
@@ -25,8 +25,22 @@
 #include "router/session_host.h"
 #include "router/session_relay.h"
 
+#include <algorithm>
+
 namespace router {
 
+namespace {
+
+// Score of a relay with no reported RTT. Ranks unknown relays between nearby ones (a few tens
+// of milliseconds) and relays on another continent.
+const double kDefaultRttMs = 150.0;
+
+// Score penalty of a fully loaded relay. Comparable to a cross-region round trip, so a distant
+// idle relay and a nearby saturated one compete instead of the load deciding alone.
+const double kFullLoadPenaltyMs = 250.0;
+
+} // namespace
+
 SessionClient::SessionClient()
     : Session(proto::ROUTER_SESSION_CLIENT)
 {
@@ -37,7 +51,32 @@ SessionClient::~SessionClient() = default;
 
 void SessionClient::onSessionReady()
 {
-    // Nothing
+    // Tell the client which relay a connection offer is most likely to point to, so it can
+    // open the transport connection to the relay in parallel with the connection request.
+    // The hint is optional and best effort: the offer carries the authoritative address.
+    std::optional<Session::SessionId> relay_id = relayKeyPool().preferredRelay(
+        [this](Session::SessionId id) { return relayScore(id); });
+    if (!relay_id.has_value())
+        return;
+
+    SessionRelay* relay = static_cast<SessionRelay*>(server().sessionById(relay_id.value()));
+    if (!relay)
+        return;
+
+    const std::optional<SessionRelay::PeerData>& peer_data = relay->peerData();
+    if (!peer_data.has_value())
+        return;
+
+    LOG(LS_INFO) << "Sending relay hint to client: " << peer_data->first
+                 << ":" << peer_data->second;
+
+    proto::RouterToClient message;
+    proto::RelayHint* relay_hint = message.mutable_relay_hint();
+
+    relay_hint->set_host(peer_data->first);
+    relay_hint->set_port(peer_data->second);
+
+    sendMessage(message);
 }
 
 void SessionClient::onMessageReceived(const base::ByteArray& buffer)
@@ -53,6 +92,10 @@ void SessionClient::onMessageReceived(const base::ByteArray& buffer)
     {
         readConnectionRequest(message.connection_request());
     }
+    else if (message.has_relay_rtt())
+    {
+        readRelayRtt(message.relay_rtt());
+    }
     else
     {
         LOG(LS_WARNING) << "Unhandled message from client";
@@ -81,7 +124,8 @@ void SessionClient::readConnectionRequest(const proto::ConnectionRequest& reques
     {
         LOG(LS_INFO) << "Host with id " << request.host_id() << " found";
 
-        std::optional<SharedKeyPool::Credentials> credentials = relayKeyPool().takeCredentials();
+        std::optional<SharedKeyPool::Credentials> credentials = relayKeyPool().takeCredentials(
+            [this](Session::SessionId id) { return relayScore(id); });
         if (!credentials.has_value())
         {
             LOG(LS_WARNING) << "Empty key pool";
@@ -118,6 +162,19 @@ void SessionClient::readConnectionRequest(const proto::ConnectionRequest& reques
 
                     LOG(LS_INFO) << "Sending connection offer to host";
                     host->sendConnectionOffer(*offer);
+
+                    // Only the client needs the direct endpoint, so it is added after the
+                    // offer went to the host. The address is the one the router observes for
+                    // the host's connection; the port is reported by the host. The client
+                    // races a direct connection against the relay setup and falls back to
+                    // the relay when a NAT or firewall is in the way.
+                    if (host->directPort() != 0)
+                    {
+                        proto::HostEndpoint* host_endpoint = offer->mutable_host_endpoint();
+
+                        host_endpoint->set_host(host->address());
+                        host_endpoint->set_port(host->directPort());
+                    }
                 }
             }
         }
@@ -127,4 +184,47 @@ void SessionClient::readConnectionRequest(const proto::ConnectionRequest& reques
     sendMessage(message);
 }
 
+void SessionClient::readRelayRtt(const proto::RelayRtt& relay_rtt)
+{
+    for (int i = 0; i < relay_rtt.entry_size(); ++i)
+    {
+        const proto::RelayRtt::Entry& entry = relay_rtt.entry(i);
+
+        LOG(LS_INFO) << "Client reported RTT to relay " << entry.host() << ":" << entry.port()
+                     << ": " << entry.rtt_ms() << " ms";
+
+        relay_rtt_[std::make_pair(entry.host(), static_cast<uint16_t>(entry.port()))] =
+            entry.rtt_ms();
+    }
+}
+
+double SessionClient::relayScore(Session::SessionId relay_id) const
+{
+    // Lower is better. The score is the round trip the client measured to the relay (or a
+    // default for relays it has not seen), plus a penalty that grows with the load the relay
+    // reported. The key pool breaks ties in favor of the relay with the most unused keys.
+    double score = kDefaultRttMs;
+
+    SessionRelay* relay = static_cast<SessionRelay*>(server().sessionById(relay_id));
+    if (!relay)
+        return score + kFullLoadPenaltyMs;
+
+    const std::optional<SessionRelay::PeerData>& peer_data = relay->peerData();
+    if (peer_data.has_value())
+    {
+        auto it = relay_rtt_.find(peer_data.value());
+        if (it != relay_rtt_.end())
+            score = it->second;
+    }
+
+    const proto::RelayLoad& load = relay->relayLoad();
+    if (load.max_sessions() != 0)
+    {
+        score += kFullLoadPenaltyMs *
+                 std::min(load.active_sessions(), load.max_sessions()) / load.max_sessions();
+    }
+
+    return score;
+}
+
 } // namespace router
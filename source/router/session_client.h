@@ -22,6 +22,8 @@
 #include "proto/router_client.pb.h"
 #include "router/session.h"
 
+#include <map>
+
 namespace router {
 
 class ServerProxy;
@@ -43,6 +45,12 @@ protected:
 
 private:
     void readConnectionRequest(const proto::ConnectionRequest& request);
+    void readRelayRtt(const proto::RelayRtt& relay_rtt);
+    double relayScore(Session::SessionId relay_id) const;
+
+    // Round-trip times reported by this client, keyed by relay address. Empty until the client
+    // sends a report; relays without an entry are scored with a default RTT.
+    std::map<std::pair<std::string, uint16_t>, uint32_t> relay_rtt_;
 
     DISALLOW_COPY_AND_ASSIGN(SessionClient);
 };
@@ -23,6 +23,7 @@
 #include "base/crypto/generic_hash.h"
 #include "base/crypto/random.h"
 #include "base/net/network_channel.h"
+#include "base/peer/heartbeat.h"
 #include "router/database.h"
 #include "router/server.h"
 
@@ -54,9 +55,33 @@ void SessionHost::sendConnectionOffer(const proto::ConnectionOffer& offer)
     sendMessage(message);
 }
 
+bool SessionHost::isHeartbeatExpired() const
+{
+    if (last_heartbeat_time_ == std::chrono::steady_clock::time_point())
+        return false;
+
+    return (std::chrono::steady_clock::now() - last_heartbeat_time_) > base::kHeartbeatTimeout;
+}
+
 void SessionHost::onSessionReady()
 {
-    // Nothing
+    setStreamListener(base::kHeartbeatStreamId, this);
+}
+
+void SessionHost::onStreamMessageReceived(uint8_t stream_id, const base::ByteArray& buffer)
+{
+    if (stream_id != base::kHeartbeatStreamId ||
+        buffer.size() != 1 || buffer[0] != base::kHeartbeatMarker)
+    {
+        LOG(LS_WARNING) << "Unexpected stream message from host (stream: "
+                        << static_cast<int>(stream_id) << ", size: " << buffer.size() << ")";
+        return;
+    }
+
+    last_heartbeat_time_ = std::chrono::steady_clock::now();
+
+    // Echo the frame back, so the host sees the full path alive too.
+    sendStreamMessage(base::kHeartbeatStreamId, base::ByteArray(buffer));
 }
 
 void SessionHost::onMessageReceived(const base::ByteArray& buffer)
@@ -89,26 +114,22 @@ void SessionHost::onMessageWritten(size_t /* pending */)
 
 void SessionHost::readHostIdRequest(const proto::HostIdRequest& host_id_request)
 {
-    std::unique_ptr<Database> database = openDatabase();
-    if (!database)
-    {
-        LOG(LS_ERROR) << "Failed to connect to database";
-        return;
-    }
-
     proto::RouterToHost message;
     proto::HostIdResponse* host_id_response = message.mutable_host_id_response();
-    base::ByteArray key_hash;
+    base::HostId host_id = base::kInvalidHostId;
+
+    direct_port_ = static_cast<uint16_t>(host_id_request.direct_port());
 
     if (host_id_request.type() == proto::HostIdRequest::NEW_ID)
     {
         // Generate new key.
         std::string key = base::Random::string(kHostKeySize);
 
-        // Calculate hash for key.
-        key_hash = base::GenericHash::hash(base::GenericHash::Type::BLAKE2b512, key);
-
-        if (!database->addHost(key_hash))
+        // Calculate hash for key. The ID is served from the server's in-memory index and
+        // persisted write-behind.
+        host_id = server().registerHostKey(
+            base::GenericHash::hash(base::GenericHash::Type::BLAKE2b512, key));
+        if (host_id == base::kInvalidHostId)
         {
             LOG(LS_ERROR) << "Unable to add host";
             return;
@@ -119,8 +140,13 @@ void SessionHost::readHostIdRequest(const proto::HostIdRequest& host_id_request)
     else if (host_id_request.type() == proto::HostIdRequest::EXISTING_ID)
     {
         // Using existing key.
-        key_hash = base::GenericHash::hash(
-            base::GenericHash::Type::BLAKE2b512, host_id_request.key());
+        host_id = server().hostIdByKeyHash(base::GenericHash::hash(
+            base::GenericHash::Type::BLAKE2b512, host_id_request.key()));
+        if (host_id == base::kInvalidHostId)
+        {
+            LOG(LS_ERROR) << "Failed to get host ID";
+            return;
+        }
     }
     else
     {
@@ -128,13 +154,6 @@ void SessionHost::readHostIdRequest(const proto::HostIdRequest& host_id_request)
         return;
     }
 
-    base::HostId host_id = database->hostId(key_hash);
-    if (host_id == base::kInvalidHostId)
-    {
-        LOG(LS_ERROR) << "Failed to get host ID";
-        return;
-    }
-
     host_id_list_.emplace_back(host_id);
 
     // Notify the server that the ID has been assigned.
@@ -165,6 +184,9 @@ void SessionHost::readResetHostId(const proto::ResetHostId& reset_host_id)
         {
             LOG(LS_INFO) << "Host ID " << host_id << " remove from list";
             host_id_list_.erase(it);
+
+            // Keep the server lookup index in sync.
+            server().onHostSessionIdRemoved(this, host_id);
             return;
         }
     }
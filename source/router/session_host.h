@@ -27,7 +27,9 @@ namespace router {
 
 class ServerProxy;
 
-class SessionHost : public Session
+class SessionHost
+    : public Session,
+      public base::NetworkChannel::StreamListener
 {
 public:
     SessionHost();
@@ -38,6 +40,15 @@ public:
     const HostIdList& hostIdList() const { return host_id_list_; }
     bool hasHostId(base::HostId host_id) const;
 
+    // TCP port on which the host accepts direct connections; zero if the host did not report
+    // one.
+    uint16_t directPort() const { return direct_port_; }
+
+    // True when the host sends heartbeats but has been silent longer than the heartbeat
+    // timeout. Always false for hosts that never sent one (older versions). Checked by the
+    // periodic sweep of the server.
+    bool isHeartbeatExpired() const;
+
     void sendConnectionOffer(const proto::ConnectionOffer& offer);
 
 protected:
@@ -48,11 +59,20 @@ protected:
     void onMessageReceived(const base::ByteArray& buffer) override;
     void onMessageWritten(size_t pending) override;
 
+    // base::NetworkChannel::StreamListener implementation. Carries the heartbeat frames; they
+    // are fixed single-byte frames handled without a protobuf parse and without touching the
+    // database.
+    void onStreamMessageReceived(uint8_t stream_id, const base::ByteArray& buffer) override;
+
 private:
     void readHostIdRequest(const proto::HostIdRequest& host_id_request);
     void readResetHostId(const proto::ResetHostId& reset_host_id);
 
     HostIdList host_id_list_;
+    uint16_t direct_port_ = 0;
+
+    // Time of the last valid heartbeat frame; zero until the first one arrives.
+    std::chrono::steady_clock::time_point last_heartbeat_time_;
 
     DISALLOW_COPY_AND_ASSIGN(SessionHost);
 };
@@ -58,7 +58,24 @@ void SessionRelay::onMessageReceived(const base::ByteArray& buffer)
 
     if (message.has_key_pool())
     {
-        readKeyPool(message.key_pool());
+        if (draining_)
+        {
+            LOG(LS_WARNING) << "Key pool received from a draining relay; ignored";
+            return;
+        }
+
+        readKeyPool(message.mutable_key_pool());
+    }
+    else if (message.has_relay_load())
+    {
+        relay_load_ = message.relay_load();
+    }
+    else if (message.has_relay_drain())
+    {
+        LOG(LS_INFO) << "Relay is draining; removing its keys from the pool";
+
+        draining_ = true;
+        relayKeyPool().removeKeysForRelay(sessionId());
     }
     else
     {
@@ -71,17 +88,19 @@ void SessionRelay::onMessageWritten(size_t /* pending */)
     // Nothing
 }
 
-void SessionRelay::readKeyPool(const proto::RelayKeyPool& key_pool)
+void SessionRelay::readKeyPool(proto::RelayKeyPool* key_pool)
 {
     SharedKeyPool& pool = relayKeyPool();
 
-    LOG(LS_INFO) << "Received key pool: " << key_pool.key_size() << " (" << address() << ")";
+    LOG(LS_INFO) << "Received key pool: " << key_pool->key_size() << " (" << address() << ")";
 
     peer_data_.emplace(std::make_pair(
-        key_pool.peer_host(), static_cast<uint16_t>(key_pool.peer_port())));
+        key_pool->peer_host(), static_cast<uint16_t>(key_pool->peer_port())));
 
-    for (int i = 0; i < key_pool.key_size(); ++i)
-        pool.addKey(sessionId(), key_pool.key(i));
+    // Keys are moved out of the message; relays send them in blocks and copying each key
+    // (public key and IV) would double the work of draining a block.
+    for (int i = 0; i < key_pool->key_size(); ++i)
+        pool.addKey(sessionId(), std::move(*key_pool->mutable_key(i)));
 }
 
 } // namespace router
@@ -34,6 +34,10 @@ public:
     using PeerData = std::pair<std::string, uint16_t>;
 
     const std::optional<PeerData>& peerData() const { return peer_data_; }
+
+    // Last load report of the relay; all fields are zero until the first report arrives.
+    const proto::RelayLoad& relayLoad() const { return relay_load_; }
+
     void sendKeyUsed(uint32_t key_id);
 
 protected:
@@ -45,9 +49,14 @@ protected:
     void onMessageWritten(size_t pending) override;
 
 private:
-    void readKeyPool(const proto::RelayKeyPool& key_pool);
+    void readKeyPool(proto::RelayKeyPool* key_pool);
 
     std::optional<PeerData> peer_data_;
+    proto::RelayLoad relay_load_;
+
+    // Set when the relay announced a drain for maintenance. Its keys are removed from the
+    // pool and late key pool messages are ignored.
+    bool draining_ = false;
 
     DISALLOW_COPY_AND_ASSIGN(SessionRelay);
 };
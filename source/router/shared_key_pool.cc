@@ -32,8 +32,9 @@ public:
 
     void dettach();
 
-    void addKey(Session::SessionId session_id, const proto::RelayKey& key);
-    std::optional<Credentials> takeCredentials();
+    void addKey(Session::SessionId session_id, proto::RelayKey key);
+    std::optional<Credentials> takeCredentials(const RelayScorer& scorer);
+    std::optional<Session::SessionId> preferredRelay(const RelayScorer& scorer) const;
     void removeKeysForRelay(Session::SessionId session_id);
     void clear();
     size_t countForRelay(Session::SessionId session_id) const;
@@ -43,6 +44,8 @@ public:
 private:
     using Keys = std::vector<proto::RelayKey>;
 
+    std::optional<Session::SessionId> selectRelay(const RelayScorer& scorer) const;
+
     std::map<Session::SessionId, Keys> pool_;
     Delegate* delegate_;
 
@@ -60,7 +63,7 @@ void SharedKeyPool::Impl::dettach()
     delegate_ = nullptr;
 }
 
-void SharedKeyPool::Impl::addKey(Session::SessionId session_id, const proto::RelayKey& key)
+void SharedKeyPool::Impl::addKey(Session::SessionId session_id, proto::RelayKey key)
 {
     auto relay = pool_.find(session_id);
     if (relay == pool_.end())
@@ -73,7 +76,8 @@ void SharedKeyPool::Impl::addKey(Session::SessionId session_id, const proto::Rel
     relay->second.emplace_back(std::move(key));
 }
 
-std::optional<SharedKeyPool::Credentials> SharedKeyPool::Impl::takeCredentials()
+std::optional<SharedKeyPool::Credentials> SharedKeyPool::Impl::takeCredentials(
+    const RelayScorer& scorer)
 {
     if (pool_.empty())
     {
@@ -81,25 +85,16 @@ std::optional<SharedKeyPool::Credentials> SharedKeyPool::Impl::takeCredentials()
         return std::nullopt;
     }
 
-    auto preffered_relay = pool_.end();
-    size_t max_count = 0;
-
-    for (auto it = pool_.begin(); it != pool_.end(); ++it)
-    {
-        size_t count = it->second.size();
-        if (count > max_count)
-        {
-            preffered_relay = it;
-            max_count = count;
-        }
-    }
-
-    if (preffered_relay == pool_.end())
+    std::optional<Session::SessionId> relay_id = selectRelay(scorer);
+    if (!relay_id.has_value())
     {
         LOG(LS_WARNING) << "Empty key pool";
         return std::nullopt;
     }
 
+    auto preffered_relay = pool_.find(relay_id.value());
+    DCHECK(preffered_relay != pool_.end());
+
     LOG(LS_INFO) << "Preffered relay: " << preffered_relay->first;
 
     if (preffered_relay->second.empty())
@@ -127,6 +122,51 @@ std::optional<SharedKeyPool::Credentials> SharedKeyPool::Impl::takeCredentials()
     return credentials;
 }
 
+std::optional<Session::SessionId> SharedKeyPool::Impl::preferredRelay(
+    const RelayScorer& scorer) const
+{
+    return selectRelay(scorer);
+}
+
+std::optional<Session::SessionId> SharedKeyPool::Impl::selectRelay(const RelayScorer& scorer) const
+{
+    auto preffered_relay = pool_.cend();
+    double best_score = 0.0;
+    size_t max_count = 0;
+
+    for (auto it = pool_.cbegin(); it != pool_.cend(); ++it)
+    {
+        const size_t count = it->second.size();
+        if (count == 0)
+            continue;
+
+        if (scorer)
+        {
+            const double score = scorer(it->first);
+
+            // The best-scoring relay wins; with equal scores the one with the most unused
+            // keys, so key consumption stays spread out.
+            if (preffered_relay == pool_.cend() || score < best_score ||
+                (score == best_score && count > max_count))
+            {
+                preffered_relay = it;
+                best_score = score;
+                max_count = count;
+            }
+        }
+        else if (count > max_count)
+        {
+            preffered_relay = it;
+            max_count = count;
+        }
+    }
+
+    if (preffered_relay == pool_.cend())
+        return std::nullopt;
+
+    return preffered_relay->first;
+}
+
 void SharedKeyPool::Impl::removeKeysForRelay(Session::SessionId session_id)
 {
     LOG(LS_INFO) << "All keys for relay '" << session_id << "' removed";
@@ -188,14 +228,30 @@ std::unique_ptr<SharedKeyPool> SharedKeyPool::share()
     return std::unique_ptr<SharedKeyPool>(new SharedKeyPool(impl_));
 }
 
-void SharedKeyPool::addKey(Session::SessionId session_id, const proto::RelayKey& key)
+void SharedKeyPool::addKey(Session::SessionId session_id, proto::RelayKey key)
 {
-    impl_->addKey(session_id, key);
+    impl_->addKey(session_id, std::move(key));
 }
 
 std::optional<SharedKeyPool::Credentials> SharedKeyPool::takeCredentials()
 {
-    return impl_->takeCredentials();
+    return impl_->takeCredentials(nullptr);
+}
+
+std::optional<SharedKeyPool::Credentials> SharedKeyPool::takeCredentials(
+    const RelayScorer& scorer)
+{
+    return impl_->takeCredentials(scorer);
+}
+
+std::optional<Session::SessionId> SharedKeyPool::preferredRelay() const
+{
+    return impl_->preferredRelay(nullptr);
+}
+
+std::optional<Session::SessionId> SharedKeyPool::preferredRelay(const RelayScorer& scorer) const
+{
+    return impl_->preferredRelay(scorer);
 }
 
 void SharedKeyPool::removeKeysForRelay(Session::SessionId session_id)
@@ -24,6 +24,7 @@
 #include "router/session.h"
 
 #include <cstdint>
+#include <functional>
 #include <optional>
 #include <memory>
 
@@ -51,8 +52,18 @@ public:
         proto::RelayKey key;
     };
 
-    void addKey(Session::SessionId session_id, const proto::RelayKey& key);
+    // Ranks a relay for selection; lower is better. When no scorer is given, or two relays
+    // score the same, the relay with the most unused keys wins.
+    using RelayScorer = std::function<double(Session::SessionId)>;
+
+    void addKey(Session::SessionId session_id, proto::RelayKey key);
     std::optional<Credentials> takeCredentials();
+    std::optional<Credentials> takeCredentials(const RelayScorer& scorer);
+
+    // Returns the relay that takeCredentials() would take a key from, without consuming
+    // anything from the pool.
+    std::optional<Session::SessionId> preferredRelay() const;
+    std::optional<Session::SessionId> preferredRelay(const RelayScorer& scorer) const;
     void removeKeysForRelay(Session::SessionId session_id);
     void clear();
     size_t countForRelay(Session::SessionId session_id) const;
@@ -0,0 +1,651 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+// Synthetic load driver for the brokering path: authenticated-channel handshakes and relay key
+// claims. Two modes:
+//
+//   Loopback handshake benchmark (default). An in-process server accepts connections through
+//   ServerAuthenticatorManager and the driver runs SRP handshakes against it through
+//   ClientAuthenticator, |total| in all with |concurrency| in flight. Measures the full
+//   connect-plus-handshake latency.
+//
+//   Broker mode (--router=<address>). Registers |hosts| simulated hosts with a live router
+//   (anonymous authentication, requires --public-key), then issues |total| client connection
+//   requests round-robin across them and measures the time from the connection request to the
+//   connection offer - the router's relay key claim path. The simulated peers never connect to
+//   the offered relay, so the router's key pool is drained at the offer rate; point the run at
+//   a staging router+relay pair.
+//
+// Both modes print count, failures, throughput and latency percentiles to stdout.
+
+#include "base/command_line.h"
+#include "base/logging.h"
+#include "base/crypto/random.h"
+#include "base/crypto/scoped_crypto_initializer.h"
+#include "base/memory/byte_array.h"
+#include "base/message_loop/message_loop.h"
+#include "base/message_loop/message_pump_asio.h"
+#include "base/net/network_channel.h"
+#include "base/net/network_server.h"
+#include "base/peer/client_authenticator.h"
+#include "base/peer/host_id.h"
+#include "base/peer/server_authenticator_manager.h"
+#include "base/peer/user.h"
+#include "base/peer/user_list.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/unicode.h"
+#include "build/build_config.h"
+#include "proto/router_client.pb.h"
+#include "proto/router_host.pb.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace {
+
+// Defaults; every value is overridable from the command line.
+const int kDefaultTotal = 1000;
+const int kDefaultConcurrency = 16;
+const int kDefaultHosts = 8;
+const uint16_t kDefaultLoopbackPort = 28900;
+
+const char16_t kLoopbackUserName[] = u"load";
+const char16_t kLoopbackPassword[] = u"load";
+
+uint64_t currentTimeUs()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Latency samples of one measured operation. Percentiles are taken over the sorted samples.
+class LatencyStats
+{
+public:
+    void addSample(uint64_t value_us) { samples_.push_back(value_us); }
+    void addFailure() { ++failures_; }
+
+    size_t sampleCount() const { return samples_.size(); }
+
+    void report(const char* name, uint64_t duration_us)
+    {
+        std::sort(samples_.begin(), samples_.end());
+
+        std::cout << name << ": " << samples_.size() << " ok, " << failures_ << " failed";
+
+        if (duration_us)
+        {
+            std::cout << ", " << (static_cast<double>(samples_.size()) * 1000000.0 /
+                static_cast<double>(duration_us)) << "/s";
+        }
+
+        std::cout << std::endl;
+
+        if (samples_.empty())
+            return;
+
+        std::cout << "  p50: " << percentile(50) << " us" << std::endl
+                  << "  p90: " << percentile(90) << " us" << std::endl
+                  << "  p99: " << percentile(99) << " us" << std::endl
+                  << "  max: " << samples_.back() << " us" << std::endl;
+    }
+
+private:
+    uint64_t percentile(int p) const
+    {
+        size_t index = samples_.size() * static_cast<size_t>(p) / 100;
+        if (index >= samples_.size())
+            index = samples_.size() - 1;
+
+        return samples_[index];
+    }
+
+    std::vector<uint64_t> samples_;
+    size_t failures_ = 0;
+};
+
+// One outgoing connection of the driver: connects, authenticates and optionally exchanges
+// messages with the peer. The owner keeps it alive until the callback fires.
+class PeerConnection : public base::NetworkChannel::Listener
+{
+public:
+    // |elapsed_us| covers connect and handshake; on failure it is meaningless.
+    using FinishCallback = std::function<void(bool success, uint64_t elapsed_us)>;
+
+    // Called for every message arriving after authentication. Unset messages are discarded.
+    using MessageCallback = std::function<void(const base::ByteArray& buffer)>;
+
+    explicit PeerConnection(std::shared_ptr<base::TaskRunner> task_runner)
+        : task_runner_(std::move(task_runner))
+    {
+        // Nothing
+    }
+
+    ~PeerConnection() override = default;
+
+    // Anonymous authentication against a server with public key |public_key|.
+    void setPeerPublicKey(const base::ByteArray& public_key) { public_key_ = public_key; }
+
+    // SRP authentication; used when no public key is set.
+    void setUserName(std::u16string_view username) { username_ = username; }
+    void setPassword(std::u16string_view password) { password_ = password; }
+
+    void setSessionType(uint32_t session_type) { session_type_ = session_type; }
+    void setMessageCallback(MessageCallback message_callback)
+    {
+        message_callback_ = std::move(message_callback);
+    }
+
+    void start(std::u16string_view address, uint16_t port, FinishCallback finish_callback)
+    {
+        finish_callback_ = std::move(finish_callback);
+        start_time_us_ = currentTimeUs();
+
+        channel_ = std::make_unique<base::NetworkChannel>();
+        channel_->setListener(this);
+        channel_->connect(address, port);
+    }
+
+    void send(base::ByteArray&& buffer) { channel_->send(std::move(buffer)); }
+
+protected:
+    // base::NetworkChannel::Listener implementation.
+    void onConnected() override
+    {
+        channel_->setNoDelay(true);
+
+        authenticator_ = std::make_unique<base::ClientAuthenticator>(task_runner_);
+
+        if (!public_key_.empty())
+        {
+            authenticator_->setIdentify(proto::IDENTIFY_ANONYMOUS);
+            authenticator_->setPeerPublicKey(public_key_);
+        }
+        else
+        {
+            authenticator_->setIdentify(proto::IDENTIFY_SRP);
+            authenticator_->setUserName(username_);
+            authenticator_->setPassword(password_);
+        }
+
+        authenticator_->setSessionType(session_type_);
+
+        authenticator_->start(std::move(channel_),
+                              [this](base::ClientAuthenticator::ErrorCode error_code)
+        {
+            const bool success = (error_code == base::ClientAuthenticator::ErrorCode::SUCCESS);
+            if (success)
+            {
+                channel_ = authenticator_->takeChannel();
+                channel_->setListener(this);
+                channel_->resume();
+            }
+
+            task_runner_->deleteSoon(std::move(authenticator_));
+            finish(success);
+        });
+    }
+
+    void onDisconnected(base::NetworkChannel::ErrorCode /* error_code */) override
+    {
+        finish(false);
+    }
+
+    void onMessageReceived(const base::ByteArray& buffer) override
+    {
+        if (message_callback_)
+            message_callback_(buffer);
+    }
+
+    void onMessageWritten(size_t /* pending */) override
+    {
+        // Nothing
+    }
+
+private:
+    void finish(bool success)
+    {
+        if (!finish_callback_)
+            return;
+
+        FinishCallback callback;
+        callback.swap(finish_callback_);
+        callback(success, currentTimeUs() - start_time_us_);
+    }
+
+    std::shared_ptr<base::TaskRunner> task_runner_;
+    std::unique_ptr<base::NetworkChannel> channel_;
+    std::unique_ptr<base::ClientAuthenticator> authenticator_;
+
+    base::ByteArray public_key_;
+    std::u16string username_;
+    std::u16string password_;
+    uint32_t session_type_ = proto::SESSION_TYPE_DESKTOP_MANAGE;
+
+    FinishCallback finish_callback_;
+    MessageCallback message_callback_;
+    uint64_t start_time_us_ = 0;
+
+    DISALLOW_COPY_AND_ASSIGN(PeerConnection);
+};
+
+// Parameters of one run, filled from the command line.
+struct Options
+{
+    std::u16string router_address; // Empty selects the loopback handshake mode.
+    uint16_t port = 0;
+    base::ByteArray public_key;
+    std::u16string username;
+    std::u16string password;
+    int total = kDefaultTotal;
+    int concurrency = kDefaultConcurrency;
+    int hosts = kDefaultHosts;
+};
+
+// Loopback handshake benchmark: an in-process SRP server and |concurrency| clients running
+// handshakes against it until |total| are done.
+class HandshakeLoadTest
+    : public base::NetworkServer::Delegate,
+      public base::ServerAuthenticatorManager::Delegate
+{
+public:
+    HandshakeLoadTest(std::shared_ptr<base::TaskRunner> task_runner, const Options& options)
+        : task_runner_(std::move(task_runner)),
+          options_(options)
+    {
+        // Nothing
+    }
+
+    void start()
+    {
+        authenticator_manager_ =
+            std::make_unique<base::ServerAuthenticatorManager>(task_runner_, this);
+
+        std::unique_ptr<base::UserList> user_list = base::UserList::createEmpty();
+        user_list->setSeedKey(base::Random::byteArray(64));
+
+        base::User user = base::User::create(kLoopbackUserName, kLoopbackPassword);
+        user.sessions = proto::SESSION_TYPE_ALL;
+        user.flags = base::User::ENABLED;
+        user_list->add(user);
+
+        authenticator_manager_->setUserList(std::move(user_list));
+
+        server_ = std::make_unique<base::NetworkServer>();
+        server_->start(options_.port, this);
+
+        std::cout << "Running " << options_.total << " loopback handshakes ("
+                  << options_.concurrency << " in flight, port " << options_.port << ")"
+                  << std::endl;
+
+        run_start_us_ = currentTimeUs();
+
+        for (int i = 0; i < options_.concurrency && started_ < options_.total; ++i)
+            launchNext();
+    }
+
+protected:
+    // base::NetworkServer::Delegate implementation.
+    void onNewConnection(std::unique_ptr<base::NetworkChannel> channel) override
+    {
+        authenticator_manager_->addNewChannel(std::move(channel));
+    }
+
+    // base::ServerAuthenticatorManager::Delegate implementation.
+    void onNewSession(base::ServerAuthenticatorManager::SessionInfo&& /* session_info */) override
+    {
+        // The server-side channel is dropped here; the measured handshake is already over.
+    }
+
+private:
+    void launchNext()
+    {
+        ++started_;
+
+        auto connection = std::make_unique<PeerConnection>(task_runner_);
+        connection->setUserName(kLoopbackUserName);
+        connection->setPassword(kLoopbackPassword);
+
+        PeerConnection* connection_ptr = connection.get();
+        connections_.emplace_back(std::move(connection));
+
+        connection_ptr->start(u"127.0.0.1", options_.port,
+                              [this, connection_ptr](bool success, uint64_t elapsed_us)
+        {
+            if (success)
+                stats_.addSample(elapsed_us);
+            else
+                stats_.addFailure();
+
+            removeConnection(connection_ptr);
+
+            ++finished_;
+            if (started_ < options_.total)
+            {
+                launchNext();
+            }
+            else if (finished_ == options_.total)
+            {
+                stats_.report("handshake", currentTimeUs() - run_start_us_);
+                task_runner_->postQuit();
+            }
+        });
+    }
+
+    void removeConnection(PeerConnection* connection)
+    {
+        for (auto it = connections_.begin(); it != connections_.end(); ++it)
+        {
+            if (it->get() == connection)
+            {
+                task_runner_->deleteSoon(std::move(*it));
+                connections_.erase(it);
+                return;
+            }
+        }
+    }
+
+    std::shared_ptr<base::TaskRunner> task_runner_;
+    const Options options_;
+
+    std::unique_ptr<base::NetworkServer> server_;
+    std::unique_ptr<base::ServerAuthenticatorManager> authenticator_manager_;
+    std::vector<std::unique_ptr<PeerConnection>> connections_;
+
+    LatencyStats stats_;
+    int started_ = 0;
+    int finished_ = 0;
+    uint64_t run_start_us_ = 0;
+
+    DISALLOW_COPY_AND_ASSIGN(HandshakeLoadTest);
+};
+
+// Broker mode: registers simulated hosts with a live router, then measures the connection
+// request to connection offer round trip of simulated clients.
+class BrokerLoadTest
+{
+public:
+    BrokerLoadTest(std::shared_ptr<base::TaskRunner> task_runner, const Options& options)
+        : task_runner_(std::move(task_runner)),
+          options_(options)
+    {
+        // Nothing
+    }
+
+    void start()
+    {
+        std::cout << "Registering " << options_.hosts << " hosts with the router" << std::endl;
+        registerNextHost();
+    }
+
+private:
+    void registerNextHost()
+    {
+        auto host = std::make_unique<PeerConnection>(task_runner_);
+        host->setPeerPublicKey(options_.public_key);
+        host->setSessionType(proto::ROUTER_SESSION_HOST);
+
+        PeerConnection* host_ptr = host.get();
+
+        host->setMessageCallback([this, host_ptr](const base::ByteArray& buffer)
+        {
+            proto::RouterToHost message;
+            if (!base::parse(buffer, &message))
+                return;
+
+            // Connection offers for the fake host arrive here and are ignored; the load test
+            // only exercises the brokering, the peers never meet.
+            if (!message.has_host_id_response())
+                return;
+
+            host_ids_.push_back(message.host_id_response().host_id());
+
+            if (static_cast<int>(host_ids_.size()) < options_.hosts)
+            {
+                registerNextHost();
+                return;
+            }
+
+            std::cout << "Running " << options_.total << " connection requests ("
+                      << options_.concurrency << " in flight)" << std::endl;
+
+            run_start_us_ = currentTimeUs();
+
+            for (int i = 0; i < options_.concurrency && started_ < options_.total; ++i)
+                launchNextRequest();
+        });
+
+        hosts_.emplace_back(std::move(host));
+
+        host_ptr->start(options_.router_address, options_.port,
+                        [this, host_ptr](bool success, uint64_t /* elapsed_us */)
+        {
+            if (!success)
+            {
+                std::cout << "Host registration failed; check --public-key and the router"
+                          << std::endl;
+                task_runner_->postQuit();
+                return;
+            }
+
+            // Request a new identifier. The response arrives in the message callback.
+            proto::HostToRouter message;
+            proto::HostIdRequest* request = message.mutable_host_id_request();
+            request->set_type(proto::HostIdRequest::NEW_ID);
+            host_ptr->send(base::serialize(message));
+        });
+    }
+
+    void launchNextRequest()
+    {
+        const base::HostId host_id = host_ids_[started_ % host_ids_.size()];
+        ++started_;
+
+        auto client = std::make_unique<PeerConnection>(task_runner_);
+        client->setUserName(options_.username);
+        client->setPassword(options_.password);
+        client->setSessionType(proto::ROUTER_SESSION_CLIENT);
+
+        PeerConnection* client_ptr = client.get();
+        clients_.emplace_back(std::move(client));
+
+        client_ptr->setMessageCallback([this, client_ptr](const base::ByteArray& buffer)
+        {
+            proto::RouterToClient message;
+            if (!base::parse(buffer, &message))
+                return;
+
+            // The relay hint precedes the offer and is not the end of the measured path.
+            if (!message.has_connection_offer())
+                return;
+
+            auto it = request_time_us_.find(client_ptr);
+            if (it == request_time_us_.end())
+                return; // The request is already finished; a late or repeated offer.
+
+            if (message.connection_offer().error_code() == proto::ConnectionOffer::SUCCESS)
+                stats_.addSample(currentTimeUs() - it->second);
+            else
+                stats_.addFailure();
+
+            finishRequest(client_ptr);
+        });
+
+        client_ptr->start(options_.router_address, options_.port,
+                          [this, client_ptr, host_id](bool success, uint64_t /* elapsed_us */)
+        {
+            if (!success)
+            {
+                stats_.addFailure();
+                finishRequest(client_ptr);
+                return;
+            }
+
+            request_time_us_[client_ptr] = currentTimeUs();
+
+            proto::ClientToRouter message;
+            message.mutable_connection_request()->set_host_id(host_id);
+            client_ptr->send(base::serialize(message));
+        });
+    }
+
+    void finishRequest(PeerConnection* client)
+    {
+        request_time_us_.erase(client);
+
+        for (auto it = clients_.begin(); it != clients_.end(); ++it)
+        {
+            if (it->get() == client)
+            {
+                task_runner_->deleteSoon(std::move(*it));
+                clients_.erase(it);
+                break;
+            }
+        }
+
+        ++finished_;
+        if (started_ < options_.total)
+        {
+            launchNextRequest();
+        }
+        else if (finished_ == options_.total)
+        {
+            stats_.report("connection offer", currentTimeUs() - run_start_us_);
+            task_runner_->postQuit();
+        }
+    }
+
+    std::shared_ptr<base::TaskRunner> task_runner_;
+    const Options options_;
+
+    std::vector<std::unique_ptr<PeerConnection>> hosts_;
+    std::vector<base::HostId> host_ids_;
+    std::vector<std::unique_ptr<PeerConnection>> clients_;
+    std::map<PeerConnection*, uint64_t> request_time_us_;
+
+    LatencyStats stats_;
+    int started_ = 0;
+    int finished_ = 0;
+    uint64_t run_start_us_ = 0;
+
+    DISALLOW_COPY_AND_ASSIGN(BrokerLoadTest);
+};
+
+void showHelp()
+{
+    std::cout << "aspia_broker_load_test [switch]" << std::endl
+        << "Available switches:" << std::endl
+        << '\t' << "--router=<address>" << '\t' << "Run against a live router" << std::endl
+        << '\t' << "--port=<port>" << '\t' << "Router (or loopback server) port" << std::endl
+        << '\t' << "--public-key=<hex>" << '\t' << "Router public key (broker mode)" << std::endl
+        << '\t' << "--username=<name>" << '\t' << "Router user (broker mode)" << std::endl
+        << '\t' << "--password=<password>" << '\t' << "Router password (broker mode)" << std::endl
+        << '\t' << "--total=<n>" << '\t' << "Operations to run" << std::endl
+        << '\t' << "--concurrency=<n>" << '\t' << "Operations in flight" << std::endl
+        << '\t' << "--hosts=<n>" << '\t' << "Simulated hosts (broker mode)" << std::endl
+        << '\t' << "--help" << '\t' << "Show help" << std::endl;
+}
+
+bool parseOptions(const base::CommandLine& command_line, Options* options)
+{
+    options->router_address = command_line.switchValue(u"router");
+
+    int value;
+    if (base::stringToInt(command_line.switchValue(u"total"), &value) && value > 0)
+        options->total = value;
+
+    if (base::stringToInt(command_line.switchValue(u"concurrency"), &value) && value > 0)
+        options->concurrency = value;
+
+    if (base::stringToInt(command_line.switchValue(u"hosts"), &value) && value > 0)
+        options->hosts = value;
+
+    if (base::stringToInt(command_line.switchValue(u"port"), &value) && value > 0 &&
+        value <= 65535)
+    {
+        options->port = static_cast<uint16_t>(value);
+    }
+    else
+    {
+        options->port = options->router_address.empty() ?
+            kDefaultLoopbackPort : DEFAULT_ROUTER_TCP_PORT;
+    }
+
+    if (options->router_address.empty())
+        return true;
+
+    options->public_key =
+        base::fromHex(base::utf8FromUtf16(command_line.switchValue(u"public-key")));
+    if (options->public_key.empty())
+    {
+        std::cout << "Broker mode requires --public-key" << std::endl;
+        return false;
+    }
+
+    options->username = command_line.switchValue(u"username");
+    options->password = command_line.switchValue(u"password");
+    if (options->username.empty() || options->password.empty())
+    {
+        std::cout << "Broker mode requires --username and --password" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace
+
+int main(int argc, const char* const* argv)
+{
+    base::CommandLine::init(argc, argv);
+    base::CommandLine* command_line = base::CommandLine::forCurrentProcess();
+
+    if (command_line->hasSwitch(u"help"))
+    {
+        showHelp();
+        return 0;
+    }
+
+    Options options;
+    if (!parseOptions(*command_line, &options))
+        return 1;
+
+    base::ScopedCryptoInitializer crypto_initializer;
+    base::MessageLoop message_loop(base::MessageLoop::Type::ASIO);
+
+    std::unique_ptr<HandshakeLoadTest> handshake_test;
+    std::unique_ptr<BrokerLoadTest> broker_test;
+
+    if (options.router_address.empty())
+    {
+        handshake_test = std::make_unique<HandshakeLoadTest>(message_loop.taskRunner(), options);
+        message_loop.taskRunner()->postTask([&handshake_test]() { handshake_test->start(); });
+    }
+    else
+    {
+        broker_test = std::make_unique<BrokerLoadTest>(message_loop.taskRunner(), options);
+        message_loop.taskRunner()->postTask([&broker_test]() { broker_test->start(); });
+    }
+
+    message_loop.run();
+    return 0;
+}